@@ -373,12 +373,13 @@ int main (int argc, char *argv [])
 	const char *hdf5out = NULL;
 	const char *config = NULL;
 	const char *group = NULL;
+	const char *swmr = NULL;
     cbf_config_t * const vec = cbf_config_create();
     
 	/* Attempt to read the arguments */
 	if (CBF_SUCCESS != (error |= cbf_make_getopt_handle(&opts))) {
 		fprintf(stderr,"Could not create a 'cbf_getopt' handle.\n");
-	} else if (CBF_SUCCESS != (error |= cbf_getopt_parse(opts, argc, argv, "c(compression):C(config):g(group):o(output):Z(register):"))) {
+	} else if (CBF_SUCCESS != (error |= cbf_getopt_parse(opts, argc, argv, "c(compression):C(config):g(group):o(output):P(plan)S(swmr):Z(register):"))) {
 		fprintf(stderr,"Could not parse arguments.\n");
 	} else {
 		int errflg = 0;
@@ -431,6 +432,15 @@ int main (int argc, char *argv [])
                         else hdf5out = optarg;
                         break;
                     }
+                    case 'P': { /* reuse the conversion of the first frame for the rest */
+                        h5_write_flags |= CBF_H5_PLAN;
+                        break;
+                    }
+                    case 'S': { /* write in SWMR mode, flushing every N frames */
+                        if (swmr || !optarg || strtol(optarg,0,10) < 0) errflg++;
+                        else swmr = optarg;
+                        break;
+                    }
                     case 'Z': { /* automatic or manual filter registration? */
                         if (cbf_cistrcmp(optarg?optarg:"","manual") == 0) {
                             h5_write_flags |= CBF_H5_REGISTER_COMPRESSIONS;
@@ -469,6 +479,8 @@ int main (int argc, char *argv [])
                     "Options:\n"
                     "\t-c|--compression cbf|cbf-byte-offset|lz4|lz4**2|bslz4|zlib|none (default: none)\n"
                     "\t-g|--group output_group (default: 'entry')\n"
+                    "\t-P|--plan (fixed-geometry series: write only per-frame values after the first frame)\n"
+                    "\t-S|--swmr flush_interval (default: no SWMR, 0 to flush only on close)\n"
                     "\t-Z|--register manual|plugin (default: plugin)\n"
                     "These options are NOT case-sensitive.\n",
                     argv[0]);
@@ -492,7 +504,8 @@ int main (int argc, char *argv [])
 		size_t f = 0;
         /* prepare the output file */
 		cbf_h5handle h5out = NULL;
-		if(CBF_SUCCESS != (error |= cbf_create_h5handle2(&h5out,hdf5out))) {
+		if(CBF_SUCCESS != (error |= (swmr ? cbf_create_h5handle2_swmr(&h5out,hdf5out,0)
+                                             : cbf_create_h5handle2(&h5out,hdf5out)))) {
 			fprintf(stderr,"Couldn't open the HDF5 file '%s'.\n", hdf5out);
 		} else if (CBF_SUCCESS != (error |= cbf_h5handle_require_entry_definition(h5out,0,group,"NXmx","1.2",0))) {
 			fprintf(stderr,"Couldn't create an NXentry group in the HDF5 file '%s'.\n", hdf5out);
@@ -591,6 +604,13 @@ int main (int argc, char *argv [])
 				/* start timing */
 				clock_t a = clock(), b;
 				error |= cbf_write_minicbf_h5file(cif, h5out, vec);
+				/* the first file creates every object, so readers may attach from now on */
+				if (CBF_SUCCESS == error && swmr && !f) {
+					if (CBF_SUCCESS != (error |= cbf_h5handle_start_swmr_write(h5out,
+                                                   (unsigned int)strtoul(swmr,0,10)))) {
+						fprintf(stderr,"Couldn't start SWMR writing to '%s'.\n", hdf5out);
+					}
+				}
 				/* stop timing */
                 b = clock ();
 				printf("Time to convert '%s': %.3fs\n", cifin[f], ((float)(b - a))/CLOCKS_PER_SEC);
@@ -0,0 +1,182 @@
+#include "cbf.h"
+#include "cbf_alloc.h"
+#include "cbf_string.h"
+#include "cbf_spots.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* series_peaksearch -- search every frame of a sweep for peaks
+
+   The frames are read, decoded and searched a few at a time, and the
+   peaks are written in frame order as each frame is done, so the memory
+   used does not depend on the number of frames.  Each line of the
+   peak list gives the frame number, x, y and I/sigma(I) of a peak. */
+
+
+void    usage()
+{
+    fprintf(stderr,"Usage: series_peaksearch [--min-peak ioversig] \\\n"
+            "        [--min-spacing min_spacing] [--min-value min_value] \\\n"
+            "        [--overload overload] [--max-peaks max_peaks] \\\n"
+            "        [--mask mask_file.cbf] [--inflight frames] \\\n"
+            "        peaklist file.cbf ...\n");
+}
+
+
+typedef struct
+{
+    FILE   *fp;
+    size_t  total;
+} series_output;
+
+
+/* Write the peaks of one frame to the peak list */
+
+int     write_peaks(void *context, size_t frame, const char *filename,
+                    const cbf_spot *spots, size_t nspots)
+{
+    series_output *output = (series_output *)context;
+    size_t i;
+
+    for (i = 0; i < nspots; i++)
+        fprintf(output->fp, "%6lu %7.2f %7.2f  %9.2f\n",
+                (unsigned long)(frame+1), spots[i].fast, spots[i].slow, spots[i].isigma);
+    if (ferror(output->fp))
+        return CBF_FILEWRITE;
+    output->total += nspots;
+    fprintf(stdout, "%s: %lu peaks\n", filename, (unsigned long)nspots);
+    return 0;
+}
+
+
+/* Read a mask image; pixels flagged 0xFFFC-0xFFFF (e.g. in BKGINIT.cbf)
+   are masked */
+
+int     read_mask(const char *maskname, unsigned char **mask,
+                  size_t *maskfast, size_t *maskslow)
+{
+    cbf_handle    hCBFmask;
+    FILE         *fp;
+    unsigned int  compression;
+    int           binary_id, elsigned, elunsigned, minelement, maxelement;
+    size_t        elsize, elements, elements_read, dim2, padding, i;
+    const char   *byteorder;
+    int          *pmaskData = NULL;
+    int           error = 0;
+
+    if ((fp = fopen(maskname, "rb")) == NULL) {
+        fprintf(stderr,"series_peaksearch: unable to open mask `%s'\n", maskname);
+        return CBF_FILEOPEN;
+    }
+    error |= cbf_make_handle(&hCBFmask);
+    if (error) {
+        fclose(fp);
+        return error;
+    }
+    error |= cbf_read_widefile(hCBFmask, fp, MSG_DIGEST);
+    if (!error) error |= cbf_find_tag(hCBFmask, "_array_data.data");
+    if (!error) error |= cbf_get_integerarrayparameters_wdims_fs(hCBFmask, &compression,
+                                                                &binary_id, &elsize,
+                                                                &elsigned, &elunsigned,
+                                                                &elements,
+                                                                &minelement, &maxelement,
+                                                                &byteorder,
+                                                                maskfast, &dim2, maskslow,
+                                                                &padding);
+    if (!error) {
+        if (*maskfast == 0) *maskfast = elements;
+        if (dim2 == 0) dim2 = 1;
+        if (*maskslow == 0) *maskslow = 1;
+        *maskslow *= dim2;
+        error |= cbf_alloc((void **)&pmaskData, NULL, sizeof(int), elements);
+    }
+    if (!error) error |= cbf_alloc((void **)mask, NULL, 1, elements);
+    if (!error) error |= cbf_get_integerarray(hCBFmask, &binary_id, (void *)pmaskData,
+                                              sizeof(int), 1, elements, &elements_read);
+    if (!error) {
+        for (i = 0; i < elements; i++)
+            (*mask)[i] = (pmaskData[i]&0xFFFC) == 0xFFFC;
+    } else {
+        fprintf(stderr,"series_peaksearch: ERROR %x reading mask `%s'\n", error, maskname);
+        cbf_free((void **)mask, NULL);
+    }
+    cbf_free((void **)&pmaskData, NULL);
+    cbf_free_handle(hCBFmask);
+    return error;
+}
+
+
+int     main (int argc, char **argv)
+{
+    char          *maskname = NULL;  /* An optional mask file (e.g. BKGINIT.cbf) */
+    int            min_spacing = 6;  /* Minimum spacing in pixels between spots */
+    int            min_value = 0;    /* Minimum valid value */
+    int            overload = 0;     /* Overload value, 0 for none */
+    int            inflight = 0;     /* Frames in flight, 0 for one per thread */
+    size_t         max_peaks = 0;    /* Peaks kept per frame, 0 for all */
+    double         ioversig = 2.;    /* Minimum peak height in I/sigma(I) */
+    unsigned char *mask = NULL;
+    size_t         maskfast = 0, maskslow = 0;
+    series_output  output;
+    int            error;
+
+    while (argc > 3) {
+        if (0 == cbf_cistrcmp("--min-i-over-sigma",argv[1])
+            || 0 == cbf_cistrcmp("--min-peak",argv[1])) {
+            ioversig = atof(argv[2]);
+        } else if (0 == cbf_cistrcmp("--min-spacing",argv[1])) {
+            min_spacing = (int)(0.5+atof(argv[2]));
+            if (min_spacing < 1) min_spacing = 1;
+        } else if (0 == cbf_cistrcmp("--min-value",argv[1])) {
+            min_value = (int)(atof(argv[2]));
+        } else if (0 == cbf_cistrcmp("--overload",argv[1])) {
+            overload = (int)(atof(argv[2]));
+        } else if (0 == cbf_cistrcmp("--max-peaks",argv[1])) {
+            max_peaks = (size_t)atol(argv[2]);
+        } else if (0 == cbf_cistrcmp("--inflight",argv[1])) {
+            inflight = atoi(argv[2]);
+            if (inflight < 0) inflight = 0;
+        } else if (0 == cbf_cistrcmp("--mask",argv[1])
+                   || 0 == cbf_cistrcmp("--BKGINIT",argv[1])) {
+            maskname = argv[2];
+        } else {
+            break;
+        }
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc < 3 || argv[1][0] == '-') {
+        usage();
+        exit(-1);
+    }
+
+    if (maskname && read_mask(maskname, &mask, &maskfast, &maskslow))
+        exit(-1);
+
+    if (NULL == (output.fp = fopen(argv[1], "w"))) {
+        fprintf(stderr, "series_peaksearch: Cannot create %s as output peaklist file\n", argv[1]);
+        exit(-1);
+    }
+    output.total = 0;
+
+    error = cbf_find_series_spots((const char * const *)(argv+2), (size_t)(argc-2),
+                                  mask, maskfast, maskslow,
+                                  ioversig, min_spacing, min_value, overload,
+                                  max_peaks, inflight, write_peaks, &output);
+
+    fclose(output.fp);
+    cbf_free((void **)&mask, NULL);
+
+    if (error) {
+        fprintf(stderr, "series_peaksearch: ERROR %x in cbf_find_series_spots\n", error);
+        exit(-1);
+    }
+
+    fprintf(stdout, "Number of peaks found with I/sigma > %.2f in %d frames is %lu\n",
+            ioversig, argc-2, (unsigned long)output.total);
+
+    exit(0);
+}
@@ -0,0 +1,359 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for cbf_bin_image and cbf_extract_roi_binoi, checked    *
+ * against naive per-pixel binning.                                   *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+#include "cbf.h"
+#include "cbf_copy.h"
+#include "unittest.h"
+
+/*
+cbf_bin_image must give, bin by bin, what a plain loop over the pixels
+of each bin gives: masked pixels left out, a bin holding an overload
+set to it, sums or rounded means clipped to the element type, and
+partial bins at the high edges.  This is checked for 16- and 32-bit
+integers, signed and unsigned, and for floats, with and without a
+mask, overload and averaging, including bins more than 65536 rows tall.
+
+cbf_extract_roi_binoi bins a region of interest with the same kernels
+when the image has no gaps, and must still add every pixel of the ROI
+into the bin (i+binratio-1)/binratio that its per-pixel loop uses.
+*/
+
+/* Image sizes and bins as dimfast, dimslow, binfast, binslow */
+
+static const size_t shape[][4] = {
+	{64, 48, 1, 1},
+	{64, 48, 2, 2},
+	{64, 48, 4, 4},
+	{67, 45, 4, 4},    /* partial bins at both high edges */
+	{67, 45, 3, 5},
+	{50, 40, 50, 40},  /* a single bin */
+	{33, 17, 7, 1},
+	{33, 17, 1, 6}
+};
+
+#define SHAPES (sizeof(shape)/sizeof(shape[0]))
+
+/* The naive bin of one element type, with the rules of cbf_bin_image
+   spelled out pixel by pixel */
+
+#define naive_bin(type,lowest,highest,realtype)                                     \
+static void naive_bin_##type(const type * src, const unsigned char * mask,          \
+		type * dst, unsigned char * binned_mask,                                    \
+		size_t dimfast, size_t dimslow, size_t binfast, size_t binslow,             \
+		int checkover, type over, int average)                                      \
+{                                                                                   \
+	size_t outfast = (dimfast+binfast-1)/binfast;                                   \
+	size_t outslow = (dimslow+binslow-1)/binslow;                                   \
+	size_t bf, bs, f, s;                                                            \
+	for (bs = 0; bs < outslow; ++bs) for (bf = 0; bf < outfast; ++bf) {             \
+		double total = 0.;                                                          \
+		size_t pixels = 0;                                                          \
+		int hot = 0;                                                                \
+		type * out = dst + bs*outfast + bf;                                         \
+		for (s = bs*binslow; s < (bs+1)*binslow && s < dimslow; ++s)                \
+			for (f = bf*binfast; f < (bf+1)*binfast && f < dimfast; ++f) {          \
+				if (mask && mask[s*dimfast+f]) continue;                            \
+				total += src[s*dimfast+f];                                          \
+				++pixels;                                                           \
+				if (checkover && src[s*dimfast+f] >= over) hot = 1;                 \
+			}                                                                       \
+		if (binned_mask) binned_mask[bs*outfast+bf] = !pixels;                      \
+		if (!pixels) { *out = 0; continue; }                                        \
+		if (hot) { *out = over; continue; }                                         \
+		if (average) {                                                              \
+			if (realtype) total /= pixels;                                          \
+			else if (total >= 0) total = floor((total+pixels/2)/pixels);            \
+			else total = -floor((-total+pixels/2)/pixels);                          \
+		}                                                                           \
+		if (!realtype && total < (double)lowest) total = lowest;                    \
+		if (!realtype && total > (double)highest) total = highest;                  \
+		*out = (type) total;                                                        \
+	}                                                                               \
+}
+
+typedef unsigned short ushort_t;
+typedef unsigned int uint_t;
+
+naive_bin(short, SHRT_MIN, SHRT_MAX, 0)
+naive_bin(ushort_t, 0, USHRT_MAX, 0)
+naive_bin(int, INT_MIN, INT_MAX, 0)
+naive_bin(uint_t, 0, UINT_MAX, 0)
+naive_bin(float, -FLT_MAX, FLT_MAX, 1)
+
+/* Every shape with and without a mask, overload and averaging, on
+   pixels spread over the type with a few near its limits so that some
+   bins clip.  Float pixels are small integers so the sums are exact in
+   any order. */
+
+#define check_type(type,elsigned,realarray,lowest,highest,overlevel)                \
+static testResult_t check_##type(void)                                              \
+{                                                                                   \
+	testResult_t r = {0,0,0};                                                       \
+	int error = CBF_SUCCESS;                                                        \
+	size_t k, i, n, nout;                                                           \
+	int masked, over, average;                                                      \
+	type * src, * dst, * ref;                                                       \
+	unsigned char * mask, * bmask, * rmask;                                         \
+	srand(7);                                                                       \
+	for (k = 0; k < SHAPES; ++k) {                                                  \
+		size_t dimfast = shape[k][0], dimslow = shape[k][1];                        \
+		size_t binfast = shape[k][2], binslow = shape[k][3];                        \
+		n = dimfast*dimslow;                                                        \
+		nout = ((dimfast+binfast-1)/binfast)*((dimslow+binslow-1)/binslow);         \
+		src = (type *) malloc(n*sizeof(type));                                      \
+		mask = (unsigned char *) malloc(n);                                         \
+		dst = (type *) malloc(nout*sizeof(type));                                   \
+		ref = (type *) malloc(nout*sizeof(type));                                   \
+		bmask = (unsigned char *) malloc(nout);                                     \
+		rmask = (unsigned char *) malloc(nout);                                     \
+		for (i = 0; i < n; ++i) {                                                   \
+			int pick = rand()%50;                                                   \
+			if (realarray) src[i] = (type)(rand()%2001-1000);                       \
+			else if (pick == 0) src[i] = (type) highest;                            \
+			else if (pick == 1) src[i] = (type) lowest;                             \
+			else src[i] = (type)((double)lowest                                     \
+				+ ((double)highest-(double)lowest)*(rand()%1000)/999.);             \
+			mask[i] = rand()%5 == 0;                                                \
+		}                                                                           \
+		/* Mask out one whole bin */                                                \
+		for (i = 0; i < binslow*dimfast; ++i)                                       \
+			if (i%dimfast < binfast) mask[i] = 1;                                   \
+		for (masked = 0; masked < 2; ++masked)                                      \
+		for (over = 0; over < 2; ++over)                                            \
+		for (average = 0; average < 2; ++average) {                                 \
+			memset(dst, 0x5a, nout*sizeof(type));                                   \
+			memset(bmask, 0x5a, nout);                                              \
+			naive_bin_##type(src, masked ? mask : NULL, ref, rmask,                 \
+					dimfast, dimslow, binfast, binslow,                             \
+					over, over ? (type) overlevel : (type) 0, average);             \
+			TEST_CBF_PASS(cbf_bin_image(src, masked ? mask : NULL, dst, bmask,      \
+					sizeof(type), elsigned, realarray,                              \
+					dimfast, dimslow, binfast, binslow,                             \
+					over ? (double) overlevel : 0., average));                      \
+			TEST(!memcmp(dst, ref, nout*sizeof(type)));                             \
+			TEST(!memcmp(bmask, rmask, nout));                                      \
+		}                                                                           \
+		free(src); free(mask); free(dst); free(ref); free(bmask); free(rmask);      \
+	}                                                                               \
+	return r;                                                                       \
+}
+
+check_type(short, 1, 0, -30000, 30000, 29000)
+check_type(ushort_t, 0, 0, 0, 60000, 59000)
+check_type(int, 1, 0, -2000000000, 2000000000, 1990000000)
+check_type(uint_t, 0, 0, 0, 4000000000u, 3990000000u)
+check_type(float, 1, 1, -1000, 1000, 990)
+
+/* A bin more than 65536 rows tall, whose 16-bit column sums need the
+   wide kernels, and the bound on the pixels in one bin */
+
+#define TALL 70000
+
+static testResult_t check_tall(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	size_t i;
+	short * s, sout[2];
+	unsigned short * u, uout[2];
+	unsigned char bmask[2];
+	short dummy = 0;
+
+	s = (short *) malloc(2*TALL*sizeof(short));
+	u = (unsigned short *) malloc(2*TALL*sizeof(unsigned short));
+	for (i = 0; i < 2*TALL; ++i) {
+		s[i] = (short)((i%2) ? -32768 : 32767);
+		u[i] = 65535;
+	}
+
+	TEST_CBF_PASS(cbf_bin_image(s, NULL, sout, bmask, sizeof(short), 1, 0,
+			2, TALL, 1, TALL, 0., 1));
+	TEST(sout[0] == 32767 && sout[1] == -32768 && !bmask[0] && !bmask[1]);
+	TEST_CBF_PASS(cbf_bin_image(s, NULL, sout, NULL, sizeof(short), 1, 0,
+			2, TALL, 1, TALL, 0., 0));
+	TEST(sout[0] == 32767 && sout[1] == -32768);
+	TEST_CBF_PASS(cbf_bin_image(u, NULL, uout, NULL, sizeof(unsigned short), 0, 0,
+			2, TALL, 1, TALL, 0., 1));
+	TEST(uout[0] == 65535 && uout[1] == 65535);
+	TEST_CBF_PASS(cbf_bin_image(u, NULL, uout, NULL, sizeof(unsigned short), 0, 0,
+			2, TALL, 2, TALL, 0., 1));
+	TEST(uout[0] == 65535);
+
+	/* More pixels in one bin than an unsigned int counts */
+	TEST_CBF_FAIL(cbf_bin_image(&dummy, NULL, &dummy, NULL, sizeof(short), 1, 0,
+			TALL, TALL, TALL, TALL, 0., 0));
+
+	free(s); free(u);
+	return r;
+}
+
+/* The per-pixel BINOI of the loop in cbf_extract_roi_binoi */
+
+#define naive_binoi(type)                                                           \
+static void naive_binoi_##type(const type * src, type * dst, const size_t * roi,    \
+		size_t dimfast, size_t dimmid, size_t binratio,                             \
+		const size_t * module, const size_t * gap)                                  \
+{                                                                                   \
+	size_t f, m, s, b = binratio;                                                   \
+	size_t outfast = (roi[1]+b-1)/b - (roi[0]+b-1)/b + 1;                           \
+	size_t outmid = (roi[3]+b-1)/b - (roi[2]+b-1)/b + 1;                            \
+	for (s = roi[4]; s <= roi[5]; ++s) for (m = roi[2]; m <= roi[3]; ++m)           \
+	for (f = roi[0]; f <= roi[1]; ++f) {                                            \
+		if (f%(module[0]+gap[0]) >= module[0]) continue;                            \
+		if (m%(module[1]+gap[1]) >= module[1]) continue;                            \
+		if (s%(module[2]+gap[2]) >= module[2]) continue;                            \
+		dst[((f+b-1)/b - (roi[0]+b-1)/b)                                            \
+			+ outfast*((m+b-1)/b - (roi[2]+b-1)/b)                                  \
+			+ outfast*outmid*((s+b-1)/b - (roi[4]+b-1)/b)]                          \
+			+= src[f + dimfast*(m + dimmid*s)];                                     \
+	}                                                                               \
+}
+
+naive_binoi(short)
+naive_binoi(int)
+naive_binoi(float)
+naive_binoi(char)
+
+#define BFAST 61
+#define BMID 47
+#define BSLOW 5
+
+/* ROIs as fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh */
+
+static const size_t roi[][6] = {
+	{0, BFAST-1, 0, BMID-1, 0, BSLOW-1},  /* the whole image */
+	{1, BFAST-1, 1, BMID-1, 0, 0},        /* starting on a bin boundary */
+	{5, 40, 9, 30, 1, 3},                 /* starting part way into a bin */
+	{7, 7, 3, 44, 2, 4},                  /* one column */
+	{10, 12, 20, 21, 0, BSLOW-1}          /* narrower than a bin */
+};
+
+#define ROIS (sizeof(roi)/sizeof(roi[0]))
+
+#define check_binoi_type(type,elsigned,realarray)                                   \
+static testResult_t check_binoi_##type(const size_t * module, const size_t * gap)   \
+{                                                                                   \
+	testResult_t r = {0,0,0};                                                       \
+	int error = CBF_SUCCESS;                                                        \
+	size_t k, b, i, nout;                                                           \
+	type * src, * dst, * ref;                                                       \
+	src = (type *) malloc(BFAST*BMID*BSLOW*sizeof(type));                           \
+	for (i = 0; i < BFAST*BMID*BSLOW; ++i)                                          \
+		src[i] = (type)(realarray ? (i*7)%19 : (i*13)%29);                          \
+	if (elsigned) for (i = 0; i < BFAST*BMID*BSLOW; i += 3) src[i] = -src[i];       \
+	for (k = 0; k < ROIS; ++k) for (b = 1; b <= 4; ++b) {                           \
+		const size_t * box = roi[k];                                                \
+		size_t lo[3], hi[3];                                                        \
+		for (i = 0; i < 3; ++i) {                                                   \
+			lo[i] = (box[2*i]+b-1)/b;                                               \
+			hi[i] = (box[2*i+1]+b-1)/b;                                             \
+		}                                                                           \
+		nout = (hi[0]-lo[0]+1)*(hi[1]-lo[1]+1)*(hi[2]-lo[2]+1);                     \
+		dst = (type *) calloc(nout, sizeof(type));                                  \
+		ref = (type *) calloc(nout, sizeof(type));                                  \
+		naive_binoi_##type(src, ref, box, BFAST, BMID, b, module, gap);             \
+		TEST_CBF_PASS(cbf_extract_roi_binoi(src, dst, sizeof(type),                 \
+				elsigned, realarray, box[0], box[1], box[2], box[3], box[4], box[5],\
+				BFAST, BMID, BSLOW, b, lo[0], hi[0], lo[1], hi[1], lo[2], hi[2],    \
+				module[0], module[1], module[2], gap[0], gap[1], gap[2]));          \
+		TEST(!memcmp(dst, ref, nout*sizeof(type)));                                 \
+		free(dst); free(ref);                                                       \
+	}                                                                               \
+	free(src);                                                                      \
+	return r;                                                                       \
+}
+
+check_binoi_type(short, 1, 0)
+check_binoi_type(int, 1, 0)
+check_binoi_type(float, 1, 1)
+check_binoi_type(char, 1, 0)
+
+static testResult_t check_binoi(void)
+{
+	testResult_t r = {0,0,0};
+	static const size_t whole[3] = {BFAST, BMID, BSLOW}, none[3] = {0, 0, 0};
+	static const size_t module[3] = {20, 15, 2}, gap[3] = {3, 2, 1};
+	static const size_t slowgap[3] = {0, 0, 1};
+
+	/* Without gaps the kernels bin the short, int and float planes */
+	TEST_COMPONENT(check_binoi_short(whole, none));
+	TEST_COMPONENT(check_binoi_int(whole, none));
+	TEST_COMPONENT(check_binoi_float(whole, none));
+	TEST_COMPONENT(check_binoi_int(module, slowgap));
+
+	/* Gaps and other types take the per-pixel loop */
+	TEST_COMPONENT(check_binoi_short(module, gap));
+	TEST_COMPONENT(check_binoi_int(module, gap));
+	TEST_COMPONENT(check_binoi_char(whole, none));
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(check_short());
+	TEST_COMPONENT(check_ushort_t());
+	TEST_COMPONENT(check_int());
+	TEST_COMPONENT(check_uint_t());
+	TEST_COMPONENT(check_float());
+	TEST_COMPONENT(check_tall());
+	TEST_COMPONENT(check_binoi());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
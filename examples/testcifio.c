@@ -0,0 +1,662 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for reading and writing the ASCII part of CIF and CBF   *
+ * files.                                                             *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "unittest.h"
+
+/*
+cbf_lex takes runs of plain characters in bulk, so each case below
+puts a character that ends a run, or that only looks as though it
+might, somewhere inside a token: quotes inside quoted strings, tabs,
+backslashes, semicolons and dashes inside text fields, long runs of
+blanks, non-ASCII characters and lines over the 80 column limit.  The
+values, and the warnings with their lines and columns, must be those
+the character-at-a-time lexer gave.  A loop long enough to need many
+refills of the input buffer checks runs that meet the end of it.
+
+The writer collects its output in a large buffer and copies plain runs
+and words into it in bulk.  Values that must be quoted, folded or
+written as text fields, a loop larger than the buffer and a binary
+section must read back as they were written, and writing the same cbf
+twice, or the cbf read back, must give the same bytes.  Rows of words
+must break across lines where the value-at-a-time writer broke them.
+*/
+
+#define LOOP_ROWS 3000
+
+typedef struct
+{
+	const char *tag, *type, *value;
+}
+lex_case;
+
+static const char lex_cif[] =
+	"#\\#CIF_1.1\n"
+	"data_lex\n"
+	"_lex.word plain_word-with.punct#not_a_comment\n"
+	"_lex.quoted 'it's quoted'\n"
+	"_lex.double \"say \"hi\"there\"\n"
+	"_lex.tabbed 'a\tb'\n"
+	"_lex.backslash C:\\dir\\sub\\\\\n"
+	"_lex.blanks                                                            after_blanks\n"
+	"_lex.long xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\n"
+	"_lex.long_quoted 'long quoted string long quoted string long quoted string long quoted string long quoted string '\n"
+	"_lex.text\n"
+	";line one\n"
+	"  -- dashes -- here\n"
+	" ;not the end\n"
+	"tttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttt\n"
+	";\n"
+	"_lex.comment value_before_comment # a comment with 'quotes' and ;semicolons and more and more and more\n"
+	"_lex.empty ''\n"
+	"_lex.nonascii 'caf\303\251'\n";
+
+static const lex_case lex_cases[] = {
+	{"_lex.word", "word", "plain_word-with.punct#not_a_comment"},
+	{"_lex.quoted", "sglq", "it's quoted"},
+	{"_lex.double", "dblq", "say \"hi\"there"},
+	{"_lex.tabbed", "sglq", "a\tb"},
+	{"_lex.backslash", "word", "C:\\dir\\sub\\\\"},
+	{"_lex.blanks", "word", "after_blanks"},
+	{"_lex.long", "word", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"},
+	{"_lex.long_quoted", "sglq", "long quoted string long quoted string long quoted string long quoted string long quoted string "},
+	{"_lex.text", "text", "line one\n  -- dashes -- here\n ;not the end\ntttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttt"},
+	{"_lex.comment", "word", "value_before_comment"},
+	{"_lex.empty", "sglq", ""},
+	{"_lex.nonascii", "sglq", "caf\303\251"}
+};
+
+static const char lex_log[] =
+	"CBFlib: warning input line 8 (81) -- over line size limit\n"
+	"CBFlib: warning input line 9 (81) -- over line size limit\n"
+	"CBFlib: warning input line 10 (81) -- over line size limit\n"
+	"CBFlib: warning input line 15 (81) -- over line size limit\n"
+	"CBFlib: warning input line 17 (81) -- over line size limit\n"
+	"CBFlib: warning input line 19 (19) -- invalid character\n"
+	"CBFlib: warning input line 19 (20) -- invalid character\n";
+
+  /* Under CIF2 rules a word stops at a comma, a colon or a quote */
+
+static const char cif2_cif[] =
+	"#\\#CIF_2.0\n"
+	"data_c2\n"
+	"_c2.word zeta,eta:theta\n"
+	"_c2.quote iota\"kappa'lambda\n"
+	"_c2.long yyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyy\n";
+
+static const lex_case cif2_cases[] = {
+	{"_c2.word", "word", "zeta"},
+	{"_c2.quote", "word", "iota"},
+	{"_c2.long", "word", "yyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyy"}
+};
+
+static const char cif2_log[] =
+	"CBFlib: warning input line 3 (14) -- invalid separator \n"
+	"CBFlib: warning input line 3 (18) -- invalid separator \n"
+	"CBFlib: error input line 3 (15) -- value without tag\n"
+	"CBFlib: error input line 3 (19) -- value without tag\n"
+	"CBFlib: warning input line 4 (15) -- invalid separator \n"
+	"CBFlib: warning input line 4 (15) -- premature end of double-quoted string\n"
+	"CBFlib: error input line 4 (15) -- value without tag\n"
+	"CBFlib: warning input line 5 (81) -- over line size limit\n";
+
+
+  /* Read text into a new cbf and return in log what reading it wrote */
+
+static int read_text (cbf_handle *handle, const char *text, size_t size,
+                      int flags, char **log)
+{
+	FILE *in = tmpfile (), *logfile = tmpfile ();
+	long length;
+	int error = CBF_SUCCESS;
+
+	*handle = NULL;
+	*log = NULL;
+
+	if (!in || !logfile || fwrite (text, 1, size, in) != size ||
+	    fseek (in, 0, SEEK_SET))
+		error = CBF_FILEWRITE;
+
+	if (!error) error = cbf_make_handle (handle);
+	if (!error) error = cbf_set_cbf_logfile (*handle, logfile);
+	if (!error) {
+		error = cbf_read_file (*handle, in, MSG_NODIGEST | flags);
+		in = NULL;
+	}
+
+	if (fflush (logfile) || (length = ftell (logfile)) < 0 ||
+	    fseek (logfile, 0, SEEK_SET) || !(*log = calloc (length + 1, 1)) ||
+	    fread (*log, 1, length, logfile) != (size_t) length)
+		error |= CBF_FILEREAD;
+
+	if (*handle) cbf_set_cbf_logfile (*handle, NULL);
+	if (in) fclose (in);
+	if (logfile) fclose (logfile);
+	return error;
+}
+
+
+static testResult_t check_cases (cbf_handle handle,
+                                 const lex_case *cases, size_t count)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		const char *value = NULL, *type = NULL;
+
+		TEST_CBF_PASS (cbf_find_tag (handle, cases[i].tag));
+		TEST_CBF_PASS (cbf_get_value (handle, &value));
+		TEST_CBF_PASS (cbf_get_typeofvalue (handle, &type));
+		TEST (value && !strcmp (value, cases[i].value));
+		TEST (type && !strcmp (type, cases[i].type));
+		if (!value || strcmp (value, cases[i].value))
+			fprintf (stderr, "%s: <%s>\n", cases[i].tag, value ? value : "(null)");
+	}
+	return r;
+}
+
+
+static testResult_t test_lex_cases (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	char *log = NULL;
+
+	TEST_CBF_PASS (read_text (&handle, lex_cif, sizeof (lex_cif) - 1, 0, &log));
+	if (handle)
+		TEST_COMPONENT (check_cases (handle, lex_cases,
+		                             sizeof (lex_cases) / sizeof (lex_cases[0])));
+	TEST (log && !strcmp (log, lex_log));
+	if (log && strcmp (log, lex_log)) fprintf (stderr, "%s", log);
+	free (log);
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+
+	  /* The CIF2 text has errors, so the read fails after reading it all */
+
+	TEST_CBF_FAIL (read_text (&handle, cif2_cif, sizeof (cif2_cif) - 1,
+	                          CBF_PARSE_CIF2, &log));
+	if (handle)
+		TEST_COMPONENT (check_cases (handle, cif2_cases,
+		                             sizeof (cif2_cases) / sizeof (cif2_cases[0])));
+	TEST (log && !strcmp (log, cif2_log));
+	if (log && strcmp (log, cif2_log)) fprintf (stderr, "%s", log);
+	free (log);
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* Row i of the loop: a quoted string with a quote inside it, a word
+     and a text field, each of a length that varies with i */
+
+static void loop_row (unsigned int i, char *word, char *quoted, char *text)
+{
+	unsigned int j;
+
+	sprintf (word, "w%u_", i);
+	for (j = strlen (word); j < 4 + i % 30; j++) word[j] = 'a' + j % 26;
+	word[j] = '\0';
+
+	sprintf (quoted, "q%u 'x", i);
+	for (j = strlen (quoted); j < 8 + i % 30; j++) quoted[j] = j % 9 ? 'b' : ' ';
+	quoted[j] = '\0';
+
+	sprintf (text, "t%u\n", i);
+	for (j = strlen (text); j < 6 + i % 75; j++) text[j] = j % 11 ? 'c' : '-';
+	text[j] = '\0';
+}
+
+
+static testResult_t test_lex_loop (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	char *cif, *next, *log = NULL;
+	char word[40], quoted[40], text[90];
+	unsigned int i, rows = 0;
+
+	TEST (NULL != (cif = malloc (LOOP_ROWS * 256 + 100)));
+	if (!cif) return r;
+
+	next = cif + sprintf (cif, "data_loop\nloop_\n_loop.id\n_loop.quoted\n"
+	                           "_loop.word\n_loop.text\n");
+	for (i = 0; i < LOOP_ROWS; i++) {
+		loop_row (i, word, quoted, text);
+		next += sprintf (next, "%u '%s' %s\n;%s\n;\n", i, quoted, word, text);
+	}
+
+	TEST_CBF_PASS (read_text (&handle, cif, next - cif, 0, &log));
+	TEST (log && !*log);
+	if (handle) {
+		TEST_CBF_PASS (cbf_find_category (handle, "loop"));
+		TEST_CBF_PASS (cbf_count_rows (handle, &rows));
+		TEST (LOOP_ROWS == rows);
+	}
+	for (i = 0; handle && !r.fail && i < rows; i++) {
+		const char *value = NULL;
+		int id = -1;
+
+		loop_row (i, word, quoted, text);
+		TEST_CBF_PASS (cbf_find_column (handle, "id"));
+		TEST_CBF_PASS (cbf_select_row (handle, i));
+		TEST_CBF_PASS (cbf_get_integervalue (handle, &id));
+		TEST ((int) i == id);
+		TEST_CBF_PASS (cbf_find_column (handle, "word"));
+		TEST_CBF_PASS (cbf_get_value (handle, &value));
+		TEST (value && !strcmp (value, word));
+		TEST_CBF_PASS (cbf_find_column (handle, "quoted"));
+		TEST_CBF_PASS (cbf_get_value (handle, &value));
+		TEST (value && !strcmp (value, quoted));
+		TEST_CBF_PASS (cbf_find_column (handle, "text"));
+		TEST_CBF_PASS (cbf_get_value (handle, &value));
+		TEST (value && !strcmp (value, text));
+	}
+
+	free (log);
+	free (cif);
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* Write a cbf to a file and return the whole of it */
+
+static int write_text (cbf_handle handle, int ciforcbf, int flags,
+                       char **text, size_t *size)
+{
+	FILE *stream = tmpfile ();
+	long end;
+
+	*text = NULL;
+	*size = 0;
+	if (!stream) return CBF_FILEOPEN;
+	cbf_onfailnez (cbf_write_file (handle, stream, 0, ciforcbf, flags, 0),
+	               fclose (stream))
+	if (fseek (stream, 0, SEEK_END) || (end = ftell (stream)) < 0 ||
+	    !(*text = malloc ((size_t) end + 1))) {
+		fclose (stream);
+		return CBF_FILEREAD;
+	}
+	rewind (stream);
+	*size = fread (*text, 1, (size_t) end, stream);
+	(*text) [*size] = '\0';
+	fclose (stream);
+	return *size == (size_t) end ? CBF_SUCCESS : CBF_FILEREAD;
+}
+
+
+  /* Values for each way the writer has of writing one */
+
+static const char *write_values[] = {
+	"plain",
+	"two words",
+	"it's",
+	"it's \"both\"",
+	"line one\nline two",
+	"_looks_like_a_tag",
+	"#not_a_comment",
+	"data_not_a_block",
+	"loop_",
+	"?",
+	".",
+	"",
+	"a\tb",
+	";semicolon",
+	"caf\303\251",
+	"l7890123456789012345678901234567890123456789012345678901234567890123456789",
+	"l789012345678901234567890123456789012345678901234567890123456789012345678901234567890",
+	";78901234567890123456789012345678901234567890123456789012345678901234567890",
+	"long words, long words, long words, long words, long words, long words, long words,"
+	" long words, long words, long words, long words, long words, long words, long words",
+	"text\n\nwith a very long line: xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+	"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\nand a \\ backslash"
+};
+
+#define WRITE_VALUES (sizeof (write_values) / sizeof (write_values[0]))
+
+  /* Reading them back warns only of the non-ASCII characters */
+
+static const char write_log[] =
+	"CBFlib: warning input line 27 (15) -- invalid character\n"
+	"CBFlib: warning input line 27 (16) -- invalid character\n";
+
+#define IMAGE_SIZE 4000
+
+
+  /* A cbf with one item for each value, and an image */
+
+static int make_write_cbf (cbf_handle *handle, int *image)
+{
+	char name[20];
+	size_t i;
+
+	cbf_failnez (cbf_make_handle (handle))
+	cbf_failnez (cbf_set_cbf_logfile (*handle, NULL))
+	cbf_failnez (cbf_new_datablock (*handle, "write"))
+	cbf_failnez (cbf_new_category (*handle, "write"))
+	for (i = 0; i < WRITE_VALUES; i++) {
+		sprintf (name, "v%u", (unsigned int) i);
+		cbf_failnez (cbf_new_column (*handle, name))
+		cbf_failnez (cbf_set_value (*handle, write_values[i]))
+	}
+	for (i = 0; i < IMAGE_SIZE; i++)
+		image[i] = (int) ((i * 7919) % 1000) - 300;
+	cbf_failnez (cbf_new_category (*handle, "array_data"))
+	cbf_failnez (cbf_new_column (*handle, "data"))
+	return cbf_set_integerarray (*handle, CBF_BYTE_OFFSET, 1, image,
+	                             sizeof (int), 1, IMAGE_SIZE);
+}
+
+
+  /* Undo the folding of a text field whose lines were too long: the
+     first line is a backslash, and a backslash ends each folded line */
+
+static void unfold (const char *value, char *unfolded)
+{
+	if (strncmp (value, "\\\n", 2)) {
+		strcpy (unfolded, value);
+		return;
+	}
+	for (value += 2; *value; value++) {
+		if (*value == '\\' && (value[1] == '\n' || !value[1])) {
+			if (value[1]) value++;
+			continue;
+		}
+		*unfolded++ = *value;
+	}
+	*unfolded = '\0';
+}
+
+
+static testResult_t check_write_cbf (cbf_handle handle, const int *image)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	int *copy = malloc (IMAGE_SIZE * sizeof (int));
+	char name[20];
+	size_t i, count = 0;
+	int id = 0;
+
+	TEST (copy != NULL);
+	if (!copy) return r;
+	TEST_CBF_PASS (cbf_find_category (handle, "write"));
+	for (i = 0; i < WRITE_VALUES; i++) {
+		const char *value = NULL;
+		char unfolded[400] = "";
+
+		sprintf (name, "v%u", (unsigned int) i);
+		TEST_CBF_PASS (cbf_find_column (handle, name));
+		TEST_CBF_PASS (cbf_get_value (handle, &value));
+		if (value) unfold (value, unfolded);
+		TEST (!strcmp (unfolded, write_values[i]));
+		if (strcmp (unfolded, write_values[i]))
+			fprintf (stderr, "%s: <%s>\n", name, value ? value : "(null)");
+	}
+	TEST_CBF_PASS (cbf_find_category (handle, "array_data"));
+	TEST_CBF_PASS (cbf_find_column (handle, "data"));
+	TEST_CBF_PASS (cbf_get_integerarray (handle, &id, copy, sizeof (int), 1,
+	                                     IMAGE_SIZE, &count));
+	TEST (IMAGE_SIZE == count && !memcmp (copy, image, sizeof (int) * IMAGE_SIZE));
+	free (copy);
+	return r;
+}
+
+
+static testResult_t test_write_cases (int ciforcbf)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL, copy = NULL;
+	char *text = NULL, *again = NULL, *log = NULL;
+	size_t size = 0, again_size = 0;
+	int image[IMAGE_SIZE], pass;
+
+	TEST_CBF_PASS (make_write_cbf (&handle, image));
+	TEST_CBF_PASS (write_text (handle, ciforcbf, MSG_DIGEST, &text, &size));
+
+	  /* The same cbf, written again */
+
+	TEST_CBF_PASS (write_text (handle, ciforcbf, MSG_DIGEST, &again, &again_size));
+	TEST (text && again && size == again_size && !memcmp (text, again, size));
+	free (again);
+	again = NULL;
+
+	  /* Read back and written again.  A long quoted string is folded
+	     into a text field, which is written as the text field it reads
+	     back as, so from the first copy on the output must not change */
+
+	for (pass = 0; pass < 3 && text && !r.fail; pass++) {
+		TEST_CBF_PASS (read_text (&copy, text, size, 0, &log));
+		TEST (log && !strcmp (log, write_log));
+		if (log && strcmp (log, write_log)) fprintf (stderr, "%s", log);
+		free (log);
+		if (!copy) break;
+		TEST_COMPONENT (check_write_cbf (copy, image));
+		TEST_CBF_PASS (write_text (copy, ciforcbf, MSG_DIGEST, &again, &again_size));
+		if (pass)
+			TEST (again && size == again_size && !memcmp (text, again, size));
+		TEST_CBF_PASS (cbf_free_handle (copy));
+		copy = NULL;
+		free (text);
+		text = again;
+		size = again_size;
+		again = NULL;
+	}
+
+	free (again);
+	free (text);
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* Words of lengths that bring them to the end of a line at every
+     column: the layout must be the one the value-at-a-time writer gave */
+
+#define LAYOUT_ROWS 6
+
+#define LAYOUT_COLUMNS 9
+
+static const char layout_cif[] =
+	"data_layout\n"
+	"\n"
+	"loop_\n"
+	"_layout.c0\n"
+	"_layout.c1\n"
+	"_layout.c2\n"
+	"_layout.c3\n"
+	"_layout.c4\n"
+	"_layout.c5\n"
+	"_layout.c6\n"
+	"_layout.c7\n"
+	"_layout.c8\n"
+	" a bcdefg cdefghijklm def efghijkl fghijklmnopqr ghijk hijklmnopq ij\n"
+	" bcdefghi cdefghijklmno defgh efghijklmn fg ghijklm hijklmnopqrs ijkl\n"
+	" jklmnopqr\n"
+	" cd defghij efghijklmnop fghi ghijklmno h ijklmn jklmnopqrst klm\n"
+	" defghijkl e fghijk ghijklmnopq hij ijklmnop jklmnopqrstuv klmno lmnopqrstu\n"
+	" efg fghijklm ghijklmnopqrs hijkl ijklmnopqr jk klmnopq lmnopqrstuvw mnop\n"
+	" fghijklmno gh hijklmn ijklmnopqrst jklm klmnopqrs l mnopqr nopqrstuvwx\n";
+
+static void layout_word (unsigned int row, unsigned int column, char *word)
+{
+	unsigned int i, length = (row * 7 + column * 5) % 13 + 1;
+
+	for (i = 0; i < length; i++) word[i] = (char) ('a' + (row + column + i) % 26);
+	word[length] = '\0';
+}
+
+
+static testResult_t test_write_layout (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	char *text = NULL, name[8], word[16];
+	size_t size = 0;
+	unsigned int row, column;
+
+	TEST_CBF_PASS (cbf_make_handle (&handle));
+	TEST_CBF_PASS (cbf_new_datablock (handle, "layout"));
+	TEST_CBF_PASS (cbf_new_category (handle, "layout"));
+	for (column = 0; column < LAYOUT_COLUMNS; column++) {
+		sprintf (name, "c%u", column);
+		TEST_CBF_PASS (cbf_new_column (handle, name));
+	}
+	for (row = 0; !r.fail && row < LAYOUT_ROWS; row++) {
+		TEST_CBF_PASS (cbf_new_row (handle));
+		for (column = 0; column < LAYOUT_COLUMNS; column++) {
+			layout_word (row, column, word);
+			TEST_CBF_PASS (cbf_select_column (handle, column));
+			TEST_CBF_PASS (cbf_set_value (handle, word));
+		}
+	}
+	TEST_CBF_PASS (write_text (handle, CIF, 0, &text, &size));
+	TEST (text && strstr (text, "data_") && !strcmp (strstr (text, "data_"), layout_cif));
+	if (text && strstr (text, "data_") && strcmp (strstr (text, "data_"), layout_cif))
+		fprintf (stderr, "%s", strstr (text, "data_"));
+
+	free (text);
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* A loop of LOOP_ROWS rows, written and read back: its output is
+     several times the size of the output buffer */
+
+static testResult_t test_write_loop (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL, copy = NULL;
+	char *text = NULL, *again = NULL, *log = NULL;
+	char word[40], quoted[40], ltext[90], *values[3];
+	const char *columns[] = {"quoted", "word", "text"};
+	size_t size = 0, again_size = 0;
+	unsigned int i, j;
+
+	values[0] = quoted;
+	values[1] = word;
+	values[2] = ltext;
+	TEST_CBF_PASS (cbf_make_handle (&handle));
+	TEST_CBF_PASS (cbf_new_datablock (handle, "loop"));
+	TEST_CBF_PASS (cbf_new_category (handle, "loop"));
+	TEST_CBF_PASS (cbf_new_column (handle, "id"));
+	for (j = 0; j < 3; j++)
+		TEST_CBF_PASS (cbf_new_column (handle, columns[j]));
+	for (i = 0; !r.fail && i < LOOP_ROWS; i++) {
+		loop_row (i, word, quoted, ltext);
+		TEST_CBF_PASS (cbf_new_row (handle));
+		TEST_CBF_PASS (cbf_find_column (handle, "id"));
+		TEST_CBF_PASS (cbf_set_integervalue (handle, (int) i));
+		for (j = 0; j < 3; j++) {
+			TEST_CBF_PASS (cbf_find_column (handle, columns[j]));
+			TEST_CBF_PASS (cbf_set_value (handle, values[j]));
+		}
+	}
+	TEST_CBF_PASS (write_text (handle, CIF, 0, &text, &size));
+	TEST (size > 4 * CBF_BULK_WRITE_BUFFER);
+
+	if (text) {
+		TEST_CBF_PASS (read_text (&copy, text, size, 0, &log));
+		TEST (log && !*log);
+		free (log);
+	}
+	for (i = 0; copy && !r.fail && i < LOOP_ROWS; i++) {
+		const char *value = NULL;
+		int id = -1;
+
+		loop_row (i, word, quoted, ltext);
+		TEST_CBF_PASS (cbf_find_tag (copy, "_loop.id"));
+		TEST_CBF_PASS (cbf_select_row (copy, i));
+		TEST_CBF_PASS (cbf_get_integervalue (copy, &id));
+		TEST ((int) i == id);
+		for (j = 0; j < 3; j++) {
+			TEST_CBF_PASS (cbf_find_column (copy, columns[j]));
+			TEST_CBF_PASS (cbf_get_value (copy, &value));
+			TEST (value && !strcmp (value, values[j]));
+		}
+	}
+	if (copy) {
+		TEST_CBF_PASS (write_text (copy, CIF, 0, &again, &again_size));
+		TEST (again && size == again_size && !memcmp (text, again, size));
+		TEST_CBF_PASS (cbf_free_handle (copy));
+	}
+
+	free (again);
+	free (text);
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+int main(int argc, char ** argv)
+{
+	testResult_t r = {0,0,0};
+
+	CBF_UNUSED(argc);
+	CBF_UNUSED(argv);
+
+	TEST_COMPONENT(test_lex_cases());
+	TEST_COMPONENT(test_lex_loop());
+	TEST_COMPONENT(test_write_cases(CIF));
+	TEST_COMPONENT(test_write_cases(CBF));
+	TEST_COMPONENT(test_write_layout());
+	TEST_COMPONENT(test_write_loop());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
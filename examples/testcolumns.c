@@ -0,0 +1,500 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for the storage of loop columns, their cached numeric   *
+ * values and the bulk column accessors.                              *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "cbf_tree.h"
+#include "unittest.h"
+
+/*
+A loop column read from a file is packed into blocks of text held by
+the column once it reaches CBF_PACK_ROWS rows, and any column can be
+packed on demand.  Neither may change a value.  The numbers
+cbf_get_doublevalue, cbf_get_integervalue and cbf_get_longvalue parse
+are cached with the column, so setting a value, inserting or deleting
+a row, or shrinking and growing the column must never leave a row
+answering with the number of a value it no longer holds.
+
+The bulk accessors read and write whole columns through the same
+cache.  A null, "?", "." or a missing value, reads as 0 and is marked
+in the mask, and a masked value is written as a null.
+*/
+
+#define ROWS 3000
+
+  /* Row i of the loop: its index, half of it and a name */
+
+static double row_value (unsigned int i)
+{
+	return i * 0.5;
+}
+
+
+  /* Read a loop of rows rows into a new handle */
+
+static int read_loop (cbf_handle *handle, unsigned int rows)
+{
+	FILE *in = tmpfile ();
+	unsigned int i;
+
+	*handle = NULL;
+	if (!in) return CBF_FILEOPEN;
+	fputs ("data_columns\nloop_\n_loop.id\n_loop.v\n_loop.name\n", in);
+	for (i = 0; i < rows; i++)
+		fprintf (in, "%u %.1f name_%u\n", i, row_value (i), i);
+	if (fflush (in) || fseek (in, 0, SEEK_SET)) {
+		fclose (in);
+		return CBF_FILEWRITE;
+	}
+	cbf_failnez (cbf_make_handle (handle))
+	cbf_failnez (cbf_read_file (*handle, in, MSG_NODIGEST))
+	return cbf_find_category (*handle, "loop");
+}
+
+
+  /* Check every row against row_value, with the cache empty or full */
+
+static testResult_t check_rows (cbf_handle handle, unsigned int expected)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	unsigned int i, rows = 0;
+
+	TEST_CBF_PASS (cbf_count_rows (handle, &rows));
+	TEST (expected == rows);
+	for (i = 0; i < rows && !r.fail; i++) {
+		const char *value = NULL;
+		char name[20];
+		double v = -1.;
+		int id = -1;
+		long lid = -1;
+
+		sprintf (name, "name_%u", i);
+		TEST_CBF_PASS (cbf_find_column (handle, "id"));
+		TEST_CBF_PASS (cbf_select_row (handle, i));
+		TEST_CBF_PASS (cbf_get_integervalue (handle, &id));
+		TEST_CBF_PASS (cbf_get_longvalue (handle, &lid));
+		TEST ((int) i == id && (long) i == lid);
+		TEST_CBF_PASS (cbf_find_column (handle, "v"));
+		TEST_CBF_PASS (cbf_get_doublevalue (handle, &v));
+		TEST (row_value (i) == v);
+		TEST_CBF_PASS (cbf_find_column (handle, "name"));
+		TEST_CBF_PASS (cbf_get_value (handle, &value));
+		TEST (value && !strcmp (value, name));
+	}
+	return r;
+}
+
+
+static testResult_t test_packed_loop (unsigned int rows)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	const char *value = NULL;
+	cbf_node *column = NULL;
+
+	TEST_CBF_PASS (read_loop (&handle, rows));
+	if (!handle || r.fail) return r;
+
+	  /* Only a long column is packed as it is read */
+
+	TEST_CBF_PASS (cbf_find_column (handle, "name"));
+	column = handle->node;
+	TEST_CBF_PASS (cbf_get_columnrow (&value, column, 10));
+	TEST (!cbf_is_packed_value (column, value) == (rows < CBF_PACK_ROWS));
+	TEST_CBF_PASS (cbf_get_columnrow (&value, column, rows - 1));
+	TEST (!cbf_is_packed_value (column, value) == (rows < CBF_PACK_ROWS));
+
+	  /* Twice, to read the cached numbers the first pass left */
+
+	TEST_COMPONENT (check_rows (handle, rows));
+	TEST_COMPONENT (check_rows (handle, rows));
+
+	  /* Packing on demand takes in every row */
+
+	TEST_CBF_PASS (cbf_pack_column (column));
+	TEST_CBF_PASS (cbf_get_columnrow (&value, column, 10));
+	TEST (cbf_is_packed_value (column, value));
+	TEST_CBF_PASS (cbf_get_columnrow (&value, column, rows - 1));
+	TEST (cbf_is_packed_value (column, value));
+	TEST_COMPONENT (check_rows (handle, rows));
+
+	TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* Select a row of a column and get its double value */
+
+static int get_double (cbf_handle handle, const char *column,
+                       unsigned int row, double *number)
+{
+	cbf_failnez (cbf_find_column (handle, column))
+	cbf_failnez (cbf_select_row (handle, row))
+	return cbf_get_doublevalue (handle, number);
+}
+
+
+static testResult_t test_cache (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	unsigned int i, row, rows = 0;
+	double v = -1.;
+	long lv = -1;
+	int iv = -1;
+
+	TEST_CBF_PASS (read_loop (&handle, ROWS));
+	if (!handle || r.fail) return r;
+
+	  /* Fill the cache of every row */
+
+	for (i = 0; i < ROWS; i++)
+		TEST_CBF_PASS (get_double (handle, "v", i, &v));
+
+	  /* Setting a value, in the first rows and in the packed ones */
+
+	for (row = 7; row < ROWS; row += CBF_PACK_ROWS) {
+		TEST_CBF_PASS (get_double (handle, "v", row, &v));
+		TEST (row_value (row) == v);
+		TEST_CBF_PASS (cbf_set_value (handle, "2.25"));
+		TEST_CBF_PASS (cbf_get_doublevalue (handle, &v));
+		TEST (2.25 == v);
+		TEST_CBF_PASS (cbf_set_doublevalue (handle, "%.2f", -4.5));
+		TEST_CBF_PASS (cbf_get_doublevalue (handle, &v));
+		TEST (-4.5 == v);
+		TEST_CBF_PASS (cbf_set_value (handle, "?"));
+		TEST_CBF_PASS (cbf_get_doublevalue (handle, &v));
+		TEST (0. == v);
+	}
+
+	  /* The long cache holds the full value, whichever call filled it */
+
+	TEST_CBF_PASS (cbf_find_column (handle, "id"));
+	TEST_CBF_PASS (cbf_select_row (handle, 20));
+	TEST_CBF_PASS (cbf_get_integervalue (handle, &iv));
+	TEST (20 == iv);
+	TEST_CBF_PASS (cbf_set_value (handle, "3000000000"));
+	TEST_CBF_PASS (cbf_get_integervalue (handle, &iv));
+	TEST_CBF_PASS (cbf_get_longvalue (handle, &lv));
+	if (sizeof (long) > 4)
+		TEST (3000000000. == (double) lv);
+	TEST_CBF_PASS (cbf_set_integervalue (handle, 21));
+	TEST_CBF_PASS (cbf_get_longvalue (handle, &lv));
+	TEST (21 == lv);
+
+	  /* Deleting a row moves the cached numbers with the rows after it,
+	     so a row that was not cached, moving up past one that was, must
+	     still parse its value */
+
+	for (i = 0, row = 100; row < ROWS - 10; i++, row += CBF_PACK_ROWS) {
+		TEST_CBF_PASS (get_double (handle, "v", row + 2, &v));
+		TEST_CBF_PASS (cbf_set_value (handle, "1.75"));
+		TEST_CBF_PASS (get_double (handle, "v", row + 1, &v));
+		TEST (row_value (row + i + 1) == v);
+		TEST_CBF_PASS (cbf_delete_row (handle, row));
+		TEST_CBF_PASS (get_double (handle, "v", row, &v));
+		TEST (row_value (row + i + 1) == v);
+		TEST_CBF_PASS (get_double (handle, "v", row + 1, &v));
+		TEST (1.75 == v);
+	}
+
+	  /* Inserting one moves them the other way and caches nothing in it */
+
+	TEST_CBF_PASS (get_double (handle, "v", 50, &v));
+	TEST (row_value (50) == v);
+	TEST_CBF_PASS (cbf_insert_row (handle, 50));
+	TEST_CBF_PASS (get_double (handle, "v", 50, &v));
+	TEST (0. == v);
+	TEST_CBF_PASS (get_double (handle, "v", 51, &v));
+	TEST (row_value (50) == v);
+
+	  /* Deleting the last rows and adding new ones leaves them empty */
+
+	TEST_CBF_PASS (cbf_count_rows (handle, &rows));
+	for (i = 1; i <= 5; i++) {
+		TEST_CBF_PASS (get_double (handle, "v", rows - i, &v));
+		TEST (v != 0.);
+	}
+	for (i = 1; i <= 5; i++) {
+		TEST_CBF_PASS (cbf_delete_row (handle, rows - i));
+	}
+	for (i = 1; i <= 5; i++)
+		TEST_CBF_PASS (cbf_new_row (handle));
+	for (i = 1; i <= 5; i++) {
+		TEST_CBF_PASS (get_double (handle, "v", rows - i, &v));
+		TEST (0. == v);
+	}
+
+	TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* Rewind a stream and read it into a new handle */
+
+static int read_stream (cbf_handle *handle, FILE *in)
+{
+	*handle = NULL;
+	if (fflush (in) || fseek (in, 0, SEEK_SET)) {
+		fclose (in);
+		return CBF_FILEWRITE;
+	}
+	cbf_failnez (cbf_make_handle (handle))
+	cbf_failnez (cbf_read_file (*handle, in, MSG_NODIGEST))
+	return cbf_find_category (*handle, "mask");
+}
+
+
+  /* The rows of the masks category: numbers, nulls and a quoted number */
+
+static const char *mask_rows [] = {
+	"1.5 3", "? ?", ". .", "-2.25 -7", "'4.5' '8'", "? 3000000000"
+};
+
+#define MASK_ROWS (sizeof mask_rows / sizeof *mask_rows)
+
+static const double mask_doubles [MASK_ROWS] = {1.5, 0., 0., -2.25, 4.5, 0.};
+
+static const char mask_masks [MASK_ROWS] = {
+	CBF_MASK_VALUE, CBF_MASK_UNKNOWN, CBF_MASK_INAPPLICABLE,
+	CBF_MASK_VALUE, CBF_MASK_VALUE, CBF_MASK_UNKNOWN
+};
+
+
+static testResult_t test_get_columns (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	FILE *in = tmpfile ();
+	double x [MASK_ROWS + 2];
+	int n [MASK_ROWS + 2];
+	char mask [MASK_ROWS + 2];
+	size_t i, count = 0;
+	long lv = -1;
+
+	TEST (in != NULL);
+	if (!in) return r;
+	fputs ("data_masks\nloop_\n_mask.x\n_mask.n\n", in);
+	for (i = 0; i < MASK_ROWS; i++)
+		fprintf (in, "%s\n", mask_rows [i]);
+	TEST_CBF_PASS (read_stream (&handle, in));
+	if (!handle || r.fail) return r;
+
+	  /* Twice, to read the numbers the first pass cached */
+
+	for (i = 0; i < 2; i++) {
+		size_t row;
+
+		memset (mask, -1, sizeof mask);
+		TEST_CBF_PASS (cbf_get_doublecolumn (handle, "x", x, mask,
+		                                     MASK_ROWS + 2, &count));
+		TEST (MASK_ROWS == count);
+		for (row = 0; row < MASK_ROWS; row++)
+			TEST (mask_doubles [row] == x [row] &&
+			      mask_masks [row] == mask [row]);
+		TEST (-1 == mask [MASK_ROWS]);
+	}
+
+	  /* The row of the long value reads as the one get_longvalue caches */
+
+	memset (mask, -1, sizeof mask);
+	TEST_CBF_PASS (cbf_get_integercolumn (handle, "n", n, mask, MASK_ROWS,
+	                                      &count));
+	TEST (MASK_ROWS == count);
+	TEST (3 == n [0] && 0 == n [1] && 0 == n [2] && -7 == n [3] && 8 == n [4]);
+	TEST (CBF_MASK_VALUE == mask [0] && CBF_MASK_UNKNOWN == mask [1] &&
+	      CBF_MASK_INAPPLICABLE == mask [2] && CBF_MASK_VALUE == mask [5]);
+	TEST_CBF_PASS (cbf_find_column (handle, "n"));
+	TEST_CBF_PASS (cbf_select_row (handle, 5));
+	TEST_CBF_PASS (cbf_get_longvalue (handle, &lv));
+	if (sizeof (long) > 4)
+		TEST (3000000000. == (double) lv);
+
+	  /* Fewer elements than rows, and no mask */
+
+	TEST_CBF_PASS (cbf_get_doublecolumn (handle, "x", x, NULL, 1, &count));
+	TEST (1 == count && 1.5 == x [0]);
+	TEST_CBF_PASS (cbf_get_integercolumn (handle, "n", n, NULL, 0, &count));
+	TEST (0 == count);
+
+	  /* Setting a value of a cached column, to a number and to none */
+
+	TEST_CBF_PASS (cbf_find_column (handle, "x"));
+	TEST_CBF_PASS (cbf_select_row (handle, 0));
+	TEST_CBF_PASS (cbf_set_value (handle, "6.5"));
+	TEST_CBF_PASS (cbf_select_row (handle, 3));
+	TEST_CBF_PASS (cbf_set_value (handle, NULL));
+	TEST_CBF_PASS (cbf_get_doublecolumn (handle, "x", x, mask, MASK_ROWS,
+	                                     &count));
+	TEST (6.5 == x [0] && CBF_MASK_VALUE == mask [0]);
+	TEST (0. == x [3] && CBF_MASK_UNKNOWN == mask [3]);
+	TEST_CBF_PASS (cbf_find_column (handle, "n"));
+	TEST_CBF_PASS (cbf_select_row (handle, 4));
+	TEST_CBF_PASS (cbf_set_integervalue (handle, -12));
+	TEST_CBF_PASS (cbf_get_integercolumn (handle, "n", n, mask, MASK_ROWS,
+	                                      &count));
+	TEST (-12 == n [4] && CBF_MASK_VALUE == mask [4]);
+
+	  /* A missing column and missing arguments */
+
+	TEST_CBF_FAIL (cbf_get_doublecolumn (handle, "y", x, mask, MASK_ROWS,
+	                                     &count));
+	TEST_CBF_FAIL (cbf_get_integercolumn (handle, "n", NULL, mask, 1,
+	                                      &count));
+	TEST_CBF_FAIL (cbf_get_doublecolumn (handle, NULL, x, mask, 1, &count));
+
+	TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+#define SET_ROWS 8
+
+static testResult_t test_set_columns (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL, copy = NULL;
+	FILE *stream = tmpfile ();
+	double x [SET_ROWS], xr [SET_ROWS];
+	int n [SET_ROWS], nr [SET_ROWS];
+	char xmask [SET_ROWS], nmask [SET_ROWS], mask [SET_ROWS];
+	const char *value = NULL;
+	unsigned int rows = 0;
+	size_t i, count = 0;
+
+	TEST (stream != NULL);
+	if (!stream) return r;
+	for (i = 0; i < SET_ROWS; i++) {
+		x [i] = i * 0.25 - 1.125;
+		n [i] = (int) (i * 1000003) - 4;
+		xmask [i] = (char) (i % 3);
+		nmask [i] = (char) (i % 4 == 1);
+	}
+
+	  /* Each call creates its column and the rows it needs */
+
+	TEST_CBF_PASS (cbf_make_handle (&handle));
+	TEST_CBF_PASS (cbf_new_datablock (handle, "masks"));
+	TEST_CBF_PASS (cbf_new_category (handle, "mask"));
+	TEST_CBF_PASS (cbf_set_doublecolumn (handle, "x", x, xmask, SET_ROWS - 3,
+	                                     NULL));
+	TEST_CBF_PASS (cbf_set_integercolumn (handle, "n", n, nmask, SET_ROWS));
+	TEST_CBF_PASS (cbf_count_rows (handle, &rows));
+	TEST (SET_ROWS == rows);
+
+	  /* Nulls are written as themselves */
+
+	TEST_CBF_PASS (cbf_find_column (handle, "x"));
+	TEST_CBF_PASS (cbf_select_row (handle, 1));
+	TEST_CBF_PASS (cbf_get_value (handle, &value));
+	TEST (value && !strcmp (value, "?"));
+	TEST_CBF_PASS (cbf_select_row (handle, 2));
+	TEST_CBF_PASS (cbf_get_value (handle, &value));
+	TEST (value && !strcmp (value, "."));
+
+	  /* A value the buffer cannot hold */
+
+	TEST_CBF_FAIL (cbf_set_doublecolumn (handle, "y", x, NULL, 1, "%600f"));
+	TEST_CBF_FAIL (cbf_set_integercolumn (handle, "n", NULL, NULL, 1));
+
+	  /* Read back, before and after a write and a read */
+
+	TEST_CBF_PASS (cbf_write_file (handle, stream, 0, CIF, 0, 0));
+	TEST_CBF_PASS (read_stream (&copy, stream));
+	for (i = 0; i < 2 && !r.fail; i++) {
+		cbf_handle h = i ? copy : handle;
+		size_t row;
+
+		TEST_CBF_PASS (cbf_get_doublecolumn (h, "x", xr, mask, SET_ROWS,
+		                                     &count));
+		TEST (SET_ROWS == count);
+		for (row = 0; row < SET_ROWS; row++) {
+			char expected = row < SET_ROWS - 3 ? xmask [row] :
+			                (char) CBF_MASK_UNKNOWN;
+
+			TEST (expected == mask [row]);
+			TEST (xr [row] == (expected == CBF_MASK_VALUE ? x [row] : 0.));
+		}
+		TEST_CBF_PASS (cbf_get_integercolumn (h, "n", nr, mask, SET_ROWS,
+		                                      &count));
+		TEST (SET_ROWS == count);
+		for (row = 0; row < SET_ROWS; row++) {
+			TEST (nmask [row] == mask [row]);
+			TEST (nr [row] == (nmask [row] ? 0 : n [row]));
+		}
+	}
+
+	TEST_CBF_PASS (cbf_free_handle (copy));
+	TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+int main(int argc, char ** argv)
+{
+	testResult_t r = {0,0,0};
+
+	CBF_UNUSED(argc);
+	CBF_UNUSED(argv);
+
+	TEST_COMPONENT(test_packed_loop(CBF_PACK_ROWS - 1));
+	TEST_COMPONENT(test_packed_loop(ROWS));
+	TEST_COMPONENT(test_cache());
+	TEST_COMPONENT(test_get_columns());
+	TEST_COMPONENT(test_set_columns());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
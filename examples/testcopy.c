@@ -0,0 +1,269 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for copying binary sections with cbf_copy_cbf, verbatim *
+ * when the compression is kept and recompressed when it is not.      *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "cbf_copy.h"
+#include "unittest.h"
+
+/*
+A byte-offset image of several hundred KB, read back from a file, is
+copied with cbf_copy_cbf.  Keeping the compression passes the
+compressed section through a transfer block at a time into the
+temporary file of the target, so the copy must write out exactly as
+the source does, padding included.  The temporary file is on disk by
+default and in memory when CBF_DEFER_TMP is "yes".
+
+Copying a packed, packed V2, flat packed or canonical image, of two
+dimensions or three, to byte-offset transcodes it a tile at a time, so
+the copy must write out exactly as the same image stored directly with
+cbf_set_integerarray as byte-offset.
+*/
+
+#define FAST 1024
+#define SLOW 512
+#define ELEMENTS (FAST*SLOW)
+
+/* The middle dimension of the three-dimensional images */
+
+#define MID 16
+
+static void make_image(int * image)
+{
+	size_t i;
+
+	srand(2);
+	for (i = 0; i < ELEMENTS; ++i) {
+		image[i] = (int)(i%1000)+rand()%300;
+		if (rand()%97 == 0) image[i] -= 70000;
+	}
+}
+
+/* Write a handle to a temporary stream and return the whole of it */
+
+static int write_handle(cbf_handle h, int flags, char ** text, size_t * size)
+{
+	FILE * stream = tmpfile();
+	long end;
+
+	*text = NULL;
+	*size = 0;
+	if (!stream) return CBF_FILEOPEN;
+	cbf_onfailnez(cbf_write_widefile(h,stream,0,CBF,MSG_DIGEST|MIME_HEADERS|flags,0),
+		fclose(stream))
+	if (fseek(stream,0,SEEK_END) || (end = ftell(stream)) < 0
+		|| !(*text = malloc((size_t)end+1))) {
+		fclose(stream);
+		return CBF_FILEREAD;
+	}
+	rewind(stream);
+	*size = fread(*text,1,(size_t)end,stream);
+	(*text)[*size] = '\0';
+	fclose(stream);
+	return *size == (size_t)end ? CBF_SUCCESS : CBF_FILEREAD;
+}
+
+/* Store the image with the given compression and dimensions, write it
+   with the given padding and read it back */
+
+static int make_source(cbf_handle * h, const int * image, int compression,
+		int padding, size_t mid)
+{
+	cbf_handle made = NULL;
+	FILE * stream = tmpfile();
+
+	if (!stream) return CBF_FILEOPEN;
+	cbf_failnez(cbf_make_handle(&made));
+	cbf_failnez(cbf_new_datablock(made,"copy"));
+	cbf_failnez(cbf_new_category(made,"array_data"));
+	cbf_failnez(cbf_new_column(made,"data"));
+	cbf_failnez(cbf_new_row(made));
+	if (mid)
+		cbf_failnez(cbf_set_integerarray_wdims_fs(made,compression,1,(void *)image,
+				sizeof(int),1,ELEMENTS,"little_endian",FAST,mid,SLOW/mid,0))
+	else
+		cbf_failnez(cbf_set_integerarray_wdims_fs(made,compression,1,(void *)image,
+				sizeof(int),1,ELEMENTS,"little_endian",FAST,SLOW,0,0))
+	cbf_failnez(cbf_write_widefile(made,stream,0,CBF,MSG_DIGEST|MIME_HEADERS|padding,0));
+	cbf_failnez(cbf_free_handle(made));
+	rewind(stream);
+	cbf_failnez(cbf_make_handle(h));
+	return cbf_read_widefile(*h,stream,MSG_DIGEST);
+}
+
+static int get_image(cbf_handle h, int * image)
+{
+	int id = 0;
+	size_t read = 0;
+
+	cbf_failnez(cbf_rewind_datablock(h));
+	cbf_failnez(cbf_find_category(h,"array_data"));
+	cbf_failnez(cbf_find_column(h,"data"));
+	cbf_failnez(cbf_rewind_row(h));
+	cbf_failnez(cbf_get_integerarray(h,&id,image,sizeof(int),1,ELEMENTS,&read));
+	return read == ELEMENTS ? CBF_SUCCESS : CBF_ENDOFDATA;
+}
+
+testResult_t test_copy(int compression, int padding)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle in = NULL, out = NULL;
+	int * image = malloc(ELEMENTS*sizeof(int));
+	int * copied = malloc(ELEMENTS*sizeof(int));
+	char * source_text = NULL, * copy_text = NULL;
+	size_t source_size = 0, copy_size = 0;
+
+	TEST(image && copied);
+	if (!r.fail) {
+		make_image(image);
+		TEST_CBF_PASS(make_source(&in,image,CBF_BYTE_OFFSET,padding,0));
+		TEST_CBF_PASS(cbf_make_handle(&out));
+		TEST_CBF_PASS(cbf_copy_cbf(out,in,compression,0));
+
+		/* the copy decodes to the image */
+		memset(copied,0,ELEMENTS*sizeof(int));
+		TEST_CBF_PASS(get_image(out,copied));
+		TEST(!memcmp(copied,image,ELEMENTS*sizeof(int)));
+
+		/* a verbatim copy writes out as the source does and keeps its
+		   padding; a recompressed one does not */
+		TEST_CBF_PASS(write_handle(in,0,&source_text,&source_size));
+		TEST_CBF_PASS(write_handle(out,0,&copy_text,&copy_size));
+		if (source_text && copy_text) {
+			if (compression == CBF_BYTE_OFFSET) {
+				TEST(source_size==copy_size && !memcmp(source_text,copy_text,copy_size));
+			} else {
+				TEST(source_size!=copy_size || memcmp(source_text,copy_text,copy_size));
+			}
+			TEST(!padding == !strstr(copy_text,"X-Binary-Size-Padding: 4095"));
+		}
+	}
+
+	cbf_free_handle(out);
+	cbf_free_handle(in);
+	free(source_text);
+	free(copy_text);
+	free(image);
+	free(copied);
+	return r;
+}
+
+testResult_t test_transcode(int compression, size_t mid)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle in = NULL, out = NULL, direct = NULL;
+	int * image = malloc(ELEMENTS*sizeof(int));
+	int * copied = malloc(ELEMENTS*sizeof(int));
+	char * direct_text = NULL, * copy_text = NULL;
+	size_t direct_size = 0, copy_size = 0;
+
+	TEST(image != NULL && copied != NULL);
+	if (!r.fail) {
+		make_image(image);
+		TEST_CBF_PASS(make_source(&in,image,compression,0,mid));
+		TEST_CBF_PASS(make_source(&direct,image,CBF_BYTE_OFFSET,0,mid));
+		TEST_CBF_PASS(cbf_make_handle(&out));
+		TEST_CBF_PASS(cbf_copy_cbf(out,in,CBF_BYTE_OFFSET,0));
+		TEST_CBF_PASS(get_image(out,copied));
+		TEST(!memcmp(image,copied,ELEMENTS*sizeof(int)));
+
+		TEST_CBF_PASS(write_handle(direct,0,&direct_text,&direct_size));
+		TEST_CBF_PASS(write_handle(out,0,&copy_text,&copy_size));
+		if (direct_text && copy_text) {
+			TEST(strstr(copy_text,"x-CBF_BYTE_OFFSET") != NULL);
+			TEST(direct_size==copy_size && !memcmp(direct_text,copy_text,copy_size));
+		}
+	}
+
+	cbf_free_handle(out);
+	cbf_free_handle(direct);
+	cbf_free_handle(in);
+	free(direct_text);
+	free(copy_text);
+	free(copied);
+	free(image);
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(test_copy(CBF_BYTE_OFFSET,0));
+	TEST_COMPONENT(test_copy(CBF_BYTE_OFFSET,PAD_4K));
+	TEST_COMPONENT(test_copy(CBF_PACKED,0));
+	TEST_COMPONENT(test_transcode(CBF_PACKED,0));
+	TEST_COMPONENT(test_transcode(CBF_PACKED,MID));
+	TEST_COMPONENT(test_transcode(CBF_PACKED_V2,0));
+	TEST_COMPONENT(test_transcode(CBF_PACKED_V2,MID));
+	TEST_COMPONENT(test_transcode(CBF_PACKED|CBF_FLAT_IMAGE,0));
+	TEST_COMPONENT(test_transcode(CBF_PACKED_V2|CBF_FLAT_IMAGE,0));
+	TEST_COMPONENT(test_transcode(CBF_CANONICAL,0));
+
+	/* again with the temporary files held in memory */
+	if (setenv("CBF_DEFER_TMP","yes",1)) {
+		fprintf(stderr,"testcopy: cannot set CBF_DEFER_TMP\n");
+		return 1;
+	}
+	TEST_COMPONENT(test_copy(CBF_BYTE_OFFSET,0));
+	TEST_COMPONENT(test_copy(CBF_BYTE_OFFSET,PAD_4K));
+	TEST_COMPONENT(test_copy(CBF_PACKED,0));
+	TEST_COMPONENT(test_transcode(CBF_PACKED_V2,MID));
+	TEST_COMPONENT(test_transcode(CBF_PACKED|CBF_FLAT_IMAGE,0));
+	TEST_COMPONENT(test_transcode(CBF_CANONICAL,0));
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
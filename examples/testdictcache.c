@@ -0,0 +1,574 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for the precompiled dictionary images written by        *
+ * cbf_write_dictionary_cache and read by cbf_read_dictionary_cache.  *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "cbf_tree.h"
+#include "unittest.h"
+
+/*
+A cbf validated against a dictionary loaded from a precompiled image
+must draw the same warnings and errors as one validated against the
+dictionary converted from its text, argv[1], from which the image was
+written.  An image whose words do not describe a tree of data blocks,
+save frames, categories and columns, each under a node of the type
+above it, or which runs out of words, must be refused with CBF_FORMAT.
+
+A dictionary shared with cbf_share_dictionary must judge the subject
+as a private one does, for any number of handles at once and in as
+many threads, and must refuse any call that would add to it.
+
+Validation compiles the definition of each item the first time a read
+meets it.  Every bad value of a long loop must still draw its own
+warning, the warnings must be those checking each value against the
+dictionary tree gave, and a handle read again with another dictionary
+must be judged by that dictionary alone.
+*/
+
+  /* The number of validations run at once against a shared dictionary */
+
+#define THREADS 8
+
+  /* The rows of a loop with bad values, and its expected warnings */
+
+#define PLAN_ROWS 24
+
+static const char plan_log [] =
+	"CBFlib: warning input line 8 (17) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 9 (11) -- _array_structure_list.dimension value out of dictionary range\n"
+	"CBFlib: warning input line 10 (15) --  _array_structure_list.precedence type conflicts with dictionary type int\n"
+	"CBFlib: warning input line 11 (17) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 13 (11) -- _array_structure_list.dimension value out of dictionary range\n"
+	"CBFlib: warning input line 14 (17) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 15 (15) --  _array_structure_list.precedence type conflicts with dictionary type int\n"
+	"CBFlib: warning input line 17 (12) -- _array_structure_list.dimension value out of dictionary range\n"
+	"CBFlib: warning input line 17 (17) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 20 (16) --  _array_structure_list.precedence type conflicts with dictionary type int\n"
+	"CBFlib: warning input line 20 (22) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 21 (12) -- _array_structure_list.dimension value out of dictionary range\n"
+	"CBFlib: warning input line 23 (19) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 25 (12) -- _array_structure_list.dimension value out of dictionary range\n"
+	"CBFlib: warning input line 25 (14) --  _array_structure_list.precedence type conflicts with dictionary type int\n"
+	"CBFlib: warning input line 26 (19) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 29 (12) -- _array_structure_list.dimension value out of dictionary range\n"
+	"CBFlib: warning input line 29 (17) -- _array_structure_list.direction value out of dictionary range\n"
+	"CBFlib: warning input line 30 (16) --  _array_structure_list.precedence type conflicts with dictionary type int\n"
+	"CBFlib: warning -- required parent tag _array_structure.id for _array_structure_list.array_id in plans not given\n";
+
+  /* A dictionary of one category, in which directions are sideways or
+     increasing and a dimension is any code */
+
+static const char mini_dictionary [] =
+	"data_mini.dic\n"
+	"_datablock.id mini.dic\n"
+	"save_ARRAY_STRUCTURE_LIST\n"
+	"_category.id array_structure_list\n"
+	"_category.mandatory_code no\n"
+	"loop_\n"
+	"_category_key.name\n"
+	"'_array_structure_list.array_id'\n"
+	"'_array_structure_list.index'\n"
+	"save_\n"
+	"save__array_structure_list.array_id\n"
+	"_item.name '_array_structure_list.array_id'\n"
+	"_item.category_id array_structure_list\n"
+	"_item.mandatory_code yes\n"
+	"_item_type.code code\n"
+	"save_\n"
+	"save__array_structure_list.index\n"
+	"_item.name '_array_structure_list.index'\n"
+	"_item.category_id array_structure_list\n"
+	"_item.mandatory_code yes\n"
+	"_item_type.code int\n"
+	"save_\n"
+	"save__array_structure_list.dimension\n"
+	"_item.name '_array_structure_list.dimension'\n"
+	"_item.category_id array_structure_list\n"
+	"_item.mandatory_code no\n"
+	"_item_type.code code\n"
+	"save_\n"
+	"save__array_structure_list.precedence\n"
+	"_item.name '_array_structure_list.precedence'\n"
+	"_item.category_id array_structure_list\n"
+	"_item.mandatory_code no\n"
+	"_item_type.code int\n"
+	"save_\n"
+	"save__array_structure_list.direction\n"
+	"_item.name '_array_structure_list.direction'\n"
+	"_item.category_id array_structure_list\n"
+	"_item.mandatory_code no\n"
+	"_item_type.code code\n"
+	"loop_\n"
+	"_item_enumeration.value\n"
+	"sideways\n"
+	"increasing\n"
+	"save_\n";
+
+  /* The image header: a magic number and then the byte order, the
+     number of words, the size of the text and a reserved word */
+
+#define HEADER_SIZE (8 + 4 * sizeof (unsigned int))
+
+  /* A cbf to validate, with a value out of range, a value of the wrong
+     type, a tag the dictionary does not define and required tags left
+     out */
+
+static const char subject [] =
+	"data_subject\n"
+	"_diffrn.id DS1\n"
+	"_diffrn_scan.id SCAN1\n"
+	"_diffrn_scan.frames -3\n"
+	"_diffrn_scan.integration_time not_a_number\n"
+	"_diffrn_detector.no_such_item 1\n"
+	"loop_\n"
+	"_diffrn_detector_element.id\n"
+	"_diffrn_detector_element.detector_id\n"
+	"ELEMENT1 DETECTOR1\n";
+
+
+  /* Read text into cif, validating it against the dictionary cif has,
+     and return in log what the validation wrote */
+
+static int read_validated (cbf_handle cif, const char *text, char **log)
+{
+	FILE *in = tmpfile (), *logfile = tmpfile ();
+	long size;
+	int error = CBF_SUCCESS;
+
+	*log = NULL;
+
+	if (!in || !logfile ||
+	    fputs (text, in) == EOF || fseek (in, 0, SEEK_SET))
+		error = CBF_FILEWRITE;
+
+	if (!error) error = cbf_set_cbf_logfile (cif, logfile);
+	if (!error) {
+		error = cbf_read_file (cif, in, MSG_DIGEST);
+		in = NULL;
+	}
+
+	if (!error && (fflush (logfile) || (size = ftell (logfile)) < 0 ||
+	    fseek (logfile, 0, SEEK_SET) || !(*log = calloc (size + 1, 1)) ||
+	    fread (*log, 1, size, logfile) != (size_t) size))
+		error = CBF_FILEREAD;
+
+	error |= cbf_set_cbf_logfile (cif, NULL);
+	if (in) fclose (in);
+	if (logfile) fclose (logfile);
+	return error;
+}
+
+
+  /* Read text into a new cbf with the dictionary of dictionary and
+     return in log what the validation wrote */
+
+static int validate (cbf_handle dictionary, const char *text, char **log)
+{
+	cbf_handle cif = NULL, dict = NULL;
+	int error = cbf_make_handle (&cif);
+
+	*log = NULL;
+
+	if (!error) error = cbf_get_dictionary (dictionary, &dict);
+	if (!error) error = cbf_set_dictionary (cif, dict);
+	if (!error) error = read_validated (cif, text, log);
+
+	if (cif) error |= cbf_free_handle (cif);
+	return error;
+}
+
+
+  /* Write the words and text of image, with word index set to value,
+     to a temporary file, and try to load it as a dictionary */
+
+static int load_patched (const char *image, size_t size,
+                         size_t index, unsigned int value)
+{
+	cbf_handle cif = NULL;
+	FILE *stream = tmpfile ();
+	char *copy = malloc (size);
+	int error = CBF_SUCCESS;
+
+	if (!stream || !copy) error = CBF_ALLOC;
+
+	if (!error) {
+		memcpy (copy, image, size);
+		memcpy (copy + HEADER_SIZE + index * sizeof (unsigned int),
+		        &value, sizeof (unsigned int));
+		if (fwrite (copy, 1, size, stream) != size || fflush (stream))
+			error = CBF_FILEWRITE;
+	}
+
+	if (!error) error = cbf_make_handle (&cif);
+	if (!error) error = cbf_read_dictionary_cache (cif, stream);
+
+	if (cif) error |= cbf_free_handle (cif);
+	if (stream) fclose (stream);
+	free (copy);
+	return error;
+}
+
+
+  /* The words of an image start with the root, its name and its number
+     of children, and then the type, name and number of children of its
+     first data block, and of the first child of that */
+
+static unsigned int image_word (const char *image, size_t index)
+{
+	unsigned int word;
+
+	memcpy (&word, image + HEADER_SIZE + index * sizeof (unsigned int),
+	        sizeof (unsigned int));
+	return word;
+}
+
+
+static testResult_t test_round_trip (const char *dicname)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle text = NULL, cached = NULL, dic = NULL;
+	FILE *stream = NULL, *cache = NULL;
+	char *text_log = NULL, *cached_log = NULL, *image = NULL;
+	long size = 0;
+
+	TEST_CBF_PASS (cbf_make_handle (&dic));
+	TEST_CBF_PASS (cbf_make_handle (&text));
+	TEST_CBF_PASS (cbf_make_handle (&cached));
+	TEST_CBF_PASS (cbf_set_cbf_logfile (dic, NULL));
+	TEST (NULL != (stream = fopen (dicname, "rb")));
+	if (stream) {
+		TEST_CBF_PASS (cbf_read_file (dic, stream, MSG_DIGEST));
+		TEST_CBF_PASS (cbf_convert_dictionary (text, dic));
+	}
+
+	  /* Write the image, and read it back as another dictionary */
+
+	TEST (NULL != (cache = tmpfile ()));
+	if (cache && !r.fail) {
+		TEST_CBF_PASS (cbf_write_dictionary_cache (text, cache));
+		TEST (!fflush (cache));
+		TEST_CBF_PASS (cbf_read_dictionary_cache (cached, cache));
+	}
+
+	  /* Both must judge the subject alike, and find fault with it */
+
+	if (!r.fail) {
+		TEST_CBF_PASS (validate (text, subject, &text_log));
+		TEST_CBF_PASS (validate (cached, subject, &cached_log));
+	}
+	if (text_log && cached_log) {
+		TEST (strlen (text_log) > 0);
+		TEST (!strcmp (text_log, cached_log));
+		if (strcmp (text_log, cached_log))
+			fprintf (stderr, "text dictionary:\n%s\nimage:\n%s\n",
+			         text_log, cached_log);
+	}
+
+	  /* Break the tree of the image in turn */
+
+	if (cache && !r.fail) {
+		TEST (!fseek (cache, 0, SEEK_END) && (size = ftell (cache)) > 0);
+		TEST (!fseek (cache, 0, SEEK_SET));
+		TEST (NULL != (image = malloc (size)));
+		if (image)
+			TEST ((size_t) size == fread (image, 1, size, cache));
+	}
+
+	if (image && !r.fail) {
+		unsigned int children = image_word (image, 2);
+
+		TEST (CBF_ROOT == image_word (image, 0));
+		TEST (CBF_DATABLOCK == image_word (image, 3));
+		TEST (CBF_CATEGORY == image_word (image, 6) ||
+		      CBF_SAVEFRAME == image_word (image, 6));
+
+		  /* Unchanged, the copy loads */
+
+		TEST_CBF_PASS (load_patched (image, size, 0, CBF_ROOT));
+
+		  /* A data block that is something else */
+
+		TEST (CBF_FORMAT == load_patched (image, size, 3, CBF_CATEGORY));
+		TEST (CBF_FORMAT == load_patched (image, size, 3, CBF_COLUMN));
+		TEST (CBF_FORMAT == load_patched (image, size, 3, CBF_ROOT));
+		TEST (CBF_FORMAT == load_patched (image, size, 3, CBF_VALUE));
+
+		  /* A category in the data block that is something else */
+
+		TEST (CBF_FORMAT == load_patched (image, size, 6, CBF_DATABLOCK));
+		TEST (CBF_FORMAT == load_patched (image, size, 6, CBF_COLUMN));
+		TEST (CBF_FORMAT == load_patched (image, size, 6, CBF_LINK));
+
+		  /* More data blocks than there are words for, or fewer */
+
+		TEST (CBF_FORMAT == load_patched (image, size, 2, children + 1));
+		TEST (CBF_FORMAT == load_patched (image, size, 2, 0xFFFFFFFFU));
+		if (children > 0)
+			TEST (CBF_FORMAT == load_patched (image, size, 2, children - 1));
+	}
+
+	free (image);
+	free (text_log);
+	free (cached_log);
+	if (cache) fclose (cache);
+	if (dic) TEST_CBF_PASS (cbf_free_handle (dic));
+	if (text) TEST_CBF_PASS (cbf_free_handle (text));
+	if (cached) TEST_CBF_PASS (cbf_free_handle (cached));
+	return r;
+}
+
+
+  /* Read and convert the dictionary dicname into a new handle */
+
+static int convert (cbf_handle *handle, const char *dicname)
+{
+	cbf_handle dic = NULL;
+	FILE *stream = fopen (dicname, "rb");
+	int error = CBF_SUCCESS;
+
+	*handle = NULL;
+	if (!stream) return CBF_FILEOPEN;
+	error = cbf_make_handle (&dic);
+	if (!error) error = cbf_set_cbf_logfile (dic, NULL);
+	if (!error) {
+		error = cbf_read_file (dic, stream, MSG_DIGEST);
+		stream = NULL;
+	}
+	if (!error) error = cbf_make_handle (handle);
+	if (!error) error = cbf_convert_dictionary (*handle, dic);
+
+	if (dic) error |= cbf_free_handle (dic);
+	if (stream) fclose (stream);
+	return error;
+}
+
+
+static testResult_t test_shared (const char *dicname)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle private = NULL, owner = NULL, other = NULL, dict = NULL;
+	char *private_log = NULL, *logs [THREADS];
+	int errors [THREADS], i;
+
+	memset (logs, 0, sizeof logs);
+	TEST_CBF_PASS (convert (&private, dicname));
+	TEST_CBF_PASS (convert (&owner, dicname));
+	if (r.fail) goto done;
+	TEST_CBF_PASS (validate (private, subject, &private_log));
+	TEST_CBF_PASS (cbf_get_dictionary (owner, &dict));
+	TEST_CBF_PASS (cbf_share_dictionary (dict));
+	TEST_CBF_PASS (cbf_share_dictionary (dict));
+	if (r.fail || !private_log) goto done;
+
+	  /* Each validation attaches a handle of its own to the dictionary */
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+	for (i = 0; i < THREADS; i++)
+		errors [i] = validate (owner, subject, logs + i);
+
+	for (i = 0; i < THREADS; i++) {
+		TEST_CBF_PASS (errors [i]);
+		TEST (logs [i] && !strcmp (logs [i], private_log));
+		if (logs [i] && strcmp (logs [i], private_log))
+			fprintf (stderr, "private dictionary:\n%s\nshared:\n%s\n",
+			         private_log, logs [i]);
+	}
+
+	  /* Nothing may add to it through a handle attached to it */
+
+	TEST_CBF_PASS (cbf_make_handle (&other));
+	TEST_CBF_PASS (cbf_set_dictionary (other, dict));
+	TEST (CBF_ARGUMENT == cbf_convert_dictionary (other, private));
+	TEST (CBF_ARGUMENT == cbf_set_category_root (other, "diffrn", "diffrn_root"));
+	TEST (CBF_ARGUMENT == cbf_set_tag_root (other, "_diffrn.id", "_diffrn.root_id"));
+	TEST (CBF_ARGUMENT == cbf_set_tag_category (other, "_diffrn.root_id", "diffrn"));
+
+	  /* The dictionary outlives the handle it was converted into */
+
+	TEST_CBF_PASS (cbf_free_handle (owner));
+	owner = NULL;
+	free (logs [0]);
+	logs [0] = NULL;
+	TEST_CBF_PASS (validate (other, subject, logs));
+	TEST (logs [0] && !strcmp (logs [0], private_log));
+
+done:
+	for (i = 0; i < THREADS; i++)
+		free (logs [i]);
+	free (private_log);
+	if (other) TEST_CBF_PASS (cbf_free_handle (other));
+	if (owner) TEST_CBF_PASS (cbf_free_handle (owner));
+	if (private) TEST_CBF_PASS (cbf_free_handle (private));
+	return r;
+}
+
+
+  /* A loop with a dimension out of range in every fourth row, a
+     precedence that is not a number in every fifth and a direction
+     that is not enumerated in every third */
+
+static void plan_subject (char *text)
+{
+	unsigned int i;
+
+	text += sprintf (text, "data_plans\nloop_\n"
+	                 "_array_structure_list.array_id\n"
+	                 "_array_structure_list.index\n"
+	                 "_array_structure_list.dimension\n"
+	                 "_array_structure_list.precedence\n"
+	                 "_array_structure_list.direction\n");
+	for (i = 0; i < PLAN_ROWS; i++) {
+		text += sprintf (text, "image_1 %u ", i + 1);
+		text += sprintf (text, i % 4 == 1 ? "0 " : "%u ", 100 + i);
+		text += sprintf (text, i % 5 == 2 ? "first " : "%u ", i + 1);
+		text += sprintf (text, "%s\n", i % 3 == 0 ? "sideways" :
+		                                i % 2 ? "increasing" : "decreasing");
+	}
+}
+
+
+  /* Read a dictionary from text and convert it into a new handle */
+
+static int convert_text (cbf_handle *handle, const char *text)
+{
+	cbf_handle dic = NULL;
+	FILE *stream = tmpfile ();
+	int error = CBF_SUCCESS;
+
+	*handle = NULL;
+	if (!stream || fputs (text, stream) == EOF || fseek (stream, 0, SEEK_SET)) {
+		if (stream) fclose (stream);
+		return CBF_FILEWRITE;
+	}
+	error = cbf_make_handle (&dic);
+	if (!error) {
+		error = cbf_read_file (dic, stream, MSG_DIGEST);
+		stream = NULL;
+	}
+	if (!error) error = cbf_make_handle (handle);
+	if (!error) error = cbf_convert_dictionary (*handle, dic);
+
+	if (dic) error |= cbf_free_handle (dic);
+	if (stream) fclose (stream);
+	return error;
+}
+
+
+static testResult_t test_plans (const char *dicname)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle img = NULL, mini = NULL, cif = NULL, dict = NULL;
+	char *text = malloc (PLAN_ROWS * 80 + 200), *img_log = NULL,
+	     *mini_log = NULL, *log = NULL;
+	int pass;
+
+	TEST (text != NULL);
+	if (!text) return r;
+	plan_subject (text);
+	TEST_CBF_PASS (convert (&img, dicname));
+	TEST_CBF_PASS (convert_text (&mini, mini_dictionary));
+	if (r.fail) goto done;
+
+	  /* A warning for each bad value */
+
+	TEST_CBF_PASS (validate (img, text, &img_log));
+	TEST (img_log && !strcmp (img_log, plan_log));
+	if (img_log && strcmp (img_log, plan_log))
+		fprintf (stderr, "%s", img_log);
+	TEST_CBF_PASS (validate (mini, text, &mini_log));
+	TEST (mini_log && strcmp (mini_log, img_log));
+
+	  /* One handle, read with each dictionary in turn */
+
+	TEST_CBF_PASS (cbf_make_handle (&cif));
+	for (pass = 0; pass < 4 && !r.fail; pass++) {
+		const char *expected = pass % 2 ? mini_log : img_log;
+
+		TEST_CBF_PASS (cbf_get_dictionary (pass % 2 ? mini : img, &dict));
+		TEST_CBF_PASS (cbf_set_dictionary (cif, dict));
+		TEST_CBF_PASS (read_validated (cif, text, &log));
+		TEST (log && expected && !strcmp (log, expected));
+		free (log);
+		log = NULL;
+	}
+
+done:
+	free (text);
+	free (img_log);
+	free (mini_log);
+	if (cif) TEST_CBF_PASS (cbf_free_handle (cif));
+	if (mini) TEST_CBF_PASS (cbf_free_handle (mini));
+	if (img) TEST_CBF_PASS (cbf_free_handle (img));
+	return r;
+}
+
+
+int main(int argc, char ** argv)
+{
+
+	testResult_t r = {0,0,0};
+
+	if (argc != 2) {
+		fprintf(stderr,"Usage: testdictcache cif_img_1.8.9.2.dic\n");
+		return 1;
+	}
+
+	TEST_COMPONENT(test_round_trip(argv[1]));
+	TEST_COMPONENT(test_shared(argv[1]));
+	TEST_COMPONENT(test_plans(argv[1]));
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for the whole-frame pixel geometry, polarization and    *
+ * reciprocal-space arrays, checked against the per-pixel calls.      *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cbf.h"
+#include "cbf_simple.h"
+#include "unittest.h"
+
+/*
+cbf_get_pixel_geometry, cbf_get_pixel_polarization,
+cbf_get_pixel_reciprocal, cbf_get_reciprocal_array and
+cbf_get_frame_reciprocal must agree with cbf_get_pixel_coordinates,
+cbf_get_pixel_normal, cbf_get_pixel_area and cbf_get_reciprocal pixel
+by pixel.  The whole-frame calls keep the position of pixel (0,0) and
+the steps to its neighbours in the detector, and find them again only
+when an axis setting they depend on has changed, so every check is
+repeated after moving and tilting the detector and after setting the
+beam centre.  The template is the Pilatus 6M of argv[1], of which the
+first ROWS rows, sampled every STEP-th pixel, and the whole of the
+first column are checked.  Pixels are found by stepping from pixel
+(0,0), so the positions drift from the per-pixel ones by up to about
+1e-10 mm across the frame, and the reciprocal-space vectors by a few
+parts in 1e13.
+*/
+
+#define FAST 2463
+#define SLOW 2527
+#define ROWS 40
+#define STEP 7
+#define WAVELENGTH 1.5418
+
+static const double degrees = 57.29577951308232;
+
+/* The index of the named axis of a positioner */
+
+static size_t axis_index(cbf_positioner positioner, const char * name)
+{
+	size_t i;
+
+	for (i = 0; i < positioner->axes; ++i)
+		if (!strcmp(positioner->axis[i].name,name))
+			return i;
+	return positioner->axes;
+}
+
+static double distance3(const double * a, const double * b)
+{
+	return fabs(a[0]-b[0])+fabs(a[1]-b[1])+fabs(a[2]-b[2]);
+}
+
+/* Every array of cbf_get_pixel_geometry and cbf_get_pixel_polarization
+   for the first dimslow rows of dimfast pixels against the per-pixel
+   calls, every step-th pixel along a row */
+
+static testResult_t check_geometry(cbf_detector detector, size_t dimfast, size_t dimslow,
+		size_t step)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	double * coordinates, * normals, * solid, * twotheta, * azimuth, * factors, * plain;
+	double position = 0., direction = 0., angle = 0., relative = 0., polar = 0.;
+	size_t slow, fast, pixels = dimfast*dimslow;
+
+	coordinates = (double *) malloc(3*pixels*sizeof(double));
+	normals = (double *) malloc(3*pixels*sizeof(double));
+	solid = (double *) malloc(pixels*sizeof(double));
+	twotheta = (double *) malloc(pixels*sizeof(double));
+	azimuth = (double *) malloc(pixels*sizeof(double));
+	factors = (double *) malloc(pixels*sizeof(double));
+	plain = (double *) malloc(3*pixels*sizeof(double));
+
+	TEST_CBF_PASS(cbf_get_pixel_geometry(detector,dimfast,dimslow,coordinates,normals,solid,
+			twotheta,azimuth));
+	TEST_CBF_PASS(cbf_get_pixel_polarization(detector,dimfast,dimslow,0.8,30.,factors));
+
+	/* Any of the arrays may be left out */
+	TEST_CBF_PASS(cbf_get_pixel_geometry(detector,dimfast,dimslow,plain,NULL,NULL,NULL,NULL));
+	TEST(!error && !memcmp(plain,coordinates,3*pixels*sizeof(double)));
+
+	for (slow = 0; !error && slow < dimslow; ++slow)
+		for (fast = slow%step; fast < dimfast; fast += step) {
+			size_t index = slow*dimfast+fast;
+			double pixel[3], normal[3], area, r2, rr, d1, d2, norm;
+
+			TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(detector,fast,slow,
+					pixel,pixel+1,pixel+2));
+			TEST_CBF_PASS(cbf_get_pixel_normal_fs(detector,fast,slow,
+					normal,normal+1,normal+2));
+			TEST_CBF_PASS(cbf_get_pixel_area_fs(detector,fast,slow,&area,NULL));
+			if (error) break;
+			position = fmax(position,distance3(pixel,coordinates+3*index));
+			direction = fmax(direction,distance3(normal,normals+3*index));
+
+			r2 = pixel[0]*pixel[0]+pixel[1]*pixel[1]+pixel[2]*pixel[2];
+			rr = sqrt(r2);
+			relative = fmax(relative,fabs(solid[index]/(area*fabs(pixel[0]*normal[0]
+					+pixel[1]*normal[1]+pixel[2]*normal[2])/(r2*rr))-1.));
+			angle = fmax(angle,fabs(twotheta[index]
+					-acos(-pixel[2]/rr)*degrees));
+			angle = fmax(angle,fabs(azimuth[index]
+					-atan2(pixel[1],pixel[0])*degrees));
+
+			/* 0.9 of the beam polarized 30 degrees from X towards Y */
+			norm = 30./degrees;
+			d1 = (pixel[0]*cos(norm)+pixel[1]*sin(norm))/rr;
+			d2 = (pixel[1]*cos(norm)-pixel[0]*sin(norm))/rr;
+			polar = fmax(polar,fabs(factors[index]-(0.9*(1.-d1*d1)+0.1*(1.-d2*d2))));
+		}
+
+	TEST(position < 2.e-10);
+	TEST(direction < 1.e-12);
+	TEST(relative < 1.e-11);
+	TEST(angle < 1.e-10);
+	TEST(polar < 1.e-12);
+
+	free(coordinates); free(normals); free(solid); free(twotheta); free(azimuth);
+	free(factors); free(plain);
+	return r;
+}
+
+/* The reciprocal-space vectors of every pixel against cbf_get_reciprocal
+   at two goniometer settings */
+
+static testResult_t check_reciprocal(cbf_goniometer goniometer, cbf_detector detector,
+		size_t dimfast, size_t dimslow, size_t step)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	double * lab, * frame, * rotated, difference = 0.;
+	static const double ratios[] = {0., 3.};
+	size_t k, slow, fast, pixels = dimfast*dimslow;
+
+	lab = (double *) malloc(3*pixels*sizeof(double));
+	frame = (double *) malloc(3*pixels*sizeof(double));
+	rotated = (double *) malloc(3*pixels*sizeof(double));
+
+	TEST_CBF_PASS(cbf_get_pixel_reciprocal(detector,WAVELENGTH,dimfast,dimslow,lab));
+	for (k = 0; !error && k < 2; ++k) {
+		TEST_CBF_PASS(cbf_get_frame_reciprocal(goniometer,detector,ratios[k],WAVELENGTH,
+				dimfast,dimslow,frame));
+		TEST_CBF_PASS(cbf_get_reciprocal_array(goniometer,0,ratios[k],pixels,lab,rotated));
+		TEST(!error && !memcmp(frame,rotated,3*pixels*sizeof(double)));
+		for (slow = 0; !error && slow < dimslow; ++slow)
+			for (fast = slow%step; fast < dimfast; fast += step) {
+				double pixel[3], vector[3];
+
+				TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(detector,fast,slow,
+						pixel,pixel+1,pixel+2));
+				TEST_CBF_PASS(cbf_get_reciprocal(goniometer,0,ratios[k],WAVELENGTH,
+						pixel[0],pixel[1],pixel[2],vector,vector+1,vector+2));
+				if (error) break;
+				difference = fmax(difference,distance3(vector,frame+3*(slow*dimfast+fast)));
+			}
+	}
+	TEST(difference < 1.e-12);
+
+	/* The array may be rotated in place */
+	TEST_CBF_PASS(cbf_get_reciprocal_array(goniometer,0,ratios[1],pixels,lab,lab));
+	TEST(!error && !memcmp(lab,rotated,3*pixels*sizeof(double)));
+
+	free(lab); free(frame); free(rotated);
+	return r;
+}
+
+/* The first rows and the first column of the element */
+
+static testResult_t check_element(cbf_goniometer goniometer, cbf_detector detector)
+{
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(check_geometry(detector,FAST,ROWS,STEP));
+	TEST_COMPONENT(check_geometry(detector,1,SLOW,1));
+	TEST_COMPONENT(check_reciprocal(goniometer,detector,FAST,ROWS,STEP));
+	TEST_COMPONENT(check_reciprocal(goniometer,detector,1,SLOW,1));
+	return r;
+}
+
+static testResult_t check_template(const char * name)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	cbf_detector detector = NULL;
+	cbf_goniometer goniometer = NULL;
+	cbf_positioner positioner;
+	double before[3], after[3], index1, index2;
+	size_t z, y, pitch, omega, kappa;
+	FILE * file;
+
+	if (!(file = fopen(name,"rb"))) {
+		fprintf(stderr,"testgeometry: cannot open %s\n",name);
+		++r.fail;
+		return r;
+	}
+	TEST_CBF_PASS(cbf_make_handle(&h));
+	TEST_CBF_PASS(cbf_read_widefile(h,file,MSG_DIGEST));
+	TEST_CBF_PASS(cbf_construct_detector(h,&detector,0));
+	TEST_CBF_PASS(cbf_construct_goniometer(h,&goniometer));
+	if (error) {
+		if (detector) cbf_free_detector(detector);
+		if (goniometer) cbf_free_goniometer(goniometer);
+		if (h) cbf_free_handle(h);
+		return r;
+	}
+
+	/* A detector 120 mm from the sample, and a goniometer that turns
+	   through a scan */
+	positioner = detector->positioner;
+	z = axis_index(positioner,"DETECTOR_Z");
+	y = axis_index(positioner,"DETECTOR_Y");
+	pitch = axis_index(positioner,"DETECTOR_PITCH");
+	omega = axis_index(goniometer,"GONIOMETER_OMEGA");
+	kappa = axis_index(goniometer,"GONIOMETER_KAPPA");
+	TEST(z < positioner->axes && y < positioner->axes && pitch < positioner->axes);
+	TEST(omega < goniometer->axes && kappa < goniometer->axes);
+	if (error || r.fail) {
+		cbf_free_detector(detector);
+		cbf_free_goniometer(goniometer);
+		cbf_free_handle(h);
+		return r;
+	}
+	positioner->axis[z].start = 120.;
+	goniometer->axis[omega].start = 10.;
+	goniometer->axis[omega].increment = 0.5;
+	goniometer->axis[kappa].start = 25.;
+	goniometer->matrix_is_valid = 0;
+
+	TEST_COMPONENT(check_element(goniometer,detector));
+
+	/* Move the detector back and up and tilt it; the frame found above
+	   no longer holds */
+	TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(detector,100.,10.,before,before+1,before+2));
+	positioner->axis[z].start = 250.;
+	positioner->axis[y].start = 30.;
+	positioner->axis[pitch].start = 15.;
+	positioner->matrix_is_valid = 0;
+	TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(detector,100.,10.,after,after+1,after+2));
+	TEST(distance3(before,after) > 100.);
+	TEST_COMPONENT(check_element(goniometer,detector));
+
+	/* A new beam centre moves the element along its own axes */
+	index1 = 1200.;
+	index2 = 1300.;
+	TEST_CBF_PASS(cbf_set_beam_center_fs(detector,&index1,&index2,NULL,NULL));
+	TEST_COMPONENT(check_element(goniometer,detector));
+
+	cbf_free_detector(detector);
+	cbf_free_goniometer(goniometer);
+	cbf_free_handle(h);
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+	testResult_t r = {0,0,0};
+
+	if (argc != 2) {
+		fprintf(stderr,"Usage: testgeometry template_pilatus6m_2463x2527.cbf\n");
+		return 1;
+	}
+
+	TEST_COMPONENT(check_template(argv[1]));
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
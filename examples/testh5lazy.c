@@ -0,0 +1,584 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for lazy reads of HDF5 image stacks and for per-frame   *
+ * conversion of NeXus files, against full reads and conversions.     *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "cbf_hdf5.h"
+#include "unittest.h"
+
+/*
+A lazy read leaves image stacks null until they are asked for, and
+cbf_select_h5frame converts the metadata of a NeXus file once and only
+refreshes the image and per-frame values for later frames.  Both must
+give the same tree as a full read or a full conversion of each frame.
+
+Image stacks spread over several files, through a virtual dataset or
+the 'data_NNNNNN' links of an Eiger master, are read through a map of
+frames to files that opens each data file on first use.
+*/
+
+static const char stackfile[] = "testh5lazy_stack.h5";
+
+/* Write a plain HDF5 file holding a stack of 3 frames of 10x12 pixels */
+
+static int make_stack( void )
+{
+	hsize_t dims[3] = {3,10,12};
+	int data[360];
+	hid_t file, space, dataset;
+	int i, error = CBF_SUCCESS;
+
+	for (i = 0; i < 360; ++i) data[i] = 7*i-100;
+
+	file = H5Fcreate(stackfile,H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
+	if (file < 0) return CBF_H5ERROR;
+	space = H5Screate_simple(3,dims,NULL);
+	dataset = H5Dcreate2(file,"data",H5T_NATIVE_INT,space,
+			H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+	if (space < 0 || dataset < 0
+		|| H5Dwrite(dataset,H5T_NATIVE_INT,H5S_ALL,H5S_ALL,H5P_DEFAULT,data) < 0)
+		error = CBF_H5ERROR;
+	if (dataset >= 0) H5Dclose(dataset);
+	if (space >= 0) H5Sclose(space);
+	H5Fclose(file);
+	return error;
+}
+
+/* Write frames of slow x fast pixels to /entry/data/data in a new file */
+
+static int write_frames(const char * filename, hid_t type, const void * data,
+		hsize_t frames, hsize_t slow, hsize_t fast)
+{
+	hsize_t dims[3];
+	hid_t file, entry = -1, group = -1, space = -1, dataset = -1;
+	int error = CBF_SUCCESS;
+
+	dims[0] = frames;
+	dims[1] = slow;
+	dims[2] = fast;
+	file = H5Fcreate(filename,H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
+	if (file < 0) return CBF_H5ERROR;
+	if ((entry = H5Gcreate2(file,"entry",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)) < 0
+		|| (group = H5Gcreate2(entry,"data",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)) < 0
+		|| (space = H5Screate_simple(3,dims,NULL)) < 0
+		|| (dataset = H5Dcreate2(group,"data",type,space,
+				H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)) < 0
+		|| H5Dwrite(dataset,type,H5S_ALL,H5S_ALL,H5P_DEFAULT,data) < 0)
+		error = CBF_H5ERROR;
+	if (dataset >= 0) H5Dclose(dataset);
+	if (space >= 0) H5Sclose(space);
+	if (group >= 0) H5Gclose(group);
+	if (entry >= 0) H5Gclose(entry);
+	H5Fclose(file);
+	return error;
+}
+
+/* Write a handle as CIF text to a buffer the caller frees */
+
+static int cif_text(cbf_handle h, char ** text, size_t * length)
+{
+	FILE * stream = tmpfile();
+	long size;
+	int error;
+
+	*text = NULL;
+	if (!stream) return CBF_FILEOPEN;
+	error = cbf_write_file(h,stream,0,CIF,MIME_HEADERS|MSG_NODIGEST,0);
+	if (!error && ((size = ftell(stream)) < 0 || fseek(stream,0,SEEK_SET)))
+		error = CBF_FILEREAD;
+	if (!error && !(*text = malloc(size+1))) error = CBF_ALLOC;
+	if (!error && fread(*text,1,size,stream) != (size_t)size) error = CBF_FILEREAD;
+	fclose(stream);
+	if (error) {
+		free(*text);
+		*text = NULL;
+		return error;
+	}
+	*length = size;
+	return CBF_SUCCESS;
+}
+
+/* Find the value of the stack in the H5_Datasets category */
+
+static int find_stack(cbf_handle h)
+{
+	cbf_failnez(cbf_find_category(h,"H5_Datasets"));
+	cbf_failnez(cbf_find_column(h,"id"));
+	cbf_failnez(cbf_find_row(h,"data"));
+	return cbf_find_column(h,"value");
+}
+
+testResult_t test_lazy_stack(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_h5handle nx = NULL;
+	cbf_handle full = NULL, lazy = NULL;
+	const char * type = NULL;
+	int full_data[360], lazy_data[360];
+	int id;
+	size_t read = 0;
+	char * text = NULL;
+	size_t length = 0;
+
+	TEST_CBF_PASS(make_stack());
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,stackfile));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_make_handle(&full));
+	TEST_CBF_PASS(cbf_make_handle(&lazy));
+	TEST_CBF_PASS(cbf_read_h5file(full,nx,0));
+	TEST_CBF_PASS(cbf_read_h5file(lazy,nx,CBF_H5_LAZY));
+	if (error) return r;
+
+	/* The lazy read leaves the stack null and reads it when asked */
+	TEST_CBF_PASS(find_stack(lazy));
+	TEST_CBF_PASS(cbf_get_typeofvalue(lazy,&type));
+	TEST(type && !strcmp(type,"null"));
+	memset(lazy_data,0,sizeof(lazy_data));
+	TEST_CBF_PASS(cbf_get_integerarray(lazy,&id,lazy_data,sizeof(int),1,360,&read));
+	TEST(360==read);
+	TEST_CBF_PASS(find_stack(full));
+	memset(full_data,0xff,sizeof(full_data));
+	TEST_CBF_PASS(cbf_get_integerarray(full,&id,full_data,sizeof(int),1,360,&read));
+	TEST(!memcmp(lazy_data,full_data,sizeof(full_data)));
+	TEST(-100==lazy_data[0] && 2413==lazy_data[359]);
+
+	/* Writing a lazy read reads every stack first */
+	TEST_CBF_PASS(cbf_free_handle(lazy));
+	TEST_CBF_PASS(cbf_make_handle(&lazy));
+	TEST_CBF_PASS(cbf_read_h5file(lazy,nx,CBF_H5_LAZY));
+	TEST_CBF_PASS(cif_text(lazy,&text,&length));
+	TEST(text && length && strstr(text,"_H5_Datasets.value"));
+	free(text);
+	TEST_CBF_PASS(find_stack(lazy));
+	TEST_CBF_PASS(cbf_get_typeofvalue(lazy,&type));
+	TEST(type && !strcmp(type,"bnry"));
+
+	/* A lazy read whose HDF5 handle is gone no longer resolves */
+	TEST_CBF_PASS(cbf_free_handle(lazy));
+	TEST_CBF_PASS(cbf_make_handle(&lazy));
+	TEST_CBF_PASS(cbf_read_h5file(lazy,nx,CBF_H5_LAZY));
+	TEST(lazy->deferred != NULL);
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+	TEST(NULL==lazy->deferred);
+
+	TEST_CBF_PASS(cbf_free_handle(lazy));
+	TEST_CBF_PASS(cbf_free_handle(full));
+	return r;
+}
+
+static const char part_a[] = "testh5lazy_part_a.h5";
+static const char part_b[] = "testh5lazy_part_b.h5";
+static const char wholefile[] = "testh5lazy_whole.h5";
+static const char tiledfile[] = "testh5lazy_tiled.h5";
+
+/* Write a virtual dataset of 4 frames of 10x12 pixels, the first two
+   from part_a and the others from part_b, or a tiled one of 2 frames
+   whose left halves come from part_a and right halves from part_b */
+
+static int make_vds(const char * filename, int tiled)
+{
+	hsize_t vdims[3] = {4,10,12}, sdims[3] = {2,10,12};
+	hsize_t start[3] = {0,0,0}, srcstart[3] = {0,0,0}, count[3] = {2,10,12};
+	hid_t file, entry = -1, group = -1, vspace = -1, sspace = -1;
+	hid_t dcpl = -1, dataset = -1;
+	int error = CBF_SUCCESS;
+
+	if (tiled) {
+		vdims[0] = 2;
+		count[2] = 6;
+	}
+	file = H5Fcreate(filename,H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
+	if (file < 0) return CBF_H5ERROR;
+	if ((entry = H5Gcreate2(file,"entry",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)) < 0
+		|| (group = H5Gcreate2(entry,"data",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)) < 0
+		|| (vspace = H5Screate_simple(3,vdims,NULL)) < 0
+		|| (sspace = H5Screate_simple(3,sdims,NULL)) < 0
+		|| (dcpl = H5Pcreate(H5P_DATASET_CREATE)) < 0
+		|| H5Sselect_hyperslab(vspace,H5S_SELECT_SET,start,NULL,count,NULL) < 0
+		|| H5Sselect_hyperslab(sspace,H5S_SELECT_SET,srcstart,NULL,count,NULL) < 0
+		|| H5Pset_virtual(dcpl,vspace,part_a,"/entry/data/data",sspace) < 0)
+		error = CBF_H5ERROR;
+	if (tiled) {
+		start[2] = srcstart[2] = 6;
+	} else {
+		start[0] = 2;
+	}
+	if (CBF_SUCCESS==error
+		&& (H5Sselect_hyperslab(vspace,H5S_SELECT_SET,start,NULL,count,NULL) < 0
+		|| H5Sselect_hyperslab(sspace,H5S_SELECT_SET,srcstart,NULL,count,NULL) < 0
+		|| H5Pset_virtual(dcpl,vspace,part_b,"/entry/data/data",sspace) < 0
+		|| H5Sselect_all(vspace) < 0
+		|| (dataset = H5Dcreate2(group,"data",H5T_NATIVE_INT,vspace,
+				H5P_DEFAULT,dcpl,H5P_DEFAULT)) < 0))
+		error = CBF_H5ERROR;
+	if (dataset >= 0) H5Dclose(dataset);
+	if (dcpl >= 0) H5Pclose(dcpl);
+	if (sspace >= 0) H5Sclose(sspace);
+	if (vspace >= 0) H5Sclose(vspace);
+	if (group >= 0) H5Gclose(group);
+	if (entry >= 0) H5Gclose(entry);
+	H5Fclose(file);
+	return error;
+}
+
+testResult_t test_vds_map(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_h5handle nx = NULL;
+	unsigned int frames = 0;
+	size_t slow = 0, fast = 0;
+	int a[240], b[240], data[480];
+	int i, f, y, x, wrong;
+
+	for (i = 0; i < 240; ++i) {
+		a[i] = i;
+		b[i] = 1000+i;
+	}
+	TEST_CBF_PASS(write_frames(part_a,H5T_NATIVE_INT,a,2,10,12));
+	TEST_CBF_PASS(write_frames(part_b,H5T_NATIVE_INT,b,2,10,12));
+	TEST_CBF_PASS(make_vds(wholefile,0));
+	TEST_CBF_PASS(make_vds(tiledfile,1));
+	if (error) return r;
+
+	/* Whole frames are read straight from the files holding them */
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,wholefile));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_get_h5image_size(nx,&frames,&slow,&fast));
+	TEST(4==frames && 10==slow && 12==fast);
+	TEST(2==nx->num_framesrcs);
+	memset(data,0,sizeof(data));
+	TEST_CBF_PASS(cbf_get_3d_h5image(nx,1,data,sizeof(int),1,2,10,12));
+	TEST(!memcmp(data,a+120,120*sizeof(int)) && !memcmp(data+120,b,120*sizeof(int)));
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+
+	/* A frame tiled from several sources is left to HDF5 */
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,tiledfile));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_get_h5image_size(nx,&frames,&slow,&fast));
+	TEST(2==frames && 10==slow && 12==fast);
+	TEST(1==nx->num_framesrcs);
+	memset(data,0,sizeof(data));
+	TEST_CBF_PASS(cbf_get_3d_h5image(nx,0,data,sizeof(int),1,2,10,12));
+	for (wrong = f = 0; f < 2; ++f)
+		for (y = 0; y < 10; ++y)
+			for (x = 0; x < 12; ++x) {
+				const int k = (f*10+y)*12+x;
+				if (data[k] != (x < 6 ? a[k] : b[k])) ++wrong;
+			}
+	TEST(!wrong);
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+	return r;
+}
+
+#ifdef CBF_USE_ULP
+
+static const char nexusfile[] = "testh5lazy_nexus.h5";
+
+static const char header[] =
+"\n# Detector: PILATUS 6M, S/N 60-0100\n# 2011-06-28T11:42:3%d.000\n"
+"# Pixel_size 172e-6 m x 172e-6 m\n"
+"# Silicon sensor, thickness 0.000320 m\n# Exposure_time %g s\n"
+"# Exposure_period 0.2 s\n# Tau = 383.8e-09 s\n"
+"# Count_cutoff 1048500 counts\n# Threshold_setting: 6330 eV\n"
+"# Wavelength 0.9795 A\n# Detector_distance %g m\n"
+"# Beam_xy (1231.50, 1263.50) pixels\n# Start_angle %g deg.\n"
+"# Angle_increment 0.1000 deg.\n# Omega %g deg.\n# Polarization 0.990\n";
+
+#define FRAMES 4
+
+/* Convert a series of miniCBF frames, whose angles, distance and
+   exposure time change from frame to frame, to a NeXus file.  Later
+   frames are only checked against the first to within a few ULP. */
+
+static int make_nexus(const char * filename)
+{
+	cbf_handle h = NULL;
+	cbf_h5handle nx = NULL;
+	cbf_config_t * config = NULL;
+	FILE * stream = NULL;
+	char name[20], contents[sizeof(header)+64];
+	int data[12];
+	int f, i, error = CBF_SUCCESS;
+
+	cbf_failnez(cbf_make_handle(&h));
+	for (f = 0; f < FRAMES && !error; ++f) {
+		sprintf(name,"image_%d",f);
+		sprintf(contents,header,f+1,f==2?0.25:0.5,0.125*(f+1),0.5*f,0.5*f);
+		for (i = 0; i < 12; ++i) data[i] = 100*f+i;
+		error |= cbf_force_new_datablock(h,name);
+		error |= cbf_new_category(h,"array_data");
+		error |= cbf_new_column(h,"header_convention");
+		error |= cbf_set_value(h,"PILATUS_1.2");
+		error |= cbf_new_column(h,"header_contents");
+		error |= cbf_set_value(h,contents);
+		error |= cbf_new_column(h,"data");
+		error |= cbf_set_integerarray_wdims_fs(h,CBF_BYTE_OFFSET,1,data,
+				sizeof(int),1,12,"little_endian",4,3,1,0);
+	}
+
+	config = cbf_config_create();
+	stream = tmpfile();
+	if (!error && (!config || !stream)) error = CBF_ALLOC;
+	if (!error) {
+		fputs("map Omega to omega\n"
+			"map Start_angle to start\n"
+			"omega depends-on . vector [1 0 0]\n"
+			"start depends-on omega vector [1 0 0]\n"
+			"Sample depends-on omega\n",stream);
+		rewind(stream);
+		error |= cbf_config_parse(stream,stderr,config);
+	}
+	if (!error) error |= cbf_create_h5handle2(&nx,filename);
+	if (!error) {
+		nx->float_ulp = nx->double_ulp = 4;
+		error |= cbf_write_minicbf_h5file(h,nx,config);
+	}
+
+	if (nx) error |= cbf_free_h5handle(nx);
+	if (stream) fclose(stream);
+	if (config) cbf_config_free(config);
+	error |= cbf_free_handle(h);
+	return error;
+}
+
+testResult_t test_frame_refresh(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_h5handle nx = NULL, fresh_nx = NULL;
+	cbf_handle h = NULL, fresh = NULL;
+	unsigned int frames = 0, frame, pass;
+	size_t slow = 0, fast = 0;
+	char * text = NULL, * fresh_text = NULL;
+	size_t length = 0, fresh_length = 0;
+
+	TEST_CBF_PASS(make_nexus(nexusfile));
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,nexusfile));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_get_h5image_size(nx,&frames,&slow,&fast));
+	TEST(FRAMES==frames && 3==slow && 4==fast);
+	TEST_CBF_PASS(cbf_make_handle(&h));
+	if (error) return r;
+
+	/* Frames selected in turn on one handle, then out of order, match
+	   a full conversion of each frame */
+	for (pass = 0; pass < 2; ++pass) {
+		for (frame = 0; frame < frames; ++frame) {
+			unsigned int f = pass ? frames-1-frame : frame;
+			TEST_CBF_PASS(cbf_select_h5frame(nx,h,f));
+			TEST_CBF_PASS(cif_text(h,&text,&length));
+			TEST_CBF_PASS(cbf_open_h5handle(&fresh_nx,nexusfile));
+			TEST_CBF_PASS(cbf_make_handle(&fresh));
+			TEST_CBF_PASS(cbf_select_h5frame(fresh_nx,fresh,f));
+			TEST_CBF_PASS(cif_text(fresh,&fresh_text,&fresh_length));
+			TEST(text && fresh_text && length==fresh_length
+				&& !memcmp(text,fresh_text,length));
+			free(text);
+			free(fresh_text);
+			text = fresh_text = NULL;
+			TEST_CBF_PASS(cbf_free_handle(fresh));
+			TEST_CBF_PASS(cbf_free_h5handle(fresh_nx));
+			if (error) return r;
+		}
+	}
+
+	/* Freeing the handle forgets the converted frame */
+	TEST(h==nx->nxframe_cbf);
+	TEST_CBF_PASS(cbf_free_handle(h));
+	TEST(NULL==nx->nxframe_cbf);
+	TEST_CBF_PASS(cbf_make_handle(&h));
+	TEST_CBF_PASS(cbf_select_h5frame(nx,h,1));
+	TEST(h==nx->nxframe_cbf);
+
+	/* Freeing the HDF5 handle detaches the handle it converted into */
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+	TEST(NULL==h->deferred);
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+static const char eigerfile[] = "testh5lazy_eiger.h5";
+static const char * const eigerdata[FRAMES] = {
+	"testh5lazy_data_1.h5",
+	"testh5lazy_data_2.h5",
+	"testh5lazy_data_3.h5",
+	"testh5lazy_data_4.h5"
+};
+
+/* Move each frame of the image stack of a NeXus file to a data file of
+   its own, reached through a 'data_NNNNNN' link as in an Eiger master */
+
+static int split_nexus(const char * filename)
+{
+	hid_t file, dataset = -1, type = -1, group = -1;
+	char * data = NULL;
+	char name[16];
+	size_t size = 0;
+	int f, error = CBF_SUCCESS;
+
+	file = H5Fopen(filename,H5F_ACC_RDWR,H5P_DEFAULT);
+	if (file < 0) return CBF_H5ERROR;
+	if ((dataset = H5Dopen2(file,"/entry/data/data",H5P_DEFAULT)) < 0
+		|| (type = H5Dget_type(dataset)) < 0
+		|| !(size = H5Tget_size(type)*3*4)
+		|| !(data = (char *)malloc(FRAMES*size))
+		|| H5Dread(dataset,type,H5S_ALL,H5S_ALL,H5P_DEFAULT,data) < 0)
+		error = CBF_H5ERROR;
+	for (f = 0; CBF_SUCCESS==error && f < FRAMES; ++f)
+		error |= write_frames(eigerdata[f],type,data+f*size,1,3,4);
+	if (dataset >= 0) H5Dclose(dataset);
+	if (CBF_SUCCESS==error
+		&& (H5Ldelete(file,"/entry/data/data",H5P_DEFAULT) < 0
+		|| H5Ldelete(file,"/entry/instrument/detector/data",H5P_DEFAULT) < 0
+		|| (group = H5Gopen2(file,"/entry/data",H5P_DEFAULT)) < 0))
+		error = CBF_H5ERROR;
+	for (f = 0; CBF_SUCCESS==error && f < FRAMES; ++f) {
+		sprintf(name,"data_%06d",f+1);
+		if (H5Lcreate_external(eigerdata[f],"/entry/data/data",group,name,
+				H5P_DEFAULT,H5P_DEFAULT) < 0)
+			error = CBF_H5ERROR;
+	}
+	if (group >= 0) H5Gclose(group);
+	if (type >= 0) H5Tclose(type);
+	free(data);
+	H5Fclose(file);
+	return error;
+}
+
+testResult_t test_eiger_master(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_h5handle nx = NULL;
+	cbf_handle h = NULL;
+	unsigned int frames = 0, frame, open_files;
+	size_t slow = 0, fast = 0;
+	char * reference[FRAMES] = {NULL};
+	size_t reference_length[FRAMES];
+	char * text = NULL;
+	size_t length = 0;
+	int data[24];
+
+	/* Convert each frame of the file before its stack is split */
+	TEST_CBF_PASS(make_nexus(eigerfile));
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,eigerfile));
+	TEST_CBF_PASS(cbf_make_handle(&h));
+	if (error) return r;
+	for (frame = 0; frame < FRAMES; ++frame) {
+		TEST_CBF_PASS(cbf_select_h5frame(nx,h,frame));
+		TEST_CBF_PASS(cif_text(h,reference+frame,reference_length+frame));
+	}
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+	TEST_CBF_PASS(split_nexus(eigerfile));
+	if (error) return r;
+
+	/* Mapping the frames opens only the first and last data files */
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,eigerfile));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_h5handle_set_max_open_files(nx,2));
+	TEST_CBF_PASS(cbf_get_h5image_size(nx,&frames,&slow,&fast));
+	TEST(FRAMES==frames && 3==slow && 4==fast);
+	TEST(FRAMES==nx->num_framesrcs);
+	TEST(nx->framesrcs[0].file >= 0 && nx->framesrcs[FRAMES-1].file >= 0);
+	TEST(nx->framesrcs[1].file < 0 && nx->framesrcs[2].file < 0);
+
+	/* Each frame converts from the data file holding it as it did
+	   from the unsplit stack, with no more data files open than allowed */
+	for (frame = 0; frame < FRAMES; ++frame) {
+		TEST_CBF_PASS(cbf_select_h5frame(nx,h,frame));
+		TEST_CBF_PASS(cif_text(h,&text,&length));
+		TEST(text && reference[frame] && length==reference_length[frame]
+			&& !memcmp(text,reference[frame],length));
+		TEST(nx->num_open_files <= 2);
+		free(text);
+		text = NULL;
+	}
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+
+	/* A data file that does not hold the frames mapped to it is closed
+	   again, leaving the other frames readable */
+	memset(data,0,sizeof(data));
+	TEST_CBF_PASS(write_frames(eigerdata[2],H5T_NATIVE_INT,data,2,3,4));
+	TEST_CBF_PASS(cbf_open_h5handle(&nx,eigerfile));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_get_h5image_size(nx,&frames,&slow,&fast));
+	TEST(FRAMES==frames);
+	open_files = nx->num_open_files;
+	TEST(CBF_FORMAT==cbf_get_h5image(nx,2,data,sizeof(int),1,3,4));
+	TEST(nx->framesrcs[2].file < 0 && open_files==nx->num_open_files);
+	TEST_CBF_PASS(cbf_get_h5image(nx,1,data,sizeof(int),1,3,4));
+	TEST_CBF_PASS(cbf_free_h5handle(nx));
+
+	for (frame = 0; frame < FRAMES; ++frame) free(reference[frame]);
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+#endif
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(test_lazy_stack());
+	TEST_COMPONENT(test_vds_map());
+#ifdef CBF_USE_ULP
+	TEST_COMPONENT(test_frame_refresh());
+	TEST_COMPONENT(test_eiger_master());
+#endif
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for lazy reads of multi-block files, to ensure that     *
+ * searches see the same tree as a full read.                         *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "cbf.h"
+#include "unittest.h"
+
+/*
+A file read with CBF_PARSE_LAZY should answer every search as the same
+file read in full.  Data blocks are only built when they are reached, so
+searches across data blocks must build them on the way.
+*/
+
+/* Write a file of three data blocks to a temporary stream */
+
+static FILE * make_blocks( void )
+{
+	cbf_handle h = NULL;
+	FILE * stream = tmpfile();
+	int error = CBF_SUCCESS;
+
+	if (!stream) return NULL;
+
+	error |= cbf_make_handle(&h);
+	error |= cbf_new_datablock(h,"first");
+	error |= cbf_new_category(h,"x");
+	error |= cbf_new_column(h,"a");
+	error |= cbf_set_value(h,"1");
+	error |= cbf_new_datablock(h,"second");
+	error |= cbf_new_category(h,"y");
+	error |= cbf_new_column(h,"a");
+	error |= cbf_set_value(h,"2");
+	error |= cbf_new_datablock(h,"third");
+	error |= cbf_new_category(h,"z");
+	error |= cbf_new_column(h,"a");
+	error |= cbf_set_value(h,"3");
+	error |= cbf_write_file(h,stream,0,CIF,MIME_HEADERS,0);
+	error |= cbf_free_handle(h);
+
+	if (error) {
+		fclose(stream);
+		return NULL;
+	}
+
+	rewind(stream);
+	return stream;
+}
+
+/* Read the file of make_blocks, in full or lazily */
+
+static int read_blocks(cbf_handle * h, int flags)
+{
+	FILE * stream = make_blocks();
+
+	if (!stream) return CBF_FILEOPEN;
+
+	cbf_failnez(cbf_make_handle(h));
+	return cbf_read_file(*h,stream,MSG_NODIGEST|flags);
+}
+
+testResult_t test_find_tag(int flags)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	const char * value = NULL;
+	const char * name = NULL;
+	unsigned int blocks = 0;
+
+	TEST_CBF_PASS(read_blocks(&h,flags));
+	if (error) return r;
+
+	TEST_CBF_PASS(cbf_count_datablocks(h,&blocks));
+	TEST(3==blocks);
+
+	/* A tag in a later data block, with and without the leading '_' */
+	TEST_CBF_PASS(cbf_find_tag(h,"_y.a"));
+	TEST_CBF_PASS(cbf_get_value(h,&value));
+	TEST(value && !strcmp(value,"2"));
+	TEST_CBF_PASS(cbf_find_tag(h,"z.a"));
+	TEST_CBF_PASS(cbf_get_value(h,&value));
+	TEST(value && !strcmp(value,"3"));
+	TEST_CBF_PASS(cbf_datablock_name(h,&name));
+	TEST(name && !strcmp(name,"third"));
+
+	/* The blocks built by the search are complete */
+	TEST_CBF_PASS(cbf_find_datablock(h,"second"));
+	TEST_CBF_PASS(cbf_find_category(h,"y"));
+	TEST_CBF_PASS(cbf_find_column(h,"a"));
+	TEST_CBF_PASS(cbf_get_value(h,&value));
+	TEST(value && !strcmp(value,"2"));
+
+	/* A tag in the first data block, and one in none */
+	TEST_CBF_PASS(cbf_find_tag(h,"_x.a"));
+	TEST_CBF_PASS(cbf_get_value(h,&value));
+	TEST(value && !strcmp(value,"1"));
+	TEST_CBF_NOTFOUND(cbf_find_tag(h,"_w.a"));
+
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+testResult_t test_srch_tag_each_block(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	const char * value = NULL;
+
+	/* A search that fails first must still build every data block */
+	TEST_CBF_PASS(read_blocks(&h,CBF_PARSE_LAZY));
+	if (error) return r;
+	TEST_CBF_NOTFOUND(cbf_find_tag(h,"_w.a"));
+	TEST_CBF_PASS(cbf_find_tag(h,"_y.a"));
+	TEST_CBF_PASS(cbf_get_value(h,&value));
+	TEST(value && !strcmp(value,"2"));
+	TEST_CBF_PASS(cbf_free_handle(h));
+
+	/* Building everything at once leaves the same tree */
+	TEST_CBF_PASS(read_blocks(&h,CBF_PARSE_LAZY));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_build_datablocks(h));
+	TEST_CBF_PASS(cbf_find_tag(h,"z.a"));
+	TEST_CBF_PASS(cbf_get_value(h,&value));
+	TEST(value && !strcmp(value,"3"));
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(test_find_tag(0));
+	TEST_COMPONENT(test_find_tag(CBF_PARSE_LAZY));
+	TEST_COMPONENT(test_srch_tag_each_block());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
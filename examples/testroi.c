@@ -0,0 +1,276 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for decoding a region of interest, checked against a    *
+ * full decode followed by cbf_extract_roi.                           *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "cbf_copy.h"
+#include "unittest.h"
+
+/*
+cbf_get_integerarray_roi and cbf_get_realarray_roi must return the same
+box as decoding the whole array and cutting it out with
+cbf_extract_roi, for the codecs that decode only the rows they need
+(byte-offset, packed) and for one that does not (canonical), in memory
+and read back from a file.
+*/
+
+#define FAST 256
+#define MID 128
+#define SLOW 4
+#define ELEMENTS (FAST*MID*SLOW)
+
+/* Boxes as fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh */
+
+static const size_t box[][6] = {
+	{0, FAST-1, 0, MID-1, 0, SLOW-1},  /* the whole array */
+	{0, 0, 0, 0, 0, 0},                /* the first element */
+	{FAST-1, FAST-1, MID-1, MID-1, SLOW-1, SLOW-1},  /* the last */
+	{100, 199, 50, 60, 2, 2},          /* rows of one section */
+	{10, 19, 5, 9, 1, 2},              /* a 3-D box over two sections */
+	{0, FAST-1, MID-1, MID-1, 0, SLOW-1},  /* the last row of each section */
+	{5, 5, 0, MID-1, 0, SLOW-1}        /* one column through every section */
+};
+
+#define BOXES (sizeof(box)/sizeof(box[0]))
+
+static size_t box_size(size_t b)
+{
+	return (box[b][1]-box[b][0]+1)*(box[b][3]-box[b][2]+1)*(box[b][5]-box[b][4]+1);
+}
+
+/* A smooth image with noise, occasional overflows for byte-offset and
+   a few large negative values */
+
+static void make_image(int * image)
+{
+	size_t i;
+
+	srand(1);
+	for (i = 0; i < ELEMENTS; ++i) {
+		image[i] = (int)((i%FAST)*3+(i/FAST%MID)*2+(i/(FAST*MID))*50)+rand()%200-100;
+		if (rand()%1000 == 0) image[i] += 100000;
+		if (rand()%5000 == 0) image[i] = -2000000000;
+	}
+}
+
+static int find_data(cbf_handle h)
+{
+	cbf_failnez(cbf_rewind_datablock(h));
+	cbf_failnez(cbf_find_category(h,"array_data"));
+	cbf_failnez(cbf_find_column(h,"data"));
+	return cbf_rewind_row(h);
+}
+
+/* Compare the ROI decode of every box with the full decode, as 4- and
+   2-byte integers */
+
+static testResult_t check_boxes(cbf_handle h, const int * image)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	int id = 0, * full, * cut, * roi;
+	short * sfull, * scut, * sroi;
+	size_t b, n, read = 0;
+
+	full = malloc(ELEMENTS*sizeof(int));
+	sfull = malloc(ELEMENTS*sizeof(short));
+	cut = malloc(ELEMENTS*sizeof(int));
+	roi = malloc(ELEMENTS*sizeof(int));
+	scut = malloc(ELEMENTS*sizeof(short));
+	sroi = malloc(ELEMENTS*sizeof(short));
+	TEST(full && sfull && cut && roi && scut && sroi);
+	if (r.fail) goto done;
+
+	TEST_CBF_PASS(find_data(h));
+	TEST_CBF_PASS(cbf_get_integerarray(h,&id,full,sizeof(int),1,ELEMENTS,&read));
+	TEST(ELEMENTS==read && !memcmp(full,image,ELEMENTS*sizeof(int)));
+	TEST_CBF_PASS(find_data(h));
+	cbf_get_integerarray(h,&id,sfull,sizeof(short),1,ELEMENTS,&read);
+
+	for (b = 0; b < BOXES && !error; ++b) {
+		n = box_size(b);
+		TEST_CBF_PASS(cbf_extract_roi(full,cut,sizeof(int),
+				box[b][0],box[b][1],box[b][2],box[b][3],box[b][4],box[b][5],
+				FAST,MID,SLOW));
+		TEST_CBF_PASS(cbf_extract_roi(sfull,scut,sizeof(short),
+				box[b][0],box[b][1],box[b][2],box[b][3],box[b][4],box[b][5],
+				FAST,MID,SLOW));
+
+		memset(roi,0,n*sizeof(int));
+		read = 0;
+		TEST_CBF_PASS(find_data(h));
+		TEST_CBF_PASS(cbf_get_integerarray_roi(h,&id,roi,sizeof(int),1,
+				box[b][0],box[b][1],box[b][2],box[b][3],box[b][4],box[b][5],&read));
+		TEST(n==read);
+		TEST(!memcmp(roi,cut,n*sizeof(int)));
+
+		/* the short decode overflows like the full one */
+		memset(sroi,0,n*sizeof(short));
+		TEST_CBF_PASS(find_data(h));
+		cbf_get_integerarray_roi(h,&id,sroi,sizeof(short),1,
+				box[b][0],box[b][1],box[b][2],box[b][3],box[b][4],box[b][5],&read);
+		TEST(!memcmp(sroi,scut,n*sizeof(short)));
+	}
+
+	/* A box outside the array is refused */
+	TEST_CBF_PASS(find_data(h));
+	TEST_CBF_FAIL(cbf_get_integerarray_roi(h,&id,roi,sizeof(int),1,
+			0,FAST,0,0,0,0,&read));
+	TEST_CBF_PASS(find_data(h));
+	TEST_CBF_FAIL(cbf_get_integerarray_roi(h,&id,roi,sizeof(int),1,
+			0,0,0,0,2,1,&read));
+
+done:
+	free(full); free(sfull); free(cut); free(roi); free(scut); free(sroi);
+	return r;
+}
+
+/* Store the image with the given compression, check the boxes in memory,
+   then write the handle out and check them again reading the file */
+
+static testResult_t test_codec(unsigned int compression)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL, back = NULL;
+	int * image = malloc(ELEMENTS*sizeof(int));
+	FILE * stream = tmpfile();
+
+	TEST(image && stream);
+	if (r.fail) {
+		free(image);
+		if (stream) fclose(stream);
+		return r;
+	}
+	make_image(image);
+
+	TEST_CBF_PASS(cbf_make_handle(&h));
+	TEST_CBF_PASS(cbf_new_datablock(h,"roi"));
+	TEST_CBF_PASS(cbf_new_category(h,"array_data"));
+	TEST_CBF_PASS(cbf_new_column(h,"data"));
+	TEST_CBF_PASS(cbf_new_row(h));
+	TEST_CBF_PASS(cbf_set_integerarray_wdims_fs(h,compression,1,image,sizeof(int),1,
+			ELEMENTS,"little_endian",FAST,MID,SLOW,0));
+	if (!error) {
+		TEST_COMPONENT(check_boxes(h,image));
+	}
+
+	TEST_CBF_PASS(cbf_write_widefile(h,stream,0,CBF,MSG_DIGEST|MIME_HEADERS,0));
+	rewind(stream);
+	TEST_CBF_PASS(cbf_make_handle(&back));
+	TEST_CBF_PASS(cbf_read_widefile(back,stream,MSG_DIGEST));
+	if (!error) {
+		TEST_COMPONENT(check_boxes(back,image));
+	}
+
+	cbf_free_handle(back);
+	cbf_free_handle(h);
+	free(image);
+	return r;
+}
+
+/* The real decode of a box matches the full decode of a real array */
+
+testResult_t test_real_roi(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	double * image = malloc(ELEMENTS*sizeof(double));
+	double * full = malloc(ELEMENTS*sizeof(double));
+	double * cut = malloc(ELEMENTS*sizeof(double));
+	double * roi = malloc(ELEMENTS*sizeof(double));
+	size_t b, i, n, read = 0;
+	int id = 0;
+
+	TEST(image && full && cut && roi);
+	if (!r.fail) {
+		for (i = 0; i < ELEMENTS; ++i) image[i] = 0.25*(double)i-1000.;
+		TEST_CBF_PASS(cbf_make_handle(&h));
+		TEST_CBF_PASS(cbf_new_datablock(h,"roi"));
+		TEST_CBF_PASS(cbf_new_category(h,"array_data"));
+		TEST_CBF_PASS(cbf_new_column(h,"data"));
+		TEST_CBF_PASS(cbf_new_row(h));
+		TEST_CBF_PASS(cbf_set_realarray_wdims_fs(h,CBF_CANONICAL,1,image,sizeof(double),
+				ELEMENTS,"little_endian",FAST,MID,SLOW,0));
+		TEST_CBF_PASS(find_data(h));
+		TEST_CBF_PASS(cbf_get_realarray(h,&id,full,sizeof(double),ELEMENTS,&read));
+		TEST(ELEMENTS==read && !memcmp(full,image,ELEMENTS*sizeof(double)));
+		for (b = 0; b < BOXES && !error; ++b) {
+			n = box_size(b);
+			TEST_CBF_PASS(cbf_extract_roi(full,cut,sizeof(double),
+					box[b][0],box[b][1],box[b][2],box[b][3],box[b][4],box[b][5],
+					FAST,MID,SLOW));
+			TEST_CBF_PASS(find_data(h));
+			TEST_CBF_PASS(cbf_get_realarray_roi(h,&id,roi,sizeof(double),
+					box[b][0],box[b][1],box[b][2],box[b][3],box[b][4],box[b][5],&read));
+			TEST(n==read && !memcmp(roi,cut,n*sizeof(double)));
+		}
+		cbf_free_handle(h);
+	}
+	free(image); free(full); free(cut); free(roi);
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(test_codec(CBF_BYTE_OFFSET));
+	TEST_COMPONENT(test_codec(CBF_PACKED));
+	TEST_COMPONENT(test_codec(CBF_CANONICAL));
+	TEST_COMPONENT(test_real_roi());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
@@ -0,0 +1,356 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for the scan geometry, checking the per-frame matrices  *
+ * against the goniometer and detector constructed for each frame.    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cbf.h"
+#include "cbf_simple.h"
+#include "unittest.h"
+
+/*
+A five-frame scan laid out like the shipped templates: the settings of
+each frame in diffrn_scan_frame_axis, with no increment columns, so the
+increments of every axis, rotation or translation, come from
+diffrn_scan_axis.  Omega steps unevenly and only FRAME3 moves the
+detector along DETECTOR_Z.
+*/
+
+#define FRAMES 5
+
+static const char scan_cif[] =
+"data_scan\n"
+"_diffrn.id DIFFRN_ID\n"
+"_diffrn_detector.diffrn_id DIFFRN_ID\n"
+"_diffrn_detector.id DETECTOR\n"
+"_diffrn_detector.number_of_axes 3\n"
+"loop_\n"
+"_diffrn_detector_axis.detector_id\n"
+"_diffrn_detector_axis.axis_id\n"
+" DETECTOR DETECTOR_Y\n"
+" DETECTOR DETECTOR_Z\n"
+" DETECTOR DETECTOR_PITCH\n"
+"_diffrn_detector_element.id ELEMENT1\n"
+"_diffrn_detector_element.detector_id DETECTOR\n"
+"loop_\n"
+"_diffrn_data_frame.id\n"
+"_diffrn_data_frame.detector_element_id\n"
+"_diffrn_data_frame.array_id\n"
+"_diffrn_data_frame.binary_id\n"
+" FRAME1 ELEMENT1 image_1 1\n"
+" FRAME2 ELEMENT1 image_1 2\n"
+" FRAME3 ELEMENT1 image_1 3\n"
+" FRAME4 ELEMENT1 image_1 4\n"
+" FRAME5 ELEMENT1 image_1 5\n"
+"_diffrn_measurement.diffrn_id DIFFRN_ID\n"
+"_diffrn_measurement.id GONIOMETER\n"
+"_diffrn_measurement.number_of_axes 3\n"
+"loop_\n"
+"_diffrn_measurement_axis.measurement_id\n"
+"_diffrn_measurement_axis.axis_id\n"
+" GONIOMETER GONIOMETER_PHI\n"
+" GONIOMETER GONIOMETER_KAPPA\n"
+" GONIOMETER GONIOMETER_OMEGA\n"
+"_diffrn_scan.id SCAN1\n"
+"_diffrn_scan.frame_id_start FRAME1\n"
+"_diffrn_scan.frame_id_end FRAME5\n"
+"_diffrn_scan.frames 5\n"
+"loop_\n"
+"_diffrn_scan_axis.scan_id\n"
+"_diffrn_scan_axis.axis_id\n"
+"_diffrn_scan_axis.angle_start\n"
+"_diffrn_scan_axis.angle_range\n"
+"_diffrn_scan_axis.angle_increment\n"
+"_diffrn_scan_axis.displacement_start\n"
+"_diffrn_scan_axis.displacement_range\n"
+"_diffrn_scan_axis.displacement_increment\n"
+" SCAN1 GONIOMETER_OMEGA 10.0 2.5 0.5 . . .\n"
+" SCAN1 GONIOMETER_KAPPA 30.0 0.0 0.0 . . .\n"
+" SCAN1 GONIOMETER_PHI 45.0 0.0 0.0 . . .\n"
+" SCAN1 DETECTOR_Z . . . 250.0 1.25 0.25\n"
+" SCAN1 DETECTOR_Y . . . 12.5 0.0 0.0\n"
+" SCAN1 DETECTOR_PITCH 5.0 0.0 0.0 . . .\n"
+"loop_\n"
+"_diffrn_scan_frame.frame_id\n"
+"_diffrn_scan_frame.frame_number\n"
+"_diffrn_scan_frame.scan_id\n"
+" FRAME1 1 SCAN1\n"
+" FRAME2 2 SCAN1\n"
+" FRAME3 3 SCAN1\n"
+" FRAME4 4 SCAN1\n"
+" FRAME5 5 SCAN1\n"
+"loop_\n"
+"_diffrn_scan_frame_axis.frame_id\n"
+"_diffrn_scan_frame_axis.axis_id\n"
+"_diffrn_scan_frame_axis.angle\n"
+"_diffrn_scan_frame_axis.displacement\n"
+" FRAME1 GONIOMETER_OMEGA 10.0 .\n"
+" FRAME1 GONIOMETER_KAPPA 30.0 .\n"
+" FRAME1 GONIOMETER_PHI 45.0 .\n"
+" FRAME1 DETECTOR_Z . 250.0\n"
+" FRAME1 DETECTOR_Y . 12.5\n"
+" FRAME1 DETECTOR_PITCH 5.0 .\n"
+" FRAME2 GONIOMETER_OMEGA 10.5 .\n"
+" FRAME2 GONIOMETER_KAPPA 30.0 .\n"
+" FRAME2 GONIOMETER_PHI 45.0 .\n"
+" FRAME2 DETECTOR_Z . 250.0\n"
+" FRAME2 DETECTOR_Y . 12.5\n"
+" FRAME2 DETECTOR_PITCH 5.0 .\n"
+" FRAME3 GONIOMETER_OMEGA 11.0 .\n"
+" FRAME3 GONIOMETER_KAPPA 30.0 .\n"
+" FRAME3 GONIOMETER_PHI 45.0 .\n"
+" FRAME3 DETECTOR_Z . 300.0\n"
+" FRAME3 DETECTOR_Y . 12.5\n"
+" FRAME3 DETECTOR_PITCH 5.0 .\n"
+" FRAME4 GONIOMETER_OMEGA 12.0 .\n"
+" FRAME4 GONIOMETER_KAPPA 30.0 .\n"
+" FRAME4 GONIOMETER_PHI 45.0 .\n"
+" FRAME4 DETECTOR_Z . 250.0\n"
+" FRAME4 DETECTOR_Y . 12.5\n"
+" FRAME4 DETECTOR_PITCH 5.0 .\n"
+" FRAME5 GONIOMETER_OMEGA 13.0 .\n"
+" FRAME5 GONIOMETER_KAPPA 30.0 .\n"
+" FRAME5 GONIOMETER_PHI 45.0 .\n"
+" FRAME5 DETECTOR_Z . 250.0\n"
+" FRAME5 DETECTOR_Y . 12.5\n"
+" FRAME5 DETECTOR_PITCH 5.0 .\n"
+"loop_\n"
+"_axis.id\n"
+"_axis.type\n"
+"_axis.equipment\n"
+"_axis.depends_on\n"
+"_axis.vector[1]\n"
+"_axis.vector[2]\n"
+"_axis.vector[3]\n"
+"_axis.offset[1]\n"
+"_axis.offset[2]\n"
+"_axis.offset[3]\n"
+" GONIOMETER_OMEGA rotation goniometer . -1 0 0 . . .\n"
+" GONIOMETER_KAPPA rotation goniometer GONIOMETER_OMEGA 0.64279 0.76604 0 . . .\n"
+" GONIOMETER_PHI rotation goniometer GONIOMETER_KAPPA -1 0 0 . . .\n"
+" SOURCE general source . 0 0 1 . . .\n"
+" GRAVITY general gravity . 0 -1 0 . . .\n"
+" DETECTOR_Z translation detector . 0 0 -1 0 0 0\n"
+" DETECTOR_Y translation detector DETECTOR_Z 0 -1 0 0 0 0\n"
+" DETECTOR_PITCH rotation detector DETECTOR_Y 1 0 0 0 0 0\n"
+" ELEMENT_X translation detector DETECTOR_PITCH 1 0 0 20.0 -25.0 0\n"
+" ELEMENT_Y translation detector ELEMENT_X 0 1 0 0 0 0\n"
+"loop_\n"
+"_array_structure_list.array_id\n"
+"_array_structure_list.axis_set_id\n"
+"_array_structure_list.index\n"
+"_array_structure_list.dimension\n"
+"_array_structure_list.precedence\n"
+"_array_structure_list.direction\n"
+" image_1 ELEMENT_X 1 200 1 increasing\n"
+" image_1 ELEMENT_Y 2 250 2 increasing\n"
+"loop_\n"
+"_array_structure_list_axis.axis_set_id\n"
+"_array_structure_list_axis.axis_id\n"
+"_array_structure_list_axis.displacement\n"
+"_array_structure_list_axis.displacement_increment\n"
+" ELEMENT_X ELEMENT_X -0.1 -0.2\n"
+" ELEMENT_Y ELEMENT_Y 0.1 0.2\n"
+"loop_\n"
+"_array_element_size.array_id\n"
+"_array_element_size.index\n"
+"_array_element_size.size\n"
+" image_1 1 0.2e-3\n"
+" image_1 2 0.2e-3\n";
+
+static const char * frame_id[FRAMES] = {"FRAME1","FRAME2","FRAME3","FRAME4","FRAME5"};
+
+static int read_scan(cbf_handle * h)
+{
+	FILE * stream = tmpfile();
+
+	if (!stream) return CBF_FILEOPEN;
+	fputs(scan_cif,stream);
+	rewind(stream);
+	cbf_failnez(cbf_make_handle(h));
+	return cbf_read_file(*h,stream,MSG_NODIGEST);
+}
+
+static double matrix_difference(double a[3][4], double b[3][4])
+{
+	double d = 0.;
+	int i, j;
+
+	for (i = 0; i < 3; ++i)
+		for (j = 0; j < 4; ++j)
+			if (fabs(a[i][j]-b[i][j]) > d) d = fabs(a[i][j]-b[i][j]);
+	return d;
+}
+
+/* Settings of each axis of a frame, from either table */
+
+testResult_t test_frame_axis_setting(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	double start = 0., increment = 0.;
+
+	TEST_CBF_PASS(read_scan(&h));
+	if (error) return r;
+
+	/* angles */
+	TEST_CBF_PASS(cbf_get_frame_axis_setting(h,0,"GONIOMETER_OMEGA","FRAME4",&start,&increment));
+	TEST(12.0==start && 0.5==increment);
+	TEST_CBF_PASS(cbf_get_frame_axis_setting(h,0,"GONIOMETER_KAPPA","FRAME4",&start,&increment));
+	TEST(30.0==start && 0.0==increment);
+
+	/* translations, which used to fail when the increment came
+	   from diffrn_scan_axis */
+	TEST_CBF_PASS(cbf_get_frame_axis_setting(h,0,"DETECTOR_Z","FRAME3",&start,&increment));
+	TEST(300.0==start && 0.25==increment);
+	TEST_CBF_PASS(cbf_get_frame_axis_setting(h,0,"DETECTOR_Z","FRAME2",&start,&increment));
+	TEST(250.0==start && 0.25==increment);
+	TEST_CBF_PASS(cbf_get_frame_axis_setting(h,0,"DETECTOR_Y","FRAME5",&start,&increment));
+	TEST(12.5==start && 0.0==increment);
+
+	TEST_CBF_NOTFOUND(cbf_get_frame_axis_setting(h,0,"NO_SUCH_AXIS","FRAME1",&start,&increment));
+
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+/* The scan table against the goniometer and detector of each frame */
+
+static testResult_t check_scan(cbf_handle h, double ratio)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_scan_geometry scan = NULL;
+	size_t frames = 0, frame, found;
+	double gmatrix[3][4], dmatrix[3][4];
+	double a[3], b[3], z[FRAMES];
+
+	TEST_CBF_PASS(cbf_construct_scan_geometry(h,&scan,0,ratio));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_get_scan_frames(scan,&frames));
+	TEST(FRAMES==frames);
+
+	for (frame = 0; frame < frames && frame < FRAMES && !error; ++frame) {
+		cbf_goniometer goniometer = NULL, scan_goniometer = NULL;
+		cbf_detector detector = NULL, scan_detector = NULL;
+
+		found = FRAMES;
+		TEST_CBF_PASS(cbf_find_scan_frame(scan,frame_id[frame],&found));
+		TEST(frame==found);
+
+		TEST_CBF_PASS(cbf_construct_frame_goniometer(h,&goniometer,frame_id[frame]));
+		TEST_CBF_PASS(cbf_construct_frame_detector(h,&detector,0,frame_id[frame]));
+		TEST_CBF_PASS(cbf_get_scan_frame_matrices(scan,frame,gmatrix,dmatrix));
+		TEST_CBF_PASS(cbf_set_scan_frame(scan,frame,&scan_goniometer,&scan_detector));
+		if (error) break;
+
+		/* the goniometer matrix and a reciprocal vector */
+		TEST_CBF_PASS(cbf_get_reciprocal(goniometer,0,ratio,1.0,0.3,-0.2,-1.0,a,a+1,a+2));
+		TEST_CBF_PASS(cbf_get_reciprocal(scan_goniometer,0,ratio,1.0,0.3,-0.2,-1.0,b,b+1,b+2));
+		TEST(matrix_difference(gmatrix,goniometer->matrix) < 1.e-12);
+		TEST(fabs(a[0]-b[0])+fabs(a[1]-b[1])+fabs(a[2]-b[2]) < 1.e-12);
+
+		/* the detector matrix and pixel positions */
+		TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(detector,10.,20.,a,a+1,a+2));
+		TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(scan_detector,10.,20.,b,b+1,b+2));
+		TEST(fabs(a[0]-b[0])+fabs(a[1]-b[1])+fabs(a[2]-b[2]) < 1.e-12);
+
+		/* the tabulated detector sits at pixel (0,0), moved along
+		   DETECTOR_Z by the ratio of its increment */
+		TEST_CBF_PASS(cbf_get_pixel_coordinates_fs(detector,0.,0.,a,a+1,a+2));
+		TEST(fabs(dmatrix[0][3]-a[0]) < 1.e-9 && fabs(dmatrix[1][3]-a[1]) < 1.e-9);
+		TEST(fabs(dmatrix[2][3]-a[2]+0.25*ratio) < 1.e-9);
+		z[frame] = a[2];
+
+		cbf_free_goniometer(goniometer);
+		cbf_free_detector(detector);
+	}
+
+	/* only FRAME3 moves the detector */
+	if (FRAMES==frames && !error) {
+		TEST(fabs(z[0]-z[1]) < 1.e-9 && fabs(z[0]-z[3]) < 1.e-9);
+		TEST(fabs(z[2]-z[0]+50.) < 1.e-9);
+	}
+
+	TEST_CBF_NOTFOUND(cbf_find_scan_frame(scan,"FRAME6",&found));
+	TEST_CBF_FAIL(cbf_get_scan_frame_matrices(scan,FRAMES,gmatrix,dmatrix));
+
+	TEST_CBF_PASS(cbf_free_scan_geometry(scan));
+	return r;
+}
+
+testResult_t test_scan_geometry(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+
+	TEST_CBF_PASS(read_scan(&h));
+	if (error) return r;
+	TEST_COMPONENT(check_scan(h,0.));
+	TEST_COMPONENT(check_scan(h,0.5));
+	TEST_COMPONENT(check_scan(h,1.));
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(test_frame_axis_setting());
+	TEST_COMPONENT(test_scan_geometry());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
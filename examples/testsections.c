@@ -0,0 +1,268 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for array sections, reversed and strided, read and      *
+ * written one at a time or in bulk through a section plan.           *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "cbf_simple.h"
+#include "unittest.h"
+
+/*
+Each section of a 12x10 array, given in array_structure_list_section,
+must hold the pixels its start, end and stride pick out of the full
+array, whether read or written one section at a time with
+cbf_get_3d_array and cbf_set_3d_array or all at once through a plan.
+*/
+
+#define FAST 12
+#define SLOW 10
+#define SECTIONS 4
+
+static const char layout[] =
+"data_sections\n"
+"loop_\n"
+"_array_structure_list.array_id\n"
+"_array_structure_list.index\n"
+"_array_structure_list.dimension\n"
+"_array_structure_list.precedence\n"
+"_array_structure_list.direction\n"
+" image_1 1 12 1 increasing\n"
+" image_1 2 10 2 increasing\n"
+"loop_\n"
+"_array_structure_list_section.id\n"
+"_array_structure_list_section.array_id\n"
+"_array_structure_list_section.index\n"
+"_array_structure_list_section.start\n"
+"_array_structure_list_section.end\n"
+"_array_structure_list_section.stride\n"
+" plain image_1 1 1 6 1\n"
+" plain image_1 2 1 5 1\n"
+" reversed image_1 1 12 7 -1\n"
+" reversed image_1 2 1 5 1\n"
+" strided image_1 1 1 11 2\n"
+" strided image_1 2 6 10 1\n"
+" upended image_1 1 7 12 1\n"
+" upended image_1 2 10 6 -1\n"
+"loop_\n"
+"_array_data.array_id\n"
+"_array_data.binary_id\n"
+"_array_data.data\n"
+" image_1 1 ?\n";
+
+/* The sections as given in the layout, by index 1 (fast) and 2 (slow) */
+
+static const struct {
+	const char * id;
+	int start[2], end[2], stride[2];
+} section[SECTIONS] = {
+	{"plain",    {1,1},  {6,5},   {1,1}},
+	{"reversed", {12,1}, {7,5},   {-1,1}},
+	{"strided",  {1,6},  {11,10}, {2,1}},
+	{"upended",  {7,10}, {12,6},  {1,-1}}
+};
+
+/* Read the layout and store a full array */
+
+static int make_array(cbf_handle * h, const int * array)
+{
+	FILE * stream = tmpfile();
+
+	if (!stream) return CBF_FILEOPEN;
+	fputs(layout,stream);
+	rewind(stream);
+	cbf_failnez(cbf_make_handle(h));
+	cbf_failnez(cbf_read_file(*h,stream,MSG_NODIGEST));
+	cbf_failnez(cbf_find_category(*h,"array_data"));
+	cbf_failnez(cbf_find_column(*h,"data"));
+	return cbf_set_integerarray_wdims_fs(*h,CBF_BYTE_OFFSET,1,(void *)array,
+			sizeof(int),1,FAST*SLOW,"little_endian",FAST,SLOW,0,0);
+}
+
+/* Copy a section out of a full array, fast index varying fastest,
+   returning the number of pixels */
+
+static size_t cut_section(const int * array, int s, int * out)
+{
+	size_t n = 0;
+	int x, y;
+
+	for (y = section[s].start[1]; ; y += section[s].stride[1]) {
+		for (x = section[s].start[0]; ; x += section[s].stride[0]) {
+			out[n++] = array[(y-1)*FAST+x-1];
+			if (x == section[s].end[0]
+				|| (section[s].stride[0] > 0) != (x < section[s].end[0]))
+				break;
+		}
+		if (y == section[s].end[1]) break;
+	}
+	return n;
+}
+
+testResult_t test_get_sections(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	cbf_section_plan plan = NULL;
+	int array[FAST*SLOW], expected[FAST*SLOW], got[FAST*SLOW];
+	int bulk[FAST*SLOW], extracted[FAST*SLOW];
+	size_t sections = 0, offset = 0, slow = 0, mid = 0, fast = 0, n;
+	const char * id = NULL;
+	int s, i;
+
+	for (i = 0; i < FAST*SLOW; ++i) array[i] = 3*i+1;
+	TEST_CBF_PASS(make_array(&h,array));
+	TEST_CBF_PASS(cbf_construct_section_plan(h,"image_1",&plan));
+	if (error) return r;
+	TEST_CBF_PASS(cbf_get_section_plan_sections(plan,&sections));
+	TEST(SECTIONS==sections);
+
+	memset(bulk,0,sizeof(bulk));
+	memset(extracted,0,sizeof(extracted));
+	TEST_CBF_PASS(cbf_get_array_sections(h,plan,NULL,bulk,CBF_INTEGER,sizeof(int),1));
+	TEST_CBF_PASS(cbf_extract_array_sections(plan,array,sizeof(int),extracted));
+
+	for (s = 0; s < SECTIONS && !error; ++s) {
+		TEST_CBF_PASS(cbf_get_section_plan_section(plan,s,&id,&offset,&slow,&mid,&fast));
+		TEST(id && !strcmp(id,section[s].id));
+		n = cut_section(array,s,expected);
+		TEST(1==slow && n==mid*fast);
+
+		/* one section at a time */
+		memset(got,0,sizeof(got));
+		TEST_CBF_PASS(cbf_get_3d_array(h,0,section[s].id,NULL,got,
+				CBF_INTEGER,sizeof(int),1,slow,mid,fast));
+		TEST(!memcmp(got,expected,n*sizeof(int)));
+
+		/* every section at once, decoded or from the decoded array */
+		TEST(!memcmp(bulk+offset,expected,n*sizeof(int)));
+		TEST(!memcmp(extracted+offset,expected,n*sizeof(int)));
+	}
+
+	TEST_CBF_PASS(cbf_free_section_plan(plan));
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+testResult_t test_set_sections(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_handle h = NULL;
+	cbf_section_plan plan = NULL;
+	int array[FAST*SLOW], values[FAST*SLOW], expected[FAST*SLOW];
+	int full[FAST*SLOW], got[FAST*SLOW], assembled[FAST*SLOW];
+	int marked[FAST*SLOW], bulk[FAST*SLOW];
+	size_t offset = 0, slow = 0, mid = 0, fast = 0, n, read = 0;
+	const char * id = NULL;
+	int s, i, binary_id = 1, changed, kept;
+
+	for (i = 0; i < FAST*SLOW; ++i) array[i] = 3*i+1;
+	TEST_CBF_PASS(make_array(&h,array));
+	TEST_CBF_PASS(cbf_construct_section_plan(h,"image_1",&plan));
+	if (error) return r;
+
+	/* Write each section in turn with new values, tracking the pixels
+	   of the full array they land on */
+	memcpy(expected,array,sizeof(array));
+	for (s = 0; s < SECTIONS && !error; ++s) {
+		TEST_CBF_PASS(cbf_get_section_plan_section(plan,s,&id,&offset,&slow,&mid,&fast));
+		n = mid*fast;
+		for (i = 0; i < (int)n; ++i) values[i] = -1000*(s+1)-i;
+		TEST_CBF_PASS(cbf_set_3d_array(h,0,section[s].id,&binary_id,CBF_BYTE_OFFSET,
+				values,CBF_INTEGER,sizeof(int),1,slow,mid,fast));
+
+		/* the section reads back as written */
+		memset(got,0,sizeof(got));
+		TEST_CBF_PASS(cbf_get_3d_array(h,0,section[s].id,NULL,got,
+				CBF_INTEGER,sizeof(int),1,slow,mid,fast));
+		TEST(!memcmp(got,values,n*sizeof(int)));
+
+		/* mark the pixels of the section in the expected full array */
+		for (i = 0; i < FAST*SLOW; ++i) marked[i] = i;
+		cut_section(marked,s,got);
+		for (i = 0; i < (int)n; ++i) expected[got[i]] = values[i];
+	}
+
+	/* The full array holds the sections written and nothing else changed */
+	TEST_CBF_PASS(cbf_find_category(h,"array_data"));
+	TEST_CBF_PASS(cbf_find_column(h,"data"));
+	TEST_CBF_PASS(cbf_get_integerarray(h,&binary_id,full,sizeof(int),1,FAST*SLOW,&read));
+	TEST(FAST*SLOW==read);
+	for (changed = kept = i = 0; i < FAST*SLOW; ++i) {
+		if (full[i] != expected[i]) ++changed;
+		if (full[i] == array[i]) ++kept;
+	}
+	TEST(!changed);
+	TEST(kept > 0 && kept < FAST*SLOW);
+
+	/* Assembling the sections read in bulk rebuilds the same array */
+	TEST_CBF_PASS(cbf_get_array_sections(h,plan,NULL,bulk,CBF_INTEGER,sizeof(int),1));
+	memcpy(assembled,array,sizeof(array));
+	TEST_CBF_PASS(cbf_assemble_array_sections(plan,bulk,sizeof(int),assembled));
+	TEST(!memcmp(assembled,full,sizeof(full)));
+
+	TEST_CBF_PASS(cbf_free_section_plan(plan));
+	TEST_CBF_PASS(cbf_free_handle(h));
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(test_get_sections());
+	TEST_COMPONENT(test_set_sections());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
@@ -0,0 +1,408 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for cbf_find_spots and cbf_find_series_spots: thread    *
+ * counts, band boundaries, masks and the order of a series.          *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cbf.h"
+#include "cbf_spots.h"
+#include "unittest.h"
+
+/*
+cbf_find_spots searches bands of rows in parallel and must return the
+same spots, in the same order, whatever the number of threads, with
+and without a mask and for 16- and 32-bit frames.  Nor may the spots
+depend on where the band boundaries fall, so a frame moved down by a
+whole number of scan steps must give the same spots, moved down.  A
+masked pixel in the box of a spot rejects the spot, and a masked pixel
+elsewhere does not.
+
+cbf_find_series_spots must hand each frame of a series to the sink in
+frame order with the spots cbf_find_spots finds in it, and a non-zero
+return from the sink, or an error on a frame, must stop the search and
+come back from it.
+*/
+
+#define NX 1000
+#define NY 700
+#define NSPOTS 300
+#define NFRAMES 6
+
+#define MIN_ISIGMA 3.
+#define MIN_SPACING 6
+#define OVERLOAD 60000
+
+/* A noisy background with Gaussian spots, some of them saturated */
+
+static void make_frame(unsigned short * frame, unsigned int seed, size_t nspots)
+{
+	size_t i, k;
+	int x, y;
+
+	srand(seed);
+	for (i = 0; i < (size_t)NX*NY; ++i)
+		frame[i] = (unsigned short)(20+rand()%10);
+	for (k = 0; k < nspots; ++k) {
+		int cx = 8+rand()%(NX-16), cy = 8+rand()%(NY-16);
+		double height = 200+rand()%3000, sigma = 0.8+(rand()%10)/10.;
+		if (k%50 == 0) height = 200000;
+		for (y = cy-4; y <= cy+4; ++y)
+			for (x = cx-4; x <= cx+4; ++x) {
+				double value = frame[(size_t)y*NX+x]
+					+height*exp(-((x-cx)*(x-cx)+(y-cy)*(y-cy))/(2*sigma*sigma));
+				frame[(size_t)y*NX+x] = (unsigned short)(value > 65535 ? 65535 : value);
+			}
+	}
+}
+
+static int same_spots(const cbf_spot * a, size_t na, const cbf_spot * b, size_t nb)
+{
+	size_t i;
+
+	if (na != nb)
+		return 0;
+	for (i = 0; i < na; ++i)
+		if (a[i].fast != b[i].fast || a[i].slow != b[i].slow || a[i].isigma != b[i].isigma
+			|| a[i].width != b[i].width || a[i].height != b[i].height)
+			return 0;
+	return 1;
+}
+
+/* The spots of one frame for each number of threads against one thread */
+
+static testResult_t check_threads(const void * image, size_t elsize, int elsign,
+		const unsigned char * mask, size_t * found)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	static const int threads[] = {2, 4, 8, 16};
+	cbf_spot * ref = NULL, * spots = NULL;
+	size_t nref = 0, nspots = 0, t;
+
+	TEST_CBF_PASS(cbf_find_spots(image,elsize,elsign,mask,NX,NY,MIN_ISIGMA,MIN_SPACING,
+			0,OVERLOAD,1,0,&ref,&nref));
+	for (t = 0; !error && t < sizeof(threads)/sizeof(threads[0]); ++t) {
+		TEST_CBF_PASS(cbf_find_spots(image,elsize,elsign,mask,NX,NY,MIN_ISIGMA,MIN_SPACING,
+				0,OVERLOAD,threads[t],0,&spots,&nspots));
+		TEST(same_spots(ref,nref,spots,nspots));
+		cbf_free_spots(&spots);
+	}
+	/* The strongest spots come first, and maxspots keeps the head */
+	TEST(nref < 2 || ref[0].isigma >= ref[nref-1].isigma);
+	TEST_CBF_PASS(cbf_find_spots(image,elsize,elsign,mask,NX,NY,MIN_ISIGMA,MIN_SPACING,
+			0,OVERLOAD,4,10,&spots,&nspots));
+	TEST(nref >= 10 && same_spots(ref,10,spots,nspots));
+	cbf_free_spots(&spots);
+	cbf_free_spots(&ref);
+	*found = nref;
+	return r;
+}
+
+static testResult_t check_frame(void)
+{
+	testResult_t r = {0,0,0};
+	unsigned short * frame;
+	int * wide;
+	unsigned char * mask;
+	size_t i, n16, n32, n16mask, n32mask;
+
+	frame = (unsigned short *) malloc((size_t)NX*NY*sizeof(unsigned short));
+	wide = (int *) malloc((size_t)NX*NY*sizeof(int));
+	mask = (unsigned char *) malloc((size_t)NX*NY);
+	make_frame(frame,1,NSPOTS);
+	srand(2);
+	for (i = 0; i < (size_t)NX*NY; ++i) {
+		wide[i] = frame[i];
+		mask[i] = rand()%53 == 0;
+	}
+
+	TEST_COMPONENT(check_threads(frame,sizeof(unsigned short),0,NULL,&n16));
+	TEST_COMPONENT(check_threads(wide,sizeof(int),1,NULL,&n32));
+	TEST_COMPONENT(check_threads(frame,sizeof(unsigned short),0,mask,&n16mask));
+	TEST_COMPONENT(check_threads(wide,sizeof(int),1,mask,&n32mask));
+
+	/* The same pixels give the same spots at either width, and a mask
+	   over one pixel in 53 rejects most of them */
+	TEST(n16 > NSPOTS/2 && n16 == n32);
+	TEST(n16mask == n32mask && n16mask < n16/2);
+
+	free(frame); free(wide); free(mask);
+	return r;
+}
+
+/* The spots of a frame and of the frame moved down by SHIFT rows of
+   flat background, away from the top and bottom edges.  The spots are
+   crowded so that many of them are cut off by spots in the band above.  Centres of mass
+   taken SHIFT rows further down round differently in the last bits. */
+
+#define SHIFT 63
+#define MARGIN 30
+
+static size_t inner_spots(const cbf_spot * spots, size_t nspots, double offset,
+		cbf_spot * inner)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < nspots; ++i)
+		if (spots[i].slow-offset >= MARGIN && spots[i].slow-offset < NY-MARGIN) {
+			inner[n] = spots[i];
+			inner[n++].slow = floor((spots[i].slow-offset)*1e6+0.5);
+		}
+	return n;
+}
+
+static testResult_t check_bands(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	unsigned short * frame, * moved;
+	cbf_spot * spots = NULL, * shifted = NULL, * a, * b;
+	size_t i, nspots = 0, nshifted = 0, na = 0, nb = 0;
+
+	frame = (unsigned short *) malloc((size_t)NX*NY*sizeof(unsigned short));
+	moved = (unsigned short *) malloc((size_t)NX*(NY+SHIFT)*sizeof(unsigned short));
+	make_frame(frame,3,10*NSPOTS);
+	for (i = 0; i < (size_t)NX*SHIFT; ++i)
+		moved[i] = 20;
+	memcpy(moved+(size_t)NX*SHIFT,frame,(size_t)NX*NY*sizeof(unsigned short));
+
+	TEST_CBF_PASS(cbf_find_spots(frame,2,0,NULL,NX,NY,MIN_ISIGMA,MIN_SPACING,
+			0,OVERLOAD,4,0,&spots,&nspots));
+	TEST_CBF_PASS(cbf_find_spots(moved,2,0,NULL,NX,NY+SHIFT,MIN_ISIGMA,MIN_SPACING,
+			0,OVERLOAD,4,0,&shifted,&nshifted));
+	a = (cbf_spot *) malloc((nspots+1)*sizeof(cbf_spot));
+	b = (cbf_spot *) malloc((nshifted+1)*sizeof(cbf_spot));
+	if (!error) {
+		na = inner_spots(spots,nspots,0,a);
+		nb = inner_spots(shifted,nshifted,SHIFT,b);
+	}
+	TEST(na > NSPOTS/2 && same_spots(a,na,b,nb));
+
+	cbf_free_spots(&spots);
+	cbf_free_spots(&shifted);
+	free(a); free(b); free(frame); free(moved);
+	return r;
+}
+
+/* One spot on a flat background, found or rejected by a mask */
+
+static size_t spots_near(const cbf_spot * spots, size_t nspots, double x, double y)
+{
+	size_t i, near = 0;
+
+	for (i = 0; i < nspots; ++i)
+		if (fabs(spots[i].fast-x) < 2 && fabs(spots[i].slow-y) < 2)
+			++near;
+	return near;
+}
+
+static testResult_t check_masked_box(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	unsigned short frame[200*200];
+	unsigned char mask[200*200];
+	cbf_spot * spots = NULL;
+	size_t nspots = 0;
+	int x, y;
+
+	for (y = 0; y < 200; ++y)
+		for (x = 0; x < 200; ++x)
+			frame[y*200+x] = (unsigned short)(20+(x*7+y*3)%5
+				+1000*exp(-((x-100)*(x-100)+(y-100)*(y-100))/2.));
+	memset(mask,0,sizeof(mask));
+
+	TEST_CBF_PASS(cbf_find_spots(frame,2,0,mask,200,200,MIN_ISIGMA,MIN_SPACING,0,0,1,0,
+			&spots,&nspots));
+	TEST(spots_near(spots,nspots,100,100) == 1);
+	cbf_free_spots(&spots);
+
+	/* A masked pixel far from the spot */
+	mask[20*200+20] = 1;
+	TEST_CBF_PASS(cbf_find_spots(frame,2,0,mask,200,200,MIN_ISIGMA,MIN_SPACING,0,0,1,0,
+			&spots,&nspots));
+	TEST(spots_near(spots,nspots,100,100) == 1);
+	cbf_free_spots(&spots);
+
+	/* A masked background pixel on the border of its box */
+	mask[103*200+102] = 1;
+	TEST_CBF_PASS(cbf_find_spots(frame,2,0,mask,200,200,MIN_ISIGMA,MIN_SPACING,0,0,1,0,
+			&spots,&nspots));
+	TEST(spots_near(spots,nspots,100,100) == 0);
+	cbf_free_spots(&spots);
+	return r;
+}
+
+/* A series of frames written as byte-offset CBF files */
+
+static const char * const names[NFRAMES] = {
+	"testspots_0.cbf", "testspots_1.cbf", "testspots_2.cbf",
+	"testspots_3.cbf", "testspots_4.cbf", "testspots_5.cbf"
+};
+
+static int write_frame(const char * name, const unsigned short * frame)
+{
+	cbf_handle h;
+	FILE * stream;
+
+	cbf_failnez(cbf_make_handle(&h));
+	cbf_onfailnez(cbf_new_datablock(h,"spots"),cbf_free_handle(h));
+	cbf_onfailnez(cbf_new_category(h,"array_data"),cbf_free_handle(h));
+	cbf_onfailnez(cbf_new_column(h,"data"),cbf_free_handle(h));
+	cbf_onfailnez(cbf_new_row(h),cbf_free_handle(h));
+	cbf_onfailnez(cbf_set_integerarray_wdims_fs(h,CBF_BYTE_OFFSET,1,(void *)frame,
+			sizeof(unsigned short),0,(size_t)NX*NY,"little_endian",NX,NY,0,0),
+			cbf_free_handle(h));
+	if (!(stream = fopen(name,"wb"))) {
+		cbf_free_handle(h);
+		return CBF_FILEOPEN;
+	}
+	cbf_onfailnez(cbf_write_widefile(h,stream,1,CBF,MSG_DIGEST|MIME_HEADERS,0),
+			cbf_free_handle(h));
+	return cbf_free_handle(h);
+}
+
+/* What the sink saw */
+
+typedef struct
+{
+	cbf_spot * expected[NFRAMES];
+	size_t nexpected[NFRAMES];
+	size_t calls, next, stop_at;
+	int out_of_order, wrong_spots;
+} series_seen;
+
+static int sink(void * context, size_t frame, const char * filename,
+		const cbf_spot * spots, size_t nspots)
+{
+	series_seen * seen = (series_seen *) context;
+
+	++seen->calls;
+	if (frame != seen->next++ || strcmp(filename,names[frame]))
+		++seen->out_of_order;
+	else if (!same_spots(seen->expected[frame],seen->nexpected[frame],spots,nspots))
+		++seen->wrong_spots;
+	return frame == seen->stop_at ? CBF_ENDOFDATA : 0;
+}
+
+static testResult_t check_series(void)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	static const int inflight[] = {1, 3, 0};
+	unsigned short * frame;
+	unsigned char * mask;
+	series_seen seen;
+	size_t f, i, k;
+
+	frame = (unsigned short *) malloc((size_t)NX*NY*sizeof(unsigned short));
+	mask = (unsigned char *) calloc((size_t)NX*NY,1);
+	for (i = 0; i < (size_t)NX*NY; i += 97)
+		mask[i] = 1;
+	memset(&seen,0,sizeof(seen));
+	for (f = 0; f < NFRAMES; ++f) {
+		make_frame(frame,10+(unsigned int)f,NSPOTS);
+		TEST_CBF_PASS(write_frame(names[f],frame));
+		TEST_CBF_PASS(cbf_find_spots(frame,sizeof(unsigned short),0,mask,NX,NY,
+				MIN_ISIGMA,MIN_SPACING,0,OVERLOAD,1,50,
+				&seen.expected[f],&seen.nexpected[f]));
+	}
+
+	for (k = 0; !error && k < sizeof(inflight)/sizeof(inflight[0]); ++k) {
+		/* Every frame, in order */
+		seen.calls = seen.next = 0;
+		seen.out_of_order = seen.wrong_spots = 0;
+		seen.stop_at = NFRAMES;
+		TEST_CBF_PASS(cbf_find_series_spots(names,NFRAMES,mask,NX,NY,MIN_ISIGMA,
+				MIN_SPACING,0,OVERLOAD,50,inflight[k],sink,&seen));
+		TEST(seen.calls == NFRAMES && !seen.out_of_order && !seen.wrong_spots);
+
+		/* The sink stops the search part way */
+		seen.calls = seen.next = 0;
+		seen.out_of_order = seen.wrong_spots = 0;
+		seen.stop_at = 2;
+		TEST(cbf_find_series_spots(names,NFRAMES,mask,NX,NY,MIN_ISIGMA,
+				MIN_SPACING,0,OVERLOAD,50,inflight[k],sink,&seen) == CBF_ENDOFDATA);
+		TEST(seen.calls == 3 && !seen.out_of_order && !seen.wrong_spots);
+	}
+
+	/* A mask of the wrong size, and a missing frame, stop at that frame */
+	seen.calls = seen.next = 0;
+	seen.stop_at = NFRAMES;
+	TEST(cbf_find_series_spots(names,NFRAMES,mask,NX,NY-1,MIN_ISIGMA,
+			MIN_SPACING,0,OVERLOAD,50,2,sink,&seen) == CBF_FORMAT);
+	TEST(seen.calls == 0);
+	remove(names[3]);
+	seen.calls = seen.next = 0;
+	seen.out_of_order = seen.wrong_spots = 0;
+	TEST(cbf_find_series_spots(names,NFRAMES,mask,NX,NY,MIN_ISIGMA,
+			MIN_SPACING,0,OVERLOAD,50,2,sink,&seen) == CBF_FILEOPEN);
+	TEST(seen.calls == 3 && !seen.out_of_order && !seen.wrong_spots);
+
+	for (f = 0; f < NFRAMES; ++f)
+		cbf_free_spots(&seen.expected[f]);
+	free(frame); free(mask);
+	return r;
+}
+
+int main(int argc, char ** argv)
+{
+
+    CBF_UNUSED(argc);
+    CBF_UNUSED(argv);
+	testResult_t r = {0,0,0};
+
+	TEST_COMPONENT(check_frame());
+	TEST_COMPONENT(check_bands());
+	TEST_COMPONENT(check_masked_box());
+	TEST_COMPONENT(check_series());
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
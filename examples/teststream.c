@@ -0,0 +1,552 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for cbf_read_stream, which reports the contents of a    *
+ * file to callbacks without building a tree.                         *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cbf.h"
+#include "unittest.h"
+
+/*
+Every callback writes its event as a line of text, so a parse can be
+checked against the events expected, in order.  A callback returning
+CBF_STREAM_SKIP must hide what its event opens and nothing else, one
+returning CBF_STREAM_STOP must end the parse at once without an error,
+and one returning an error must end the parse with that error.
+
+With CBF_PARSE_SCAN a padded binary section must be skipped, padding
+and all, and reported with the parameters of its MIME header.  Reading
+with the flag must neither check the digest nor decode the section, so
+a section with a damaged payload still reads and answers the array
+parameter queries, while an undamaged one still gives its data.
+*/
+
+#define FAST 300
+#define SLOW 200
+#define ELEMENTS (FAST*SLOW)
+
+typedef struct
+{
+	char events[4096];
+	size_t used;
+	const char *skip, *stop;
+	int error;
+	size_t binary_size;
+}
+recorder;
+
+static const char stream_cif[] =
+	"data_one\n"
+	"_cat_a.x 1\n"
+	"_cat_a.y 'two words'\n"
+	"loop_\n"
+	"_cat_b.id\n"
+	"_cat_b.v\n"
+	"r1 10\n"
+	"r2 20\n"
+	"r3 30\n"
+	"_cat_e.after 5\n"
+	"save_frame1\n"
+	"_cat_c.z\n"
+	";text\n"
+	";\n"
+	"save_\n"
+	"data_two\n"
+	"_cat_d.w ww\n";
+
+static const char all_events[] =
+	"data_one\n"
+	"category cat_a\n"
+	"column x\n"
+	"value 0 word 1\n"
+	"column y\n"
+	"value 1 sglq two words\n"
+	"loop_\n"
+	"category cat_b\n"
+	"column id\n"
+	"column v\n"
+	"row 0\n"
+	"value 0 word r1\n"
+	"value 1 word 10\n"
+	"row 1\n"
+	"value 0 word r2\n"
+	"value 1 word 20\n"
+	"row 2\n"
+	"value 0 word r3\n"
+	"value 1 word 30\n"
+	"category cat_e\n"
+	"column after\n"
+	"value 0 word 5\n"
+	"save_frame1\n"
+	"category cat_c\n"
+	"column z\n"
+	"value 0 text text\n"
+	"save_\n"
+	"data_two\n"
+	"category cat_d\n"
+	"column w\n"
+	"value 0 word ww\n";
+
+
+  /* Record an event, and answer as the recorder was told to */
+
+static int record (recorder *rec, const char *event)
+{
+	size_t length = strlen (event);
+
+	if (rec->used + length + 2 > sizeof (rec->events))
+		return CBF_ALLOC;
+	memcpy (rec->events + rec->used, event, length);
+	rec->used += length;
+	rec->events[rec->used++] = '\n';
+	rec->events[rec->used] = '\0';
+
+	if (rec->stop && !strcmp (event, rec->stop))
+		return rec->error ? rec->error : CBF_STREAM_STOP;
+	if (rec->skip && !strcmp (event, rec->skip))
+		return CBF_STREAM_SKIP;
+	return 0;
+}
+
+static int on_datablock (void *context, const char *name)
+{
+	char event[100];
+
+	sprintf (event, "data_%.90s", name);
+	return record ((recorder *) context, event);
+}
+
+static int on_saveframe (void *context, const char *name)
+{
+	char event[100];
+
+	sprintf (event, "save_%.90s", name ? name : "");
+	return record ((recorder *) context, event);
+}
+
+static int on_category (void *context, const char *name)
+{
+	char event[100];
+
+	sprintf (event, "category %.80s", name);
+	return record ((recorder *) context, event);
+}
+
+static int on_column (void *context, const char *name)
+{
+	char event[100];
+
+	sprintf (event, "column %.80s", name);
+	return record ((recorder *) context, event);
+}
+
+static int on_loop (void *context)
+{
+	return record ((recorder *) context, "loop_");
+}
+
+static int on_row (void *context, unsigned int row)
+{
+	char event[100];
+
+	sprintf (event, "row %u", row);
+	return record ((recorder *) context, event);
+}
+
+static int on_value (void *context, unsigned int column, const char *value,
+                     const char *typeofvalue)
+{
+	char event[100];
+
+	sprintf (event, "value %u %.10s %.70s", column, typeofvalue, value);
+	return record ((recorder *) context, event);
+}
+
+static int on_binary (void *context, unsigned int column,
+                      const cbf_stream_binary *binary)
+{
+	char event[100];
+
+	sprintf (event, "binary %u %d %d %lu %lu %lu %lu", column,
+	         binary->bits, binary->sign, (unsigned long) binary->dimfast,
+	         (unsigned long) binary->dimmid, (unsigned long) binary->dimslow,
+	         (unsigned long) binary->padding);
+	((recorder *) context)->binary_size = binary->size;
+	return record ((recorder *) context, event);
+}
+
+static const cbf_stream_callbacks callbacks = {
+	on_datablock, on_saveframe, on_category, on_column,
+	on_loop, on_row, on_value, on_binary
+};
+
+
+  /* Stream text to a recorder */
+
+static int stream_text (cbf_handle handle, const char *text, size_t size,
+                        int flags, recorder *rec)
+{
+	FILE *in = tmpfile ();
+
+	rec->used = 0;
+	rec->events[0] = '\0';
+	rec->binary_size = 0;
+
+	if (!in || fwrite (text, 1, size, in) != size || fseek (in, 0, SEEK_SET)) {
+		if (in) fclose (in);
+		return CBF_FILEWRITE;
+	}
+	return cbf_read_stream (handle, in, flags, &callbacks, rec);
+}
+
+
+  /* The events of all_events from the line starting with first up to the
+     one starting with last, both included */
+
+static void expect_lines (char *expected, const char *first, const char *last)
+{
+	const char *start = strstr (all_events, first);
+	const char *end = strstr (start, last);
+
+	end = strchr (end, '\n') + 1;
+	strncat (expected, start, end - start);
+}
+
+
+static testResult_t check_events (cbf_handle handle, const char *skip,
+                                  const char *stop, int error,
+                                  const char *expected, int result)
+{
+	testResult_t r = {0, 0, 0};
+	recorder rec;
+
+	rec.skip = skip;
+	rec.stop = stop;
+	rec.error = error;
+	TEST (result == stream_text (handle, stream_cif, sizeof (stream_cif) - 1,
+	                             MSG_NODIGEST, &rec));
+	TEST (!strcmp (rec.events, expected));
+	if (strcmp (rec.events, expected))
+		fprintf (stderr, "skip '%s', stop '%s':\n%s--\n",
+		         skip ? skip : "", stop ? stop : "", rec.events);
+	return r;
+}
+
+
+static testResult_t test_skip_and_stop (void)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	char expected[4096];
+	const char *name = NULL;
+	unsigned int blocks = 0;
+
+	TEST_CBF_PASS (cbf_make_handle (&handle));
+	if (!handle) return r;
+	TEST_CBF_PASS (cbf_new_datablock (handle, "kept"));
+
+	TEST_COMPONENT (check_events (handle, NULL, NULL, 0, all_events, 0));
+
+	  /* Skipping a data block hides it up to the next one */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "data_one");
+	expect_lines (expected, "data_two", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "data_one", NULL, 0, expected, 0));
+
+	  /* Skipping a category hides its columns and values */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "category cat_a");
+	expect_lines (expected, "loop_", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "category cat_a", NULL, 0, expected, 0));
+
+	  /* Skipping a column hides its values, in and out of a loop */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "column x");
+	expect_lines (expected, "column y", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "column x", NULL, 0, expected, 0));
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "row 0");
+	expect_lines (expected, "value 1 word 10", "row 1");
+	expect_lines (expected, "value 1 word 20", "row 2");
+	expect_lines (expected, "value 1 word 30", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "column id", NULL, 0, expected, 0));
+
+	  /* Skipping a loop hides it up to the items after it */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "loop_");
+	expect_lines (expected, "category cat_e", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "loop_", NULL, 0, expected, 0));
+
+	  /* Skipping a row hides its values only */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "row 1");
+	expect_lines (expected, "row 2", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "row 1", NULL, 0, expected, 0));
+
+	  /* Skipping a save frame hides it, and its end */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "save_frame1");
+	expect_lines (expected, "data_two", "value 0 word ww");
+	TEST_COMPONENT (check_events (handle, "save_frame1", NULL, 0, expected, 0));
+
+	  /* Stopping ends the parse at once, at any kind of event */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "value 1 word 20");
+	TEST_COMPONENT (check_events (handle, NULL, "value 1 word 20", 0, expected, 0));
+	*expected = '\0';
+	expect_lines (expected, "data_one", "save_frame1");
+	TEST_COMPONENT (check_events (handle, NULL, "save_frame1", 0, expected, 0));
+	*expected = '\0';
+	expect_lines (expected, "data_one", "data_one");
+	TEST_COMPONENT (check_events (handle, NULL, "data_one", 0, expected, 0));
+
+	  /* An error from a callback ends the parse with that error */
+
+	*expected = '\0';
+	expect_lines (expected, "data_one", "row 1");
+	TEST_COMPONENT (check_events (handle, NULL, "row 1", CBF_ARGUMENT,
+	                              expected, CBF_ARGUMENT));
+
+	  /* None of it touches the data blocks of the handle */
+
+	TEST_CBF_PASS (cbf_count_datablocks (handle, &blocks));
+	TEST (1 == blocks);
+	TEST_CBF_PASS (cbf_datablock_name (handle, &name));
+	TEST (name && !strcmp (name, "kept"));
+
+	TEST_CBF_PASS (cbf_free_handle (handle));
+	return r;
+}
+
+
+  /* Write an image, padded, with an item after it, and return the whole
+     of the file */
+
+static int write_image (const int *image, unsigned int compression,
+                        char **text, size_t *size)
+{
+	cbf_handle handle = NULL;
+	FILE *stream = tmpfile ();
+	long end;
+
+	*text = NULL;
+	*size = 0;
+	if (!stream) return CBF_FILEOPEN;
+	cbf_failnez (cbf_make_handle (&handle))
+	cbf_failnez (cbf_new_datablock (handle, "scan"))
+	cbf_failnez (cbf_new_category (handle, "array_data"))
+	cbf_failnez (cbf_new_column (handle, "data"))
+	cbf_failnez (cbf_new_row (handle))
+	cbf_failnez (cbf_set_integerarray_wdims_fs (handle, compression, 1,
+	             (void *) image, sizeof (int), 1, ELEMENTS, "little_endian",
+	             FAST, SLOW, 0, 0))
+	cbf_failnez (cbf_new_category (handle, "after"))
+	cbf_failnez (cbf_new_column (handle, "x"))
+	cbf_failnez (cbf_set_value (handle, "done"))
+	cbf_onfailnez (cbf_write_file (handle, stream, 0, CBF,
+	               MSG_DIGEST | MIME_HEADERS | PAD_4K, 0), fclose (stream))
+	cbf_failnez (cbf_free_handle (handle))
+	if (fseek (stream, 0, SEEK_END) || (end = ftell (stream)) < 0 ||
+	    !(*text = malloc ((size_t) end))) {
+		fclose (stream);
+		return CBF_FILEREAD;
+	}
+	rewind (stream);
+	*size = fread (*text, 1, (size_t) end, stream);
+	fclose (stream);
+	return *size == (size_t) end ? CBF_SUCCESS : CBF_FILEREAD;
+}
+
+
+  /* Read text into a new handle and find the image in it */
+
+static int read_image (cbf_handle *handle, const char *text, size_t size,
+                       int flags)
+{
+	FILE *in = tmpfile ();
+
+	*handle = NULL;
+	if (!in || fwrite (text, 1, size, in) != size || fseek (in, 0, SEEK_SET)) {
+		if (in) fclose (in);
+		return CBF_FILEWRITE;
+	}
+	cbf_failnez (cbf_make_handle (handle))
+	cbf_failnez (cbf_set_cbf_logfile (*handle, NULL))
+	cbf_failnez (cbf_read_file (*handle, in, flags))
+	cbf_failnez (cbf_find_category (*handle, "array_data"))
+	cbf_failnez (cbf_find_column (*handle, "data"))
+	return cbf_rewind_row (*handle);
+}
+
+
+static testResult_t check_parameters (cbf_handle handle,
+                                      unsigned int expected)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	unsigned int compression = 0;
+	int id = 0, elsigned = 0, elunsigned = 0, minelem = 0, maxelem = 0;
+	size_t elsize = 0, nelem = 0, dimfast = 0, dimmid = 0, dimslow = 0,
+	       padding = 0;
+	const char *byteorder = NULL;
+
+	TEST_CBF_PASS (cbf_get_integerarrayparameters_wdims_fs (handle,
+	               &compression, &id, &elsize, &elsigned, &elunsigned,
+	               &nelem, &minelem, &maxelem, &byteorder,
+	               &dimfast, &dimmid, &dimslow, &padding));
+	TEST (expected == compression);
+	TEST (sizeof (int) == elsize && elsigned && !elunsigned);
+	TEST (ELEMENTS == nelem);
+	TEST (FAST == dimfast && SLOW == dimmid);
+	TEST (4095 == padding);
+	return r;
+}
+
+
+static testResult_t test_scan (unsigned int compression)
+{
+	testResult_t r = {0, 0, 0};
+	int error = CBF_SUCCESS;
+	cbf_handle handle = NULL;
+	int *image = malloc (ELEMENTS * sizeof (int));
+	int *read = malloc (ELEMENTS * sizeof (int));
+	char *text = NULL, *payload = NULL;
+	size_t size = 0, nread = 0, i;
+	recorder rec, scanned;
+	char expected[4096];
+	int id = 0;
+
+	TEST (image && read);
+	if (r.fail) goto done;
+	for (i = 0; i < ELEMENTS; i++)
+		image[i] = (int) (i % 1000) + (i % 97 ? 0 : 70000);
+	TEST_CBF_PASS (write_image (image, compression, &text, &size));
+	TEST_CBF_PASS (cbf_make_handle (&handle));
+	if (r.fail) goto done;
+
+	  /* A scan reports what a full parse reports, and the item after the
+	     padding */
+
+	sprintf (expected, "data_scan\ncategory array_data\ncolumn data\n"
+	         "binary 0 32 1 %d %d 0 4095\ncategory after\ncolumn x\n"
+	         "value 0 word done\n", FAST, SLOW);
+	rec.skip = rec.stop = scanned.skip = scanned.stop = NULL;
+	rec.error = scanned.error = 0;
+	TEST_CBF_PASS (stream_text (handle, text, size, MSG_DIGEST, &rec));
+	TEST_CBF_PASS (stream_text (handle, text, size, CBF_PARSE_SCAN, &scanned));
+	TEST (!strcmp (rec.events, expected));
+	TEST (!strcmp (scanned.events, expected));
+	if (strcmp (scanned.events, expected))
+		fprintf (stderr, "%s--\n", scanned.events);
+	TEST (rec.binary_size > 0 && rec.binary_size == scanned.binary_size);
+	TEST_CBF_PASS (cbf_free_handle (handle));
+	handle = NULL;
+
+	  /* A scanned image gives its parameters and, on demand, its data */
+
+	TEST_CBF_PASS (read_image (&handle, text, size, CBF_PARSE_SCAN));
+	if (handle && !r.fail) {
+		TEST_COMPONENT (check_parameters (handle, compression));
+		TEST_CBF_PASS (cbf_get_integerarray (handle, &id, read, sizeof (int),
+		                                     1, ELEMENTS, &nread));
+		TEST (ELEMENTS == nread && !memcmp (read, image, sizeof (int) * ELEMENTS));
+	}
+	if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	handle = NULL;
+
+	  /* Damage the start of the payload, which for packed data holds the
+	     number of elements: a full read checking digests fails, a scan
+	     does not look */
+
+	for (i = 0; i + 4 < size && !payload; i++)
+		if (!memcmp (text + i, "\014\032\004\325", 4))
+			payload = text + i + 4;
+	TEST (payload && payload + rec.binary_size <= text + size);
+	if (payload && !r.fail) {
+		payload[0] ^= 0x55;
+		TEST_CBF_FAIL (read_image (&handle, text, size, MSG_DIGESTNOW));
+		if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+		handle = NULL;
+		TEST_CBF_PASS (read_image (&handle, text, size,
+		                           MSG_DIGESTNOW | CBF_PARSE_SCAN));
+		if (handle && !r.fail)
+			TEST_COMPONENT (check_parameters (handle, compression));
+		if (handle) TEST_CBF_PASS (cbf_free_handle (handle));
+	}
+
+done:
+	free (text);
+	free (image);
+	free (read);
+	return r;
+}
+
+
+int main(int argc, char ** argv)
+{
+	testResult_t r = {0,0,0};
+
+	CBF_UNUSED(argc);
+	CBF_UNUSED(argv);
+
+	TEST_COMPONENT(test_skip_and_stop());
+	TEST_COMPONENT(test_scan(CBF_BYTE_OFFSET));
+	TEST_COMPONENT(test_scan(CBF_PACKED));
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+/**********************************************************************
+ *                                                                    *
+ * Unit tests for SWMR writing, checking each frame from a reader     *
+ * process as soon as the writer has flushed it.                      *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "cbf.h"
+#include "cbf_simple.h"
+#include "cbf_hdf5.h"
+#include "unittest.h"
+
+/*
+A writer appends frames to a NeXus file in SWMR mode, flushing every
+frame, and after each one tells a reader in a child process, which
+refreshes the image and the per-frame datasets with H5Drefresh.  Every
+dataset written for a frame must be visible with it: the image and the
+per-frame values grow together and hold the values of the frame.
+
+The reader is forked before either process opens the file, as HDF5
+will not open a file for SWMR reading in a process that has it open
+for writing.
+*/
+
+#ifdef CBF_USE_ULP
+
+#define FRAMES 4
+#define FAST 4
+#define SLOW 3
+
+static const char * template_file = NULL;
+
+/* A dataset that gains a value with every frame */
+
+typedef struct
+{
+	const char * path;
+	int check_value;   /* 0 to check only the extent */
+	double scale;      /* the value of frame f is scale*f+offset */
+	double offset;
+}
+frame_dataset_t;
+
+/* A way of writing a frame and the datasets it writes */
+
+typedef struct
+{
+	const char * filename;
+	unsigned long int flags;
+	int (*write_frame)(cbf_h5handle nx, int frame);
+	const char * image;
+	frame_dataset_t values[3];
+}
+writer_t;
+
+static const char header[] =
+"\n# Detector: PILATUS 6M, S/N 60-0100\n# 2011-06-28T11:42:3%d.000\n"
+"# Pixel_size 172e-6 m x 172e-6 m\n"
+"# Silicon sensor, thickness 0.000320 m\n# Exposure_time 0.5 s\n"
+"# Exposure_period 0.2 s\n# Tau = 383.8e-09 s\n"
+"# Count_cutoff 1048500 counts\n# Threshold_setting: 6330 eV\n"
+"# Wavelength 0.9795 A\n# Detector_distance %g m\n"
+"# Beam_xy (1231.50, 1263.50) pixels\n# Start_angle %g deg.\n"
+"# Angle_increment 0.1000 deg.\n# Omega %g deg.\n# Polarization 0.990\n";
+
+static void frame_data(int frame, int * data)
+{
+	int i;
+
+	for (i = 0; i < FAST*SLOW; ++i) data[i] = 100*frame+i;
+}
+
+/* Write one miniCBF frame */
+
+static int write_minicbf_frame(cbf_h5handle nx, int frame)
+{
+	cbf_handle h = NULL;
+	cbf_config_t * config = NULL;
+	FILE * stream = NULL;
+	char contents[sizeof(header)+64];
+	int data[FAST*SLOW], error = CBF_SUCCESS;
+
+	frame_data(frame,data);
+	sprintf(contents,header,frame+1,0.125*(frame+1),0.5*frame,0.5*frame);
+	cbf_failnez(cbf_make_handle(&h));
+	error |= cbf_force_new_datablock(h,"image");
+	error |= cbf_new_category(h,"array_data");
+	error |= cbf_new_column(h,"header_convention");
+	error |= cbf_set_value(h,"PILATUS_1.2");
+	error |= cbf_new_column(h,"header_contents");
+	error |= cbf_set_value(h,contents);
+	error |= cbf_new_column(h,"data");
+	error |= cbf_set_integerarray_wdims_fs(h,CBF_BYTE_OFFSET,1,data,
+			sizeof(int),1,FAST*SLOW,"little_endian",FAST,SLOW,1,0);
+
+	config = cbf_config_create();
+	stream = tmpfile();
+	if (!error && (!config || !stream)) error = CBF_ALLOC;
+	if (!error) {
+		fputs("map Omega to omega\n"
+			"map Start_angle to start\n"
+			"omega depends-on . vector [1 0 0]\n"
+			"start depends-on omega vector [1 0 0]\n"
+			"Sample depends-on omega\n",stream);
+		rewind(stream);
+		error |= cbf_config_parse(stream,stderr,config);
+	}
+	if (!error) error |= cbf_write_minicbf_h5file(h,nx,config);
+
+	if (stream) fclose(stream);
+	if (config) cbf_config_free(config);
+	error |= cbf_free_handle(h);
+	return error;
+}
+
+/* Write one frame of the Pilatus template, shrunk to a few pixels */
+
+static int write_imgcif_frame(cbf_h5handle nx, int frame)
+{
+	cbf_handle h = NULL;
+	FILE * stream = NULL;
+	int data[FAST*SLOW], error = CBF_SUCCESS;
+
+	frame_data(frame,data);
+	if (!(stream = fopen(template_file,"rb"))) return CBF_FILEOPEN;
+	cbf_onfailnez(cbf_make_handle(&h),fclose(stream));
+	error |= cbf_read_template(h,stream);
+	error |= cbf_find_category(h,"array_structure_list");
+	error |= cbf_find_column(h,"dimension");
+	error |= cbf_rewind_row(h);
+	error |= cbf_set_integervalue(h,FAST);
+	error |= cbf_next_row(h);
+	error |= cbf_set_integervalue(h,SLOW);
+	error |= cbf_find_category(h,"diffrn_scan_axis");
+	error |= cbf_find_column(h,"axis_id");
+	error |= cbf_find_row(h,"GONIOMETER_OMEGA");
+	error |= cbf_find_column(h,"angle_start");
+	error |= cbf_set_doublevalue(h,"%.3f",0.5*frame);
+	error |= cbf_find_category(h,"array_data");
+	error |= cbf_find_column(h,"data");
+	error |= cbf_set_integerarray_wdims_fs(h,CBF_BYTE_OFFSET,1,data,
+			sizeof(int),1,FAST*SLOW,"little_endian",FAST,SLOW,0,0);
+	if (!error) error |= cbf_write_cbf_h5file(h,nx);
+	error |= cbf_free_handle(h);
+	return error;
+}
+
+static const writer_t writers[] = {
+	{"testswmr_minicbf.h5", 0, write_minicbf_frame,
+		"entry/instrument/detector/data",
+		{{"entry/instrument/detector/count_time",1,0.,0.5},
+		 {"entry/instrument/detector/distance",1,0.125,0.125},
+		 {"entry/sample/transformations/omega",1,0.5,0.}}},
+	{"testswmr_plan.h5", CBF_H5_PLAN, write_minicbf_frame,
+		"entry/instrument/detector/data",
+		{{"entry/instrument/detector/count_time",1,0.,0.5},
+		 {"entry/instrument/detector/distance",1,0.125,0.125},
+		 {"entry/sample/transformations/omega",1,0.5,0.}}},
+	{"testswmr_imgcif.h5", 0, write_imgcif_frame,
+		"entry/instrument/1/data_image_1_1",
+		{{"entry/instrument/1/count_time",0,0.,0.},
+		 {"entry/instrument/1/frame_start_time",0,0.,0.},
+		 {"entry/sample/GONIOMETER/GONIOMETER_OMEGA",1,0.5,0.}}}
+};
+
+#define WRITERS (sizeof(writers)/sizeof(writers[0]))
+
+/* Check the state of the file after a frame, opening the file and the
+   datasets for the first frame and refreshing them afterwards */
+
+static testResult_t check_frame(const writer_t * w, int frame,
+		cbf_h5handle * nx, hid_t * image, hid_t * values)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	hsize_t dims[3] = {0,0,0}, offset[3] = {0,0,0}, count[3] = {1,SLOW,FAST};
+	int data[FAST*SLOW], expected[FAST*SLOW];
+	double value;
+	hid_t filespace, memspace;
+	size_t i;
+
+	if (!*nx) {
+		TEST_CBF_PASS(cbf_open_h5handle_swmr(nx,w->filename));
+		if (error) return r;
+		TEST(cbf_H5Ivalid(*image = H5Dopen2((*nx)->hfile,w->image,H5P_DEFAULT)));
+		for (i = 0; i < 3; ++i)
+			TEST(cbf_H5Ivalid(values[i] = H5Dopen2((*nx)->hfile,w->values[i].path,H5P_DEFAULT)));
+		if (r.fail) return r;
+	}
+
+	/* the image holds the frame */
+	TEST_CBF_PASS(cbf_H5Drefresh(*image,dims));
+	TEST((hsize_t)frame+1==dims[0] && SLOW==dims[1] && FAST==dims[2]);
+	if (!error && (hsize_t)frame+1==dims[0]) {
+		offset[0] = frame;
+		frame_data(frame,expected);
+		memset(data,0,sizeof(data));
+		filespace = H5Dget_space(*image);
+		memspace = H5Screate_simple(3,count,NULL);
+		TEST(H5Sselect_hyperslab(filespace,H5S_SELECT_SET,offset,NULL,count,NULL) >= 0);
+		TEST(H5Dread(*image,H5T_NATIVE_INT,memspace,filespace,H5P_DEFAULT,data) >= 0);
+		TEST(!memcmp(data,expected,sizeof(data)));
+		H5Sclose(memspace);
+		H5Sclose(filespace);
+	}
+
+	/* and so does every per-frame dataset */
+	for (i = 0; i < 3; ++i) {
+		TEST_CBF_PASS(cbf_H5Drefresh(values[i],dims));
+		TEST((hsize_t)frame+1==dims[0]);
+		if (!error && w->values[i].check_value && (hsize_t)frame+1==dims[0]) {
+			offset[0] = frame;
+			count[0] = 1;
+			value = -1.;
+			filespace = H5Dget_space(values[i]);
+			memspace = H5Screate_simple(1,count,NULL);
+			TEST(H5Sselect_hyperslab(filespace,H5S_SELECT_SET,offset,NULL,count,NULL) >= 0);
+			TEST(H5Dread(values[i],H5T_NATIVE_DOUBLE,memspace,filespace,H5P_DEFAULT,&value) >= 0);
+			TEST(w->values[i].scale*frame+w->values[i].offset==value);
+			H5Sclose(memspace);
+			H5Sclose(filespace);
+		}
+	}
+	return r;
+}
+
+/* The reader: check the file after each frame the writer announces,
+   sending the results back */
+
+static int run_reader(const writer_t * w, int from_writer, int to_writer)
+{
+	cbf_h5handle nx = NULL;
+	hid_t image = CBF_H5FAIL, values[3] = {CBF_H5FAIL,CBF_H5FAIL,CBF_H5FAIL};
+	testResult_t r = {0,0,0};
+	int frame, i;
+
+	while (sizeof(frame)==read(from_writer,&frame,sizeof(frame)) && frame >= 0) {
+		r = check_frame(w,frame,&nx,&image,values);
+		if (sizeof(r)!=write(to_writer,&r,sizeof(r))) break;
+	}
+	if (cbf_H5Ivalid(image)) H5Dclose(image);
+	for (i = 0; i < 3; ++i) if (cbf_H5Ivalid(values[i])) H5Dclose(values[i]);
+	if (nx) cbf_free_h5handle(nx);
+	return 0;
+}
+
+testResult_t test_swmr(const writer_t * w)
+{
+	testResult_t r = {0,0,0};
+	int error = CBF_SUCCESS;
+	cbf_h5handle nx = NULL;
+	int to_reader[2], from_reader[2], frame, status = 0, stop = -1;
+	pid_t reader;
+
+	TEST(!pipe(to_reader) && !pipe(from_reader));
+	if (r.fail) return r;
+	fflush(stdout);
+	fflush(stderr);
+	TEST((reader = fork()) >= 0);
+	if (r.fail) return r;
+	if (!reader) {
+		close(to_reader[1]);
+		close(from_reader[0]);
+		_exit(run_reader(w,to_reader[0],from_reader[1]));
+	}
+	close(to_reader[0]);
+	close(from_reader[1]);
+
+	TEST_CBF_PASS(cbf_create_h5handle2_swmr(&nx,w->filename,0));
+	TEST_CBF_PASS(cbf_h5handle_require_entry_definition(nx,0,NULL,"NXmx","1.2",0));
+	if (!error) {
+		nx->flags = w->flags;
+		nx->float_ulp = nx->double_ulp = 4;
+	}
+	for (frame = 0; frame < FRAMES && !error; ++frame) {
+		testResult_t t = {0,0,0};
+
+		TEST_CBF_PASS(w->write_frame(nx,frame));
+		if (!frame) TEST_CBF_PASS(cbf_h5handle_start_swmr_write(nx,1));
+		if (error) break;
+
+		/* let the reader check the frame before writing the next */
+		TEST(sizeof(frame)==write(to_reader[1],&frame,sizeof(frame)));
+		TEST(sizeof(t)==read(from_reader[0],&t,sizeof(t)));
+		r.pass += t.pass;
+		r.fail += t.fail;
+		r.skip += t.skip;
+	}
+	if (sizeof(stop)!=write(to_reader[1],&stop,sizeof(stop))) ++r.fail;
+	close(to_reader[1]);
+	close(from_reader[0]);
+	TEST(waitpid(reader,&status,0)==reader && WIFEXITED(status) && !WEXITSTATUS(status));
+	if (nx) TEST_CBF_PASS(cbf_free_h5handle(nx));
+	return r;
+}
+
+#endif
+
+int main(int argc, char ** argv)
+{
+	testResult_t r = {0,0,0};
+
+#ifdef CBF_USE_ULP
+	size_t w;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s template_pilatus6m_2463x2527.cbf\n",argv[0]);
+		return 1;
+	}
+	template_file = argv[1];
+	for (w = 0; w < WRITERS; ++w)
+		TEST_COMPONENT(test_swmr(writers+w));
+#else
+	CBF_UNUSED(argc);
+	CBF_UNUSED(argv);
+	++r.skip;
+#endif
+
+	printf_results(&r);
+	return r.fail ? 1 : 0;
+}
@@ -375,6 +375,7 @@ _CBF_STR(CBF_VERS_RELEASE) CBF_VERS_SUBRELEASE
   
 #define CBF_INIT_READ_BUFFER 4096
 #define CBF_INIT_WRITE_BUFFER 4096
+#define CBF_BULK_WRITE_BUFFER 65536
 #define CBF_TRANSFER_BUFFER 4096
 
 
@@ -615,6 +616,13 @@ _CBF_STR(CBF_VERS_RELEASE) CBF_VERS_SUBRELEASE
 
 #define CBF_H5_NXPDB   0x10000  /* Flag to use  NXpdb conventions in HDF5 */
 
+#define CBF_H5_LAZY    0x20000  /* Flag to defer reading image stacks
+                                     when reading HDF5                */
+
+#define CBF_H5_PLAN    0x40000  /* Flag to reuse a compiled NeXus
+                                     mapping for a fixed-geometry
+                                     series of miniCBF frames         */
+
 
   /* Flags used for logging */
   
@@ -662,6 +670,10 @@ _CBF_STR(CBF_VERS_RELEASE) CBF_VERS_SUBRELEASE
 #define CBF_PARSE_WIDE      0x4000  /* PARSE wide files                         */
 #define CBF_PARSE_WS        0x8000  /* PARSE whitespace                         */
 #define CBF_PARSE_UTF8      0x10000 /* PARSE UTF-8                              */
+#define CBF_PARSE_SCAN      0x20000 /* Scan headers only, leave binary
+                                       sections unread and undigested       */
+#define CBF_PARSE_LAZY      0x40000 /* Index the data blocks, build each
+                                       one when it is first selected        */
 
 #define HDR_DEFAULT (MIME_HEADERS | MSG_NODIGEST)
 
@@ -939,6 +951,30 @@ const char * cbf_strerror(const int err);
 
   /* cbf handle */
 
+typedef struct cbf_validation_plan_struct cbf_validation_plan;
+
+typedef struct cbf_lazy_index_struct cbf_lazy_index;
+
+struct _cbf_handle_struct;
+
+  /* A source of values a handle holds or has left null, such as the
+     image stacks of a lazy HDF5 read */
+
+typedef struct cbf_deferred_source_struct
+{
+  int (*resolve) (struct _cbf_handle_struct *handle, void *context,
+                                                     int all);
+                                     /* Read the value at the current row
+                                        and column, or all of them, if
+                                        left null */
+
+  void (*release) (struct _cbf_handle_struct *handle, void *context);
+                                     /* Forget the handle */
+
+  void *context;
+}
+cbf_deferred_source;
+
 typedef struct _cbf_handle_struct
 {
   cbf_node *node;
@@ -956,11 +992,82 @@ typedef struct _cbf_handle_struct
   int warnings, errors;
 
   int refcount, row, search_row;
+
+  void * image;                      /* NULL or a loaded dictionary image */
+
+  size_t image_size;
+
+  int readonly;                      /* A shared dictionary or a view of one */
+
+  struct _cbf_handle_struct *shared; /* NULL or the shared dictionary viewed */
+
+  int * refcounts;                   /* Item reference counts of a read-only
+                                        dictionary, kept out of its tree */
+  size_t refcounts_size;
+
+  cbf_validation_plan *validation;   /* NULL or the compiled definitions
+                                        used to validate the current read */
+
+  cbf_lazy_index *lazy;              /* NULL or the data blocks of a lazy
+                                        read that are not built yet */
+
+  int lazy_block;                    /* Building one lazy data block:
+                                        1 before its name, 2 after */
+
+  cbf_deferred_source *deferred;     /* NULL or the source of values the
+                                        tree holds or has left null */
 }
 cbf_handle_struct;
 
 typedef cbf_handle_struct *cbf_handle;
 
+
+  /* Callback return values for cbf_read_stream */
+
+#define CBF_STREAM_SKIP  (-1)  /* Ignore what this event opens        */
+#define CBF_STREAM_STOP  (-2)  /* End the parse without an error      */
+
+
+  /* A binary section reported by cbf_read_stream */
+
+typedef struct
+{
+  int id, mime, bits, sign, realarray;
+
+  unsigned int compression;
+
+  size_t size, dimover, dimfast, dimmid, dimslow, padding;
+
+  const char *byteorder;
+}
+cbf_stream_binary;
+
+
+  /* Callbacks for cbf_read_stream, any of which may be NULL.  The names
+     and values passed are only valid during the call. */
+
+typedef struct
+{
+  int (*datablock) (void *context, const char *name);
+
+  int (*saveframe) (void *context, const char *name);  /* NULL at save_ */
+
+  int (*category)  (void *context, const char *name);
+
+  int (*column)    (void *context, const char *name);
+
+  int (*loop)      (void *context);
+
+  int (*row)       (void *context, unsigned int row);
+
+  int (*value)     (void *context, unsigned int column, const char *value,
+                                                const char *typeofvalue);
+
+  int (*binary)    (void *context, unsigned int column,
+                                   const cbf_stream_binary *binary);
+}
+cbf_stream_callbacks;
+
     
     /* 3D array 1-based indexing macro */
     
@@ -1004,6 +1111,13 @@ int cbf_read_buffered_file (cbf_handle handle, FILE *stream, int flags,
                             const char * buffer, size_t buffer_len);
 
 
+  /* Parse a file, reporting its contents to callbacks without building
+     the tree */
+
+int cbf_read_stream (cbf_handle handle, FILE *stream, int flags,
+                     const cbf_stream_callbacks *callbacks, void *context);
+
+
 
   /* Write a file */
 
@@ -1234,6 +1348,10 @@ int cbf_require_nextrow (cbf_handle handle, const char *value);
 
 int cbf_count_datablocks (cbf_handle handle, unsigned int *datablocks);
 
+  /* Build the data blocks a lazy read has not built yet */
+
+int cbf_build_datablocks (cbf_handle handle);
+
   /* Count the save frames in the current data block */
 
 int cbf_count_saveframes (cbf_handle handle, unsigned int *saveframes);
@@ -1499,6 +1617,39 @@ int cbf_get_realarray (cbf_handle  handle,
                           size_t      nelem, 
                           size_t     *nelem_read);
 
+
+  /* Get the integer values of a region of interest of the current
+     (row, column) array entry, packed fast index first */
+
+int cbf_get_integerarray_roi (cbf_handle  handle,
+                              int        *id,
+                              void       *value,
+                              size_t      elsize,
+                              int         elsign,
+                              size_t      fastlow,
+                              size_t      fasthigh,
+                              size_t      midlow,
+                              size_t      midhigh,
+                              size_t      slowlow,
+                              size_t      slowhigh,
+                              size_t     *nelem_read);
+
+
+  /* Get the real values of a region of interest of the current
+     (row, column) array entry, packed fast index first */
+
+int cbf_get_realarray_roi (cbf_handle  handle,
+                           int        *id,
+                           void       *value,
+                           size_t      elsize,
+                           size_t      fastlow,
+                           size_t      fasthigh,
+                           size_t      midlow,
+                           size_t      midhigh,
+                           size_t      slowlow,
+                           size_t      slowhigh,
+                           size_t     *nelem_read);
+
   /* Get the parameters of the current (row, column) array entry */
 
 int cbf_get_realarrayparameters (cbf_handle    handle,
@@ -1582,6 +1733,24 @@ int cbf_set_realarray_wdims (cbf_handle    handle,
 #define cbf_set_realarray_wdims_sf(handle, compression, id, value, elsize, nelem, byteorder, dimslow, dimmid, dimfast, padding) \
          cbf_set_realarray_wdims((handle),(compression),(id),(value),(elsize),(nelem),(byteorder),(dimfast),(dimmid),(dimslow),(padding))
 
+
+  /* Set the current (row, column) entry to a copy of the current
+     binary entry of another handle, keeping the compressed data */
+
+int cbf_copy_binaryvalue (cbf_handle handle, cbf_handle source);
+
+
+  /* Set the current (row, column) entry to the integer array of the
+     current binary entry of another handle, recompressed with
+     byte-offset compression a tile at a time */
+
+int cbf_transcode_integerarray (cbf_handle    handle,
+                                cbf_handle    source,
+                                unsigned int  compression,
+                                size_t        dimfast,
+                                size_t        dimmid,
+                                size_t        dimslow);
+
   /* Issue a warning message */
 
 void cbf_warning (const char *message);
@@ -1643,6 +1812,43 @@ int cbf_require_column_doublevalue (cbf_handle  handle,
                              double *number,
                              const double defaultvalue);
 
+  /* Mask values of the bulk column accessors */
+
+#define CBF_MASK_VALUE        0  /* A number                           */
+#define CBF_MASK_UNKNOWN      1  /* ? or no value                      */
+#define CBF_MASK_INAPPLICABLE 2  /* .                                  */
+
+
+  /* Get the double values of the first nelem rows of a named column
+     of the current category, marking null values in an optional mask */
+
+int cbf_get_doublecolumn (cbf_handle handle, const char *columnname,
+                          double *values, char *mask,
+                          size_t nelem, size_t *nelem_read);
+
+  /* Get the integer values of the first nelem rows of a named column
+     of the current category, marking null values in an optional mask */
+
+int cbf_get_integercolumn (cbf_handle handle, const char *columnname,
+                           int *values, char *mask,
+                           size_t nelem, size_t *nelem_read);
+
+  /* Set the first nelem rows of a named column of the current category
+     to double values, or to nulls where marked in an optional mask,
+     creating the column and rows as needed */
+
+int cbf_set_doublecolumn (cbf_handle handle, const char *columnname,
+                          const double *values, const char *mask,
+                          size_t nelem, const char *format);
+
+  /* Set the first nelem rows of a named column of the current category
+     to integer values, or to nulls where marked in an optional mask,
+     creating the column and rows as needed */
+
+int cbf_set_integercolumn (cbf_handle handle, const char *columnname,
+                           const int *values, const char *mask,
+                           size_t nelem);
+
   /* Get the local byte order of the default integer type */
   
 int cbf_get_local_integer_byte_order (char ** byte_order);
@@ -1663,6 +1869,10 @@ int cbf_get_dictionary (cbf_handle handle, cbf_handle * dictionary);
   
 int cbf_set_dictionary (cbf_handle handle, cbf_handle dictionary);
 
+  /* Make a dictionary read-only, to be shared by any number of handles */
+
+int cbf_share_dictionary (cbf_handle dictionary);
+
   /* Get the dictionary for a cbf, or create one */
   
 int cbf_require_dictionary (cbf_handle handle, cbf_handle * dictionary);
@@ -1708,6 +1918,16 @@ int cbf_reset_refcounts( cbf_handle dictionary );
 int cbf_convert_dictionary (cbf_handle handle, cbf_handle dictionary );
 
 
+  /* Write the dictionary of a cbf as a precompiled image */
+
+int cbf_write_dictionary_cache (cbf_handle handle, FILE *stream);
+
+
+  /* Load a precompiled dictionary image as the dictionary of a cbf */
+
+int cbf_read_dictionary_cache (cbf_handle handle, FILE *stream);
+
+
   /* Find the requested tag anywhere in the cbf, make it the current column */
 
 int cbf_find_tag (cbf_handle handle, const char *tag);
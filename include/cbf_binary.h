@@ -330,6 +330,22 @@ int cbf_set_binary (cbf_node *column, unsigned int row,
                     size_t dimover,
                     size_t dim1, size_t dim2, size_t dim3, size_t padding);
 
+
+  /* Copy a binary value without decompressing it */
+
+int cbf_copy_binary (cbf_node *column, unsigned int row,
+                     cbf_node *source, unsigned int source_row);
+
+
+  /* Set a binary value to another recompressed with byte-offset
+     compression, a tile at a time */
+
+int cbf_transcode_binary (cbf_node *column, unsigned int row,
+                          cbf_node *source, unsigned int source_row,
+                          unsigned int compression,
+                          size_t dimfast, size_t dimmid, size_t dimslow);
+
+
   /* Check the message digest */
 
 int cbf_check_digest (cbf_node *column, unsigned int row);
@@ -360,6 +376,16 @@ int cbf_get_binary (cbf_node *column, unsigned int row, int *binary_id,
                     size_t *padding);
 
 
+  /* Get the elements of a region of interest of a binary value */
+
+int cbf_get_binary_roi (cbf_node *column, unsigned int row, int *binary_id,
+                        void *value, size_t elsize, int elsign,
+                        size_t fastlow, size_t fasthigh,
+                        size_t midlow, size_t midhigh,
+                        size_t slowlow, size_t slowhigh,
+                        size_t *nelem_read, int *realarray);
+
+
 #ifdef __cplusplus
 
 }
@@ -283,6 +283,16 @@ int cbf_compress_byte_offset (void         *source,
         cbf_compress_byte_offset((source),(elsize),(elsign),(nelem),(compression),(file),(compressedsize),(storedbits),(realarray),(byteorder),(dimfast),(dimmid),(dimslow),(padding)) 
   
 
+  /* Compress a tile of 32-bit integers, continuing from the
+     previous element */
+
+int cbf_compress_byte_offset_tile (const void   *source,
+                                   size_t        nelem,
+                                   cbf_file     *file,
+                                   unsigned int *previous,
+                                   size_t       *compressedsize);
+
+
   /* Decompress an array with the byte-offset algorithm */
 
 int cbf_decompress_byte_offset (void         *destination, 
@@ -308,6 +318,26 @@ int cbf_decompress_byte_offset (void         *destination,
         cbf_decompress_byte_offset((destination),(elsize),(elsign),(nelem),(nelem_read),(compressedsize),(compression),(bits),(sign),(file),(realarray),(byteorder),(dimover),(dimfast),(dimmid),(dimslow),(padding))
 
 
+  /* Decompress the integers of a region of interest, reading only as
+     far as the last element of the region */
+
+int cbf_decompress_byte_offset_roi (void         *destination,
+                                    size_t        elsize,
+                                    size_t        nelem,
+                                    size_t       *nelem_read,
+                                    size_t        compressedsize,
+                                    int           bits,
+                                    cbf_file     *file,
+                                    size_t        dimfast,
+                                    size_t        dimmid,
+                                    size_t        fastlow,
+                                    size_t        fasthigh,
+                                    size_t        midlow,
+                                    size_t        midhigh,
+                                    size_t        slowlow,
+                                    size_t        slowhigh);
+
+
 #ifdef __cplusplus
 
 }
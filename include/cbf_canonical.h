@@ -259,6 +259,7 @@ extern "C" {
 #include <stdio.h>
 
 #include "cbf_file.h"
+#include "cbf_compress.h"
 
 
   /* Compression tree node */
@@ -464,6 +465,27 @@ int cbf_decompress_canonical (void         *destination,
         cbf_decompress_canonical((destination),(elsize),(elsign),(nelem),(nelem_read),(compressedsize),(compression),(bits),(sign),(file),(realarray),(byteorder),(dimover),(dimfast),(dimmid),(dimslow),(padding))
 
 
+  /* Decompress an array (from the start of the table) a tile at a time */
+
+int cbf_decompress_canonical_tiles (cbf_tile_sink *sink,
+                                    size_t        elsize,
+                                    int           elsign,
+                                    size_t        nelem,
+                                    size_t       *nelem_read,
+                                    size_t        compressedsize,
+                                    unsigned int  compression,
+                                    int           bits,
+                                    int           sign,
+                                    cbf_file     *file,
+                                    int           realarray,
+                                    const char   *byteorder,
+                                    size_t        dimover,
+                                    size_t        dimfast,
+                                    size_t        dimmid,
+                                    size_t        dimslow,
+                                    size_t        padding);
+
+
 #ifdef __cplusplus
 
 }
@@ -261,6 +261,27 @@ extern "C" {
 #include "cbf_file.h"
 
 
+  /* Elements passed on at a time by a tiled decompression */
+
+#define CBF_TILE_ELEMENTS 8192
+
+
+  /* Sink return value that ends a tiled decompression without an error */
+
+#define CBF_TILE_STOP (-1)
+
+
+  /* Receiver for the elements of a tiled decompression */
+
+typedef struct
+{
+  int (*put) (void *context, const void *elements, size_t nelem);
+
+  void *context;
+}
+cbf_tile_sink;
+
+
   /* Compress an array */
 
 int cbf_compress (void         *source, 
@@ -322,6 +343,66 @@ int cbf_decompress (void         *destination,
         cbf_decompress((destination),(elsize),(elsign),(nelem),(nelem_read),(compressedsize),(compression),(bits),(sign),(file),(realarray),(byteorder),(dimover),(dimfast),(dimmid),(dimslow),(padding))
 
 
+  /* Decompress an array a tile at a time (from the start of the table) */
+
+int cbf_decompress_tiles (cbf_tile_sink *sink,
+                          size_t        elsize,
+                          int           elsign,
+                          size_t        nelem,
+                          size_t       *nelem_read,
+                          size_t        compressedsize,
+                          unsigned int  compression,
+                          int           bits,
+                          int           sign,
+                          cbf_file     *file,
+                          int           realarray,
+                          const char   *byteorder,
+                          size_t        dimover,
+                          size_t        dimfast,
+                          size_t        dimmid,
+                          size_t        dimslow,
+                          size_t        padding);
+
+
+  /* Pass the elements decoded into a window on to the sink and keep
+     the last history elements at the start of the window */
+
+int cbf_flush_tile (cbf_tile_sink  *sink,
+                    unsigned char  *window,
+                    unsigned char **next,
+                    unsigned char **delivered,
+                    size_t          history,
+                    size_t          elsize);
+
+
+  /* Decompress the elements of a region of interest into a packed
+     array, stopping after the last element of the region */
+
+int cbf_decompress_roi (void         *destination,
+                        size_t        elsize,
+                        int           elsign,
+                        size_t        nelem,
+                        size_t       *nelem_read,
+                        size_t        compressedsize,
+                        unsigned int  compression,
+                        int           bits,
+                        int           sign,
+                        cbf_file     *file,
+                        int           realarray,
+                        const char   *byteorder,
+                        size_t        dimover,
+                        size_t        dimfast,
+                        size_t        dimmid,
+                        size_t        dimslow,
+                        size_t        padding,
+                        size_t        fastlow,
+                        size_t        fasthigh,
+                        size_t        midlow,
+                        size_t        midhigh,
+                        size_t        slowlow,
+                        size_t        slowhigh);
+
+
 #ifdef __cplusplus
 
 }
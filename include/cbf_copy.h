@@ -409,6 +409,24 @@ extern "C" {
                         size_t        gapslow
                         );
 
+    /* Bin an image into blocks of binfast x binslow pixels, leaving out
+       masked pixels and carrying overloads through to the bins */
+
+    int cbf_bin_image(const void          * src,
+                      const unsigned char * mask,
+                      void                * dst,
+                      unsigned char       * binned_mask,
+                      size_t                elsize,
+                      int                   elsigned,
+                      int                   realarray,
+                      size_t                dimfast,
+                      size_t                dimslow,
+                      size_t                binfast,
+                      size_t                binslow,
+                      double                overload,
+                      int                   average
+                      );
+
 
 
     /* Multiply a 3x3 matrix times a 3-vector to produce a 3-vectorD */
@@ -443,6 +443,12 @@ int cbf_get_character (cbf_file *file);
 int cbf_read_character (cbf_file *file);
 
 
+  /* Read a run of buffered characters that do not change the line */
+
+int cbf_read_span (cbf_file *file, const char *plain, size_t limit,
+                                   int save, const char **span, size_t *length);
+
+
   /* Put the next character */
 
 int cbf_put_character (cbf_file *file, int c);
@@ -463,6 +469,11 @@ int cbf_put_string (cbf_file *file, const char *string);
 int cbf_write_string (cbf_file *file, const char *string);
 
 
+  /* Write length characters (convert end-of-line and update line and column) */
+
+int cbf_write_chars (cbf_file *file, const char *string, size_t length);
+
+
   /* Read a (CR/LF)-terminated line into the buffer */
 
 int cbf_read_line (cbf_file *file, const char **line);
@@ -372,6 +372,7 @@ extern "C" {
 		hsize_t ydim;    /* mid index */
         hsize_t zdim;    /* slow index */
         int rank;    /* rank including the frame index */
+        int mapped;  /* 1 if frames are read through the frame sources of the h5handle */
 		/* axes */
 		cbf_axisData_t * * axisData;
         cbf_axisData_t * axispathhash[CBF_NX2CBF_HASH_BINS];  /* path hash links */
@@ -781,6 +782,18 @@ cbf_H5Drequire_scalar_F64LE2(loc,ds,nm,val,cmp)
 	 */
 	int cbf_H5Dfree(const hid_t ID);
 
+	/**
+	\brief Flush a HDF5 dataset so that SWMR readers can see appended data.
+	\ingroup section_HDF5_H5D
+	 */
+	int cbf_H5Dflush(const hid_t ID);
+
+	/**
+	\brief Refresh a HDF5 dataset opened by a SWMR reader, optionally getting its new extent.
+	\ingroup section_HDF5_H5D
+	 */
+	int cbf_H5Drefresh(const hid_t ID, hsize_t * const dim);
+
 	/* Custom HDF5 types - to get the correct string type for datasets in a consistent way */
 
 	/**
@@ -949,11 +962,38 @@ H5Gcreate2(loc_id,name,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)
     } cbf_fast_bookmark;
     
     
+    /* Source of a run of frames of an image stack, which may be held in
+       the master file or in a separate data file reached through an
+       external link or a virtual dataset mapping */
+
+    typedef struct
+    {
+        char * filename;  /* The data file, or NULL for the master file */
+        char * path;      /* The path of the dataset within that file */
+        hsize_t first;    /* The first frame of the stack held here */
+        hsize_t srcfirst; /* The matching frame within the source dataset */
+        hsize_t count;    /* The number of frames held here */
+        hsize_t frames;   /* The frames of the source dataset, or 0 if not checked */
+        hid_t file;       /* The open data file, or CBF_H5FAIL */
+        hid_t dataset;    /* The open source dataset, or CBF_H5FAIL */
+        unsigned long lastuse; /* The LRU clock at the last read */
+    } cbf_h5framesrc;
+
+    /* Opaque type for a compiled miniCBF to NeXus conversion */
+    struct cbf_minicbf_h5plan;
+
+    /* Opaque type for the cells of a CBF handle read per frame */
+    struct cbf_h5frame_cells;
+
     /* H5File structure */
     
     typedef struct
     {
         int   rwmode;  /* 0 for read-only, 1 for read-write */
+        int   swmr;    /* 0 for normal access, 1 if opened for SWMR,
+                          2 once SWMR writing has been started */
+        unsigned int swmr_flush_interval; /* Number of slices between flushes
+                                             while SWMR writing, 0 for none */
 	unsigned int slice; /* The slice within the HDF5 data arrays where data will be added */
         unsigned int block; /* The block of data arrays, or zero if no blocking */
         unsigned int blocksize;  /* The number of arrays in a block */
@@ -978,6 +1018,18 @@ H5Gcreate2(loc_id,name,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)
         hid_t colid;   /* The current column */
         hid_t curnxid; /* The current NeXus group */
         hid_t dataid;  /* The NeXus NXdata group */
+        cbf_h5framesrc * framesrcs; /* The sources of the image stack, or NULL until mapped */
+        size_t num_framesrcs;       /* The number of sources of the image stack */
+        hsize_t framedims[3];       /* The frames, slow and fast dimensions of the stack */
+        unsigned int max_open_files; /* The limit on data files held open, 0 for none */
+        unsigned int num_open_files; /* The number of data files held open */
+        unsigned long framesrc_clock; /* The LRU clock for the data files */
+        struct cbf_minicbf_h5plan * minicbf_plan; /* The compiled miniCBF conversion, or NULL */
+        cbf_deferred_source deferred; /* The source of the values of nxlazy_cbf and nxframe_cbf */
+        cbf_handle nxlazy_cbf;  /* The CBF handle last read with CBF_H5_LAZY, or NULL */
+        cbf_handle nxframe_cbf; /* The CBF handle last filled by cbf_select_h5frame, or NULL */
+        unsigned int nxframe;   /* The frame held in nxframe_cbf */
+        struct cbf_h5frame_cells * nxframe_cells; /* The cells of nxframe_cbf read per frame */
 		/* Names of various groups, used to construct paths to the axes */
 		const char * nxid_name;
         const char * nxdetector_group_name;
@@ -1933,6 +1985,23 @@ H5Gcreate2(loc_id,name,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)
     
     int cbf_create_h5handle2u(cbf_h5handle *h5handle,const char * h5filename);
     
+    /* Create an HDF5 File handle without adding a CBF_cbf group to it,
+     using the latest file format so that SWMR writing can be started.
+     If update is non-zero, an existing file is opened read-write */
+
+    int cbf_create_h5handle2_swmr(cbf_h5handle *h5handle,const char * h5filename,
+                                  const int update);
+
+    /* Start single-writer/multiple-reader writing on an H5File handle,
+     flushing the data every flush_interval slices */
+
+    int cbf_h5handle_start_swmr_write(cbf_h5handle h5handle,
+                                      const unsigned int flush_interval);
+
+    /* Flush the file of an H5File handle */
+
+    int cbf_h5handle_flush(cbf_h5handle h5handle);
+
 	/**
 	\brief Allocates space for a HDF5 file handle and associates it with the given file.
 	\ingroup section_H5Handle
@@ -1993,6 +2062,62 @@ H5Gcreate2(loc_id,name,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)
     
     int cbf_open_h5handle(cbf_h5handle *h5handle,
                           const char * h5filename);
+
+    /* Get the number of frames and the frame size of the image stack
+     in the NXdata group of the current entry.  The stack may be a
+     'data' dataset, an external link or virtual dataset mapped onto
+     data files, or a series of 'data_NNNNNN' external links as written
+     by Eiger detectors */
+
+    int cbf_get_h5image_size(cbf_h5handle nx,
+                             unsigned int * frames,
+                             size_t * ndimslow,
+                             size_t * ndimfast);
+
+    /* Read a single frame of the image stack in the NXdata group of
+     the current entry.  ndimslow is the slow dimension, ndimfast is fast. */
+
+    int cbf_get_h5image(cbf_h5handle nx,
+                        unsigned int frame,
+                        void * array,
+                        size_t elsize,
+                        int elsign,
+                        size_t ndimslow,
+                        size_t ndimfast);
+
+    /* Read ndimslow consecutive frames of the image stack in the NXdata
+     group of the current entry, starting at frame. */
+
+    int cbf_get_3d_h5image(cbf_h5handle nx,
+                           unsigned int frame,
+                           void * array,
+                           size_t elsize,
+                           int elsign,
+                           size_t ndimslow,
+                           size_t ndimmid,
+                           size_t ndimfast);
+
+    /* Convert the metadata and image of a single frame of the current
+     entry into a CBF handle, replacing any previous contents, so that
+     cbf_get_image reads only that frame.  Nothing is done if the
+     frame is the one already held in the CBF handle.  The metadata is
+     converted once; later frames only refresh the image and the
+     values that change from frame to frame. */
+
+    int cbf_select_h5frame(cbf_h5handle nx,
+                           cbf_handle cbf,
+                           unsigned int frame);
+
+    /* Set the number of data files of an image stack held open at
+     once, the least recently used being closed first; 0 for no limit */
+
+    int cbf_h5handle_set_max_open_files(cbf_h5handle nx,
+                                        unsigned int max_open_files);
+
+    /* Open an HDF5 File handle as a SWMR reader */
+
+    int cbf_open_h5handle_swmr(cbf_h5handle *h5handle,
+                               const char * h5filename);
     
     /* Convert an HDF5 typeclass to a string
      and flag for atomic or not
@@ -2063,7 +2188,10 @@ H5Gcreate2(loc_id,name,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT)
                             void *op_data);
     
     
-    /* Read an HDF5 file */
+    /* Read an HDF5 file.  With CBF_H5_LAZY, image stacks are left null
+     and read from the HDF5 file when an array call or a write needs
+     them, for as long as the HDF5 handle is open and the CBF handle is
+     the last one read lazily from it. */
     
     int cbf_read_h5file(const cbf_handle handle,
                         const cbf_h5handle h5handle,
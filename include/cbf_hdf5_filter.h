@@ -346,6 +346,15 @@ extern "C" {
     
 #endif
 
+    /* Decode one chunk as stored by the CBF filter, without calling HDF5 */
+
+    int cbf_h5z_decode_chunk(void *cbfbuf,
+                             size_t nbytes,
+                             size_t cd_nelmts,
+                             const unsigned int cd_values[],
+                             void **destination,
+                             size_t *destsize);
+
     
 #ifdef __cplusplus
     
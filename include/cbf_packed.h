@@ -259,6 +259,7 @@ extern "C" {
 #include <stdio.h>
 
 #include "cbf_file.h"
+#include "cbf_compress.h"
 
 
   /* Compress an array */
@@ -306,6 +307,26 @@ int cbf_decompress_packed (void         *destination,
 #define cbf_decompress_packed_sf(destination,elsize,elsign,nelem,nelem_read,compressedsize,compression,data_bits,data_sign,file,realarray,byteorder,dimover,dimslow,dimmid,dimfast,padding) \
         cbf_decompress_packed((destination),(elsize),(elsign),(nelem),(nelem_read),(compressedsize),(compression),(data_bits),(data_sign),(file),(realarray),(byteorder),(dimover),(dimfast),(dimmid),(dimslow),(padding))
 
+  /* Decompress an array a tile at a time */
+
+int cbf_decompress_packed_tiles (cbf_tile_sink *sink,
+                                 size_t        elsize,
+                                 int           elsign,
+                                 size_t        nelem,
+                                 size_t       *nelem_read,
+                                 size_t        compressedsize,
+                                 unsigned int  compression,
+                                 int           data_bits,
+                                 int           data_sign,
+                                 cbf_file     *file,
+                                 int           realarray,
+                                 const char   *byteorder,
+                                 size_t        dimover,
+                                 size_t        dimfast,
+                                 size_t        dimmid,
+                                 size_t        dimslow,
+                                 size_t        padding);
+
 #ifdef __cplusplus
 
 }
@@ -318,11 +318,63 @@ extern "C" {
         cbf_handle handle;
         
         int element;
+        
+        double pixel_frame [3][3], * frame_settings;
+        
+        size_t frame_nsettings;
+        
+        int pixel_frame_is_valid, pixel_frame_is_affine;
     }
     cbf_detector_struct;
     
     typedef cbf_detector_struct *cbf_detector;
     
+    typedef struct
+    {
+        size_t frames;
+        
+        char **frame_id;
+        
+        double ratio;
+        
+        cbf_goniometer goniometer;
+        
+        cbf_detector detector;
+        
+        size_t goniometer_axes, detector_axes;
+        
+        double *goniometer_settings, *detector_settings;
+        
+        double (*goniometer_matrix) [3][4], (*detector_matrix) [3][4];
+    }
+    cbf_scan_geometry_struct;
+    
+    typedef cbf_scan_geometry_struct *cbf_scan_geometry;
+    
+    typedef struct
+    {
+        size_t array_offset, section_offset, length;
+        
+        long array_stride;
+    }
+    cbf_section_row;
+    
+    typedef struct
+    {
+        char *array_id, **section_id;
+        
+        size_t dimslow, dimmid, dimfast, sections, rows;
+        
+        size_t *section_dim, *section_offset, *section_start;
+        
+        long *section_stride;
+        
+        cbf_section_row *row;
+    }
+    cbf_section_plan_struct;
+    
+    typedef cbf_section_plan_struct *cbf_section_plan;
+    
     
     /* Read a template file */
     
@@ -1097,6 +1149,54 @@ cbf_set_3d_array ((handle),(reserved),(array_id),(binary_id),(compression),(arra
 #define cbf_set_3d_array_sf(handle, reserved, array_id, binary_id, compression, array, eltype, elsize, elsign, ndimslow, ndimmid, ndimfast) \
 cbf_set_3d_array ((handle),(reserved),(array_id),(binary_id),(compression),(array),(eltype),(elsize),(elsign),(ndimslow),(ndimmid),(ndimfast) )
     
+    /* Construct a plan for moving the sections of an array between the
+       full array and a buffer holding the sections one after another */
+    
+    int cbf_construct_section_plan (cbf_handle        handle,
+                                    const char       *array_id,
+                                    cbf_section_plan *plan);
+    
+    /* Free a section plan */
+    
+    int cbf_free_section_plan (cbf_section_plan plan);
+    
+    /* Get the number of sections in a plan */
+    
+    int cbf_get_section_plan_sections (cbf_section_plan plan, size_t *sections);
+    
+    /* Get the id, buffer offset and dimensions of a section of a plan */
+    
+    int cbf_get_section_plan_section (cbf_section_plan plan, size_t section,
+                                      const char **section_id,
+                                      size_t      *offset,
+                                      size_t      *ndimslow,
+                                      size_t      *ndimmid,
+                                      size_t      *ndimfast);
+    
+    /* Copy the sections of a full array into a section buffer */
+    
+    int cbf_extract_array_sections (cbf_section_plan plan,
+                                    const void      *array,
+                                    size_t           elsize,
+                                    void            *sections);
+    
+    /* Copy a section buffer into the full array */
+    
+    int cbf_assemble_array_sections (cbf_section_plan plan,
+                                     const void      *sections,
+                                     size_t           elsize,
+                                     void            *array);
+    
+    /* Read all the sections of a plan, decoding the full array once */
+    
+    int cbf_get_array_sections (cbf_handle       handle,
+                                cbf_section_plan plan,
+                                int             *binary_id,
+                                void            *sections,
+                                int              eltype,
+                                size_t           elsize,
+                                int              elsign);
+    
     
     /* Get the specified ancestor of an axis */
     
@@ -1241,6 +1341,17 @@ cbf_set_3d_array ((handle),(reserved),(array_id),(binary_id),(compression),(arra
                             double      *reciprocal3);
     
     
+    /* Rotate nvectors lab-frame reciprocal-space vectors (3 values each)
+       back to the 0 position of the goniometer; the result may overwrite
+       the input */
+    
+    int cbf_get_reciprocal_array (cbf_goniometer goniometer, unsigned int reserved,
+                                  double        ratio,
+                                  size_t        nvectors,
+                                  const double *lab,
+                                  double       *reciprocal);
+    
+    
     /* Construct a detector positioner */
     
     int cbf_construct_detector (cbf_handle    handle,
@@ -1433,6 +1544,54 @@ cbf_get_pixel_area ((detector), (indexslow), (indexfast), (area), (projected_are
 #define cbf_get_pixel_area_fs(detector, indexfast, indexslow, area, projected_area) \
 cbf_get_pixel_area ((detector), (indexslow), (indexfast), (area), (projected_area))
     
+    /* Calculate the geometry of every pixel of a dimfast x dimslow
+       detector element, fast index varying fastest: the lab coordinates
+       and normals of the pixel centres (3 values per pixel), the solid
+       angles they subtend at the sample, and the 2theta and azimuth of
+       the scattered beam in degrees.  Any of the arrays may be NULL. */
+    
+    int cbf_get_pixel_geometry (cbf_detector detector, size_t dimfast,
+                                size_t dimslow,
+                                double *coordinates,
+                                double *normals,
+                                double *solid_angles,
+                                double *two_theta,
+                                double *azimuth);
+    
+    
+    /* Calculate the polarization factor of every pixel of a dimfast x
+       dimslow detector element for a source with the given
+       polarizn_source_ratio and polarizn_source_norm */
+    
+    int cbf_get_pixel_polarization (cbf_detector detector, size_t dimfast,
+                                    size_t dimslow,
+                                    double polarizn_source_ratio,
+                                    double polarizn_source_norm,
+                                    double *factors);
+    
+    
+    /* Calculate the lab-frame reciprocal-space vector of every pixel of a
+       dimfast x dimslow detector element (3 values per pixel, beam along
+       -z); these do not change through a scan */
+    
+    int cbf_get_pixel_reciprocal (cbf_detector detector, double wavelength,
+                                  size_t dimfast,
+                                  size_t dimslow,
+                                  double *reciprocal);
+    
+    
+    /* Calculate the reciprocal-space coordinates of every pixel of a
+       frame at the goniometer setting given by ratio, as cbf_get_reciprocal
+       would for each pixel position */
+    
+    int cbf_get_frame_reciprocal (cbf_goniometer goniometer,
+                                  cbf_detector   detector,
+                                  double         ratio,
+                                  double         wavelength,
+                                  size_t         dimfast,
+                                  size_t         dimslow,
+                                  double        *reciprocal);
+    
     /* Calcluate the size of a pixel from the detector element axis displacements */
     
     int cbf_get_inferred_pixel_size (cbf_detector detector,
@@ -1555,6 +1714,39 @@ cbf_get_inferred_pixel_size((detector), (axis_number), (psize))
                                         const char *axis_id,
                                         const char *frame_id);
     
+    /* Construct the goniometer and detector matrices of every frame
+       of a scan */
+    
+    int cbf_construct_scan_geometry (cbf_handle         handle,
+                                     cbf_scan_geometry *scan,
+                                     unsigned int       element_number,
+                                     double             ratio);
+    
+    /* Free a scan geometry */
+    
+    int cbf_free_scan_geometry (cbf_scan_geometry scan);
+    
+    /* Get the number of frames in a scan */
+    
+    int cbf_get_scan_frames (cbf_scan_geometry scan, size_t *frames);
+    
+    /* Find the number of a frame in a scan from its frame_id */
+    
+    int cbf_find_scan_frame (cbf_scan_geometry scan, const char *frame_id,
+                             size_t *frame);
+    
+    /* Get the goniometer and detector matrices of a frame */
+    
+    int cbf_get_scan_frame_matrices (cbf_scan_geometry scan, size_t frame,
+                                     double goniometer_matrix [3][4],
+                                     double detector_matrix [3][4]);
+    
+    /* Set the goniometer and detector of a scan to a frame */
+    
+    int cbf_set_scan_frame (cbf_scan_geometry scan, size_t frame,
+                            cbf_goniometer *goniometer,
+                            cbf_detector *detector);
+    
     /*  For a given axis, return the first element_id
      associated with it for the given equipment
      and equipment_id */
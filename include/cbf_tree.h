@@ -279,6 +279,44 @@ typedef enum
 CBF_NODETYPE;
 
 
+  /* Columnar storage kept with a column: the packed value text and
+     the parsed numeric values of its rows */
+
+#define CBF_STORE_DOUBLE  0x01  /* number[row] holds the double value */
+#define CBF_STORE_LONG    0x02  /* integer[row] holds the long value  */
+
+#define CBF_PACK_ROWS     1024  /* Pack columns read with this many rows */
+#define CBF_ARENA_BLOCK  65536  /* Size of the first packed text block   */
+
+typedef struct cbf_arena_struct
+{
+  struct cbf_arena_struct *next;
+
+  size_t size;                  /* Bytes of text after this header    */
+
+  size_t used;
+}
+cbf_arena;
+
+typedef struct
+{
+  cbf_arena *arena;             /* Packed copies of the values        */
+
+  const char *image;            /* Shared text not owned by the column */
+
+  size_t image_size;
+
+  size_t size;                  /* Rows with room in the caches       */
+
+  unsigned char *state;         /* CBF_STORE_* flags of each row      */
+
+  double *number;
+
+  long *integer;
+}
+cbf_column_store;
+
+
   /* Node structure */
 
 typedef struct cbf_node_struct
@@ -298,6 +336,8 @@ typedef struct cbf_node_struct
   size_t child_size;
 
   struct cbf_node_struct **child;
+
+  cbf_column_store *store;
 }
 cbf_node;
 
@@ -402,6 +442,11 @@ int cbf_add_child (cbf_node *node, cbf_node *child);
 int cbf_add_new_child (cbf_node *node, cbf_node *child);
 
 
+  /* Move all the children of one node to the end of another */
+
+int cbf_move_children (cbf_node *node, cbf_node *source);
+
+
   /* Get the name of a node */
 
 int cbf_get_name (const char **name, cbf_node *node);
@@ -473,6 +518,44 @@ int cbf_delete_columnrow (cbf_node *column, unsigned int row);
 int cbf_add_columnrow (cbf_node *column, const char *value);
 
 
+  /* Get the cached double or long value of a row */
+
+int cbf_get_columnrow_double (double *number, const cbf_node *column,
+                              unsigned int row);
+
+int cbf_get_columnrow_long (long *number, const cbf_node *column,
+                            unsigned int row);
+
+
+  /* Cache the double or long value of a row */
+
+int cbf_set_columnrow_double (cbf_node *column, unsigned int row,
+                              double number);
+
+int cbf_set_columnrow_long (cbf_node *column, unsigned int row,
+                            long number);
+
+
+  /* Is the text of a value held in the packed storage of its column? */
+
+int cbf_is_packed_value (const cbf_node *column, const char *value);
+
+
+  /* Copy the text values of a column into one contiguous block */
+
+int cbf_pack_column (cbf_node *column);
+
+
+  /* Let the values of a column point into text it does not own */
+
+int cbf_set_column_image (cbf_node *column, const char *image, size_t size);
+
+
+  /* Add a value read from a file to a column, packing long columns */
+
+int cbf_append_columnrow (cbf_node *column, const char **value);
+
+
   /* compute a hash code for a string */
   
 int cbf_compute_hashcode(const char *string, unsigned int *hashcode);
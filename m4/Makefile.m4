@@ -1264,6 +1264,7 @@ SOURCE   =  $(SRC)/cbf.c               \
 	$(SRC)/cbf_read_binary.c   \
 	$(SRC)/cbf_read_mime.c     \
 	$(SRC)/cbf_simple.c        \
+	$(SRC)/cbf_spots.c         \
 	$(SRC)/cbf_string.c        \
 	$(SRC)/cbf_stx.c           \
 	$(SRC)/cbf_tree.c          \
@@ -1333,6 +1334,7 @@ HEADERS   =  $(INCLUDE)/cbf.h               \
 	$(INCLUDE)/cbf_read_binary.h   \
 	$(INCLUDE)/cbf_read_mime.h     \
 	$(INCLUDE)/cbf_simple.h        \
+	$(INCLUDE)/cbf_spots.h         \
 	$(INCLUDE)/cbf_string.h        \
 	$(INCLUDE)/cbf_stx.h           \
 	$(INCLUDE)/cbf_tree.h          \
@@ -1536,6 +1538,7 @@ all::	$(BIN) $(SOURCE) $(F90SOURCE) $(HEADERS) \
 	$(BIN)/minicbf2nexus  \
 	$(BIN)/nexus2cbf      \
 	$(BIN)/roi_peaksearch \
+	$(BIN)/series_peaksearch \
 	$(BIN)/sequence_match \
 	$(BIN)/testcell       \
 	$(BIN)/testalloc      \
@@ -1543,6 +1546,20 @@ all::	$(BIN) $(SOURCE) $(F90SOURCE) $(HEADERS) \
 	$(BIN)/testflat       \
 	$(BIN)/testflatpacked \
 	$(BIN)/testhdf5       \
+	$(BIN)/testcolumns    \
+	$(BIN)/teststream     \
+	$(BIN)/testcifio      \
+	$(BIN)/testdictcache  \
+	$(BIN)/testgeometry   \
+	$(BIN)/testspots      \
+	$(BIN)/testbin        \
+	$(BIN)/testswmr       \
+	$(BIN)/testcopy       \
+	$(BIN)/testscan       \
+	$(BIN)/testroi        \
+	$(BIN)/testsections   \
+	$(BIN)/testh5lazy     \
+	$(BIN)/testlazy       \
 	$(BIN_TESTULP)        \
 	$(BIN)/tiff2cbf       \
 	$(BIN)/test_cbf_airy_disk \
@@ -1765,6 +1782,8 @@ baseinstall:  all $(CBF_PREFIX) $(CBF_PREFIX)/lib $(CBF_PREFIX)/bin \
 	cp $(BIN)/nexus2cbf $(CBF_PREFIX)/bin/nexus2cbf
 	-cp $(CBF_PREFIX)/bin/roi_peaksearch $(CBF_PREFIX)/bin/roi_peaksearch_old
 	cp $(BIN)/roi_peaksearch $(CBF_PREFIX)/bin/roi_peaksearch
+	-cp $(CBF_PREFIX)/bin/series_peaksearch $(CBF_PREFIX)/bin/series_peaksearch_old
+	cp $(BIN)/series_peaksearch $(CBF_PREFIX)/bin/series_peaksearch
 	-cp $(CBF_PREFIX)/bin/sequence_match $(CBF_PREFIX)/bin/sequence_match_old
 	cp $(BIN)/sequence_match $(CBF_PREFIX)/bin/sequence_match
 	-cp $(CBF_PREFIX)/bin/testalloc $(CBF_PREFIX)/bin/testalloc_old
@@ -1824,6 +1843,7 @@ endif
 	chmod 755 $(CBF_PREFIX)/bin/minicbf2nexus
 	chmod 755 $(CBF_PREFIX)/bin/nexus2cbf
 	chmod 755 $(CBF_PREFIX)/bin/roi_peaksearch
+	chmod 755 $(CBF_PREFIX)/bin/series_peaksearch
 	chmod 755 $(CBF_PREFIX)/bin/sequence_match
 	chmod 755 $(CBF_PREFIX)/bin/testalloc
 	chmod 755 $(CBF_PREFIX)/bin/testflat
@@ -2608,6 +2628,16 @@ $(BIN)/roi_peaksearch: $(LIB)/libcbf.a $(EXAMPLES)/roi_peaksearch.c \
 	$(EXAMPLES)/roi_peaksearch.c $(EXAMPLES)/dps_peaksearch.c $(GOPTLIB) -L$(LIB) \
 	-lcbf $(REGEX_LIBS_STATIC) $(HDF5LIBS_LOCAL) $(EXTRALIBS) $(HDF5LIBS_SYSTEM)  -limg -o $@
 
+#
+# series_peaksearch example program
+#
+$(BIN)/series_peaksearch: $(LIB)/libcbf.a $(EXAMPLES)/series_peaksearch.c \
+	$(GOPTLIB)	$(GOPTINC)
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) $(WARNINGS) \
+	$(EXAMPLES)/series_peaksearch.c $(GOPTLIB) -L$(LIB) \
+	-lcbf $(REGEX_LIBS_STATIC) $(HDF5LIBS_LOCAL) $(EXTRALIBS) $(HDF5LIBS_SYSTEM)  -limg -o $@
+
 
 #
 # dectris cbf_template_t program
@@ -2779,6 +2809,148 @@ $(BIN)/testalloc: $(LIB)/libcbf.a $(EXAMPLES)/testalloc.c $(EXAMPLES)/unittest.h
 	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
 	mv $@.tmp $@
 	
+#
+# testlazy test program
+#
+$(BIN)/testlazy: $(LIB)/libcbf.a $(EXAMPLES)/testlazy.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testlazy.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testh5lazy test program
+#
+$(BIN)/testh5lazy: $(LIB)/libcbf.a $(EXAMPLES)/testh5lazy.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testh5lazy.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(HDF5LIBS_LOCAL) $(EXTRALIBS) $(HDF5LIBS_SYSTEM) \
+	  -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testsections test program
+#
+$(BIN)/testsections: $(LIB)/libcbf.a $(EXAMPLES)/testsections.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testsections.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testroi test program
+#
+$(BIN)/testroi: $(LIB)/libcbf.a $(EXAMPLES)/testroi.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testroi.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testscan test program
+#
+$(BIN)/testscan: $(LIB)/libcbf.a $(EXAMPLES)/testscan.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testscan.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testcopy test program
+#
+$(BIN)/testcopy: $(LIB)/libcbf.a $(EXAMPLES)/testcopy.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testcopy.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testswmr test program
+#
+$(BIN)/testswmr: $(LIB)/libcbf.a $(EXAMPLES)/testswmr.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testswmr.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(HDF5LIBS_LOCAL) $(EXTRALIBS) $(HDF5LIBS_SYSTEM) \
+	  -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testbin test program
+#
+$(BIN)/testbin: $(LIB)/libcbf.a $(EXAMPLES)/testbin.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testbin.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testspots test program
+#
+$(BIN)/testspots: $(LIB)/libcbf.a $(EXAMPLES)/testspots.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testspots.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testgeometry test program
+#
+$(BIN)/testgeometry: $(LIB)/libcbf.a $(EXAMPLES)/testgeometry.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testgeometry.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testdictcache test program
+#
+$(BIN)/testdictcache: $(LIB)/libcbf.a $(EXAMPLES)/testdictcache.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testdictcache.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testcifio test program
+#
+$(BIN)/testcifio: $(LIB)/libcbf.a $(EXAMPLES)/testcifio.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testcifio.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# teststream test program
+#
+$(BIN)/teststream: $(LIB)/libcbf.a $(EXAMPLES)/teststream.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/teststream.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
+#
+# testcolumns test program
+#
+$(BIN)/testcolumns: $(LIB)/libcbf.a $(EXAMPLES)/testcolumns.c $(EXAMPLES)/unittest.h
+	mkdir -p $(BIN)
+	$(CC) $(CFLAGS) $(LDFLAGS) $(MISCFLAG) $(CBF_REGEXFLAG) $(INCLUDES) \
+	  $(WARNINGS) $(EXAMPLES)/testcolumns.c -L$(LIB) $(LIB)/libcbf.a \
+	  $(REGEX_LIBS_STATIC) $(EXTRALIBS) -o $@.tmp
+	mv $@.tmp $@
+
 #
 # test_cbf_airy_disk test program
 #
@@ -3096,6 +3268,20 @@ extra:	$(BIN)/convert_image $(BIN)/convert_minicbf $(BIN)/cif2cbf \
 	$(BIN)/sauter_test $(BIN)/adscimg2cbf $(BIN)/cbf2adscimg \
 	$(BIN)/changtestcompression $(BIN)/tiff2cbf \
 	$(BIN)/testhdf5 $(BIN)/testalloc \
+	$(BIN)/testlazy \
+	$(BIN)/testh5lazy \
+	$(BIN)/testsections \
+	$(BIN)/testroi \
+	$(BIN)/testscan \
+	$(BIN)/testcopy \
+	$(BIN)/testswmr \
+	$(BIN)/testbin \
+	$(BIN)/testspots \
+	$(BIN)/testgeometry \
+	$(BIN)/testdictcache \
+	$(BIN)/testcifio \
+	$(BIN)/teststream \
+	$(BIN)/testcolumns \
 	$(BIN_TESTULP) \
 	basic $(TESTINPUT_EXTRA) $(TESTOUTPUT) $(EXAMPLES)/batch_convert_minicbf.sh \
 	$(TEMPLATES)/template_X4_lots_M1S4.cbf
@@ -3106,6 +3292,20 @@ extra:	$(BIN)/convert_image $(BIN)/convert_minicbf $(BIN)/cif2cbf \
 	$(BIN)/convert_minicbf \
 	$(BIN)/sauter_test $(BIN)/adscimg2cbf $(BIN)/cbf2adscimg \
 	$(BIN)/testhdf5 $(BIN)/testalloc \
+	$(BIN)/testlazy \
+	$(BIN)/testh5lazy \
+	$(BIN)/testsections \
+	$(BIN)/testroi \
+	$(BIN)/testscan \
+	$(BIN)/testcopy \
+	$(BIN)/testswmr \
+	$(BIN)/testbin \
+	$(BIN)/testspots \
+	$(BIN)/testgeometry \
+	$(BIN)/testdictcache \
+	$(BIN)/testcifio \
+	$(BIN)/teststream \
+	$(BIN)/testcolumns \
 	$(BIN_TESTULP) \
 	basic $(TESTINPUT_EXTRA) $(TESTOUTPUT) $(EXAMPLES)/batch_convert_minicbf.sh
 endif
@@ -3196,6 +3396,20 @@ endif
 	$(LDPREFIX)  $(TIME) $(BIN)/cbf_testxfelread
 	$(LDPREFIX)  $(TIME) $(BIN)/testalloc
 	$(LDPREFIX)  $(TIME) $(BIN)/testhdf5; rm -f testfile.h5
+	$(LDPREFIX)  $(TIME) $(BIN)/testlazy
+	$(LDPREFIX)  $(TIME) $(BIN)/testh5lazy; rm -f testh5lazy_*.h5
+	$(LDPREFIX)  $(TIME) $(BIN)/testsections
+	$(LDPREFIX)  $(TIME) $(BIN)/testroi
+	$(LDPREFIX)  $(TIME) $(BIN)/testscan
+	$(LDPREFIX)  $(TIME) $(BIN)/testcopy
+	$(LDPREFIX)  $(TIME) $(BIN)/testswmr $(TEMPLATES)/template_pilatus6m_2463x2527.cbf; rm -f testswmr_*.h5
+	$(LDPREFIX)  $(TIME) $(BIN)/testbin
+	$(LDPREFIX)  $(TIME) $(BIN)/testspots; rm -f testspots_*.cbf
+	$(LDPREFIX)  $(TIME) $(BIN)/testgeometry $(TEMPLATES)/template_pilatus6m_2463x2527.cbf
+	$(LDPREFIX)  $(TIME) $(BIN)/testdictcache $(DOC)/cif_img_1.8.9.2.dic
+	$(LDPREFIX)  $(TIME) $(BIN)/testcifio
+	$(LDPREFIX)  $(TIME) $(BIN)/teststream
+	$(LDPREFIX)  $(TIME) $(BIN)/testcolumns
 ifneq ($(CBF_USE_ULP),)
 	$(LDPREFIX)  $(TIME) $(BIN)/testulp
 endif
@@ -3436,6 +3650,9 @@ endif
 	@-rm -f  *_old
 	@-rm -f X4_lots_M1S4_1_*.cbf
 	@-rm -f testfile.h5
+	@-rm -f testh5lazy_*.h5
+	@-rm -f testswmr_*.h5
+	@-rm -f testspots_*.cbf
 	@-rm -f hit-20140306005258847.cbf
 	@-rm -f build_*
 	@-rm -rf HDF5Plugin_5Jun21/
@@ -259,12 +259,24 @@ extern "C" {
 #include "cbf_write.h"
 #include "cbf_string.h"
 #include "cbf_ascii.h"
+#include "cbf_context.h"
+#include "cbf_file.h"
+#include "cbf_lex.h"
+#include "cbf_stx.h"
 #ifdef CBF_USE_ULP
 #include "cbf_ulp.h"
 #endif
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
     
 
 #if !defined(CBF_NO_REGEX)
@@ -278,6 +290,17 @@ extern "C" {
 
     int cbf_parse (void *context);
 
+static int cbf_free_validation_plan (cbf_handle handle);
+
+static int cbf_free_lazy_index (cbf_handle handle);
+
+static int cbf_resolve_deferred (cbf_handle handle, int all);
+
+static void cbf_release_deferred (cbf_handle handle);
+
+static int cbf_build_datablock (cbf_handle handle, cbf_node *datablock,
+                                                   unsigned int index);
+
   /* Create a handle */
 
 int cbf_make_handle (cbf_handle *handle)
@@ -316,6 +339,26 @@ int cbf_make_handle (cbf_handle *handle)
 
   (*handle)->startcolumn = 0;
 
+  (*handle)->image = NULL;
+
+  (*handle)->image_size = 0;
+
+  (*handle)->readonly = 0;
+
+  (*handle)->shared = NULL;
+
+  (*handle)->refcounts = NULL;
+
+  (*handle)->refcounts_size = 0;
+
+  (*handle)->validation = NULL;
+
+  (*handle)->lazy = NULL;
+
+  (*handle)->lazy_block = 0;
+
+  (*handle)->deferred = NULL;
+
   return 0;
 }
 
@@ -328,6 +371,29 @@ int cbf_set_cbf_logfile (cbf_handle handle, FILE * logfile)
 	return 0;
 }
 
+  /* Change the reference count of a handle.  Shared dictionaries are
+     attached and released from any thread, so this is atomic where
+     the compiler provides the means. */
+
+static int cbf_add_refcount (cbf_handle handle, int increment)
+{
+#if defined(__GNUC__) || defined(__clang__)
+
+  return __sync_add_and_fetch (&handle->refcount, increment);
+
+#elif defined(_MSC_VER)
+
+  return _InterlockedExchangeAdd ((volatile long *) &handle->refcount,
+                                                    increment) + increment;
+
+#else
+
+  return handle->refcount += increment;
+
+#endif
+}
+
+
   /* Free a handle */
 
 int cbf_free_handle (cbf_handle handle)
@@ -342,7 +408,7 @@ int cbf_free_handle (cbf_handle handle)
   
   memblock = (void *) handle;
 
-  if (handle && (--(handle->refcount) <= 0) )
+  if (handle && cbf_add_refcount (handle, -1) <= 0)
   {
     if (handle->dictionary) {
 
@@ -354,11 +420,42 @@ int cbf_free_handle (cbf_handle handle)
     }
     
     if( handle->commentfile) errorcode |= cbf_free_file (&(handle->commentfile));
+
+    errorcode |= cbf_free_validation_plan (handle);
+
+    errorcode |= cbf_free_lazy_index (handle);
+
+    cbf_release_deferred (handle);
+
+    if (handle->refcounts)
+
+      errorcode |= cbf_free ((void **) &handle->refcounts, &handle->refcounts_size);
+
+
+      /* A view leaves the tree to the dictionary it shares */
+
+    if (handle->shared) {
+
+      errorcode |= cbf_free_handle (handle->shared);
+
+      return errorcode | cbf_free (&memblock, NULL);
+
+    }
       
     errorcode |= cbf_find_parent (&node, handle->node, CBF_ROOT);
 
     if (!errorcode) errorcode |= cbf_free_node (node);
 
+    if (handle->image) {
+
+#ifndef _WIN32
+      munmap (handle->image, handle->image_size);
+#else
+      errorcode |= cbf_free (&handle->image, NULL);
+#endif
+
+    }
+
     return errorcode | cbf_free (&memblock, NULL);
   }
 
@@ -366,1613 +463,1766 @@ int cbf_free_handle (cbf_handle handle)
 }
 
 
-  /* Read a file or a wide file */
+  /* Lazy reads
 
-static int cbf_read_anyfile (cbf_handle handle, FILE *stream, int flags, const char * buffer, size_t buffer_size)
+     A read with CBF_PARSE_LAZY runs the lexer over the file once, with
+     binary sections skipped as in a header scan, and records where each
+     data block starts.  Each data block is entered in the tree empty and
+     is parsed from its start up to the next data block name when it is
+     first selected.  Files whose data blocks cannot be told apart this
+     way, with duplicate names or with items before the first data
+     block, and streams that cannot be repositioned are read in full. */
+
+typedef struct
 {
-  cbf_file *file;
+  cbf_node *datablock;        /* The empty data block, NULL once built */
 
-  cbf_node *node, *tnode;
+  long int offset;            /* Where its text starts                 */
 
-  void *parse [4];
+  unsigned int line;          /* The line there                        */
 
-  int errorcode;
-  
-  unsigned int children;
+  long int next;              /* The next name with the same hash,
+                                 while the file is being indexed       */
+}
+cbf_lazy_datablock;
 
-  const char *name;
+#define CBF_LAZY_HASH 1024
 
+struct cbf_lazy_index_struct
+{
+  cbf_file *file;             /* The file, kept connected              */
 
-    /* Check the arguments */
+  int flags;                  /* The flags of the read                 */
 
-  if (!handle) {
+  cbf_lazy_datablock *block;
 
-    if (stream)
-      fclose (stream);
-    
-    return CBF_ARGUMENT;
-    	
-  }
+  size_t blocks, blocks_size;
 
+  size_t unbuilt;             /* Data blocks still to be built         */
+};
 
-  if (((flags & (MSG_DIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN)) && (flags & MSG_NODIGEST))) {
 
-    if (stream)
-      fclose (stream);
-    
-    return CBF_ARGUMENT;
-    	
-  }
-  
-  if (!stream && (!buffer || !buffer_size))
-  
-    return CBF_ARGUMENT;
+  /* Free the lazy index of a handle.  Data blocks not yet built stay
+     empty */
 
+static int cbf_free_lazy_index (cbf_handle handle)
+{
+  cbf_lazy_index *lazy;
 
-    /* Delete the old datablocks */
-    
-  if( handle->commentfile) cbf_onfailnez (cbf_free_file (&(handle->commentfile)), fclose(stream));
+  int errorcode;
 
-  cbf_onfailnez (cbf_find_parent (&node, handle->node, CBF_ROOT), fclose(stream))
+  lazy = handle->lazy;
 
-  cbf_onfailnez (cbf_set_children (node, 0), if (stream) fclose(stream))
+  if (!lazy)
 
-  handle->node = node;
-  
-  cbf_onfailnez (cbf_reset_refcounts(handle->dictionary), if (stream) fclose(stream))
+    return 0;
 
+  handle->lazy = NULL;
 
-    /* Create the input file */
+  errorcode = cbf_delete_fileconnection (&lazy->file);
 
-  if (flags&CBF_PARSE_WIDE) {
-  	
-    cbf_onfailnez (cbf_make_widefile (&file, stream), if (stream) fclose(stream))
+  errorcode |= cbf_free ((void **) &lazy->block, &lazy->blocks_size);
 
-    file->logfile = handle->logfile;
-  
-  } else {
+  return errorcode | cbf_free ((void **) &lazy, NULL);
+}
 
-    cbf_onfailnez (cbf_make_file (&file, stream), if (stream) fclose(stream))
 
-    file->logfile = handle->logfile;
-  	
-  }
-  
-  handle->file = file;
-  
-  if (buffer && buffer_size != 0) {
-    
-    cbf_onfailnez (cbf_set_io_buffersize(file, buffer_size+1), if (stream) fclose(stream))
-    
-    memmove((void *)file->characters_base,(const void *)buffer,buffer_size);
-    
-    file->characters = file->characters_base;
-    
-    file->characters_used = buffer_size;
-    
-    if (stream) {
-    
-      file->characters[file->characters_used++] = '\n';
-    	
-    }
-    
-  }
+  /* Read the values a lazy read from another format has left null, at
+     the current row and column or all of them.  The source, such as an
+     HDF5 file, keeps them until they are needed */
 
+static int cbf_resolve_deferred (cbf_handle handle, int all)
+{
+  cbf_deferred_source *deferred;
 
-    /* Defaults */
+  deferred = handle->deferred;
 
-  if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN )) == 0)
+  if (!deferred || !deferred->resolve)
 
-    flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN));
+    return 0;
 
-  if (flags & (MSG_DIGESTNOW | MSG_DIGESTWARN) )
+  return deferred->resolve (handle, deferred->context, all);
+}
 
-    flags |= MSG_DIGEST;
 
-    /* Copy the flags */
+  /* Detach a handle from the source of its deferred values, when the
+     handle is freed or its tree replaced */
 
-  file->read_headers = flags;
+static void cbf_release_deferred (cbf_handle handle)
+{
+  cbf_deferred_source *deferred;
 
+  deferred = handle->deferred;
 
-    /* Parse the file */
+  handle->deferred = NULL;
 
-  parse [0] = file;
-  parse [1] = handle->node;
-  parse [2] = handle;
-  parse [3] = 0;
+  if (deferred && deferred->release)
 
-  errorcode = cbf_parse (parse);
+    deferred->release (handle, deferred->context);
+}
 
 
-    /* Validate the last category, save frame and data block and do
-       overall checks */
-  
-  cbf_failnez(cbf_validate(handle, handle->node, CBF_ROOT, (cbf_node *)NULL) )
+  /* Index the data blocks of a file.  indexed is cleared if the file
+     has to be read in full */
 
-    /* Delete the first datablock if it's empty */
+static int cbf_index_datablocks (cbf_handle handle, cbf_file *file,
+                                 int flags, int *indexed)
+{
+  cbf_lazy_index *lazy;
 
-  if (!errorcode)
-  {
-    errorcode = cbf_get_child (&tnode, node, 0);
+  cbf_lazy_datablock *block;
 
-    if (!errorcode)
-    {
-      errorcode = cbf_get_name (&name, tnode);
+  cbf_node *root, *node;
 
-      if (!errorcode && !name)
-      {
-        errorcode = cbf_count_children (&children, tnode);
+  YYSTYPE val;
 
-        if (!errorcode && !children)
+  FILE *logfile;
 
-          errorcode = cbf_free_node (tnode);
-      }
-    }
-    else
+  long int offset, hash [CBF_LAZY_HASH], probe;
 
-      if (errorcode == CBF_NOTFOUND)
+  const char *name;
 
-        errorcode = 0;
-  }
+  unsigned int line, hashcode;
 
-  cbf_onfailnez (cbf_find_parent (&node, handle->node, CBF_ROOT), cbf_delete_fileconnection (&file))
-  
-  errorcode = cbf_count_children (&children, node);
+  int token, errorcode, errors, warnings;
 
-  if (!errorcode && !children) {
+  *indexed = 0;
 
-    cbf_log(handle, "no data blocks found", CBF_LOGWARNING|CBF_LOGWOLINE);
-  	
-  }
-  
-    /* Disconnect the file */
-    
-  handle->file = NULL;
+  cbf_failnez (cbf_find_parent (&root, handle->node, CBF_ROOT))
 
-  return errorcode 
-    |(handle->errors?CBF_FORMAT:0)
-    | cbf_delete_fileconnection (&file);
-}
+  cbf_failnez (cbf_alloc ((void **) &lazy, NULL, sizeof (cbf_lazy_index), 1))
 
-  /* Read a file */
+  lazy->file = file;
 
-int cbf_read_file (cbf_handle handle, FILE *stream, int flags) 
-{
-	return cbf_read_anyfile (handle, stream, flags, NULL, 0);
-}
+  lazy->flags = flags;
 
-  /* Read a wide file */
+  lazy->block = NULL;
 
+  lazy->blocks = lazy->blocks_size = lazy->unbuilt = 0;
 
-int cbf_read_widefile (cbf_handle handle, FILE *stream, int flags) 
-{
-	return cbf_read_anyfile (handle, stream, flags|CBF_PARSE_WIDE, NULL, 0);
-}
+  for (hashcode = 0; hashcode < CBF_LAZY_HASH; hashcode++)
 
-  /* Read a pre-read buffered file */
-  
-int cbf_read_buffered_file (cbf_handle handle, FILE *stream, int flags, 
-                            const char * buffer, size_t buffer_len)
-{
-	return cbf_read_anyfile (handle, stream, flags, buffer, buffer_len);	
-}
+    hash [hashcode] = -1;
 
 
-  /* Write a file */
+    /* Lex quietly: anything worth reporting is reported when the data
+       block is built, or when the file is read in full */
 
-int cbf_write_file (cbf_handle handle, FILE *stream, int isbuffer,
-                                                     int ciforcbf,
-                                                     int flags,
-                                                     int encoding)
-{
-  cbf_file *file;
+  logfile = handle->logfile;
 
-  cbf_node *node;
+  errors = handle->errors;
 
-  int errorcode;
+  warnings = handle->warnings;
 
+  handle->logfile = file->logfile = NULL;
 
-    /* CIF or CBF? */
+  file->read_headers = ((flags | CBF_PARSE_SCAN) & ~(MSG_DIGEST | MSG_DIGESTNOW
+                                                  | MSG_DIGESTWARN | CBF_PARSE_WS))
+                                                  | MSG_NODIGEST;
 
-  if (ciforcbf == CIF) {
+  errorcode = 0;
 
-    encoding = encoding & ~ENC_NONE;
+  *indexed = 1;
 
-    if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_LFTERM;
+  while (!errorcode && *indexed)
+  {
+    val.text = NULL;
 
-  } else {
+    val.errorcode = 0;
 
-    encoding = (encoding & ~(ENC_BASE8   |
-                             ENC_BASE10  |
-                             ENC_BASE16  |
-                             ENC_BASE64  |
-                             ENC_BASE32K |
-                             ENC_QP      |
-                             ENC_FORWARD |
-                             ENC_BACKWARD)) | ENC_NONE;
-                             
-   if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_CRTERM|ENC_LFTERM;
+    token = cbf_lex (handle, &val);
 
-  	
-  }
+    if (token == 0)
 
+      break;
 
-    /* Check the arguments */
+    if (token == ERROR)
 
-  if (!handle)
+      *indexed = 0;
 
-    return CBF_ARGUMENT;
+    else
 
-  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
-      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
+      if (token == DATA)
+      {
+        for (hashcode = 0, name = val.text; *name; name++)
 
-    return CBF_ARGUMENT;
+          hashcode = hashcode * 31 + toupper ((unsigned char) *name);
 
+        hashcode %= CBF_LAZY_HASH;
 
-  if (((encoding & ENC_NONE)    > 0) +
-      ((encoding & ENC_BASE8)   > 0) +
-      ((encoding & ENC_BASE10)  > 0) +
-      ((encoding & ENC_BASE16)  > 0) +
-      ((encoding & ENC_BASE64)  > 0) +
-      ((encoding & ENC_BASE32K) > 0) +
-      ((encoding & ENC_QP)      > 0) > 1)
+        for (probe = hash [hashcode]; probe >= 0; probe = lazy->block [probe].next)
 
-    return CBF_ARGUMENT;
+          if (!cbf_cistrcmp (lazy->block [probe].datablock->name, val.text))
 
+            break;
 
-    /* Find the root node */
+        if (probe >= 0)
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+          *indexed = 0;
 
+        else
+        {
+            /* The lexer has read the name and the character after it,
+               so the block starts there or at the character before */
 
-    /* Create the file */
+          errorcode = cbf_get_fileposition (file, &offset);
 
-  cbf_failnez (cbf_make_file (&file, stream))
+          offset -= (long int) strlen (val.text) + 6;
 
-  file->logfile = handle->logfile;
+          if (offset < 0)
 
+            offset = 0;
 
-    /* Defaults */
+          line = file->line;
 
-  if (flags & (MSG_DIGEST | MSG_DIGESTNOW))
+          if (file->last_read == '\n' || file->last_read == '\r')
 
-    flags |= MIME_HEADERS;
+            line--;
 
-  else
+          if (lazy->blocks >= lazy->blocks_size)
 
-    if ((flags & (MIME_HEADERS | PLAIN_HEADERS)) == 0)
+            errorcode = cbf_realloc ((void **) &lazy->block, &lazy->blocks_size,
+                                     sizeof (cbf_lazy_datablock),
+                                     lazy->blocks_size * 2 + 64);
 
-      flags |= (HDR_DEFAULT & (MIME_HEADERS | PLAIN_HEADERS));
+          if (!errorcode)
 
-  if (flags & PLAIN_HEADERS)
+            errorcode = cbf_make_new_child (&node, root, CBF_DATABLOCK, val.text);
 
-    flags |= MSG_NODIGEST;
+          if (!errorcode)
+          {
+            val.text = NULL;
 
-  else
+            block = lazy->block + lazy->blocks++;
 
-    if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW)) == 0)
+            block->datablock = node;
 
-      flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW));
+            block->offset = offset;
 
-  if (flags & MSG_DIGESTNOW)
+            block->line = line;
 
-    flags |= MSG_DIGEST;
+            block->next = hash [hashcode];
 
+            hash [hashcode] = (long int) (lazy->blocks - 1);
+          }
+        }
+      }
+      else
 
-  if ((encoding & (ENC_NONE    |
-                   ENC_BASE8   |
-                   ENC_BASE10  |
-                   ENC_BASE16  |
-                   ENC_BASE64  |
-                   ENC_BASE32K |
-                   ENC_QP)) == 0)
+        if (!lazy->blocks && token != COMMENT)
 
-    encoding |= (ENC_DEFAULT & (ENC_NONE    |
-                                ENC_BASE8   |
-                                ENC_BASE10  |
-                                ENC_BASE16  |
-                                ENC_BASE64  |
-                                ENC_BASE32K |
-                                ENC_QP));
+          *indexed = 0;
 
-  if ((encoding & (ENC_CRTERM | ENC_LFTERM)) == 0)
+    if (val.text)
+    {
+      if (token == BINARY)
+      {
+        void *binary_file = NULL;
 
-    encoding |= (ENC_DEFAULT & (ENC_CRTERM | ENC_LFTERM));
+        sscanf (val.text + 1, " %*x %p", &binary_file);
 
-  if ((encoding & (ENC_FORWARD | ENC_BACKWARD)) == 0)
+        if (binary_file)
+        {
+          cbf_file *connection = (cbf_file *) binary_file;
 
-    encoding |= (ENC_DEFAULT & (ENC_FORWARD | ENC_BACKWARD));
+          errorcode |= cbf_delete_fileconnection (&connection);
+        }
+      }
 
+      cbf_free_text (&val.text, NULL);
+    }
+  }
 
-    /* Copy the flags */
+  handle->logfile = file->logfile = logfile;
 
-  file->write_headers  = flags;
-  file->write_encoding = encoding;
-  
-    /* Reset the reference counts */
-    
- cbf_failnez( cbf_reset_refcounts(handle->dictionary) )
+  handle->errors = errors;
 
+  handle->warnings = warnings;
 
-    /* Write the file */
+  if (!lazy->blocks)
 
-  errorcode = cbf_write_node (handle, node, file, isbuffer);
+    *indexed = 0;
 
+  if (errorcode || !*indexed)
+  {
+    *indexed = 0;
 
-    /* Free the file structure but don't close the file? */
+    errorcode |= cbf_set_children (root, 0);
 
-  if (!isbuffer)
+    errorcode |= cbf_free ((void **) &lazy->block, &lazy->blocks_size);
 
-    file->stream = NULL;
+    return errorcode | cbf_free ((void **) &lazy, NULL);
+  }
 
+  lazy->unbuilt = lazy->blocks;
 
-    /* Disconnect the file */
+  cbf_onfailnez (cbf_add_fileconnection (&file, NULL),
+                 cbf_free ((void **) &lazy->block, &lazy->blocks_size);
+                 cbf_free ((void **) &lazy, NULL))
 
-  return errorcode | cbf_delete_fileconnection (&file);
+  handle->lazy = lazy;
+
+  return 0;
 }
 
 
-  /* Write a file, starting from the local node */
+  /* Build one data block of a lazy read */
 
-int cbf_write_local_file (cbf_handle handle, FILE *stream, int isbuffer,
-                                                     int ciforcbf,
-                                                     int flags,
-                                                     int encoding)
+static int cbf_build_lazy_block (cbf_handle handle, cbf_lazy_datablock *block)
 {
-  cbf_file *file;
+  cbf_lazy_index *lazy;
 
-  cbf_node *node;
+  cbf_node *datablock, *root, *parsed, *current;
 
-  int errorcode;
+  cbf_file *file;
 
+  void *parse [4];
 
-    /* CIF or CBF? */
+  int errorcode, errors;
 
-  if (ciforcbf == CIF) {
+  lazy = handle->lazy;
 
-    encoding = encoding & ~ENC_NONE;
+  file = lazy->file;
 
-      if ((encoding &(ENC_CRTERM | ENC_LFTERM))==0 ) encoding |= ENC_LFTERM;
+  datablock = block->datablock;
 
-  } else {
+  cbf_failnez (cbf_find_parent (&root, datablock, CBF_ROOT))
 
-    encoding = (encoding & ~(ENC_BASE8   |
-                             ENC_BASE10  |
-                             ENC_BASE16  |
-                             ENC_BASE64  |
-                             ENC_BASE32K |
-                             ENC_QP      |
-                             ENC_FORWARD |
-                             ENC_BACKWARD)) | ENC_NONE;
-                             
-   if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_CRTERM|ENC_LFTERM;
 
-  	
-  }
+    /* Parse the data block into a tree of its own */
 
+  cbf_failnez (cbf_set_fileposition (file, block->offset, SEEK_SET))
 
-    /* Check the arguments */
+  cbf_failnez (cbf_make_node (&parsed, CBF_ROOT, root->context, NULL))
 
-  if (!handle)
+  file->line = block->line;
 
-    return CBF_ARGUMENT;
+  file->column = 0;
 
-  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
-      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
+  file->last_read = '\n';
 
-    return CBF_ARGUMENT;
+  file->read_headers = lazy->flags;
 
+  errors = handle->errors;
 
-  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
-      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
-  
-    return CBF_ARGUMENT;
+  current = handle->node;
 
+  handle->node = parsed;
 
-  if (((encoding & ENC_NONE)    > 0) +
-      ((encoding & ENC_BASE8)   > 0) +
-      ((encoding & ENC_BASE10)  > 0) +
-      ((encoding & ENC_BASE16)  > 0) +
-      ((encoding & ENC_BASE64)  > 0) +
-      ((encoding & ENC_BASE32K) > 0) +
-      ((encoding & ENC_QP)      > 0) > 1)
+  handle->file = file;
 
-    return CBF_ARGUMENT;
+  handle->lazy_block = 1;
 
+  errorcode = cbf_reset_refcounts (handle->dictionary);
 
+  if (!errorcode)
+  {
+    parse [0] = file;
+    parse [1] = parsed;
+    parse [2] = handle;
+    parse [3] = 0;
 
-    /* Create the file */
+    errorcode = cbf_parse (parse);
+  }
 
-  cbf_failnez (cbf_make_file (&file, stream))
+  if (!errorcode)
 
-  file->logfile = handle->logfile;
+    errorcode = cbf_validate (handle, handle->node, CBF_ROOT, (cbf_node *) NULL);
 
-    /* Defaults */
+  errorcode |= cbf_free_validation_plan (handle);
 
-  if (flags & (MSG_DIGEST | MSG_DIGESTNOW))
+  handle->lazy_block = 0;
 
-    flags |= MIME_HEADERS;
+  handle->file = NULL;
 
-  else
+  handle->node = current;
 
-    if ((flags & (MIME_HEADERS | PLAIN_HEADERS)) == 0)
 
-      flags |= (HDR_DEFAULT & (MIME_HEADERS | PLAIN_HEADERS));
+    /* Move its contents into the empty data block */
 
-  if (flags & PLAIN_HEADERS)
+  if (!errorcode)
+  {
+    errorcode = cbf_find_child (&current, parsed, datablock->name);
 
-    flags |= MSG_NODIGEST;
+    if (!errorcode)
 
-  else
+      errorcode = cbf_move_children (datablock, current);
+  }
 
-    if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW)) == 0)
+  errorcode |= cbf_free_node (parsed);
 
-      flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW));
+  if (errorcode)
 
-  if (flags & MSG_DIGESTNOW)
+    return errorcode;
 
-    flags |= MSG_DIGEST;
+  block->datablock = NULL;
 
-  if ((encoding & (ENC_NONE    |
-                   ENC_BASE8   |
-                   ENC_BASE10  |
-                   ENC_BASE16  |
-                   ENC_BASE64  |
-                   ENC_BASE32K |
-                   ENC_QP)) == 0)
+  lazy->unbuilt--;
 
-    encoding |= (ENC_DEFAULT & (ENC_NONE    |
-                                ENC_BASE8   |
-                                ENC_BASE10  |
-                                ENC_BASE16  |
-                                ENC_BASE64  |
-                                ENC_BASE32K |
-                                ENC_QP));
+  return handle->errors > errors ? CBF_FORMAT : 0;
+}
 
-  if ((encoding & (ENC_CRTERM | ENC_LFTERM)) == 0)
 
-    encoding |= (ENC_DEFAULT & (ENC_CRTERM | ENC_LFTERM));
+  /* Build a data block of a lazy read if it has not been built.  index
+     is where to look first in the index */
 
-  if ((encoding & (ENC_FORWARD | ENC_BACKWARD)) == 0)
+static int cbf_build_datablock (cbf_handle handle, cbf_node *datablock,
+                                                   unsigned int index)
+{
+  cbf_lazy_index *lazy;
 
-    encoding |= (ENC_DEFAULT & (ENC_FORWARD | ENC_BACKWARD));
+  size_t block;
 
+  lazy = handle->lazy;
 
-    /* Copy the flags */
+  if (!lazy || !datablock)
 
-  file->write_headers  = flags;
-  file->write_encoding = encoding;
+    return 0;
 
-  node = handle->node;
+  if (index < lazy->blocks && lazy->block [index].datablock == datablock)
 
-    /* Write the file */
+    return cbf_build_lazy_block (handle, lazy->block + index);
 
-  errorcode = cbf_write_node (handle, node, file, isbuffer);
+  for (block = 0; block < lazy->blocks; block++)
 
+    if (lazy->block [block].datablock == datablock)
 
-    /* Free the file structure but don't close the file? */
+      return cbf_build_lazy_block (handle, lazy->block + block);
 
-  if (!isbuffer)
+  return 0;
+}
 
-    file->stream = NULL;
 
+  /* Build every data block of a lazy read that has not been built */
 
-    /* Disconnect the file */
+int cbf_build_datablocks (cbf_handle handle)
+{
+  cbf_lazy_index *lazy;
 
-  return errorcode | cbf_delete_fileconnection (&file);
-}
+  size_t block;
 
+  lazy = handle->lazy;
 
+  if (!lazy)
 
-  /* Write a wide file */
+    return 0;
 
-int cbf_write_widefile (cbf_handle handle, FILE *stream, int isbuffer,
-                                                     int ciforcbf,
-                                                     int flags,
-                                                     int encoding)
-{
-  cbf_file *file;
+  for (block = 0; block < lazy->blocks && lazy->unbuilt; block++)
 
-  cbf_node *node;
+    if (lazy->block [block].datablock)
 
-  int errorcode;
+      cbf_failnez (cbf_build_lazy_block (handle, lazy->block + block))
 
+  return cbf_free_lazy_index (handle);
+}
 
-    /* CIF or CBF? */
 
-  if (ciforcbf == CIF) {
+  /* Read a file or a wide file */
 
-    encoding = encoding & ~ENC_NONE;
+static int cbf_read_anyfile (cbf_handle handle, FILE *stream, int flags, const char * buffer, size_t buffer_size)
+{
+  cbf_file *file;
 
-    if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_LFTERM;
+  cbf_node *node, *tnode;
 
-  } else {
+  void *parse [4];
 
-    encoding = (encoding & ~(ENC_BASE8   |
-                             ENC_BASE10  |
-                             ENC_BASE16  |
-                             ENC_BASE64  |
-                             ENC_BASE32K |
-                             ENC_QP      |
-                             ENC_FORWARD |
-                             ENC_BACKWARD)) | ENC_NONE;
-                             
-   if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_CRTERM|ENC_LFTERM;
+  int errorcode;
+  
+  unsigned int children;
+
+  const char *name;
 
-  	
-  }
 
     /* Check the arguments */
 
-  if (!handle)
+  if (!handle) {
 
+    if (stream)
+      fclose (stream);
+    
     return CBF_ARGUMENT;
+    	
+  }
 
-  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
-      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
 
-    return CBF_ARGUMENT;
+  if (((flags & (MSG_DIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN)) && (flags & MSG_NODIGEST))) {
 
+    if (stream)
+      fclose (stream);
+    
+    return CBF_ARGUMENT;
+    	
+  }
+  
+  if (!stream && (!buffer || !buffer_size))
+  
+    return CBF_ARGUMENT;
 
-  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
-      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
-      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
 
-    return CBF_ARGUMENT;
+    /* Delete the old datablocks */
     
+  if( handle->commentfile) cbf_onfailnez (cbf_free_file (&(handle->commentfile)), fclose(stream));
 
-  if (((encoding & ENC_NONE)    > 0) +
-      ((encoding & ENC_BASE8)   > 0) +
-      ((encoding & ENC_BASE10)  > 0) +
-      ((encoding & ENC_BASE16)  > 0) +
-      ((encoding & ENC_BASE64)  > 0) +
-      ((encoding & ENC_BASE32K) > 0) +
-      ((encoding & ENC_QP)      > 0) > 1)
-
-    return CBF_ARGUMENT;
+  cbf_release_deferred (handle);
 
+  cbf_onfailnez (cbf_find_parent (&node, handle->node, CBF_ROOT), fclose(stream))
 
-    /* Find the root node */
-
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+  cbf_onfailnez (cbf_set_children (node, 0), if (stream) fclose(stream))
 
+  handle->node = node;
+  
+  cbf_onfailnez (cbf_reset_refcounts(handle->dictionary), if (stream) fclose(stream))
 
-    /* Create the file */
+  cbf_onfailnez (cbf_free_validation_plan(handle), if (stream) fclose(stream))
 
-  cbf_failnez (cbf_make_widefile (&file, stream))
+  cbf_onfailnez (cbf_free_lazy_index(handle), if (stream) fclose(stream))
 
 
-    /* Defaults */
+    /* Create the input file */
 
-  if (flags & (MSG_DIGEST | MSG_DIGESTNOW))
+  if (flags&CBF_PARSE_WIDE) {
+  	
+    cbf_onfailnez (cbf_make_widefile (&file, stream), if (stream) fclose(stream))
 
-    flags |= MIME_HEADERS;
+    file->logfile = handle->logfile;
+  
+  } else {
 
-  else
+    cbf_onfailnez (cbf_make_file (&file, stream), if (stream) fclose(stream))
 
-    if ((flags & (MIME_HEADERS | PLAIN_HEADERS)) == 0)
+    file->logfile = handle->logfile;
+  	
+  }
+  
+  handle->file = file;
+  
+  if (buffer && buffer_size != 0) {
+    
+    cbf_onfailnez (cbf_set_io_buffersize(file, buffer_size+1), if (stream) fclose(stream))
+    
+    memmove((void *)file->characters_base,(const void *)buffer,buffer_size);
+    
+    file->characters = file->characters_base;
+    
+    file->characters_used = buffer_size;
+    
+    if (stream) {
+    
+      file->characters[file->characters_used++] = '\n';
+    	
+    }
+    
+  }
 
-      flags |= (HDR_DEFAULT & (MIME_HEADERS | PLAIN_HEADERS));
 
-  if (flags & PLAIN_HEADERS)
+    /* Defaults.  A header scan never reads a binary section, so it
+       cannot check digests */
 
-    flags |= MSG_NODIGEST;
+  if (flags & CBF_PARSE_SCAN)
 
-  else
+    flags = (flags & ~(MSG_DIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN)) | MSG_NODIGEST;
 
-    if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW)) == 0)
+  if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN )) == 0)
 
-      flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW));
+    flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN));
 
-  if (flags & MSG_DIGESTNOW)
+  if (flags & (MSG_DIGESTNOW | MSG_DIGESTWARN) )
 
     flags |= MSG_DIGEST;
 
-  if ((encoding & (ENC_NONE    |
-                   ENC_BASE8   |
-                   ENC_BASE10  |
-                   ENC_BASE16  |
-                   ENC_BASE64  |
-                   ENC_BASE32K |
-                   ENC_QP)) == 0)
+    /* Copy the flags */
 
-    encoding |= (ENC_DEFAULT & (ENC_NONE    |
-                                ENC_BASE8   |
-                                ENC_BASE10  |
-                                ENC_BASE16  |
-                                ENC_BASE64  |
-                                ENC_BASE32K |
-                                ENC_QP));
+  file->read_headers = flags;
 
-  if ((encoding & (ENC_CRTERM | ENC_LFTERM)) == 0)
 
-    encoding |= (ENC_DEFAULT & (ENC_CRTERM | ENC_LFTERM));
+    /* A lazy read only indexes the data blocks, unless the file has to
+       be read in full after all */
 
-  if ((encoding & (ENC_FORWARD | ENC_BACKWARD)) == 0)
+  if ((flags & CBF_PARSE_LAZY) && !buffer) {
 
-    encoding |= (ENC_DEFAULT & (ENC_FORWARD | ENC_BACKWARD));
+    long int start;
 
+    int indexed;
 
-    /* Copy the flags */
+    unsigned int line, column;
 
-  file->write_headers  = flags;
-  file->write_encoding = encoding;
+    line = file->line;
 
+    column = file->column;
 
-    /* Write the file */
+    indexed = 0;
 
-  errorcode = cbf_write_node (handle, node, file, isbuffer);
+    errorcode = cbf_get_fileposition (file, &start);
 
+    if (!errorcode)
 
-    /* Free the file structure but don't close the file? */
+      errorcode = cbf_index_datablocks (handle, file, flags & ~CBF_PARSE_LAZY, &indexed);
 
-  if (!isbuffer)
+    if (!errorcode && !indexed) {
 
-    file->stream = NULL;
+      errorcode = cbf_set_fileposition (file, start, SEEK_SET);
 
+      file->line = line;
 
-    /* Disconnect the file */
+      file->column = column;
 
-  return errorcode | cbf_delete_fileconnection (&file);
-}
+      file->last_read = '\0';
 
+      file->read_headers = flags & ~CBF_PARSE_LAZY;
 
-  /* Add a data block */
+    }
 
-int cbf_new_datablock (cbf_handle handle, const char *datablockname)
-{
-  cbf_node *node;
+    if (errorcode || indexed) {
 
-  int errorcode;
+      handle->file = NULL;
 
-  if (!handle)
+      return errorcode | cbf_delete_fileconnection (&file);
 
-    return CBF_ARGUMENT;
+    }
 
+  }
 
-    /* Find the root node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+    /* Parse the file */
 
+  parse [0] = file;
+  parse [1] = handle->node;
+  parse [2] = handle;
+  parse [3] = 0;
 
-    /* Copy the name */
+  errorcode = cbf_parse (parse);
 
-  if (datablockname)
-  {
-    datablockname = cbf_copy_string (NULL, datablockname, 0);
 
-    if (!datablockname)
+    /* Validate the last category, save frame and data block and do
+       overall checks */
+  
+  cbf_failnez(cbf_validate(handle, handle->node, CBF_ROOT, (cbf_node *)NULL) )
 
-      return CBF_ALLOC;
-  }
+  cbf_failnez(cbf_free_validation_plan(handle))
 
+    /* Delete the first datablock if it's empty */
 
-    /* Add a datablock */
+  if (!errorcode)
+  {
+    errorcode = cbf_get_child (&tnode, node, 0);
 
-  errorcode = cbf_make_child (&node, node, CBF_DATABLOCK, datablockname);
+    if (!errorcode)
+    {
+      errorcode = cbf_get_name (&name, tnode);
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, datablockname);
+      if (!errorcode && !name)
+      {
+        errorcode = cbf_count_children (&children, tnode);
 
-    return errorcode;
-  }
+        if (!errorcode && !children)
 
+          errorcode = cbf_free_node (tnode);
+      }
+    }
+    else
 
-    /* Success */
+      if (errorcode == CBF_NOTFOUND)
 
-  handle->node = node;
+        errorcode = 0;
+  }
 
-  return 0;
-}
+  cbf_onfailnez (cbf_find_parent (&node, handle->node, CBF_ROOT), cbf_delete_fileconnection (&file))
+  
+  errorcode = cbf_count_children (&children, node);
 
+  if (!errorcode && !children) {
 
-  /* Add a save frame */
+    cbf_log(handle, "no data blocks found", CBF_LOGWARNING|CBF_LOGWOLINE);
+  	
+  }
+  
+    /* Disconnect the file */
+    
+  handle->file = NULL;
 
-int cbf_new_saveframe (cbf_handle handle, const char *saveframename)
-{
-  cbf_node *node;
+  return errorcode 
+    |(handle->errors?CBF_FORMAT:0)
+    | cbf_delete_fileconnection (&file);
+}
 
-  int errorcode;
+  /* Read a file */
 
-  if (!handle)
+int cbf_read_file (cbf_handle handle, FILE *stream, int flags) 
+{
+	return cbf_read_anyfile (handle, stream, flags, NULL, 0);
+}
 
-    return CBF_ARGUMENT;
+  /* Read a wide file */
 
 
-    /* Find the root node */
+int cbf_read_widefile (cbf_handle handle, FILE *stream, int flags) 
+{
+	return cbf_read_anyfile (handle, stream, flags|CBF_PARSE_WIDE, NULL, 0);
+}
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  /* Read a pre-read buffered file */
+  
+int cbf_read_buffered_file (cbf_handle handle, FILE *stream, int flags, 
+                            const char * buffer, size_t buffer_len)
+{
+	return cbf_read_anyfile (handle, stream, flags, buffer, buffer_len);	
+}
 
 
-    /* Copy the name */
+  /* Interpret the value returned by a cbf_read_stream callback */
 
-  if (saveframename)
+static int cbf_stream_result (int result, int *skip, int *stop)
+{
+  if (result == CBF_STREAM_SKIP)
   {
-    saveframename = cbf_copy_string (NULL, saveframename, 0);
+    if (skip)
 
-    if (!saveframename)
+      *skip = 1;
 
-      return CBF_ALLOC;
+    return 0;
   }
 
-
-    /* Add a save frame */
-
-  errorcode = cbf_make_child (&node, node, CBF_SAVEFRAME, saveframename);
-
-  if (errorcode)
+  if (result == CBF_STREAM_STOP)
   {
-    cbf_free_string (NULL, saveframename);
+    *stop = 1;
 
-    return errorcode;
+    return 0;
   }
 
+  return result;
+}
 
-    /* Success */
-
-  handle->node = node;
 
-  return 0;
-}
+  /* Parse a file, reporting its contents to callbacks without building
+     the tree.
 
+     The file is read token by token with the same lexer as cbf_read_file,
+     so memory use does not grow with the size of the file.  Events are
+     reported in file order: data blocks, save frames (with a NULL name at
+     the closing save_), categories (whenever the category changes),
+     columns, loops, loop rows, and values with the index of their column
+     in the loop or category.  Binary sections are reported with their
+     parameters and skipped.
 
-  /* Add a data block, allowing for duplicates */
+     A callback may return CBF_STREAM_SKIP to suppress the events inside
+     what it announced (the rest of a data block, save frame, category,
+     loop or loop row, or the values of a column), CBF_STREAM_STOP to end
+     the parse successfully, or any other non-zero value to end the parse
+     with that error.  The stream is closed, as with cbf_read_file.  The
+     datablocks in the handle are left alone. */
 
-int cbf_force_new_datablock (cbf_handle handle, const char *datablockname)
+int cbf_read_stream (cbf_handle handle, FILE *stream, int flags,
+                     const cbf_stream_callbacks *callbacks, void *context)
 {
-  cbf_node *node;
+  cbf_file *file;
 
-  int errorcode;
+  YYSTYPE val;
 
-  if (!handle)
+  int token, errorcode, errors, stop, define, inloop, named;
 
-    return CBF_ARGUMENT;
+  int skip_block, skip_frame, skip_category, skip_loop, skip_row, skip_column;
 
+  int *skip_columns;
 
-    /* Find the root node */
+  size_t skip_columns_size;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+  unsigned int columns, values, column;
 
+  const char *category, *pending, *typeofvalue;
 
-    /* Copy the name */
+  const cbf_stream_callbacks nocallbacks = { NULL };
 
-  if (datablockname)
-  {
-    datablockname = cbf_copy_string (NULL, datablockname, 0);
 
-    if (!datablockname)
+    /* Check the arguments */
 
-      return CBF_ALLOC;
-  }
+  if (!handle || !stream) {
+
+    if (stream)
+      fclose (stream);
 
+    return CBF_ARGUMENT;
 
-    /* Add a datablock */
+  }
 
-  errorcode = cbf_make_new_child (&node, node, CBF_DATABLOCK, datablockname);
+  if (((flags & (MSG_DIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN)) && (flags & MSG_NODIGEST))) {
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, datablockname);
+    fclose (stream);
+
+    return CBF_ARGUMENT;
 
-    return errorcode;
   }
 
+  if (!callbacks)
 
-    /* Success */
+    callbacks = &nocallbacks;
 
-  handle->node = node;
 
-  return 0;
-}
+    /* Create the input file */
 
+  if (flags&CBF_PARSE_WIDE) {
 
-  /* Add a save frame, allowing for duplicates */
+    cbf_onfailnez (cbf_make_widefile (&file, stream), fclose(stream))
 
-int cbf_force_new_saveframe (cbf_handle handle, const char *saveframename)
-{
-  cbf_node *node;
+  } else {
 
-  int errorcode;
+    cbf_onfailnez (cbf_make_file (&file, stream), fclose(stream))
 
-  if (!handle)
+  }
 
-    return CBF_ARGUMENT;
+  file->logfile = handle->logfile;
 
+  handle->file = file;
 
-    /* Find the DATABLOCK */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+    /* Defaults.  Whitespace is not kept, since nothing would consume it */
 
+  if (flags & CBF_PARSE_SCAN)
 
-    /* Copy the name */
-
-  if (saveframename)
-  {
-    saveframename = cbf_copy_string (NULL, saveframename, 0);
-
-    if (!saveframename)
-
-      return CBF_ALLOC;
-  }
-
-
-    /* Add a save frame */
-
-  errorcode = cbf_make_new_child (&node, node, CBF_SAVEFRAME, saveframename);
-
-  if (errorcode)
-  {
-    cbf_free_string (NULL, saveframename);
-
-    return errorcode;
-  }
+    flags = (flags & ~(MSG_DIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN)) | MSG_NODIGEST;
 
+  if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN )) == 0)
 
-    /* Success */
-
-  handle->node = node;
+    flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW | MSG_DIGESTWARN));
 
-  return 0;
-}
+  if (flags & (MSG_DIGESTNOW | MSG_DIGESTWARN) )
 
+    flags |= MSG_DIGEST;
 
-  /* Add a category to the current data block or save frame*/
+  file->read_headers = flags & ~CBF_PARSE_WS;
 
-int cbf_new_category (cbf_handle handle, const char *categoryname)
-{
-  cbf_node *node;
 
-  int errorcode;
+    /* Report the tokens */
 
-  if (!handle)
+  errorcode = 0;
 
-    return CBF_ARGUMENT;
+  errors = handle->errors;
 
+  stop = define = inloop = named = 0;
 
-    /* Find the save frame or data block node */
+  skip_block = skip_frame = skip_category = skip_loop = skip_row = skip_column = 0;
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
+  skip_columns = NULL;
 
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  skip_columns_size = 0;
 
-  }
+  columns = values = 0;
 
-    /* Copy the name */
+  category = pending = NULL;
 
-  if (categoryname)
+  while (!errorcode && !stop)
   {
-    categoryname = cbf_copy_string (NULL, categoryname, 0);
+    val.text = NULL;
 
-    if (!categoryname)
+    val.errorcode = 0;
 
-      return CBF_ALLOC;
-  }
+    token = cbf_lex (handle, &val);
 
+    if (token == ERROR)
+    {
+      errorcode = val.errorcode ? val.errorcode : CBF_FORMAT;
 
-    /* Add a category */
+      break;
+    }
 
-  errorcode = cbf_make_child (&node, node, CBF_CATEGORY, categoryname);
+    if (token == 0)
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, categoryname);
+      break;
 
-    return errorcode;
-  }
+    switch (token)
+    {
+      case DATA:
+      case SAVE:
+      case SAVEEND:
+      case LOOP:
 
+          /* Each of these ends any loop and category */
 
-    /* Success */
+        inloop = named = define = 0;
 
-  handle->node = node;
+        columns = values = 0;
 
-  return 0;
-}
+        skip_category = skip_loop = skip_row = skip_column = 0;
 
+        if (category)
 
-  /* Add a category to the current data block, allowing for duplicates */
+          cbf_free_text (&category, NULL);
 
-int cbf_force_new_category (cbf_handle handle, const char *categoryname)
-{
-  cbf_node *node;
+        if (token == DATA)
+        {
+          skip_block = skip_frame = 0;
 
-  int errorcode;
+          if (callbacks->datablock)
 
-  if (!handle)
+            errorcode = cbf_stream_result (callbacks->datablock (context, val.text),
+                                           &skip_block, &stop);
+        }
+        else
 
-    return CBF_ARGUMENT;
+          if (token == LOOP)
+          {
+            inloop = 1;
 
+            if (!skip_block && !skip_frame && callbacks->loop)
 
-    /* Find the data block node */
+              errorcode = cbf_stream_result (callbacks->loop (context),
+                                             &skip_loop, &stop);
+          }
+          else
+          {
+            int skipped = skip_frame;
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
+            skip_frame = 0;
 
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+            if (!skip_block && !(token == SAVEEND && skipped) && callbacks->saveframe)
 
-  }
+              errorcode = cbf_stream_result (callbacks->saveframe (context,
+                                             token == SAVE ? val.text : NULL),
+                                             token == SAVE ? &skip_frame : NULL, &stop);
+          }
 
-    /* Copy the name */
+        break;
 
-  if (categoryname)
-  {
-    categoryname = cbf_copy_string (NULL, categoryname, 0);
+      case CATEGORY:
 
-    if (!categoryname)
+          /* Wait for the column */
 
-      return CBF_ALLOC;
-  }
+        if (pending)
 
+          cbf_free_text (&pending, NULL);
 
-    /* Add a category */
+        pending = val.text;
 
-  errorcode = cbf_make_new_child (&node, node, CBF_CATEGORY, categoryname);
+        val.text = NULL;
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, categoryname);
+        break;
 
-    return errorcode;
-  }
+      case COLUMN:
+      case ITEM:
 
+          /* A name after the values of a loop starts new items, which
+             number their columns afresh under a new category event */
 
-    /* Success */
+        if (inloop && values)
+        {
+          inloop = 0;
 
-  handle->node = node;
+          columns = values = 0;
 
-  return 0;
-}
+          skip_loop = skip_row = 0;
 
+          if (category)
 
-  /* Add a column to the current category */
+            cbf_free_text (&category, NULL);
+        }
 
-int cbf_new_column (cbf_handle handle, const char *columnname)
-{
-  cbf_node *node;
+        if (token == ITEM)
+        {
+          if (pending)
 
-  int errorcode;
+            cbf_free_text (&pending, NULL);
 
-  unsigned int rows;
+          pending = cbf_copy_string (NULL, val.text, 0);
 
-  if (!handle)
+          if (!pending)
+          {
+            errorcode = CBF_ALLOC;
 
-    return CBF_ARGUMENT;
+            break;
+          }
+        }
 
+        if (!pending)
+        {
+          cbf_log (handle, "column name without a category", CBF_LOGERROR|CBF_LOGSTARTLOC);
 
-    /* Find the category node */
+          break;
+        }
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
+          /* Has the category changed? */
 
-    /* How many rows does this category have? */
+        if (!category || cbf_cistrcmp (category, pending))
+        {
+          if (category)
 
-  cbf_failnez (cbf_count_rows (handle, &rows))
+            cbf_free_text (&category, NULL);
 
+          category = pending;
 
-    /* Copy the name */
+          skip_category = 0;
 
-  if (columnname)
-  {
-    columnname = cbf_copy_string (NULL, columnname, 0);
+          if (!inloop)
 
-    if (!columnname)
+            columns = 0;
 
-      return CBF_ALLOC;
-  }
+          if (!skip_block && !skip_frame && !skip_loop && callbacks->category)
 
+            errorcode = cbf_stream_result (callbacks->category (context, category),
+                                           &skip_category, &stop);
+        }
+        else
 
-    /* Add a column */
+          cbf_free_text (&pending, NULL);
 
-  errorcode = cbf_make_child (&node, node, CBF_COLUMN, columnname);
+        pending = NULL;
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, columnname);
+        if (errorcode || stop)
 
-    return errorcode;
-  }
+          break;
 
 
-    /* Set the number of rows */
+          /* Report the column */
 
-  errorcode = cbf_set_children (node, rows);
+        skip_column = 0;
 
-  if (errorcode)
+        if (!skip_block && !skip_frame && !skip_loop && !skip_category && callbacks->column)
 
-    return errorcode | cbf_free_node (node);
+          errorcode = cbf_stream_result (callbacks->column (context, val.text),
+                                         &skip_column, &stop);
 
+        skip_column = skip_column || skip_category;
 
-    /* Success */
+        if (inloop)
+        {
+          if (columns >= skip_columns_size)
+          {
+            errorcode = cbf_realloc ((void **) &skip_columns, &skip_columns_size,
+                                     sizeof (int), columns * 2 + 16);
 
-  handle->node = node;
+            if (errorcode)
 
-  handle->row = 0;
+              break;
+          }
 
-  handle->search_row = 0;
+          skip_columns [columns] = skip_column;
+        }
 
-  return 0;
-}
+        columns++;
 
+        named = 1;
 
-  /* Add a row to the current category */
+        break;
 
-int cbf_new_row (cbf_handle handle)
-{
-  cbf_node *node, *columnnode;
+      case DEFINE:
 
-  int errorcode [2];
+          /* Functions are not reported; drop the definition */
 
-  unsigned int rows, columns, column;
+        define = 1;
 
-  if (!handle)
+        break;
 
-    return CBF_ARGUMENT;
+      case STRING:
+      case CBFWORD:
+      case BINARY:
 
+        if (define)
+        {
+          define = 0;
 
-    /* Find the category node */
+          break;
+        }
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+        if (inloop)
+        {
+          if (!columns)
+          {
+            cbf_log (handle, "loop value without tag", CBF_LOGERROR|CBF_LOGSTARTLOC);
 
+            break;
+          }
 
-    /* How many rows and columns does this category have? */
+          column = values % columns;
 
-  cbf_failnez (cbf_count_rows (handle, &rows))
+          if (!column)
+          {
+            skip_row = 0;
 
-  cbf_failnez (cbf_count_columns (handle, &columns))
+            if (!skip_block && !skip_frame && !skip_loop && callbacks->row)
 
+              errorcode = cbf_stream_result (callbacks->row (context, values / columns),
+                                             &skip_row, &stop);
+          }
 
-    /* Add a row to each column */
+          values++;
 
-  for (column = 0; column < columns; column++)
-  {
-    errorcode [0] = cbf_get_child (&columnnode, node, column);
+          if (errorcode || stop || skip_row || skip_columns [column])
 
-    if (!errorcode [0])
+            break;
+        }
+        else
+        {
+          if (!named)
+          {
+            cbf_log (handle, "value without tag", CBF_LOGERROR|CBF_LOGSTARTLOC);
 
-      errorcode [0] = cbf_add_columnrow (columnnode, NULL);
+            break;
+          }
 
-    if (errorcode [0])
-    {
-        /* Set the columns back to the original number of rows */
+          named = 0;
 
-      while (column)
-      {
-        column--;
+          column = columns - 1;
 
-        errorcode [1] = cbf_get_child (&columnnode, node, column);
+          if (skip_column)
 
-        if (!errorcode [1])
+            break;
+        }
 
-          errorcode [1] |= cbf_set_children (columnnode, rows);
+        if (skip_block || skip_frame || skip_loop)
 
-        errorcode [0] |= errorcode [1];
-      }
+          break;
 
-      return errorcode [0];
-    }
-  }
+        if (token == BINARY)
+        {
+          cbf_stream_binary binary;
 
+          void *binary_file;
 
-    /* Success */
+          unsigned long size, dimover, dimfast, dimmid, dimslow, padding, position;
 
-  handle->row = rows;
+          int checked_digest;
 
-  handle->search_row = rows;
+          char digest [25], byteorder [15];
 
-  return 0;
-}
+          if (!callbacks->binary)
 
+            break;
 
-  /* Insert a row in the current category */
+          sscanf (val.text + 1, " %x %p %lx %lx %d %24s %x %d %d %14s %lu %lu %lu %lu %lu %u",
+                                (unsigned int *) &binary.id,
+                                &binary_file,
+                                &position,
+                                &size,
+                                &checked_digest,
+                                digest,
+                                (unsigned int *) &binary.bits,
+                                &binary.sign,
+                                &binary.realarray,
+                                byteorder,
+                                &dimover, &dimfast, &dimmid, &dimslow,
+                                &padding,
+                                &binary.compression);
 
-int cbf_insert_row (cbf_handle handle, const int rownumber)
-{
-  cbf_node *node, *columnnode;
+          binary.mime = *val.text == CBF_TOKEN_MIME_BIN;
 
-  int errorcode [2];
+          binary.size = size;
 
-  unsigned int rows, columns, column;
+          binary.dimover = dimover;
 
-  if (!handle)
+          binary.dimfast = dimfast;
 
-    return CBF_ARGUMENT;
+          binary.dimmid = dimmid;
 
+          binary.dimslow = dimslow;
 
-    /* Find the category node */
+          binary.padding = padding;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+          binary.byteorder = (byteorder [0] == 'b' || byteorder [0] == 'B') ?
+                                  "big_endian" : "little_endian";
 
+          errorcode = cbf_stream_result (callbacks->binary (context, column, &binary),
+                                         NULL, &stop);
+        }
+        else
+        {
+          if (!callbacks->value)
 
-    /* How many rows and columns does this category have? */
+            break;
 
-  cbf_failnez (cbf_count_rows (handle, &rows))
+          errorcode = cbf_get_value_type (val.text, &typeofvalue);
 
-  cbf_failnez (cbf_count_columns (handle, &columns))
+          if (!errorcode)
 
+            errorcode = cbf_stream_result (callbacks->value (context, column,
+                                           val.text + 1, typeofvalue),
+                                           NULL, &stop);
+        }
 
-    /* Insert a row into each column */
+        break;
 
-  for (column = 0; column < columns; column++)
-  {
-    errorcode [0] = cbf_get_child (&columnnode, node, column);
+      default:
 
-    if (!errorcode [0])
+        break;
+    }
 
-      errorcode [0] = cbf_insert_columnrow (columnnode, rownumber, NULL);
 
-    if (errorcode [0])
-    {
-        /* Set the columns back to the original number of rows */
+      /* Release the token; a binary section holds a connection to the file */
 
-      while (column)
+    if (val.text)
+    {
+      if (token == BINARY)
       {
-        column--;
-
-        errorcode [1] = cbf_get_child (&columnnode, node, column);
+        void *binary_file = NULL;
 
-        if (!errorcode [1])
+        sscanf (val.text + 1, " %*x %p", &binary_file);
 
-          errorcode [1] |= cbf_delete_columnrow (columnnode, rownumber);
+        if (binary_file)
+        {
+          cbf_file *connection = (cbf_file *) binary_file;
 
-        errorcode [0] |= errorcode [1];
+          errorcode |= cbf_delete_fileconnection (&connection);
+        }
       }
 
-      return errorcode [0];
+      cbf_free_text (&val.text, NULL);
     }
   }
 
+  if (category)
 
-    /* Success */
+    cbf_free_text (&category, NULL);
 
-  handle->row = rownumber;
+  if (pending)
 
-  handle->search_row = rownumber;
+    cbf_free_text (&pending, NULL);
 
-  return 0;
-}
+  if (skip_columns)
 
+    cbf_free ((void **) &skip_columns, &skip_columns_size);
 
-  /* Delete a row from the current category */
 
-int cbf_delete_row (cbf_handle handle, const int rownumber)
-{
-  cbf_node *node, *columnnode;
+    /* Disconnect the file */
 
-  int errorcode [2];
+  handle->file = NULL;
 
-  unsigned int rows, columns, column;
+  return errorcode
+    |(handle->errors > errors ? CBF_FORMAT : 0)
+    | cbf_delete_fileconnection (&file);
+}
 
-  if (!handle)
 
-    return CBF_ARGUMENT;
+  /* Write a file */
 
+int cbf_write_file (cbf_handle handle, FILE *stream, int isbuffer,
+                                                     int ciforcbf,
+                                                     int flags,
+                                                     int encoding)
+{
+  cbf_file *file;
 
-    /* Find the category node */
+  cbf_node *node;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+  int errorcode;
 
 
-    /* How many rows and columns does this category have? */
+    /* CIF or CBF? */
 
-  cbf_failnez (cbf_count_rows (handle, &rows))
+  if (ciforcbf == CIF) {
 
-  if (!rows) return CBF_NOTFOUND;
+    encoding = encoding & ~ENC_NONE;
 
-  cbf_failnez (cbf_count_columns (handle, &columns))
+    if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_LFTERM;
 
+  } else {
 
-    /* Delete a row from each column */
+    encoding = (encoding & ~(ENC_BASE8   |
+                             ENC_BASE10  |
+                             ENC_BASE16  |
+                             ENC_BASE64  |
+                             ENC_BASE32K |
+                             ENC_QP      |
+                             ENC_FORWARD |
+                             ENC_BACKWARD)) | ENC_NONE;
+                             
+   if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_CRTERM|ENC_LFTERM;
 
-  errorcode [0] = 0;
+  	
+  }
 
-  for (column = 0; column < columns; column++)
-  {
-    errorcode [1] = cbf_get_child (&columnnode, node, column);
 
-    if (!errorcode [1])
+    /* Check the arguments */
 
-      errorcode [1] = cbf_delete_columnrow (columnnode, rownumber);
+  if (!handle)
 
-    errorcode [0] |= errorcode [1];
-  }
+    return CBF_ARGUMENT;
 
-  rows--;
+  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
+      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
 
-  if (handle->row > rownumber && handle->row)
+    return CBF_ARGUMENT;
 
-    handle->row--;
 
-  if (handle->search_row > rownumber && handle->search_row)
+  if (((encoding & ENC_NONE)    > 0) +
+      ((encoding & ENC_BASE8)   > 0) +
+      ((encoding & ENC_BASE10)  > 0) +
+      ((encoding & ENC_BASE16)  > 0) +
+      ((encoding & ENC_BASE64)  > 0) +
+      ((encoding & ENC_BASE32K) > 0) +
+      ((encoding & ENC_QP)      > 0) > 1)
 
-    handle->search_row--;
+    return CBF_ARGUMENT;
 
-  return errorcode [0];
-}
 
+    /* Build any data blocks a lazy read left unbuilt */
 
-  /* Change the name of the current data block */
+  cbf_failnez (cbf_build_datablocks (handle))
 
-int cbf_set_datablockname (cbf_handle handle, const char *datablockname)
-{
-  cbf_node *node;
 
-  int errorcode;
+    /* Read any values left null by a lazy read from another format */
 
-  if (!handle)
+  cbf_failnez (cbf_resolve_deferred (handle, 1))
 
-    return CBF_ARGUMENT;
 
+    /* Find the root node */
 
-    /* Find the data block node */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
+    /* Create the file */
 
-    /* Copy the name */
+  cbf_failnez (cbf_make_file (&file, stream))
 
-  if (datablockname)
-  {
-    datablockname = cbf_copy_string (NULL, datablockname, 0);
+  file->logfile = handle->logfile;
 
-    if (!datablockname)
+    /* Collect the output in a large buffer; a failure here only
+       leaves the default buffer in place */
 
-      return CBF_ALLOC;
-  }
+  cbf_set_output_buffersize (file, CBF_BULK_WRITE_BUFFER);
 
 
-    /* Change the name */
+    /* Defaults */
 
-  errorcode = cbf_name_node (node, datablockname);
+  if (flags & (MSG_DIGEST | MSG_DIGESTNOW))
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, datablockname);
+    flags |= MIME_HEADERS;
 
-    return errorcode;
-  }
+  else
 
+    if ((flags & (MIME_HEADERS | PLAIN_HEADERS)) == 0)
 
-    /* Success */
+      flags |= (HDR_DEFAULT & (MIME_HEADERS | PLAIN_HEADERS));
 
-  handle->node = node;
+  if (flags & PLAIN_HEADERS)
 
-  return 0;
-}
+    flags |= MSG_NODIGEST;
 
-  /* Change the name of the current save frame */
+  else
 
-int cbf_set_saveframename (cbf_handle handle, const char *saveframename)
-{
-  cbf_node *node;
+    if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW)) == 0)
 
-  int errorcode;
+      flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW));
 
-  if (!handle)
+  if (flags & MSG_DIGESTNOW)
 
-    return CBF_ARGUMENT;
+    flags |= MSG_DIGEST;
 
 
-    /* Find the save frame node */
+  if ((encoding & (ENC_NONE    |
+                   ENC_BASE8   |
+                   ENC_BASE10  |
+                   ENC_BASE16  |
+                   ENC_BASE64  |
+                   ENC_BASE32K |
+                   ENC_QP)) == 0)
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
+    encoding |= (ENC_DEFAULT & (ENC_NONE    |
+                                ENC_BASE8   |
+                                ENC_BASE10  |
+                                ENC_BASE16  |
+                                ENC_BASE64  |
+                                ENC_BASE32K |
+                                ENC_QP));
 
+  if ((encoding & (ENC_CRTERM | ENC_LFTERM)) == 0)
 
-    /* Copy the name */
+    encoding |= (ENC_DEFAULT & (ENC_CRTERM | ENC_LFTERM));
 
-  if (saveframename)
-  {
-    saveframename = cbf_copy_string (NULL, saveframename, 0);
+  if ((encoding & (ENC_FORWARD | ENC_BACKWARD)) == 0)
 
-    if (!saveframename)
+    encoding |= (ENC_DEFAULT & (ENC_FORWARD | ENC_BACKWARD));
 
-      return CBF_ALLOC;
-  }
 
+    /* Copy the flags */
 
-    /* Change the name */
+  file->write_headers  = flags;
+  file->write_encoding = encoding;
+  
+    /* Reset the reference counts */
+    
+ cbf_failnez( cbf_reset_refcounts(handle->dictionary) )
 
-  errorcode = cbf_name_node (node, saveframename);
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, saveframename);
+    /* Write the file */
 
-    return errorcode;
-  }
+  errorcode = cbf_write_node (handle, node, file, isbuffer);
 
 
-    /* Success */
+    /* Free the file structure but don't close the file? */
 
-  handle->node = node;
+  if (!isbuffer)
 
-  return 0;
+    file->stream = NULL;
+
+
+    /* Disconnect the file */
+
+  return errorcode | cbf_delete_fileconnection (&file);
 }
 
 
-  /* Delete all categories from all the data blocks */
+  /* Write a file, starting from the local node */
 
-int cbf_reset_datablocks (cbf_handle handle)
+int cbf_write_local_file (cbf_handle handle, FILE *stream, int isbuffer,
+                                                     int ciforcbf,
+                                                     int flags,
+                                                     int encoding)
 {
-  cbf_node *node, *datablocknode;
+  cbf_file *file;
 
-  unsigned int datablocks, datablock;
+  cbf_node *node;
 
   int errorcode;
 
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* CIF or CBF? */
 
+  if (ciforcbf == CIF) {
 
-    /* Find the data block node */
+    encoding = encoding & ~ENC_NONE;
 
-  errorcode = cbf_find_parent (&datablocknode, handle->node, CBF_DATABLOCK);
+      if ((encoding &(ENC_CRTERM | ENC_LFTERM))==0 ) encoding |= ENC_LFTERM;
 
-  if (errorcode && errorcode != CBF_NOTFOUND)
+  } else {
 
-    return errorcode;
+    encoding = (encoding & ~(ENC_BASE8   |
+                             ENC_BASE10  |
+                             ENC_BASE16  |
+                             ENC_BASE64  |
+                             ENC_BASE32K |
+                             ENC_QP      |
+                             ENC_FORWARD |
+                             ENC_BACKWARD)) | ENC_NONE;
+                             
+   if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_CRTERM|ENC_LFTERM;
 
+  	
+  }
 
-    /* Find the root node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+    /* Check the arguments */
 
-  if (errorcode)
+  if (!handle)
 
-    handle->node = node;
+    return CBF_ARGUMENT;
 
-  else
+  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
+      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
 
-    handle->node = datablocknode;
+    return CBF_ARGUMENT;
 
 
-    /* Delete all grandchildren */
+  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
+      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
+  
+    return CBF_ARGUMENT;
 
-  cbf_failnez (cbf_count_children (&datablocks, node))
 
-  for (datablock = 0; datablock < datablocks; datablock++)
-  {
-    cbf_failnez (cbf_get_child (&node, handle->node, datablock))
+  if (((encoding & ENC_NONE)    > 0) +
+      ((encoding & ENC_BASE8)   > 0) +
+      ((encoding & ENC_BASE10)  > 0) +
+      ((encoding & ENC_BASE16)  > 0) +
+      ((encoding & ENC_BASE64)  > 0) +
+      ((encoding & ENC_BASE32K) > 0) +
+      ((encoding & ENC_QP)      > 0) > 1)
 
-    cbf_failnez (cbf_set_children (node, 0))
-  }
+    return CBF_ARGUMENT;
 
 
-    /* Success */
 
-  return 0;
-}
+    /* Build any data blocks a lazy read left unbuilt */
 
+  cbf_failnez (cbf_build_datablocks (handle))
 
-  /* Delete all categories from the current data block */
 
-int cbf_reset_datablock (cbf_handle handle)
-{
-  cbf_node *node;
+    /* Read any values left null by a lazy read from another format */
 
-  if (!handle)
+  cbf_failnez (cbf_resolve_deferred (handle, 1))
 
-    return CBF_ARGUMENT;
 
+    /* Create the file */
 
-    /* Find the data block node */
+  cbf_failnez (cbf_make_file (&file, stream))
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  file->logfile = handle->logfile;
 
-  handle->node = node;
+    /* Collect the output in a large buffer; a failure here only
+       leaves the default buffer in place */
 
+  cbf_set_output_buffersize (file, CBF_BULK_WRITE_BUFFER);
 
-    /* Delete the children */
+    /* Defaults */
 
-  return cbf_set_children (node, 0);
-}
+  if (flags & (MSG_DIGEST | MSG_DIGESTNOW))
 
+    flags |= MIME_HEADERS;
 
-  /* Delete all categories from the current save frame */
+  else
 
-int cbf_reset_saveframe (cbf_handle handle)
-{
-  cbf_node *node;
+    if ((flags & (MIME_HEADERS | PLAIN_HEADERS)) == 0)
 
-  if (!handle)
+      flags |= (HDR_DEFAULT & (MIME_HEADERS | PLAIN_HEADERS));
 
-    return CBF_ARGUMENT;
+  if (flags & PLAIN_HEADERS)
 
+    flags |= MSG_NODIGEST;
 
-    /* Find the data block node */
+  else
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
+    if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW)) == 0)
 
-  handle->node = node;
+      flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW));
 
+  if (flags & MSG_DIGESTNOW)
 
-    /* Delete the children */
+    flags |= MSG_DIGEST;
 
-  return cbf_set_children (node, 0);
-}
+  if ((encoding & (ENC_NONE    |
+                   ENC_BASE8   |
+                   ENC_BASE10  |
+                   ENC_BASE16  |
+                   ENC_BASE64  |
+                   ENC_BASE32K |
+                   ENC_QP)) == 0)
+
+    encoding |= (ENC_DEFAULT & (ENC_NONE    |
+                                ENC_BASE8   |
+                                ENC_BASE10  |
+                                ENC_BASE16  |
+                                ENC_BASE64  |
+                                ENC_BASE32K |
+                                ENC_QP));
 
+  if ((encoding & (ENC_CRTERM | ENC_LFTERM)) == 0)
 
-  /* Delete all columns and rows from the current category */
+    encoding |= (ENC_DEFAULT & (ENC_CRTERM | ENC_LFTERM));
 
-int cbf_reset_category (cbf_handle handle)
-{
-  cbf_node *node;
+  if ((encoding & (ENC_FORWARD | ENC_BACKWARD)) == 0)
 
-  if (!handle)
+    encoding |= (ENC_DEFAULT & (ENC_FORWARD | ENC_BACKWARD));
 
-    return CBF_ARGUMENT;
 
+    /* Copy the flags */
 
-    /* Find the category node */
+  file->write_headers  = flags;
+  file->write_encoding = encoding;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+  node = handle->node;
 
-  handle->node = node;
+    /* Write the file */
 
+  errorcode = cbf_write_node (handle, node, file, isbuffer);
 
-    /* Delete the children */
 
-  return cbf_set_children (node, 0);
+    /* Free the file structure but don't close the file? */
+
+  if (!isbuffer)
+
+    file->stream = NULL;
+
+
+    /* Disconnect the file */
+
+  return errorcode | cbf_delete_fileconnection (&file);
 }
 
 
-  /* Delete the current data block */
 
-int cbf_remove_datablock (cbf_handle handle)
+  /* Write a wide file */
+
+int cbf_write_widefile (cbf_handle handle, FILE *stream, int isbuffer,
+                                                     int ciforcbf,
+                                                     int flags,
+                                                     int encoding)
 {
-  cbf_node *node, *parent;
+  cbf_file *file;
 
-  if (!handle)
+  cbf_node *node;
 
-    return CBF_ARGUMENT;
+  int errorcode;
 
 
-    /* Find the data block node */
+    /* CIF or CBF? */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  if (ciforcbf == CIF) {
 
+    encoding = encoding & ~ENC_NONE;
 
-    /* Find the root node */
+    if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_LFTERM;
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_ROOT))
+  } else {
 
-  handle->node = parent;
+    encoding = (encoding & ~(ENC_BASE8   |
+                             ENC_BASE10  |
+                             ENC_BASE16  |
+                             ENC_BASE64  |
+                             ENC_BASE32K |
+                             ENC_QP      |
+                             ENC_FORWARD |
+                             ENC_BACKWARD)) | ENC_NONE;
+                             
+   if ((encoding &(ENC_CRTERM | ENC_LFTERM)) ==0 ) encoding |= ENC_CRTERM|ENC_LFTERM;
 
+  	
+  }
 
-    /* Delete the datablock */
+    /* Check the arguments */
 
-  return cbf_free_node (node);
-}
+  if (!handle)
 
+    return CBF_ARGUMENT;
 
-  /* Delete the current save frame  */
+  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
+      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
 
-int cbf_remove_saveframe (cbf_handle handle)
-{
-  cbf_node *node, *parent;
+    return CBF_ARGUMENT;
 
-  if (!handle)
+
+  if (((flags  & MIME_HEADERS)  && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGEST)    && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGEST)    && (flags  & PLAIN_HEADERS)) ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & MSG_NODIGEST))  ||
+      ((flags  & MSG_DIGESTNOW) && (flags  & PLAIN_HEADERS)) ||
+      ((encoding & ENC_FORWARD)   && (encoding & ENC_BACKWARD)))
 
     return CBF_ARGUMENT;
+    
 
+  if (((encoding & ENC_NONE)    > 0) +
+      ((encoding & ENC_BASE8)   > 0) +
+      ((encoding & ENC_BASE10)  > 0) +
+      ((encoding & ENC_BASE16)  > 0) +
+      ((encoding & ENC_BASE64)  > 0) +
+      ((encoding & ENC_BASE32K) > 0) +
+      ((encoding & ENC_QP)      > 0) > 1)
 
-    /* Find the save frame node */
+    return CBF_ARGUMENT;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
 
+    /* Find the root node */
 
-    /* Find the data block */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
-  handle->node = parent;
+    /* Build any data blocks a lazy read left unbuilt */
 
+  cbf_failnez (cbf_build_datablocks (handle))
 
-    /* Delete the save frame */
 
-  return cbf_free_node (node);
-}
+    /* Read any values left null by a lazy read from another format */
 
+  cbf_failnez (cbf_resolve_deferred (handle, 1))
 
 
-  /* Delete the current category */
+    /* Create the file */
 
-int cbf_remove_category (cbf_handle handle)
-{
-  cbf_node *node, *parent;
+  cbf_failnez (cbf_make_widefile (&file, stream))
 
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* Collect the output in a large buffer; a failure here only
+       leaves the default buffer in place */
 
+  cbf_set_output_buffersize (file, CBF_BULK_WRITE_BUFFER);
 
-    /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+    /* Defaults */
 
+  if (flags & (MSG_DIGEST | MSG_DIGESTNOW))
 
-    /* Find the save frame or data block node */
+    flags |= MIME_HEADERS;
 
-  if (cbf_find_parent (&parent, node, CBF_SAVEFRAME)) {
+  else
 
-    cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
+    if ((flags & (MIME_HEADERS | PLAIN_HEADERS)) == 0)
 
-  }
+      flags |= (HDR_DEFAULT & (MIME_HEADERS | PLAIN_HEADERS));
 
-  handle->node = parent;
+  if (flags & PLAIN_HEADERS)
 
+    flags |= MSG_NODIGEST;
 
-    /* Delete the column */
+  else
 
-  return cbf_free_node (node);
-}
+    if ((flags & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW)) == 0)
 
+      flags |= (HDR_DEFAULT & (MSG_DIGEST | MSG_NODIGEST | MSG_DIGESTNOW));
 
-  /* Delete the current column */
+  if (flags & MSG_DIGESTNOW)
 
-int cbf_remove_column (cbf_handle handle)
-{
-  cbf_node *node, *parent;
+    flags |= MSG_DIGEST;
 
-  if (!handle)
+  if ((encoding & (ENC_NONE    |
+                   ENC_BASE8   |
+                   ENC_BASE10  |
+                   ENC_BASE16  |
+                   ENC_BASE64  |
+                   ENC_BASE32K |
+                   ENC_QP)) == 0)
 
-    return CBF_ARGUMENT;
+    encoding |= (ENC_DEFAULT & (ENC_NONE    |
+                                ENC_BASE8   |
+                                ENC_BASE10  |
+                                ENC_BASE16  |
+                                ENC_BASE64  |
+                                ENC_BASE32K |
+                                ENC_QP));
 
+  if ((encoding & (ENC_CRTERM | ENC_LFTERM)) == 0)
 
-    /* Find the column node */
+    encoding |= (ENC_DEFAULT & (ENC_CRTERM | ENC_LFTERM));
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
+  if ((encoding & (ENC_FORWARD | ENC_BACKWARD)) == 0)
 
+    encoding |= (ENC_DEFAULT & (ENC_FORWARD | ENC_BACKWARD));
 
-    /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_CATEGORY))
+    /* Copy the flags */
 
-  handle->node = parent;
+  file->write_headers  = flags;
+  file->write_encoding = encoding;
 
 
-    /* Delete the column */
+    /* Write the file */
 
-  return cbf_free_node (node);
-}
+  errorcode = cbf_write_node (handle, node, file, isbuffer);
 
 
-  /* Delete the current row */
+    /* Free the file structure but don't close the file? */
 
-int cbf_remove_row (cbf_handle handle)
-{
-  if (!handle)
+  if (!isbuffer)
 
-    return CBF_ARGUMENT;
+    file->stream = NULL;
 
-  return cbf_delete_row (handle, handle->row);
+
+    /* Disconnect the file */
+
+  return errorcode | cbf_delete_fileconnection (&file);
 }
 
 
-  /* Make the first data block the current data block */
+  /* Add a data block */
 
-int cbf_rewind_datablock (cbf_handle handle)
+int cbf_new_datablock (cbf_handle handle, const char *datablockname)
 {
   cbf_node *node;
 
+  int errorcode;
+
   if (!handle)
 
     return CBF_ARGUMENT;
@@ -1983,197 +2233,253 @@ int cbf_rewind_datablock (cbf_handle handle)
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
 
-    /* Find the first child */
+    /* Copy the name */
 
-  cbf_failnez (cbf_get_child (&node, node, 0))
+  if (datablockname)
+  {
+    datablockname = cbf_copy_string (NULL, datablockname, 0);
 
-  handle->node = node;
+    if (!datablockname)
 
+      return CBF_ALLOC;
+  }
 
-    /* Success */
 
-  return 0;
-}
+    /* Add a datablock */
 
+  errorcode = cbf_make_child (&node, node, CBF_DATABLOCK, datablockname);
 
-  /* Make the first save frame in the current data block the current saveframe */
+  if (errorcode)
+  {
+    cbf_free_string (NULL, datablockname);
 
-int cbf_rewind_saveframe (cbf_handle handle)
+    return errorcode;
+  }
+
+
+    /* An existing data block of a lazy read is built before it is added to */
+
+  cbf_failnez (cbf_build_datablock (handle, node, 0))
+
+
+    /* Success */
+
+  handle->node = node;
+
+  return 0;
+}
+
+
+  /* Add a save frame */
+
+int cbf_new_saveframe (cbf_handle handle, const char *saveframename)
 {
   cbf_node *node;
 
-  cbf_node *child_node;
-
-  int i;
+  int errorcode;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the save frame or data block node */
+    /* Find the root node */
 
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
 
+    /* Copy the name */
 
-    /* Find the first child that is a save frame*/
+  if (saveframename)
+  {
+    saveframename = cbf_copy_string (NULL, saveframename, 0);
 
-  for (i = 0; (unsigned int)i < node->children; i++) {
+    if (!saveframename)
 
-    cbf_failnez (cbf_get_child (&child_node, node, i))
+      return CBF_ALLOC;
+  }
 
-    if (child_node && child_node->type == CBF_SAVEFRAME) {
 
-      handle->node = child_node;
+    /* Add a save frame */
 
-      /* Success */
+  errorcode = cbf_make_child (&node, node, CBF_SAVEFRAME, saveframename);
 
-      return 0;
+  if (errorcode)
+  {
+    cbf_free_string (NULL, saveframename);
 
-    }
+    return errorcode;
   }
 
-  return CBF_NOTFOUND;
 
+    /* Success */
+
+  handle->node = node;
+
+  return 0;
 }
 
 
-  /* Make the first category in the current data block the current category */
+  /* Add a data block, allowing for duplicates */
 
-int cbf_rewind_category (cbf_handle handle)
+int cbf_force_new_datablock (cbf_handle handle, const char *datablockname)
 {
   cbf_node *node;
 
-  cbf_node *child_node;
-
-  int i;
+  int errorcode;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the save frame or data block node */
-
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
+    /* Find the root node */
 
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-  }
 
+    /* Copy the name */
 
-    /* Find the first child that is a category*/
+  if (datablockname)
+  {
+    datablockname = cbf_copy_string (NULL, datablockname, 0);
 
-  for (i = 0; (unsigned int)i < node->children; i++) {
+    if (!datablockname)
 
-    cbf_failnez (cbf_get_child (&child_node, node, i))
+      return CBF_ALLOC;
+  }
 
-    if (child_node && child_node->type == CBF_CATEGORY) {
 
-      handle->node = child_node;
+    /* Add a datablock */
 
-      /* Success */
+  errorcode = cbf_make_new_child (&node, node, CBF_DATABLOCK, datablockname);
 
-      return 0;
+  if (errorcode)
+  {
+    cbf_free_string (NULL, datablockname);
 
-    }
+    return errorcode;
   }
 
-  return CBF_NOTFOUND;
 
+    /* Success */
+
+  handle->node = node;
+
+  return 0;
 }
 
 
-  /* Make the first save frame or category in the current data block the current save frame or category */
+  /* Add a save frame, allowing for duplicates */
 
-int cbf_rewind_blockitem (cbf_handle handle, CBF_NODETYPE * type)
+int cbf_force_new_saveframe (cbf_handle handle, const char *saveframename)
 {
   cbf_node *node;
 
-  cbf_node *child_node;
+  int errorcode;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the data block node */
+    /* Find the DATABLOCK */
 
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
 
-    /* Find the first child */
+    /* Copy the name */
 
-  cbf_failnez (cbf_get_child (&child_node, node, 0))
+  if (saveframename)
+  {
+    saveframename = cbf_copy_string (NULL, saveframename, 0);
 
-  handle->node = child_node;
+    if (!saveframename)
+
+      return CBF_ALLOC;
+  }
+
+
+    /* Add a save frame */
+
+  errorcode = cbf_make_new_child (&node, node, CBF_SAVEFRAME, saveframename);
+
+  if (errorcode)
+  {
+    cbf_free_string (NULL, saveframename);
+
+    return errorcode;
+  }
 
-  *type = child_node->type;
 
     /* Success */
 
-  return 0;
+  handle->node = node;
 
+  return 0;
 }
 
-  /* Make the first column in the current category the current column */
 
-int cbf_rewind_column (cbf_handle handle)
+  /* Add a category to the current data block or save frame*/
+
+int cbf_new_category (cbf_handle handle, const char *categoryname)
 {
   cbf_node *node;
 
+  int errorcode;
+
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the category node */
-
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
-
+    /* Find the save frame or data block node */
 
-    /* Find the first child */
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-  cbf_failnez (cbf_get_child (&node, node, 0))
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  handle->node = node;
+  }
 
+    /* Copy the name */
 
-    /* Success */
+  if (categoryname)
+  {
+    categoryname = cbf_copy_string (NULL, categoryname, 0);
 
-  return 0;
-}
+    if (!categoryname)
 
+      return CBF_ALLOC;
+  }
 
-  /* Make the first row in the current category the current row */
 
-int cbf_rewind_row (cbf_handle handle)
-{
-  if (!handle)
+    /* Add a category */
 
-    return CBF_ARGUMENT;
+  errorcode = cbf_make_child (&node, node, CBF_CATEGORY, categoryname);
 
-  handle->row = 0;
+  if (errorcode)
+  {
+    cbf_free_string (NULL, categoryname);
 
-  handle->search_row = 0;
+    return errorcode;
+  }
 
 
     /* Success */
 
+  handle->node = node;
+
   return 0;
 }
 
 
-  /* Make the next data block the current data block */
+  /* Add a category to the current data block, allowing for duplicates */
 
-int cbf_next_datablock (cbf_handle handle)
+int cbf_force_new_category (cbf_handle handle, const char *categoryname)
 {
-  cbf_node *parent, *node;
-
-    int error;
+  cbf_node *node;
 
-  unsigned int index;
+  int errorcode;
 
   if (!handle)
 
@@ -2182,50 +2488,53 @@ int cbf_next_datablock (cbf_handle handle)
 
     /* Find the data block node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-    /* Find the root node */
+  }
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_ROOT))
+    /* Copy the name */
 
+  if (categoryname)
+  {
+    categoryname = cbf_copy_string (NULL, categoryname, 0);
 
-    /* Which child is this? */
+    if (!categoryname)
 
-  cbf_failnez (cbf_child_index (&index, node))
+      return CBF_ALLOC;
+  }
 
 
-    /* Get the next data block */
+    /* Add a category */
 
-    error = cbf_get_child (&node, parent, index + 1);
+  errorcode = cbf_make_new_child (&node, node, CBF_CATEGORY, categoryname);
 
-    if (!error) {
+  if (errorcode)
+  {
+    cbf_free_string (NULL, categoryname);
 
-  handle->node = node;
+    return errorcode;
+  }
 
 
     /* Success */
 
-  return 0;
-        
-    } else {
-        
-      return error;
-        
-}
+  handle->node = node;
 
+  return 0;
 }
 
 
-  /* Make the next category in the current save frame or data block the current category */
+  /* Add a column to the current category */
 
-int cbf_next_category (cbf_handle handle)
+int cbf_new_column (cbf_handle handle, const char *columnname)
 {
-  cbf_node *parent, *node;
+  cbf_node *node;
 
-  int i;
+  int errorcode;
 
-  unsigned int index;
+  unsigned int rows;
 
   if (!handle)
 
@@ -2237,50 +2546,65 @@ int cbf_next_category (cbf_handle handle)
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
 
-    /* Find the save frame or data block node */
+    /* How many rows does this category have? */
 
-  if (cbf_find_parent (&parent, node, CBF_SAVEFRAME)) {
+  cbf_failnez (cbf_count_rows (handle, &rows))
 
-    cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
-  }
+    /* Copy the name */
 
+  if (columnname)
+  {
+    columnname = cbf_copy_string (NULL, columnname, 0);
 
-    /* Which child is this? */
+    if (!columnname)
 
-  cbf_failnez (cbf_child_index (&index, node))
+      return CBF_ALLOC;
+  }
 
 
-    /* Get the next category */
+    /* Add a column */
 
-  for (i = index+1; (unsigned int)i<parent->children; i++) {
+  errorcode = cbf_make_child (&node, node, CBF_COLUMN, columnname);
 
-    cbf_failnez (cbf_get_child (&node, parent, i))
+  if (errorcode)
+  {
+    cbf_free_string (NULL, columnname);
 
-    if (node->type == CBF_CATEGORY) {
+    return errorcode;
+  }
 
-      handle->node = node;
 
-      /* Success */
+    /* Set the number of rows */
 
-      return 0;
-    }
+  errorcode = cbf_set_children (node, rows);
 
-  }
+  if (errorcode)
 
-  return CBF_NOTFOUND;
+    return errorcode | cbf_free_node (node);
+
+
+    /* Success */
+
+  handle->node = node;
+
+  handle->row = 0;
+
+  handle->search_row = 0;
+
+  return 0;
 }
 
 
-  /* Make the next save frame in the current data block the current save frame */
+  /* Add a row to the current category */
 
-int cbf_next_saveframe (cbf_handle handle)
+int cbf_new_row (cbf_handle handle)
 {
-  cbf_node *parent, *node;
+  cbf_node *node, *columnnode;
 
-  int i;
+  int errorcode [2];
 
-  unsigned int index;
+  unsigned int rows, columns, column;
 
   if (!handle)
 
@@ -2289,310 +2613,372 @@ int cbf_next_saveframe (cbf_handle handle)
 
     /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
 
-    /* Find the data block node */
+    /* How many rows and columns does this category have? */
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
+  cbf_failnez (cbf_count_rows (handle, &rows))
 
+  cbf_failnez (cbf_count_columns (handle, &columns))
 
-    /* Which child is this? */
 
-  cbf_failnez (cbf_child_index (&index, node))
+    /* Add a row to each column */
 
+  for (column = 0; column < columns; column++)
+  {
+    errorcode [0] = cbf_get_child (&columnnode, node, column);
 
-    /* Get the next save frame */
+    if (!errorcode [0])
 
-  for (i = index+1; (unsigned int)i<parent->children; i++) {
+      errorcode [0] = cbf_add_columnrow (columnnode, NULL);
 
-    cbf_failnez (cbf_get_child (&node, parent, i))
+    if (errorcode [0])
+    {
+        /* Set the columns back to the original number of rows */
 
-    if (node->type == CBF_SAVEFRAME) {
+      while (column)
+      {
+        column--;
 
-      handle->node = node;
+        errorcode [1] = cbf_get_child (&columnnode, node, column);
 
-      /* Success */
+        if (!errorcode [1])
 
-      return 0;
-    }
+          errorcode [1] |= cbf_set_children (columnnode, rows);
 
+        errorcode [0] |= errorcode [1];
+      }
+
+      return errorcode [0];
+    }
   }
 
-  return CBF_NOTFOUND;
+
+    /* Success */
+
+  handle->row = rows;
+
+  handle->search_row = rows;
+
+  return 0;
 }
 
 
-  /* Make the next save frame or category the current data block or category */
+  /* Insert a row in the current category */
 
-int cbf_next_blockitem (cbf_handle handle, CBF_NODETYPE * type)
+int cbf_insert_row (cbf_handle handle, const int rownumber)
 {
-  cbf_node *parent, *node;
+  cbf_node *node, *columnnode;
 
-  unsigned int index;
+  int errorcode [2];
+
+  unsigned int rows, columns, column;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
-    /* Discover if we are in a save frame or just in a data block */
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
+    /* Find the category node */
 
-    /* There is no save frame look for a category */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-    cbf_failnez(cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-  }
+    /* How many rows and columns does this category have? */
 
-     /* Find the root node */
+  cbf_failnez (cbf_count_rows (handle, &rows))
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
+  cbf_failnez (cbf_count_columns (handle, &columns))
 
-    /* Which child is this? */
 
-  cbf_failnez (cbf_child_index (&index, node))
+    /* Insert a row into each column */
 
+  for (column = 0; column < columns; column++)
+  {
+    errorcode [0] = cbf_get_child (&columnnode, node, column);
 
-    /* Get the next data block */
+    if (!errorcode [0])
 
-  cbf_failnez (cbf_get_child (&node, parent, index + 1))
+      errorcode [0] = cbf_insert_columnrow (columnnode, rownumber, NULL);
 
-  handle->node = node;
+    if (errorcode [0])
+    {
+        /* Set the columns back to the original number of rows */
+
+      while (column)
+      {
+        column--;
+
+        errorcode [1] = cbf_get_child (&columnnode, node, column);
+
+        if (!errorcode [1])
+
+          errorcode [1] |= cbf_delete_columnrow (columnnode, rownumber);
+
+        errorcode [0] |= errorcode [1];
+      }
+
+      return errorcode [0];
+    }
+  }
 
-  *type = handle->node->type;
 
     /* Success */
 
+  handle->row = rownumber;
+
+  handle->search_row = rownumber;
+
   return 0;
 }
 
 
-  /* Make the next column in the current category the current column */
+  /* Delete a row from the current category */
 
-int cbf_next_column (cbf_handle handle) {
-    
-  cbf_node *parent, *node;
+int cbf_delete_row (cbf_handle handle, const int rownumber)
+{
+  cbf_node *node, *columnnode;
 
-    int error;
-    
-  unsigned int index;
+  int errorcode [2];
+
+  unsigned int rows, columns, column;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the column node */
+    /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
 
-    /* Find the category node */
+    /* How many rows and columns does this category have? */
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_CATEGORY))
+  cbf_failnez (cbf_count_rows (handle, &rows))
 
+  if (!rows) return CBF_NOTFOUND;
 
-    /* Which child is this? */
+  cbf_failnez (cbf_count_columns (handle, &columns))
 
-  cbf_failnez (cbf_child_index (&index, node))
 
+    /* Delete a row from each column */
 
-    /* Get the next column */
+  errorcode [0] = 0;
 
-    error = cbf_get_child (&node, parent, index + 1);
+  for (column = 0; column < columns; column++)
+  {
+    errorcode [1] = cbf_get_child (&columnnode, node, column);
 
-    if (!error) {
-        
-  handle->node = node;
+    if (!errorcode [1])
 
+      errorcode [1] = cbf_delete_columnrow (columnnode, rownumber);
 
-    /* Success */
+    errorcode [0] |= errorcode [1];
+  }
 
-  return 0;
-        
-    } else {
-        
-        return error;
-}
+  rows--;
+
+  if (handle->row > rownumber && handle->row)
+
+    handle->row--;
 
+  if (handle->search_row > rownumber && handle->search_row)
+
+    handle->search_row--;
+
+  return errorcode [0];
 }
 
 
-  /* Make the next row in the current category the current row */
+  /* Change the name of the current data block */
 
-int cbf_next_row (cbf_handle handle)
+int cbf_set_datablockname (cbf_handle handle, const char *datablockname)
 {
   cbf_node *node;
 
-  unsigned int rows;
+  int errorcode;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the column node */
+    /* Find the data block node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  cbf_failnez (cbf_count_children (&rows, node))
 
+    /* Copy the name */
 
-    /* Is the row valid? */
+  if (datablockname)
+  {
+    datablockname = cbf_copy_string (NULL, datablockname, 0);
 
-  if (handle->row >= 0 && (unsigned int)(handle->row) >= rows)
+    if (!datablockname)
 
-    return CBF_NOTFOUND;
+      return CBF_ALLOC;
+  }
 
-  handle->row++;
 
-  handle->search_row = handle->row;
+    /* Change the name */
+
+  errorcode = cbf_name_node (node, datablockname);
+
+  if (errorcode)
+  {
+    cbf_free_string (NULL, datablockname);
+
+    return errorcode;
+  }
 
 
     /* Success */
 
+  handle->node = node;
+
   return 0;
 }
 
+  /* Change the name of the current save frame */
 
-  /* Make the specified data block the current data block */
-
-int cbf_select_datablock (cbf_handle handle, unsigned int datablock)
+int cbf_set_saveframename (cbf_handle handle, const char *saveframename)
 {
   cbf_node *node;
 
+  int errorcode;
+
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the root node */
+    /* Find the save frame node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
 
 
-    /* Select the data block */
+    /* Copy the name */
 
-  cbf_failnez (cbf_get_child (&node, node, datablock))
+  if (saveframename)
+  {
+    saveframename = cbf_copy_string (NULL, saveframename, 0);
 
-  handle->node = node;
+    if (!saveframename)
 
+      return CBF_ALLOC;
+  }
 
-    /* Success */
 
-  return 0;
-}
+    /* Change the name */
 
+  errorcode = cbf_name_node (node, saveframename);
 
-  /* Make the specified save frame the current save frame */
+  if (errorcode)
+  {
+    cbf_free_string (NULL, saveframename);
 
-int cbf_select_saveframe (cbf_handle handle, unsigned int saveframe)
-{
-  cbf_node *node;
-
-  cbf_node *child_node;
-
-  unsigned int isf, jsf;
-
-  if (!handle)
-
-    return CBF_ARGUMENT;
+    return errorcode;
+  }
 
 
-  /* Find the data block node */
+    /* Success */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  handle->node = node;
 
+  return 0;
+}
 
-  /* Select the save frame */
 
-  isf = 0;
+  /* Delete all categories from all the data blocks */
 
-  jsf = 0;
+int cbf_reset_datablocks (cbf_handle handle)
+{
+  cbf_node *node, *datablocknode;
 
-  while (jsf < saveframe+1 && isf < node->children) {
+  unsigned int datablocks, datablock;
 
-    cbf_failnez (cbf_get_child (&child_node, node, isf++))
+  int errorcode;
 
-    if (child_node->type == CBF_SAVEFRAME) jsf++;
+  if (!handle)
 
-  }
+    return CBF_ARGUMENT;
 
-  if (jsf == saveframe+1) {
 
-    handle->node = child_node;
+    /* Find the data block node */
 
-    /* Success */
+  errorcode = cbf_find_parent (&datablocknode, handle->node, CBF_DATABLOCK);
 
-    return 0;
+  if (errorcode && errorcode != CBF_NOTFOUND)
 
-  }
+    return errorcode;
 
-  return CBF_NOTFOUND;
-}
 
+    /* Find the root node */
 
-  /* Make the specified category the current category */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-int cbf_select_category (cbf_handle handle, unsigned int category)
-{
-  cbf_node *node;
+  if (errorcode)
 
-  cbf_node *child_node;
+    handle->node = node;
 
-  unsigned int icat, jcat;
+  else
 
-  if (!handle)
+    handle->node = datablocknode;
 
-    return CBF_ARGUMENT;
 
+    /* Delete all grandchildren.  Data blocks of a lazy read that have
+       not been built are empty already */
 
-    /* Find the data block node */
+  cbf_failnez (cbf_free_lazy_index (handle))
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
+  cbf_failnez (cbf_count_children (&datablocks, node))
 
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  for (datablock = 0; datablock < datablocks; datablock++)
+  {
+    cbf_failnez (cbf_get_child (&node, handle->node, datablock))
 
+    cbf_failnez (cbf_set_children (node, 0))
   }
 
 
-    /* Select the category */
+    /* Success */
 
-  icat = 0;
+  return 0;
+}
 
-  jcat = 0;
 
-  while (jcat < category+1 && icat < node->children) {
+  /* Delete all categories from the current data block */
 
-    cbf_failnez (cbf_get_child (&child_node, node, icat++))
+int cbf_reset_datablock (cbf_handle handle)
+{
+  cbf_node *node;
 
-    if (child_node->type == CBF_CATEGORY) jcat++;
+  if (!handle)
 
-  }
+    return CBF_ARGUMENT;
 
-  if (jcat == category+1) {
 
-    handle->node = child_node;
+    /* Find the data block node */
 
-    /* Success */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-    return 0;
+  handle->node = node;
 
-  }
 
-  return CBF_NOTFOUND;
+    /* Delete the children */
+
+  return cbf_set_children (node, 0);
 }
 
 
-  /* Make the specified category or save frame the current block item */
+  /* Delete all categories from the current save frame */
 
-int cbf_select_blockitem (cbf_handle handle, unsigned int item, CBF_NODETYPE * type)
+int cbf_reset_saveframe (cbf_handle handle)
 {
   cbf_node *node;
 
-  cbf_node *child_node;
-
   if (!handle)
 
     return CBF_ARGUMENT;
@@ -2600,26 +2986,20 @@ int cbf_select_blockitem (cbf_handle handle, unsigned int item, CBF_NODETYPE * t
 
     /* Find the data block node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
-
-
-    /* Select the item */
-
-  cbf_failnez (cbf_get_child (&child_node, node, item))
-
-  handle->node = child_node;
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
 
-  *type = child_node->type;
+  handle->node = node;
 
-    /* Success */
 
-  return 0;
+    /* Delete the children */
 
+  return cbf_set_children (node, 0);
 }
 
-  /* Make the specified column the current column */
 
-int cbf_select_column (cbf_handle handle, unsigned int column)
+  /* Delete all columns and rows from the current category */
+
+int cbf_reset_category (cbf_handle handle)
 {
   cbf_node *node;
 
@@ -2632,345 +3012,303 @@ int cbf_select_column (cbf_handle handle, unsigned int column)
 
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-
-    /* Select the column */
-
-  cbf_failnez (cbf_get_child (&node, node, column))
-
   handle->node = node;
 
 
-    /* Success */
+    /* Delete the children */
 
-  return 0;
+  return cbf_set_children (node, 0);
 }
 
 
-  /* Make the specified row the current row */
+  /* Delete the current data block */
 
-int cbf_select_row (cbf_handle handle, unsigned int row)
+int cbf_remove_datablock (cbf_handle handle)
 {
-  cbf_node *node;
-
-  unsigned int rows;
+  cbf_node *node, *parent;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the column node */
-
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
-
-  cbf_failnez (cbf_count_children (&rows, node))
-
+    /* Find the data block node */
 
-    /* Is the row valid? */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  if (row >= rows)
 
-    return CBF_NOTFOUND;
+    /* Find the root node */
 
-  handle->row = row;
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_ROOT))
 
-  handle->search_row = row;
+  handle->node = parent;
 
 
-    /* Success */
+    /* Delete the datablock */
 
-  return 0;
+  return cbf_free_node (node);
 }
 
 
-  /* Make the named data block the current data block */
+  /* Delete the current save frame  */
 
-int cbf_find_datablock (cbf_handle handle, const char *datablockname)
+int cbf_remove_saveframe (cbf_handle handle)
 {
-  cbf_node *node;
+  cbf_node *node, *parent;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the root node */
+    /* Find the save frame node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
 
 
     /* Find the data block */
 
-  cbf_failnez (cbf_find_child (&node, node, datablockname))
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
-  handle->node = node;
+  handle->node = parent;
 
 
-    /* Success */
+    /* Delete the save frame */
 
-  return 0;
+  return cbf_free_node (node);
 }
 
 
-  /* Make the named save frame in the current data block the current save frame */
 
-int cbf_find_saveframe (cbf_handle handle, const char *saveframename)
+  /* Delete the current category */
+
+int cbf_remove_category (cbf_handle handle)
 {
-  cbf_node *node;
+  cbf_node *node, *parent;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the data block node */
-
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+    /* Find the category node */
 
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
 
-    /* Find the save frame */
+    /* Find the save frame or data block node */
 
-  cbf_failnez (cbf_find_typed_child (&node, node, saveframename, CBF_SAVEFRAME))
+  if (cbf_find_parent (&parent, node, CBF_SAVEFRAME)) {
 
-  handle->node = node;
+    cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
-  handle->row = 0;
+  }
 
-  handle->search_row = 0;
+  handle->node = parent;
 
 
-    /* Success */
+    /* Delete the column */
 
-  return 0;
+  return cbf_free_node (node);
 }
 
 
+  /* Delete the current column */
 
-  /* Make the named category in the current save frame or data block the current category */
-
-int cbf_find_category (cbf_handle handle, const char *categoryname)
+int cbf_remove_column (cbf_handle handle)
 {
-  cbf_node *node;
-
-    int error;
+  cbf_node *node, *parent;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the data block node */
+    /* Find the column node */
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  }
+    /* Find the category node */
 
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_CATEGORY))
 
-    /* Find the category */
+  handle->node = parent;
 
-    error = cbf_find_typed_child (&node, node, categoryname, CBF_CATEGORY);
 
-    if (!error) {
+    /* Delete the column */
 
-  handle->node = node;
+  return cbf_free_node (node);
+}
 
-  handle->row = 0;
 
-  handle->search_row = 0;
+  /* Delete the current row */
 
+int cbf_remove_row (cbf_handle handle)
+{
+  if (!handle)
 
-    /* Success */
+    return CBF_ARGUMENT;
 
-  return 0;
-        
-    } else {
-        
-        return error;
-        
-}
+  return cbf_delete_row (handle, handle->row);
 }
 
 
-  /* Make the named column in the current category the current column */
+  /* Make the first data block the current data block */
 
-int cbf_find_column (cbf_handle handle, const char *columnname) {
-    
+int cbf_rewind_datablock (cbf_handle handle)
+{
   cbf_node *node;
 
-    int error;
-    
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the category node */
+    /* Find the root node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
 
-    /* Find the column */
+    /* Find the first child */
 
-    error = cbf_find_child (&node, node, columnname);
+  cbf_failnez (cbf_get_child (&node, node, 0))
+
+  cbf_failnez (cbf_build_datablock (handle, node, 0))
 
-    if (!error) {
-        
   handle->node = node;
 
 
     /* Success */
 
-        return CBF_SUCCESS;
-        
-    } else {
-        
-        return error;
-        
-}
-
+  return 0;
 }
 
 
-  /* Make the first row with matching value the current row */
+  /* Make the first save frame in the current data block the current saveframe */
 
-int cbf_find_row (cbf_handle handle, const char *value)
+int cbf_rewind_saveframe (cbf_handle handle)
 {
-  cbf_failnez (cbf_rewind_row (handle))
-
-  return cbf_find_nextrow (handle, value);
-}
+  cbf_node *node;
 
+  cbf_node *child_node;
 
+  int i;
 
-  /* Make the first row with matching value the current row
-     creating it if necessary */
+  if (!handle)
 
-int cbf_require_row (cbf_handle handle, const char *value)
-{
-  if (cbf_rewind_row (handle)) {
+    return CBF_ARGUMENT;
 
-    cbf_failnez(cbf_new_row (handle))
-    
-    return cbf_set_value (handle, value);
-  	
-  }
 
-  return cbf_require_nextrow (handle, value);
-}
+    /* Find the save frame or data block node */
 
-  /* Make the next row with matching value the current row */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-int cbf_find_nextrow (cbf_handle handle, const char *value)
-{
-  cbf_node *node;
 
-  unsigned int row, rows;
 
-  const char *text;
+    /* Find the first child that is a save frame*/
 
-  if (!handle)
+  for (i = 0; (unsigned int)i < node->children; i++) {
 
-    return CBF_ARGUMENT;
+    cbf_failnez (cbf_get_child (&child_node, node, i))
 
+    if (child_node && child_node->type == CBF_SAVEFRAME) {
 
-    /* Find the column node */
+      handle->node = child_node;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
+      /* Success */
 
+      return 0;
 
-    /* Count the rows */
+    }
+  }
 
-  cbf_failnez (cbf_count_children (&rows, node))
+  return CBF_NOTFOUND;
 
-  for (row = handle->search_row; row < rows; row++)
-  {
-      /* Is the value ascii? */
+}
 
-    if (cbf_is_binary (node, row))
 
-      continue;
+  /* Make the first category in the current data block the current category */
 
+int cbf_rewind_category (cbf_handle handle)
+{
+  cbf_node *node;
 
-      /* Get the value of the current row */
+  cbf_node *child_node;
 
-    cbf_failnez (cbf_get_columnrow (&text, node, row))
+  int i;
 
+  if (!handle)
 
-      /* Compare the values */
+    return CBF_ARGUMENT;
 
-    if (text && value)
-    {
-      if (strcmp (text + 1, value))
 
-        continue;
-    }
-    else
+    /* Find the save frame or data block node */
 
-      if (text != value)
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-        continue;
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
+  }
 
-      /* Found a match */
 
-    handle->row = row;
+    /* Find the first child that is a category*/
 
-    handle->search_row = row + 1;
+  for (i = 0; (unsigned int)i < node->children; i++) {
 
-    return 0;
-  }
+    cbf_failnez (cbf_get_child (&child_node, node, i))
 
-  return CBF_NOTFOUND;
+    if (child_node && child_node->type == CBF_CATEGORY) {
 
-}
+      handle->node = child_node;
 
-  /* Make the next row with matching value the current row,
-     creating the row if necessary */
+      /* Success */
 
-int cbf_require_nextrow (cbf_handle handle, const char *value)
-{
+      return 0;
 
-  if (cbf_find_nextrow(handle, value)) {
-  
-    cbf_failnez( cbf_new_row(handle))
-    
-    return cbf_set_value(handle, value);
-  	
+    }
   }
-  
-  return 0;
+
+  return CBF_NOTFOUND;
 
 }
 
 
-  /* Count the data blocks */
+  /* Make the first save frame or category in the current data block the current save frame or category */
 
-int cbf_count_datablocks (cbf_handle handle, unsigned int *datablocks)
+int cbf_rewind_blockitem (cbf_handle handle, CBF_NODETYPE * type)
 {
   cbf_node *node;
 
+  cbf_node *child_node;
+
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the root node */
+    /* Find the data block node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
 
-    /* Count the data blocks */
+    /* Find the first child */
 
-  return cbf_count_children (datablocks, node);
-}
+  cbf_failnez (cbf_get_child (&child_node, node, 0))
+
+  handle->node = child_node;
 
+  *type = child_node->type;
 
-  /* Count the save frames in the current data block */
+    /* Success */
 
-int cbf_count_saveframes (cbf_handle handle, unsigned int *saveframes)
+  return 0;
+
+}
+
+  /* Make the first column in the current category the current column */
+
+int cbf_rewind_column (cbf_handle handle)
 {
   cbf_node *node;
 
@@ -2979,46 +3317,52 @@ int cbf_count_saveframes (cbf_handle handle, unsigned int *saveframes)
     return CBF_ARGUMENT;
 
 
-    /* Find the data block node */
+    /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
 
-    /* Count the save frames */
+    /* Find the first child */
 
-  return cbf_count_typed_children (saveframes, node, CBF_SAVEFRAME);
+  cbf_failnez (cbf_get_child (&node, node, 0))
+
+  handle->node = node;
+
+
+    /* Success */
+
+  return 0;
 }
 
-  /* Count the categories in the current save frame or data block */
 
-int cbf_count_categories (cbf_handle handle, unsigned int *categories)
-{
-  cbf_node *node;
+  /* Make the first row in the current category the current row */
 
+int cbf_rewind_row (cbf_handle handle)
+{
   if (!handle)
 
     return CBF_ARGUMENT;
 
+  handle->row = 0;
 
-    /* Find the data block node */
+  handle->search_row = 0;
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+    /* Success */
 
-  }
+  return 0;
+}
 
 
-    /* Count the categories */
+  /* Make the next data block the current data block */
 
-  return cbf_count_typed_children (categories, node, CBF_CATEGORY);
-}
+int cbf_next_datablock (cbf_handle handle)
+{
+  cbf_node *parent, *node;
 
-  /* Count the items in the current data block */
+    int error;
 
-int cbf_count_blockitems (cbf_handle handle, unsigned int *blockitems)
-{
-  cbf_node *node;
+  unsigned int index;
 
   if (!handle)
 
@@ -3030,41 +3374,51 @@ int cbf_count_blockitems (cbf_handle handle, unsigned int *blockitems)
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
 
-    /* Count the categories */
+    /* Find the root node */
 
-  return cbf_count_children (blockitems, node);
-}
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_ROOT))
 
 
-  /* Count the columns in the current category */
+    /* Which child is this? */
 
-int cbf_count_columns (cbf_handle handle, unsigned int *columns)
-{
-  cbf_node *node;
+  cbf_failnez (cbf_child_index (&index, node))
 
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* Get the next data block */
 
+    error = cbf_get_child (&node, parent, index + 1);
 
-    /* Find the category node */
+    if (!error)
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+      error = cbf_build_datablock (handle, node, index + 1);
 
+    if (!error) {
 
-    /* Count the columns */
+  handle->node = node;
 
-  return cbf_count_children (columns, node);
+
+    /* Success */
+
+  return 0;
+        
+    } else {
+        
+      return error;
+        
 }
 
+}
 
-  /* Count the rows in the current category */
 
-int cbf_count_rows (cbf_handle handle, unsigned int *rows)
+  /* Make the next category in the current save frame or data block the current category */
+
+int cbf_next_category (cbf_handle handle)
 {
-  cbf_node *node, *parent;
+  cbf_node *parent, *node;
 
-  unsigned int columns, column, columnrows, categoryrows;
+  int i;
+
+  unsigned int index;
 
   if (!handle)
 
@@ -3073,126 +3427,149 @@ int cbf_count_rows (cbf_handle handle, unsigned int *rows)
 
     /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&parent, handle->node, CBF_CATEGORY))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
 
-    /* Count the columns */
+    /* Find the save frame or data block node */
 
-  cbf_failnez (cbf_count_children (&columns, parent))
+  if (cbf_find_parent (&parent, node, CBF_SAVEFRAME)) {
 
+    cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
-    /* Get the size of each column */
+  }
 
-  categoryrows = 0;
 
-  for (column = 0; column < columns; column++)
-  {
-      /* Get the column */
+    /* Which child is this? */
 
-    cbf_failnez (cbf_get_child (&node, parent, column))
+  cbf_failnez (cbf_child_index (&index, node))
 
 
-      /* Count the number of rows */
+    /* Get the next category */
 
-    cbf_failnez (cbf_count_children (&columnrows, node))
+  for (i = index+1; (unsigned int)i<parent->children; i++) {
 
+    cbf_failnez (cbf_get_child (&node, parent, i))
 
-      /* Is it the same size as the other columns? */
-
-    if (column == 0)
+    if (node->type == CBF_CATEGORY) {
 
-      categoryrows = columnrows;
+      handle->node = node;
 
-    else
+      /* Success */
 
-      if (categoryrows < columnrows)
+      return 0;
+    }
 
-          categoryrows = columnrows;
- 
   }
 
-  if (rows)
-
-    *rows = categoryrows;
-
-
-    /* Success */
-
-  return 0;
+  return CBF_NOTFOUND;
 }
 
 
-  /* Get the name of the current data block */
+  /* Make the next save frame in the current data block the current save frame */
 
-int cbf_datablock_name (cbf_handle handle, const char **datablockname)
+int cbf_next_saveframe (cbf_handle handle)
 {
-  cbf_node *node;
+  cbf_node *parent, *node;
+
+  int i;
+
+  unsigned int index;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Find the data block node */
+    /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
 
 
-    /* Get the name */
+    /* Find the data block node */
 
-  return cbf_get_name (datablockname, node);
-}
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
 
-  /* Get the name of the current save frame */
+    /* Which child is this? */
 
-int cbf_saveframe_name (cbf_handle handle, const char **saveframename)
-{
-  cbf_node *node;
+  cbf_failnez (cbf_child_index (&index, node))
 
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* Get the next save frame */
 
+  for (i = index+1; (unsigned int)i<parent->children; i++) {
 
-    /* Find the data block node */
+    cbf_failnez (cbf_get_child (&node, parent, i))
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
+    if (node->type == CBF_SAVEFRAME) {
 
+      handle->node = node;
 
-    /* Get the name */
+      /* Success */
 
-  return cbf_get_name (saveframename, node);
+      return 0;
+    }
+
+  }
+
+  return CBF_NOTFOUND;
 }
 
 
-  /* Get the name of the current category */
+  /* Make the next save frame or category the current data block or category */
 
-int cbf_category_name (cbf_handle handle, const char **categoryname)
+int cbf_next_blockitem (cbf_handle handle, CBF_NODETYPE * type)
 {
-  cbf_node *node;
+  cbf_node *parent, *node;
+
+  unsigned int index;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
+    /* Discover if we are in a save frame or just in a data block */
 
-    /* Find the category node */
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+    /* There is no save frame look for a category */
 
+    cbf_failnez(cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-    /* Get the name */
+  }
 
-  return cbf_get_name (categoryname, node);
+     /* Find the root node */
+
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
+
+    /* Which child is this? */
+
+  cbf_failnez (cbf_child_index (&index, node))
+
+
+    /* Get the next data block */
+
+  cbf_failnez (cbf_get_child (&node, parent, index + 1))
+
+  handle->node = node;
+
+  *type = handle->node->type;
+
+    /* Success */
+
+  return 0;
 }
 
 
-  /* Get the name of the current column */
+  /* Make the next column in the current category the current column */
 
-int cbf_column_name (cbf_handle handle, const char **columnname)
-{
-  cbf_node *node;
+int cbf_next_column (cbf_handle handle) {
+    
+  cbf_node *parent, *node;
+
+    int error;
+    
+  unsigned int index;
 
   if (!handle)
 
@@ -3204,89 +3581,44 @@ int cbf_column_name (cbf_handle handle, const char **columnname)
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
 
-    /* Get the name */
+    /* Find the category node */
 
-  return cbf_get_name (columnname, node);
-}
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_CATEGORY))
 
-    
-    /* Change the name of the current column */
-    
-int cbf_set_column_name (cbf_handle handle, const char *columnname)
-{
-    cbf_node *node;
-    
-    int errorcode;
-    
-    if (!handle)
-        
-        return CBF_ARGUMENT;
-    
-    
-    /* Find the column node */
-    
-    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
-    
-    
-    /* Copy the name */
-    
-    if (columnname)
-    {
-        columnname = cbf_copy_string (NULL, columnname, 0);
-        
-        if (!columnname)
-            
-            return CBF_ALLOC;
-    }
-    
-    
-    /* Change the name */
-    
-    errorcode = cbf_name_node (node, columnname);
-    
-    if (errorcode)
-    {
-        cbf_free_string (NULL, columnname);
-        
-        return errorcode;
-    }
-    
-    
-    /* Success */
-    
-    handle->node = node;
-    
-    return 0;
-}
-    
 
+    /* Which child is this? */
 
-  /* Get the number of the current row */
+  cbf_failnez (cbf_child_index (&index, node))
 
-int cbf_row_number (cbf_handle handle, unsigned int *row)
-{
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* Get the next column */
 
-  if (row)
+    error = cbf_get_child (&node, parent, index + 1);
 
-    *row = handle->row;
+    if (!error) {
+        
+  handle->node = node;
 
 
     /* Success */
 
   return 0;
+        
+    } else {
+        
+        return error;
 }
 
+}
 
 
-  /* Get the number of the current column */
+  /* Make the next row in the current category the current row */
 
-int cbf_column_number (cbf_handle handle, unsigned int *column)
+int cbf_next_row (cbf_handle handle)
 {
+  cbf_node *node;
 
-  cbf_node *parent, *node;
+  unsigned int rows;
 
   if (!handle)
 
@@ -3297,15 +3629,18 @@ int cbf_column_number (cbf_handle handle, unsigned int *column)
 
   cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
+  cbf_failnez (cbf_count_children (&rows, node))
 
-    /* Find the category node */
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_CATEGORY))
+    /* Is the row valid? */
 
+  if (handle->row >= 0 && (unsigned int)(handle->row) >= rows)
 
-    /* Which child is this? */
+    return CBF_NOTFOUND;
 
-  cbf_failnez (cbf_child_index (column, node))
+  handle->row++;
+
+  handle->search_row = handle->row;
 
 
     /* Success */
@@ -3314,34 +3649,30 @@ int cbf_column_number (cbf_handle handle, unsigned int *column)
 }
 
 
-  /* Get the number of the current block item */
+  /* Make the specified data block the current data block */
 
-int cbf_blockitem_number (cbf_handle handle, unsigned int *blockitem)
+int cbf_select_datablock (cbf_handle handle, unsigned int datablock)
 {
-  
-  cbf_node *parent, *node;
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
-    
-    /* Discover if we are in a save frame or just in a data block */
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-    /* There is no save frame look for a category */
+    /* Find the root node */
 
-    cbf_failnez(cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-  }
 
-     /* Find the root node */
+    /* Select the data block */
 
-  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
+  cbf_failnez (cbf_get_child (&node, node, datablock))
 
-    /* Which child is this? */
+  cbf_failnez (cbf_build_datablock (handle, node, datablock))
+
+  handle->node = node;
 
-  cbf_failnez (cbf_child_index (blockitem, node))
 
     /* Success */
 
@@ -3349,180 +3680,160 @@ int cbf_blockitem_number (cbf_handle handle, unsigned int *blockitem)
 }
 
 
-  /* Get the ascii value of the current (row, column) entry */
+  /* Make the specified save frame the current save frame */
 
-int cbf_get_value (cbf_handle handle, const char **value)
+int cbf_select_saveframe (cbf_handle handle, unsigned int saveframe)
 {
-  const char *text;
+  cbf_node *node;
 
+  cbf_node *child_node;
 
-    /* Check the arguments */
+  unsigned int isf, jsf;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Is the value binary? */
+  /* Find the data block node */
 
-  if (cbf_is_binary (handle->node, handle->row))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-    return CBF_BINARY;
 
+  /* Select the save frame */
 
-    /* Get the value */
+  isf = 0;
 
-  cbf_failnez (cbf_get_columnrow (&text, handle->node, handle->row))
+  jsf = 0;
 
-  if (value) {
+  while (jsf < saveframe+1 && isf < node->children) {
 
-    if (text) {
+    cbf_failnez (cbf_get_child (&child_node, node, isf++))
 
-      *value = text + 1;
+    if (child_node->type == CBF_SAVEFRAME) jsf++;
 
-    } else {
+  }
 
-      *value = NULL;
-    }
-
-  }
+  if (jsf == saveframe+1) {
 
+    handle->node = child_node;
 
     /* Success */
 
-  return 0;
+    return 0;
+
+  }
+
+  return CBF_NOTFOUND;
 }
 
 
-  /* Set the ascii value of the current (row, column) entry */
+  /* Make the specified category the current category */
 
-int cbf_set_value (cbf_handle handle, const char *value)
+int cbf_select_category (cbf_handle handle, unsigned int category)
 {
-  int errorcode;
+  cbf_node *node;
 
+  cbf_node *child_node;
 
-    /* Check the arguments */
+  unsigned int icat, jcat;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Copy the string */
+    /* Find the data block node */
 
-  if (value)
-  {
-    value = cbf_copy_string (NULL, value, '\200');
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-    if (!value)
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-      return CBF_ALLOC;
   }
 
 
-    /* Set the new value */
+    /* Select the category */
 
-  errorcode = cbf_set_columnrow (handle->node, handle->row, value, 1);
+  icat = 0;
 
-  if (errorcode)
-  {
-    cbf_free_string (NULL, value);
+  jcat = 0;
+
+  while (jcat < category+1 && icat < node->children) {
+
+    cbf_failnez (cbf_get_child (&child_node, node, icat++))
+
+    if (child_node->type == CBF_CATEGORY) jcat++;
 
-    return errorcode;
   }
 
+  if (jcat == category+1) {
 
-    /* Success */
+    handle->node = child_node;
 
-  return 0;
-}
+    /* Success */
 
-  /* Get the ascii value of the current (row, column) entry,
-     setting it to a default value if necessary */
+    return 0;
 
-int cbf_require_value (cbf_handle handle, const char **value, 
-                                          const char *defaultvalue)
-{
-  if (cbf_get_value (handle, value) || !*value) 
-  {
-  	 cbf_failnez (cbf_set_value(handle, defaultvalue))
-  	 
-  	 return (cbf_get_value(handle, value));
   }
-  
-  return 0;
+
+  return CBF_NOTFOUND;
 }
 
 
-  /* Set the ascii type value of the current (row, column) entry */
+  /* Make the specified category or save frame the current block item */
 
-int cbf_set_typeofvalue (cbf_handle handle, const char *typeofvalue)
+int cbf_select_blockitem (cbf_handle handle, unsigned int item, CBF_NODETYPE * type)
 {
-  char *text;
+  cbf_node *node;
 
-    /* Check the arguments */
+  cbf_node *child_node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
-    /* Is the value binary? */
 
-  if (cbf_is_binary (handle->node, handle->row))
+    /* Find the data block node */
 
-    return CBF_BINARY;
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-    /* Get the value */
 
-  cbf_failnez (cbf_get_columnrow ((const char **)(&text), handle->node, handle->row))
+    /* Select the item */
 
-  cbf_failnez (cbf_set_value_type(handle, text, typeofvalue))
+  cbf_failnez (cbf_get_child (&child_node, node, item))
+
+  handle->node = child_node;
+
+  *type = child_node->type;
 
     /* Success */
 
   return 0;
+
 }
 
-  /* Get the ascii type of value of the current (row, column) entry */
+  /* Make the specified column the current column */
 
-int cbf_get_typeofvalue (cbf_handle handle, const char **typeofvalue)
+int cbf_select_column (cbf_handle handle, unsigned int column)
 {
-  const char *text;
-
-    /* Check the arguments */
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
-    /* Get the value */
-    
-  cbf_failnez (cbf_get_columnrow (&text, handle->node, handle->row))
-
-
-    /* Is the value binary? */
-
-  if (cbf_is_binary (handle->node, handle->row)) {
 
-    *typeofvalue = "bnry";
-
-    return 0;
-
-  }
-
-  if (typeofvalue) {
+    /* Find the category node */
 
-    if (text) {
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-      cbf_failnez (cbf_get_value_type(text, typeofvalue))
 
-    } else {
+    /* Select the column */
 
-      *typeofvalue = NULL;
+  cbf_failnez (cbf_get_child (&node, node, column))
 
-    }
+  handle->node = node;
 
-  }
 
     /* Success */
 
@@ -3530,152 +3841,67 @@ int cbf_get_typeofvalue (cbf_handle handle, const char **typeofvalue)
 }
 
 
+  /* Make the specified row the current row */
 
-  /* Get the (int) numeric value of the current (row, column) entry */
-
-int cbf_get_integervalue (cbf_handle handle, int *number)
+int cbf_select_row (cbf_handle handle, unsigned int row)
 {
-  const char *value;
+  cbf_node *node;
 
-  const char *typeofvalue;
+  unsigned int rows;
 
+  if (!handle)
 
-    /* Get the value */
+    return CBF_ARGUMENT;
 
-  cbf_failnez (cbf_get_value (handle, &value))
-    
-  cbf_failnez (cbf_get_typeofvalue (handle, &typeofvalue))
-    
-  if (!typeofvalue || cbf_cistrcmp(typeofvalue,"null") == 0 ) {
-        
-    if (number) *number = 0;
-        
-    return 0;
-        
-  }
-    
 
+    /* Find the column node */
 
-    /* Convert it into an integer */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
-  if (!value)
+  cbf_failnez (cbf_count_children (&rows, node))
 
-    return CBF_NOTFOUND;
 
-  if (number)
+    /* Is the row valid? */
 
-    *number = atoi (value);
+  if (row >= rows)
 
+    return CBF_NOTFOUND;
 
-    /* Success */
+  handle->row = row;
 
-  return 0;
-}
+  handle->search_row = row;
 
-    /* Get the (long) numeric value of the current (row, column) entry */
 
-int cbf_get_longvalue (cbf_handle handle, long *number)
-{
-    const char *value;
-    
-    const char *typeofvalue;
-    
-    
-    /* Get the value */
-    
-    cbf_failnez (cbf_get_value (handle, &value))
-    
-    cbf_failnez (cbf_get_typeofvalue (handle, &typeofvalue))
-    
-    if (!typeofvalue || cbf_cistrcmp(typeofvalue,"null") == 0 ) {
-        
-        if (number) *number = 0;
-        
-        return 0;
-        
-    }
-    
-    
-    
-    /* Convert it into an integer */
-    
-    if (!value)
-        
-        return CBF_NOTFOUND;
-    
-    if (number)
-        
-        *number = atol (value);
-    
-    
     /* Success */
-    
-    return 0;
-}
 
+  return 0;
+}
 
 
-  /* Get the (double) numeric value of the current (row, column) entry */
+  /* Make the named data block the current data block */
 
-int cbf_get_doublevalue (cbf_handle handle, double *number)
+int cbf_find_datablock (cbf_handle handle, const char *datablockname)
 {
-  const char *value;
-    
-  const char *typeofvalue;
-  
-  char buffer[80];
-  
-  char *endptr;
+  cbf_node *node;
 
+  if (!handle)
 
-    /* Get the value */
+    return CBF_ARGUMENT;
 
-  cbf_failnez (cbf_get_value (handle, &value))
-    
-  cbf_failnez (cbf_get_typeofvalue (handle, &typeofvalue))
 
-  if (!typeofvalue || cbf_cistrcmp(typeofvalue,"null") == 0 ) {
-      
-      if (number) *number = 0.;
-    
-      return 0;
-      
-  }
+    /* Find the root node */
 
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-    /* Convert it into a double */
 
-  if (!value)
+    /* Find the data block */
 
-    return CBF_NOTFOUND;
+  cbf_failnez (cbf_find_child (&node, node, datablockname))
 
-  if (number) {
-  
-    *number = strtod(value,&endptr);
-    
-    if (!*endptr) return 0;
-    
-    memcpy(buffer,value,79);
-    
-    buffer[79] = '\0';
-    
-    if (*endptr == '.' && (endptr-value) < 80) *(buffer+(endptr-value)) = ',';
-    
-    if (!cbf_cistrncmp(buffer,",",80) || !cbf_cistrncmp(buffer,"?",80)) {
-    
-      *number = 0;
-      
-      return 0;
-    	
-    }
-    
-    *number = strtod(buffer,&endptr);
+  cbf_failnez (cbf_build_datablock (handle, node, 0))
+
+  handle->node = node;
 
-    if (!*endptr || *endptr==' ') return 0;
-    
-    return CBF_FORMAT;
-  	
-  }
 
     /* Success */
 
@@ -3683,2938 +3909,5661 @@ int cbf_get_doublevalue (cbf_handle handle, double *number)
 }
 
 
-  /* Set the ascii value of the current (row, column) entry from an int */
+  /* Make the named save frame in the current data block the current save frame */
 
-int cbf_set_integervalue (cbf_handle handle, int number)
+int cbf_find_saveframe (cbf_handle handle, const char *saveframename)
 {
-  char value [64];
+  cbf_node *node;
 
+  if (!handle)
 
-    /* Write the value */
+    return CBF_ARGUMENT;
 
-  sprintf (value, "%d", number);
 
+    /* Find the data block node */
 
-    /* Save it */
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  return cbf_set_value (handle, value);
+
+
+    /* Find the save frame */
+
+  cbf_failnez (cbf_find_typed_child (&node, node, saveframename, CBF_SAVEFRAME))
+
+  handle->node = node;
+
+  handle->row = 0;
+
+  handle->search_row = 0;
+
+
+    /* Success */
+
+  return 0;
 }
 
 
-  /* Set the ascii value of the current (row, column) entry from a double */
 
-int cbf_set_doublevalue (cbf_handle handle, const char *format, double number)
+  /* Make the named category in the current save frame or data block the current category */
+
+int cbf_find_category (cbf_handle handle, const char *categoryname)
 {
-  char value [64];
+  cbf_node *node;
 
-  int lopos, hipos, ic;
+    int error;
 
+  if (!handle)
 
-    /* Write the value */
+    return CBF_ARGUMENT;
 
-  sprintf (value, format, number);
 
-    /* strip the leading and trailing blanks */
+    /* Find the data block node */
 
-  for (lopos=0; (value[lopos]==' '||value[lopos]=='\t'); lopos++);
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-  for (hipos=strlen(value+lopos); hipos>0&&(value[lopos+hipos-1]==' '||value[lopos+hipos-1]=='\t'); hipos--);
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  *(value+lopos+hipos) = '\0';
-  
-    /* undo locale conversions of '.' to ',' */
+  }
+
+
+    /* Find the category */
+
+    error = cbf_find_typed_child (&node, node, categoryname, CBF_CATEGORY);
+
+    if (!error) {
+
+  handle->node = node;
+
+  handle->row = 0;
+
+  handle->search_row = 0;
+
+
+    /* Success */
+
+  return 0;
+        
+    } else {
+        
+        return error;
+        
+}
+}
+
+
+  /* Make the named column in the current category the current column */
+
+int cbf_find_column (cbf_handle handle, const char *columnname) {
     
-  for (ic = 0; ic < (int)strlen(value+lopos); ic++)
-    if (value[lopos+ic] == ',') value[lopos+ic] = '.';
+  cbf_node *node;
 
+    int error;
+    
+  if (!handle)
 
-    /* Save it */
+    return CBF_ARGUMENT;
 
-  return cbf_set_value (handle, value+lopos);
+
+    /* Find the category node */
+
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
+
+
+    /* Find the column */
+
+    error = cbf_find_child (&node, node, columnname);
+
+    if (!error) {
+        
+  handle->node = node;
+
+
+    /* Success */
+
+        return CBF_SUCCESS;
+        
+    } else {
+        
+        return error;
+        
 }
 
-  /* Get the integer value of the current (row, column) entry,
-     setting it to a default value if necessary */
+}
 
-int cbf_require_integervalue (cbf_handle handle, int *number, 
-                                          int defaultvalue)
+
+  /* Make the first row with matching value the current row */
+
+int cbf_find_row (cbf_handle handle, const char *value)
 {
-  if (cbf_get_integervalue (handle, number)) 
-  {
-  	 cbf_failnez (cbf_set_integervalue(handle, defaultvalue))
-  	 
-  	 return (cbf_get_integervalue(handle, number));
-  }
-  
-  return 0;
+  cbf_failnez (cbf_rewind_row (handle))
+
+  return cbf_find_nextrow (handle, value);
 }
 
-  /* Get the integer value of the current (row, column) entry,
-     setting it to a default value if necessary */
 
-int cbf_require_doublevalue (cbf_handle handle, double *number, 
-                                          double defaultvalue)
+
+  /* Make the first row with matching value the current row
+     creating it if necessary */
+
+int cbf_require_row (cbf_handle handle, const char *value)
 {
-  if (cbf_get_doublevalue (handle, number)) 
-  {
-  	 cbf_failnez (cbf_set_doublevalue(handle, "%-.15g", defaultvalue))
-  	 
-  	 return (cbf_get_doublevalue(handle, number));
+  if (cbf_rewind_row (handle)) {
+
+    cbf_failnez(cbf_new_row (handle))
+    
+    return cbf_set_value (handle, value);
+  	
   }
-  
-  return 0;
+
+  return cbf_require_nextrow (handle, value);
 }
 
+  /* Make the next row with matching value the current row */
 
+int cbf_find_nextrow (cbf_handle handle, const char *value)
+{
+  cbf_node *node;
 
-  /* Get the parameters of the current (row, column) array entry */
+  unsigned int row, rows;
 
-int cbf_get_arrayparameters (cbf_handle    handle,
-                                    unsigned int *compression,
-                                    int          *id,
-                                    size_t       *elsize,
-                                    int          *elsigned,
-                                    int          *elunsigned,
-                                    size_t       *nelem,
-                                    int          *minelem,
-                                    int          *maxelem,
-                                    int          *realarray)
-{
-    /* Check the arguments */
+  const char *text;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Is the value binary? */
+    /* Find the column node */
 
-  if (!cbf_is_binary (handle->node, handle->row))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
-    return CBF_ASCII;
 
+    /* Count the rows */
 
-    /* Get the parameters */
+  cbf_failnez (cbf_count_children (&rows, node))
 
-  return cbf_binary_parameters (handle->node, handle->row,
-                                compression, id, NULL, elsize,
-                                elsigned, elunsigned, nelem,
-                                minelem, maxelem, realarray,
-                                NULL, NULL, NULL, NULL, NULL);
-}
+  for (row = handle->search_row; row < rows; row++)
+  {
+      /* Is the value ascii? */
 
+    if (cbf_is_binary (node, row))
 
+      continue;
 
-  /* Get the parameters of the current (row, column) array entry */
 
-int cbf_get_arrayparameters_wdims (cbf_handle    handle,
-                                    unsigned int *compression,
-                                    int          *id,
-                                    size_t       *elsize,
-                                    int          *elsigned,
-                                    int          *elunsigned,
-                                    size_t       *nelem,
-                                    int          *minelem,
-                                    int          *maxelem,
-                                    int          *realarray,
-                                    const char  **byteorder,
-                                    size_t       *dimfast,
-                                    size_t       *dimmid,
-                                    size_t       *dimslow,
-                                    size_t       *padding)
-{
-    /* Check the arguments */
+      /* Get the value of the current row */
 
-  if (!handle)
+    cbf_failnez (cbf_get_columnrow (&text, node, row))
 
-    return CBF_ARGUMENT;
 
+      /* Compare the values */
 
-    /* Is the value binary? */
+    if (text && value)
+    {
+      if (strcmp (text + 1, value))
 
-  if (!cbf_is_binary (handle->node, handle->row))
+        continue;
+    }
+    else
 
-    return CBF_ASCII;
+      if (text != value)
 
+        continue;
 
-    /* Get the parameters */
 
-  return cbf_binary_parameters (handle->node, handle->row,
-                                compression, id, NULL, elsize,
-                                elsigned, elunsigned, nelem,
-                                minelem, maxelem, realarray,
-                                byteorder, dimfast, dimmid, dimslow, padding);
+      /* Found a match */
+
+    handle->row = row;
+
+    handle->search_row = row + 1;
+
+    return 0;
+  }
+
+  return CBF_NOTFOUND;
+
 }
 
+  /* Make the next row with matching value the current row,
+     creating the row if necessary */
 
-    /* Get the dimensions of the current (row, column) array entry
-     from the CBF tags */
-    
+int cbf_require_nextrow (cbf_handle handle, const char *value)
+{
+
+  if (cbf_find_nextrow(handle, value)) {
+  
+    cbf_failnez( cbf_new_row(handle))
     
-    int cbf_get_arraydimensions(cbf_handle handle, 
-                                size_t * dimover,
-                                size_t * dimfast,
-                                size_t * dimmid,
-                                size_t * dimslow) {
-        cbf_node *column;
-        
-        unsigned int row;
-        
-        cbf_node *category;
-        
-        cbf_node *asl_category;
-        
-        cbf_node *asl_array_id_col;
-        
-        cbf_node *asl_precedence_col;
-        
-        cbf_node *asl_dimension_col;
-        
-        cbf_node *datablock;
-        
-        cbf_node *array_id_column;
-        
-        const char * array_id;
-        
-        const char * asl_array_id;
-        
-        const char * asl_dimension;
-        
-        const char * asl_precedence;
-        
-        long precedence;
-        
-        unsigned int asl_row, asl_rows;
-        
-        size_t asl_dims[3];
-        
-        asl_dims[0] = asl_dims[1] = asl_dims[2] = 0;
-        
-        
-        /* Check the arguments */
-        
-        if (!handle)
-            
-            return CBF_ARGUMENT;
-        
-        
-        /* Is the value binary? */
-        
-        if (!cbf_is_binary (handle->node, handle->row))
-            
-            return CBF_ASCII;
-        
-        column = handle->node;
-        
-        row = handle->row;
-        
-        /* Follow any links */
-        
-        column = cbf_get_link (column);
-        
-        
-        /* Check the arguments */
-        
-        if (!column)
-            
-            return CBF_ARGUMENT;
-        
-        
-        /* Check the node type */
-        
-        if (column->type != CBF_COLUMN)
-            
-            return CBF_ARGUMENT;
-        
-        
-        if (!column)
-            
-            return CBF_ARGUMENT;
-        
-        
-        /* Check the node type */
-        
-        if (column->type != CBF_COLUMN)
-            
-            return CBF_ARGUMENT;
-        
-        
-        /* Find the parent category */
-        
-        cbf_failnez(cbf_find_parent(&category,column,CBF_CATEGORY))
-        
-        if (!(category->name) || cbf_cistrncmp(category->name,"array_data",11) ) return CBF_ARGUMENT;
-        
-        /* Find the array id */
-        
-        cbf_failnez (cbf_find_child (&array_id_column, category, "array_id"))
-        
-        if (cbf_is_binary(array_id_column,row)) return CBF_FORMAT;
-        
-        cbf_failnez(cbf_get_columnrow(&array_id, array_id_column,row ))
-        
-        if (!array_id) return CBF_FORMAT;
-        
-        array_id++;
-        
-        
-        /* Find the parent save frame or data block node */
-        
-        if (cbf_find_parent (&datablock, category, CBF_SAVEFRAME)) {
-            
-            cbf_failnez (cbf_find_parent (&datablock, category, CBF_DATABLOCK))
-            
-        }
-        
-        /* Find the array_structure_list category and extract the dimensions with their precedence
-         for the given array_id */
-        
-        cbf_failnez(cbf_find_typed_child (&asl_category, datablock, "array_structure_list", CBF_CATEGORY))
-        
-        cbf_failnez(cbf_find_typed_child (&asl_array_id_col,   asl_category, "array_id", CBF_COLUMN))
-        
-        cbf_failnez(cbf_find_typed_child (&asl_precedence_col, asl_category, "precedence", CBF_COLUMN))
-        
-        cbf_failnez(cbf_find_typed_child (&asl_dimension_col,  asl_category, "dimension", CBF_COLUMN))
-        
-        cbf_failnez (cbf_count_children (&asl_rows, asl_array_id_col))
-        
-        for (asl_row = 0; asl_row < asl_rows; asl_row++) {
-            
-            /* Is the value ascii? */
-            
-            if (cbf_is_binary (asl_array_id_col, asl_row) ||
-                cbf_is_binary (asl_precedence_col, asl_row) ||
-                cbf_is_binary (asl_dimension_col, asl_row))
-                
-                continue;
-
+    return cbf_set_value(handle, value);
+  	
+  }
+  
+  return 0;
 
-            /* Get the value of the current row */
-            
-            cbf_failnez (cbf_get_columnrow (&asl_array_id, asl_array_id_col, asl_row))
-            
-            /* Compare the values 
-             If the array_id matches, then store the dimension according to the precedence
-             */
-            
-            if (asl_array_id && !strcmp(asl_array_id+1,array_id)) {
-                
-                cbf_failnez(cbf_get_columnrow (&asl_precedence, asl_precedence_col, asl_row))
-                
-                cbf_failnez(cbf_get_columnrow (&asl_dimension, asl_dimension_col, asl_row))
-                
-                if (asl_precedence && asl_dimension) {
-                    
-                    precedence = atol(asl_precedence+1);
-                    
-                    if (precedence > 0 && precedence < 4) asl_dims[precedence-1] = atol(asl_dimension+1);
-                    
-                }
-                
-            }
-            
-        }
-        
-        if (dimover) *dimover = 1;
-        
-        for (precedence = 0; precedence < 3; precedence++) {
-            
-            if (asl_dims[precedence] > 0) {
-                
-                if (dimover) *dimover *= asl_dims[precedence];
-                
-                switch (precedence) {
-                        
-                    case 0:  if (dimfast) *dimfast = asl_dims[precedence]; break;
-                    case 1:  if (dimmid)  *dimmid  = asl_dims[precedence]; break;
-                    case 2:  if (dimslow) *dimslow = asl_dims[precedence]; break;
-                        
-                }
-                
-            }
-        }
-        
-        return 0;
-        
-    }
-    
-    
+}
 
 
-  /* Get the parameters of the current (row, column) integer array entry */
+  /* Count the data blocks */
 
-int cbf_get_integerarrayparameters (cbf_handle    handle,
-                                    unsigned int *compression,
-                                    int          *id,
-                                    size_t       *elsize,
-                                    int          *elsigned,
-                                    int          *elunsigned,
-                                    size_t       *nelem,
-                                    int          *minelem,
-                                    int          *maxelem)
+int cbf_count_datablocks (cbf_handle handle, unsigned int *datablocks)
 {
-  int realarray;
-  
-    /* Check the arguments */
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Is the value binary? */
-
-  if (!cbf_is_binary (handle->node, handle->row))
+    /* Find the root node */
 
-    return CBF_ASCII;
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
 
-    /* Get the parameters */
+    /* Count the data blocks */
 
-  return cbf_binary_parameters (handle->node, handle->row,
-                                compression, id, NULL, elsize,
-                                elsigned, elunsigned, nelem,
-                                minelem, maxelem, &realarray,
-                                NULL, NULL, NULL, NULL, NULL);
+  return cbf_count_children (datablocks, node);
 }
 
-  /* Get the parameters of the current (row, column) integer array entry */
-  
 
-int cbf_get_integerarrayparameters_wdims (cbf_handle    handle,
-                                    unsigned int *compression,
-                                    int          *id,
-                                    size_t       *elsize,
-                                    int          *elsigned,
-                                    int          *elunsigned,
-                                    size_t       *nelem,
-                                    int          *minelem,
-                                    int          *maxelem,
-                                    const char  **byteorder,
-                                    size_t       *dimfast,
-                                    size_t       *dimmid,
-                                    size_t       *dimslow,
-                                    size_t       *padding)
-{
-  int realarray;
+  /* Count the save frames in the current data block */
 
-    /* Check the arguments */
+int cbf_count_saveframes (cbf_handle handle, unsigned int *saveframes)
+{
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Is the value binary? */
+    /* Find the data block node */
 
-  if (!cbf_is_binary (handle->node, handle->row))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-    return CBF_ASCII;
 
+    /* Count the save frames */
 
-    /* Get the parameters */
+  return cbf_count_typed_children (saveframes, node, CBF_SAVEFRAME);
+}
 
-  return cbf_binary_parameters (handle->node, handle->row,
-                                compression, id, NULL, elsize,
-                                elsigned, elunsigned, nelem,
-                                minelem, maxelem, &realarray,
-                                byteorder,dimfast,dimmid,dimslow,padding);
-}
-
-
-  /* Get the parameters of the current (row, column) array entry */
+  /* Count the categories in the current save frame or data block */
 
-int cbf_get_realarrayparameters (cbf_handle    handle,
-                                    unsigned int *compression,
-                                    int          *id,
-                                    size_t       *elsize,
-                                    size_t       *nelem)
+int cbf_count_categories (cbf_handle handle, unsigned int *categories)
 {
-
-    /* Check the arguments */
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Is the value binary? */
+    /* Find the data block node */
 
-  if (!cbf_is_binary (handle->node, handle->row))
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-    return CBF_ASCII;
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
+  }
 
-    /* Get the parameters */
 
-  return cbf_binary_parameters (handle->node, handle->row,
-                                compression, id, NULL, elsize,
-                                NULL, NULL, nelem,
-                                NULL, NULL, NULL,
-                                NULL, NULL, NULL, NULL, NULL);
-}
+    /* Count the categories */
 
+  return cbf_count_typed_children (categories, node, CBF_CATEGORY);
+}
 
-  /* Get the parameters of the current (row, column) array entry */
+  /* Count the items in the current data block */
 
-int cbf_get_realarrayparameters_wdims (cbf_handle    handle,
-                                    unsigned int *compression,
-                                    int          *id,
-                                    size_t       *elsize,
-                                    size_t       *nelem,
-                                    const char  **byteorder,
-                                    size_t       *dimfast,
-                                    size_t       *dimmid,
-                                    size_t       *dimslow,
-                                    size_t       *padding)
+int cbf_count_blockitems (cbf_handle handle, unsigned int *blockitems)
 {
-    /* Check the arguments */
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
 
-    /* Is the value binary? */
-
-  if (!cbf_is_binary (handle->node, handle->row))
+    /* Find the data block node */
 
-    return CBF_ASCII;
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
 
-    /* Get the parameters */
+    /* Count the categories */
 
-  return cbf_binary_parameters (handle->node, handle->row,
-                                compression, id, NULL, elsize,
-                                NULL, NULL, nelem,
-                                NULL, NULL, NULL,
-                                byteorder,dimfast,dimmid,dimslow,padding);
+  return cbf_count_children (blockitems, node);
 }
 
 
+  /* Count the columns in the current category */
 
-  /* Get the integer value of the current (row, column) array entry */
-
-int cbf_get_integerarray (cbf_handle  handle,
-                          int        *id,
-                          void       *value,
-                          size_t      elsize,
-                          int         elsign,
-                          size_t      nelem,
-                          size_t     *nelem_read)
+int cbf_count_columns (cbf_handle handle, unsigned int *columns)
 {
-
-  int realarray;
-  
-  const char *byteorder;
-  
-  size_t dimover, dimfast, dimmid, dimslow, padding;
+  cbf_node *node;
 
   if (!handle)
 
     return CBF_ARGUMENT;
 
-  return cbf_get_binary (handle->node, handle->row, id,
-                         value, elsize, elsign, nelem, nelem_read, &realarray,
-                         &byteorder,&dimover, &dimfast, &dimmid, &dimslow, &padding);
-}
 
+    /* Find the category node */
 
-  /* Get the real value of the current (row, column) array entry */
-
-int cbf_get_realarray (cbf_handle  handle,
-                          int        *id,
-                          void       *value,
-                          size_t      elsize,
-                          size_t      nelem,
-                          size_t     *nelem_read)
-{
-  int realarray;
-  
-  const char *byteorder;
-  
-  size_t dimover, dimfast, dimmid, dimslow, padding;
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* Count the columns */
 
-  return cbf_get_binary (handle->node, handle->row, id,
-                         value, elsize, 1, nelem, nelem_read, &realarray,
-                         &byteorder, &dimover, &dimfast, &dimmid, &dimslow, &padding);
+  return cbf_count_children (columns, node);
 }
 
 
-  /* Set the integer value of the current (row, column) array entry */
+  /* Count the rows in the current category */
 
-int cbf_set_integerarray (cbf_handle    handle,
-                          unsigned int  compression,
-                          int           id,
-                          void         *value,
-                          size_t        elsize,
-                          int           elsign,
-                          size_t        nelem)
+int cbf_count_rows (cbf_handle handle, unsigned int *rows)
 {
-  if (!handle)
-
-    return CBF_ARGUMENT;
-
-  return cbf_set_binary (handle->node, handle->row,
-                         compression, id, value, elsize, elsign, nelem, 0,
-                         "little_endian", nelem, 0, 0, 0, 0);
-}
+  cbf_node *node, *parent;
 
-  /* Set the integer value of the current (row, column) array entry */
+  unsigned int columns, column, columnrows, categoryrows;
 
-int cbf_set_integerarray_wdims (cbf_handle    handle,
-                          unsigned int  compression,
-                          int           id,
-                          void         *value,
-                          size_t        elsize,
-                          int           elsign,
-                          size_t        nelem,
-                          const char   *byteorder,
-                          size_t        dimfast,
-                          size_t        dimmid,
-                          size_t        dimslow,
-                          size_t        padding)
-{
   if (!handle)
 
     return CBF_ARGUMENT;
 
-  return cbf_set_binary (handle->node, handle->row,
-                         compression, id, value, elsize, elsign, nelem, 0,
-                         byteorder, nelem, dimfast, dimmid, dimslow, padding);
-}
 
+    /* Find the category node */
 
-  /* Set the real value of the current (row, column) array entry */
+  cbf_failnez (cbf_find_parent (&parent, handle->node, CBF_CATEGORY))
 
-int cbf_set_realarray (cbf_handle    handle,
-                          unsigned int  compression,
-                          int           id,
-                          void         *value,
-                          size_t        elsize,
-                          size_t        nelem)
-{
-  if (!handle)
 
-    return CBF_ARGUMENT;
+    /* Count the columns */
 
-  return cbf_set_binary (handle->node, handle->row,
-                         compression, id, value, elsize, 1, nelem, 1,
-                         "little_endian", nelem, 0, 0, 0, 0);
-}
+  cbf_failnez (cbf_count_children (&columns, parent))
 
-  /* Set the real value of the current (row, column) array entry
-     with dimensions */
 
-int cbf_set_realarray_wdims (cbf_handle    handle,
-                          unsigned int  compression,
-                          int           id,
-                          void         *value,
-                          size_t        elsize,
-                          size_t        nelem,
-                          const char   *byteorder,
-                          size_t        dimfast,
-                          size_t        dimmid,
-                          size_t        dimslow,
-                          size_t        padding)
-{
-  if (!handle)
+    /* Get the size of each column */
 
-    return CBF_ARGUMENT;
+  categoryrows = 0;
 
-  return cbf_set_binary (handle->node, handle->row,
-                         compression, id, value, elsize, 1, nelem, 1,
-                         byteorder, nelem, dimfast, dimmid, dimslow, padding);
-}
+  for (column = 0; column < columns; column++)
+  {
+      /* Get the column */
 
+    cbf_failnez (cbf_get_child (&node, parent, column))
 
-  /* Issue a warning message */
 
-void cbf_warning (const char *message)
+      /* Count the number of rows */
 
-{
-  fprintf (stderr, " CBFlib: warning -- %s\n", message);
-}
+    cbf_failnez (cbf_count_children (&columnrows, node))
 
 
-  /* Issue an error message */
+      /* Is it the same size as the other columns? */
 
-void cbf_error (const char *message)
-{
-  fprintf (stderr, " CBFlib: error -- %s\n", message);
-}
+    if (column == 0)
 
+      categoryrows = columnrows;
 
-  /* Issue a log message for a cbf */
+    else
 
-void cbf_log (cbf_handle handle, const char *message, 
-                                 int logflags)
+      if (categoryrows < columnrows)
 
-{
-  char * buffer;
-  
-  void * memblock;
-  
-  int line=0, column=0;
-  
-  if (cbf_alloc(&memblock, NULL, 1, strlen(message)+80) ) {
+          categoryrows = columnrows;
+ 
+  }
 
-    if (handle->logfile) {
+  if (rows)
 
-      fprintf (handle->logfile, "CBFlib: memory allocation error\n");
+    *rows = categoryrows;
 
-    } else {
 
-      exit(CBF_ALLOC);
+    /* Success */
 
-    }  
-  
-    return;
+  return 0;
+}
 
-  }
-  
-  buffer = (char *)memblock;
-  
-  if (logflags & CBF_LOGCURRENTLOC) {
 
-    line = (handle->file->line);
+  /* Get the name of the current data block */
 
-    column = (handle->file->column);
+int cbf_datablock_name (cbf_handle handle, const char **datablockname)
+{
+  cbf_node *node;
 
-    logflags &= (~CBF_LOGWOLINE);
+  if (!handle)
 
-  } else if (logflags & CBF_LOGSTARTLOC) {
+    return CBF_ARGUMENT;
 
-  	line = (handle->startline);
 
-  	column = (handle->startcolumn);
+    /* Find the data block node */
 
-    logflags &= (~CBF_LOGWOLINE);
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-  } else {
 
-  	logflags |= CBF_LOGWOLINE;
+    /* Get the name */
 
-  }
-  
-  if (logflags&CBF_LOGERROR)  handle->errors++;
-  
-  else if (logflags&CBF_LOGWARNING) handle->warnings++;
+  return cbf_get_name (datablockname, node);
+}
 
-  if ( !handle->logfile ) return;
 
-  if ( handle->file) {
-  
-    if (logflags&CBF_LOGWOLINE)
+  /* Get the name of the current save frame */
 
-      sprintf (buffer, "CBFlib: %s -- %s\n",
-        (logflags&CBF_LOGERROR)?"error":
-        ((logflags&CBF_LOGWARNING)?("warning"):""), 
-        message);
-        
-    else if (logflags&CBF_LOGWOCOLUMN || column==0)  
+int cbf_saveframe_name (cbf_handle handle, const char **saveframename)
+{
+  cbf_node *node;
 
-      sprintf (buffer, "CBFlib: %s input line %d -- %s\n",
-        (logflags&CBF_LOGERROR)?"error":
-        ((logflags&CBF_LOGWARNING)?("warning"):""), 
-        line+1, 
-        message);  
-    
-    else
+  if (!handle)
 
-      sprintf (buffer, "CBFlib: %s input line %d (%d) -- %s\n",
-        (logflags&CBF_LOGERROR)?"error":
-        ((logflags&CBF_LOGWARNING)?("warning"):""), 
-        line+1, column,
-        message);  
+    return CBF_ARGUMENT;
 
-  } else {
 
-       sprintf (buffer, "CBFlib: %s -- %s\n",
-         (logflags&CBF_LOGERROR)?"error":
-         ((logflags&CBF_LOGWARNING)?("warning"):""),
-         message);
-  }
-  
-  fprintf (handle->logfile, "%s", buffer);
+    /* Find the data block node */
 
-  cbf_free(&memblock, NULL );
- 
-  return;
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
+
+
+    /* Get the name */
+
+  return cbf_get_name (saveframename, node);
 }
-  /* Issue a log message for a cbf_file */
 
-void cbf_flog (cbf_file *file, const char *message, 
-                                 int logflags)
 
+  /* Get the name of the current category */
+
+int cbf_category_name (cbf_handle handle, const char **categoryname)
 {
-  char * buffer;
-  
-  void * memblock;
-  
-  int line=0, column=0;
-  
-  if (cbf_alloc(&memblock, NULL, 1, strlen(message)+80) ) {
-  	  
-    if (file->logfile) {
+  cbf_node *node;
 
-      fprintf (file->logfile, "CBFlib: memory allocation error\n");
-    
-    } else {
+  if (!handle)
 
-      exit(CBF_ALLOC);
+    return CBF_ARGUMENT;
 
-    }
-    return;
 
-  }
-  
-  buffer = (char *)memblock;
-  
-  if (logflags & CBF_LOGCURRENTLOC) {
+    /* Find the category node */
 
-    line = (file->line);
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
-    column = (file->column);
 
-    logflags &= (~CBF_LOGWOLINE);
+    /* Get the name */
 
-  } else {
+  return cbf_get_name (categoryname, node);
+}
 
-  	logflags |= CBF_LOGWOLINE;
 
-  }
-  
-  if (logflags&CBF_LOGERROR)  file->errors++;
-  
-  else if (logflags&CBF_LOGWARNING) file->warnings++;
+  /* Get the name of the current column */
 
-  if ( !file->logfile ) return;
+int cbf_column_name (cbf_handle handle, const char **columnname)
+{
+  cbf_node *node;
 
-  if (logflags&CBF_LOGWOLINE)
+  if (!handle)
 
-      sprintf (buffer, "CBFlib: %s -- %s\n",
-        (logflags&CBF_LOGERROR)?"error":
-        ((logflags&CBF_LOGWARNING)?("warning"):""), 
-        message);
-        
-  else if (logflags&CBF_LOGWOCOLUMN || column==0)  
+    return CBF_ARGUMENT;
 
-      sprintf (buffer, "CBFlib: %s input line %d -- %s\n",
-        (logflags&CBF_LOGERROR)?"error":
-        ((logflags&CBF_LOGWARNING)?("warning"):""), 
-        line+1, 
-        message);  
-    
-  else
 
-      sprintf (buffer, "CBFlib: %s input line %d (%d) -- %s\n",
-        (logflags&CBF_LOGERROR)?"error":
-        ((logflags&CBF_LOGWARNING)?("warning"):""), 
-        line+1, column,
-        message);  
+    /* Find the column node */
 
-  fprintf (file->logfile, "%s", buffer);
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
-  cbf_free(&memblock, NULL );
- 
-  return;
+
+    /* Get the name */
+
+  return cbf_get_name (columnname, node);
+}
+
+    
+    /* Change the name of the current column */
+    
+int cbf_set_column_name (cbf_handle handle, const char *columnname)
+{
+    cbf_node *node;
+    
+    int errorcode;
+    
+    if (!handle)
+        
+        return CBF_ARGUMENT;
+    
+    
+    /* Find the column node */
+    
+    cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
+    
+    
+    /* Copy the name */
+    
+    if (columnname)
+    {
+        columnname = cbf_copy_string (NULL, columnname, 0);
+        
+        if (!columnname)
+            
+            return CBF_ALLOC;
+    }
+    
+    
+    /* Change the name */
+    
+    errorcode = cbf_name_node (node, columnname);
+    
+    if (errorcode)
+    {
+        cbf_free_string (NULL, columnname);
+        
+        return errorcode;
+    }
+    
+    
+    /* Success */
+    
+    handle->node = node;
+    
+    return 0;
 }
+    
 
 
-  /* Find a datablock, creating it if necessary */
+  /* Get the number of the current row */
 
-int cbf_require_datablock (cbf_handle  handle,
-                             const char *datablockname)
+int cbf_row_number (cbf_handle handle, unsigned int *row)
 {
-  if (cbf_find_datablock(handle, datablockname)) {
+  if (!handle)
 
-    cbf_failnez(cbf_new_datablock(handle, datablockname))
+    return CBF_ARGUMENT;
+
+  if (row)
+
+    *row = handle->row;
+
+
+    /* Success */
 
-  }
   return 0;
 }
 
 
-  /* Find a saveframe, creating it if necessary */
 
-int cbf_require_saveframe (cbf_handle  handle,
-                             const char *saveframename)
+  /* Get the number of the current column */
+
+int cbf_column_number (cbf_handle handle, unsigned int *column)
 {
-  if (cbf_find_saveframe(handle, saveframename)) {
 
-    cbf_failnez(cbf_new_saveframe(handle, saveframename))
+  cbf_node *parent, *node;
 
-  }
+  if (!handle)
 
-  return 0;
+    return CBF_ARGUMENT;
 
-}
 
-  /* Find a category, creating it if necessary */
+    /* Find the column node */
 
-int cbf_require_category (cbf_handle  handle,
-                             const char *categoryname)
-{
-  if (cbf_find_category(handle, categoryname)) {
-  
-    const char * datablockname;
-    
-    if (cbf_datablock_name(handle, &datablockname)) 
-    
-      cbf_failnez(cbf_require_datablock(handle,"(null)"))
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_COLUMN))
 
-    cbf_failnez(cbf_new_category(handle, categoryname))
 
-  }
-  return 0;
-}
+    /* Find the category node */
 
-  /* Find a column, creating it if necessary */
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_CATEGORY))
 
-int cbf_require_column (cbf_handle  handle,
-                             const char *columnname)
-{
-  unsigned int currow, rows;
-  
-  if (cbf_row_number(handle,&currow)) currow = 0;
-  
-  if (cbf_count_rows(handle,&rows))   rows = 0;
-  
 
-  if (cbf_find_column(handle, columnname)) {
+    /* Which child is this? */
 
-    cbf_failnez(cbf_count_rows(handle, &rows))
-    
-    cbf_failnez(cbf_new_column(handle, columnname))
-    
-    if (currow < rows) cbf_failnez(cbf_select_row(handle, currow))
+  cbf_failnez (cbf_child_index (column, node))
+
+
+    /* Success */
 
-  }
   return 0;
 }
 
 
-  /* Find a column value, return a default if necessary */
+  /* Get the number of the current block item */
 
-int cbf_require_column_value (cbf_handle  handle,
-                             const char *columnname,
-                             const char **value,
-                             const char *defaultvalue)
+int cbf_blockitem_number (cbf_handle handle, unsigned int *blockitem)
 {
-  if (!cbf_require_column(handle, columnname) &&
-      !cbf_get_value(handle, value)) {
+  
+  cbf_node *parent, *node;
 
-    return 0;
+  if (!handle)
 
-  } else {
+    return CBF_ARGUMENT;
+    
+    /* Discover if we are in a save frame or just in a data block */
 
-    cbf_failnez (cbf_set_value(handle, defaultvalue))
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME)) {
 
-    return cbf_get_value(handle, value);
+    /* There is no save frame look for a category */
+
+    cbf_failnez(cbf_find_parent (&node, handle->node, CBF_CATEGORY))
 
   }
-}
 
-  /* Find a column integer value, return a default if necessary */
+     /* Find the root node */
 
-int cbf_require_column_integervalue (cbf_handle  handle,
-                             const char *columnname,
-                             int *number,
-                             const int defaultvalue)
-{
-    if (!cbf_require_column(handle, columnname) &&
-      !cbf_get_integervalue(handle, number)) {
+  cbf_failnez (cbf_find_parent (&parent, node, CBF_DATABLOCK))
 
-      return 0;
+    /* Which child is this? */
 
-    } else {
-    
-      cbf_failnez (cbf_set_integervalue(handle, defaultvalue))
+  cbf_failnez (cbf_child_index (blockitem, node))
 
-      return cbf_get_integervalue(handle, number);
+    /* Success */
 
-    }
+  return 0;
 }
 
-  /* Find a column double value, return a default if necessary */
 
-int cbf_require_column_doublevalue (cbf_handle  handle,
-                             const char *columnname,
-                             double *number,
-                             const double defaultvalue)
+  /* Get the ascii value of the current (row, column) entry */
+
+int cbf_get_value (cbf_handle handle, const char **value)
 {
-    if (!cbf_require_column(handle, columnname) &&
-      !cbf_get_doublevalue(handle, number)) {
+  const char *text;
 
-      return 0;
 
-    } else {
+    /* Check the arguments */
 
-      cbf_failnez (cbf_set_doublevalue(handle, "%.15g", defaultvalue))
+  if (!handle)
 
-      return cbf_get_doublevalue(handle, number);
+    return CBF_ARGUMENT;
+
+
+    /* Is the value binary? */
+
+  if (cbf_is_binary (handle->node, handle->row))
 
+    return CBF_BINARY;
+
+
+    /* Get the value */
+
+  cbf_failnez (cbf_get_columnrow (&text, handle->node, handle->row))
+
+  if (value) {
+
+    if (text) {
+
+      *value = text + 1;
+
+    } else {
+
+      *value = NULL;
     }
+
+  }
+
+
+    /* Success */
+
+  return 0;
 }
 
 
-  /* Get the local byte order of the default integer type */
+  /* Set the ascii value of the current (row, column) entry */
 
-int cbf_get_local_integer_byte_order (char ** byte_order)
+int cbf_set_value (cbf_handle handle, const char *value)
 {
-   static char le[14] = "little_endian";
+  int errorcode;
 
-   static char be[11] = "big_endian";
 
-   int *test;
+    /* Check the arguments */
 
-   int probe = 1;
+  if (!handle)
 
-   test = (int *)&probe;
+    return CBF_ARGUMENT;
 
-   if (*(char*)test) *byte_order = le;
 
-   else *byte_order = be;
+    /* Copy the string */
 
-   return 0;
-}
+  if (value)
+  {
+    value = cbf_copy_string (NULL, value, '\200');
 
-  /* Get the local byte order of the default real type */
+    if (!value)
 
-int cbf_get_local_real_byte_order (char ** byte_order)
-{
-   static char le[14] = "little_endian";
+      return CBF_ALLOC;
+  }
 
-   static char be[11] = "big_endian";
 
-   double *test;
+    /* Set the new value */
 
-   double probe = 1.;
+  errorcode = cbf_set_columnrow (handle->node, handle->row, value, 1);
 
-   test = (double *)&probe;
+  if (errorcode)
+  {
+    cbf_free_string (NULL, value);
 
-   if (*(char*)test) *byte_order = be;
+    return errorcode;
+  }
 
-   else *byte_order = le;
 
-   return 0;
+    /* Success */
+
+  return 0;
 }
 
-  /* Get the local real format */
+  /* Get the ascii value of the current (row, column) entry,
+     setting it to a default value if necessary */
 
-int cbf_get_local_real_format (char ** real_format )
+int cbf_require_value (cbf_handle handle, const char **value, 
+                                          const char *defaultvalue)
 {
-   static char ieee[14] = "ieee 754-1985";
+  if (cbf_get_value (handle, value) || !*value) 
+  {
+  	 cbf_failnez (cbf_set_value(handle, defaultvalue))
+  	 
+  	 return (cbf_get_value(handle, value));
+  }
+  
+  return 0;
+}
 
-   static char other[6] = "other";
 
+  /* Set the ascii type value of the current (row, column) entry */
 
-   union ftest { float fltest; int itest; long ltest; } test;
+int cbf_set_typeofvalue (cbf_handle handle, const char *typeofvalue)
+{
+  char *text;
 
-   *real_format = other; 
+    /* Check the arguments */
 
-   test.fltest = 1.;
+  if (!handle)
 
-   if (sizeof (float) == sizeof (long) ) {
+    return CBF_ARGUMENT;
 
-     if ( test.ltest == 1065353216L ) *real_format = ieee;
+    /* Is the value binary? */
 
-   } else {
+  if (cbf_is_binary (handle->node, handle->row))
 
-     if (sizeof (float) == sizeof (int ) ) {
+    return CBF_BINARY;
 
-       if (test.itest == 1065353216 ) *real_format = ieee;
+    /* Get the value */
 
+  cbf_failnez (cbf_get_columnrow ((const char **)(&text), handle->node, handle->row))
 
-     }
-   }
+  cbf_failnez (cbf_set_value_type(handle, text, typeofvalue))
 
-   return 0;
+    /* Store it again, so that any number parsed from it is forgotten */
+
+  return cbf_set_columnrow (handle->node, handle->row, text, 0);
 }
 
-  /* Get the dictionary for a cbf */
+  /* Get the ascii type of value of the current (row, column) entry */
 
-int cbf_get_dictionary (cbf_handle handle, cbf_handle * dictionary)
+int cbf_get_typeofvalue (cbf_handle handle, const char **typeofvalue)
 {
-  if (handle &&
-    (*dictionary = (cbf_handle)(handle->dictionary)) ) return 0;
+  const char *text;
 
-  return CBF_NOTFOUND;
+    /* Check the arguments */
 
-}
+  if (!handle)
 
-  /* Set the dictionary for a cbf */
+    return CBF_ARGUMENT;
 
-int cbf_set_dictionary (cbf_handle handle, cbf_handle dictionary)
-{
-  if (!handle) return CBF_ARGUMENT;
+    /* Get the value */
+    
+  cbf_failnez (cbf_get_columnrow (&text, handle->node, handle->row))
 
-  if (handle->dictionary) {
 
-    cbf_failnez(cbf_free_handle((cbf_handle)(handle->dictionary)))
+    /* Is the value binary? */
+
+  if (cbf_is_binary (handle->node, handle->row)) {
+
+    *typeofvalue = "bnry";
+
+    return 0;
 
   }
 
-  * ((cbf_handle *)(&handle->dictionary)) = dictionary;
+  if (typeofvalue) {
 
-  (dictionary->refcount)++;
+    if (text) {
 
-  return 0;
+      cbf_failnez (cbf_get_value_type(text, typeofvalue))
+
+    } else {
+
+      *typeofvalue = NULL;
 
+    }
+
+  }
+
+    /* Success */
+
+  return 0;
 }
 
-  /* Get the dictionary for a cbf, or create one */
 
-int cbf_require_dictionary (cbf_handle handle, cbf_handle * dictionary)
+
+  /* Get the (int) numeric value of the current (row, column) entry */
+
+int cbf_get_integervalue (cbf_handle handle, int *number)
 {
-  if (!handle) return CBF_ARGUMENT;
+  const char *value;
 
-  if (!cbf_get_dictionary(handle, dictionary)) return 0;
+  const char *typeofvalue;
 
-  cbf_failnez (cbf_make_handle((cbf_handle *)&(handle->dictionary)))
+  long cached;
 
-  *dictionary = (cbf_handle)(handle->dictionary);
 
-  return 0;
+    /* Has the value been parsed before? */
 
-}
+  if (number && handle && !cbf_get_columnrow_long (&cached, handle->node, handle->row)) {
 
-  /* Put the value into the named column, updating the hash table links 
-  
-     If valuerow >= 0, the value is to be stored into the row of that
-     number.
-     
-     If valuerow < 0, the value is to be stored into a newly created row.
-     
-     For a given category of name <catname>, the hash table is
-     held in a category of name <catname>(hash_table), e.g.
-     if the category is "atom", the hastable is "atom(hash_table)".
-     For each column of name <colname> the hashtable links,
-     as integer row numbers are held in columns of name
-     <colname>(hash_index), e.g. if the column name is "label",
-     the hash index column name is "label(hash_index)".   The
-     same column name is used in both the hash table category
-     and the original category. 
-  
-  
-  
-  */
+    *number = (int) cached;
 
-int cbf_set_hashedvalue(cbf_handle handle, const char * value, 
-                                           const char * columnname, 
-                        int valuerow) {
-    
-    char colhashnext[91];
-    
-    char * category;
-    
-    const char * ovalue;
-    
-    
-    int ohashnext;
-    
-    char categoryhashtable[91];
-    
-    unsigned int hashcode, ohashcode;
-    
-    int orownum, rownum, nrownum=0, catrownum;
-    
-    int colnamelen, catnamelen;
-    
-    if ( !columnname ) return CBF_ARGUMENT;
+    return 0;
+
+  }
+
+
+    /* Get the value */
+
+  cbf_failnez (cbf_get_value (handle, &value))
     
-    if ( (colnamelen = strlen(columnname)) > 80 ) return CBF_ARGUMENT;
+  cbf_failnez (cbf_get_typeofvalue (handle, &typeofvalue))
     
-    cbf_failnez(cbf_category_name (handle, (const char * *)&category));
+  if (!typeofvalue || cbf_cistrcmp(typeofvalue,"null") == 0 ) {
+        
+    if (number) *number = 0;
+        
+    return 0;
+        
+  }
     
-    if ( (catnamelen = strlen(category)) > 80 ) return CBF_ARGUMENT;
+
+
+    /* Convert it into an integer */
+
+  if (!value)
+
+    return CBF_NOTFOUND;
+
+  if (number) {
+
+      /* Cache the full long value, so that a later cbf_get_longvalue
+         does not see the narrowed int */
+
+    cached = atol (value);
+
+    *number = (int) cached;
+
+      /* The caches of a shared dictionary are left alone */
+
+    if (!handle->readonly)
+
+      cbf_set_columnrow_long (handle->node, handle->row, cached);
+
+  }
+
+
+    /* Success */
+
+  return 0;
+}
+
+    /* Get the (long) numeric value of the current (row, column) entry */
+
+int cbf_get_longvalue (cbf_handle handle, long *number)
+{
+    const char *value;
     
-    strcpy (categoryhashtable,category);
+    const char *typeofvalue;
     
-    strcpy (categoryhashtable + catnamelen, "(hash_table)");
     
-    strcpy (colhashnext, columnname);
+    /* Has the value been parsed before? */
     
-    strcpy (colhashnext+colnamelen, "(hash_next)");
+    if (number && handle && !cbf_get_columnrow_long (number, handle->node, handle->row))
+        
+        return 0;
     
-    cbf_failnez( cbf_compute_hashcode(value, &hashcode))
     
-    cbf_failnez( cbf_require_column(handle, columnname))
+    /* Get the value */
     
-    /* If we are going to hash an existing row, we need to
-     
-     undo any existing hash to the same row */
+    cbf_failnez (cbf_get_value (handle, &value))
     
+    cbf_failnez (cbf_get_typeofvalue (handle, &typeofvalue))
     
-    if (valuerow >= 0) {
+    if (!typeofvalue || cbf_cistrcmp(typeofvalue,"null") == 0 ) {
         
-        cbf_failnez( cbf_select_row       (handle, valuerow))
+        if (number) *number = 0;
         
-        if (!cbf_get_value(handle,&ovalue) && ovalue
-            && !cbf_find_column(handle, colhashnext)
-            && !cbf_get_integervalue(handle, &ohashnext)) {
-            
-            cbf_failnez( cbf_compute_hashcode(ovalue, &ohashcode))
-            
-            if (hashcode != ohashcode)   {
-                
-                cbf_failnez( cbf_require_category (handle,   categoryhashtable))
-                
-                cbf_failnez( cbf_require_column   (handle,   colhashnext))
-                
-                cbf_failnez( cbf_select_row       (handle,   ohashcode))
-                
-                if ( ! cbf_get_integervalue (handle, &rownum)) {
-                    
-                    if (rownum == valuerow) {
-                        
-                        cbf_failnez(cbf_set_integervalue(handle,ohashnext))
-                        
-                    } else  {
-                        
-                        cbf_failnez( cbf_find_category    (handle,   category))
-                        
-                        cbf_failnez( cbf_find_column      (handle,   colhashnext))
-                        
-                        while ( rownum >=0 && rownum != valuerow)  {
-                            
-                            cbf_failnez( cbf_select_row     (handle,   rownum))
-                            
-                            orownum = -1;
-                            
-                            if (cbf_get_integervalue (handle,&orownum) || orownum <= rownum) {
-                                
-                                break;
-                                
-                            } else {
-                                
-                                if (orownum == valuerow) {
-                                    
-                                    cbf_failnez(cbf_set_integervalue(handle,ohashnext))
-                                    
-                                    break;
-                                    
-                                }
-                            }
-                            
-                            rownum = orownum;
-                            
-                        }
-                        
-                    }
-                    
-                }
-                
-            }
-            
-        }
+        return 0;
         
     }
     
     
-    cbf_failnez( cbf_find_category (handle,   category));
-    
     
-    cbf_failnez( cbf_find_column (handle,   columnname));
+    /* Convert it into an integer */
     
+    if (!value)
+        
+        return CBF_NOTFOUND;
     
-    if ( valuerow < 0 )  {
+    if (number) {
         
-        cbf_failnez( cbf_new_row          (handle));
+        *number = atol (value);
         
-    } else {
+        if (!handle->readonly)
         
-        cbf_failnez( cbf_select_row       (handle, valuerow));
+            cbf_set_columnrow_long (handle->node, handle->row, *number);
         
     }
     
-    cbf_failnez( cbf_set_value        (handle,    value))
-    
-    cbf_failnez( cbf_row_number       (handle,   (unsigned int *)&nrownum))
-    
-    cbf_debug_print4("cbf_set_hashed_value, category %s, column %s, row %ud", category, columnname, nrownum);
-    
-    cbf_debug_print2("cbf_set_hashed_value, value %s", value);
-    
-    cbf_failnez( cbf_require_column   (handle,   (const char *) colhashnext))
     
-    cbf_failnez( cbf_set_integervalue (handle,   -1))
+    /* Success */
     
-    cbf_failnez( cbf_require_category (handle,   categoryhashtable))
+    return 0;
+}
+
+
+
+  /* Convert the text of a value into a double */
+
+static int cbf_parse_doublevalue (const char *value, double *number)
+{
+  char buffer[80];
+  
+  char *endptr;
+
+  *number = strtod(value,&endptr);
     
-    cbf_failnez( cbf_require_column   (handle,   colhashnext))
+  if (!*endptr) return 0;
     
-    cbf_failnez( cbf_count_rows       (handle,   (unsigned int *)&catrownum))
+  strncpy(buffer,value,79);
     
-    if ((unsigned int)catrownum < hashcode+1) {
-        
-        for (rownum = catrownum; (unsigned int)rownum < hashcode+1; rownum++) {
-            
-            cbf_failnez(cbf_new_row(handle));
-            
-            cbf_failnez(cbf_set_integervalue(handle,-1));
-            
-        }
-        
-    }
+  buffer[79] = '\0';
     
+  if (*endptr == '.' && (endptr-value) < 80) *(buffer+(endptr-value)) = ',';
     
-    cbf_failnez( cbf_find_column      (handle, colhashnext))
+  if (!cbf_cistrncmp(buffer,",",80) || !cbf_cistrncmp(buffer,"?",80)) {
     
-    cbf_failnez( cbf_select_row       (handle, hashcode))
+    *number = 0;
+      
+    return 0;
+    	
+  }
     
-    if ( cbf_get_integervalue (handle, &rownum) || rownum == -1) {
-        
-        cbf_failnez( cbf_set_integervalue   (handle, nrownum))
-        
-        cbf_failnez( cbf_find_category      (handle, category))
-        
-        cbf_failnez( cbf_find_column        (handle,  colhashnext))
-        
-        cbf_failnez( cbf_select_row         (handle, nrownum))
-        
-        cbf_failnez( cbf_set_integervalue   (handle, -1))
-        
-        cbf_failnez( cbf_find_column        (handle, columnname))
-        
-        return 0;
-        
-    }
+  *number = strtod(buffer,&endptr);
+
+  if (!*endptr || *endptr==' ') return 0;
     
-    /* nrownum is the row number of the value
-     rownum is the row number of pointed to by the hash table
-     
-     If the hash table points higher up, reset the hashtable to
-     point to the new row.
-     
-     We will still have to relink the chain by having this row point
-     to rownum
-     
-     If the hash table point higher up, the hash table remains as
-     is, and the new link is inserted only in the main category
-     
-     */
+  return CBF_FORMAT;
+}
+
+
+  /* Get the (double) numeric value of the current (row, column) entry */
+
+int cbf_get_doublevalue (cbf_handle handle, double *number)
+{
+  const char *value;
     
-    if (nrownum < rownum) {
-        
-        cbf_failnez( cbf_set_integervalue(handle,nrownum))
-        
-    }
+  const char *typeofvalue;
+
+
+    /* Has the value been parsed before? */
+
+  if (number && handle && !cbf_get_columnrow_double (number, handle->node, handle->row))
+
+    return 0;
+
+
+    /* Get the value */
+
+  cbf_failnez (cbf_get_value (handle, &value))
     
-    cbf_failnez( cbf_find_category    (handle,   category))
+  cbf_failnez (cbf_get_typeofvalue (handle, &typeofvalue))
+
+  if (!typeofvalue || cbf_cistrcmp(typeofvalue,"null") == 0 ) {
+      
+      if (number) *number = 0.;
     
-    cbf_failnez( cbf_find_column      (handle,   colhashnext))
+      return 0;
+      
+  }
+
+
+    /* Convert it into a double */
+
+  if (!value)
+
+    return CBF_NOTFOUND;
+
+  if (number) {
+  
+    cbf_failnez (cbf_parse_doublevalue (value, number))
+
+    if (!handle->readonly)
+
+      cbf_set_columnrow_double (handle->node, handle->row, *number);
+  	
+  }
+
+    /* Success */
+
+  return 0;
+}
+
+
+  /* Set the ascii value of the current (row, column) entry from an int */
+
+int cbf_set_integervalue (cbf_handle handle, int number)
+{
+  char value [64];
+
+
+    /* Write the value */
+
+  sprintf (value, "%d", number);
+
+
+    /* Save it */
+
+  return cbf_set_value (handle, value);
+}
+
+
+  /* Set the ascii value of the current (row, column) entry from a double */
+
+int cbf_set_doublevalue (cbf_handle handle, const char *format, double number)
+{
+  char value [64];
+
+  int lopos, hipos, ic;
+
+
+    /* Write the value */
+
+  sprintf (value, format, number);
+
+    /* strip the leading and trailing blanks */
+
+  for (lopos=0; (value[lopos]==' '||value[lopos]=='\t'); lopos++);
+
+  for (hipos=strlen(value+lopos); hipos>0&&(value[lopos+hipos-1]==' '||value[lopos+hipos-1]=='\t'); hipos--);
+
+  *(value+lopos+hipos) = '\0';
+  
+    /* undo locale conversions of '.' to ',' */
     
-    if (rownum >= nrownum) {
+  for (ic = 0; ic < (int)strlen(value+lopos); ic++)
+    if (value[lopos+ic] == ',') value[lopos+ic] = '.';
+
+
+    /* Save it */
+
+  return cbf_set_value (handle, value+lopos);
+}
+
+  /* Get the integer value of the current (row, column) entry,
+     setting it to a default value if necessary */
+
+int cbf_require_integervalue (cbf_handle handle, int *number, 
+                                          int defaultvalue)
+{
+  if (cbf_get_integervalue (handle, number)) 
+  {
+  	 cbf_failnez (cbf_set_integervalue(handle, defaultvalue))
+  	 
+  	 return (cbf_get_integervalue(handle, number));
+  }
+  
+  return 0;
+}
+
+  /* Get the integer value of the current (row, column) entry,
+     setting it to a default value if necessary */
+
+int cbf_require_doublevalue (cbf_handle handle, double *number, 
+                                          double defaultvalue)
+{
+  if (cbf_get_doublevalue (handle, number)) 
+  {
+  	 cbf_failnez (cbf_set_doublevalue(handle, "%-.15g", defaultvalue))
+  	 
+  	 return (cbf_get_doublevalue(handle, number));
+  }
+  
+  return 0;
+}
+
+
+
+  /* Get the parameters of the current (row, column) array entry */
+
+int cbf_get_arrayparameters (cbf_handle    handle,
+                                    unsigned int *compression,
+                                    int          *id,
+                                    size_t       *elsize,
+                                    int          *elsigned,
+                                    int          *elunsigned,
+                                    size_t       *nelem,
+                                    int          *minelem,
+                                    int          *maxelem,
+                                    int          *realarray)
+{
+    /* Check the arguments */
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+
+    /* Is the value binary? */
+
+  if (!cbf_is_binary (handle->node, handle->row))
+
+    return CBF_ASCII;
+
+
+    /* Get the parameters */
+
+  return cbf_binary_parameters (handle->node, handle->row,
+                                compression, id, NULL, elsize,
+                                elsigned, elunsigned, nelem,
+                                minelem, maxelem, realarray,
+                                NULL, NULL, NULL, NULL, NULL);
+}
+
+
+
+  /* Get the parameters of the current (row, column) array entry */
+
+int cbf_get_arrayparameters_wdims (cbf_handle    handle,
+                                    unsigned int *compression,
+                                    int          *id,
+                                    size_t       *elsize,
+                                    int          *elsigned,
+                                    int          *elunsigned,
+                                    size_t       *nelem,
+                                    int          *minelem,
+                                    int          *maxelem,
+                                    int          *realarray,
+                                    const char  **byteorder,
+                                    size_t       *dimfast,
+                                    size_t       *dimmid,
+                                    size_t       *dimslow,
+                                    size_t       *padding)
+{
+    /* Check the arguments */
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+
+    /* Is the value binary? */
+
+  if (!cbf_is_binary (handle->node, handle->row))
+
+    return CBF_ASCII;
+
+
+    /* Get the parameters */
+
+  return cbf_binary_parameters (handle->node, handle->row,
+                                compression, id, NULL, elsize,
+                                elsigned, elunsigned, nelem,
+                                minelem, maxelem, realarray,
+                                byteorder, dimfast, dimmid, dimslow, padding);
+}
+
+
+    /* Get the dimensions of the current (row, column) array entry
+     from the CBF tags */
+    
+    
+    int cbf_get_arraydimensions(cbf_handle handle, 
+                                size_t * dimover,
+                                size_t * dimfast,
+                                size_t * dimmid,
+                                size_t * dimslow) {
+        cbf_node *column;
         
-        cbf_failnez( cbf_select_row         (handle, nrownum))
+        unsigned int row;
         
-        if (rownum > nrownum) {
-            
-            cbf_failnez( cbf_set_integervalue(handle, rownum))
-            
-        }
+        cbf_node *category;
         
-        if (cbf_get_integervalue (handle, &orownum)) {
-            
-            
-            cbf_failnez(cbf_set_integervalue (handle, -1))
-            
-        }
+        cbf_node *asl_category;
         
-        cbf_failnez( cbf_find_column        (handle, columnname))
+        cbf_node *asl_array_id_col;
         
-        return 0;
+        cbf_node *asl_precedence_col;
         
-    }
-    
-    
-    while ( rownum >=0 )  {
+        cbf_node *asl_dimension_col;
         
-        cbf_failnez( cbf_select_row     (handle,   rownum))
+        cbf_node *datablock;
         
-        orownum = -1;
+        cbf_node *array_id_column;
         
-        if (cbf_get_integervalue (handle,&orownum) || orownum < 0 || orownum >= nrownum) {
-            
-            cbf_failnez( cbf_set_integervalue   (handle, nrownum))
+        const char * array_id;
+        
+        const char * asl_array_id;
+        
+        const char * asl_dimension;
+        
+        const char * asl_precedence;
+        
+        long precedence;
+        
+        unsigned int asl_row, asl_rows;
+        
+        size_t asl_dims[3];
+        
+        asl_dims[0] = asl_dims[1] = asl_dims[2] = 0;
+        
+        
+        /* Check the arguments */
+        
+        if (!handle)
+            
+            return CBF_ARGUMENT;
+        
+        
+        /* Is the value binary? */
+        
+        if (!cbf_is_binary (handle->node, handle->row))
+            
+            return CBF_ASCII;
+        
+        column = handle->node;
+        
+        row = handle->row;
+        
+        /* Follow any links */
+        
+        column = cbf_get_link (column);
+        
+        
+        /* Check the arguments */
+        
+        if (!column)
+            
+            return CBF_ARGUMENT;
+        
+        
+        /* Check the node type */
+        
+        if (column->type != CBF_COLUMN)
+            
+            return CBF_ARGUMENT;
+        
+        
+        if (!column)
+            
+            return CBF_ARGUMENT;
+        
+        
+        /* Check the node type */
+        
+        if (column->type != CBF_COLUMN)
+            
+            return CBF_ARGUMENT;
+        
+        
+        /* Find the parent category */
+        
+        cbf_failnez(cbf_find_parent(&category,column,CBF_CATEGORY))
+        
+        if (!(category->name) || cbf_cistrncmp(category->name,"array_data",11) ) return CBF_ARGUMENT;
+        
+        /* Find the array id */
+        
+        cbf_failnez (cbf_find_child (&array_id_column, category, "array_id"))
+        
+        if (cbf_is_binary(array_id_column,row)) return CBF_FORMAT;
+        
+        cbf_failnez(cbf_get_columnrow(&array_id, array_id_column,row ))
+        
+        if (!array_id) return CBF_FORMAT;
+        
+        array_id++;
+        
+        
+        /* Find the parent save frame or data block node */
+        
+        if (cbf_find_parent (&datablock, category, CBF_SAVEFRAME)) {
+            
+            cbf_failnez (cbf_find_parent (&datablock, category, CBF_DATABLOCK))
+            
+        }
+        
+        /* Find the array_structure_list category and extract the dimensions with their precedence
+         for the given array_id */
+        
+        cbf_failnez(cbf_find_typed_child (&asl_category, datablock, "array_structure_list", CBF_CATEGORY))
+        
+        cbf_failnez(cbf_find_typed_child (&asl_array_id_col,   asl_category, "array_id", CBF_COLUMN))
+        
+        cbf_failnez(cbf_find_typed_child (&asl_precedence_col, asl_category, "precedence", CBF_COLUMN))
+        
+        cbf_failnez(cbf_find_typed_child (&asl_dimension_col,  asl_category, "dimension", CBF_COLUMN))
+        
+        cbf_failnez (cbf_count_children (&asl_rows, asl_array_id_col))
+        
+        for (asl_row = 0; asl_row < asl_rows; asl_row++) {
+            
+            /* Is the value ascii? */
+            
+            if (cbf_is_binary (asl_array_id_col, asl_row) ||
+                cbf_is_binary (asl_precedence_col, asl_row) ||
+                cbf_is_binary (asl_dimension_col, asl_row))
+                
+                continue;
+
+
+            /* Get the value of the current row */
+            
+            cbf_failnez (cbf_get_columnrow (&asl_array_id, asl_array_id_col, asl_row))
+            
+            /* Compare the values 
+             If the array_id matches, then store the dimension according to the precedence
+             */
+            
+            if (asl_array_id && !strcmp(asl_array_id+1,array_id)) {
+                
+                cbf_failnez(cbf_get_columnrow (&asl_precedence, asl_precedence_col, asl_row))
+                
+                cbf_failnez(cbf_get_columnrow (&asl_dimension, asl_dimension_col, asl_row))
+                
+                if (asl_precedence && asl_dimension) {
+                    
+                    precedence = atol(asl_precedence+1);
+                    
+                    if (precedence > 0 && precedence < 4) asl_dims[precedence-1] = atol(asl_dimension+1);
+                    
+                }
+                
+            }
+            
+        }
+        
+        if (dimover) *dimover = 1;
+        
+        for (precedence = 0; precedence < 3; precedence++) {
+            
+            if (asl_dims[precedence] > 0) {
+                
+                if (dimover) *dimover *= asl_dims[precedence];
+                
+                switch (precedence) {
+                        
+                    case 0:  if (dimfast) *dimfast = asl_dims[precedence]; break;
+                    case 1:  if (dimmid)  *dimmid  = asl_dims[precedence]; break;
+                    case 2:  if (dimslow) *dimslow = asl_dims[precedence]; break;
+                        
+                }
+                
+            }
+        }
+        
+        return 0;
+        
+    }
+    
+    
+
+
+  /* Get the parameters of the current (row, column) integer array entry */
+
+int cbf_get_integerarrayparameters (cbf_handle    handle,
+                                    unsigned int *compression,
+                                    int          *id,
+                                    size_t       *elsize,
+                                    int          *elsigned,
+                                    int          *elunsigned,
+                                    size_t       *nelem,
+                                    int          *minelem,
+                                    int          *maxelem)
+{
+  int realarray;
+  
+    /* Check the arguments */
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+
+    /* Is the value binary? */
+
+  if (!cbf_is_binary (handle->node, handle->row))
+
+    return CBF_ASCII;
+
+
+    /* Get the parameters */
+
+  return cbf_binary_parameters (handle->node, handle->row,
+                                compression, id, NULL, elsize,
+                                elsigned, elunsigned, nelem,
+                                minelem, maxelem, &realarray,
+                                NULL, NULL, NULL, NULL, NULL);
+}
+
+  /* Get the parameters of the current (row, column) integer array entry */
+  
+
+int cbf_get_integerarrayparameters_wdims (cbf_handle    handle,
+                                    unsigned int *compression,
+                                    int          *id,
+                                    size_t       *elsize,
+                                    int          *elsigned,
+                                    int          *elunsigned,
+                                    size_t       *nelem,
+                                    int          *minelem,
+                                    int          *maxelem,
+                                    const char  **byteorder,
+                                    size_t       *dimfast,
+                                    size_t       *dimmid,
+                                    size_t       *dimslow,
+                                    size_t       *padding)
+{
+  int realarray;
+
+    /* Check the arguments */
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+
+    /* Is the value binary? */
+
+  if (!cbf_is_binary (handle->node, handle->row))
+
+    return CBF_ASCII;
+
+
+    /* Get the parameters */
+
+  return cbf_binary_parameters (handle->node, handle->row,
+                                compression, id, NULL, elsize,
+                                elsigned, elunsigned, nelem,
+                                minelem, maxelem, &realarray,
+                                byteorder,dimfast,dimmid,dimslow,padding);
+}
+
+
+  /* Get the parameters of the current (row, column) array entry */
+
+int cbf_get_realarrayparameters (cbf_handle    handle,
+                                    unsigned int *compression,
+                                    int          *id,
+                                    size_t       *elsize,
+                                    size_t       *nelem)
+{
+
+    /* Check the arguments */
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+
+    /* Is the value binary? */
+
+  if (!cbf_is_binary (handle->node, handle->row))
+
+    return CBF_ASCII;
+
+
+    /* Get the parameters */
+
+  return cbf_binary_parameters (handle->node, handle->row,
+                                compression, id, NULL, elsize,
+                                NULL, NULL, nelem,
+                                NULL, NULL, NULL,
+                                NULL, NULL, NULL, NULL, NULL);
+}
+
+
+  /* Get the parameters of the current (row, column) array entry */
+
+int cbf_get_realarrayparameters_wdims (cbf_handle    handle,
+                                    unsigned int *compression,
+                                    int          *id,
+                                    size_t       *elsize,
+                                    size_t       *nelem,
+                                    const char  **byteorder,
+                                    size_t       *dimfast,
+                                    size_t       *dimmid,
+                                    size_t       *dimslow,
+                                    size_t       *padding)
+{
+    /* Check the arguments */
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+
+    /* Is the value binary? */
+
+  if (!cbf_is_binary (handle->node, handle->row))
+
+    return CBF_ASCII;
+
+
+    /* Get the parameters */
+
+  return cbf_binary_parameters (handle->node, handle->row,
+                                compression, id, NULL, elsize,
+                                NULL, NULL, nelem,
+                                NULL, NULL, NULL,
+                                byteorder,dimfast,dimmid,dimslow,padding);
+}
+
+
+
+  /* Get the integer value of the current (row, column) array entry */
+
+int cbf_get_integerarray (cbf_handle  handle,
+                          int        *id,
+                          void       *value,
+                          size_t      elsize,
+                          int         elsign,
+                          size_t      nelem,
+                          size_t     *nelem_read)
+{
+
+  int realarray;
+  
+  const char *byteorder;
+  
+  size_t dimover, dimfast, dimmid, dimslow, padding;
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+  return cbf_get_binary (handle->node, handle->row, id,
+                         value, elsize, elsign, nelem, nelem_read, &realarray,
+                         &byteorder,&dimover, &dimfast, &dimmid, &dimslow, &padding);
+}
+
+
+  /* Get the real value of the current (row, column) array entry */
+
+int cbf_get_realarray (cbf_handle  handle,
+                          int        *id,
+                          void       *value,
+                          size_t      elsize,
+                          size_t      nelem,
+                          size_t     *nelem_read)
+{
+  int realarray;
+  
+  const char *byteorder;
+  
+  size_t dimover, dimfast, dimmid, dimslow, padding;
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+  return cbf_get_binary (handle->node, handle->row, id,
+                         value, elsize, 1, nelem, nelem_read, &realarray,
+                         &byteorder, &dimover, &dimfast, &dimmid, &dimslow, &padding);
+}
+
+
+  /* Get the integer values of a region of interest of the current
+     (row, column) array entry, packed fast index first */
+
+int cbf_get_integerarray_roi (cbf_handle  handle,
+                              int        *id,
+                              void       *value,
+                              size_t      elsize,
+                              int         elsign,
+                              size_t      fastlow,
+                              size_t      fasthigh,
+                              size_t      midlow,
+                              size_t      midhigh,
+                              size_t      slowlow,
+                              size_t      slowhigh,
+                              size_t     *nelem_read)
+{
+  int realarray;
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+  return cbf_get_binary_roi (handle->node, handle->row, id,
+                             value, elsize, elsign,
+                             fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh,
+                             nelem_read, &realarray);
+}
+
+
+  /* Get the real values of a region of interest of the current
+     (row, column) array entry, packed fast index first */
+
+int cbf_get_realarray_roi (cbf_handle  handle,
+                           int        *id,
+                           void       *value,
+                           size_t      elsize,
+                           size_t      fastlow,
+                           size_t      fasthigh,
+                           size_t      midlow,
+                           size_t      midhigh,
+                           size_t      slowlow,
+                           size_t      slowhigh,
+                           size_t     *nelem_read)
+{
+  int realarray;
+
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+    /* Read the value if a lazy read left it null */
+
+  cbf_failnez (cbf_resolve_deferred (handle, 0))
+
+  return cbf_get_binary_roi (handle->node, handle->row, id,
+                             value, elsize, 1,
+                             fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh,
+                             nelem_read, &realarray);
+}
+
+
+  /* Set the integer value of the current (row, column) array entry */
+
+int cbf_set_integerarray (cbf_handle    handle,
+                          unsigned int  compression,
+                          int           id,
+                          void         *value,
+                          size_t        elsize,
+                          int           elsign,
+                          size_t        nelem)
+{
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+  return cbf_set_binary (handle->node, handle->row,
+                         compression, id, value, elsize, elsign, nelem, 0,
+                         "little_endian", nelem, 0, 0, 0, 0);
+}
+
+  /* Set the integer value of the current (row, column) array entry */
+
+int cbf_set_integerarray_wdims (cbf_handle    handle,
+                          unsigned int  compression,
+                          int           id,
+                          void         *value,
+                          size_t        elsize,
+                          int           elsign,
+                          size_t        nelem,
+                          const char   *byteorder,
+                          size_t        dimfast,
+                          size_t        dimmid,
+                          size_t        dimslow,
+                          size_t        padding)
+{
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+  return cbf_set_binary (handle->node, handle->row,
+                         compression, id, value, elsize, elsign, nelem, 0,
+                         byteorder, nelem, dimfast, dimmid, dimslow, padding);
+}
+
+
+  /* Set the real value of the current (row, column) array entry */
+
+int cbf_set_realarray (cbf_handle    handle,
+                          unsigned int  compression,
+                          int           id,
+                          void         *value,
+                          size_t        elsize,
+                          size_t        nelem)
+{
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+  return cbf_set_binary (handle->node, handle->row,
+                         compression, id, value, elsize, 1, nelem, 1,
+                         "little_endian", nelem, 0, 0, 0, 0);
+}
+
+  /* Set the real value of the current (row, column) array entry
+     with dimensions */
+
+int cbf_set_realarray_wdims (cbf_handle    handle,
+                          unsigned int  compression,
+                          int           id,
+                          void         *value,
+                          size_t        elsize,
+                          size_t        nelem,
+                          const char   *byteorder,
+                          size_t        dimfast,
+                          size_t        dimmid,
+                          size_t        dimslow,
+                          size_t        padding)
+{
+  if (!handle)
+
+    return CBF_ARGUMENT;
+
+  return cbf_set_binary (handle->node, handle->row,
+                         compression, id, value, elsize, 1, nelem, 1,
+                         byteorder, nelem, dimfast, dimmid, dimslow, padding);
+}
+
+
+  /* Set the current (row, column) entry to a copy of the current
+     binary entry of another handle, keeping the compressed data */
+
+int cbf_copy_binaryvalue (cbf_handle handle, cbf_handle source)
+{
+  if (!handle || !source)
+
+    return CBF_ARGUMENT;
+
+  if (!cbf_is_binary (source->node, source->row))
+
+    return CBF_ASCII;
+
+  return cbf_copy_binary (handle->node, handle->row,
+                          source->node, source->row);
+}
+
+
+  /* Set the current (row, column) entry to the integer array of the
+     current binary entry of another handle, recompressed with
+     byte-offset compression a tile at a time */
+
+int cbf_transcode_integerarray (cbf_handle    handle,
+                                cbf_handle    source,
+                                unsigned int  compression,
+                                size_t        dimfast,
+                                size_t        dimmid,
+                                size_t        dimslow)
+{
+  if (!handle || !source)
+
+    return CBF_ARGUMENT;
+
+  if (!cbf_is_binary (source->node, source->row))
+
+    return CBF_ASCII;
+
+  return cbf_transcode_binary (handle->node, handle->row,
+                               source->node, source->row,
+                               compression, dimfast, dimmid, dimslow);
+}
+
+
+  /* Issue a warning message */
+
+void cbf_warning (const char *message)
+
+{
+  fprintf (stderr, " CBFlib: warning -- %s\n", message);
+}
+
+
+  /* Issue an error message */
+
+void cbf_error (const char *message)
+{
+  fprintf (stderr, " CBFlib: error -- %s\n", message);
+}
+
+
+  /* Issue a log message for a cbf */
+
+void cbf_log (cbf_handle handle, const char *message, 
+                                 int logflags)
+
+{
+  char * buffer;
+  
+  void * memblock;
+  
+  int line=0, column=0;
+  
+  if (cbf_alloc(&memblock, NULL, 1, strlen(message)+80) ) {
+
+    if (handle->logfile) {
+
+      fprintf (handle->logfile, "CBFlib: memory allocation error\n");
+
+    } else {
+
+      exit(CBF_ALLOC);
+
+    }  
+  
+    return;
+
+  }
+  
+  buffer = (char *)memblock;
+  
+  if (logflags & CBF_LOGCURRENTLOC) {
+
+    line = (handle->file->line);
+
+    column = (handle->file->column);
+
+    logflags &= (~CBF_LOGWOLINE);
+
+  } else if (logflags & CBF_LOGSTARTLOC) {
+
+  	line = (handle->startline);
+
+  	column = (handle->startcolumn);
+
+    logflags &= (~CBF_LOGWOLINE);
+
+  } else {
+
+  	logflags |= CBF_LOGWOLINE;
+
+  }
+  
+  if (logflags&CBF_LOGERROR)  handle->errors++;
+  
+  else if (logflags&CBF_LOGWARNING) handle->warnings++;
+
+  if ( !handle->logfile ) {
+
+    cbf_free(&memblock, NULL );
+
+    return;
+
+  }
+
+  if ( handle->file) {
+  
+    if (logflags&CBF_LOGWOLINE)
+
+      sprintf (buffer, "CBFlib: %s -- %s\n",
+        (logflags&CBF_LOGERROR)?"error":
+        ((logflags&CBF_LOGWARNING)?("warning"):""), 
+        message);
+        
+    else if (logflags&CBF_LOGWOCOLUMN || column==0)  
+
+      sprintf (buffer, "CBFlib: %s input line %d -- %s\n",
+        (logflags&CBF_LOGERROR)?"error":
+        ((logflags&CBF_LOGWARNING)?("warning"):""), 
+        line+1, 
+        message);  
+    
+    else
+
+      sprintf (buffer, "CBFlib: %s input line %d (%d) -- %s\n",
+        (logflags&CBF_LOGERROR)?"error":
+        ((logflags&CBF_LOGWARNING)?("warning"):""), 
+        line+1, column,
+        message);  
+
+  } else {
+
+       sprintf (buffer, "CBFlib: %s -- %s\n",
+         (logflags&CBF_LOGERROR)?"error":
+         ((logflags&CBF_LOGWARNING)?("warning"):""),
+         message);
+  }
+  
+  fprintf (handle->logfile, "%s", buffer);
+
+  cbf_free(&memblock, NULL );
+ 
+  return;
+}
+  /* Issue a log message for a cbf_file */
+
+void cbf_flog (cbf_file *file, const char *message, 
+                                 int logflags)
+
+{
+  char * buffer;
+  
+  void * memblock;
+  
+  int line=0, column=0;
+  
+  if (cbf_alloc(&memblock, NULL, 1, strlen(message)+80) ) {
+  	  
+    if (file->logfile) {
+
+      fprintf (file->logfile, "CBFlib: memory allocation error\n");
+    
+    } else {
+
+      exit(CBF_ALLOC);
+
+    }
+    return;
+
+  }
+  
+  buffer = (char *)memblock;
+  
+  if (logflags & CBF_LOGCURRENTLOC) {
+
+    line = (file->line);
+
+    column = (file->column);
+
+    logflags &= (~CBF_LOGWOLINE);
+
+  } else {
+
+  	logflags |= CBF_LOGWOLINE;
+
+  }
+  
+  if (logflags&CBF_LOGERROR)  file->errors++;
+  
+  else if (logflags&CBF_LOGWARNING) file->warnings++;
+
+  if ( !file->logfile ) {
+
+    cbf_free(&memblock, NULL );
+
+    return;
+
+  }
+
+  if (logflags&CBF_LOGWOLINE)
+
+      sprintf (buffer, "CBFlib: %s -- %s\n",
+        (logflags&CBF_LOGERROR)?"error":
+        ((logflags&CBF_LOGWARNING)?("warning"):""), 
+        message);
+        
+  else if (logflags&CBF_LOGWOCOLUMN || column==0)  
+
+      sprintf (buffer, "CBFlib: %s input line %d -- %s\n",
+        (logflags&CBF_LOGERROR)?"error":
+        ((logflags&CBF_LOGWARNING)?("warning"):""), 
+        line+1, 
+        message);  
+    
+  else
+
+      sprintf (buffer, "CBFlib: %s input line %d (%d) -- %s\n",
+        (logflags&CBF_LOGERROR)?"error":
+        ((logflags&CBF_LOGWARNING)?("warning"):""), 
+        line+1, column,
+        message);  
+
+  fprintf (file->logfile, "%s", buffer);
+
+  cbf_free(&memblock, NULL );
+ 
+  return;
+}
+
+
+  /* Find a datablock, creating it if necessary */
+
+int cbf_require_datablock (cbf_handle  handle,
+                             const char *datablockname)
+{
+  if (cbf_find_datablock(handle, datablockname)) {
+
+    cbf_failnez(cbf_new_datablock(handle, datablockname))
+
+  }
+  return 0;
+}
+
+
+  /* Find a saveframe, creating it if necessary */
+
+int cbf_require_saveframe (cbf_handle  handle,
+                             const char *saveframename)
+{
+  if (cbf_find_saveframe(handle, saveframename)) {
+
+    cbf_failnez(cbf_new_saveframe(handle, saveframename))
+
+  }
+
+  return 0;
+
+}
+
+  /* Find a category, creating it if necessary */
+
+int cbf_require_category (cbf_handle  handle,
+                             const char *categoryname)
+{
+  if (cbf_find_category(handle, categoryname)) {
+  
+    const char * datablockname;
+    
+    if (cbf_datablock_name(handle, &datablockname)) 
+    
+      cbf_failnez(cbf_require_datablock(handle,"(null)"))
+
+    cbf_failnez(cbf_new_category(handle, categoryname))
+
+  }
+  return 0;
+}
+
+  /* Find a column, creating it if necessary */
+
+int cbf_require_column (cbf_handle  handle,
+                             const char *columnname)
+{
+  unsigned int currow, rows;
+  
+  if (cbf_row_number(handle,&currow)) currow = 0;
+  
+  if (cbf_count_rows(handle,&rows))   rows = 0;
+  
+
+  if (cbf_find_column(handle, columnname)) {
+
+    cbf_failnez(cbf_count_rows(handle, &rows))
+    
+    cbf_failnez(cbf_new_column(handle, columnname))
+    
+    if (currow < rows) cbf_failnez(cbf_select_row(handle, currow))
+
+  }
+  return 0;
+}
+
+
+  /* Find a column value, return a default if necessary */
+
+int cbf_require_column_value (cbf_handle  handle,
+                             const char *columnname,
+                             const char **value,
+                             const char *defaultvalue)
+{
+  if (!cbf_require_column(handle, columnname) &&
+      !cbf_get_value(handle, value)) {
+
+    return 0;
+
+  } else {
+
+    cbf_failnez (cbf_set_value(handle, defaultvalue))
+
+    return cbf_get_value(handle, value);
+
+  }
+}
+
+  /* Find a column integer value, return a default if necessary */
+
+int cbf_require_column_integervalue (cbf_handle  handle,
+                             const char *columnname,
+                             int *number,
+                             const int defaultvalue)
+{
+    if (!cbf_require_column(handle, columnname) &&
+      !cbf_get_integervalue(handle, number)) {
+
+      return 0;
+
+    } else {
+    
+      cbf_failnez (cbf_set_integervalue(handle, defaultvalue))
+
+      return cbf_get_integervalue(handle, number);
+
+    }
+}
+
+  /* Find a column double value, return a default if necessary */
+
+int cbf_require_column_doublevalue (cbf_handle  handle,
+                             const char *columnname,
+                             double *number,
+                             const double defaultvalue)
+{
+    if (!cbf_require_column(handle, columnname) &&
+      !cbf_get_doublevalue(handle, number)) {
+
+      return 0;
+
+    } else {
+
+      cbf_failnez (cbf_set_doublevalue(handle, "%.15g", defaultvalue))
+
+      return cbf_get_doublevalue(handle, number);
+
+    }
+}
+
+
+  /* Get the text of a row of a column for the bulk accessors, setting
+     it to NULL for a null or missing value and marking the mask */
+
+static int cbf_get_column_text (cbf_node *column, unsigned int row,
+                                const char **value, char *mask)
+{
+  const char *text, *typeofvalue;
+
+  *value = NULL;
+
+  if (mask)
+
+    *mask = CBF_MASK_UNKNOWN;
+
+  if (cbf_get_columnrow (&text, column, row) || !text)
+
+    return 0;
+
+  if (cbf_is_binary (column, row))
+
+    return CBF_BINARY;
+
+  cbf_failnez (cbf_get_value_type (text, &typeofvalue))
+
+  if (!typeofvalue || !cbf_cistrcmp (typeofvalue, "null"))
+  {
+    if (mask && text [1] == '.')
+
+      *mask = CBF_MASK_INAPPLICABLE;
+
+    return 0;
+  }
+
+  if (mask)
+
+    *mask = CBF_MASK_VALUE;
+
+  *value = text + 1;
+
+  return 0;
+}
+
+
+  /* Get the double values of a named column of the current category */
+
+int cbf_get_doublecolumn (cbf_handle handle, const char *columnname,
+                          double *values, char *mask,
+                          size_t nelem, size_t *nelem_read)
+{
+  cbf_node *column;
+
+  const char *value;
+
+  unsigned int row, rows;
+
+
+    /* Check the arguments */
+
+  if (!handle || !columnname || (nelem && !values))
+
+    return CBF_ARGUMENT;
+
+
+    /* Find the column */
+
+  cbf_failnez (cbf_find_column (handle, columnname))
+
+  cbf_failnez (cbf_count_rows (handle, &rows))
+
+  column = handle->node;
+
+  if (rows > nelem)
+
+    rows = nelem;
+
+
+    /* Convert each row, using the numbers already parsed */
+
+  for (row = 0; row < rows; row++)
+  {
+    if (!cbf_get_columnrow_double (values + row, column, row))
+    {
+      if (mask)
+
+        mask [row] = CBF_MASK_VALUE;
+
+      continue;
+    }
+
+    cbf_failnez (cbf_get_column_text (column, row, &value, mask ? mask + row : NULL))
+
+    if (!value)
+    {
+      values [row] = 0.;
+
+      continue;
+    }
+
+    cbf_failnez (cbf_parse_doublevalue (value, values + row))
+
+    cbf_set_columnrow_double (column, row, values [row]);
+  }
+
+  if (nelem_read)
+
+    *nelem_read = rows;
+
+  return 0;
+}
+
+
+  /* Get the integer values of a named column of the current category */
+
+int cbf_get_integercolumn (cbf_handle handle, const char *columnname,
+                           int *values, char *mask,
+                           size_t nelem, size_t *nelem_read)
+{
+  cbf_node *column;
+
+  const char *value;
+
+  unsigned int row, rows;
+
+  long number;
+
+
+    /* Check the arguments */
+
+  if (!handle || !columnname || (nelem && !values))
+
+    return CBF_ARGUMENT;
+
+
+    /* Find the column */
+
+  cbf_failnez (cbf_find_column (handle, columnname))
+
+  cbf_failnez (cbf_count_rows (handle, &rows))
+
+  column = handle->node;
+
+  if (rows > nelem)
+
+    rows = nelem;
+
+
+    /* Convert each row, using the numbers already parsed */
+
+  for (row = 0; row < rows; row++)
+  {
+    if (!cbf_get_columnrow_long (&number, column, row))
+    {
+      values [row] = (int) number;
+
+      if (mask)
+
+        mask [row] = CBF_MASK_VALUE;
+
+      continue;
+    }
+
+    cbf_failnez (cbf_get_column_text (column, row, &value, mask ? mask + row : NULL))
+
+    if (!value)
+    {
+      values [row] = 0;
+
+      continue;
+    }
+
+    number = atol (value);
+
+    values [row] = (int) number;
+
+    cbf_set_columnrow_long (column, row, number);
+  }
+
+  if (nelem_read)
+
+    *nelem_read = rows;
+
+  return 0;
+}
+
+
+  /* Set the values of a named column of the current category from
+     formatted numbers, creating the column and adding rows as needed */
+
+static int cbf_set_numbercolumn (cbf_handle handle, const char *columnname,
+                                 const double *dvalues, const int *ivalues,
+                                 const char *mask, size_t nelem,
+                                 const char *format)
+{
+  cbf_node *category, *column, *node;
+
+  const char *value;
+
+  char buffer [512];
+
+  unsigned int row, rows, columns, count;
+
+  int errorcode, length;
+
+
+    /* Find or create the column */
+
+  cbf_failnez (cbf_require_column (handle, columnname))
+
+  column = handle->node;
+
+
+    /* Add rows to every column of the category */
+
+  cbf_failnez (cbf_count_rows (handle, &rows))
+
+  if (rows < nelem)
+  {
+    cbf_failnez (cbf_find_parent (&category, column, CBF_CATEGORY))
+
+    cbf_failnez (cbf_count_children (&columns, category))
+
+    for (count = 0; count < columns; count++)
+    {
+      cbf_failnez (cbf_get_child (&node, category, count))
+
+      if (node->children < nelem)
+
+        cbf_failnez (cbf_set_children (node, nelem))
+    }
+  }
+
+
+    /* Set the values */
+
+  for (row = 0; row < nelem; row++)
+  {
+    if (mask && mask [row] == CBF_MASK_UNKNOWN)
+
+      value = cbf_copy_string (NULL, "?", CBF_TOKEN_NULL);
+
+    else
+
+      if (mask && mask [row] == CBF_MASK_INAPPLICABLE)
+
+        value = cbf_copy_string (NULL, ".", CBF_TOKEN_NULL);
+
+      else
+      {
+        if (dvalues)
+
+          length = snprintf (buffer, sizeof buffer, format, dvalues [row]);
+
+        else
+
+          length = snprintf (buffer, sizeof buffer, format, ivalues [row]);
+
+          /* The format is the caller's: refuse a truncated value */
+
+        if (length < 0 || (size_t) length >= sizeof buffer)
+
+          return CBF_ARGUMENT;
+
+        value = cbf_copy_string (NULL, buffer, '\200');
+      }
+
+    if (!value)
+
+      return CBF_ALLOC;
+
+    errorcode = cbf_set_columnrow (column, row, value, 1);
+
+    if (errorcode)
+    {
+      cbf_free_string (NULL, value);
+
+      return errorcode;
+    }
+  }
+
+  return 0;
+}
+
+
+  /* Set the double values of a named column of the current category */
+
+int cbf_set_doublecolumn (cbf_handle handle, const char *columnname,
+                          const double *values, const char *mask,
+                          size_t nelem, const char *format)
+{
+  if (!handle || !columnname || (nelem && !values))
+
+    return CBF_ARGUMENT;
+
+  return cbf_set_numbercolumn (handle, columnname, values, NULL, mask, nelem,
+                               format ? format : "%-.15g");
+}
+
+
+  /* Set the integer values of a named column of the current category */
+
+int cbf_set_integercolumn (cbf_handle handle, const char *columnname,
+                           const int *values, const char *mask,
+                           size_t nelem)
+{
+  if (!handle || !columnname || (nelem && !values))
+
+    return CBF_ARGUMENT;
+
+  return cbf_set_numbercolumn (handle, columnname, NULL, values, mask, nelem,
+                               "%d");
+}
+
+
+  /* Get the local byte order of the default integer type */
+
+int cbf_get_local_integer_byte_order (char ** byte_order)
+{
+   static char le[14] = "little_endian";
+
+   static char be[11] = "big_endian";
+
+   int *test;
+
+   int probe = 1;
+
+   test = (int *)&probe;
+
+   if (*(char*)test) *byte_order = le;
+
+   else *byte_order = be;
+
+   return 0;
+}
+
+  /* Get the local byte order of the default real type */
+
+int cbf_get_local_real_byte_order (char ** byte_order)
+{
+   static char le[14] = "little_endian";
+
+   static char be[11] = "big_endian";
+
+   double *test;
+
+   double probe = 1.;
+
+   test = (double *)&probe;
+
+   if (*(char*)test) *byte_order = be;
+
+   else *byte_order = le;
+
+   return 0;
+}
+
+  /* Get the local real format */
+
+int cbf_get_local_real_format (char ** real_format )
+{
+   static char ieee[14] = "ieee 754-1985";
+
+   static char other[6] = "other";
+
+
+   union ftest { float fltest; int itest; long ltest; } test;
+
+   *real_format = other; 
+
+   test.fltest = 1.;
+
+   if (sizeof (float) == sizeof (long) ) {
+
+     if ( test.ltest == 1065353216L ) *real_format = ieee;
+
+   } else {
+
+     if (sizeof (float) == sizeof (int ) ) {
+
+       if (test.itest == 1065353216 ) *real_format = ieee;
+
+
+     }
+   }
+
+   return 0;
+}
+
+  /* Get the dictionary for a cbf */
+
+int cbf_get_dictionary (cbf_handle handle, cbf_handle * dictionary)
+{
+  if (handle &&
+    (*dictionary = (cbf_handle)(handle->dictionary)) ) return 0;
+
+  return CBF_NOTFOUND;
+
+}
+
+  /* Make a view of a shared dictionary: a handle of its own on the
+     same tree, with its own position and reference counts */
+
+static int cbf_make_dictionary_view (cbf_handle *view, cbf_handle dictionary)
+{
+  cbf_node *node;
+
+  cbf_failnez (cbf_find_parent (&node, dictionary->node, CBF_ROOT))
+
+  cbf_failnez (cbf_make_handle (view))
+
+  cbf_onfailnez (cbf_free_node ((*view)->node), cbf_free_handle (*view))
+
+  (*view)->node = node;
+
+  (*view)->logfile = dictionary->logfile;
+
+  (*view)->readonly = 1;
+
+  (*view)->shared = dictionary;
+
+  cbf_add_refcount (dictionary, 1);
+
+  return 0;
+}
+
+
+  /* Set the dictionary for a cbf.  A shared dictionary is attached
+     through a view, so that handles in different threads do not
+     disturb each other's queries. */
+
+int cbf_set_dictionary (cbf_handle handle, cbf_handle dictionary)
+{
+  cbf_handle view;
+
+  if (!handle || !dictionary) return CBF_ARGUMENT;
+
+  if (dictionary->shared) dictionary = dictionary->shared;
+
+  if (dictionary->readonly) {
+
+    cbf_failnez (cbf_make_dictionary_view (&view, dictionary))
+
+  } else {
+
+    view = dictionary;
+
+    cbf_add_refcount (dictionary, 1);
+
+  }
+
+  if (handle->dictionary) {
+
+    cbf_onfailnez (cbf_free_handle((cbf_handle)(handle->dictionary)),
+                   cbf_free_handle (view))
+
+  }
+
+  * ((cbf_handle *)(&handle->dictionary)) = view;
+
+  return 0;
+
+}
+
+
+  /* Resolve the token types of all the values below a node, so that
+     reading them later never writes to the tree */
+
+static int cbf_resolve_value_types (cbf_node *node)
+{
+  unsigned int count;
+
+  const char *text;
+
+  node = cbf_get_link (node);
+
+  for (count = 0; count < node->children; count++)
+
+    if (node->type == CBF_COLUMN) {
+
+      cbf_failnez (cbf_get_columnrow (&text, node, count))
+
+      if (text && !cbf_is_binary (node, count))
+
+        cbf_failnez (cbf_value_type ((char *) text))
+
+    } else
+
+      cbf_failnez (cbf_resolve_value_types (node->child [count]))
+
+  return 0;
+}
+
+
+  /* Make a dictionary read-only, so that any number of handles, in
+     any number of threads, can share it through cbf_set_dictionary.
+     The dictionary must not be changed or queried directly after
+     this; each handle it is attached to queries it through a view. */
+
+int cbf_share_dictionary (cbf_handle dictionary)
+{
+  cbf_node *node;
+
+  if (!dictionary) return CBF_ARGUMENT;
+
+  if (dictionary->readonly) return 0;
+
+    /* A shared dictionary is never built later */
+
+  cbf_failnez (cbf_build_datablocks (dictionary))
+
+  cbf_failnez (cbf_find_parent (&node, dictionary->node, CBF_ROOT))
+
+  cbf_failnez (cbf_resolve_value_types (node))
+
+  dictionary->node = node;
+
+  dictionary->row = 0;
+
+  dictionary->search_row = 0;
+
+  dictionary->readonly = 1;
+
+  return 0;
+}
+
+  /* Get the dictionary for a cbf, or create one */
+
+int cbf_require_dictionary (cbf_handle handle, cbf_handle * dictionary)
+{
+  if (!handle) return CBF_ARGUMENT;
+
+  if (!cbf_get_dictionary(handle, dictionary)) return 0;
+
+  cbf_failnez (cbf_make_handle((cbf_handle *)&(handle->dictionary)))
+
+  *dictionary = (cbf_handle)(handle->dictionary);
+
+  return 0;
+
+}
+
+  /* Put the value into the named column, updating the hash table links 
+  
+     If valuerow >= 0, the value is to be stored into the row of that
+     number.
+     
+     If valuerow < 0, the value is to be stored into a newly created row.
+     
+     For a given category of name <catname>, the hash table is
+     held in a category of name <catname>(hash_table), e.g.
+     if the category is "atom", the hastable is "atom(hash_table)".
+     For each column of name <colname> the hashtable links,
+     as integer row numbers are held in columns of name
+     <colname>(hash_index), e.g. if the column name is "label",
+     the hash index column name is "label(hash_index)".   The
+     same column name is used in both the hash table category
+     and the original category. 
+  
+  
+  
+  */
+
+int cbf_set_hashedvalue(cbf_handle handle, const char * value, 
+                                           const char * columnname, 
+                        int valuerow) {
+    
+    char colhashnext[91];
+    
+    char * category;
+    
+    const char * ovalue;
+    
+    
+    int ohashnext;
+    
+    char categoryhashtable[91];
+    
+    unsigned int hashcode, ohashcode;
+    
+    int orownum, rownum, nrownum=0, catrownum;
+    
+    int colnamelen, catnamelen;
+    
+    if ( !columnname ) return CBF_ARGUMENT;
+    
+    if ( (colnamelen = strlen(columnname)) > 80 ) return CBF_ARGUMENT;
+    
+    cbf_failnez(cbf_category_name (handle, (const char * *)&category));
+    
+    if ( (catnamelen = strlen(category)) > 80 ) return CBF_ARGUMENT;
+    
+    strcpy (categoryhashtable,category);
+    
+    strcpy (categoryhashtable + catnamelen, "(hash_table)");
+    
+    strcpy (colhashnext, columnname);
+    
+    strcpy (colhashnext+colnamelen, "(hash_next)");
+    
+    cbf_failnez( cbf_compute_hashcode(value, &hashcode))
+    
+    cbf_failnez( cbf_require_column(handle, columnname))
+    
+    /* If we are going to hash an existing row, we need to
+     
+     undo any existing hash to the same row */
+    
+    
+    if (valuerow >= 0) {
+        
+        cbf_failnez( cbf_select_row       (handle, valuerow))
+        
+        if (!cbf_get_value(handle,&ovalue) && ovalue
+            && !cbf_find_column(handle, colhashnext)
+            && !cbf_get_integervalue(handle, &ohashnext)) {
+            
+            cbf_failnez( cbf_compute_hashcode(ovalue, &ohashcode))
+            
+            if (hashcode != ohashcode)   {
+                
+                cbf_failnez( cbf_require_category (handle,   categoryhashtable))
+                
+                cbf_failnez( cbf_require_column   (handle,   colhashnext))
+                
+                cbf_failnez( cbf_select_row       (handle,   ohashcode))
+                
+                if ( ! cbf_get_integervalue (handle, &rownum)) {
+                    
+                    if (rownum == valuerow) {
+                        
+                        cbf_failnez(cbf_set_integervalue(handle,ohashnext))
+                        
+                    } else  {
+                        
+                        cbf_failnez( cbf_find_category    (handle,   category))
+                        
+                        cbf_failnez( cbf_find_column      (handle,   colhashnext))
+                        
+                        while ( rownum >=0 && rownum != valuerow)  {
+                            
+                            cbf_failnez( cbf_select_row     (handle,   rownum))
+                            
+                            orownum = -1;
+                            
+                            if (cbf_get_integervalue (handle,&orownum) || orownum <= rownum) {
+                                
+                                break;
+                                
+                            } else {
+                                
+                                if (orownum == valuerow) {
+                                    
+                                    cbf_failnez(cbf_set_integervalue(handle,ohashnext))
+                                    
+                                    break;
+                                    
+                                }
+                            }
+                            
+                            rownum = orownum;
+                            
+                        }
+                        
+                    }
+                    
+                }
+                
+            }
+            
+        }
+        
+    }
+    
+    
+    cbf_failnez( cbf_find_category (handle,   category));
+    
+    
+    cbf_failnez( cbf_find_column (handle,   columnname));
+    
+    
+    if ( valuerow < 0 )  {
+        
+        cbf_failnez( cbf_new_row          (handle));
+        
+    } else {
+        
+        cbf_failnez( cbf_select_row       (handle, valuerow));
+        
+    }
+    
+    cbf_failnez( cbf_set_value        (handle,    value))
+    
+    cbf_failnez( cbf_row_number       (handle,   (unsigned int *)&nrownum))
+    
+    cbf_debug_print4("cbf_set_hashed_value, category %s, column %s, row %ud", category, columnname, nrownum);
+    
+    cbf_debug_print2("cbf_set_hashed_value, value %s", value);
+    
+    cbf_failnez( cbf_require_column   (handle,   (const char *) colhashnext))
+    
+    cbf_failnez( cbf_set_integervalue (handle,   -1))
+    
+    cbf_failnez( cbf_require_category (handle,   categoryhashtable))
+    
+    cbf_failnez( cbf_require_column   (handle,   colhashnext))
+    
+    cbf_failnez( cbf_count_rows       (handle,   (unsigned int *)&catrownum))
+    
+    if ((unsigned int)catrownum < hashcode+1) {
+        
+        for (rownum = catrownum; (unsigned int)rownum < hashcode+1; rownum++) {
+            
+            cbf_failnez(cbf_new_row(handle));
+            
+            cbf_failnez(cbf_set_integervalue(handle,-1));
+            
+        }
+        
+    }
+    
+    
+    cbf_failnez( cbf_find_column      (handle, colhashnext))
+    
+    cbf_failnez( cbf_select_row       (handle, hashcode))
+    
+    if ( cbf_get_integervalue (handle, &rownum) || rownum == -1) {
+        
+        cbf_failnez( cbf_set_integervalue   (handle, nrownum))
+        
+        cbf_failnez( cbf_find_category      (handle, category))
+        
+        cbf_failnez( cbf_find_column        (handle,  colhashnext))
+        
+        cbf_failnez( cbf_select_row         (handle, nrownum))
+        
+        cbf_failnez( cbf_set_integervalue   (handle, -1))
+        
+        cbf_failnez( cbf_find_column        (handle, columnname))
+        
+        return 0;
+        
+    }
+    
+    /* nrownum is the row number of the value
+     rownum is the row number of pointed to by the hash table
+     
+     If the hash table points higher up, reset the hashtable to
+     point to the new row.
+     
+     We will still have to relink the chain by having this row point
+     to rownum
+     
+     If the hash table point higher up, the hash table remains as
+     is, and the new link is inserted only in the main category
+     
+     */
+    
+    if (nrownum < rownum) {
+        
+        cbf_failnez( cbf_set_integervalue(handle,nrownum))
+        
+    }
+    
+    cbf_failnez( cbf_find_category    (handle,   category))
+    
+    cbf_failnez( cbf_find_column      (handle,   colhashnext))
+    
+    if (rownum >= nrownum) {
+        
+        cbf_failnez( cbf_select_row         (handle, nrownum))
+        
+        if (rownum > nrownum) {
+            
+            cbf_failnez( cbf_set_integervalue(handle, rownum))
+            
+        }
+        
+        if (cbf_get_integervalue (handle, &orownum)) {
+            
+            
+            cbf_failnez(cbf_set_integervalue (handle, -1))
+            
+        }
+        
+        cbf_failnez( cbf_find_column        (handle, columnname))
+        
+        return 0;
+        
+    }
+    
+    
+    while ( rownum >=0 )  {
+        
+        cbf_failnez( cbf_select_row     (handle,   rownum))
+        
+        orownum = -1;
+        
+        if (cbf_get_integervalue (handle,&orownum) || orownum < 0 || orownum >= nrownum) {
+            
+            cbf_failnez( cbf_set_integervalue   (handle, nrownum))
             
             cbf_failnez( cbf_select_row         (handle, nrownum))
             
-            if ( orownum < 0  || orownum > nrownum) {
+            if ( orownum < 0  || orownum > nrownum) {
+                
+                cbf_failnez( cbf_set_integervalue   (handle, orownum))
+                
+            }
+            
+            if (cbf_get_integervalue (handle, &orownum)) {
+                
+                
+                cbf_failnez(cbf_set_integervalue (handle, -1))
+                
+            }
+            
+            cbf_failnez( cbf_find_column        (handle, columnname))
+            
+            cbf_failnez( cbf_select_row         (handle, nrownum));
+            
+            return 0;
+            
+        }      
+        
+        rownum = orownum;
+        
+    }
+    
+    return CBF_NOTFOUND;
+    
+}
+
+
+  /* Find value in the named column, using the hash table links, if available*/
+
+int cbf_find_hashedvalue(cbf_handle handle, const char * value, 
+                                            const char * columnname,
+                                            int caseinsensitive) {
+
+  char colhashnext[91];
+  
+  char * category;
+  
+  char categoryhashtable[91];
+
+  char hashcodestring[81];
+  
+  unsigned int hashcode;
+
+  int rownum, catrownum;
+
+  const char * rowvalue;
+
+  int colnamelen, catnamelen;
+  
+  if (!columnname) return CBF_ARGUMENT;
+
+  if ( (colnamelen = strlen(columnname)) > 80 ) return CBF_ARGUMENT;
+  
+  cbf_failnez(cbf_category_name (handle, (const char **)&category));
+  
+  if ( (catnamelen = strlen(category)) > 80 ) return CBF_ARGUMENT;
+  
+
+    /* Compute the hashcode value (0-255) */
+
+  cbf_failnez (cbf_compute_hashcode(value, &hashcode))
+
+  sprintf (hashcodestring,"%d",hashcode);
+  
+    /* Save the category of the primary search */
+  
+  strcpy (categoryhashtable,category);
+  
+    /* Compute the names
+    
+        <category>(hash_table)
+        <column>(hash_next)
+        
+     */
+  
+  strcpy (categoryhashtable + catnamelen, "(hash_table)");   
+
+  strcpy (colhashnext, columnname);
+
+  strcpy (colhashnext+colnamelen, "(hash_next)");
+  
+    /* A shared dictionary cannot grow its hash tables: a missing
+       table or row just means that the value is not there */
+
+  if (handle->readonly) {
+
+    if (cbf_find_category (handle, categoryhashtable)
+      || cbf_find_column  (handle, colhashnext)
+      || cbf_count_rows   (handle, (unsigned int *)&catrownum)
+      || (unsigned int)catrownum < hashcode+1) {
+
+      cbf_failnez( cbf_find_category (handle, category))
+
+      cbf_failnez( cbf_find_column   (handle, columnname))
+
+      return CBF_NOTFOUND;
+
+    }
+
+  }
+
+    /* Switch to the hash table and make sure it has enough rows */
+  
+  cbf_failnez( cbf_require_category (handle, categoryhashtable))
+  
+  cbf_failnez( cbf_require_column   (handle, colhashnext))
+  
+  cbf_failnez( cbf_count_rows       (handle, (unsigned int *)&catrownum))
+  
+  if ((unsigned int)catrownum < hashcode+1) {
+  
+    for (rownum = catrownum; (unsigned int)rownum < hashcode+1; rownum++) {
+    
+      cbf_failnez( cbf_new_row(handle))
+    	
+    }	
+  	
+  }
+  
+    /* examine the row in the hash table given by the hash code
+       to see if it points to a row  */
+
+  if ( ! cbf_select_row(handle, hashcode) 
+       && !cbf_get_integervalue(handle, (int *) &rownum)
+       &&  rownum >= 0 ) {
+  
+    /* If we have a start point, trace the chain until we find
+       a match to the probe, or fail */
+
+  	cbf_failnez( cbf_find_category    (handle,   category))
+  	
+    while ( rownum >=0 )  {
+  
+      cbf_failnez( cbf_find_column    (handle,   columnname))
+
+      cbf_failnez( cbf_select_row     (handle,   rownum))
+      
+      if (caseinsensitive) {
+      	
+        if ( !cbf_get_value(handle, &rowvalue)  && rowvalue && !cbf_cistrcmp(rowvalue, value)) {
+            
+            cbf_debug_print4("cbf_find_hashed_value, category %s, column %s, row %ud", category, columnname, rownum);
+            
+            cbf_debug_print2("cbf_find_hashed_value, value %s", value);
+
+      
+          return 0;
+          
+        }
+          
+      } else {
+      
+        if ( !cbf_get_value(handle, &rowvalue)  && rowvalue && !strcmp(rowvalue, value)) {
+      
+          return 0;
+          
+        }
+      	
+      }
+      
+      cbf_failnez( cbf_find_column    (handle, colhashnext))
+    
+      if (cbf_get_integervalue       (handle,&rownum)) break;
+            	
+    }
+    
+  }
+
+  cbf_failnez( cbf_find_category      (handle,   category))
+  
+  cbf_failnez( cbf_find_column        (handle,   columnname))
+  
+  return CBF_NOTFOUND;
+
+}
+
+
+int cbf_convert_dictionary_definition(cbf_handle cbfdictionary, cbf_handle dictionary,
+                                                                const char * name)
+{
+
+    const char *category_id;
+
+    const char *mandatory_code;
+
+    const char *itemname=NULL;
+	
+    const char *expression;
+
+    const char *columnname;
+    
+    const char *categoryname, *ocategoryname;
+           
+    int colno;
+
+    const char *type_code;
+
+    const char *default_value;
+
+    const char *parent_name;
+
+    const char *child_name;
+
+    const char *alias_name;
+
+    const char *key, *oldkey;
+    
+    const char *value, *value2, *value_type;
+    
+    const char *keytype;
+    
+    char buffer[255];
+
+    cbf_node * base_node, * local_node;
+
+    int rownum, numrows, numrow;
+    
+    int nextkeyrow;
+
+    int haveitemname;
+
+    int haveitemcategory;
+
+    haveitemname = haveitemcategory = 0;
+    
+      /* Save the base data block or save frame to come back to */
+    
+    base_node = dictionary->node;
+    
+    local_node = base_node;
+    
+      /* Find the name for this defintion */
+
+    if (!cbf_find_local_tag(dictionary,"_name") ||
+      !cbf_find_local_tag(dictionary,"_item.name") ||
+      !cbf_find_local_tag(dictionary,"_definition.id")) {
+    	
+       haveitemname = 1; local_node = dictionary->node;
+       
+       cbf_failnez(cbf_column_name(dictionary, &columnname) )
+       
+    }
+
+    if (!haveitemname && (!cbf_find_category(dictionary,"item") || !cbf_find_category(dictionary,"name"))) haveitemcategory = 1;
+
+    if (haveitemname || haveitemcategory) {
+
+      cbf_failnez( cbf_count_rows (dictionary,(unsigned int *)&numrows))
+
+      cbf_failnez( cbf_rewind_row        (dictionary))
+
+      for (numrow=0; numrow < numrows; numrow++) {
+
+        cbf_failnez( cbf_require_category  (cbfdictionary, "items"))
+        
+        if (haveitemname  && !cbf_find_column(dictionary,columnname)) {
+ 
+          cbf_failnez( cbf_select_row(dictionary, numrow) )
+
+          cbf_failnez( cbf_get_value(dictionary, &itemname))
+
+        } else {
+
+          itemname = name;
+
+        }
+
+        if (cbf_find_hashedvalue(cbfdictionary, itemname, "name", 
+           CBF_CASE_INSENSITIVE)) {
+
+          cbf_failnez( cbf_set_hashedvalue (cbfdictionary, itemname, "name", -1))
+
+        }
+        
+        cbf_failnez( cbf_row_number          (cbfdictionary, (unsigned int*)&rownum))
+
+        if (!cbf_find_column(dictionary,"category_id") 
+          || !cbf_find_column(dictionary,"_category")){
+
+          cbf_failnez( cbf_select_row(dictionary, (unsigned int)numrow) )
+
+          if (!cbf_get_value(dictionary, &category_id)) {
+
+            cbf_failnez( cbf_find_column(cbfdictionary, "category_id"));
+            
+            if (cbf_get_value(cbfdictionary, &categoryname) 
+              || !categoryname 
+              || !strcmp(categoryname," "))
+              
+            cbf_failnez(cbf_set_hashedvalue(cbfdictionary, category_id, "category_id", rownum))
+
+          }
+
+        } else  {
+        
+          dictionary->node = base_node;
+        	
+          if (!cbf_find_local_tag(dictionary,"_category")
+              ||!cbf_find_local_tag(dictionary,"_item.category_id") ) {
+              
+            if (!cbf_get_value(dictionary, &category_id)) {
+
+              cbf_failnez( cbf_find_column(cbfdictionary, "category_id"));
+
+              if (cbf_get_value(cbfdictionary, &categoryname) 
+                || !categoryname 
+                || !strcmp(categoryname," "))
+              
+              cbf_failnez(cbf_set_hashedvalue(cbfdictionary, category_id, "category_id", rownum))
+              
+            }
+
+          }
+             
+        }
+
+        dictionary->node = local_node;
+
+        if (!cbf_find_column(dictionary,"mandatory_code") ) {
+
+          cbf_failnez( cbf_select_row(dictionary, numrow) )
+
+          if (!cbf_get_value(dictionary, &mandatory_code)) {
+
+            cbf_failnez( cbf_find_column(cbfdictionary, "mandatory_code"));
+
+            cbf_failnez( cbf_set_value(cbfdictionary, mandatory_code))
+
+          }
+
+        }
+
+
+        dictionary->node = base_node;
+        	
+        if ( !cbf_find_local_tag(dictionary,"_type") ||
+          !cbf_find_local_tag(dictionary,"_item_type.code") ||
+          !cbf_find_local_tag(dictionary,"_type.contents") ) {
+
+          if (!cbf_get_value(dictionary, &type_code)) {
+
+            cbf_failnez( cbf_find_column(cbfdictionary, "type_code"));
+
+            cbf_failnez( cbf_set_value(cbfdictionary, type_code))
+
+          }
+
+        }  
+        
+
+        dictionary->node = base_node;
+        	
+        if (!cbf_find_local_tag(dictionary,"_enumeration_default") ||
+          !cbf_find_local_tag(dictionary,"_item_default.value") ||
+		  !cbf_find_local_tag(dictionary,"_enumeration.default"))  {
+
+          if (!cbf_get_value(dictionary, &default_value)) {
+
+            cbf_failnez( cbf_find_column(cbfdictionary, "default_value"));
+
+            cbf_failnez( cbf_set_value(cbfdictionary, default_value))
+
+          }
+
+        }
+
+       dictionary->node = base_node;
+        	
+        if (!cbf_find_local_tag(dictionary,"_method.expression"))  {
+
+          if (!cbf_get_value(dictionary, &expression)) {
+		
+           cbf_failnez( cbf_require_column(cbfdictionary, "method_expression"));
+
+            cbf_failnez( cbf_set_value(cbfdictionary, expression))
+
+          }
+
+        }	
+
+        dictionary->node = base_node;
+        	
+        if ( !cbf_find_local_tag(dictionary,"_item_aliases.alias_name") )  {
+
+          if (!cbf_get_value(dictionary, &alias_name)) {
+
+            cbf_failnez(cbf_find_category(cbfdictionary, "item_aliases"))
+
+            if (cbf_find_hashedvalue(cbfdictionary, alias_name, "item_alias", 
+              CBF_CASE_INSENSITIVE)) {
+
+            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, alias_name, "item_alias", -1))
+
+            }
+            
+            cbf_failnez( cbf_row_number          (cbfdictionary, (unsigned int *)&rownum))
+            
+            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, itemname, "item_root", rownum))
+
+          }
+
+        }
+
+      }
+
+    }
+    
+    
+    /* extract enumerations */
+    
+    dictionary->node = base_node;
+    
+    value_type = "value";
+
+    if (!cbf_find_local_tag(dictionary, "_item_enumeration.value") ||
+      !cbf_find_local_tag(dictionary, "_enumeration"))  {
+      
+      cbf_failnez( cbf_column_number(dictionary, (unsigned int *)&colno))
+      
+      cbf_failnez( cbf_count_rows (dictionary, (unsigned int *)&numrows))
+
+      cbf_failnez( cbf_rewind_row        (dictionary))
+
+      cbf_failnez( cbf_require_category  (cbfdictionary, "items_enumerations"))
+        
+      for (numrow=0; numrow < numrows; numrow++) {
+      
+        cbf_failnez( cbf_select_row(dictionary, numrow))
+        
+        cbf_failnez( cbf_select_column(dictionary, colno))
+
+        cbf_failnez( cbf_get_value (dictionary, &value))
+
+        if (!haveitemname)   {
+        
+          cbf_failnez (cbf_find_column(dictionary,"name"))
+
+          cbf_failnez (cbf_get_value(dictionary,&itemname))
+        	
+        }
+
+        cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, itemname, "name", -1))
+
+        cbf_failnez( cbf_require_column      (cbfdictionary, "value"))
+        
+        cbf_failnez( cbf_set_value           (cbfdictionary, value))
+        
+        cbf_failnez( cbf_require_column      (cbfdictionary, "value_type") )
+        
+        cbf_failnez( cbf_set_value           (cbfdictionary, value_type))
+        
+      }
+    
+    }
+
+    dictionary->node = base_node;
+        	
+    if (!cbf_find_local_tag(dictionary, "_item_range.minimum") ||
+      !cbf_find_local_tag(dictionary, "_enumeration_range") ||
+      !cbf_find_local_tag(dictionary, "_enumeration.range"))  {
+      
+      cbf_failnez( cbf_column_number(dictionary, (unsigned int *)&colno))
+      
+      cbf_failnez( cbf_count_rows (dictionary, (unsigned int *)&numrows))
+
+      cbf_failnez( cbf_rewind_row        (dictionary))
+
+      cbf_failnez( cbf_require_category    (cbfdictionary, "items_enumerations"))
+        
+      for (numrow=0; numrow < numrows; numrow++) {
+            
+        cbf_failnez( cbf_select_row(dictionary, numrow) )
+        
+        cbf_failnez( cbf_select_column(dictionary, colno))
+
+        cbf_failnez( cbf_get_value (dictionary, &value))
+                
+        if (!haveitemname)   {
+        
+          cbf_failnez (cbf_find_column(dictionary,"name"))
+
+          cbf_failnez (cbf_get_value(dictionary,&itemname))
+        	
+        }
+
+        value_type = "closed_range";
+
+        if (!cbf_find_column(dictionary, "maximum")) {
+        
+          cbf_failnez( cbf_get_value (dictionary, &value2))
+          
+          if (value && value2 && strlen(value)+strlen(value2) < 255) {
+          
+            if (strcmp(value,value2)) value_type = "open_range";
+ 
+            strcpy(buffer,value);
+            
+            buffer[strlen(value)]=':';
+            
+            strcpy(buffer+strlen(value)+1,value2);
+            
+            value = buffer;
+            
+          	
+          } else {
+          
+            value = "invalid";
+            
+            sprintf(buffer,"dictionary:  invalid range of values for %s",itemname);
+            
+            cbf_log(dictionary,buffer,CBF_LOGWARNING|CBF_LOGSTARTLOC);
+          	
+          }
+        	
+        }
+
+
+        cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, itemname, "name", -1))
+
+        cbf_failnez( cbf_require_column      (cbfdictionary, "value"))
+        
+        cbf_failnez( cbf_set_value           (cbfdictionary, value))
+        
+        cbf_failnez( cbf_require_column      (cbfdictionary, "value_type") )
+        
+        cbf_failnez( cbf_set_value           (cbfdictionary, value_type))
+        
+      }
+
+
+    }
+
+
+
+    dictionary->node = base_node;
+        	
+    if (!cbf_find_local_tag(dictionary, "_item_linked.parent_name") ||
+      !cbf_find_local_tag(dictionary, "_item_link_parent") || 
+      !cbf_find_local_tag(dictionary, "_category.parent_id"))  {
+
+      cbf_failnez( cbf_count_rows (dictionary,(unsigned int *)&numrows))
+
+      cbf_failnez( cbf_rewind_row        (dictionary))
+
+      for (numrow=0; numrow < numrows; numrow++) {
+
+        cbf_failnez( cbf_require_category  (cbfdictionary, "items"))
+
+        cbf_failnez( cbf_select_row(dictionary, numrow) )
+
+        parent_name = NULL;
+
+        if (!cbf_find_column(dictionary,"parent_name") ||
+            !cbf_find_column(dictionary,"_list_link_parent") || 
+            !cbf_find_column(dictionary,"parent_id") )
+            if (cbf_get_value(dictionary,&parent_name)) parent_name = NULL;
+
+        child_name = NULL;
+
+        if (!cbf_find_column(dictionary,"child_name") ||
+            !cbf_find_column(dictionary,"_list_link_child") )
+            if (cbf_get_value(dictionary,&child_name)) child_name = NULL;
+
+        if ((numrows==1) && (child_name == NULL)) {
+
+          child_name = itemname;
+
+        }
+
+        if (parent_name && child_name) {
+
+          if (cbf_find_hashedvalue(cbfdictionary, child_name, "name", 
+            CBF_CASE_INSENSITIVE)) {
+
+            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, child_name, "name", -1))
+
+          }
+
+          cbf_failnez(cbf_find_column(cbfdictionary, "parent"))
+
+          cbf_failnez(cbf_set_value(cbfdictionary,parent_name))
+
+        }
+
+      }
+
+    }
+
+    dictionary->node = base_node;
+        	
+    if (!cbf_find_local_tag(dictionary,"_category") ||
+
+      !cbf_find_local_tag(dictionary,"_category.id") )  {
+
+      cbf_failnez( cbf_count_rows (dictionary,(unsigned int *)&numrows))
+
+      cbf_failnez( cbf_rewind_row        (dictionary))
+      
+      local_node = dictionary->node;
+      
+      for (numrow=0; numrow < numrows; numrow++) {
+
+        cbf_failnez( cbf_require_category  (cbfdictionary, "categories"))
+        
+        dictionary->node = local_node;
+
+        cbf_failnez( cbf_select_row(dictionary, numrow) )
+        
+        cbf_failnez( cbf_get_value         (dictionary, &categoryname))
+   
+        if (cbf_find_hashedvalue(cbfdictionary, categoryname, "id", 
+          CBF_CASE_INSENSITIVE)) {
+
+          cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, categoryname, "id", -1))
+
+        } 
+        
+        key = NULL;
+                
+        mandatory_code = "no";
+        
+        if (!cbf_find_column(dictionary,"mandatory_code") 
+          && !cbf_get_value(dictionary,&mandatory_code)) {
+          
+          cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
+          
+          cbf_failnez(cbf_set_value(cbfdictionary,mandatory_code))
+       
+        }
+
+
+        dictionary->node = base_node;
+
+        if (!cbf_find_local_tag(dictionary,"_list_reference") ||
+          !cbf_find_local_tag(dictionary,"_category_key.name") ||
+          !cbf_find_local_tag(dictionary,"_category_key.primitive") ||
+          !cbf_find_local_tag(dictionary,"_category_key.generic")) {
+
+          if (!cbf_get_value(dictionary, &key) && key) {
+
+            cbf_failnez( cbf_get_typeofvalue(dictionary,&keytype))
+
+            cbf_failnez( cbf_require_column(cbfdictionary, "key"))
+            
+            while (cbf_get_value(cbfdictionary, &oldkey) || !oldkey || strcmp(oldkey," "))  {
+            
+              if (key && oldkey && !strcmp(oldkey,key)) break;
+              
+              cbf_failnez( cbf_find_column         (cbfdictionary, "id(hash_next)"))
+              
+              cbf_failnez( cbf_get_integervalue    (cbfdictionary, &nextkeyrow))
+              
+              cbf_failnez( cbf_find_column(cbfdictionary, "key"))
+
+              if (nextkeyrow < 0) {
+            
+                cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, categoryname, "id", -1))
+
+                cbf_failnez( cbf_find_column         (cbfdictionary, "key"))
+              
+                break;
+ 
+              }
+              
+              cbf_failnez( cbf_select_row            (cbfdictionary, (unsigned int)nextkeyrow))
+            	
+            }
+            
+            cbf_failnez(cbf_set_value(cbfdictionary,key))
+            
+            if ( keytype != NULL )  {
+            	
+              cbf_failnez(cbf_set_typeofvalue(cbfdictionary,keytype))
+            
+            }
+
+            cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
+            
+            cbf_failnez(cbf_set_value(cbfdictionary,mandatory_code))
+            
+          }
+          
+        }
+        
+        cbf_failnez( cbf_require_category  (cbfdictionary, "items"))
+        
+        cbf_failnez (cbf_require_column(cbfdictionary,"name"))
+        
+        if (key) {
+        	
+            if (cbf_find_hashedvalue(cbfdictionary,key,"name",CBF_CASE_INSENSITIVE)) {
+        
+              cbf_failnez(cbf_set_hashedvalue(cbfdictionary,key,"name", -1))
+          
+              cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
+          
+              cbf_failnez(cbf_set_value(cbfdictionary,"yes"))
+            
+            } else {
+        
+              cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
+          
+              if (cbf_get_value(cbfdictionary,&mandatory_code) || !mandatory_code) {
+          
+                 cbf_failnez(cbf_set_value(cbfdictionary,"yes"))
+          	
+              }
+              
+            }
+            
+            cbf_failnez(cbf_row_number(cbfdictionary, (unsigned int *)&rownum))
+            
+            cbf_failnez(cbf_require_column(cbfdictionary,"category_id"))
+              
+              if (cbf_get_value(cbfdictionary, &ocategoryname) 
+                || !ocategoryname 
+                || !strcmp(ocategoryname," "))
+              
+                cbf_failnez(cbf_set_hashedvalue(cbfdictionary, categoryname, "category_id", rownum))
+          
+        }
+        
+        dictionary->node = base_node;
+        	
+        if (!cbf_find_local_tag(dictionary,"_category_aliases.alias_name") )  {
+
+          if (!cbf_get_value(dictionary, &alias_name)) {
+
+            cbf_failnez(cbf_find_category(cbfdictionary, "category_aliases"))
+
+            if (cbf_find_hashedvalue(cbfdictionary, alias_name, "category_alias", 
+              CBF_CASE_INSENSITIVE)) {
+
+            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, alias_name, "category_alias", -1))
+
+            }
+            
+            cbf_failnez( cbf_row_number          (cbfdictionary, (unsigned int *)&rownum))
+            
+            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, categoryname, "category_root", rownum))
+
+          }
+
+        }
+
+      }
+
+    }
+
+return 0;
+}
+
+  /* The reference count columns kept in a dictionary by validation */
+
+static const char * const cbf_refcount_columns [] = {
+
+  "CBF_wide_refcounts", "DB_wide_refcounts", "DBcat_wide_refcounts",
+
+  "SF_wide_refcounts",  "SFcat_wide_refcounts" };
+
+#define CBF_REFCOUNT_COLUMNS 5
+
+
+  /* Find the reference count of the current row of a read-only
+     dictionary, which is kept with the view rather than in the tree */
+
+static int cbf_find_view_refcount (cbf_handle handle, const char *columnname,
+                                                     int **count)
+{
+  int index;
+
+  size_t size;
+
+  for (index = 0; index < CBF_REFCOUNT_COLUMNS; index++)
+
+    if (!strcmp (columnname, cbf_refcount_columns [index]))
+
+      break;
+
+  if (index == CBF_REFCOUNT_COLUMNS)
+
+    return CBF_ARGUMENT;
+
+  size = ((size_t) handle->row + 1) * CBF_REFCOUNT_COLUMNS;
+
+  if (size > handle->refcounts_size) {
+
+    if (size < handle->refcounts_size * 2)
+
+      size = handle->refcounts_size * 2;
+
+    cbf_failnez (cbf_realloc ((void **) &handle->refcounts,
+                              &handle->refcounts_size, sizeof (int), size))
+  }
+
+  *count = handle->refcounts + (size_t) handle->row * CBF_REFCOUNT_COLUMNS + index;
+
+  return 0;
+}
+
+
+  /* Get a reference count of the current dictionary row */
+
+static int cbf_get_refcount (cbf_handle dictionary, const char *columnname,
+                                                    long *refcount)
+{
+  const char *refcountval;
+
+  char *endptr;
+
+  int *count;
+
+  *refcount = 0;
+
+  if (dictionary->readonly) {
+
+    cbf_failnez (cbf_find_view_refcount (dictionary, columnname, &count))
+
+    *refcount = *count;
+
+    return 0;
+
+  }
+
+  cbf_failnez (cbf_find_column (dictionary, columnname))
+
+  if (!cbf_get_value (dictionary, &refcountval) && refcountval)
+
+    *refcount = strtol (refcountval, &endptr, 10);
+
+  return 0;
+}
+
+
+  /* Increment a column */
+
+int cbf_increment_column( cbf_handle handle, const char* columnname, int * count ) {
+
+  int *refcount;
+
+  if (handle && handle->readonly) {
+
+    cbf_failnez (cbf_find_view_refcount (handle, columnname, &refcount))
+
+    *count = ++(*refcount);
+
+    return 0;
+
+  }
+
+  cbf_failnez(cbf_find_column(handle, columnname))
+  
+  if (!cbf_get_integervalue(handle, count)) {
+  
+    (*count)++;
+  
+    return cbf_set_integervalue(handle, *count);
+  	
+  }
+  
+  *count = 1;
+  
+  return cbf_set_integervalue(handle, 1);  
+	
+}
+
+  /* Reset a column */
+
+int cbf_reset_column( cbf_handle handle, const char* columnname) {
+
+  size_t row;
+
+  int *refcount;
+
+  if (handle && handle->readonly) {
+
+    cbf_failnez (cbf_find_view_refcount (handle, columnname, &refcount))
+
+    refcount -= (size_t) handle->row * CBF_REFCOUNT_COLUMNS;
+
+    for (row = 0; row < handle->refcounts_size / CBF_REFCOUNT_COLUMNS; row++)
+
+      refcount [row * CBF_REFCOUNT_COLUMNS] = 0;
+
+    return 0;
+
+  }
+
+  if (!cbf_find_column(handle, columnname )) {
+  
+    cbf_failnez( cbf_remove_column(handle))
+  	
+  }
+  
+  return cbf_new_column( handle, columnname);
+	
+}
+
+
+  /* Reset reference counts for a dictionary */
+  
+int cbf_reset_refcounts( cbf_handle dictionary ) {
+
+  if ( dictionary && !cbf_find_tag(dictionary,"_items.name"))  {
+  
+    cbf_failnez(cbf_reset_column(dictionary, "CBF_wide_refcounts") )
+  
+    cbf_failnez(cbf_reset_column(dictionary, "DB_wide_refcounts") )
+  
+    cbf_failnez(cbf_reset_column(dictionary, "DBcat_wide_refcounts") )
+  	
+    cbf_failnez(cbf_reset_column(dictionary, "SF_wide_refcounts") )
+
+    cbf_failnez(cbf_reset_column(dictionary, "SFcat_wide_refcounts") )
+  }
+  
+  return 0;
+	
+}
+
+  /* Convert a DDL1 or DDL2 dictionary and add it to a CBF dictionary */
+
+
+int cbf_convert_dictionary (cbf_handle handle, cbf_handle dictionary )
+{
+    cbf_handle dict;
+		
+    unsigned int blocks, frames, blockitems, blocknum, itemnum;
+
+    unsigned int numrows, rownum, parent_row;
+
+    int inconsistent;
+
+    CBF_NODETYPE itemtype;
+
+    const char *datablock_name;
+
+    const char *saveframe_name;
+    
+    const char *parent_name, *child_name;
+    
+    const char *type_code, *otype_code;
+    
+    char buffer[255];
+
+    if (!handle || !dictionary ) return CBF_ARGUMENT;
+
+    cbf_failnez( cbf_require_dictionary(handle, &dict))
+
+    if (dict->readonly) return CBF_ARGUMENT;
+
+    cbf_failnez( cbf_require_datablock  (dict, "cbf_dictionary"))
+    
+
+    cbf_failnez( cbf_require_category   (dict, "category_aliases(hash_table)"))
+    
+      cbf_failnez( cbf_require_column   (dict, "category_root(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_alias(hash_next)"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "category_aliases"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_root"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_alias"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_root(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_alias(hash_next)"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "item_aliases(hash_table)"))
+
+      cbf_failnez( cbf_require_column   (dict, "item_root(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "item_alias(hash_next)"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "item_aliases"))
+
+      cbf_failnez( cbf_require_column   (dict, "item_root"))
+
+      cbf_failnez( cbf_require_column   (dict, "item_alias"))
+
+      cbf_failnez( cbf_require_column   (dict, "item_root(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "item_alias(hash_next)"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "categories(hash_table)"))
+
+      cbf_failnez( cbf_require_column   (dict, "id(hash_next)"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "categories"))
+
+      cbf_failnez( cbf_require_column   (dict, "id"))
+
+      cbf_failnez( cbf_require_column   (dict, "id(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "key"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "items(hash_table)"))
+
+      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
+      
+      cbf_failnez( cbf_require_column   (dict, "category_id(hash_next)"))
+
+
+    cbf_failnez( cbf_require_category   (dict, "items"))
+
+      cbf_failnez( cbf_require_column   (dict, "name"))
+
+      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "type_code"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_id"))
+
+      cbf_failnez( cbf_require_column   (dict, "category_id(hash_next)"))
+
+      cbf_failnez( cbf_require_column   (dict, "sub_category_id"))
+
+      cbf_failnez( cbf_require_column   (dict, "mandatory_code"))
+
+      cbf_failnez( cbf_require_column   (dict, "default_value"))
+
+      cbf_failnez( cbf_require_column   (dict, "parent"))
+      
+	  cbf_failnez( cbf_require_column	(dict, "method_expression"))
+ 
+
+    cbf_failnez( cbf_require_category   (dict, "items_enumerations(hash_table)"))
+
+      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
+   
+
+    cbf_failnez( cbf_require_category   (dict, "items_enumerations"))
+
+      cbf_failnez( cbf_require_column   (dict, "name"))
+
+      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
+      
+      cbf_failnez( cbf_require_column   (dict, "value"))
+
+      cbf_failnez( cbf_require_column   (dict, "value_type"))
+
+
+      cbf_failnez (cbf_rewind_datablock (dictionary))
+
+      cbf_failnez (cbf_count_datablocks (dictionary, &blocks))
+
+
+    for (blocknum = 0; blocknum < blocks;  blocknum++ )
+    {
+      cbf_failnez (cbf_select_datablock(dictionary, blocknum))
+
+      cbf_failnez (cbf_datablock_name(dictionary, &datablock_name))
+
+      if ( !cbf_rewind_blockitem(dictionary, &itemtype) ) {
+
+        if (cbf_count_saveframes(dictionary, &frames) || frames == 0)
+        {
+            cbf_failnez( cbf_convert_dictionary_definition(dict, dictionary, datablock_name))
+
+        } else {
+
+          cbf_failnez (cbf_count_blockitems(dictionary, &blockitems))
+
+          for (itemnum = 0; itemnum < blockitems;  itemnum++) {
+
+            cbf_select_blockitem(dictionary, itemnum, &itemtype);
+
+            if (itemtype == CBF_SAVEFRAME) {
+
+              cbf_failnez( cbf_saveframe_name(dictionary, &saveframe_name))
+
+              cbf_failnez( cbf_convert_dictionary_definition(dict, dictionary, saveframe_name))
+
+            }
+
+          }
+
+        }
+
+      }
+
+    }
+    
+    /* Update unfilled-in items for children */
+    
+    if( !cbf_find_tag(dict,"_items.parent")) {
+    
+      cbf_failnez(cbf_count_rows(dict,&numrows))
+      
+      for (rownum = 0; rownum < numrows; rownum++)  {
+      
+        cbf_failnez(cbf_find_column(dict,"parent"))
+        
+        if (!cbf_select_row(dict,rownum)) {
+        
+          if (!cbf_get_value(dict,&parent_name) && parent_name) {
+          
+            if (!cbf_find_hashedvalue(dict, parent_name, "name", CBF_CASE_INSENSITIVE)) {
+            
+              cbf_failnez(cbf_row_number(dict,&parent_row))
+              
+              cbf_failnez(cbf_find_column(dict,"type_code"))
+              
+              if (!cbf_get_value(dict,&type_code) && type_code) {
+              
+                cbf_failnez(cbf_select_row(dict,rownum))
                 
-                cbf_failnez( cbf_set_integervalue   (handle, orownum))
+                if (cbf_get_value(dict,&otype_code)) otype_code = NULL;
                 
-            }
-            
-            if (cbf_get_integervalue (handle, &orownum)) {
+                  /* Compare before the old value is freed */
                 
+                inconsistent = otype_code && !cbf_cistrcmp(otype_code, type_code);
                 
-                cbf_failnez(cbf_set_integervalue (handle, -1))
+                cbf_failnez(cbf_set_value(dict,type_code))
                 
+                if (inconsistent) {
+                
+                  cbf_failnez(cbf_find_column(dict,"name"))
+                  
+                  if (!cbf_get_value(dict,&child_name)) {
+                  	
+                    sprintf(buffer," inconsistent data type %s for %s", type_code, child_name);
+                    
+                  }
+                	
+                }
+              	
+              }
+            	
             }
-            
-            cbf_failnez( cbf_find_column        (handle, columnname))
-            
-            cbf_failnez( cbf_select_row         (handle, nrownum));
-            
-            return 0;
-            
-        }      
-        
-        rownum = orownum;
-        
+          	
+          }
+        	
+        }
+      	
+      }
+          
+    	
     }
-    
-    return CBF_NOTFOUND;
-    
+
+    if (getenv("CBFLIB_DEBUG") ) cbf_failnez(cbf_write_file(dict,stderr,0,0,0,0))
+	
+    return 0;
+
 }
 
 
-  /* Find value in the named column, using the hash table links, if available*/
+  /* Precompiled dictionary images
 
-int cbf_find_hashedvalue(cbf_handle handle, const char * value, 
-                                            const char * columnname,
-                                            int caseinsensitive) {
+     A converted dictionary is saved as a header, a preorder list of
+     its nodes as 32-bit words and a block of NUL-terminated text.
+     Each node is written as its type, the text offset of its name and
+     the number of its children, followed, for a column, by the text
+     offsets of its values and, otherwise, by its children.  Values are
+     stored with their token types resolved, so that a loaded tree can
+     point straight into a mapping of the file that is shared by every
+     handle and process using it. */
 
-  char colhashnext[91];
-  
-  char * category;
-  
-  char categoryhashtable[91];
+#define CBF_DICTIONARY_IMAGE_MAGIC "CBFDICT1"
 
-  char hashcodestring[81];
-  
-  unsigned int hashcode;
+#define CBF_DICTIONARY_IMAGE_ORDER 0x01020304U
 
-  int rownum, catrownum;
+#define CBF_DICTIONARY_IMAGE_NONE  0xFFFFFFFFU
 
-  const char * rowvalue;
+  /* Root, data block, save frame, category and column */
 
-  int colnamelen, catnamelen;
-  
-  if (!columnname) return CBF_ARGUMENT;
+#define CBF_DICTIONARY_IMAGE_DEPTH 5
 
-  if ( (colnamelen = strlen(columnname)) > 80 ) return CBF_ARGUMENT;
-  
-  cbf_failnez(cbf_category_name (handle, (const char **)&category));
-  
-  if ( (catnamelen = strlen(category)) > 80 ) return CBF_ARGUMENT;
-  
+typedef struct
+{
+  char magic [8];
 
-    /* Compute the hashcode value (0-255) */
+  unsigned int order, words, text_size, reserved;
+}
+cbf_dictionary_image_header;
 
-  cbf_failnez (cbf_compute_hashcode(value, &hashcode))
+typedef struct
+{
+  unsigned int *word;
 
-  sprintf (hashcodestring,"%d",hashcode);
-  
-    /* Save the category of the primary search */
-  
-  strcpy (categoryhashtable,category);
-  
-    /* Compute the names
-    
-        <category>(hash_table)
-        <column>(hash_next)
-        
-     */
-  
-  strcpy (categoryhashtable + catnamelen, "(hash_table)");   
+  size_t words, word_size;
 
-  strcpy (colhashnext, columnname);
+  char *text;
 
-  strcpy (colhashnext+colnamelen, "(hash_next)");
-  
-    /* Switch to the hash table and make sure it has enough rows */
-  
-  cbf_failnez( cbf_require_category (handle, categoryhashtable))
-  
-  cbf_failnez( cbf_require_column   (handle, colhashnext))
-  
-  cbf_failnez( cbf_count_rows       (handle, (unsigned int *)&catrownum))
-  
-  if ((unsigned int)catrownum < hashcode+1) {
-  
-    for (rownum = catrownum; (unsigned int)rownum < hashcode+1; rownum++) {
-    
-      cbf_failnez( cbf_new_row(handle))
-    	
-    }	
-  	
+  size_t text_used, text_size;
+}
+cbf_dictionary_image;
+
+
+  /* Add a word to an image */
+
+static int cbf_image_word (cbf_dictionary_image *image, unsigned int word)
+{
+  if (image->words == image->word_size)
+
+    cbf_failnez (cbf_realloc ((void **) &image->word, &image->word_size,
+                              sizeof (unsigned int),
+                              image->word_size ? image->word_size * 2 : 4096))
+
+  image->word [image->words++] = word;
+
+  return 0;
+}
+
+
+  /* Add a string to the text of an image and its offset to the words */
+
+static int cbf_image_text (cbf_dictionary_image *image, const char *string)
+{
+  size_t length, size;
+
+  if (!string)
+
+    return cbf_image_word (image, CBF_DICTIONARY_IMAGE_NONE);
+
+  length = strlen (string) + 1;
+
+  if (image->text_used + length >= CBF_DICTIONARY_IMAGE_NONE)
+
+    return CBF_ALLOC;
+
+  if (image->text_used + length > image->text_size)
+  {
+    size = image->text_size ? image->text_size * 2 : 65536;
+
+    while (size < image->text_used + length)
+
+      size *= 2;
+
+    cbf_failnez (cbf_realloc ((void **) &image->text, &image->text_size, 1, size))
   }
-  
-    /* examine the row in the hash table given by the hash code
-       to see if it points to a row  */
 
-  if ( ! cbf_select_row(handle, hashcode) 
-       && !cbf_get_integervalue(handle, (int *) &rownum)
-       &&  rownum >= 0 ) {
-  
-    /* If we have a start point, trace the chain until we find
-       a match to the probe, or fail */
+  memcpy (image->text + image->text_used, string, length);
 
-  	cbf_failnez( cbf_find_category    (handle,   category))
-  	
-    while ( rownum >=0 )  {
-  
-      cbf_failnez( cbf_find_column    (handle,   columnname))
+  cbf_failnez (cbf_image_word (image, (unsigned int) image->text_used))
 
-      cbf_failnez( cbf_select_row     (handle,   rownum))
-      
-      if (caseinsensitive) {
-      	
-        if ( !cbf_get_value(handle, &rowvalue)  && rowvalue && !cbf_cistrcmp(rowvalue, value)) {
-            
-            cbf_debug_print4("cbf_find_hashed_value, category %s, column %s, row %ud", category, columnname, rownum);
-            
-            cbf_debug_print2("cbf_find_hashed_value, value %s", value);
+  image->text_used += length;
 
-      
-          return 0;
-          
-        }
-          
-      } else {
-      
-        if ( !cbf_get_value(handle, &rowvalue)  && rowvalue && !strcmp(rowvalue, value)) {
-      
-          return 0;
-          
-        }
-      	
+  return 0;
+}
+
+
+  /* Add a node and everything below it to an image */
+
+static int cbf_image_node (cbf_dictionary_image *image, cbf_node *node)
+{
+  unsigned int count;
+
+  const char *value;
+
+  cbf_node *child;
+
+  node = cbf_get_link (node);
+
+  if (!node)
+
+    return CBF_ARGUMENT;
+
+  cbf_failnez (cbf_image_word (image, (unsigned int) node->type))
+
+  cbf_failnez (cbf_image_text (image, node->name))
+
+  cbf_failnez (cbf_image_word (image, node->children))
+
+  for (count = 0; count < node->children; count++)
+
+    if (node->type == CBF_COLUMN)
+    {
+      cbf_failnez (cbf_get_columnrow (&value, node, count))
+
+      if (value)
+      {
+        cbf_failnez (cbf_value_type ((char *) value))
+
+        if (*value == CBF_TOKEN_BIN     ||
+            *value == CBF_TOKEN_TMP_BIN ||
+            *value == CBF_TOKEN_MIME_BIN)
+
+          return CBF_ARGUMENT;
       }
-      
-      cbf_failnez( cbf_find_column    (handle, colhashnext))
-    
-      if (cbf_get_integervalue       (handle,&rownum)) break;
-            	
+
+      cbf_failnez (cbf_image_text (image, value))
     }
-    
+    else
+    {
+      cbf_failnez (cbf_get_child (&child, node, count))
+
+      cbf_failnez (cbf_image_node (image, child))
+    }
+
+  return 0;
+}
+
+
+  /* Write the dictionary of a cbf as a precompiled image.  The stream
+     is left open. */
+
+int cbf_write_dictionary_cache (cbf_handle handle, FILE *stream)
+{
+  cbf_dictionary_image image;
+
+  cbf_dictionary_image_header header;
+
+  cbf_handle dictionary;
+
+  cbf_node *node;
+
+  int errorcode;
+
+  if (!handle || !stream)
+
+    return CBF_ARGUMENT;
+
+  cbf_failnez (cbf_get_dictionary (handle, &dictionary))
+
+  cbf_failnez (cbf_build_datablocks (dictionary))
+
+  cbf_failnez (cbf_find_parent (&node, dictionary->node, CBF_ROOT))
+
+  memset (&image, 0, sizeof (image));
+
+  errorcode = cbf_image_node (&image, node);
+
+  if (!errorcode && image.words >= CBF_DICTIONARY_IMAGE_NONE)
+
+    errorcode = CBF_ALLOC;
+
+  if (!errorcode)
+  {
+    memset (&header, 0, sizeof (header));
+
+    memcpy (header.magic, CBF_DICTIONARY_IMAGE_MAGIC, sizeof (header.magic));
+
+    header.order = CBF_DICTIONARY_IMAGE_ORDER;
+
+    header.words = (unsigned int) image.words;
+
+    header.text_size = (unsigned int) image.text_used;
+
+    if (fwrite (&header, sizeof (header), 1, stream) != 1 ||
+        fwrite (image.word, sizeof (unsigned int), image.words, stream) != image.words ||
+        fwrite (image.text, 1, image.text_used, stream) != image.text_used ||
+        fflush (stream))
+
+      errorcode = CBF_FILEWRITE;
   }
 
-  cbf_failnez( cbf_find_category      (handle,   category))
-  
-  cbf_failnez( cbf_find_column        (handle,   columnname))
-  
-  return CBF_NOTFOUND;
+  errorcode |= cbf_free ((void **) &image.word, &image.word_size);
+
+  errorcode |= cbf_free ((void **) &image.text, &image.text_size);
+
+  return errorcode;
+}
+
+
+  /* Can a node of type child hang from a node of type parent? */
+
+static int cbf_image_child_type (CBF_NODETYPE parent, unsigned int child)
+{
+  switch (parent)
+  {
+    case CBF_ROOT:
+
+      return child == CBF_DATABLOCK;
+
+    case CBF_DATABLOCK:
+
+      return child == CBF_SAVEFRAME || child == CBF_CATEGORY;
+
+    case CBF_SAVEFRAME:
+
+      return child == CBF_CATEGORY;
+
+    case CBF_CATEGORY:
+
+      return child == CBF_COLUMN;
+
+    default:
 
+      return 0;
+  }
 }
 
 
-int cbf_convert_dictionary_definition(cbf_handle cbfdictionary, cbf_handle dictionary,
-                                                                const char * name)
+  /* Rebuild the children of a node from the words of an image, the
+     node being depth levels below the root */
+
+static int cbf_image_load (cbf_node *node, const unsigned int **word,
+                           const unsigned int *end,
+                           const char *text, size_t text_size,
+                           unsigned int depth)
 {
+  unsigned int count, children, type, offset;
 
-    const char *category_id;
+  const char *name;
 
-    const char *mandatory_code;
+  cbf_node *child;
 
-    const char *itemname=NULL;
-	
-    const char *expression;
+  int errorcode;
 
-    const char *columnname;
-    
-    const char *categoryname, *ocategoryname;
-           
-    int colno;
+  if (depth >= CBF_DICTIONARY_IMAGE_DEPTH || *word >= end)
 
-    const char *type_code;
+    return CBF_FORMAT;
 
-    const char *default_value;
+  children = *((*word)++);
 
-    const char *parent_name;
+  if (node->type == CBF_COLUMN)
+  {
+    if ((size_t) (end - *word) < children)
 
-    const char *child_name;
+      return CBF_FORMAT;
 
-    const char *alias_name;
+    cbf_failnez (cbf_set_children (node, children))
 
-    const char *key, *oldkey;
-    
-    const char *value, *value2, *value_type;
-    
-    const char *keytype;
-    
-    char buffer[255];
+    cbf_failnez (cbf_set_column_image (node, text, text_size))
 
-    cbf_node * base_node, * local_node;
+    for (count = 0; count < children; count++)
+    {
+      offset = *((*word)++);
 
-    int rownum, numrows, numrow;
-    
-    int nextkeyrow;
+      if (offset == CBF_DICTIONARY_IMAGE_NONE)
 
-    int haveitemname;
+        continue;
 
-    int haveitemcategory;
+      if (offset >= text_size || (text [offset] & '\300') != '\300')
 
-    haveitemname = haveitemcategory = 0;
-    
-      /* Save the base data block or save frame to come back to */
-    
-    base_node = dictionary->node;
-    
-    local_node = base_node;
-    
-      /* Find the name for this defintion */
+        return CBF_FORMAT;
 
-    if (!cbf_find_local_tag(dictionary,"_name") ||
-      !cbf_find_local_tag(dictionary,"_item.name") ||
-      !cbf_find_local_tag(dictionary,"_definition.id")) {
-    	
-       haveitemname = 1; local_node = dictionary->node;
-       
-       cbf_failnez(cbf_column_name(dictionary, &columnname) )
-       
+      cbf_failnez (cbf_set_columnrow (node, count, text + offset, 0))
     }
 
-    if (!haveitemname && (!cbf_find_category(dictionary,"item") || !cbf_find_category(dictionary,"name"))) haveitemcategory = 1;
+    return 0;
+  }
 
-    if (haveitemname || haveitemcategory) {
+  for (count = 0; count < children; count++)
+  {
+    if (end - *word < 3)
 
-      cbf_failnez( cbf_count_rows (dictionary,(unsigned int *)&numrows))
+      return CBF_FORMAT;
 
-      cbf_failnez( cbf_rewind_row        (dictionary))
+    type = *((*word)++);
 
-      for (numrow=0; numrow < numrows; numrow++) {
+    offset = *((*word)++);
 
-        cbf_failnez( cbf_require_category  (cbfdictionary, "items"))
-        
-        if (haveitemname  && !cbf_find_column(dictionary,columnname)) {
- 
-          cbf_failnez( cbf_select_row(dictionary, numrow) )
+    if (!cbf_image_child_type (node->type, type))
 
-          cbf_failnez( cbf_get_value(dictionary, &itemname))
+      return CBF_FORMAT;
 
-        } else {
+    name = NULL;
 
-          itemname = name;
+    if (offset != CBF_DICTIONARY_IMAGE_NONE)
+    {
+      if (offset >= text_size)
 
-        }
+        return CBF_FORMAT;
 
-        if (cbf_find_hashedvalue(cbfdictionary, itemname, "name", 
-           CBF_CASE_INSENSITIVE)) {
+      name = cbf_copy_string (NULL, text + offset, 0);
 
-          cbf_failnez( cbf_set_hashedvalue (cbfdictionary, itemname, "name", -1))
+      if (!name)
 
-        }
-        
-        cbf_failnez( cbf_row_number          (cbfdictionary, (unsigned int*)&rownum))
+        return CBF_ALLOC;
+    }
 
-        if (!cbf_find_column(dictionary,"category_id") 
-          || !cbf_find_column(dictionary,"_category")){
+    errorcode = cbf_make_new_child (&child, node, (CBF_NODETYPE) type, name);
 
-          cbf_failnez( cbf_select_row(dictionary, (unsigned int)numrow) )
+    if (errorcode)
+    {
+      if (name)
 
-          if (!cbf_get_value(dictionary, &category_id)) {
+        cbf_free_string (NULL, name);
 
-            cbf_failnez( cbf_find_column(cbfdictionary, "category_id"));
-            
-            if (cbf_get_value(cbfdictionary, &categoryname) 
-              || !categoryname 
-              || !strcmp(categoryname," "))
-              
-            cbf_failnez(cbf_set_hashedvalue(cbfdictionary, category_id, "category_id", rownum))
+      return errorcode;
+    }
 
-          }
+    cbf_failnez (cbf_image_load (child, word, end, text, text_size, depth + 1))
+  }
 
-        } else  {
-        
-          dictionary->node = base_node;
-        	
-          if (!cbf_find_local_tag(dictionary,"_category")
-              ||!cbf_find_local_tag(dictionary,"_item.category_id") ) {
-              
-            if (!cbf_get_value(dictionary, &category_id)) {
+  return 0;
+}
 
-              cbf_failnez( cbf_find_column(cbfdictionary, "category_id"));
 
-              if (cbf_get_value(cbfdictionary, &categoryname) 
-                || !categoryname 
-                || !strcmp(categoryname," "))
-              
-              cbf_failnez(cbf_set_hashedvalue(cbfdictionary, category_id, "category_id", rownum))
-              
-            }
+  /* Load a precompiled dictionary image as the dictionary of a cbf.
+     The image is mapped rather than copied where the system allows,
+     and the values of the dictionary point into it.  The stream is
+     left open. */
 
-          }
-             
-        }
+int cbf_read_dictionary_cache (cbf_handle handle, FILE *stream)
+{
+  cbf_dictionary_image_header header;
 
-        dictionary->node = local_node;
+  cbf_handle dictionary;
 
-        if (!cbf_find_column(dictionary,"mandatory_code") ) {
+  cbf_node *node;
 
-          cbf_failnez( cbf_select_row(dictionary, numrow) )
+  const unsigned int *word;
 
-          if (!cbf_get_value(dictionary, &mandatory_code)) {
+  const char *text;
 
-            cbf_failnez( cbf_find_column(cbfdictionary, "mandatory_code"));
+  struct stat status;
 
-            cbf_failnez( cbf_set_value(cbfdictionary, mandatory_code))
+  int errorcode;
 
-          }
+  if (!handle || !stream)
 
-        }
+    return CBF_ARGUMENT;
 
+  if (fstat (fileno (stream), &status) || status.st_size < (off_t) sizeof (header))
 
-        dictionary->node = base_node;
-        	
-        if ( !cbf_find_local_tag(dictionary,"_type") ||
-          !cbf_find_local_tag(dictionary,"_item_type.code") ||
-          !cbf_find_local_tag(dictionary,"_type.contents") ) {
+    return CBF_FILEREAD;
 
-          if (!cbf_get_value(dictionary, &type_code)) {
+  cbf_failnez (cbf_make_handle (&dictionary))
 
-            cbf_failnez( cbf_find_column(cbfdictionary, "type_code"));
+  dictionary->image_size = (size_t) status.st_size;
 
-            cbf_failnez( cbf_set_value(cbfdictionary, type_code))
+#ifndef _WIN32
 
-          }
+    /* Map the file privately: the pages stay shared between processes
+       unless something writes to them */
 
-        }  
-        
+  dictionary->image = mmap (NULL, dictionary->image_size,
+                            PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                            fileno (stream), 0);
 
-        dictionary->node = base_node;
-        	
-        if (!cbf_find_local_tag(dictionary,"_enumeration_default") ||
-          !cbf_find_local_tag(dictionary,"_item_default.value") ||
-		  !cbf_find_local_tag(dictionary,"_enumeration.default"))  {
+  if (dictionary->image == MAP_FAILED)
+  {
+    dictionary->image = NULL;
 
-          if (!cbf_get_value(dictionary, &default_value)) {
+    return CBF_FILEREAD | cbf_free_handle (dictionary);
+  }
 
-            cbf_failnez( cbf_find_column(cbfdictionary, "default_value"));
+#else
 
-            cbf_failnez( cbf_set_value(cbfdictionary, default_value))
+  errorcode = cbf_alloc (&dictionary->image, NULL, 1, dictionary->image_size);
 
-          }
+  if (!errorcode && (fseek (stream, 0, SEEK_SET) ||
+      fread (dictionary->image, 1, dictionary->image_size, stream)
+                                != dictionary->image_size))
 
-        }
+    errorcode = CBF_FILEREAD;
 
-       dictionary->node = base_node;
-        	
-        if (!cbf_find_local_tag(dictionary,"_method.expression"))  {
+  if (errorcode)
 
-          if (!cbf_get_value(dictionary, &expression)) {
-		
-           cbf_failnez( cbf_require_column(cbfdictionary, "method_expression"));
+    return errorcode | cbf_free_handle (dictionary);
 
-            cbf_failnez( cbf_set_value(cbfdictionary, expression))
+#endif
 
-          }
 
-        }	
+    /* Check the header */
 
-        dictionary->node = base_node;
-        	
-        if ( !cbf_find_local_tag(dictionary,"_item_aliases.alias_name") )  {
+  memcpy (&header, dictionary->image, sizeof (header));
 
-          if (!cbf_get_value(dictionary, &alias_name)) {
+  word = (const unsigned int *) ((char *) dictionary->image + sizeof (header));
 
-            cbf_failnez(cbf_find_category(cbfdictionary, "item_aliases"))
+  text = (const char *) (word + header.words);
 
-            if (cbf_find_hashedvalue(cbfdictionary, alias_name, "item_alias", 
-              CBF_CASE_INSENSITIVE)) {
+  if (memcmp (header.magic, CBF_DICTIONARY_IMAGE_MAGIC, sizeof (header.magic)) ||
+      header.order != CBF_DICTIONARY_IMAGE_ORDER || header.words < 3 ||
+      (dictionary->image_size - sizeof (header)) / sizeof (unsigned int) < header.words ||
+      dictionary->image_size - sizeof (header)
+                             - header.words * sizeof (unsigned int) != header.text_size ||
+      (header.text_size && text [header.text_size - 1]) ||
+      word [0] != CBF_ROOT)
 
-            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, alias_name, "item_alias", -1))
+    return CBF_FORMAT | cbf_free_handle (dictionary);
 
-            }
-            
-            cbf_failnez( cbf_row_number          (cbfdictionary, (unsigned int *)&rownum))
-            
-            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, itemname, "item_root", rownum))
 
-          }
+    /* Rebuild the tree */
 
-        }
+  errorcode = cbf_find_parent (&node, dictionary->node, CBF_ROOT);
 
-      }
+  word += 2;
 
-    }
-    
-    
-    /* extract enumerations */
-    
-    dictionary->node = base_node;
-    
-    value_type = "value";
+  if (!errorcode)
 
-    if (!cbf_find_local_tag(dictionary, "_item_enumeration.value") ||
-      !cbf_find_local_tag(dictionary, "_enumeration"))  {
-      
-      cbf_failnez( cbf_column_number(dictionary, (unsigned int *)&colno))
-      
-      cbf_failnez( cbf_count_rows (dictionary, (unsigned int *)&numrows))
+    errorcode = cbf_image_load (node, &word,
+               (const unsigned int *) text, text, header.text_size, 0);
+
+  if (!errorcode && word != (const unsigned int *) text)
+
+    errorcode = CBF_FORMAT;
+
+  if (!errorcode)
+
+    errorcode = cbf_set_dictionary (handle, dictionary);
+
+  return errorcode | cbf_free_handle (dictionary);
+}
+
+
+  /* Find the requested tag anywhere in the cbf, make it the current column */
+
+int cbf_find_tag (cbf_handle handle, const char *tag)
+{
+  cbf_node *node;
+
+  size_t catlen, collen;
+
+  char categoryname[81];
+
+  char columnname[81];
+
+  char *colstart;
+
+  if (!handle || !tag) return CBF_ARGUMENT;
+
+  if (strlen(tag)>80) return CBF_ARGUMENT;
+
+  if (tag[0] == '_') tag++;
+
+  if (!(colstart = strchr(tag,'.'))) {
+
+    colstart=(char *)tag-1;
+
+    catlen = 0;
+
+  } else {
+
+    catlen = colstart-tag;
+
+  }
+  if (catlen) memcpy(categoryname,tag,catlen);
+
+  categoryname[catlen] = '\0';
+
+  collen = (tag+strlen(tag))-colstart;
+
+  columnname[0] = '_';
+
+  if (collen) memcpy(columnname+(catlen?0:1),colstart+1,collen);
+
+  columnname[collen+(catlen?0:1)] = '\0';
+
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-      cbf_failnez( cbf_rewind_row        (dictionary))
+  cbf_failnez(cbf_srch_tag(handle, node, categoryname, columnname))
 
-      cbf_failnez( cbf_require_category  (cbfdictionary, "items_enumerations"))
-        
-      for (numrow=0; numrow < numrows; numrow++) {
-      
-        cbf_failnez( cbf_select_row(dictionary, numrow))
-        
-        cbf_failnez( cbf_select_column(dictionary, colno))
+  return 0;
 
-        cbf_failnez( cbf_get_value (dictionary, &value))
+}
 
-        if (!haveitemname)   {
-        
-          cbf_failnez (cbf_find_column(dictionary,"name"))
+  /* Find the requested tag in the cbf within the current
 
-          cbf_failnez (cbf_get_value(dictionary,&itemname))
-        	
-        }
+     save frame or data block, make it the current column */
 
-        cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, itemname, "name", -1))
+int cbf_find_local_tag (cbf_handle handle, const char *tag)
+{
+  cbf_node *node;
 
-        cbf_failnez( cbf_require_column      (cbfdictionary, "value"))
-        
-        cbf_failnez( cbf_set_value           (cbfdictionary, value))
-        
-        cbf_failnez( cbf_require_column      (cbfdictionary, "value_type") )
-        
-        cbf_failnez( cbf_set_value           (cbfdictionary, value_type))
-        
-      }
-    
-    }
+  size_t catlen, collen;
 
-    dictionary->node = base_node;
-        	
-    if (!cbf_find_local_tag(dictionary, "_item_range.minimum") ||
-      !cbf_find_local_tag(dictionary, "_enumeration_range") ||
-      !cbf_find_local_tag(dictionary, "_enumeration.range"))  {
-      
-      cbf_failnez( cbf_column_number(dictionary, (unsigned int *)&colno))
-      
-      cbf_failnez( cbf_count_rows (dictionary, (unsigned int *)&numrows))
+  char categoryname[81];
 
-      cbf_failnez( cbf_rewind_row        (dictionary))
+  char columnname[81];
 
-      cbf_failnez( cbf_require_category    (cbfdictionary, "items_enumerations"))
-        
-      for (numrow=0; numrow < numrows; numrow++) {
-            
-        cbf_failnez( cbf_select_row(dictionary, numrow) )
-        
-        cbf_failnez( cbf_select_column(dictionary, colno))
+  char *colstart;
 
-        cbf_failnez( cbf_get_value (dictionary, &value))
-                
-        if (!haveitemname)   {
-        
-          cbf_failnez (cbf_find_column(dictionary,"name"))
+  if (!handle || !tag) return CBF_ARGUMENT;
 
-          cbf_failnez (cbf_get_value(dictionary,&itemname))
-        	
-        }
+  if (strlen(tag)>80) return CBF_ARGUMENT;
 
-        value_type = "closed_range";
+  if (tag[0] == '_') tag++;
 
-        if (!cbf_find_column(dictionary, "maximum")) {
-        
-          cbf_failnez( cbf_get_value (dictionary, &value2))
-          
-          if (value && value2 && strlen(value)+strlen(value2) < 255) {
-          
-            if (strcmp(value,value2)) value_type = "open_range";
- 
-            strcpy(buffer,value);
-            
-            buffer[strlen(value)]=':';
-            
-            strcpy(buffer+strlen(value)+1,value2);
-            
-            value = buffer;
-            
-          	
-          } else {
-          
-            value = "invalid";
-            
-            sprintf(buffer,"dictionary:  invalid range of values for %s",itemname);
-            
-            cbf_log(dictionary,buffer,CBF_LOGWARNING|CBF_LOGSTARTLOC);
-          	
-          }
-        	
-        }
+  if (!(colstart = strchr(tag,'.'))) {
 
+    colstart=(char *)tag-1;
 
-        cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, itemname, "name", -1))
+    catlen = 0;
 
-        cbf_failnez( cbf_require_column      (cbfdictionary, "value"))
-        
-        cbf_failnez( cbf_set_value           (cbfdictionary, value))
-        
-        cbf_failnez( cbf_require_column      (cbfdictionary, "value_type") )
-        
-        cbf_failnez( cbf_set_value           (cbfdictionary, value_type))
-        
-      }
+  } else {
 
+    catlen = colstart-tag;
 
-    }
+  }
+  if (catlen) memcpy(categoryname,tag,catlen);
 
+  categoryname[catlen] = '\0';
 
+  collen = (tag+strlen(tag))-colstart;
+  
+  columnname[0] = '_';
 
-    dictionary->node = base_node;
-        	
-    if (!cbf_find_local_tag(dictionary, "_item_linked.parent_name") ||
-      !cbf_find_local_tag(dictionary, "_item_link_parent") || 
-      !cbf_find_local_tag(dictionary, "_category.parent_id"))  {
+  if (collen) memcpy(columnname+(catlen?0:1),colstart+1,collen);
 
-      cbf_failnez( cbf_count_rows (dictionary,(unsigned int *)&numrows))
+  columnname[collen+(catlen?0:1)] = '\0';
 
-      cbf_failnez( cbf_rewind_row        (dictionary))
+  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
+  {
 
-      for (numrow=0; numrow < numrows; numrow++) {
+  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
 
-        cbf_failnez( cbf_require_category  (cbfdictionary, "items"))
+  }
 
-        cbf_failnez( cbf_select_row(dictionary, numrow) )
+  cbf_failnez(cbf_srch_tag(handle, node, categoryname, columnname))
 
-        parent_name = NULL;
+  return 0;
 
-        if (!cbf_find_column(dictionary,"parent_name") ||
-            !cbf_find_column(dictionary,"_list_link_parent") || 
-            !cbf_find_column(dictionary,"parent_id") )
-            if (cbf_get_value(dictionary,&parent_name)) parent_name = NULL;
+}
 
-        child_name = NULL;
 
-        if (!cbf_find_column(dictionary,"child_name") ||
-            !cbf_find_column(dictionary,"_list_link_child") )
-            if (cbf_get_value(dictionary,&child_name)) child_name = NULL;
+  /* Find the requested category and column anywhere in the cbf, make it the current column */
 
-        if ((numrows==1) && (child_name == NULL)) {
 
-          child_name = itemname;
+int cbf_srch_tag (cbf_handle handle, cbf_node *node,
+                                     const char *categoryname,
+                                     const char *columnname)
+{
+  unsigned int children, child;
 
-        }
+  if (!node) return CBF_NOTFOUND;
 
-        if (parent_name && child_name) {
+  node = cbf_get_link(node);
 
-          if (cbf_find_hashedvalue(cbfdictionary, child_name, "name", 
-            CBF_CASE_INSENSITIVE)) {
+  if (node->type == CBF_CATEGORY) {
 
-            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, child_name, "name", -1))
+    if (((!(node->name) || (node->name[0] == '_')) &&(categoryname[0]=='\0'))
+       || ((node->name)&&!cbf_cistrcmp(node->name,categoryname))) {
 
-          }
+      cbf_failnez (cbf_find_child(&node,node,columnname))
 
-          cbf_failnez(cbf_find_column(cbfdictionary, "parent"))
+      handle->node = node;
+      
+      handle->row = 0;
 
-          cbf_failnez(cbf_set_value(cbfdictionary,parent_name))
+      handle->search_row = 0;
 
-        }
+      return 0;
 
-      }
+    } else {
+
+      return CBF_NOTFOUND;
 
     }
+  }
 
-    dictionary->node = base_node;
-        	
-    if (!cbf_find_local_tag(dictionary,"_category") ||
+  children = node->children;
 
-      !cbf_find_local_tag(dictionary,"_category.id") )  {
+  for (child = 0; child < children; child++) {
 
-      cbf_failnez( cbf_count_rows (dictionary,(unsigned int *)&numrows))
+      /* Data blocks of a lazy read are built as the search reaches them */
 
-      cbf_failnez( cbf_rewind_row        (dictionary))
-      
-      local_node = dictionary->node;
-      
-      for (numrow=0; numrow < numrows; numrow++) {
+    if (node->type == CBF_ROOT)
 
-        cbf_failnez( cbf_require_category  (cbfdictionary, "categories"))
-        
-        dictionary->node = local_node;
+      cbf_failnez (cbf_build_datablock (handle, (node->child)[child], child))
 
-        cbf_failnez( cbf_select_row(dictionary, numrow) )
-        
-        cbf_failnez( cbf_get_value         (dictionary, &categoryname))
-   
-        if (cbf_find_hashedvalue(cbfdictionary, categoryname, "id", 
-          CBF_CASE_INSENSITIVE)) {
+    if(! cbf_srch_tag(handle, (node->child)[child],
+      categoryname, columnname)) return 0;
 
-          cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, categoryname, "id", -1))
+  }
 
-        } 
-        
-        key = NULL;
-                
-        mandatory_code = "no";
-        
-        if (!cbf_find_column(dictionary,"mandatory_code") 
-          && !cbf_get_value(dictionary,&mandatory_code)) {
-          
-          cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
-          
-          cbf_failnez(cbf_set_value(cbfdictionary,mandatory_code))
-       
-        }
+  return CBF_NOTFOUND;
 
+}
 
-        dictionary->node = base_node;
+  /* Find the root alias of a given category */
 
-        if (!cbf_find_local_tag(dictionary,"_list_reference") ||
-          !cbf_find_local_tag(dictionary,"_category_key.name") ||
-          !cbf_find_local_tag(dictionary,"_category_key.primitive") ||
-          !cbf_find_local_tag(dictionary,"_category_key.generic")) {
+int cbf_find_category_root (cbf_handle handle, const char* categoryname,
+                                            const char** categoryroot)
+{
+    cbf_handle dictionary;
+    
+    const char * tempcatname;
 
-          if (!cbf_get_value(dictionary, &key) && key) {
+    if (!handle || !categoryname || !categoryroot ) return CBF_ARGUMENT;
+
+    dictionary = (cbf_handle) handle->dictionary;
+
+    if (!dictionary) return CBF_NOTFOUND;
+    
+    if (categoryname[0] == '_') {
+    
+      if (!cbf_find_tag(dictionary,"_items.name") 
+        && !cbf_find_hashedvalue(dictionary,categoryname,"name",CBF_CASE_INSENSITIVE)
+        && !cbf_find_column(dictionary,"category_id")
+        && !cbf_get_value(dictionary,&tempcatname)
+        && tempcatname)  categoryname = tempcatname;
+        
+        else return CBF_NOTFOUND;
+    	
+    }
+
+    cbf_failnez( cbf_find_tag(dictionary, "_category_aliases.alias_id"))
+
+    cbf_failnez( cbf_rewind_row(dictionary))
+
+    cbf_failnez( cbf_find_hashedvalue(dictionary, categoryname,"alias_id",CBF_CASE_INSENSITIVE))
 
-            cbf_failnez( cbf_get_typeofvalue(dictionary,&keytype))
+    cbf_failnez( cbf_find_column(dictionary, "root_id"))
 
-            cbf_failnez( cbf_require_column(cbfdictionary, "key"))
-            
-            while (cbf_get_value(cbfdictionary, &oldkey) || !oldkey || strcmp(oldkey," "))  {
-            
-              if (key && oldkey && !strcmp(oldkey,key)) break;
-              
-              cbf_failnez( cbf_find_column         (cbfdictionary, "id(hash_next)"))
-              
-              cbf_failnez( cbf_get_integervalue    (cbfdictionary, &nextkeyrow))
-              
-              cbf_failnez( cbf_find_column(cbfdictionary, "key"))
+    return cbf_get_value(dictionary,categoryroot);
 
-              if (nextkeyrow < 0) {
-            
-                cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, categoryname, "id", -1))
+}
 
-                cbf_failnez( cbf_find_column         (cbfdictionary, "key"))
-              
-                break;
- 
-              }
-              
-              cbf_failnez( cbf_select_row            (cbfdictionary, (unsigned int)nextkeyrow))
-            	
-            }
-            
-            cbf_failnez(cbf_set_value(cbfdictionary,key))
-            
-            if ( keytype != NULL )  {
-            	
-              cbf_failnez(cbf_set_typeofvalue(cbfdictionary,keytype))
-            
-            }
+  /* Find the root alias of a given category, defaulting to the current one */
 
-            cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
-            
-            cbf_failnez(cbf_set_value(cbfdictionary,mandatory_code))
-            
-          }
-          
-        }
-        
-        cbf_failnez( cbf_require_category  (cbfdictionary, "items"))
-        
-        cbf_failnez (cbf_require_column(cbfdictionary,"name"))
+int cbf_require_category_root (cbf_handle handle, const char* categoryname,
+                                            const char** categoryroot)
+{
+    cbf_handle dictionary;
         
-        if (key) {
-        	
-            if (cbf_find_hashedvalue(cbfdictionary,key,"name",CBF_CASE_INSENSITIVE)) {
+    const char * tempcatname;
+
+    if (!handle || !categoryname || !categoryroot ) return CBF_ARGUMENT;
+
+    dictionary = (cbf_handle) handle->dictionary;
+
+    if (categoryname[0] == '_') {
+    
+      if (!cbf_find_tag(dictionary,"_items.name") 
+        && !cbf_find_hashedvalue(dictionary,categoryname,"name",CBF_CASE_INSENSITIVE)
+        && !cbf_find_column(dictionary,"category_id")
+        && !cbf_get_value(dictionary,&tempcatname)
+        && tempcatname)  categoryname = tempcatname;
         
-              cbf_failnez(cbf_set_hashedvalue(cbfdictionary,key,"name", -1))
-          
-              cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
-          
-              cbf_failnez(cbf_set_value(cbfdictionary,"yes"))
-            
-            } else {
+      else {
         
-              cbf_failnez(cbf_require_column(cbfdictionary,"mandatory_code"))
-          
-              if (cbf_get_value(cbfdictionary,&mandatory_code) || !mandatory_code) {
-          
-                 cbf_failnez(cbf_set_value(cbfdictionary,"yes"))
-          	
-              }
-              
-            }
-            
-            cbf_failnez(cbf_row_number(cbfdictionary, (unsigned int *)&rownum))
-            
-            cbf_failnez(cbf_require_column(cbfdictionary,"category_id"))
-              
-              if (cbf_get_value(cbfdictionary, &ocategoryname) 
-                || !ocategoryname 
-                || !strcmp(ocategoryname," "))
-              
-                cbf_failnez(cbf_set_hashedvalue(cbfdictionary, categoryname, "category_id", rownum))
+        * categoryroot = categoryname;
           
-        }
-        
-        dictionary->node = base_node;
+        return 0;
         	
-        if (!cbf_find_local_tag(dictionary,"_category_aliases.alias_name") )  {
-
-          if (!cbf_get_value(dictionary, &alias_name)) {
+      }
+    	
+    }
 
-            cbf_failnez(cbf_find_category(cbfdictionary, "category_aliases"))
+    if (cbf_find_category_root(handle,categoryname,categoryroot))
 
-            if (cbf_find_hashedvalue(cbfdictionary, alias_name, "category_alias", 
-              CBF_CASE_INSENSITIVE)) {
+      * categoryroot = categoryname;
 
-            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, alias_name, "category_alias", -1))
+    return 0;
 
-            }
-            
-            cbf_failnez( cbf_row_number          (cbfdictionary, (unsigned int *)&rownum))
-            
-            cbf_failnez( cbf_set_hashedvalue     (cbfdictionary, categoryname, "category_root", rownum))
+}
 
-          }
+  /* Set the root alias of a given category */
 
-        }
+int cbf_set_category_root (cbf_handle handle, const char* categoryname,
+                                            const char* categoryroot)
+{
+    cbf_handle dictionary;
 
-      }
+    unsigned int rownum;
 
-    }
+    if (!handle || !categoryname || !categoryroot ) return CBF_ARGUMENT;
 
-return 0;
-}
+    cbf_failnez( cbf_require_dictionary(handle, &dictionary))
 
-  /* Increment a column */
+    if (!dictionary) return CBF_NOTFOUND;
 
-int cbf_increment_column( cbf_handle handle, const char* columnname, int * count ) {
+    if (dictionary->readonly) return CBF_ARGUMENT;
 
-  cbf_failnez(cbf_find_column(handle, columnname))
-  
-  if (!cbf_get_integervalue(handle, count)) {
-  
-    (*count)++;
-  
-    return cbf_set_integervalue(handle, *count);
-  	
-  }
-  
-  *count = 1;
-  
-  return cbf_set_integervalue(handle, 1);  
-	
-}
+    if ( cbf_find_tag(dictionary, "_category_aliases.alias_id")) {
 
-  /* Reset a column */
+        cbf_failnez( cbf_require_datablock(dictionary, "dictionary"))
 
-int cbf_reset_column( cbf_handle handle, const char* columnname) {
+        cbf_failnez( cbf_require_category(dictionary, "category_aliases"))
 
-  if (!cbf_find_column(handle, columnname )) {
-  
-    cbf_failnez( cbf_remove_column(handle))
-  	
-  }
-  
-  return cbf_new_column( handle, columnname);
-	
-}
+        cbf_failnez( cbf_require_column(dictionary, "alias_id"))
+    }
 
+    if (cbf_find_hashedvalue(dictionary, categoryname, "alias_id", 
+              CBF_CASE_INSENSITIVE)) {
 
-  /* Reset reference counts for a dictionary */
-  
-int cbf_reset_refcounts( cbf_handle dictionary ) {
+        cbf_failnez( cbf_set_hashedvalue(dictionary, categoryname, "alias_id", -1))
 
-  if ( dictionary && !cbf_find_tag(dictionary,"_items.name"))  {
-  
-    cbf_failnez(cbf_reset_column(dictionary, "CBF_wide_refcounts") )
-  
-    cbf_failnez(cbf_reset_column(dictionary, "DB_wide_refcounts") )
-  
-    cbf_failnez(cbf_reset_column(dictionary, "DBcat_wide_refcounts") )
-  	
-    cbf_failnez(cbf_reset_column(dictionary, "SF_wide_refcounts") )
+    }
+    
+    cbf_failnez( cbf_row_number(dictionary, &rownum))
+            
+    cbf_failnez( cbf_set_hashedvalue(dictionary, categoryroot, "root_id", rownum))
 
-    cbf_failnez(cbf_reset_column(dictionary, "SFcat_wide_refcounts") )
-  }
-  
-  return 0;
-	
+    return 0;
 }
 
-  /* Convert a DDL1 or DDL2 dictionary and add it to a CBF dictionary */
-
+  /* Find the root alias of a given tag */
 
-int cbf_convert_dictionary (cbf_handle handle, cbf_handle dictionary )
+int cbf_find_tag_root (cbf_handle handle, const char* tagname,
+                                            const char** tagroot)
 {
-    cbf_handle dict;
-		
-    unsigned int blocks, frames, blockitems, blocknum, itemnum;
-
-    unsigned int numrows, rownum, parent_row;
+    cbf_handle dictionary;
 
-    CBF_NODETYPE itemtype;
+    if (!handle || !tagname || !tagroot ) return CBF_ARGUMENT;
 
-    const char *datablock_name;
+    dictionary = (cbf_handle) handle->dictionary;
 
-    const char *saveframe_name;
-    
-    const char *parent_name, *child_name;
-    
-    const char *type_code, *otype_code;
-    
-    char buffer[255];
+    if (!dictionary) return CBF_NOTFOUND;
 
-    if (!handle || !dictionary ) return CBF_ARGUMENT;
+    if ( cbf_find_tag(dictionary, "_item_aliases.alias_name") && cbf_find_tag(dictionary, "_aliases.definition_id"))
+      {
+        return CBF_NOTFOUND;
+      }
 
-    cbf_failnez( cbf_require_dictionary(handle, &dict))
+    cbf_failnez( cbf_find_hashedvalue(dictionary,tagname,"alias_name",
+      CBF_CASE_INSENSITIVE))
+      
+    cbf_failnez( cbf_find_column(dictionary, "root_name"))
 
-    cbf_failnez( cbf_require_datablock  (dict, "cbf_dictionary"))
-    
+    return cbf_get_value(dictionary,tagroot);
 
-    cbf_failnez( cbf_require_category   (dict, "category_aliases(hash_table)"))
-    
-      cbf_failnez( cbf_require_column   (dict, "category_root(hash_next)"))
+}
 
-      cbf_failnez( cbf_require_column   (dict, "category_alias(hash_next)"))
+  /* Find the root alias of a given tag, defaulting to the current one */
 
+int cbf_require_tag_root (cbf_handle handle, const char* tagname,
+                                            const char** tagroot)
+{
+    if (!handle || !tagname || !tagroot ) return CBF_ARGUMENT;
 
-    cbf_failnez( cbf_require_category   (dict, "category_aliases"))
+    if (cbf_find_tag_root(handle,tagname,tagroot))
+      * tagroot = tagname;
 
-      cbf_failnez( cbf_require_column   (dict, "category_root"))
+    return 0;
 
-      cbf_failnez( cbf_require_column   (dict, "category_alias"))
+}
 
-      cbf_failnez( cbf_require_column   (dict, "category_root(hash_next)"))
+  /* Set the root alias of a given tag */
 
-      cbf_failnez( cbf_require_column   (dict, "category_alias(hash_next)"))
+int cbf_set_tag_root (cbf_handle handle, const char* tagname,
+                                            const char* tagroot)
+{
+    cbf_handle dictionary;
 
+    unsigned int rownum;
 
-    cbf_failnez( cbf_require_category   (dict, "item_aliases(hash_table)"))
+    if (!handle || !tagname || !tagroot ) return CBF_ARGUMENT;
 
-      cbf_failnez( cbf_require_column   (dict, "item_root(hash_next)"))
+    cbf_failnez( cbf_require_dictionary(handle, &dictionary))
 
-      cbf_failnez( cbf_require_column   (dict, "item_alias(hash_next)"))
+    if (!dictionary) return CBF_NOTFOUND;
 
+    if (dictionary->readonly) return CBF_ARGUMENT;
 
-    cbf_failnez( cbf_require_category   (dict, "item_aliases"))
+    if ( cbf_find_tag(dictionary, "_item_aliases.alias_name")) {
 
-      cbf_failnez( cbf_require_column   (dict, "item_root"))
+        cbf_failnez( cbf_require_datablock(dictionary, "dictionary"))
 
-      cbf_failnez( cbf_require_column   (dict, "item_alias"))
+        cbf_failnez( cbf_require_category(dictionary, "item_aliases"))
 
-      cbf_failnez( cbf_require_column   (dict, "item_root(hash_next)"))
+        cbf_failnez( cbf_require_column(dictionary, "alias_name"))
+    }
 
-      cbf_failnez( cbf_require_column   (dict, "item_alias(hash_next)"))
+    if (cbf_find_hashedvalue(dictionary, tagname, "alias_name", 
+              CBF_CASE_INSENSITIVE)) {
 
+        cbf_failnez( cbf_set_hashedvalue(dictionary, tagname, "alias_name", -1))
 
-    cbf_failnez( cbf_require_category   (dict, "categories(hash_table)"))
+    }
+    
+    cbf_failnez( cbf_row_number(dictionary, &rownum))
+            
+    cbf_failnez( cbf_set_hashedvalue(dictionary, tagroot, "root_name", rownum))
 
-      cbf_failnez( cbf_require_column   (dict, "id(hash_next)"))
+    return 0;
 
+}
 
-    cbf_failnez( cbf_require_category   (dict, "categories"))
 
-      cbf_failnez( cbf_require_column   (dict, "id"))
+  /* Find the category of a given tag */
 
-      cbf_failnez( cbf_require_column   (dict, "id(hash_next)"))
+int cbf_find_tag_category (cbf_handle handle, const char* tagname,
+                                            const char** categoryname)
+{
+    cbf_handle dictionary;
 
-      cbf_failnez( cbf_require_column   (dict, "key"))
+    if (!handle || !tagname || !categoryname ) return CBF_ARGUMENT;
 
+    dictionary = (cbf_handle) handle->dictionary;
 
-    cbf_failnez( cbf_require_category   (dict, "items(hash_table)"))
+    if (!dictionary) return CBF_NOTFOUND;
 
-      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
-      
-      cbf_failnez( cbf_require_column   (dict, "category_id(hash_next)"))
+    cbf_failnez( cbf_find_tag(dictionary, "_item.name"))
 
+    cbf_failnez( cbf_rewind_row(dictionary))
 
-    cbf_failnez( cbf_require_category   (dict, "items"))
+    cbf_failnez( cbf_find_row(dictionary, tagname))
 
-      cbf_failnez( cbf_require_column   (dict, "name"))
+    cbf_failnez( cbf_find_column(dictionary, "category_id"))
 
-      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
+    return cbf_get_value(dictionary,categoryname);
 
-      cbf_failnez( cbf_require_column   (dict, "type_code"))
+}
 
-      cbf_failnez( cbf_require_column   (dict, "category_id"))
 
-      cbf_failnez( cbf_require_column   (dict, "category_id(hash_next)"))
+  /* Set category of a given tag */
 
-      cbf_failnez( cbf_require_column   (dict, "sub_category_id"))
+int cbf_set_tag_category (cbf_handle handle, const char* tagname,
+                                            const char* categoryname)
+{
+    cbf_handle dictionary;
 
-      cbf_failnez( cbf_require_column   (dict, "mandatory_code"))
+    char * tempcat;
 
-      cbf_failnez( cbf_require_column   (dict, "default_value"))
+    if (!handle || !tagname || !categoryname ) return CBF_ARGUMENT;
 
-      cbf_failnez( cbf_require_column   (dict, "parent"))
-      
-	  cbf_failnez( cbf_require_column	(dict, "method_expression"))
- 
+    cbf_failnez( cbf_require_dictionary(handle, &dictionary))
 
-    cbf_failnez( cbf_require_category   (dict, "items_enumerations(hash_table)"))
+    if (!dictionary) return CBF_NOTFOUND;
 
-      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
-   
+    if (dictionary->readonly) return CBF_ARGUMENT;
 
-    cbf_failnez( cbf_require_category   (dict, "items_enumerations"))
+    if ( cbf_find_tag(dictionary, "_item.name")) {
 
-      cbf_failnez( cbf_require_column   (dict, "name"))
+        cbf_failnez( cbf_require_datablock(dictionary, "dictionary"))
 
-      cbf_failnez( cbf_require_column   (dict, "name(hash_next)"))
-      
-      cbf_failnez( cbf_require_column   (dict, "value"))
+        cbf_failnez( cbf_require_category(dictionary, "item"))
 
-      cbf_failnez( cbf_require_column   (dict, "value_type"))
+        cbf_failnez( cbf_require_column(dictionary, "name"))
+    }
 
+    cbf_failnez( cbf_require_column(dictionary, "category_id"))
 
-      cbf_failnez (cbf_rewind_datablock (dictionary))
+    cbf_failnez( cbf_rewind_row(dictionary))
 
-      cbf_failnez (cbf_count_datablocks (dictionary, &blocks))
+    cbf_failnez( cbf_find_column(handle, "name"))
 
+    while (!cbf_find_nextrow(dictionary,tagname)) {
 
-    for (blocknum = 0; blocknum < blocks;  blocknum++ )
-    {
-      cbf_failnez (cbf_select_datablock(dictionary, blocknum))
+        cbf_failnez( cbf_require_column(dictionary, "category_id"))
 
-      cbf_failnez (cbf_datablock_name(dictionary, &datablock_name))
+        if (!cbf_get_value(dictionary,(const char **)&tempcat)) {
 
-      if ( !cbf_rewind_blockitem(dictionary, &itemtype) ) {
+          if (tempcat && !cbf_cistrcmp(tempcat,categoryname))return 0;
 
-        if (cbf_count_saveframes(dictionary, &frames) || frames == 0)
-        {
-            cbf_failnez( cbf_convert_dictionary_definition(dict, dictionary, datablock_name))
+        }
 
-        } else {
+	    if (!tempcat) return cbf_set_value(dictionary,categoryname);
 
-          cbf_failnez (cbf_count_blockitems(dictionary, &blockitems))
+        cbf_failnez( cbf_find_column(dictionary, "name"))
 
-          for (itemnum = 0; itemnum < blockitems;  itemnum++) {
+    }
 
-            cbf_select_blockitem(dictionary, itemnum, &itemtype);
+    cbf_failnez( cbf_new_row(dictionary))
 
-            if (itemtype == CBF_SAVEFRAME) {
+    cbf_failnez( cbf_set_value(dictionary,tagname))
 
-              cbf_failnez( cbf_saveframe_name(dictionary, &saveframe_name))
+    cbf_failnez( cbf_find_column(dictionary, "category_id"))
 
-              cbf_failnez( cbf_convert_dictionary_definition(dict, dictionary, saveframe_name))
+    return cbf_set_value(dictionary,categoryname);
 
-            }
+}
 
-          }
+  /* check a category for all required tags and for parent tags */
 
-        }
+int cbf_check_category_tags(cbf_handle handle, cbf_node* category, cbf_node* parent) {
 
-      }
+  int rownum;
+  
+  long refcount, parentcount;
+  
+  char buffer[512];
+  
+  const char* refcount_column, *mandatory_code, *item_name, 
+    *category_id, *parent_name, *block_name;
+  
+  if (parent->type == CBF_SAVEFRAME) refcount_column = "SF_wide_refcounts";
+  
+  else refcount_column = "DB_wide_refcounts";
+  
+  block_name = parent->name?parent->name:"(null)";
 
-    }
-    
-    /* Update unfilled-in items for children */
-    
-    if( !cbf_find_tag(dict,"_items.parent")) {
-    
-      cbf_failnez(cbf_count_rows(dict,&numrows))
+  if (handle->dictionary && category->name && category->name[0]) {
+  
+    if (getenv("CBFLIB_DEBUG")) cbf_write_file(handle->dictionary, stderr, 0, 0, 0, 0);
+  
+    if (!cbf_find_tag(handle->dictionary,"_items.name") &&   
+      !cbf_find_hashedvalue(handle->dictionary,category->name,"category_id",
+        CBF_CASE_INSENSITIVE) ) {
+        
+      cbf_failnez(cbf_row_number(handle->dictionary,(unsigned int *)&rownum))
       
-      for (rownum = 0; rownum < numrows; rownum++)  {
+      do {
       
-        cbf_failnez(cbf_find_column(dict,"parent"))
+        cbf_failnez(cbf_select_row(handle->dictionary,rownum))
+      
+       	cbf_failnez(cbf_find_column(handle->dictionary,"name"))
+        	   
+        cbf_failnez(cbf_get_value(handle->dictionary,&item_name))
         
-        if (!cbf_select_row(dict,rownum)) {
+        if (!item_name) item_name = "(null)";
         
-          if (!cbf_get_value(dict,&parent_name) && parent_name) {
+        if (!cbf_find_column(handle->dictionary,"category_id")
+          && !cbf_get_value(handle->dictionary, &category_id)
+          && category_id
+          && !cbf_cistrcmp(category_id, category->name)) {
           
-            if (!cbf_find_hashedvalue(dict, parent_name, "name", CBF_CASE_INSENSITIVE)) {
-            
-              cbf_failnez(cbf_row_number(dict,&parent_row))
-              
-              cbf_failnez(cbf_find_column(dict,"type_code"))
-              
-              if (!cbf_get_value(dict,&type_code) && type_code) {
-              
-                cbf_failnez(cbf_select_row(dict,rownum))
-                
-                if (cbf_get_value(dict,&otype_code)) otype_code = NULL;
-                
-                cbf_failnez(cbf_set_value(dict,type_code))
-                
-                if (otype_code && !cbf_cistrcmp(otype_code, type_code)) {
-                
-                  cbf_failnez(cbf_find_column(dict,"name"))
-                  
-                  if (!cbf_get_value(dict,&child_name)) {
-                  	
-                    sprintf(buffer," inconsistent data type %s for %s", otype_code, child_name);
-                    
-                  }
-                	
-                }
-              	
-              }
-            	
+          if (cbf_get_refcount(handle->dictionary, refcount_column, &refcount))
+          
+            refcount = 0;
+
+      
+          if (!cbf_find_column(handle->dictionary,"mandatory_code")
+            && !cbf_get_value(handle->dictionary, &mandatory_code)
+            && mandatory_code
+            && !cbf_cistrcmp(mandatory_code,"yes")) {
+
+            if( refcount <= 0) {
+        	   
+         	  sprintf(buffer, "required tag %s in %s not given", 
+        	    item_name, block_name);
+        	   
+        	  cbf_log(handle,buffer, CBF_LOGWARNING|CBF_LOGWOLINE);
+        	  
+        	}
+        	 	
+          }
+          
+          if (refcount > 0) {
+          
+            if (!cbf_find_column(handle->dictionary,"parent")
+              && !cbf_get_value(handle->dictionary, &parent_name)
+              && parent_name
+              && !cbf_find_hashedvalue(handle->dictionary,parent_name,"name",
+                CBF_CASE_INSENSITIVE)
+              && !cbf_get_refcount(handle->dictionary, refcount_column, &parentcount)
+              && parentcount <= 0)  {
+                      	   
+        	  sprintf(buffer, "required parent tag %s for %s in %s not given", 
+        	    parent_name?parent_name:"(null)",
+        	    item_name, block_name);
+        	   
+        	  cbf_log(handle,buffer, CBF_LOGWARNING|CBF_LOGWOLINE);
+        	          	  
+
             }
           	
           }
-        	
+          
         }
+        
+        cbf_failnez(cbf_select_row(handle->dictionary, rownum))
+        
+        cbf_failnez(cbf_find_column(handle->dictionary, "category_id(hash_next)"))
+        
+        if (cbf_get_integervalue(handle->dictionary, &rownum)) rownum = 1;
       	
-      }
-          
-    	
+      } while (rownum >= 0);
+        
     }
+  	
+  }
+  
+  return 0;
+	
+}
 
-    if (getenv("CBFLIB_DEBUG") ) cbf_failnez(cbf_write_file(dict,stderr,0,0,0,0))
-	
-    return 0;
-
-}
-
-
-  /* Find the requested tag anywhere in the cbf, make it the current column */
-
-int cbf_find_tag (cbf_handle handle, const char *tag)
-{
-  cbf_node *node;
-
-  size_t catlen, collen;
+  /* Validation plans
 
-  char categoryname[81];
+     cbf_validate checks each value against the definition of its item.
+     Finding the definition in the dictionary, comparing its type code
+     with every known type and walking its enumeration chain cost far
+     more than the checks themselves, so the first time a read meets an
+     item its definition is compiled into a plan entry, and the later
+     values of the item, usually the rest of a loop column, are checked
+     from the entry alone.  A plan is private to the handle being read
+     and lasts for one read. */
 
-  char columnname[81];
 
-  char *colstart;
+  /* Regular expressions for the DDLm content types */
 
-  if (!handle || !tag) return CBF_ARGUMENT;
+static const struct
+{
+  const char *type, *pattern;
+}
+cbf_type_patterns [] =
+{
+  { "Achar",       "^[A-Za-z]$" },
+  { "ANchar",      "^[A-Za-z0-9]$" },
+  { "Element",     "^[A-Za-z]+$" },                    /* Achar + */
+  { "Tag",         "^[_][A-Za-z0-9]+[_][._][A-Za-z0-9]+[_]$" },
+                                                       /* _ Ctag [._] Otag */
+  { "Otag",        "^[A-Za-z0-9]+[_]$" },              /* ANchar [_] + */
+  { "Ctag",        "^[A-Za-z0-9]+[_]$" },
+  { "Filename",    "^[A-Za-z0-9]+[_]$" },
+  { "Savename",    "[$][A-Za-z0-9]+[_]" },             /* $ Otag */
+  { "Date",        "^[0-9][0-9][0-9][0-9]-[0-1]?[0-9]-[0-3][0-9]$" },
+  { "Version",     "^[0-9]+[.][0-9]+[.][0-9]+$" },     /* Count [.] Count [.] Count */
+  { "Range",       "([+-]?[0-9]+)?:([+-]?[0-9]+)?" },  /* Integer ? : Integer ? */
+  { "Digit",       "^[0-9]$" },
+  { "Count",       "^[0-9]+$" },
+  { "Index",       "^[1-9]+[0-9]+" },                  /* [1-9] Digit + */
+  { "Integer",     "^[+-]?[0-9]+$" },                  /* [+-]? Count */
+  { "Binary",      "^0b[0-1]+" },
+  { "Hexadecimal", "^0x[0-9a-fA-F]+$" },
+  { "Octal",       "^0o[0-7]+$" },
+  { "Symop",       "^[0-1]?[0-9]?[0-9]_[0-9][0-9][0-9]$" },
+  { "YesorNo",     "^y(es)?$|^n(o)?$" },
+  { "Pchar",       "" },
+  { "Uri",         "" },
+  { "Text",        "" },
+  { "Code",        "" },
+  { "Dimension",   "" },
+  { "Float",       "^-?(([0-9]+)|([0-9]*[.][0-9]+))([(][0-9]+[)])?([eEdDqQ][+-]?[0-9]+)?" },
+  { "Real",        "^-?(([0-9]+)|([0-9]*[.][0-9]+))([(][0-9]+[)])?([eEdDqQ][+-]?[0-9]+)?" },
+  { "Imag",        "^-?((([0-9]+)|([0-9]*[.][0-9]+))([(][0-9]+[)])?([eEdDqQ][+-]?[0-9]+)?)?[iIjJ]" },
+                                                       /* Real [jJ] */
+  { "Label",       "" },
+  { "Formula",     "" }
+};
+
+#define CBF_TYPE_PATTERNS (sizeof (cbf_type_patterns) / sizeof (cbf_type_patterns [0]))
+
+
+  /* How a value of one token class is matched to its type */
+
+#define CBF_MATCH_TEST    0   /* Test the contents                  */
+#define CBF_MATCH_ANY     1   /* Any value matches                  */
+#define CBF_MATCH_UCHAR3  2   /* Three characters, optionally + one */
+#define CBF_MATCH_UCHAR1  3   /* One character, optionally + one    */
+#define CBF_MATCH_SYMOP   4   /* A symmetry operation n_klm         */
+#define CBF_MATCH_DATE    5   /* yyyy-mm-dd[Thh:mm:ss.ff][+-zz]     */
+
+
+  /* One compiled item definition */
+
+typedef struct
+{
+  char name [82];                 /* The item name probed             */
 
-  if (strlen(tag)>80) return CBF_ARGUMENT;
+  const char *type;               /* type_code, NULL if not defined   */
 
-  if (tag[0] == '_') tag++;
+  int row;                        /* Row of the definition            */
 
-  if (!(colstart = strchr(tag,'.'))) {
+  int word, quoted, text;         /* Matchers for each token class    */
 
-    colstart=(char *)tag-1;
+  int integer, real, number;      /* Numeric tests                    */
 
-    catlen = 0;
+  int pattern;                    /* DDLm content pattern or -1       */
 
-  } else {
+  int binary;
 
-    catlen = colstart-tag;
+  const char *expression;         /* method_expression or NULL        */
 
-  }
-  if (catlen) memcpy(categoryname,tag,catlen);
+  size_t enumeration, enumerations;    /* Slice of the enumerations   */
 
-  categoryname[catlen] = '\0';
+  int next;                       /* Next item with the same hash     */
+}
+cbf_plan_item;
 
-  collen = (tag+strlen(tag))-colstart;
 
-  columnname[0] = '_';
+  /* One enumerated value or range */
 
-  if (collen) memcpy(columnname+(catlen?0:1),colstart+1,collen);
+typedef struct
+{
+  const char *type, *value;
 
-  columnname[collen+(catlen?0:1)] = '\0';
+  double number;                  /* The value converted with strtod  */
+}
+cbf_plan_enumeration;
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT))
 
-  cbf_failnez(cbf_srch_tag(handle, node, categoryname, columnname))
+struct cbf_validation_plan_struct
+{
+  cbf_handle dictionary;          /* The dictionary compiled          */
 
-  return 0;
+  int hash [256];                 /* First item for each hash code    */
 
-}
+  cbf_plan_item *item;
 
-  /* Find the requested tag in the cbf within the current
+  size_t items, items_size;
 
-     save frame or data block, make it the current column */
+  cbf_plan_enumeration *enumeration;
 
-int cbf_find_local_tag (cbf_handle handle, const char *tag)
-{
-  cbf_node *node;
+  size_t enumerations, enumerations_size;
 
-  size_t catlen, collen;
+#if !defined(CBF_NO_REGEX)
 
-  char categoryname[81];
+  regex_t pattern [CBF_TYPE_PATTERNS];
 
-  char columnname[81];
+  signed char compiled [CBF_TYPE_PATTERNS];   /* 1 compiled, -1 failed */
 
-  char *colstart;
+#endif
+};
 
-  if (!handle || !tag) return CBF_ARGUMENT;
 
-  if (strlen(tag)>80) return CBF_ARGUMENT;
+  /* Free the validation plan of a handle */
 
-  if (tag[0] == '_') tag++;
+static int cbf_free_validation_plan (cbf_handle handle)
+{
+  cbf_validation_plan *plan;
 
-  if (!(colstart = strchr(tag,'.'))) {
+  int errorcode;
 
-    colstart=(char *)tag-1;
+#if !defined(CBF_NO_REGEX)
 
-    catlen = 0;
+  size_t pattern;
 
-  } else {
+#endif
 
-    catlen = colstart-tag;
+  plan = handle->validation;
 
-  }
-  if (catlen) memcpy(categoryname,tag,catlen);
+  if (!plan)
 
-  categoryname[catlen] = '\0';
+    return 0;
 
-  collen = (tag+strlen(tag))-colstart;
-  
-  columnname[0] = '_';
+#if !defined(CBF_NO_REGEX)
 
-  if (collen) memcpy(columnname+(catlen?0:1),colstart+1,collen);
+  for (pattern = 0; pattern < CBF_TYPE_PATTERNS; pattern++)
 
-  columnname[collen+(catlen?0:1)] = '\0';
+    if (plan->compiled [pattern] > 0)
 
-  if (cbf_find_parent (&node, handle->node, CBF_SAVEFRAME))
-  {
+      regfree (&plan->pattern [pattern]);
 
-  cbf_failnez (cbf_find_parent (&node, handle->node, CBF_DATABLOCK))
+#endif
 
-  }
+  errorcode = cbf_free ((void **) &plan->item, &plan->items_size);
 
-  cbf_failnez(cbf_srch_tag(handle, node, categoryname, columnname))
+  errorcode |= cbf_free ((void **) &plan->enumeration,
+                                   &plan->enumerations_size);
 
-  return 0;
+  handle->validation = NULL;
 
+  return errorcode | cbf_free ((void **) &plan, NULL);
 }
 
 
-  /* Find the requested category and column anywhere in the cbf, make it the current column */
-
+  /* Choose the matcher for a type and a token class */
 
-int cbf_srch_tag (cbf_handle handle, cbf_node *node,
-                                     const char *categoryname,
-                                     const char *columnname)
+static int cbf_plan_word_matcher (const char *type)
 {
-  unsigned int children, child;
+  if (!cbf_cistrncmp(type,"implied",8))
 
-  if (!node) return CBF_NOTFOUND;
+    return CBF_MATCH_ANY;
 
-  node = cbf_get_link(node);
+  if (!cbf_cistrncmp(type,"uchar3",7))
 
-  if (node->type == CBF_CATEGORY) {
+    return CBF_MATCH_UCHAR3;
 
-    if (((!(node->name) || (node->name[0] == '_')) &&(categoryname[0]=='\0'))
-       || ((node->name)&&!cbf_cistrcmp(node->name,categoryname))) {
+  if (!cbf_cistrncmp(type,"uchar1",7))
 
-      cbf_failnez (cbf_find_child(&node,node,columnname))
+    return CBF_MATCH_UCHAR1;
 
-      handle->node = node;
-      
-      handle->row = 0;
+  if (!cbf_cistrncmp(type,"symo",4))
 
-      handle->search_row = 0;
+    return CBF_MATCH_SYMOP;
 
-      return 0;
+  if (!cbf_cistrncmp(type,"yyyy-",5) || !cbf_cistrncmp(type,"date",4))
 
-    } else {
+    return CBF_MATCH_DATE;
 
-      return CBF_NOTFOUND;
+  if ( !cbf_cistrncmp(type,"char",4)
+    || !cbf_cistrncmp(type,"ucha",4)
+    || !cbf_cistrncmp(type,"code",4)
+    || !cbf_cistrncmp(type,"name",4)
+    || !cbf_cistrncmp(type,"idna",4)
+    || !cbf_cistrncmp(type,"alia",4)
+    || !cbf_cistrncmp(type,"ucod",4)
+    || !cbf_cistrncmp(type,"line",4)
+    || !cbf_cistrncmp(type,"ulin",4)
+    || !cbf_cistrncmp(type,"any", 3)
+    || !cbf_cistrncmp(type,"atco",4)
+    || !cbf_cistrncmp(type,"phon",4)
+    || !cbf_cistrncmp(type,"emai",4)
+    || !cbf_cistrncmp(type,"fax", 3)
+    || !cbf_cistrncmp(type,"text",4)
+    || !cbf_cistrncmp(type,"tag",3)
+    || !cbf_cistrncmp(type,"ctag",4)
+    || !cbf_cistrncmp(type,"otag",4) )
 
-    }
-  }
+    return CBF_MATCH_ANY;
 
-  children = node->children;
+  return CBF_MATCH_TEST;
+}
 
-  for (child = 0; child < children; child++) {
+static int cbf_plan_quoted_matcher (const char *type)
+{
+  if ( !cbf_cistrncmp(type,"implied",8)
+    || !cbf_cistrncmp(type,"text",4)
+    || !cbf_cistrncmp(type,"any",3)
+    || !cbf_cistrncmp(type,"line",4)
+    || !cbf_cistrncmp(type,"ulin",4)
+    || !cbf_cistrncmp(type,"name",4)
+    || !cbf_cistrncmp(type,"idna",4)
+    || !cbf_cistrncmp(type,"alia",4)
+    || !cbf_cistrncmp(type,"atco",4)
+    || !cbf_cistrncmp(type,"char",4)
+    || !cbf_cistrncmp(type,"ucha",4) )
 
-    if(! cbf_srch_tag(handle, (node->child)[child],
-      categoryname, columnname)) return 0;
+    return CBF_MATCH_ANY;
 
-  }
+  return CBF_MATCH_TEST;
+}
 
-  return CBF_NOTFOUND;
+static int cbf_plan_text_matcher (const char *type)
+{
+  if ( !cbf_cistrncmp(type,"implied",8)
+    || !cbf_cistrncmp(type,"text",4)
+    || !cbf_cistrncmp(type,"any",3)
+    || !cbf_cistrncmp(type,"char",4)
+    || !cbf_cistrncmp(type,"ucha",4) )
 
+    return CBF_MATCH_ANY;
+
+  return CBF_MATCH_TEST;
 }
 
-  /* Find the root alias of a given category */
 
-int cbf_find_category_root (cbf_handle handle, const char* categoryname,
-                                            const char** categoryroot)
+  /* Compile the definition of an item */
+
+static int cbf_compile_plan_item (cbf_validation_plan *plan,
+                                  cbf_plan_item *item,
+                                  const char *itemname)
 {
-    cbf_handle dictionary;
-    
-    const char * tempcatname;
+  cbf_handle dictionary;
 
-    if (!handle || !categoryname || !categoryroot ) return CBF_ARGUMENT;
+  const char *dictype, *nextitem, *enumvalue, *enumvaluetype, *expression;
 
-    dictionary = (cbf_handle) handle->dictionary;
+  unsigned int row;
 
-    if (!dictionary) return CBF_NOTFOUND;
-    
-    if (categoryname[0] == '_') {
-    
-      if (!cbf_find_tag(dictionary,"_items.name") 
-        && !cbf_find_hashedvalue(dictionary,categoryname,"name",CBF_CASE_INSENSITIVE)
-        && !cbf_find_column(dictionary,"category_id")
-        && !cbf_get_value(dictionary,&tempcatname)
-        && tempcatname)  categoryname = tempcatname;
-        
-        else return CBF_NOTFOUND;
-    	
-    }
+  int nextrow;
 
-    cbf_failnez( cbf_find_tag(dictionary, "_category_aliases.alias_id"))
+  size_t pattern;
 
-    cbf_failnez( cbf_rewind_row(dictionary))
+  cbf_plan_enumeration *enumeration;
 
-    cbf_failnez( cbf_find_hashedvalue(dictionary, categoryname,"alias_id",CBF_CASE_INSENSITIVE))
+  dictionary = plan->dictionary;
 
-    cbf_failnez( cbf_find_column(dictionary, "root_id"))
+  item->type = NULL;
 
-    return cbf_get_value(dictionary,categoryroot);
+  item->expression = NULL;
 
-}
+  item->enumeration = plan->enumerations;
 
-  /* Find the root alias of a given category, defaulting to the current one */
+  item->enumerations = 0;
 
-int cbf_require_category_root (cbf_handle handle, const char* categoryname,
-                                            const char** categoryroot)
-{
-    cbf_handle dictionary;
-        
-    const char * tempcatname;
+  if ((cbf_find_tag(dictionary, "_items.name")
+    && cbf_find_tag(dictionary, "_definition.id"))
+    || cbf_find_hashedvalue(dictionary, itemname, "name", CBF_CASE_INSENSITIVE))
 
-    if (!handle || !categoryname || !categoryroot ) return CBF_ARGUMENT;
+    return 0;
 
-    dictionary = (cbf_handle) handle->dictionary;
+  cbf_failnez (cbf_row_number (dictionary, &row))
 
-    if (categoryname[0] == '_') {
-    
-      if (!cbf_find_tag(dictionary,"_items.name") 
-        && !cbf_find_hashedvalue(dictionary,categoryname,"name",CBF_CASE_INSENSITIVE)
-        && !cbf_find_column(dictionary,"category_id")
-        && !cbf_get_value(dictionary,&tempcatname)
-        && tempcatname)  categoryname = tempcatname;
-        
-      else {
-        
-        * categoryroot = categoryname;
-          
-        return 0;
-        	
-      }
-    	
-    }
+  if (cbf_find_column(dictionary, "type_code")
+    || cbf_get_value(dictionary, &dictype) || !dictype)
 
-    if (cbf_find_category_root(handle,categoryname,categoryroot))
+    return 0;
 
-      * categoryroot = categoryname;
+  item->type = dictype;
 
-    return 0;
+  item->row = (int) row;
 
-}
+  item->word = cbf_plan_word_matcher (dictype);
 
-  /* Set the root alias of a given category */
+  item->quoted = cbf_plan_quoted_matcher (dictype);
 
-int cbf_set_category_root (cbf_handle handle, const char* categoryname,
-                                            const char* categoryroot)
-{
-    cbf_handle dictionary;
+  item->text = cbf_plan_text_matcher (dictype);
 
-    unsigned int rownum;
+  item->integer = cbf_cistrncmp(dictype,"numb",4)
+               || cbf_cistrncmp(dictype,"int",3)
+               || cbf_cistrncmp(dictype,"floa",4);
 
-    if (!handle || !categoryname || !categoryroot ) return CBF_ARGUMENT;
+  item->real = !cbf_cistrncmp(dictype,"numb",4)
+            || !cbf_cistrncmp(dictype,"floa",4);
 
-    cbf_failnez( cbf_require_dictionary(handle, &dictionary))
+    /* Only a numeric type compares values with enumerations as numbers:
+       otherwise every word would match every word, both being 0 */
 
-    if (!dictionary) return CBF_NOTFOUND;
+  item->number = !cbf_cistrncmp(dictype,"numb",4)
+              || !cbf_cistrncmp(dictype,"int",3)
+              || !cbf_cistrncmp(dictype,"floa",4)
+              || !cbf_cistrncmp(dictype,"real",4);
 
-    if ( cbf_find_tag(dictionary, "_category_aliases.alias_id")) {
+  item->binary = !cbf_cistrcmp(dictype,"binary");
 
-        cbf_failnez( cbf_require_datablock(dictionary, "dictionary"))
+  item->pattern = -1;
 
-        cbf_failnez( cbf_require_category(dictionary, "category_aliases"))
+  for (pattern = 0; pattern < CBF_TYPE_PATTERNS; pattern++)
 
-        cbf_failnez( cbf_require_column(dictionary, "alias_id"))
-    }
+    if (!cbf_cistrcmp(dictype, cbf_type_patterns [pattern].type)) {
 
-    if (cbf_find_hashedvalue(dictionary, categoryname, "alias_id", 
-              CBF_CASE_INSENSITIVE)) {
+      item->pattern = (int) pattern;
 
-        cbf_failnez( cbf_set_hashedvalue(dictionary, categoryname, "alias_id", -1))
+      break;
 
     }
-    
-    cbf_failnez( cbf_row_number(dictionary, &rownum))
-            
-    cbf_failnez( cbf_set_hashedvalue(dictionary, categoryroot, "root_id", rownum))
 
-    return 0;
-}
 
-  /* Find the root alias of a given tag */
+    /* The method used to generate a missing value */
 
-int cbf_find_tag_root (cbf_handle handle, const char* tagname,
-                                            const char** tagroot)
-{
-    cbf_handle dictionary;
+  if (!cbf_find_tag(dictionary, "_items.method_expression")
+    && !cbf_select_row(dictionary, row)
+    && !cbf_find_column(dictionary, "name")
+    && !cbf_get_value(dictionary, &nextitem)
+    && nextitem && !cbf_cistrcmp(nextitem, itemname)
+    && !cbf_find_column(dictionary, "method_expression")
+    && !cbf_get_value(dictionary, &expression))
 
-    if (!handle || !tagname || !tagroot ) return CBF_ARGUMENT;
+    item->expression = expression;
 
-    dictionary = (cbf_handle) handle->dictionary;
 
-    if (!dictionary) return CBF_NOTFOUND;
+    /* The enumerated values and ranges, in the order of the chain */
 
-    if ( cbf_find_tag(dictionary, "_item_aliases.alias_name") && cbf_find_tag(dictionary, "_aliases.definition_id"))
-      {
-        return CBF_NOTFOUND;
-      }
+  if (cbf_find_tag(dictionary,"_items_enumerations.name")
+    || cbf_find_hashedvalue(dictionary,itemname,"name", CBF_CASE_INSENSITIVE))
 
-    cbf_failnez( cbf_find_hashedvalue(dictionary,tagname,"alias_name",
-      CBF_CASE_INSENSITIVE))
-      
-    cbf_failnez( cbf_find_column(dictionary, "root_name"))
+    return 0;
 
-    return cbf_get_value(dictionary,tagroot);
+  cbf_failnez (cbf_row_number (dictionary, (unsigned int *) &nextrow))
 
-}
+  while ( nextrow >=0 ) {
 
-  /* Find the root alias of a given tag, defaulting to the current one */
+    cbf_failnez( cbf_find_column (dictionary, "name"))
 
-int cbf_require_tag_root (cbf_handle handle, const char* tagname,
-                                            const char** tagroot)
-{
-    if (!handle || !tagname || !tagroot ) return CBF_ARGUMENT;
+    cbf_failnez( cbf_select_row (dictionary, nextrow))
 
-    if (cbf_find_tag_root(handle,tagname,tagroot))
-      * tagroot = tagname;
+    cbf_failnez( cbf_get_value (dictionary, &nextitem))
 
-    return 0;
+    cbf_failnez( cbf_find_column (dictionary, "name(hash_next)"))
 
-}
+    cbf_failnez( cbf_get_integervalue(dictionary, &nextrow))
 
-  /* Set the root alias of a given tag */
+    if (nextitem && !cbf_cistrcmp(nextitem, itemname)) {
 
-int cbf_set_tag_root (cbf_handle handle, const char* tagname,
-                                            const char* tagroot)
-{
-    cbf_handle dictionary;
+      cbf_failnez( cbf_find_column (dictionary, "value_type"))
 
-    unsigned int rownum;
+      cbf_failnez( cbf_get_value (dictionary, &enumvaluetype))
 
-    if (!handle || !tagname || !tagroot ) return CBF_ARGUMENT;
+      cbf_failnez( cbf_find_column (dictionary, "value"))
 
-    cbf_failnez( cbf_require_dictionary(handle, &dictionary))
+      cbf_failnez( cbf_get_value (dictionary, &enumvalue))
 
-    if (!dictionary) return CBF_NOTFOUND;
+      if (!enumvaluetype || !enumvalue)
 
-    if ( cbf_find_tag(dictionary, "_item_aliases.alias_name")) {
+        continue;
 
-        cbf_failnez( cbf_require_datablock(dictionary, "dictionary"))
+      if (plan->enumerations >= plan->enumerations_size)
 
-        cbf_failnez( cbf_require_category(dictionary, "item_aliases"))
+        cbf_failnez (cbf_realloc ((void **) &plan->enumeration,
+                                            &plan->enumerations_size,
+                                  sizeof (cbf_plan_enumeration),
+                                  plan->enumerations_size * 2 + 16))
 
-        cbf_failnez( cbf_require_column(dictionary, "alias_name"))
-    }
+      enumeration = plan->enumeration + plan->enumerations++;
 
-    if (cbf_find_hashedvalue(dictionary, tagname, "alias_name", 
-              CBF_CASE_INSENSITIVE)) {
+      enumeration->type = enumvaluetype;
 
-        cbf_failnez( cbf_set_hashedvalue(dictionary, tagname, "alias_name", -1))
+      enumeration->value = enumvalue;
+
+      enumeration->number = strtod (enumvalue, NULL);
+
+      item->enumerations++;
 
     }
-    
-    cbf_failnez( cbf_row_number(dictionary, &rownum))
-            
-    cbf_failnez( cbf_set_hashedvalue(dictionary, tagroot, "root_name", rownum))
 
-    return 0;
+  }
 
+  return 0;
 }
 
 
-  /* Find the category of a given tag */
+  /* Find the plan entry for an item, compiling it the first time */
+
+static int cbf_find_plan_item (cbf_handle handle, const char *itemname,
+                                                  cbf_plan_item **item)
+{
+  cbf_validation_plan *plan;
+
+  unsigned int hashcode;
+
+  int index, errorcode;
+
+  plan = handle->validation;
+
+  if (plan && plan->dictionary != handle->dictionary) {
+
+    cbf_failnez (cbf_free_validation_plan (handle))
+
+    plan = NULL;
+
+  }
+
+  if (!plan) {
+
+    cbf_failnez (cbf_alloc ((void **) &plan, NULL,
+                            sizeof (cbf_validation_plan), 1))
 
-int cbf_find_tag_category (cbf_handle handle, const char* tagname,
-                                            const char** categoryname)
-{
-    cbf_handle dictionary;
+    plan->dictionary = handle->dictionary;
 
-    if (!handle || !tagname || !categoryname ) return CBF_ARGUMENT;
+    for (index = 0; index < 256; index++)
 
-    dictionary = (cbf_handle) handle->dictionary;
+      plan->hash [index] = -1;
 
-    if (!dictionary) return CBF_NOTFOUND;
+    plan->item = NULL;
 
-    cbf_failnez( cbf_find_tag(dictionary, "_item.name"))
+    plan->items = plan->items_size = 0;
 
-    cbf_failnez( cbf_rewind_row(dictionary))
+    plan->enumeration = NULL;
 
-    cbf_failnez( cbf_find_row(dictionary, tagname))
+    plan->enumerations = plan->enumerations_size = 0;
 
-    cbf_failnez( cbf_find_column(dictionary, "category_id"))
+#if !defined(CBF_NO_REGEX)
 
-    return cbf_get_value(dictionary,categoryname);
+    memset (plan->compiled, 0, sizeof (plan->compiled));
 
-}
+#endif
 
+    handle->validation = plan;
 
-  /* Set category of a given tag */
+  }
 
-int cbf_set_tag_category (cbf_handle handle, const char* tagname,
-                                            const char* categoryname)
-{
-    cbf_handle dictionary;
+  cbf_failnez (cbf_compute_hashcode (itemname, &hashcode))
 
-    char * tempcat;
+  for (index = plan->hash [hashcode]; index >= 0;
+                                      index = plan->item [index].next)
 
-    if (!handle || !tagname || !categoryname ) return CBF_ARGUMENT;
+    if (!cbf_cistrcmp (plan->item [index].name, itemname)) {
 
-    cbf_failnez( cbf_require_dictionary(handle, &dictionary))
+      *item = plan->item + index;
 
-    if (!dictionary) return CBF_NOTFOUND;
+      return 0;
 
-    if ( cbf_find_tag(dictionary, "_item.name")) {
+    }
 
-        cbf_failnez( cbf_require_datablock(dictionary, "dictionary"))
+  if (plan->items >= plan->items_size)
 
-        cbf_failnez( cbf_require_category(dictionary, "item"))
+    cbf_failnez (cbf_realloc ((void **) &plan->item, &plan->items_size,
+                              sizeof (cbf_plan_item),
+                              plan->items_size * 2 + 64))
 
-        cbf_failnez( cbf_require_column(dictionary, "name"))
-    }
+  index = (int) plan->items;
 
-    cbf_failnez( cbf_require_column(dictionary, "category_id"))
+  *item = plan->item + index;
 
-    cbf_failnez( cbf_rewind_row(dictionary))
+  strncpy ((*item)->name, itemname, 81);
 
-    cbf_failnez( cbf_find_column(handle, "name"))
+  (*item)->name [81] = '\0';
 
-    while (!cbf_find_nextrow(dictionary,tagname)) {
+  errorcode = cbf_compile_plan_item (plan, *item, itemname);
 
-        cbf_failnez( cbf_require_column(dictionary, "category_id"))
+  if (errorcode)
 
-        if (!cbf_get_value(dictionary,(const char **)&tempcat)) {
+    return errorcode;
 
-          if (tempcat && !cbf_cistrcmp(tempcat,categoryname))return 0;
+  (*item)->next = plan->hash [hashcode];
 
-        }
+  plan->hash [hashcode] = index;
 
-	    if (!tempcat) return cbf_set_value(dictionary,categoryname);
+  plan->items++;
 
-        cbf_failnez( cbf_find_column(dictionary, "name"))
+  return 0;
+}
 
-    }
 
-    cbf_failnez( cbf_new_row(dictionary))
+  /* Check the contents of a value against the DDLm pattern of its type.
+     Returns 0 for a match, as cbf_check_type_contents does */
 
-    cbf_failnez( cbf_set_value(dictionary,tagname))
+static int cbf_plan_check_contents (cbf_validation_plan *plan,
+                                    cbf_plan_item *item, const char *value)
+{
+#if defined(CBF_NO_REGEX)
 
-    cbf_failnez( cbf_find_column(dictionary, "category_id"))
+  return cbf_check_type_contents (item->type, value);
 
-    return cbf_set_value(dictionary,categoryname);
+#else
 
-}
+  if (item->pattern < 0)
 
-  /* check a category for all required tags and for parent tags */
+    return 1;
 
-int cbf_check_category_tags(cbf_handle handle, cbf_node* category, cbf_node* parent) {
+  if (!plan->compiled [item->pattern])
 
-  int rownum;
-  
-  long refcount;
-  
-  char *endptr;
-  
-  char buffer[512];
-  
-  const char* refcount_column, *mandatory_code, *item_name, 
-    *category_id, *parent_name, *refcountval, *block_name;
-  
-  if (parent->type == CBF_SAVEFRAME) refcount_column = "SF_wide_refcounts";
-  
-  else refcount_column = "DB_wide_refcounts";
-  
-  block_name = parent->name?parent->name:"(null)";
+    plan->compiled [item->pattern] =
+        regcomp (&plan->pattern [item->pattern],
+                 cbf_type_patterns [item->pattern].pattern,
+                 REG_EXTENDED|REG_NOSUB) ? -1 : 1;
 
-  if (handle->dictionary && category->name && category->name[0]) {
-  
-    if (getenv("CBFLIB_DEBUG")) cbf_write_file(handle->dictionary, stderr, 0, 0, 0, 0);
-  
-    if (!cbf_find_tag(handle->dictionary,"_items.name") &&   
-      !cbf_find_hashedvalue(handle->dictionary,category->name,"category_id",
-        CBF_CASE_INSENSITIVE) ) {
-        
-      cbf_failnez(cbf_row_number(handle->dictionary,(unsigned int *)&rownum))
-      
-      do {
-      
-        cbf_failnez(cbf_select_row(handle->dictionary,rownum))
-      
-       	cbf_failnez(cbf_find_column(handle->dictionary,"name"))
-        	   
-        cbf_failnez(cbf_get_value(handle->dictionary,&item_name))
-        
-        if (!item_name) item_name = "(null)";
-        
-        if (!cbf_find_column(handle->dictionary,"category_id")
-          && !cbf_get_value(handle->dictionary, &category_id)
-          && category_id
-          && !cbf_cistrcmp(category_id, category->name)) {
-          
-          refcount = 0;
-          
-          if(!cbf_find_column(handle->dictionary,refcount_column)
-        	&& !cbf_get_value(handle->dictionary, &refcountval)
-        	&& refcountval)  {
-          	
-            refcount = strtol(refcountval,&endptr,10);
-         
-          }
+  if (plan->compiled [item->pattern] < 0)
 
-      
-          if (!cbf_find_column(handle->dictionary,"mandatory_code")
-            && !cbf_get_value(handle->dictionary, &mandatory_code)
-            && mandatory_code
-            && !cbf_cistrcmp(mandatory_code,"yes")) {
+    return 1;
 
-            if( refcount <= 0) {
-        	   
-         	  sprintf(buffer, "required tag %s in %s not given", 
-        	    item_name, block_name);
-        	   
-        	  cbf_log(handle,buffer, CBF_LOGWARNING|CBF_LOGWOLINE);
-        	  
-        	}
-        	 	
-          }
-          
-          if (refcount > 0) {
-          
-            if (!cbf_find_column(handle->dictionary,"parent")
-              && !cbf_get_value(handle->dictionary, &parent_name)
-              && parent_name
-              && !cbf_find_hashedvalue(handle->dictionary,parent_name,"name",
-                CBF_CASE_INSENSITIVE)
-              && !cbf_find_column(handle->dictionary,refcount_column)
-              && (cbf_get_value(handle->dictionary, &refcountval)
-        	      || !refcountval || strtol(refcountval,&endptr,10) <=0))  {
-                      	   
-        	  sprintf(buffer, "required parent tag %s for %s in %s not given", 
-        	    parent_name?parent_name:"(null)",
-        	    item_name, block_name);
-        	   
-        	  cbf_log(handle,buffer, CBF_LOGWARNING|CBF_LOGWOLINE);
-        	          	  
+  return regexec (&plan->pattern [item->pattern], value,
+                                  (size_t) 0, NULL, 0) != 0;
 
-            }
-          	
-          }
-          
-        }
-        
-        cbf_failnez(cbf_select_row(handle->dictionary, rownum))
-        
-        cbf_failnez(cbf_find_column(handle->dictionary, "category_id(hash_next)"))
-        
-        if (cbf_get_integervalue(handle->dictionary, &rownum)) rownum = 1;
-      	
-      } while (rownum >= 0);
-        
-    }
-  	
-  }
-  
-  return 0;
-	
+#endif
 }
 
+
   /* Validate portion of CBF */
  
 int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_node * auxnode) {
@@ -6917,7 +9866,9 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
    
      if (columns == 0) cbf_log(handle,"function definition is missing",CBF_LOGWARNING|CBF_LOGSTARTLOC);
      
-     else {
+       /* Declarations are not recorded in a shared dictionary */
+
+     else if (!handle->dictionary || !handle->dictionary->readonly) {
         char location[255];
 
 		cbf_find_child (&node, node, catname);
@@ -7268,6 +10219,8 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     
     long yyyy, mm, dd, hr, mi, se, sf, tz;
 
+    cbf_plan_item *item;
+
     CBF_UNUSED(dtest);
 
     CBF_UNUSED(ltest);
@@ -7283,15 +10236,13 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     if (handle->dictionary && (tnode = cbf_get_link(auxnode)) && (tnode->name) ){
     
         if (!cbf_compose_itemname(handle, tnode, itemname, 80)) {
-    
-          if (!cbf_find_tag(handle->dictionary, "_items.name") || !cbf_find_tag(handle->dictionary, "_definition.id")) {
-   	            	     
 
-    	    if (!cbf_find_hashedvalue(handle->dictionary, itemname, 
-    	      "name",CBF_CASE_INSENSITIVE)) {
-    	
-    	      if (!cbf_find_column(handle->dictionary, "type_code") &&
-    	        !cbf_get_value(handle->dictionary, &dictype)) {
+          cbf_failnez(cbf_find_plan_item(handle, itemname, &item))
+
+    	      if (item->type) {
+
+    	        dictype = item->type;
+
     	        	
 					goodmatch = 0;
     	       	                      
@@ -7364,7 +10315,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     	        	  
     	        	case CBF_TOKEN_WORD:
     	        	
-    	        	    if ( !cbf_cistrncmp(dictype,"implied",8) ) {
+    	        	  if ( item->word == CBF_MATCH_ANY ) {
     	        	  
     	        	    goodmatch = 1;
     	        	    
@@ -7372,7 +10323,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     	        	  	
     	        	  }
  
-     	        	  if ( !cbf_cistrncmp(dictype,"uchar3",7) )
+     	        	  if ( item->word == CBF_MATCH_UCHAR3 )
      	        	  {
      	        	  	if (strlen(valuestring)==3 
      	        	  	  || (strlen(valuestring)==4 && *(valuestring)=='+'))
@@ -7384,7 +10335,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
      	        	  }
 
 
-     	        	  if ( !cbf_cistrncmp(dictype,"uchar1",7) ) {
+     	        	  if ( item->word == CBF_MATCH_UCHAR1 ) {
      	        	  	if (strlen(valuestring)==1 
      	        	  	  || (strlen(valuestring)==2 && *(valuestring)=='+'))
      	        	  	  
@@ -7394,7 +10345,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
      	        	  	
      	        	  }
 
-     	        	  if ( !cbf_cistrncmp(dictype,"symo",4) ) {
+     	        	  if ( item->word == CBF_MATCH_SYMOP ) {
      	        	         	        	    
      	        	    symop = strtol(valuestring, &endptr, 10);
      	        	    
@@ -7413,8 +10364,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
      	        	    break;
      	        	  }
      	        	    
-     	        	  if( !cbf_cistrncmp(dictype,"yyyy-",5) ||
-     	        	      !cbf_cistrncmp(dictype,"date",4) )  {
+     	        	  if ( item->word == CBF_MATCH_DATE )  {
      	        	  
      	        	    mm=-1, dd=-1, hr=0, mi =0, se=0, sf=0, tz = 0;
      	        	       	        	    
@@ -7450,28 +10400,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
      	        	  	break;
      	        	  }
     	        	
-    	        	  if ( !cbf_cistrncmp(dictype,"char",4)
-    	        	    || !cbf_cistrncmp(dictype,"ucha",4)
-    	        	    || !cbf_cistrncmp(dictype,"code",4)
-    	        	    || !cbf_cistrncmp(dictype,"name",4)
-    	        	    || !cbf_cistrncmp(dictype,"idna",4)
-    	        	    || !cbf_cistrncmp(dictype,"alia",4)
-    	        	    || !cbf_cistrncmp(dictype,"ucod",4)
-    	        	    || !cbf_cistrncmp(dictype,"line",4)
-    	        	    || !cbf_cistrncmp(dictype,"ulin",4)
-    	        	    || !cbf_cistrncmp(dictype,"any", 3)
-    	        	    || !cbf_cistrncmp(dictype,"atco",4)
-    	        	    || !cbf_cistrncmp(dictype,"phon",4)
-    	        	    || !cbf_cistrncmp(dictype,"emai",4)
-    	        	    || !cbf_cistrncmp(dictype,"fax", 3)
-    	        	    || !cbf_cistrncmp(dictype,"text",4) 
-    	        	    || !cbf_cistrncmp(dictype,"tag",3) 
-    	        	    || !cbf_cistrncmp(dictype,"ctag",4) 
-    	        	    || !cbf_cistrncmp(dictype,"otag",4) )  {
-    	        	  	
-    	        	    goodmatch = 1; break;
-    	        	  	
-    	        	  }
+
 					  /*Check if valuestring is a function call*/
     	        	  if (!cbf_cistrncmp(valuestring,"::",2)) {
 	
@@ -7487,9 +10416,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
 						cbf_log(handle,buffer,CBF_LOGWARNING|CBF_LOGSTARTLOC);
 					}
 
-    	        	  if ( cbf_cistrncmp(dictype,"numb",4)
-    	        	    || cbf_cistrncmp(dictype,"int",3)
-    	        	    || cbf_cistrncmp(dictype,"floa",4)) {
+    	        	  if ( item->integer ) {
     	        	        	        	    
     	        	    ltest = strtol(valuestring, &endptr, 10);
 
@@ -7504,8 +10431,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     	        	    
     	        	    }
     	        	    
-    	        	    if ( !cbf_cistrncmp(dictype,"numb",4)
-    	        	      || !cbf_cistrncmp(dictype,"floa",4)) {
+    	        	    if ( item->real ) {
     	        	      
     	        	      dtest = strtod(valuestring, &endptr);
     	        	      
@@ -7531,51 +10457,24 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     	        	case CBF_TOKEN_SQSTRING:
     	        	case CBF_TOKEN_DQSTRING:
     	        	
-    	        if ( !cbf_cistrncmp(dictype,"implied",8) ) {
-    	        	  
-    	        	    goodmatch = 1;
-    	        	    
-    	        	    break;
-    	        	  	
-    	        	  }
-
-    	        	  if(!cbf_cistrncmp(dictype,"text",4) 
-    	        	    || !cbf_cistrncmp(dictype,"any",3)
-    	        	    || !cbf_cistrncmp(dictype,"line",4)
-    	        	    || !cbf_cistrncmp(dictype,"ulin",4)
-    	        	    || !cbf_cistrncmp(dictype,"name",4)
-    	        	    || !cbf_cistrncmp(dictype,"idna",4)
-    	        	    || !cbf_cistrncmp(dictype,"alia",4)
-    	        	    || !cbf_cistrncmp(dictype,"atco",4)
-    	        	    || !cbf_cistrncmp(dictype,"char",4)
-    	        	    || !cbf_cistrncmp(dictype,"ucha",4)) { goodmatch = 1; break;   }
+    	        	  if ( item->quoted == CBF_MATCH_ANY ) { goodmatch = 1; break;   }
     	        	    
-    	        	  if (!cbf_check_type_contents(dictype,valuestring)) { goodmatch = 1; break; }
+    	        	  if (!cbf_plan_check_contents(handle->validation,item,valuestring)) { goodmatch = 1; break; }
     	        	  break;
 
     	        	
     	        	case CBF_TOKEN_SCSTRING:
 
-					if ( !cbf_cistrncmp(dictype,"implied",8) ) {
-    	        	  
-    	        	    goodmatch = 1;
-    	        	    
-    	        	    break;
-    	        	  	
-    	        	  }
     	        	
-    	        	  if(!cbf_cistrncmp(dictype,"text",4) 
-    	        	    || !cbf_cistrncmp(dictype,"any",3)
-    	        	    || !cbf_cistrncmp(dictype,"char",4)
-    	                || !cbf_cistrncmp(dictype,"ucha",4)) { goodmatch = 1; break;   }
+    	        	  if ( item->text == CBF_MATCH_ANY ) { goodmatch = 1; break;   }
     	        	   
-    	        	  if (!cbf_check_type_contents(dictype,valuestring)) { goodmatch = 1; break; }
+    	        	  if (!cbf_plan_check_contents(handle->validation,item,valuestring)) { goodmatch = 1; break; }
     	        	  break;
 
     	        	
     	        }
     	                      
-    	        if (!cbf_cistrcmp(dictype,"binary")) {
+    	        if (item->binary) {
     	        
     	            if ( (((char *)node)) == NULL  
     	              || (((char *)node)[0]) == CBF_TOKEN_NULL
@@ -7600,11 +10499,11 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
 					
 					mainitemname[80] = '\0';
 					
-					cbf_failnez(cbf_row_number(handle->dictionary, (unsigned int *) &nextrow))
-					
-					memcpy(mainitemname, itemname, 80);
+					nextrow = item->row;
+
+                        memcpy(mainitemname, itemname, 80);
 				
-					if(!cbf_find_tag(handle->dictionary, "_items.method_expression")) {
+					if(item->expression && !cbf_find_tag(handle->dictionary, "_items.method_expression")) {
 						
 						while ( nextrow >=0 ) {
     	              
@@ -7681,11 +10580,11 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
                         */
                         mainitemname[80] = '\0';
                       
-                        cbf_failnez(cbf_row_number(handle->dictionary, (unsigned int *) &nextrow))
-             
+                        nextrow = item->row;
+
                         memcpy(mainitemname, itemname, 80);
                     
-                        if(!cbf_find_tag(handle->dictionary, "_items.method_expression")) {
+                        if(item->expression && !cbf_find_tag(handle->dictionary, "_items.method_expression")) {
                 
                         while ( nextrow >=0 ) {
                       
@@ -7771,26 +10670,27 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
                 } else {
                     
                   if (tokentype != CBF_TOKEN_NULL
-                    && !cbf_find_tag(handle->dictionary,"_items_enumerations.name")) {
+                    ) {
                 
-                    if (!cbf_find_hashedvalue(handle->dictionary,itemname,"name", CBF_CASE_INSENSITIVE)) {
+                    if (item->enumerations) {
                     
-                      int nextrow, valok, numb;
+                      int valok, numb;
                       
                       double doubleval=0.0;
                       
-                      const char *nextitem, *enumvalue, *enumvaluetype;
+                      const char *enumvalue, *enumvaluetype;
                       
                       char * endptr;
-                      
-                      cbf_failnez(cbf_row_number(handle->dictionary, (unsigned int *) &nextrow))
+
+                      cbf_plan_enumeration *enumeration, *lastenumeration;
+
+                      enumeration = handle->validation->enumeration + item->enumeration;
+
+                      lastenumeration = enumeration + item->enumerations;
                       
                       valok = numb = 0;
                     
-                      if ( cbf_cistrncmp(dictype,"numb",4)
-                        || cbf_cistrncmp(dictype,"int",3)
-                        || cbf_cistrncmp(dictype,"floa",4)
-                        || cbf_cistrncmp(dictype,"real",4)) {
+                      if ( item->number ) {
                         
                         numb = 1;
                         
@@ -7798,32 +10698,16 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
                       }
 
                     
-                      while ( nextrow >=0 ) {
+                      for ( ; enumeration < lastenumeration; enumeration++) {
                       
-                        cbf_failnez( cbf_find_column (handle->dictionary, "name"))
-                        
-                        cbf_failnez( cbf_select_row (handle->dictionary, nextrow))
-                        
-                        cbf_failnez( cbf_get_value (handle->dictionary, &nextitem))
-                        
-                        cbf_failnez( cbf_find_column (handle->dictionary, "name(hash_next)"))
-                        
-                        cbf_failnez( cbf_get_integervalue(handle->dictionary, &nextrow))
-
-                         if (nextitem && !cbf_cistrcmp(nextitem, itemname)) {
-                        
-                          cbf_failnez( cbf_find_column (handle->dictionary, "value_type"))
-                          
-                          cbf_failnez( cbf_get_value (handle->dictionary, &enumvaluetype))
+                          enumvaluetype = enumeration->type;
                           
-                          cbf_failnez( cbf_find_column (handle->dictionary, "value"))
-                          
-                          cbf_failnez( cbf_get_value (handle->dictionary, &enumvalue))
+                          enumvalue = enumeration->value;
                           
                           if (!cbf_cistrcmp(enumvaluetype,"value")) {
                           
                             if (!strcmp(enumvalue,valuestring) 
-                              || (numb && doubleval == strtod(enumvalue, &endptr))) {
+                              || (numb && doubleval == enumeration->number)) {
                             
     	                      valok = 1;
     	                      
@@ -7946,9 +10830,7 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     	                    
     	                  }
     	                	
-    	                }
-    	                    	              	
-    	              } /* while ( nextrow >=0 ) */
+    	                } /* for each enumeration */
     	              
     	              if (!valok) {
    						 if (!generated) {
@@ -7970,12 +10852,6 @@ int cbf_validate (cbf_handle handle, cbf_node * node, CBF_NODETYPE type, cbf_nod
     	        	
     	        }
     	      
-    	        
-    	        
-    	      }
-
-    	    }
-    	  	
     	  }
     		
     	}
@@ -8555,137 +11431,14 @@ int cbf_mpint_get_acc_bitlength(unsigned int * acc, size_t acsize, size_t * bitl
   /* Check value of type validity */
   
 int cbf_check_type_contents (const char *type, const char *value){
-	if (!cbf_cistrcmp(type,"Achar")) {
-		
-		return cbf_match(value,"^[A-Za-z]$");
-		
-	}else if (!cbf_cistrcmp(type,"ANchar")) {
-		
-		return cbf_match(value,"^[A-Za-z0-9]$");
-	
-	}else if (!cbf_cistrcmp(type,"Element")) {
-	
-		/*Achar +*/
-		return cbf_match(value,"^[A-Za-z]+$");
-		
-	}else if (!cbf_cistrcmp(type,"Tag")) {
-	
-		/*_ Ctag [._] Otag*/
-		return cbf_match(value,"^[_][A-Za-z0-9]+[_][._][A-Za-z0-9]+[_]$");
-		
-	}else if (!cbf_cistrcmp(type,"Otag")
-			  || !cbf_cistrcmp(type,"Ctag")
-			  || !cbf_cistrcmp(type,"Filename")) {
-		
-		/* ANchar [_] +*/
-		return cbf_match(value,"^[A-Za-z0-9]+[_]$");
-		
-	}else if (!cbf_cistrcmp(type,"Savename")) {
-		
-		/*$ Otag*/
-		return cbf_match(value,"[$][A-Za-z0-9]+[_]");
-		
-	}else if (!cbf_cistrcmp(type,"Date")) {
-		
-		/*[0-9][0-9][0-9][0-9]-[0-1]?[0-9]-[0-3][0-9]*/
-		return cbf_match(value,"^[0-9][0-9][0-9][0-9]-[0-1]?[0-9]-[0-3][0-9]$");
-		
-	}else if (!cbf_cistrcmp(type,"Version")) {
-		
-		/*Count [.] Count [.] Count*/
-		return cbf_match(value,"^[0-9]+[.][0-9]+[.][0-9]+$");
-		
-	}else if (!cbf_cistrcmp(type,"Range")) {
-		
-		/*Integer ? : Integer ?*/
-		return cbf_match(value,"([+-]?[0-9]+)?:([+-]?[0-9]+)?");
-		
-	}else if (!cbf_cistrcmp(type,"Digit")) {
-		
-		/*[0-9]*/
-		return cbf_match(value,"^[0-9]$");
-		
-	}else if (!cbf_cistrcmp(type,"Count")) {
-		
-		/*[0-9]+*/
-		return cbf_match(value,"^[0-9]+$");
-		
-	}else if (!cbf_cistrcmp(type,"Index")) {
-		
-		/*[1-9] Digit +*/
-		return cbf_match(value,"^[1-9]+[0-9]+");
-		
-	}else if (!cbf_cistrcmp(type,"Integer")) {
-		
-		/*[+-]? Count*/
-		return cbf_match(value,"^[+-]?[0-9]+$");
-		
-	}else if (!cbf_cistrcmp(type,"Binary")) {
-		
-		/*0b[0-1]+*/
-		return cbf_match(value,"^0b[0-1]+");
-		
-	}else if (!cbf_cistrcmp(type,"Hexadecimal")) {
-		
-		/*0x[0-7a-fA-F]+*/
-		return cbf_match(value,"^0x[0-9a-fA-F]+$");
-		
-	}else if (!cbf_cistrcmp(type,"Octal")) {
-		
-		/*0o[0-7]+*/
-		return cbf_match(value,"^0o[0-7]+$");
-		
-	}else if (!cbf_cistrcmp(type,"Symop")) {
-		
-		/*[0-1]?[0-9]?[0-9]_[0-9][0-9][0-9]*/
-		return cbf_match(value,"^[0-1]?[0-9]?[0-9]_[0-9][0-9][0-9]$");
-		
-	}else if (!cbf_cistrcmp(type,"YesorNo")) {
-		return cbf_match(value,"^y(es)?$|^n(o)?$"); 
-		
-	}else if (!cbf_cistrcmp(type,"Pchar")
-			  ||!cbf_cistrcmp(type,"Uri")) {
-		
-		/*[()\[\]_,.;:"&<>/\{}'`~!@#$%?+=*A-Za-z0-9|^-]*/
-		return cbf_match(value,"");
-		
-	}else if (!cbf_cistrcmp(type,"Text")) {
-		
-		/*[][ \n\t()_,.;:"&<>/\{}'`~!@#$%?+=*A-Za-z0-9|^-]*/
-		return cbf_match(value,"");
-		
-	}else if (!cbf_cistrcmp(type,"Code")) {
-		
-		/*[()\[\]_&<>{}~!@#$%?+=*A-Za-z0-9|^-]+*/
-		return cbf_match(value,"");
-		
-	}else if (!cbf_cistrcmp(type,"Dimension")) {
-		
-		/*[[] Count [,]? + []]*/
-		return cbf_match(value,"");
-		
-	}else if (!cbf_cistrcmp(type,"Float")
-			  || !cbf_cistrcmp(type,"Real")) {
-		
-		/*-?(([0-9]+)|([0-9]*[.][0-9]+))([(][0-9]+[)])?([eE][+-]?[0-9]+)?*/
-		return cbf_match(value,"^-?(([0-9]+)|([0-9]*[.][0-9]+))([(][0-9]+[)])?([eEdDqQ][+-]?[0-9]+)?");
-		
-	}else if (!cbf_cistrcmp(type,"Imag")) {
-		
-		/*Real[jJ]*/
-		return cbf_match(value,"^-?((([0-9]+)|([0-9]*[.][0-9]+))([(][0-9]+[)])?([eEdDqQ][+-]?[0-9]+)?)?[iIjJ]");
-		
-	}else if (!cbf_cistrcmp(type,"Label")) {
-		
-		/*[()\[\]_&<>{}~!@#$%?+=*A-Za-z0-9|^-]+*/
-		return cbf_match(value,"");
-		
-	}else if (!cbf_cistrcmp(type,"Formula")) {
-		
-		/*[()\[\]+-=*A-Za-z0-9]+*/
-		return cbf_match(value,"");
-		
-	}
+
+	size_t pattern;
+
+	for (pattern = 0; pattern < CBF_TYPE_PATTERNS; pattern++)
+
+		if (!cbf_cistrcmp(type,cbf_type_patterns[pattern].type))
+
+			return cbf_match(value,(char *)cbf_type_patterns[pattern].pattern);
 
 	return 1;
 }
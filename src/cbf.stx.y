@@ -919,7 +919,7 @@ CbfThruLoopAssignment:
 
                                                   cbf_failnez (cbf_shift_link ($$));
 
-                                                  cbf_failnez (cbf_add_columnrow ($$, $2));
+                                                  cbf_failnez (cbf_append_columnrow ($$, &($2)));
                      
                                                   cbf_failnez(cbf_apply_ws((cbf_handle)(((void **)context)[2])));
 
@@ -931,7 +931,7 @@ CbfThruLoopAssignment:
 
                                                   cbf_failnez (cbf_shift_link ($$));
 
-                                                  cbf_failnez (cbf_add_columnrow ($$, $2));
+                                                  cbf_failnez (cbf_append_columnrow ($$, &($2)));
                     
                                                   cbf_failnez(cbf_apply_ws((cbf_handle)(((void **)context)[2])));
 
@@ -1158,7 +1158,7 @@ CbfThruSFLoopAssignment:
 
                                                   cbf_failnez (cbf_shift_link ($$));
 
-                                                  cbf_failnez (cbf_add_columnrow ($$, $2));
+                                                  cbf_failnez (cbf_append_columnrow ($$, &($2)));
 
                                                   cbf_failnez (cbf_validate ((cbf_handle)(((void **)context)[2]), (cbf_node *) $2, CBF_VALUE,
                                                                                                                   (cbf_node *) $$));
@@ -1168,7 +1168,7 @@ CbfThruSFLoopAssignment:
 
                                                   cbf_failnez (cbf_shift_link ($$));
 
-                                                  cbf_failnez (cbf_add_columnrow ($$, $2));
+                                                  cbf_failnez (cbf_append_columnrow ($$, &($2)));
 
                                                   cbf_failnez (cbf_validate ((cbf_handle)(((void **)context)[2]), (cbf_node *) $2, CBF_VALUE,
                                                                                                                   (cbf_node *) $$));
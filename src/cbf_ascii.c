@@ -341,6 +341,10 @@ int cbf_foldtextline(const char** string, char* fline,
            if (c[ipos+1] == '\n' || c[ipos+1] == '\0') {
            
              ipos++;
+
+               /* a final backslash ends the text */
+
+             if (!c[ipos]) break;
               
              continue;
            	
@@ -449,6 +453,8 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
 
   unsigned int column;
 
+  size_t length;
+
   const char *c;
   
   char delim, adelim;
@@ -479,12 +485,27 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
 
       return CBF_ARGUMENT;
 
+  length = strlen (string + 1);
+
 
     /* Get the current column */
 
   cbf_failnez (cbf_get_filecoordinates (file, NULL, &column))
 
 
+    /* Fast path: a plain word that fits on the current line */
+
+  if ((*string == CBF_TOKEN_WORD || *string == CBF_TOKEN_NULL)
+      && column + length + 3 <= file->columnlimit
+      && string [1] != '"' && string [1] != '\''
+      && !strpbrk (string + 1, " \t\n\r")) {
+
+    cbf_failnez (cbf_write_character (file, ' '))
+
+    return cbf_write_chars (file, string + 1, length);
+  }
+
+
     /* Do we need to start a new line? */
 
   if (column) {
@@ -545,16 +566,16 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
     case  CBF_TOKEN_WORD:
     case  CBF_TOKEN_NULL:
     
-      if (strlen(string+1) <= file->columnlimit
+      if (length <= file->columnlimit
         && *(string+1)!='"' && *(string+1)!='\''
         && !strpbrk(string+1," \t\n\r")
-        && !(strlen(string+1) == file->columnlimit && *(string+1)==';') ) {
+        && !(length == file->columnlimit && *(string+1)==';') ) {
 
-        if (strlen(string+1) != file->columnlimit)
+        if (length != file->columnlimit)
 
           cbf_failnez (cbf_write_character (file, ' '))
 
-        cbf_failnez (cbf_write_string (file, string + 1))
+        cbf_failnez (cbf_write_chars (file, string + 1, length))
 
         break;
       
@@ -586,16 +607,16 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
       	  
       }
 
-      if (strlen(string+1)+2 < file->columnlimit && !strchr(string+1,delim))  {
+      if (length+2 < file->columnlimit && !strchr(string+1,delim))  {
 
-        if (strlen(string+1)+3 < file->columnlimit) {
+        if (length+3 < file->columnlimit) {
         	
           cbf_failnez (cbf_write_character (file, ' '))
         }
 
         cbf_failnez (cbf_write_character (file, delim))
 
-        cbf_failnez (cbf_write_string (file, string + 1))
+        cbf_failnez (cbf_write_chars (file, string + 1, length))
 
         cbf_failnez (cbf_write_character (file, delim))
 
@@ -742,7 +763,9 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
 
       } else {
 
-        if (file->column) {
+          /* A final newline of the value is not the one before the ; */
+
+        if (file->column || *(c-1) == '\n') {
 
       	  cbf_failnez (cbf_write_character (file, '\n'))
 
@@ -894,7 +917,7 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
 
 
         if (termc == ';') {
-            if (file->column) {
+            if (file->column || *(c-1) == '\n') {
                 cbf_failnez (cbf_write_character (file, '\n'))
             }
             cbf_failnez (cbf_write_string (file, ";\n"))	
@@ -918,9 +941,9 @@ int cbf_write_ascii (cbf_handle handle, const char *string, cbf_file *file)
   }
 
 
-    /* Flush the buffer */
+    /* Leave the text in the buffer; the caller flushes */
 
-  return cbf_flush_characters (file);
+  return 0;
 }
 
 #ifdef __cplusplus
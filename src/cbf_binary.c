@@ -257,6 +257,7 @@ extern "C" {
 #include "cbf_tree.h"
 #include "cbf_codes.h"
 #include "cbf_compress.h"
+#include "cbf_byte_offset.h"
 #include "cbf_context.h"
 #include "cbf_binary.h"
 #include "cbf_read_mime.h"
@@ -642,9 +643,11 @@ int cbf_free_value (cbf_context *context, const cbf_node *column, unsigned int r
 
         cbf_failnez(cbf_setnull_columnrow(column, row));
 
-    /* And free it */
+    /* And free it, unless it is part of the packed text of the column */
 
-  cbf_free_string (NULL, text);
+  if (!cbf_is_packed_value (column, text))
+
+    cbf_free_string (NULL, text);
 
   if (is_binary) {
 
@@ -745,6 +748,258 @@ int cbf_set_binary (cbf_node *column, unsigned int row,
 }
 
 
+  /* Copy a binary value without decompressing it */
+
+int cbf_copy_binary (cbf_node *column, unsigned int row,
+                     cbf_node *source, unsigned int source_row)
+{
+  cbf_file *file, *tempfile;
+
+  char digest [25];
+
+  long start, source_start;
+
+  size_t size, dimover, dimfast, dimmid, dimslow, padding;
+
+  unsigned int compression;
+
+  int id, bits, sign, checked_digest, realarray;
+
+  const char *byteorder;
+
+
+  if (column == source && row == source_row)
+
+    return 0;
+
+
+    /* Check the digest (this will also decode it if necessary) */
+
+  cbf_failnez (cbf_check_digest (source, source_row))
+
+  cbf_failnez (cbf_get_bintext (source, source_row, NULL, &id, &file,
+                                &source_start, &size, &checked_digest,
+                                digest, &bits, &sign, &realarray,
+                                &byteorder, &dimover, &dimfast, &dimmid, &dimslow,
+                                &padding, &compression))
+
+
+    /* Remove the old value */
+
+  cbf_failnez (cbf_set_columnrow (column, row, NULL, 1))
+
+
+    /* Get the temporary file */
+
+  cbf_failnez (cbf_open_temporary (column->context, &tempfile))
+
+
+    /* Move to the end of the temporary file */
+
+  if (cbf_set_fileposition (tempfile, 0, SEEK_END))
+
+    return CBF_FILESEEK | cbf_delete_fileconnection (&tempfile);
+
+
+    /* Get the starting location */
+
+  if (cbf_get_fileposition (tempfile, &start))
+
+    return CBF_FILETELL | cbf_delete_fileconnection (&tempfile);
+
+
+    /* Copy the compressed data as it stands */
+
+  cbf_onfailnez (cbf_set_fileposition (file, source_start, SEEK_SET),
+                 cbf_delete_fileconnection (&tempfile))
+
+  cbf_onfailnez (cbf_copy_file (tempfile, file, size),
+                 cbf_delete_fileconnection (&tempfile))
+
+
+    /* Set the value with the same descriptor */
+
+  cbf_onfailnez (cbf_set_bintext (column, row, CBF_TOKEN_TMP_BIN,
+                                  id, tempfile, start, size,
+                                  checked_digest, digest, bits, sign, realarray,
+                                  byteorder, dimover, dimfast, dimmid, dimslow,
+                                  padding, compression),
+                 cbf_delete_fileconnection (&tempfile))
+
+
+    /* Success */
+
+  return 0;
+}
+
+
+  /* State of a byte-offset compression fed a tile at a time */
+
+typedef struct
+{
+  cbf_file *file;
+
+  unsigned int previous;
+
+  size_t size;
+}
+cbf_transcode_state;
+
+static int cbf_transcode_tile (void *context, const void *elements, size_t nelem)
+{
+  cbf_transcode_state *state = (cbf_transcode_state *) context;
+
+  return cbf_compress_byte_offset_tile (elements, nelem, state->file,
+                                        &state->previous, &state->size);
+}
+
+
+  /* Set a binary value to the integer array of another binary value
+     recompressed with byte-offset compression.  The source is decoded
+     a tile at a time straight into the compressor, so the full array
+     is never held.  The result is the same as reading the array with
+     cbf_get_binary and setting it with cbf_set_binary */
+
+int cbf_transcode_binary (cbf_node *column, unsigned int row,
+                          cbf_node *source, unsigned int source_row,
+                          unsigned int compression,
+                          size_t dimfast, size_t dimmid, size_t dimslow)
+{
+  cbf_file *file, *tempfile;
+
+  cbf_tile_sink sink;
+
+  cbf_transcode_state state;
+
+  char digest [25];
+
+  long start, source_start;
+
+  size_t size, nelem, nelem_read, elsize, dimover, padding;
+
+  size_t source_dimfast, source_dimmid, source_dimslow;
+
+  unsigned int source_compression;
+
+  int id, bits, sign, elsigned, elunsigned, minelem, maxelem, realarray, errorcode;
+
+  const char *byteorder;
+
+
+  if ((compression&CBF_COMPRESSION_MASK) != CBF_BYTE_OFFSET ||
+      (compression&CBF_NO_EXPAND) ||
+      (column == source && row == source_row))
+
+    return CBF_ARGUMENT;
+
+
+    /* Get the element type (this also checks and decodes the data) */
+
+  cbf_failnez (cbf_binary_parameters (source, source_row, &source_compression,
+                                      &id, NULL, &elsize, &elsigned, &elunsigned,
+                                      &nelem, &minelem, &maxelem, &realarray,
+                                      &byteorder, &source_dimfast, &source_dimmid,
+                                      &source_dimslow, &padding))
+
+  if (realarray || elsize != sizeof (int))
+
+    return CBF_ARGUMENT;
+
+  if (cbf_is_mimebinary (source, source_row))
+
+    cbf_failnez (cbf_mime_temp (source, source_row))
+
+  cbf_failnez (cbf_get_bintext (source, source_row, NULL, &id, &file,
+                                &source_start, &size, NULL, NULL,
+                                &bits, &sign, NULL, &byteorder, &dimover,
+                                &source_dimfast, &source_dimmid, &source_dimslow,
+                                &padding, &source_compression))
+
+
+    /* Position the file at the start of the table */
+
+  cbf_failnez (cbf_set_fileposition (file, source_start, SEEK_SET))
+
+  cbf_failnez (cbf_decompress_parameters (NULL, NULL, NULL, NULL, NULL,
+                                          NULL, NULL, source_compression, file))
+
+
+    /* Remove the old value */
+
+  cbf_failnez (cbf_set_columnrow (column, row, NULL, 1))
+
+
+    /* Get the temporary file */
+
+  cbf_failnez (cbf_open_temporary (column->context, &tempfile))
+
+
+    /* Move to the end of the temporary file */
+
+  if (cbf_set_fileposition (tempfile, 0, SEEK_END))
+
+    return CBF_FILESEEK | cbf_delete_fileconnection (&tempfile);
+
+
+    /* Get the starting location */
+
+  if (cbf_get_fileposition (tempfile, &start))
+
+    return CBF_FILETELL | cbf_delete_fileconnection (&tempfile);
+
+
+    /* Feed the decoded tiles to the compressor */
+
+  cbf_onfailnez (cbf_reset_bits (tempfile),
+                 cbf_delete_fileconnection (&tempfile))
+
+  cbf_onfailnez (cbf_start_digest (tempfile),
+                 cbf_delete_fileconnection (&tempfile))
+
+  state.file = tempfile;
+
+  state.previous = 0;
+
+  state.size = 0;
+
+  sink.put = cbf_transcode_tile;
+
+  sink.context = &state;
+
+  errorcode = cbf_decompress_tiles (&sink, elsize, elsigned, nelem, &nelem_read,
+                                    size, source_compression, bits, sign, file,
+                                    0, byteorder, dimover, source_dimfast,
+                                    source_dimmid, source_dimslow, padding);
+
+  if (!errorcode && nelem_read != nelem)
+
+    errorcode = CBF_ENDOFDATA;
+
+  errorcode |= cbf_flush_bits (tempfile);
+
+  errorcode |= cbf_end_digest (tempfile, digest);
+
+  if (errorcode)
+
+    return errorcode | cbf_delete_fileconnection (&tempfile);
+
+
+    /* Set the value */
+
+  cbf_onfailnez (cbf_set_bintext (column, row, CBF_TOKEN_TMP_BIN,
+                                  id, tempfile, start, state.size,
+                                  1, digest, elsize * CHAR_BIT, elsigned != 0, 0,
+                                  "little_endian", nelem, dimfast, dimmid, dimslow,
+                                  0, compression),
+                 cbf_delete_fileconnection (&tempfile))
+
+
+    /* Success */
+
+  return 0;
+}
+
+
   /* Check the message digest */
 
 int cbf_check_digest (cbf_node *column, unsigned int row)
@@ -849,9 +1104,9 @@ int cbf_binary_parameters (cbf_node *column,
 
   int text_bits=0, errorcode=0;
   
-  size_t text_dimover=0;
+  size_t text_dimover=0, text_dimfast=0, text_dimmid=0, text_dimslow=0;
   
-  int text_sign=0;
+  int text_sign=0, text_real=0;
 
 
     /* Check the digest (this will also decode it if necessary) */
@@ -859,6 +1114,74 @@ int cbf_binary_parameters (cbf_node *column,
   cbf_failnez (cbf_check_digest (column, row))
 
 
+    /* If only the headers were scanned, answer from the MIME header
+       when it gives the element count, without touching the data */
+
+  cbf_failnez (cbf_get_bintext (column, row, NULL,
+                                id, &file, &start, &size, NULL,
+                                NULL, &text_bits, &text_sign, &text_real,
+                                byteorder, &text_dimover,
+                                &text_dimfast, &text_dimmid, &text_dimslow, padding,
+                                compression))
+
+  if (file && (file->read_headers & CBF_PARSE_SCAN) && text_bits > 0)
+  {
+    if (!text_dimover && text_dimfast)
+
+      text_dimover = text_dimfast * (text_dimmid ? text_dimmid : 1)
+                                  * (text_dimslow ? text_dimslow : 1);
+
+    if (text_dimover)
+    {
+      if (realarray)
+
+        *realarray = text_real;
+
+      if (dimfast)
+
+        *dimfast = text_dimfast;
+
+      if (dimmid)
+
+        *dimmid = text_dimmid;
+
+      if (dimslow)
+
+        *dimslow = text_dimslow;
+
+      if (eltype)
+
+        *eltype = text_real ? CBF_FLOAT : CBF_INTEGER;
+
+      if (elsize)
+
+        *elsize = (text_bits + CHAR_BIT - 1) / CHAR_BIT;
+
+      if (elsigned)
+
+        *elsigned = text_sign ? 1 : 0;
+
+      if (elunsigned)
+
+        *elunsigned = text_sign ? 0 : 1;
+
+      if (nelem)
+
+        *nelem = text_dimover;
+
+      if (minelem)
+
+        *minelem = 0;
+
+      if (maxelem)
+
+        *maxelem = 0;
+
+      return 0;
+    }
+  }
+
+
     /* Is it an encoded binary section? */
 
   if (cbf_is_mimebinary (column, row))
@@ -1040,6 +1363,86 @@ int cbf_get_binary (cbf_node *column, unsigned int row, int *id,
 }
 
 
+  /* Get the elements of a region of interest of a binary value */
+
+int cbf_get_binary_roi (cbf_node *column, unsigned int row, int *id,
+                        void *value, size_t elsize, int elsign,
+                        size_t fastlow, size_t fasthigh,
+                        size_t midlow, size_t midhigh,
+                        size_t slowlow, size_t slowhigh,
+                        size_t *nelem_read, int *realarray)
+{
+  cbf_file *file=NULL;
+
+  long start=0;
+
+  int eltype_file=0, elsigned_file=0, elunsigned_file=0,
+                   minelem_file=0, maxelem_file=0, bits=0, sign=0;
+
+  unsigned int compression=0;
+
+  size_t nelem_file=0;
+
+  const char *byteorder;
+
+  size_t dimover=0, dimfast=0, dimmid=0, dimslow=0, padding=0;
+
+  size_t size=0;
+
+    /* Check the digest (this will also decode it if necessary) */
+
+  cbf_failnez (cbf_check_digest (column, row))
+
+
+    /* Is it an encoded binary section? */
+
+  if (cbf_is_mimebinary (column, row))
+  {
+    cbf_failnez (cbf_mime_temp (column, row))
+
+    return cbf_get_binary_roi (column, row, id, value, elsize, elsign,
+                               fastlow, fasthigh, midlow, midhigh,
+                               slowlow, slowhigh, nelem_read, realarray);
+  }
+
+
+    /* Parse the value */
+
+  cbf_failnez (cbf_get_bintext (column, row, NULL,
+                                id, &file, &start, &size,
+                                NULL, NULL, &bits, &sign, realarray,
+                                &byteorder, &dimover, &dimfast, &dimmid, &dimslow,
+                                &padding, &compression))
+
+
+    /* Position the file at the start of the binary section */
+
+  cbf_failnez (cbf_set_fileposition (file, start, SEEK_SET))
+
+
+    /* Get the parameters and position the file */
+
+  cbf_failnez (cbf_decompress_parameters (&eltype_file, NULL,
+                                          &elsigned_file, &elunsigned_file,
+                                          &nelem_file,
+                                          &minelem_file, &maxelem_file,
+                                          compression,
+                                          file))
+
+  if (!nelem_file)
+
+    nelem_file = dimover;
+
+
+    /* Decompress up to the end of the region */
+
+  return cbf_decompress_roi (value, elsize, elsign, nelem_file, nelem_read,
+                             size, compression, bits, sign, file, *realarray,
+                             byteorder, dimover, dimfast, dimmid, dimslow, padding,
+                             fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh);
+}
+
+
 #ifdef __cplusplus
 
 }
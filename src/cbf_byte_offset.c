@@ -260,6 +260,7 @@ extern "C" {
 #include <ctype.h>
 
 #include "cbf.h"
+#include "cbf_alloc.h"
 #include "cbf_file.h"
 #include "cbf_byte_offset.h"
 
@@ -1048,6 +1049,94 @@ int cbf_compress_byte_offset (void         *source,
     }
 
 
+  /* Compress a tile of 32-bit integers with the byte-offset algorithm,
+     continuing from the previous element.  The output is the same as
+     cbf_compress_byte_offset gives for the whole array, little-endian */
+
+int cbf_compress_byte_offset_tile (const void   *source,
+                                   size_t        nelem,
+                                   cbf_file     *file,
+                                   unsigned int *previous,
+                                   size_t       *compressedsize)
+    {
+        const unsigned int *element;
+        
+        unsigned char *unsigned_char_dest;
+        
+        unsigned int delta;
+        
+        size_t count, csize;
+        
+        if (sizeof (int) != 4 || !previous)
+            
+            return CBF_ARGUMENT;
+        
+        
+        /* At most 7 characters per element */
+        
+        cbf_failnez (cbf_set_output_buffersize (file, nelem*7))
+        
+        unsigned_char_dest =
+        (unsigned char *)(file->characters+file->characters_used);
+        
+        element = (const unsigned int *) source;
+        
+        csize = 0;
+        
+        for (count = 0; count < nelem; count++) {
+            
+            delta = element[count] - *previous;
+            
+            *previous = element[count];
+            
+            if (delta + 127 <= 254)  {
+                
+                *unsigned_char_dest++ = delta & 0xff;
+                
+                csize++;
+                
+            } else if (delta + 32767 <= 65534) {
+                
+                *unsigned_char_dest++ = 0x80;
+                
+                *unsigned_char_dest++ = delta & 0xff;
+                
+                *unsigned_char_dest++ = (delta >> 8) & 0xff;
+                
+                csize += 3;
+                
+            } else {
+                
+                *unsigned_char_dest++ = 0x80;
+                
+                *unsigned_char_dest++ = 0x00;
+                
+                *unsigned_char_dest++ = 0x80;
+                
+                *unsigned_char_dest++ = delta & 0xff;
+                
+                *unsigned_char_dest++ = (delta >> 8) & 0xff;
+                
+                *unsigned_char_dest++ = (delta >> 16) & 0xff;
+                
+                *unsigned_char_dest++ = (delta >> 24) & 0xff;
+                
+                csize += 7;
+                
+            }
+            
+        }
+        
+        file->characters_used += csize;
+        
+        if (compressedsize)
+            
+            *compressedsize += csize;
+        
+        return 0;
+    }
+
+
   /* Decompress an array with the byte-offset algorithm */
 
 static int cbf_decompress_byte_offset_slow (void         *destination,
@@ -2169,6 +2258,235 @@ int cbf_decompress_byte_offset(void         *destination,
       file, realarray, byteorder, dimover, dimfast, dimmid, dimslow, padding);
 }
 
+
+  /* Decompress the integers of a region of interest, reading only as
+     far as the last element of the region
+
+     Elements ahead of the region are decoded to carry the running
+     value but are not stored.  The compressed bytes are read a block
+     at a time, so nothing past the block holding the last element of
+     the region is read. */
+
+#define CBF_ROI_BLOCK 65536
+
+int cbf_decompress_byte_offset_roi (void         *destination,
+                                    size_t        elsize,
+                                    size_t        nelem,
+                                    size_t       *nelem_read,
+                                    size_t        compressedsize,
+                                    int           data_bits,
+                                    cbf_file     *file,
+                                    size_t        dimfast,
+                                    size_t        dimmid,
+                                    size_t        fastlow,
+                                    size_t        fasthigh,
+                                    size_t        midlow,
+                                    size_t        midhigh,
+                                    size_t        slowlow,
+                                    size_t        slowhigh)
+{
+#ifdef CBF_USE_LONG_LONG
+    unsigned char *raw, *out;
+
+    size_t avail, pos, unread, index, last, stored, fast, mid, slow;
+
+    long long base, delta;
+
+    int inrow;
+
+    void *block;
+
+
+    /* Is the element size valid? */
+
+    if (elsize != 1 && elsize != 2 && elsize != 4 && elsize != 8)
+
+        return CBF_ARGUMENT;
+
+    if (data_bits < 1 || data_bits > 64 || file->bits[0] != 0)
+
+        return CBF_ARGUMENT;
+
+    if (!dimfast || !dimmid
+        || fasthigh < fastlow || fasthigh >= dimfast
+        || midhigh < midlow || midhigh >= dimmid
+        || slowhigh < slowlow)
+
+        return CBF_ARGUMENT;
+
+
+    /* Index of the last element of the region */
+
+    last = fasthigh + dimfast * (midhigh + dimmid * slowhigh);
+
+    if (last >= nelem)
+
+        return CBF_ARGUMENT;
+
+
+    /* Leave room at the end of the block for one escaped element */
+
+    cbf_failnez (cbf_alloc (&block, NULL, 1, CBF_ROI_BLOCK + 16))
+
+    raw = (unsigned char *) block;
+
+    memset (raw, 0, CBF_ROI_BLOCK + 16);
+
+    out = (unsigned char *) destination;
+
+    avail = pos = 0;
+
+    unread = compressedsize;
+
+    base = 0;
+
+    stored = 0;
+
+    fast = mid = slow = 0;
+
+    inrow = midlow == 0 && slowlow == 0;
+
+    for (index = 0; index <= last; index++)
+    {
+        /* Refill when the next element could run past the block */
+
+        if (avail - pos < 15 && unread) {
+
+            if (pos)
+
+                memmove (raw, raw + pos, avail - pos);
+
+            avail -= pos;
+
+            pos = 0;
+
+            while (avail < CBF_ROI_BLOCK && unread) {
+
+                size_t todo;
+
+                todo = CBF_ROI_BLOCK - avail;
+
+                if (todo > unread)
+
+                    todo = unread;
+
+                cbf_onfailnez (cbf_get_block (file, todo),
+                               cbf_free (&block, NULL))
+
+                if (!file->buffer_used) {
+
+                    cbf_free (&block, NULL);
+
+                    return CBF_FILEREAD;
+                }
+
+                memcpy (raw + avail, file->buffer, file->buffer_used);
+
+                avail += file->buffer_used;
+
+                unread -= file->buffer_used;
+            }
+
+            memset (raw + avail, 0, CBF_ROI_BLOCK + 16 - avail);
+        }
+
+        if (pos >= avail)
+
+            break;
+
+
+        /* Decode the next delta */
+
+        delta = (signed char) raw[pos++];
+
+        if (delta == -128) {
+
+            delta = (short) (raw[pos] | (raw[pos+1] << 8));
+
+            pos += 2;
+
+            if (delta == -32768) {
+
+                delta = (int) ((unsigned int) raw[pos]
+                            | ((unsigned int) raw[pos+1] << 8)
+                            | ((unsigned int) raw[pos+2] << 16)
+                            | ((unsigned int) raw[pos+3] << 24));
+
+                pos += 4;
+
+                if (delta == -2147483647L - 1) {
+
+                    int j;
+
+                    unsigned long long wide;
+
+                    wide = 0;
+
+                    for (j = 7; j >= 0; j--)
+
+                        wide = (wide << 8) | raw[pos+j];
+
+                    delta = (long long) wide;
+
+                    pos += 8;
+                }
+            }
+        }
+
+        base += delta;
+
+
+        /* Store it if it lies in the region */
+
+        if (inrow && fast >= fastlow && fast <= fasthigh) {
+
+            switch (elsize)
+            {
+                case 1: { unsigned char  value = (unsigned char)  base;
+                          memcpy (out, &value, 1); break; }
+                case 2: { unsigned short value = (unsigned short) base;
+                          memcpy (out, &value, 2); break; }
+                case 4: { unsigned int   value = (unsigned int)   base;
+                          memcpy (out, &value, 4); break; }
+                default:  memcpy (out, &base, 8);
+            }
+
+            out += elsize;
+
+            stored++;
+        }
+
+        if (++fast == dimfast) {
+
+            fast = 0;
+
+            if (++mid == dimmid) {
+
+                mid = 0;
+
+                slow++;
+            }
+
+            inrow = mid >= midlow && mid <= midhigh
+                 && slow >= slowlow && slow <= slowhigh;
+        }
+    }
+
+    cbf_failnez (cbf_free (&block, NULL))
+
+
+    /* Number read */
+
+    if (nelem_read)
+
+        *nelem_read = stored;
+
+    return 0;
+#else
+    return CBF_ARGUMENT;
+#endif
+}
+
 #ifdef __cplusplus
 
 }
@@ -2157,29 +2157,33 @@ int cbf_compress_canonical (void         *source,
 }
 
 
-    /* Decompress an array (from the start of the table) */
-
-int cbf_decompress_canonical (void         *destination,
-                              size_t        elsize,
-                              int           elsign,
-                              size_t        nelem,
-                              size_t       *nelem_read,
-                              size_t        compressedsize,
-                              unsigned int  compression,
-                              int           data_bits,
-                              int           data_sign,
-                              cbf_file     *file,
-                              int           realarray,
-                              const char   *byteorder,
-                              size_t        dimover,
-                              size_t        dimfast,
-                              size_t        dimmid,
-                              size_t        dimslow,
-                              size_t        padding)
+    /* Decompress an array (from the start of the table), either into
+       a full destination array or, if sink is set, through a destination
+       window of window elements that is passed on each time it fills */
+
+static int cbf_decompress_canonical_window (void         *destination,
+                                            size_t        window,
+                                            cbf_tile_sink *sink,
+                                            size_t        elsize,
+                                            int           elsign,
+                                            size_t        nelem,
+                                            size_t       *nelem_read,
+                                            size_t        compressedsize,
+                                            unsigned int  compression,
+                                            int           data_bits,
+                                            int           data_sign,
+                                            cbf_file     *file,
+                                            int           realarray,
+                                            const char   *byteorder,
+                                            size_t        dimover,
+                                            size_t        dimfast,
+                                            size_t        dimmid,
+                                            size_t        dimslow,
+                                            size_t        padding)
 {
     unsigned int bits, element[4], sign, unsign, limit, count64, count;
     
-    unsigned char *unsigned_char_data;
+    unsigned char *unsigned_char_data, *window_end, *delivered;
     
     cbf_compress_data *data;
     
@@ -2273,6 +2277,10 @@ int cbf_decompress_canonical (void         *destination,
     
     unsigned_char_data = (unsigned char *) destination;
     
+    delivered = unsigned_char_data;
+    
+    window_end = unsigned_char_data + window * elsize;
+    
     
     /* Maximum limit (unsigned) is 64 bits */
     
@@ -2423,8 +2431,22 @@ int cbf_decompress_canonical (void         *destination,
         
         
         unsigned_char_data += elsize;
+        
+        if (sink && unsigned_char_data == window_end)
+            
+            cbf_onfailnez (cbf_flush_tile (sink, (unsigned char *) destination,
+                                           &unsigned_char_data, &delivered,
+                                           0, elsize),
+                           cbf_free_compressdata (data))
     }
     
+    if (sink)
+        
+        cbf_onfailnez (cbf_flush_tile (sink, (unsigned char *) destination,
+                                       &unsigned_char_data, &delivered,
+                                       0, elsize),
+                       cbf_free_compressdata (data))
+    
     
     /* Number read */
     
@@ -2442,6 +2464,72 @@ int cbf_decompress_canonical (void         *destination,
     
     return 0;
 }
+
+
+    /* Decompress an array (from the start of the table) */
+
+int cbf_decompress_canonical (void         *destination,
+                              size_t        elsize,
+                              int           elsign,
+                              size_t        nelem,
+                              size_t       *nelem_read,
+                              size_t        compressedsize,
+                              unsigned int  compression,
+                              int           data_bits,
+                              int           data_sign,
+                              cbf_file     *file,
+                              int           realarray,
+                              const char   *byteorder,
+                              size_t        dimover,
+                              size_t        dimfast,
+                              size_t        dimmid,
+                              size_t        dimslow,
+                              size_t        padding)
+{
+    return cbf_decompress_canonical_window (destination, 0, NULL,
+                                            elsize, elsign, nelem, nelem_read,
+                                            compressedsize, compression,
+                                            data_bits, data_sign, file,
+                                            realarray, byteorder, dimover,
+                                            dimfast, dimmid, dimslow, padding);
+}
+
+
+    /* Decompress an array (from the start of the table) a tile at a time */
+
+int cbf_decompress_canonical_tiles (cbf_tile_sink *sink,
+                                    size_t        elsize,
+                                    int           elsign,
+                                    size_t        nelem,
+                                    size_t       *nelem_read,
+                                    size_t        compressedsize,
+                                    unsigned int  compression,
+                                    int           data_bits,
+                                    int           data_sign,
+                                    cbf_file     *file,
+                                    int           realarray,
+                                    const char   *byteorder,
+                                    size_t        dimover,
+                                    size_t        dimfast,
+                                    size_t        dimmid,
+                                    size_t        dimslow,
+                                    size_t        padding)
+{
+    void *window;
+    
+    int errorcode;
+    
+    cbf_failnez (cbf_alloc (&window, NULL, elsize, CBF_TILE_ELEMENTS))
+    
+    errorcode = cbf_decompress_canonical_window (window, CBF_TILE_ELEMENTS, sink,
+                                                 elsize, elsign, nelem, nelem_read,
+                                                 compressedsize, compression,
+                                                 data_bits, data_sign, file,
+                                                 realarray, byteorder, dimover,
+                                                 dimfast, dimmid, dimslow, padding);
+    
+    return errorcode | cbf_free (&window, NULL);
+}
     
 
 #ifdef __cplusplus
@@ -630,6 +630,310 @@ int cbf_decompress (void         *destination,
 }
 
 
+  /* Decompress an array a tile at a time (from the start of the table) */
+
+int cbf_decompress_tiles (cbf_tile_sink *sink,
+                          size_t        elsize,
+                          int           elsign,
+                          size_t        nelem,
+                          size_t       *nelem_read,
+                          size_t        compressedsize,
+                          unsigned int  compression,
+                          int           bits,
+                          int           sign,
+                          cbf_file     *file,
+                          int           realarray,
+                          const char   *byteorder,
+                          size_t        dimover,
+                          size_t        dimfast,
+                          size_t        dimmid,
+                          size_t        dimslow,
+                          size_t        padding)
+{
+  void *array;
+
+  size_t done;
+
+  int errorcode;
+
+
+  if (!sink || !sink->put)
+
+    return CBF_ARGUMENT;
+
+  switch (compression&CBF_COMPRESSION_MASK)
+  {
+    case CBF_CANONICAL:
+
+      errorcode = cbf_decompress_canonical_tiles (sink, elsize, elsign, nelem,
+                                       nelem_read, compressedsize, compression,
+                                       bits, sign, file, realarray, byteorder,
+                                       dimover, dimfast, dimmid, dimslow, padding);
+
+      return errorcode == CBF_TILE_STOP ? 0 : errorcode;
+
+    case CBF_PACKED:
+    case CBF_PACKED_V2:
+    case 0:
+
+      errorcode = cbf_decompress_packed_tiles (sink, elsize, elsign, nelem,
+                                    nelem_read, compressedsize, compression,
+                                    bits, sign, file, realarray, byteorder,
+                                    dimover, dimfast, dimmid, dimslow, padding);
+
+      return errorcode == CBF_TILE_STOP ? 0 : errorcode;
+  }
+
+
+    /* The other codecs decode the whole array and pass it on */
+
+  cbf_failnez (cbf_alloc (&array, NULL, elsize, nelem))
+
+  if (!nelem_read)
+
+    nelem_read = &done;
+
+  errorcode = cbf_decompress (array, elsize, elsign, nelem, nelem_read,
+                              compressedsize, compression, bits, sign, file,
+                              realarray, byteorder, dimover,
+                              dimfast, dimmid, dimslow, padding);
+
+  if (!errorcode)
+
+    errorcode = sink->put (sink->context, array, *nelem_read);
+
+  if (errorcode == CBF_TILE_STOP)
+
+    errorcode = 0;
+
+  return errorcode | cbf_free (&array, NULL);
+}
+
+
+  /* Pass the elements decoded into a window on to the sink and keep
+     the last history elements at the start of the window */
+
+int cbf_flush_tile (cbf_tile_sink  *sink,
+                    unsigned char  *window,
+                    unsigned char **next,
+                    unsigned char **delivered,
+                    size_t          history,
+                    size_t          elsize)
+{
+  size_t keep;
+
+  if (*next > *delivered)
+
+    cbf_failnez (sink->put (sink->context, *delivered,
+                            (*next - *delivered) / elsize))
+
+  keep = (*next - window) / elsize;
+
+  if (keep > history)
+
+    keep = history;
+
+  if (keep && *next - keep * elsize != window)
+
+    memmove (window, *next - keep * elsize, keep * elsize);
+
+  *next = *delivered = window + keep * elsize;
+
+  return 0;
+}
+
+
+  /* Sink that keeps the elements of a region of interest */
+
+typedef struct
+{
+  unsigned char *destination;
+
+  size_t elsize, index, last, stored;
+
+  size_t dimfast, dimmid;
+
+  size_t fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh;
+}
+cbf_roi_state;
+
+static int cbf_roi_tile (void *context, const void *elements, size_t nelem)
+{
+  cbf_roi_state *roi;
+
+  const unsigned char *source;
+
+  size_t fast, row, mid, slow, run, low, high;
+
+  roi = (cbf_roi_state *) context;
+
+  source = (const unsigned char *) elements;
+
+
+    /* Take the tile a row at a time */
+
+  while (nelem && roi->index <= roi->last)
+  {
+    fast = roi->index % roi->dimfast;
+
+    row = roi->index / roi->dimfast;
+
+    mid = row % roi->dimmid;
+
+    slow = row / roi->dimmid;
+
+    run = roi->dimfast - fast;
+
+    if (run > nelem)
+
+      run = nelem;
+
+    if (mid >= roi->midlow && mid <= roi->midhigh &&
+        slow >= roi->slowlow && slow <= roi->slowhigh)
+    {
+      low = fast > roi->fastlow ? fast : roi->fastlow;
+
+      high = fast + run - 1 < roi->fasthigh ? fast + run - 1 : roi->fasthigh;
+
+      if (low <= high)
+      {
+        memcpy (roi->destination + roi->stored * roi->elsize,
+                source + (low - fast) * roi->elsize,
+                (high - low + 1) * roi->elsize);
+
+        roi->stored += high - low + 1;
+      }
+    }
+
+    source += run * roi->elsize;
+
+    nelem -= run;
+
+    roi->index += run;
+  }
+
+  if (roi->index > roi->last)
+
+    return CBF_TILE_STOP;
+
+  return 0;
+}
+
+
+  /* Decompress the elements of a region of interest into a packed
+     array, stopping after the last element of the region */
+
+int cbf_decompress_roi (void         *destination,
+                        size_t        elsize,
+                        int           elsign,
+                        size_t        nelem,
+                        size_t       *nelem_read,
+                        size_t        compressedsize,
+                        unsigned int  compression,
+                        int           bits,
+                        int           sign,
+                        cbf_file     *file,
+                        int           realarray,
+                        const char   *byteorder,
+                        size_t        dimover,
+                        size_t        dimfast,
+                        size_t        dimmid,
+                        size_t        dimslow,
+                        size_t        padding,
+                        size_t        fastlow,
+                        size_t        fasthigh,
+                        size_t        midlow,
+                        size_t        midhigh,
+                        size_t        slowlow,
+                        size_t        slowhigh)
+{
+  cbf_roi_state roi;
+
+  cbf_tile_sink sink;
+
+  size_t fast, mid, slow;
+
+
+    /* Missing dimensions run along the fast direction */
+
+  slow = dimslow ? dimslow : 1;
+
+  mid = dimmid ? dimmid : 1;
+
+  fast = dimfast ? dimfast : nelem / (mid * slow);
+
+  if (!nelem)
+
+    nelem = fast * mid * slow;
+
+  if (fasthigh < fastlow || fasthigh >= fast ||
+      midhigh < midlow || midhigh >= mid ||
+      slowhigh < slowlow || slowhigh >= slow ||
+      fast * mid * slow > nelem)
+
+    return CBF_ARGUMENT;
+
+
+    /* Byte-offset integers are decoded in place */
+
+#ifdef CBF_USE_LONG_LONG
+
+  if ((compression&CBF_COMPRESSION_MASK) == CBF_BYTE_OFFSET && !realarray &&
+      file->bits[0] == 0 && CHAR_BIT == 8 &&
+      (elsize == 1 || elsize == 2 || elsize == 4 || elsize == 8))
+
+    return cbf_decompress_byte_offset_roi (destination, elsize, nelem, nelem_read,
+                                           compressedsize, bits, file,
+                                           fast, mid,
+                                           fastlow, fasthigh, midlow, midhigh,
+                                           slowlow, slowhigh);
+
+#endif
+
+
+    /* The other codecs pass their tiles through the region */
+
+  roi.destination = (unsigned char *) destination;
+
+  roi.elsize = elsize;
+
+  roi.index = roi.stored = 0;
+
+  roi.last = fasthigh + fast * (midhigh + mid * slowhigh);
+
+  roi.dimfast = fast;
+
+  roi.dimmid = mid;
+
+  roi.fastlow = fastlow;
+
+  roi.fasthigh = fasthigh;
+
+  roi.midlow = midlow;
+
+  roi.midhigh = midhigh;
+
+  roi.slowlow = slowlow;
+
+  roi.slowhigh = slowhigh;
+
+  sink.put = cbf_roi_tile;
+
+  sink.context = &roi;
+
+  cbf_failnez (cbf_decompress_tiles (&sink, elsize, elsign, nelem, NULL,
+                                     compressedsize, compression, bits, sign,
+                                     file, realarray, byteorder, dimover,
+                                     dimfast, dimmid, dimslow, padding))
+
+  if (nelem_read)
+
+    *nelem_read = roi.stored;
+
+  return 0;
+}
+
+
 #ifdef __cplusplus
 
 }
@@ -269,6 +269,33 @@ extern "C" {
 #include <stdio.h>
 
 
+    /* cbf_copy_unchanged -- would a binary value be recompressed
+     exactly as it stands? */
+
+    static int cbf_copy_unchanged(const int compression,
+                                  const unsigned int cifcompression,
+                                  const char * byteorder) {
+
+        return (unsigned int)compression == cifcompression
+            && !cbf_cistrcmp(byteorder,"little_endian");
+
+    }
+
+
+    /* cbf_copy_transcodable -- can a binary value be recompressed
+     a tile at a time? */
+
+    static int cbf_copy_transcodable(const int compression,
+                                     const int realarray,
+                                     const size_t elsize) {
+
+        return (compression&CBF_COMPRESSION_MASK) == CBF_BYTE_OFFSET
+            && !(compression&CBF_NO_EXPAND)
+            && !realarray && elsize == sizeof(int);
+
+    }
+
+
     /* cbf_copy_cbf -- copy cbfin to cbfout */
 
     int cbf_copy_cbf(cbf_handle cbfout, cbf_handle cbfin,
@@ -479,6 +506,34 @@ extern "C" {
                                                                  &elements, &minelement, &maxelement, &realarray,
                                                                  &byteorder, &dimfast, &dimmid, &dimslow, &padding))
 
+                    /* Copy the compressed data if the codec round trip
+                       would give the same data back */
+
+                    if (cbf_copy_unchanged(compression, cifcompression, byteorder)
+                        && !(dimflag == CBF_HDR_FINDDIMS && dimfast==0)) {
+
+                        cbf_failnez (cbf_select_column(cbfout,colnum))
+
+                        cbf_failnez (cbf_copy_binaryvalue(cbfout,cbfin))
+
+                        continue;
+                    }
+
+                    /* Recompress integers to byte-offset without
+                       holding the full array */
+
+                    if (cbf_copy_transcodable(compression, realarray, elsize)
+                        && !(dimflag == CBF_HDR_FINDDIMS && dimfast==0)) {
+
+                        cbf_failnez (cbf_select_column(cbfout,colnum))
+
+                        cbf_failnez (cbf_transcode_integerarray(cbfout,cbfin,
+                                                                compression,
+                                                                dimfast,dimmid,dimslow))
+
+                        continue;
+                    }
+
                     if ((array=malloc(elsize*elements))) {
 
                         memset(array,0,elsize*elements);
@@ -933,6 +988,38 @@ extern "C" {
                 oelsize != sizeof (char))
                 return CBF_ARGUMENT;
 
+            /* Copy the compressed data if the codec round trip
+               would give the same data back, and recompress integers
+               to byte-offset without holding the full array */
+
+            if (!roi && !binoi
+                && (eltype == 0
+                    || ((eltype & CBF_CPY_SETINTEGER) && !realarray)
+                    || ((eltype & CBF_CPY_SETREAL) && realarray))
+                && (elsize == 0 || elsize == oelsize)
+                && (elsign == 0 || realarray
+                    || ((elsign & CBF_CPY_SETSIGNED) && elsigned)
+                    || ((elsign & CBF_CPY_SETUNSIGNED) && elunsigned))
+                && cliplow >= cliphigh) {
+
+                if (cbf_copy_unchanged(compression, cifcompression, byteorder))
+
+                    return cbf_copy_binaryvalue(cbfout, cbfin);
+
+                if (cbf_copy_transcodable(compression, realarray, oelsize))
+
+                    return cbf_transcode_integerarray(cbfout, cbfin, compression,
+                                                      dimfast, dimmid, dimslow);
+
+            }
+
+
+            /* Without binning only the region of interest is decoded */
+
+            if (roi && !binoi)
+
+                elements = (fasthigh-fastlow+1)*(midhigh-midlow+1)*(slowhigh-slowlow+1);
+
 
             if ((array=malloc(oelsize*elements))) {
 
@@ -972,71 +1059,80 @@ extern "C" {
 
                     /* The current array is integer */
 
-                    cbf_onfailnez (cbf_get_integerarray(cbfin,
-                                                        &binary_id,
-                                                        array,
-                                                        oelsize,
-                                                        elsigned,
-                                                        elements,
-                                                        &elements_read),
-                                   {free(array); array=NULL;})
+                    if (roi && !binoi) {
+
+                        cbf_onfailnez (cbf_get_integerarray_roi(cbfin,
+                                                                &binary_id,
+                                                                array,
+                                                                oelsize,
+                                                                elsigned,
+                                                                fastlow,
+                                                                fasthigh,
+                                                                midlow,
+                                                                midhigh,
+                                                                slowlow,
+                                                                slowhigh,
+                                                                &elements_read),
+                                       {free(array); array=NULL;})
+
+                        dimfast = fasthigh - fastlow + 1;
+
+                        dimmid  = midhigh  - midlow + 1;
+
+                        dimslow = slowhigh - slowlow + 1;
+
+                    } else {
+
+                        cbf_onfailnez (cbf_get_integerarray(cbfin,
+                                                            &binary_id,
+                                                            array,
+                                                            oelsize,
+                                                            elsigned,
+                                                            elements,
+                                                            &elements_read),
+                                       {free(array); array=NULL;})
+
+                    }
 
                     if (dimfast < 1) dimfast = 1;
                     if (dimmid < 1) dimmid = 1;
                     if (dimslow < 1) dimslow = 1;
 
-                    if (roi || binoi) {
+                    if (binoi) {
 
                         void * roi_array;
 
-                        if (!binoi) {
-                            roi_array=malloc(oelsize*(fasthigh-fastlow+1)*(midhigh-midlow+1)*(slowhigh-slowlow+1));
-                            memset(roi_array,0,oelsize*(fasthigh-fastlow+1)*(midhigh-midlow+1)*(slowhigh-slowlow+1));
-                            cbf_failnez(cbf_extract_roi(array,
-                                                        roi_array,
-                                                        elsize,
-                                                        fastlow,
-                                                        fasthigh,
-                                                        midlow,
-                                                        midhigh,
-                                                        slowlow,
-                                                        slowhigh,
-                                                        dimfast,
-                                                        dimmid,
-                                                        dimslow));
-                        } else {
-                            roi_array=malloc(oelsize*(bndfasthigh-bndfastlow+1)*(bndmidhigh-bndmidlow+1)*(bndslowhigh-bndslowlow+1));
-                            memset(roi_array,0,oelsize*(bndfasthigh-bndfastlow+1)*(bndmidhigh-bndmidlow+1)*(bndslowhigh-bndslowlow+1));
-                            cbf_failnez(cbf_extract_roi_binoi(array,
-                                                              roi_array,
-                                                              elsize,
-                                                              elsigned,
-                                                              realarray,
-                                                              fastlow,
-                                                              fasthigh,
-                                                              midlow,
-                                                              midhigh,
-                                                              slowlow,
-                                                              slowhigh,
-                                                              dimfast,
-                                                              dimmid,
-                                                              dimslow,
-                                                              binratio,
-                                                              bndfastlow,
-                                                              bndfasthigh,
-                                                              bndmidlow,
-                                                              bndmidhigh,
-                                                              bndslowlow,
-                                                              bndslowhigh,
-                                                              modulefast,
-                                                              modulemid,
-                                                              moduleslow,
-                                                              gapfast,
-                                                              gapmid,
-                                                              gapslow
-                                                              ));
+                        roi_array=malloc(oelsize*(bndfasthigh-bndfastlow+1)*(bndmidhigh-bndmidlow+1)*(bndslowhigh-bndslowlow+1));
+                        memset(roi_array,0,oelsize*(bndfasthigh-bndfastlow+1)*(bndmidhigh-bndmidlow+1)*(bndslowhigh-bndslowlow+1));
+                        cbf_failnez(cbf_extract_roi_binoi(array,
+                                                          roi_array,
+                                                          elsize,
+                                                          elsigned,
+                                                          realarray,
+                                                          fastlow,
+                                                          fasthigh,
+                                                          midlow,
+                                                          midhigh,
+                                                          slowlow,
+                                                          slowhigh,
+                                                          dimfast,
+                                                          dimmid,
+                                                          dimslow,
+                                                          binratio,
+                                                          bndfastlow,
+                                                          bndfasthigh,
+                                                          bndmidlow,
+                                                          bndmidhigh,
+                                                          bndslowlow,
+                                                          bndslowhigh,
+                                                          modulefast,
+                                                          modulemid,
+                                                          moduleslow,
+                                                          gapfast,
+                                                          gapmid,
+                                                          gapslow
+                                                          ));
 
-                        }
                         if (!roi_array) {
 
                             cbf_onfailnez(CBF_ALLOC,{free(array);});
@@ -1048,23 +1144,11 @@ extern "C" {
 
                         array = roi_array;
 
-                        if (!binoi) {
-
-                          dimfast = fasthigh - fastlow + 1;
-
-                          dimmid  = midhigh  - midlow + 1;
-
-                          dimslow = slowhigh - slowlow + 1;
+                        dimfast = bndfasthigh - bndfastlow +1;
 
-                        } else {
-
-                          dimfast = bndfasthigh - bndfastlow +1;
+                        dimmid = bndmidhigh - bndmidlow +1;
 
-                          dimmid = bndmidhigh - bndmidlow +1;
-
-                          dimslow = bndslowhigh - bndslowlow +1;
-
-                        }
+                        dimslow = bndslowhigh - bndslowlow +1;
 
                         elements = elements_read = dimfast*dimmid*dimslow;
 
@@ -1708,9 +1792,28 @@ extern "C" {
 
                 /* the current array is real */
 
-                cbf_onfailnez (cbf_get_realarray(
-                                                 cbfin, &binary_id, array, oelsize,
-                                                 elements, &elements_read), {free(array);})
+                if (roi && !binoi) {
+
+                    cbf_onfailnez (cbf_get_realarray_roi(
+                                                         cbfin, &binary_id, array, oelsize,
+                                                         fastlow, fasthigh,
+                                                         midlow, midhigh,
+                                                         slowlow, slowhigh,
+                                                         &elements_read), {free(array);})
+
+                    dimfast = fasthigh - fastlow + 1;
+
+                    dimmid  = midhigh - midlow + 1;
+
+                    dimslow = slowhigh - slowlow + 1;
+
+                } else {
+
+                    cbf_onfailnez (cbf_get_realarray(
+                                                     cbfin, &binary_id, array, oelsize,
+                                                     elements, &elements_read), {free(array);})
+
+                }
 
                 if (dimflag == CBF_HDR_FINDDIMS && dimfast==0) {
                     cbf_get_arraydimensions(cbfin,NULL,&dimfast,&dimmid,&dimslow);
@@ -1720,7 +1823,7 @@ extern "C" {
                 if (dimmid < 1) dimmid = 1;
                 if (dimslow < 1) dimslow = 1;
 
-                if (roi) {
+                if (roi && binoi) {
 
                     void * roi_array;
 
@@ -2756,7 +2859,7 @@ int cbf_extract_roi(void        * src,
         || fasthigh >= dimfast
         || midhigh < midlow
         || midhigh >= dimmid
-        || slowhigh > slowlow
+        || slowhigh < slowlow
         || slowhigh >= dimslow )
 
         return CBF_ARGUMENT;
@@ -2778,27 +2881,42 @@ int cbf_extract_roi(void        * src,
 
     return CBF_SUCCESS;
 }
+/* The module offset and bin of successive fast pixels are stepped
+   rather than divided out for each pixel */
+
 #define proc_extract(type,zero)                                                                    {\
     type * binned;                                                                                  \
     type * rawel;                                                                                   \
+    type * binrow;                                                                                  \
+    type * rawrow;                                                                                  \
+    size_t binstep, binrem, binfirst;                                                               \
     binned = ( type * )dst;                                                                         \
     rawel = ( type * )src;                                                                          \
+    binfirst = (fastlow+binratio-1)/binratio;                                                       \
     for (indexslow = slowlow; indexslow <= slowhigh; indexslow++) {                                 \
         slowmodoff=indexslow%modszslow;                                                             \
+        if (slowmodoff >= moduleslow) continue;                                                     \
         indexbinslow=(size_t)((indexslow+binratio-1)/binratio)                                      \
                      -(size_t)((slowlow+binratio-1)/binratio);                                      \
         for (indexmid = midlow; indexmid <= midhigh; indexmid++) {                                  \
             midmodoff=indexmid%modszmid;                                                            \
+            if (midmodoff >= modulemid) continue;                                                   \
             indexbinmid=(size_t)((indexmid+binratio-1)/binratio)                                    \
                         -(size_t)((midlow+binratio-1)/binratio);                                    \
+            binrow = binned + (bndfasthigh-bndfastlow+1)*indexbinmid                                \
+                     + (bndfasthigh-bndfastlow+1)*(bndmidhigh-bndmidlow+1)*indexbinslow;            \
+            rawrow = rawel + dimfast*indexmid + dimfast*dimmid*indexslow;                           \
+            fastmodoff = fastlow%modszfast;                                                         \
+            binstep = (fastlow+binratio-1)/binratio;                                                \
+            binrem = (fastlow+binratio-1)%binratio;                                                 \
             for (indexfast = fastlow; indexfast <= fasthigh; indexfast++) {                         \
-                fastmodoff=indexfast%modszfast;                                                     \
-                indexbinfast=(size_t)((indexfast+binratio-1)/binratio)                              \
-                             -(size_t)((fastlow+binratio-1)/binratio);                              \
-                if (slowmodoff < moduleslow && midmodoff < modulemid  && fastmodoff < modulefast) { \
-                    binned[indexbinfast+(bndfasthigh-bndfastlow+1)*indexbinmid                      \
-                    +       (bndfasthigh-bndfastlow+1)*(bndmidhigh-bndmidlow+1)*indexbinslow] +=    \
-                    rawel[indexfast + dimfast*indexmid + dimfast*dimmid*indexslow];                 \
+                if (fastmodoff < modulefast) {                                                      \
+                    binrow[binstep-binfirst] += rawrow[indexfast];                                  \
+                }                                                                                   \
+                if (++fastmodoff == modszfast) fastmodoff = 0;                                      \
+                if (++binrem == binratio) {                                                         \
+                    binrem = 0;                                                                     \
+                    binstep++;                                                                      \
                 }                                                                                   \
             }                                                                                       \
         }                                                                                           \
@@ -2807,6 +2925,26 @@ int cbf_extract_roi(void        * src,
 }
 
 
+static int cbf_binoi_blocks(const void * src,
+                            void       * dst,
+                            size_t       elsize,
+                            int          elsigned,
+                            int          realarray,
+                            size_t       fastlow,
+                            size_t       fasthigh,
+                            size_t       midlow,
+                            size_t       midhigh,
+                            size_t       slowlow,
+                            size_t       slowhigh,
+                            size_t       dimfast,
+                            size_t       dimmid,
+                            size_t       binratio,
+                            size_t       outfast,
+                            size_t       outmid,
+                            size_t       moduleslow,
+                            size_t       modszslow);
+
+
 /* Extract an ROI from an image array into a BINOI */
 
 int cbf_extract_roi_binoi(void        * src,
@@ -2844,7 +2982,7 @@ int cbf_extract_roi_binoi(void        * src,
 
     size_t modszfast, modszmid, modszslow;
 
-    size_t indexbinfast, indexbinmid, indexbinslow, indexbin;
+    size_t indexbinmid, indexbinslow, indexbin;
 
     modszfast=modulefast+gapfast;
 
@@ -2881,6 +3019,19 @@ int cbf_extract_roi_binoi(void        * src,
 
     size_t fastmodoff, fastbinoff, midmodoff, midbinoff, slowmodoff, slowbinoff;
 
+    /* Planes of short, int or float pixels without gaps are binned by
+       the row kernels of cbf_bin_image */
+
+    if (!gapfast && !gapmid && binratio <= 65535
+        && (realarray ? elsize == sizeof (float)
+                      : elsize == sizeof (short) || elsize == sizeof (int)))
+
+        return cbf_binoi_blocks(src, dst, elsize, elsigned, realarray,
+                                fastlow, fasthigh, midlow, midhigh, slowlow, slowhigh,
+                                dimfast, dimmid, binratio,
+                                bndfasthigh-bndfastlow+1, bndmidhigh-bndmidlow+1,
+                                moduleslow, modszslow);
+
     if (realarray) {
         if (elsize == sizeof (float) ) {
             proc_extract( float , 0. );
@@ -2919,6 +3070,535 @@ int cbf_extract_roi_binoi(void        * src,
     return CBF_SUCCESS;
 }
 
+
+/* Bin the rows of an image of one element type.  Each band of binslow
+   rows is first summed down the columns, plain loops over contiguous
+   pixels that the compiler can vectorize, and the column sums are then
+   folded binfast at a time into the binned row.  Successive rows of the
+   source and of the mask are stride elements apart. */
+
+#define proc_bin(name,type,coltype,totaltype,lowest,highest,realtype)                               \
+static void name (const type * source, const unsigned char * mask, size_t stride,                   \
+                  type * destination, unsigned char * binned_mask,                                  \
+                  size_t dimfast, size_t dimslow, size_t binfast, size_t binslow,                   \
+                  int checkover, type over, int average,                                            \
+                  void * work, unsigned int * count, unsigned char * hot) {                         \
+    coltype * sum;                                                                                  \
+    totaltype * binsum;                                                                             \
+    const type * raw;                                                                               \
+    const unsigned char * rawmask;                                                                  \
+    type * out;                                                                                     \
+    size_t outfast, nfull, band, first, last, row, index, bin, end;                                 \
+    unsigned int full, half, pixels;                                                                \
+    int shift;                                                                                      \
+    sum = (coltype *) work;                                                                         \
+    binsum = (totaltype *) (sum + dimfast);                                                         \
+    outfast = (dimfast+binfast-1)/binfast;                                                          \
+    nfull = dimfast/binfast;                                                                        \
+    for (band = 0, first = 0; first < dimslow; band++, first += binslow) {                          \
+        last = first+binslow;                                                                       \
+        if (last > dimslow) last = dimslow;                                                         \
+        out = destination + band*outfast;                                                           \
+        /* Sum down the columns */                                                                  \
+        if (mask) {                                                                                 \
+            for (index = 0; index < dimfast; index++) {                                             \
+                sum[index] = 0;                                                                     \
+                count[index] = 0;                                                                   \
+                hot[index] = 0;                                                                     \
+            }                                                                                       \
+            for (row = first; row < last; row++) {                                                  \
+                raw = source + row*stride;                                                          \
+                rawmask = mask + row*stride;                                                        \
+                for (index = 0; index < dimfast; index++) {                                         \
+                    unsigned int keep = !rawmask[index];                                            \
+                    sum[index] += keep ? (coltype) raw[index] : (coltype) 0;                        \
+                    count[index] += keep;                                                           \
+                    hot[index] |= keep & (raw[index] >= over);                                      \
+                }                                                                                   \
+            }                                                                                       \
+        } else {                                                                                    \
+            raw = source + first*stride;                                                            \
+            for (index = 0; index < dimfast; index++) sum[index] = raw[index];                      \
+            for (row = first+1; row < last; row++) {                                                \
+                raw = source + row*stride;                                                          \
+                for (index = 0; index < dimfast; index++) sum[index] += raw[index];                 \
+            }                                                                                       \
+            if (checkover) {                                                                        \
+                for (index = 0; index < dimfast; index++) {                                         \
+                    count[index] = 0;                                                               \
+                    hot[index] = 0;                                                                 \
+                }                                                                                   \
+                for (row = first; row < last; row++) {                                              \
+                    raw = source + row*stride;                                                      \
+                    for (index = 0; index < dimfast; index++) hot[index] |= (raw[index] >= over);   \
+                }                                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+        /* Fold the column sums into bins */                                                        \
+        if (binfast == 1) {                                                                         \
+            for (bin = 0; bin < nfull; bin++) binsum[bin] = sum[bin];                               \
+        } else if (binfast == 2) {                                                                  \
+            for (bin = 0; bin < nfull; bin++)                                                       \
+                binsum[bin] = (totaltype) sum[2*bin] + sum[2*bin+1];                                \
+        } else if (binfast == 4) {                                                                  \
+            for (bin = 0; bin < nfull; bin++)                                                       \
+                binsum[bin] = (totaltype) sum[4*bin] + sum[4*bin+1]                                 \
+                            + sum[4*bin+2] + sum[4*bin+3];                                          \
+        } else {                                                                                    \
+            for (bin = 0; bin < nfull; bin++) {                                                     \
+                totaltype total = 0;                                                                \
+                for (index = bin*binfast; index < (bin+1)*binfast; index++) total += sum[index];    \
+                binsum[bin] = total;                                                                \
+            }                                                                                       \
+        }                                                                                           \
+        if (nfull < outfast) {                                                                      \
+            totaltype total = 0;                                                                    \
+            for (index = nfull*binfast; index < dimfast; index++) total += sum[index];              \
+            binsum[nfull] = total;                                                                  \
+        }                                                                                           \
+        if (mask || checkover) {                                                                    \
+            for (bin = 0; bin < outfast; bin++) {                                                   \
+                unsigned int pixelsum = 0;                                                          \
+                unsigned char flag = 0;                                                             \
+                end = (bin+1)*binfast;                                                              \
+                if (end > dimfast) end = dimfast;                                                   \
+                for (index = bin*binfast; index < end; index++) {                                   \
+                    pixelsum += count[index];                                                       \
+                    flag |= hot[index];                                                             \
+                }                                                                                   \
+                count[bin] = pixelsum;                                                              \
+                hot[bin] = flag;                                                                    \
+            }                                                                                       \
+        }                                                                                           \
+        /* Scale and clip the bins */                                                               \
+        full = (unsigned int)(binfast*(last-first));                                                \
+        half = full/2;                                                                              \
+        for (shift = 0; shift < 31 && (1u << shift) < full; shift++);                               \
+        if ((1u << shift) != full) shift = -1;                                                      \
+        if (!mask && !checkover) {                                                                  \
+            for (bin = 0; bin < nfull; bin++) {                                                     \
+                totaltype total = binsum[bin];                                                      \
+                if (average) {                                                                      \
+                    if (realtype) total /= full;                                                    \
+                    else if (shift >= 0) {                                                          \
+                        if (total >= 0) total = (totaltype)(((long long) total + half) >> shift);   \
+                        else total = -(totaltype)(((long long) -total + half) >> shift);            \
+                    }                                                                               \
+                    else if (total >= 0) total = (total + half)/full;                               \
+                    else total = -((-total + half)/full);                                           \
+                }                                                                                   \
+                if (!realtype) {                                                                    \
+                    if (total < lowest) total = lowest;                                             \
+                    if (total > highest) total = highest;                                           \
+                }                                                                                   \
+                out[bin] = (type) total;                                                            \
+            }                                                                                       \
+            if (binned_mask) memset(binned_mask + band*outfast, 0, nfull);                          \
+            bin = nfull;                                                                            \
+        } else bin = 0;                                                                             \
+        for (; bin < outfast; bin++) {                                                              \
+            totaltype total = binsum[bin];                                                          \
+            end = (bin+1)*binfast;                                                                  \
+            if (end > dimfast) end = dimfast;                                                       \
+            pixels = mask ? count[bin] : (unsigned int)((end-bin*binfast)*(last-first));            \
+            if (binned_mask) binned_mask[band*outfast + bin] = !pixels;                             \
+            if (!pixels) {                                                                          \
+                out[bin] = 0;                                                                       \
+                continue;                                                                           \
+            }                                                                                       \
+            if (checkover && hot[bin]) {                                                            \
+                out[bin] = over;                                                                    \
+                continue;                                                                           \
+            }                                                                                       \
+            if (average) {                                                                          \
+                if (realtype) total /= pixels;                                                      \
+                else if (total >= 0) total = (total + pixels/2)/pixels;                             \
+                else total = -((-total + pixels/2)/pixels);                                         \
+            }                                                                                       \
+            if (!realtype) {                                                                        \
+                if (total < lowest) total = lowest;                                                 \
+                if (total > highest) total = highest;                                               \
+            }                                                                                       \
+            out[bin] = (type) total;                                                                \
+        }                                                                                           \
+    }                                                                                               \
+}
+
+proc_bin( cbf_bin_short, short, int, long long, SHRT_MIN, SHRT_MAX, 0 )
+proc_bin( cbf_bin_ushort, unsigned short, unsigned int, long long, 0, USHRT_MAX, 0 )
+proc_bin( cbf_bin_short_tall, short, long long, long long, SHRT_MIN, SHRT_MAX, 0 )
+proc_bin( cbf_bin_ushort_tall, unsigned short, long long, long long, 0, USHRT_MAX, 0 )
+proc_bin( cbf_bin_int, int, long long, long long, INT_MIN, INT_MAX, 0 )
+proc_bin( cbf_bin_uint, unsigned int, long long, long long, 0, UINT_MAX, 0 )
+proc_bin( cbf_bin_float, float, double, double, -FLT_MAX, FLT_MAX, 1 )
+
+
+/* Bin rows stride elements apart with the kernel for the element type.
+   The element type and the sizes are checked by the caller, and the
+   work areas hold 2*dimfast column sums and dimfast counts and flags. */
+
+static void cbf_bin_rows(const void          * src,
+                         const unsigned char * mask,
+                         size_t                stride,
+                         void                * dst,
+                         unsigned char       * binned_mask,
+                         size_t                elsize,
+                         int                   elsigned,
+                         int                   realarray,
+                         size_t                dimfast,
+                         size_t                dimslow,
+                         size_t                binfast,
+                         size_t                binslow,
+                         int                   checkover,
+                         double                overload,
+                         int                   average,
+                         void                * colsum,
+                         unsigned int        * count,
+                         unsigned char       * hot
+                         ) {
+
+    if (realarray) {
+
+        cbf_bin_float((const float *) src, mask, stride, (float *) dst, binned_mask,
+                      dimfast, dimslow, binfast, binslow,
+                      checkover, (float) overload, average, colsum, count, hot);
+
+    } else if (elsize == sizeof (short)) {
+
+        /* The narrow column sums hold at most 65536 rows */
+
+        if (elsigned && binslow <= 65536)
+
+            cbf_bin_short((const short *) src, mask, stride, (short *) dst, binned_mask,
+                          dimfast, dimslow, binfast, binslow,
+                          checkover, (short) overload, average, colsum, count, hot);
+
+        else if (elsigned)
+
+            cbf_bin_short_tall((const short *) src, mask, stride, (short *) dst, binned_mask,
+                               dimfast, dimslow, binfast, binslow,
+                               checkover, (short) overload, average, colsum, count, hot);
+
+        else if (binslow <= 65536)
+
+            cbf_bin_ushort((const unsigned short *) src, mask, stride,
+                           (unsigned short *) dst, binned_mask,
+                           dimfast, dimslow, binfast, binslow,
+                           checkover, (unsigned short) overload, average,
+                           colsum, count, hot);
+
+        else
+
+            cbf_bin_ushort_tall((const unsigned short *) src, mask, stride,
+                                (unsigned short *) dst, binned_mask,
+                                dimfast, dimslow, binfast, binslow,
+                                checkover, (unsigned short) overload, average,
+                                colsum, count, hot);
+
+    } else if (elsigned) {
+
+        cbf_bin_int((const int *) src, mask, stride, (int *) dst, binned_mask,
+                    dimfast, dimslow, binfast, binslow,
+                    checkover, (int) overload, average, colsum, count, hot);
+
+    } else {
+
+        cbf_bin_uint((const unsigned int *) src, mask, stride,
+                     (unsigned int *) dst, binned_mask,
+                     dimfast, dimslow, binfast, binslow,
+                     checkover, (unsigned int) overload, average,
+                     colsum, count, hot);
+    }
+}
+
+
+/* Allocate the work areas of cbf_bin_rows for rows of dimfast pixels */
+
+static int cbf_alloc_bin_work(size_t dimfast, void ** colsum,
+                              unsigned int ** count, unsigned char ** hot) {
+
+    int errorcode;
+
+    *colsum = NULL;
+
+    *count = NULL;
+
+    *hot = NULL;
+
+    errorcode = cbf_alloc (colsum, NULL, sizeof (double) > sizeof (long long) ?
+                           sizeof (double) : sizeof (long long), 2*dimfast);
+
+    if (!errorcode)
+
+        errorcode = cbf_alloc ((void **) count, NULL, sizeof (unsigned int), dimfast);
+
+    if (!errorcode)
+
+        errorcode = cbf_alloc ((void **) hot, NULL, 1, dimfast);
+
+    return errorcode;
+}
+
+
+/* Free the work areas of cbf_bin_rows */
+
+static int cbf_free_bin_work(void ** colsum, unsigned int ** count, unsigned char ** hot) {
+
+    int errorcode;
+
+    errorcode = 0;
+
+    if (*hot) errorcode |= cbf_free ((void **) hot, NULL);
+
+    if (*count) errorcode |= cbf_free ((void **) count, NULL);
+
+    if (*colsum) errorcode |= cbf_free (colsum, NULL);
+
+    return errorcode;
+}
+
+
+/* Bin an image into blocks of binfast x binslow pixels
+
+   Pixels with a non-zero mask entry are left out of their bin, and a
+   bin with no pixels left is set to zero and flagged in binned_mask.
+   If overload is positive, a bin holding an unmasked pixel at or above
+   it is set to the overload value.  Otherwise the bin is the sum, or
+   with average set the rounded mean, of its pixels, clipped to the
+   range of the element type.  Partial bins at the high edges are kept,
+   so the binned image is ceil(dimfast/binfast) x ceil(dimslow/binslow). */
+
+int cbf_bin_image(const void          * src,
+                  const unsigned char * mask,
+                  void                * dst,
+                  unsigned char       * binned_mask,
+                  size_t                elsize,
+                  int                   elsigned,
+                  int                   realarray,
+                  size_t                dimfast,
+                  size_t                dimslow,
+                  size_t                binfast,
+                  size_t                binslow,
+                  double                overload,
+                  int                   average
+                  ) {
+
+    void * colsum;
+
+    unsigned int * count;
+
+    unsigned char * hot;
+
+    int checkover, errorcode;
+
+    double ceiling;
+
+    /* The pixels of a bin are counted in an unsigned int */
+
+    if (!src || !dst || !dimfast || !dimslow
+        || !binfast || !binslow || binfast > dimfast || binslow > dimslow
+        || binfast > UINT_MAX/binslow)
+
+        return CBF_ARGUMENT;
+
+    if (realarray) {
+
+        if (elsize != sizeof (float)) return CBF_ARGUMENT;
+
+        ceiling = FLT_MAX;
+
+    } else if (elsize == sizeof (short)) {
+
+        ceiling = elsigned ? SHRT_MAX : USHRT_MAX;
+
+    } else if (elsize == sizeof (int)) {
+
+        ceiling = elsigned ? INT_MAX : UINT_MAX;
+
+    } else return CBF_ARGUMENT;
+
+    /* An overload level the type cannot reach is never hit */
+
+    if (!realarray) overload = ceil(overload);
+
+    checkover = overload > 0. && overload <= ceiling;
+
+    if (!checkover) overload = ceiling;
+
+    errorcode = cbf_alloc_bin_work (dimfast, &colsum, &count, &hot);
+
+    if (!errorcode)
+
+        cbf_bin_rows (src, mask, dimfast, dst, binned_mask, elsize, elsigned, realarray,
+                      dimfast, dimslow, binfast, binslow, checkover, overload, average,
+                      colsum, count, hot);
+
+    return errorcode | cbf_free_bin_work (&colsum, &count, &hot);
+}
+
+
+/* Add a block of binned pixels into a BINOI */
+
+#define proc_binoi_add(type)                                                                        \
+    for (row = 0; row < outrows; row++) {                                                           \
+        type * out = (type *) dst + (binmid+row)*outfast + binfast + binslow*outfast*outmid;        \
+        const type * in = (const type *) block + row*outcols;                                       \
+        for (col = 0; col < outcols; col++) out[col] += in[col];                                    \
+    }
+
+/* Bin the ROI of an image without gaps into a BINOI with the row kernels
+
+   A BINOI bin k runs from pixel (k-1)*binratio+1 to k*binratio, so the
+   pixels that share a bin with the first pixel of the ROI are binned as
+   a block of their own in the fast and mid directions, and the up to
+   four blocks of each plane are added into the bins they belong to.
+   A block sum beyond the range of the element type is clipped. */
+
+static int cbf_binoi_blocks(const void * src,
+                            void       * dst,
+                            size_t       elsize,
+                            int          elsigned,
+                            int          realarray,
+                            size_t       fastlow,
+                            size_t       fasthigh,
+                            size_t       midlow,
+                            size_t       midhigh,
+                            size_t       slowlow,
+                            size_t       slowhigh,
+                            size_t       dimfast,
+                            size_t       dimmid,
+                            size_t       binratio,
+                            size_t       outfast,
+                            size_t       outmid,
+                            size_t       moduleslow,
+                            size_t       modszslow) {
+
+    size_t start[2][2], width[2][2], bin[2][2], first[2];
+
+    size_t indexslow, binslow, binmid, binfast, outrows, outcols, row, col;
+
+    int axis, fastblock, midblock, errorcode;
+
+    void * block, * colsum;
+
+    unsigned int * count;
+
+    unsigned char * hot;
+
+    first[0] = fastlow;
+
+    first[1] = midlow;
+
+    for (axis = 0; axis < 2; axis++) {
+
+        size_t low, high, lead;
+
+        low = first[axis];
+
+        high = axis ? midhigh : fasthigh;
+
+        /* The pixels up to the end of the bin of the first pixel */
+
+        lead = ((low+binratio-1)/binratio)*binratio + 1 - low;
+
+        if (lead >= binratio) lead = 0;
+
+        if (lead > high-low+1) lead = high-low+1;
+
+        start[axis][0] = low;
+
+        width[axis][0] = lead;
+
+        bin[axis][0] = 0;
+
+        start[axis][1] = low+lead;
+
+        width[axis][1] = high+1-low-lead;
+
+        bin[axis][1] = lead ? 1 : 0;
+    }
+
+    block = NULL;
+
+    errorcode = cbf_alloc_bin_work (fasthigh-fastlow+1, &colsum, &count, &hot);
+
+    if (!errorcode)
+
+        errorcode = cbf_alloc (&block, NULL, elsize, outfast*outmid);
+
+    for (indexslow = slowlow; !errorcode && indexslow <= slowhigh; indexslow++) {
+
+        if (indexslow%modszslow >= moduleslow) continue;
+
+        binslow = (indexslow+binratio-1)/binratio - (slowlow+binratio-1)/binratio;
+
+        for (midblock = 0; midblock < 2; midblock++) {
+
+            if (!width[1][midblock]) continue;
+
+            for (fastblock = 0; fastblock < 2; fastblock++) {
+
+                size_t binsfast, binsmid;
+
+                if (!width[0][fastblock]) continue;
+
+                /* A lead block is a single bin */
+
+                binsfast = fastblock ? binratio : width[0][0];
+
+                binsmid = midblock ? binratio : width[1][0];
+
+                if (binsfast > width[0][fastblock]) binsfast = width[0][fastblock];
+
+                if (binsmid > width[1][midblock]) binsmid = width[1][midblock];
+
+                cbf_bin_rows ((const char *) src
+                              + elsize*(start[0][fastblock]
+                                        + dimfast*(start[1][midblock] + dimmid*indexslow)),
+                              NULL, dimfast, block, NULL, elsize, elsigned, realarray,
+                              width[0][fastblock], width[1][midblock], binsfast, binsmid,
+                              0, 0., 0, colsum, count, hot);
+
+                outcols = (width[0][fastblock]+binsfast-1)/binsfast;
+
+                outrows = (width[1][midblock]+binsmid-1)/binsmid;
+
+                binfast = bin[0][fastblock];
+
+                binmid = bin[1][midblock];
+
+                if (realarray) {
+
+                    proc_binoi_add(float)
+
+                } else if (elsize == sizeof (short)) {
+
+                    if (elsigned) {
+
+                        proc_binoi_add(short)
+
+                    } else {
+
+                        proc_binoi_add(unsigned short)
+                    }
+
+                } else if (elsigned) {
+
+                    proc_binoi_add(int)
+
+                } else {
+
+                    proc_binoi_add(unsigned int)
+                }
+            }
+        }
+    }
+
+    if (block) errorcode |= cbf_free (&block, NULL);
+
+    return errorcode | cbf_free_bin_work (&colsum, &count, &hot);
+}
+
 /* Multiply a 3x3 matrix times a 3-vector to produce a 3-vector */
 
 int cbf_mat33_vec(double mat[3][3], double vecin[3], double vecout[3]) {
@@ -539,7 +539,7 @@ int cbf_set_io_buffersize (cbf_file *file, size_t size)
         
         target_size = old_data + size;
         
-        if (target_size  < old_size) target_size = old_size*2;
+        if (target_size  < old_size*2) target_size = old_size*2;
         
         if (cbf_realloc ((void **)fc, &old_size, 1, target_size)) {
             
@@ -1677,6 +1677,83 @@ int cbf_read_character (cbf_file *file)
 }
 
 
+  /* Read a run of at most limit characters from the input buffer without
+     going through cbf_read_character.  plain is a table indexed by
+     unsigned character, non-zero for characters that may be taken in bulk;
+     it must not mark end-of-line, tab or null characters, so that only the
+     column changes.  The run stops at the end of the characters already
+     buffered.  If save is set the run is also appended to the token
+     buffer.  The run is left in place in the input buffer and returned in
+     span and length. */
+
+int cbf_read_span (cbf_file *file, const char *plain, size_t limit,
+                                   int save, const char **span, size_t *length)
+{
+  const unsigned char *start, *end, *next;
+
+
+    /* Does the file exist? */
+
+  if (!file || !plain || !span || !length)
+
+    return CBF_ARGUMENT;
+
+  *span = file->characters;
+
+  *length = 0;
+
+  if (!file->characters || !file->characters_used || !limit)
+
+    return 0;
+
+
+    /* Find the end of the run */
+
+  start = (const unsigned char *) file->characters;
+
+  end = start + (limit < file->characters_used ? limit : file->characters_used);
+
+  for (next = start; next < end && plain [*next]; next++);
+
+  *length = next - start;
+
+  if (!*length)
+
+    return 0;
+
+
+    /* Add it to the token buffer? */
+
+  if (save)
+  {
+    if (file->buffer_size < file->buffer_used + *length + 3)
+
+      cbf_failnez (cbf_set_buffersize (file, (file->buffer_used + *length + 3) * 2))
+
+    memcpy (file->buffer + file->buffer_used, start, *length);
+
+    file->buffer_used += *length;
+
+    file->buffer [file->buffer_used] = '\0';
+  }
+
+
+    /* Consume it */
+
+  file->characters += *length;
+
+  file->characters_used -= *length;
+
+  file->characters_size -= *length;
+
+  file->column += *length;
+
+  file->last_read = next [-1];
+
+  return 0;
+}
+
+
   /* Put a character */
 
 int cbf_put_character (cbf_file *file, int c)
@@ -1766,24 +1843,109 @@ int cbf_write_character (cbf_file *file, int c)
 }
 
 
+  /* Copy a run of characters into the buffer, flushing only when full */
+
+static int cbf_put_run (cbf_file *file, const char *string, size_t length)
+{
+  size_t space;
+
+  while (length)
+  {
+    if (file->characters_used == file->characters_size)
+
+      cbf_failnez (cbf_flush_characters (file))
+
+    space = file->characters_size - file->characters_used;
+
+    if (space == 0)
+
+      return CBF_FILEWRITE;
+
+    if (space > length)
+
+      space = length;
+
+    memcpy (file->characters + file->characters_used, string, space);
+
+    file->characters_used += space;
+
+    string += space;
+
+    length -= space;
+  }
+
+
+    /* Success */
+
+  return 0;
+}
+
+
   /* Put a string */
 
 int cbf_put_string (cbf_file *file, const char *string)
 {
     /* Does the string exist? */
 
+  if (!string)
+
+    return CBF_ARGUMENT;
+
+  if (!file)
+
+    return EOF;
+
+
+    /* Copy the string into the buffer */
+
+  return cbf_put_run (file, string, strlen (string));
+}
+
+
+  /* Write length characters (convert end-of-line and update line and column) */
+
+int cbf_write_chars (cbf_file *file, const char *string, size_t length)
+{
+  const char *end;
+
+  size_t run;
+
+
+    /* Does the file exist? */
+
+  if (!file)
+
+    return EOF;
+
   if (!string)
 
     return CBF_ARGUMENT;
 
 
-    /* Write the string one character at a time */
+    /* Copy runs that need no translation in bulk */
 
-  while (*string)
+  end = string + length;
+
+  while (string < end)
   {
-    cbf_failnez (cbf_put_character (file, *string))
+    for (run = 0; string + run < end && string [run] != '\n'
+                                     && string [run] != '\t'; run++);
+
+    if (run)
+    {
+      cbf_failnez (cbf_put_run (file, string, run))
+
+      file->column += run;
+
+      string += run;
+    }
+
+    if (string < end)
+    {
+      cbf_failnez (cbf_write_character (file, *string))
 
-    string++;
+      string++;
+    }
   }
 
 
@@ -1806,17 +1968,7 @@ int cbf_write_string (cbf_file *file, const char *string)
 
     /* Write the string */
 
-  while (*string)
-  {
-    cbf_failnez (cbf_write_character (file, *string))
-
-    string++;
-  }
-
-
-    /* Success */
-
-  return 0;
+  return cbf_write_chars (file, string, strlen (string));
 }
 
 
@@ -2199,8 +2351,11 @@ int cbf_copy_file (cbf_file *destination, cbf_file *source, size_t nelem)
         old_data = destination->characters-destination->characters_base;
     
         old_size = old_data + destination->characters_size;
-    
-        if (cbf_realloc ((void **)fc, &old_size, 1, old_size+todo)) {
+
+          /* Grow geometrically, a large section arrives a block at a time */
+
+        if (cbf_realloc ((void **)fc, &old_size, 1,
+                         old_size+todo > 2*old_size ? old_size+todo : 2*old_size)) {
             
           if (!destination->stream) return CBF_ALLOC;
       
@@ -2208,7 +2363,7 @@ int cbf_copy_file (cbf_file *destination, cbf_file *source, size_t nelem)
         
           destination->characters = destination->characters_base;
         
-          destination->characters_used = old_data;
+          destination->characters_used += old_data;
         
           destination->characters_size = old_size;
         
@@ -2230,8 +2385,6 @@ int cbf_copy_file (cbf_file *destination, cbf_file *source, size_t nelem)
     
       destination->characters_used += todo;
       
-      destination->characters_size -= todo;
-      
       done = todo;
     
       break;
@@ -282,6 +282,9 @@ extern "C" {
 #include <math.h>
 #include <assert.h>
 #include <errno.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifndef HAVE_REALPATH
 #define realpath _cbf_realpath
@@ -3494,6 +3497,199 @@ if (CBF_SUCCESS==found) {
 
 
 
+#if (H5_VERS_MAJOR>1)||((H5_VERS_MAJOR==1)&&(H5_VERS_MINOR>10))||((H5_VERS_MAJOR==1)&&(H5_VERS_MINOR==10)&&(H5_VERS_RELEASE>=3))
+#define CBF_H5_HAVE_READ_CHUNK
+#endif
+
+    /* Copy the part of a decoded chunk at chunkoff that falls inside the
+       block of count elements at offset into that block, a row at a time */
+
+    static void cbf_H5Dscatter_chunk
+    (const int rank,
+     const hsize_t * const chunkoff,
+     const hsize_t * const chunk,
+     const hsize_t * const offset,
+     const hsize_t * const count,
+     const char * const src,
+     char * const dst,
+     const size_t elsize)
+    {
+        hsize_t lo[H5S_MAX_RANK], hi[H5S_MAX_RANK], pos[H5S_MAX_RANK];
+        size_t rowbytes;
+        int i;
+        for (i = 0; i < rank; ++i) {
+            lo[i] = chunkoff[i] > offset[i] ? chunkoff[i] : offset[i];
+            hi[i] = chunkoff[i]+chunk[i] < offset[i]+count[i] ? chunkoff[i]+chunk[i] : offset[i]+count[i];
+            if (hi[i] <= lo[i]) return;
+            pos[i] = lo[i];
+        }
+        rowbytes = (size_t)(hi[rank-1]-lo[rank-1])*elsize;
+        for (;;) {
+            size_t s = 0, d = 0;
+            for (i = 0; i < rank; ++i) {
+                s = s*chunk[i] + (pos[i]-chunkoff[i]);
+                d = d*count[i] + (pos[i]-offset[i]);
+            }
+            memcpy(dst+d*elsize,src+s*elsize,rowbytes);
+            for (i = rank-2; i >= 0; --i) {
+                if (++pos[i] < hi[i]) break;
+                pos[i] = lo[i];
+            }
+            if (i < 0) break;
+        }
+    }
+
+    /* Read a block spanning several chunks of a dataset compressed only with
+       the CBF filter by fetching the raw chunks with H5Dread_chunk and decoding
+       them directly into the block, in parallel when built with OpenMP.  HDF5
+       itself is only called from the calling thread.  Returns CBF_NOTFOUND
+       when the dataset or the request does not suit this path, in which case
+       nothing useful has been written to value. */
+
+    static int cbf_H5Dread_cbf_chunks
+    (const hid_t dataset,
+     const hid_t filespace,
+     const int rank,
+     const hsize_t * const offset,
+     const hsize_t * const stride,
+     const hsize_t * const count,
+     void * const value,
+     const hid_t type)
+    {
+#ifdef CBF_H5_HAVE_READ_CHUNK
+        int error = CBF_SUCCESS;
+        hid_t dcpl = CBF_H5FAIL;
+        hid_t filetype = CBF_H5FAIL;
+        hsize_t dims[H5S_MAX_RANK], chunk[H5S_MAX_RANK];
+        hsize_t first[H5S_MAX_RANK], nper[H5S_MAX_RANK];
+        unsigned int cd_values[CBF_H5Z_FILTER_CBF_NELMTS];
+        size_t cd_nelmts = CBF_H5Z_FILTER_CBF_NELMTS;
+        unsigned int filter_flags;
+        size_t elsize = 0, chunkbytes = 0, nchunks = 1, batch = 1, base, j;
+        hsize_t * chunkoffs = NULL;
+        void * * raw = NULL;
+        size_t * rawsize = NULL;
+        uint32_t * masks = NULL;
+        int * errors = NULL;
+        int i;
+
+        if (rank < 1 || rank > H5S_MAX_RANK || !offset || !count || !value) return CBF_ARGUMENT;
+        if (stride) for (i = 0; i < rank; ++i) if (1 != stride[i]) return CBF_NOTFOUND;
+        if (rank != H5Sget_simple_extent_dims(filespace,dims,NULL)) return CBF_NOTFOUND;
+
+        /* only a chunked dataset with the CBF filter alone, read without conversion */
+        if (!cbf_H5Ivalid(dcpl = H5Dget_create_plist(dataset))
+            || !cbf_H5Ivalid(filetype = H5Dget_type(dataset))) {
+            error |= CBF_H5ERROR;
+        } else if (H5D_CHUNKED != H5Pget_layout(dcpl)
+                   || 1 != H5Pget_nfilters(dcpl)
+                   || CBF_H5Z_FILTER_CBF != H5Pget_filter2(dcpl,0,&filter_flags,&cd_nelmts,cd_values,0,NULL,NULL)
+                   || rank != H5Pget_chunk(dcpl,rank,chunk)
+                   || H5Tequal(filetype,type) <= 0
+                   || !(elsize = H5Tget_size(type))) {
+            error |= CBF_NOTFOUND;
+        } else {
+            chunkbytes = elsize;
+            for (i = 0; i < rank; ++i) {
+                if (!count[i] || !chunk[i] || offset[i]+count[i] > dims[i]) {
+                    error |= CBF_NOTFOUND;
+                    break;
+                }
+                first[i] = offset[i]/chunk[i];
+                nper[i] = (offset[i]+count[i]-1)/chunk[i] - first[i] + 1;
+                nchunks *= nper[i];
+                chunkbytes *= chunk[i];
+            }
+            if (cd_nelmts > CBF_H5Z_FILTER_CBF_NELMTS) cd_nelmts = CBF_H5Z_FILTER_CBF_NELMTS;
+            /* a single chunk gains nothing from this */
+            if (nchunks < 2) error |= CBF_NOTFOUND;
+        }
+        if (cbf_H5Ivalid(filetype)) H5Tclose(filetype);
+        if (cbf_H5Ivalid(dcpl)) H5Pclose(dcpl);
+        if (CBF_SUCCESS != error) return error;
+
+#ifdef _OPENMP
+        batch = 4*(size_t)omp_get_max_threads();
+#endif
+        if (batch > nchunks) batch = nchunks;
+        if (!(chunkoffs = (hsize_t *)malloc(batch*rank*sizeof(hsize_t)))
+            || !(raw = (void * *)calloc(batch,sizeof(void *)))
+            || !(rawsize = (size_t *)malloc(batch*sizeof(size_t)))
+            || !(masks = (uint32_t *)malloc(batch*sizeof(uint32_t)))
+            || !(errors = (int *)malloc(batch*sizeof(int)))) {
+            error |= CBF_ALLOC;
+        }
+
+        for (base = 0; CBF_SUCCESS == error && base < nchunks; base += batch) {
+            const size_t n = nchunks-base < batch ? nchunks-base : batch;
+            long k;
+
+            /* fetch the raw chunks */
+            for (j = 0; CBF_SUCCESS == error && j < n; ++j) {
+                hsize_t * const coff = chunkoffs+j*rank;
+                size_t index = base+j;
+                hsize_t nbytes = 0;
+                for (i = rank-1; i >= 0; --i) {
+                    coff[i] = (first[i] + index%nper[i])*chunk[i];
+                    index /= nper[i];
+                }
+                masks[j] = 0;
+                /* unallocated chunks hold fill values, which are left to HDF5 */
+                if (H5Dget_chunk_storage_size(dataset,coff,&nbytes) < 0 || !nbytes) {
+                    error |= CBF_NOTFOUND;
+                } else if (!(raw[j] = malloc(nbytes))) {
+                    error |= CBF_ALLOC;
+                } else {
+                    rawsize[j] = nbytes;
+                    CBF_H5CALL(H5Dread_chunk(dataset,H5P_DEFAULT,coff,&masks[j],raw[j]));
+                }
+            }
+
+            /* decode them into the block */
+            if (CBF_SUCCESS == error) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(n > 1)
+#endif
+                for (k = 0; k < (long)n; ++k) {
+                    void * decoded = malloc(chunkbytes);
+                    size_t size = chunkbytes;
+                    errors[k] = CBF_SUCCESS;
+                    if (!decoded) {
+                        errors[k] = CBF_ALLOC;
+                    } else if (masks[k] & 1) {
+                        /* the filter was skipped when the chunk was written */
+                        if (rawsize[k] != chunkbytes) errors[k] = CBF_FORMAT;
+                        else memcpy(decoded,raw[k],chunkbytes);
+                    } else {
+                        errors[k] = cbf_h5z_decode_chunk(raw[k],rawsize[k],cd_nelmts,cd_values,&decoded,&size);
+                        if (!errors[k] && size != chunkbytes) errors[k] = CBF_FORMAT;
+                    }
+                    if (!errors[k]) {
+                        cbf_H5Dscatter_chunk(rank,chunkoffs+k*rank,chunk,offset,count,
+                                             (const char *)decoded,(char *)value,elsize);
+                    }
+                    free(decoded);
+                }
+                for (j = 0; j < n; ++j) error |= errors[j];
+            }
+
+            for (j = 0; j < n; ++j) {
+                free(raw[j]);
+                raw[j] = NULL;
+            }
+        }
+
+        free(errors);
+        free(masks);
+        free(rawsize);
+        free(raw);
+        free(chunkoffs);
+        return error;
+#else
+        return CBF_NOTFOUND;
+#endif
+    }
+
     /**
      Read some data from a given location in the dataset to an existing location in memory. Does not check the
     length of the array parameters, which should all have <code>rank</code> elements or (in some cases) be
@@ -3545,6 +3741,8 @@ if (CBF_SUCCESS==found) {
                     error |= CBF_ARGUMENT;
                 } else if (!cbf_H5Ivalid(memspace)) {
                     error |= CBF_H5ERROR;
+                } else if (rank && CBF_SUCCESS == cbf_H5Dread_cbf_chunks(dataset,filespace,rank,offset,stride,count,value,type)) {
+                    /* a multi-chunk block of CBF-compressed data has been decoded directly */
                 } else {
         /* select elements & read the dataset */
         if (rank) {
@@ -3827,6 +4025,69 @@ if (CBF_SUCCESS==found) {
         else return CBF_ARGUMENT;
     }
 
+    /**
+     Flush the data and metadata of a dataset to the file, so that a process reading the file in SWMR mode
+     can see any slices appended to the dataset since the last flush.
+
+     \param ID The HDF5 dataset to be flushed.
+     \sa cbf_H5Drefresh
+     \sa cbf_h5handle_start_swmr_write
+     \return An error code.
+     */
+    int cbf_H5Dflush(const hid_t ID)
+    {
+        if (!cbf_H5Ivalid(ID) || H5I_DATASET!=H5Iget_type(ID)) return CBF_ARGUMENT;
+        return H5Dflush(ID)>=0 ? CBF_SUCCESS : CBF_H5ERROR;
+    }
+
+    /**
+     Refresh the metadata of a dataset in a file opened with <code>cbf_open_h5handle_swmr</code>, to pick up any
+     slices flushed by the writer since the dataset was opened or last refreshed.
+
+     If <code>dim</code> is given it must have space for the rank of the dataset, and the current extent of the
+     dataset is stored in it after the refresh.
+
+     \param ID The HDF5 dataset to be refreshed.
+     \param dim Optional location for the refreshed extent of the dataset.
+     \sa cbf_H5Dflush
+     \sa cbf_open_h5handle_swmr
+     \return An error code.
+     */
+    int cbf_H5Drefresh(const hid_t ID, hsize_t * const dim)
+    {
+        int error = CBF_SUCCESS;
+        if (!cbf_H5Ivalid(ID) || H5I_DATASET!=H5Iget_type(ID)) {
+            error |= CBF_ARGUMENT;
+        } else {
+            CBF_H5CALL(H5Drefresh(ID));
+            if (CBF_SUCCESS==error && dim) {
+                hid_t space = H5Dget_space(ID);
+                if (!cbf_H5Ivalid(space)) {
+                    error |= CBF_H5ERROR;
+                } else {
+                    if (H5Sget_simple_extent_dims(space,dim,0) < 0) error |= CBF_H5ERROR;
+                    H5Sclose(space);
+                }
+            }
+        }
+        return error;
+    }
+
+    /* Flush the file once the frame in the current slice completes a
+       flush interval while SWMR writing.  The whole file is flushed, so
+       that readers see the per-frame values of every dataset extended
+       for the frame together with the image */
+
+    static int cbf_h5handle_swmr_flush_frame(const cbf_h5handle h5handle)
+    {
+        if (!h5handle || h5handle->swmr < 2 || !h5handle->swmr_flush_interval
+            || (h5handle->slice+1)%h5handle->swmr_flush_interval) return CBF_SUCCESS;
+
+        cbf_h5failneg(H5Fflush(h5handle->hfile,H5F_SCOPE_LOCAL),CBF_H5ERROR);
+
+        return CBF_SUCCESS;
+    }
+
     /* Custom HDF5 types - to get the correct string type for datasets in a consistent way */
 
     /** \brief Get a HDF5 string datatype with a specified length.
@@ -17356,6 +17617,292 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
     }
 
 
+    /*
+    Release the sources of the image stack of the current entry,
+    closing any data files that are still open.
+    */
+    static int cbf_h5handle_free_framesrcs
+            (cbf_h5handle nx)
+    {
+        int error = CBF_SUCCESS;
+        size_t i;
+        for (i = 0; i < nx->num_framesrcs; ++i) {
+            cbf_h5framesrc * const src = nx->framesrcs+i;
+            if (cbf_H5Ivalid(src->dataset)) CBF_H5CALL(H5Dclose(src->dataset));
+            if (cbf_H5Ivalid(src->file)) CBF_H5CALL(H5Fclose(src->file));
+            free((void*)src->filename);
+            free((void*)src->path);
+        }
+        free((void*)nx->framesrcs);
+        nx->framesrcs = NULL;
+        nx->num_framesrcs = 0;
+        nx->num_open_files = 0;
+        nx->framedims[0] = nx->framedims[1] = nx->framedims[2] = 0;
+        return error;
+    }
+
+    /*
+    A compiled plan for converting a fixed-geometry series of miniCBF frames.
+    The header of the first frame, less its per-frame values, is kept as a
+    signature; a later frame with the same signature only needs its
+    per-frame values appended to the datasets held open here.
+    */
+#define CBF_MINICBF_H5PLAN_MAX 16
+    struct cbf_minicbf_h5plan
+    {
+        const cbf_config_t * config; /* The configuration the plan was compiled for */
+        char * signature;            /* The header without its per-frame values */
+        char * saturation_value;     /* The count cutoff of the series, or NULL */
+        char * start_time;           /* The earliest frame time written */
+        char * end_time;             /* The latest frame time written */
+        size_t num_items;            /* The number of per-frame values */
+        const char * keywords[CBF_MINICBF_H5PLAN_MAX]; /* The header keyword of each value */
+        hid_t datasets[CBF_MINICBF_H5PLAN_MAX];        /* The dataset receiving each value */
+        int stokes[CBF_MINICBF_H5PLAN_MAX];  /* Set for a polarisation written as Stokes parameters */
+        hid_t rotation;              /* The detector rotation, which has a fixed value */
+    };
+
+    /*
+    Free a compiled miniCBF conversion plan, closing its datasets.
+    */
+    static int _cbf_free_minicbf_h5plan
+            (struct cbf_minicbf_h5plan * const plan)
+    {
+        int error = CBF_SUCCESS;
+        size_t i;
+        if (!plan) return CBF_SUCCESS;
+        for (i = 0; i < plan->num_items; ++i) {
+            if (cbf_H5Ivalid(plan->datasets[i])) CBF_H5CALL(H5Dclose(plan->datasets[i]));
+        }
+        if (cbf_H5Ivalid(plan->rotation)) CBF_H5CALL(H5Dclose(plan->rotation));
+        free((void*)plan->signature);
+        free((void*)plan->saturation_value);
+        free((void*)plan->start_time);
+        free((void*)plan->end_time);
+        free((void*)plan);
+        return error;
+    }
+
+    /*
+    The cells of the CBF handle filled by cbf_select_h5frame that hold a
+    value of the current frame, noted while its first frame is converted.
+    Later frames refresh only these cells from the datasets they were read
+    from, rather than converting all of the metadata again.
+    */
+#define CBF_H5FRAME_REAL    1
+#define CBF_H5FRAME_INTEGER 2
+#define CBF_H5FRAME_TEXT    3
+#define CBF_H5FRAME_NUMBER  4
+#define CBF_H5FRAME_IMAGE   5
+    typedef struct
+    {
+        cbf_node * column;   /* The column of the cell */
+        unsigned int row;    /* The row of the cell */
+        int kind;            /* CBF_H5FRAME_REAL, _INTEGER, _TEXT, _NUMBER or _IMAGE */
+        hid_t dataset;       /* The dataset read, or CBF_H5FAIL for the frame number */
+        const char * format; /* The format of a real value */
+        double factor;       /* The scale of a real value */
+        hid_t type;          /* The native type of an image */
+        hsize_t count[4];    /* The hyperslab of an image */
+        size_t nelems;       /* The number of elements of an image */
+        int rank;            /* The rank of the image stack */
+        int binary_id;       /* The binary id of an image */
+    } cbf_h5frame_cell;
+
+    struct cbf_h5frame_cells
+    {
+        cbf_h5frame_cell * cell;
+        size_t cells, size;
+        hid_t pending;       /* A per-frame dataset read but not yet noted */
+        int recording;       /* Set while the first frame is converted */
+        int full;            /* Set if a per-frame value has no cell, so
+                                that every frame must be converted in full */
+    };
+
+    /*
+    Free the cells of the CBF handle of cbf_select_h5frame.
+    */
+    static int cbf_h5handle_free_frame_cells
+            (cbf_h5handle nx)
+    {
+        int error = CBF_SUCCESS;
+        struct cbf_h5frame_cells * const cells = nx->nxframe_cells;
+        size_t i;
+        if (!cells) return CBF_SUCCESS;
+        for (i = 0; i < cells->cells; ++i) {
+            cbf_h5frame_cell * const cell = cells->cell+i;
+            if (cbf_H5Ivalid(cell->dataset)) CBF_H5CALL(H5Idec_ref(cell->dataset));
+            if (cbf_H5Ivalid(cell->type)) CBF_H5CALL(H5Tclose(cell->type));
+        }
+        free((void*)cells->cell);
+        free((void*)cells);
+        nx->nxframe_cells = NULL;
+        return error;
+    }
+
+    /*
+    Forget a CBF handle that is freed or refilled, so that its cells and
+    values left null are no longer taken from this HDF5 file.
+    */
+    static void cbf_h5handle_release
+            (cbf_handle cbf,
+             void * context)
+    {
+        cbf_h5handle nx = (cbf_h5handle)context;
+        if (nx->nxframe_cbf == cbf) {
+            cbf_h5handle_free_frame_cells(nx);
+            nx->nxframe_cbf = NULL;
+        }
+        if (nx->nxlazy_cbf == cbf) nx->nxlazy_cbf = NULL;
+    }
+
+    /*
+    Detach a CBF handle from the HDF5 file, if any, whose values it holds.
+    */
+    static void cbf_h5handle_detach
+            (cbf_handle cbf)
+    {
+        cbf_deferred_source * const deferred = cbf->deferred;
+        cbf->deferred = NULL;
+        if (deferred && deferred->release) deferred->release(cbf,deferred->context);
+    }
+
+    /*
+    Attach a CBF handle read lazily from this HDF5 file, so that the values
+    it leaves null are read when they are needed.  Only the handle last
+    read lazily is attached.
+    */
+    static void cbf_h5handle_attach_lazy
+            (cbf_h5handle nx,
+             cbf_handle cbf)
+    {
+        if (nx->nxlazy_cbf == cbf && cbf->deferred == &nx->deferred) return;
+        cbf_h5handle_detach(cbf);
+        if (nx->nxlazy_cbf) cbf_h5handle_detach(nx->nxlazy_cbf);
+        nx->nxlazy_cbf = cbf;
+        cbf->deferred = &nx->deferred;
+    }
+
+    /*
+    Read the value of an image stack left null by a lazy cbf_read_h5file,
+    at the current row and column of the CBF handle.  The dataset is found
+    again from the address recorded with it, and stored as an eager read
+    would have stored it.
+    */
+    static int cbf_h5handle_resolve_cell
+            (cbf_handle handle,
+             cbf_h5handle nx)
+    {
+        int error = CBF_SUCCESS;
+        cbf_node * column = NULL;
+        cbf_node * category = NULL;
+        const char * typeofvalue = NULL;
+        const char * text = NULL;
+        char * name = NULL;
+        char * parent_name = NULL;
+        haddr_t addr = 0;
+        unsigned int row;
+        if (cbf_find_parent(&column,handle->node,CBF_COLUMN)
+            || cbf_find_parent(&category,column,CBF_CATEGORY)
+            || !column->name || cbf_cistrcmp(column->name,"value")
+            || !category->name || cbf_cistrcmp(category->name,"H5_Datasets")
+            || handle->row < 0 || (unsigned int)handle->row >= column->children
+            || cbf_get_typeofvalue(handle,&typeofvalue)
+            || !typeofvalue || strcmp(typeofvalue,"null")) return CBF_SUCCESS;
+        row = handle->row;
+        /* the name, parent and address noted by cbf_h5ds_store_deferred */
+        CBF_CALL(cbf_find_column(handle,"parent_id"));
+        CBF_CALL(cbf_get_value(handle,&text));
+        if (CBF_SUCCESS==error) {
+            if (!text) error |= CBF_NOTFOUND;
+            else addr = (haddr_t)strtoul(text,NULL,0);
+        }
+        CBF_CALL(cbf_find_column(handle,"id"));
+        CBF_CALL(cbf_get_value(handle,&text));
+        if (CBF_SUCCESS==error && !(name = _cbf_strdup(text?text:""))) error |= CBF_ALLOC;
+        CBF_CALL(cbf_find_column(handle,"parent_name"));
+        CBF_CALL(cbf_get_value(handle,&text));
+        if (CBF_SUCCESS==error && !(parent_name = _cbf_strdup(text?text:""))) error |= CBF_ALLOC;
+        if (CBF_SUCCESS==error) {
+            hid_t dataset = H5Oopen_by_addr(nx->hfile,addr);
+            hid_t space = CBF_H5FAIL;
+            hid_t type = CBF_H5FAIL;
+            void * value = NULL;
+            if (!cbf_H5Ivalid(dataset) || H5I_DATASET!=H5Iget_type(dataset)) {
+                cbf_debug_print2("error: couldn't reopen dataset '%s'\n",name);
+                error |= CBF_H5ERROR;
+            } else if (!cbf_H5Ivalid(space = H5Dget_space(dataset))
+                       || !cbf_H5Ivalid(type = H5Dget_type(dataset))) {
+                error |= CBF_H5ERROR;
+            } else {
+                handle->node = column;
+                error |= cbf_h5ds_store(handle,addr,parent_name,row,"H5_Datasets",
+                                        dataset,space,type,name,0,&value);
+                if (value) cbf_free(&value,NULL);
+            }
+            cbf_H5Tfree(type);
+            cbf_H5Sfree(space);
+            if (cbf_H5Ivalid(dataset)) H5Oclose(dataset);
+        }
+        free((void*)name);
+        free((void*)parent_name);
+        handle->node = column;
+        handle->row = row;
+        return error;
+    }
+
+    /*
+    Read every value left null by a lazy cbf_read_h5file below a node.
+    */
+    static int cbf_h5handle_resolve_node
+            (cbf_handle handle,
+             cbf_h5handle nx,
+             cbf_node * node)
+    {
+        int error = CBF_SUCCESS;
+        unsigned int i;
+        if (CBF_CATEGORY==node->type) {
+            cbf_node * column = NULL;
+            if (!node->name || cbf_cistrcmp(node->name,"H5_Datasets")
+                || cbf_find_child(&column,node,"value")) return CBF_SUCCESS;
+            for (i = 0; CBF_SUCCESS==error && i < column->children; ++i) {
+                handle->node = column;
+                handle->row = i;
+                CBF_CALL(cbf_h5handle_resolve_cell(handle,nx));
+            }
+        } else if (CBF_ROOT==node->type || CBF_DATABLOCK==node->type
+                   || CBF_SAVEFRAME==node->type) {
+            for (i = 0; CBF_SUCCESS==error && i < node->children; ++i) {
+                CBF_CALL(cbf_h5handle_resolve_node(handle,nx,node->child[i]));
+            }
+        }
+        return error;
+    }
+
+    /*
+    Read the values of image stacks left null by a lazy cbf_read_h5file,
+    when the CBF handle is used by calls that expect a full read: the
+    value at the current row and column, or all of them.
+    */
+    static int cbf_h5handle_resolve
+            (cbf_handle handle,
+             void * context,
+             int all)
+    {
+        int error = CBF_SUCCESS;
+        cbf_h5handle nx = (cbf_h5handle)context;
+        cbf_node * node = handle->node;
+        const int row = handle->row;
+        cbf_node * root = NULL;
+        if (nx->nxlazy_cbf != handle) return CBF_SUCCESS;
+        if (!all) return cbf_h5handle_resolve_cell(handle,nx);
+        CBF_CALL(cbf_find_parent(&root,node,CBF_ROOT));
+        CBF_CALL(cbf_h5handle_resolve_node(handle,nx,root));
+        handle->node = node;
+        handle->row = row;
+        return error;
+    }
+
     /**
      Checks if the handle appears to be valid, the free's the handle and any data that the handle owns.
      \param h5handle The handle to be free'd.
@@ -17375,6 +17922,10 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
 
             /* cbf_debug_print("Entering cbf_free_h5handle"); */
 
+            if (h5handle->nxframe_cbf) cbf_h5handle_detach(h5handle->nxframe_cbf);
+
+            if (h5handle->nxlazy_cbf) cbf_h5handle_detach(h5handle->nxlazy_cbf);
+
             if (cbf_H5Ivalid(h5handle->colid)) {
                 CBF_H5CALL(H5Gclose(h5handle->colid));
             }
@@ -17403,6 +17954,10 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                 CBF_H5CALL(H5Gclose(h5handle->dataid));
             }
 
+            error |= cbf_h5handle_free_framesrcs(h5handle);
+
+            error |= _cbf_free_minicbf_h5plan(h5handle->minicbf_plan);
+
             if (cbf_H5Ivalid(h5handle->nxid)) {
                 CBF_H5CALL(H5Gclose(h5handle->nxid));
             }
@@ -17547,6 +18102,20 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
         (*h5handle)->nxsource = (hid_t)CBF_H5FAIL;
         (*h5handle)->curnxid = (hid_t)CBF_H5FAIL;
         (*h5handle)->dataid  = (hid_t)CBF_H5FAIL;
+        (*h5handle)->framesrcs  = NULL;
+        (*h5handle)->num_framesrcs  = 0;
+        (*h5handle)->framedims[0] = (*h5handle)->framedims[1] = (*h5handle)->framedims[2] = 0;
+        (*h5handle)->max_open_files  = 8;
+        (*h5handle)->num_open_files  = 0;
+        (*h5handle)->framesrc_clock  = 0;
+        (*h5handle)->minicbf_plan  = NULL;
+        (*h5handle)->deferred.resolve  = cbf_h5handle_resolve;
+        (*h5handle)->deferred.release  = cbf_h5handle_release;
+        (*h5handle)->deferred.context  = (void *)*h5handle;
+        (*h5handle)->nxlazy_cbf  = NULL;
+        (*h5handle)->nxframe_cbf  = NULL;
+        (*h5handle)->nxframe  = 0;
+        (*h5handle)->nxframe_cells  = NULL;
         (*h5handle)->nxid_name = NULL;
         (*h5handle)->nxdetector_group_name = NULL;
         (*h5handle)->nxdetector_names = NULL;
@@ -17561,6 +18130,8 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
         (*h5handle)->catid_name = NULL;
         (*h5handle)->colid_name = NULL;
         (*h5handle)->rwmode  = 0;
+        (*h5handle)->swmr  = 0;
+        (*h5handle)->swmr_flush_interval  = 0;
         (*h5handle)->flags = 0;
 #ifdef CBF_USE_ULP
         (*h5handle)->cmp_double_as_float = 0;
@@ -17968,12 +18539,11 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
 
     }
 
-    /* Create an HDF5 File handle without adding an CBF_cbf group to it */
+    /* Mark the root of a new H5File handle as an NXroot written by CBFlib,
+       with the library version and revision as creator_version */
 
-    int cbf_create_h5handle2(cbf_h5handle *h5handle,const char * h5filename)
+    static int cbf_h5handle_require_creator(cbf_h5handle h5handle)
     {
-        hid_t fcreate_prop_list;
-
         char verstring[] = CBF_VERS_STRING;
 
         char svnrev[] = CBF_SVN_REVISION_STRING;
@@ -17986,28 +18556,9 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
 
         int error = CBF_SUCCESS;
 
-        cbf_failnez(cbf_make_h5handle(h5handle));
-
-        cbf_h5onfailneg(fcreate_prop_list = H5Pcreate(H5P_FILE_ACCESS),
-                        CBF_ALLOC,cbf_free((void**) h5handle, NULL));
-
-        (*h5handle)->rwmode = 1;
-
-        cbf_h5onfailneg(H5Pset_fclose_degree(fcreate_prop_list,H5F_CLOSE_STRONG),
-                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
-
-        cbf_h5onfailneg((*h5handle)->hfile = H5Fcreate(h5filename,H5F_ACC_TRUNC,
-                                                       H5P_DEFAULT,fcreate_prop_list),
-                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
-
-        cbf_h5onfailneg(H5Pclose(fcreate_prop_list), CBF_ARGUMENT,
-                        cbf_free((void**) h5handle, NULL));
+        CBF_CALL(cbf_H5Arequire_string(h5handle->hfile,"NX_class","NXroot"));
+        CBF_CALL(cbf_H5Arequire_string(h5handle->hfile,"creator","CBFlib"));
 
-        CBF_CALL(cbf_H5Arequire_string((*h5handle)->hfile,"NX_class","NXroot"));
-        CBF_CALL(cbf_H5Arequire_string((*h5handle)->hfile,"creator","CBFlib"));
-        buffer[0] = '\0';
-
-        strncat(buffer,verstring,50);
         for (ii=_cbf_strlen(svnrev)-1; ii >= 0; ii--) {
             if (svnrev[ii] == '$' || svnrev[ii] == ' ') {
                 svnrev[ii] = '\0';
@@ -18037,34 +18588,52 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
             }
         }
 
-        strncat(buffer," (r",3);
-        strncat(buffer,svnrev+irev,10);
-        strncat(buffer,") ",2);
-        strncat(buffer,svndate+idate,50);
-        CBF_CALL(cbf_H5Arequire_string((*h5handle)->hfile,"creator_version", 
-            buffer));
-
-        cbf_failnez(cbf_require_h5handle_filename(*h5handle));
+        snprintf(buffer,sizeof buffer,"%.50s (r%.10s) %.50s",
+                 verstring,svnrev+irev,svndate+idate);
+        CBF_CALL(cbf_H5Arequire_string(h5handle->hfile,"creator_version",
+                                       buffer));
 
         return error;
     }
 
-    /* Create an HDF5 File handle without adding a CBF_cbf group to it
-       in update mode*/
+    /* Create an HDF5 File handle without adding an CBF_cbf group to it */
 
-    int cbf_create_h5handle2u(cbf_h5handle *h5handle,const char * h5filename)
+    int cbf_create_h5handle2(cbf_h5handle *h5handle,const char * h5filename)
     {
         hid_t fcreate_prop_list;
 
-        char verstring[] = CBF_VERS_STRING;
+        int error = CBF_SUCCESS;
 
-        char svnrev[] = CBF_SVN_REVISION_STRING;
+        cbf_failnez(cbf_make_h5handle(h5handle));
 
-        char svndate[] = CBF_SVN_DATE_STRING;
+        cbf_h5onfailneg(fcreate_prop_list = H5Pcreate(H5P_FILE_ACCESS),
+                        CBF_ALLOC,cbf_free((void**) h5handle, NULL));
 
-        char buffer[140] = {0};
+        (*h5handle)->rwmode = 1;
 
-        int ii, irev, idate;
+        cbf_h5onfailneg(H5Pset_fclose_degree(fcreate_prop_list,H5F_CLOSE_STRONG),
+                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        cbf_h5onfailneg((*h5handle)->hfile = H5Fcreate(h5filename,H5F_ACC_TRUNC,
+                                                       H5P_DEFAULT,fcreate_prop_list),
+                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        cbf_h5onfailneg(H5Pclose(fcreate_prop_list), CBF_ARGUMENT,
+                        cbf_free((void**) h5handle, NULL));
+
+        CBF_CALL(cbf_h5handle_require_creator(*h5handle));
+
+        cbf_failnez(cbf_require_h5handle_filename(*h5handle));
+
+        return error;
+    }
+
+    /* Create an HDF5 File handle without adding a CBF_cbf group to it
+       in update mode*/
+
+    int cbf_create_h5handle2u(cbf_h5handle *h5handle,const char * h5filename)
+    {
+        hid_t fcreate_prop_list;
 
         int error = CBF_SUCCESS;
 
@@ -18085,52 +18654,111 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
         cbf_h5onfailneg(H5Pclose(fcreate_prop_list), CBF_ARGUMENT,
                         cbf_free((void**) h5handle, NULL));
 
-        CBF_CALL(cbf_H5Arequire_string((*h5handle)->hfile,"NX_class","NXroot"));
-        CBF_CALL(cbf_H5Arequire_string((*h5handle)->hfile,"creator","CBFlib"));
-        buffer[0] = '\0';
+        CBF_CALL(cbf_h5handle_require_creator(*h5handle));
+
+        cbf_failnez(cbf_require_h5handle_filename(*h5handle));
+
+        return error;
+    }
+
+    /* Create an HDF5 File handle without adding a CBF_cbf group to it,
+       using the latest file format so that SWMR writing can be started
+       with cbf_h5handle_start_swmr_write.  If update is non-zero, an
+       existing file is opened read-write instead of being truncated;
+       that file must also have been created with the latest format */
+
+    int cbf_create_h5handle2_swmr(cbf_h5handle *h5handle,const char * h5filename,
+                                  const int update)
+    {
+        hid_t fcreate_prop_list;
+
+        int error = CBF_SUCCESS;
+
+        if (!h5handle || !h5filename) return CBF_ARGUMENT;
+
+        cbf_failnez(cbf_make_h5handle(h5handle));
+
+        cbf_h5onfailneg(fcreate_prop_list = H5Pcreate(H5P_FILE_ACCESS),
+                        CBF_ALLOC,cbf_free((void**) h5handle, NULL));
+
+        (*h5handle)->rwmode = 1;
+
+        (*h5handle)->swmr = 1;
+
+        cbf_h5onfailneg(H5Pset_fclose_degree(fcreate_prop_list,H5F_CLOSE_STRONG),
+                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        /* SWMR needs the file format introduced with HDF5 1.10 */
+
+        cbf_h5onfailneg(H5Pset_libver_bounds(fcreate_prop_list,H5F_LIBVER_LATEST,
+                                             H5F_LIBVER_LATEST),
+                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        if (update) {
+
+            cbf_h5onfailneg((*h5handle)->hfile = H5Fopen(h5filename, H5F_ACC_RDWR,
+                                                         fcreate_prop_list),
+                            CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        } else {
+
+            cbf_h5onfailneg((*h5handle)->hfile = H5Fcreate(h5filename,H5F_ACC_TRUNC,
+                                                           H5P_DEFAULT,fcreate_prop_list),
+                            CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
 
-        strncat(buffer,verstring,50);
-        for (ii=_cbf_strlen(svnrev)-1; ii >= 0; ii--) {
-            if (svnrev[ii] == '$' || svnrev[ii] == ' ') {
-                svnrev[ii] = '\0';
-            } else break;
-        }
-        irev = 0;
-        if (_cbf_strlen(svnrev)>0 && svnrev[0]=='$') irev++;
-        for (ii=0; ii < (ssize_t)_cbf_strlen(svnrev); ii++) {
-            if (svnrev[ii]==':') {
-                irev = ii+1;
-                if (ii < (ssize_t)_cbf_strlen(svnrev)-1 && svnrev[ii+1]==' ') irev++;
-                break;
-            }
-        }
-        for (ii=_cbf_strlen(svndate)-1; ii >= 0; ii--) {
-            if (svndate[ii] == '$' || svndate[ii] == ' ') {
-                svndate[ii] = '\0';
-            } else break;
-        }
-        idate = 0;
-        if (_cbf_strlen(svndate)>0 && svndate[0]=='$') idate++;
-        for (ii=0; ii < (ssize_t)_cbf_strlen(svndate); ii++) {
-            if (svndate[ii]==':') {
-                idate = ii+1;
-                if (ii < (ssize_t)_cbf_strlen(svndate)-1 && svndate[ii]==' ') idate++;
-                break;
-            }
         }
 
-        strncat(buffer," (r",3);
-        strncat(buffer,svnrev+irev,10);
-        strncat(buffer,") ",2);
-        strncat(buffer,svndate+idate,50);
-        CBF_CALL(cbf_H5Arequire_string((*h5handle)->hfile,"creator_version",
-                                       buffer));
+        cbf_h5onfailneg(H5Pclose(fcreate_prop_list), CBF_ARGUMENT,
+                        cbf_free((void**) h5handle, NULL));
+
+        CBF_CALL(cbf_h5handle_require_creator(*h5handle));
 
         cbf_failnez(cbf_require_h5handle_filename(*h5handle));
 
         return error;
     }
 
+    /* Start single-writer/multiple-reader writing on an H5File handle
+       created with cbf_create_h5handle2_swmr.
+
+       SWMR readers cannot see objects created after writing has started,
+       so all the groups and datasets must already exist, normally by
+       writing the first frame before calling this function.  Afterwards
+       only slices may be appended to the existing datasets.  The file,
+       with every dataset extended for a frame, is flushed every
+       flush_interval frames; 0 leaves flushing to
+       the caller through cbf_h5handle_flush */
+
+    int cbf_h5handle_start_swmr_write(cbf_h5handle h5handle,
+                                      const unsigned int flush_interval)
+    {
+        if (!h5handle || !cbf_H5Ivalid(h5handle->hfile)
+            || !h5handle->rwmode || !h5handle->swmr) return CBF_ARGUMENT;
+
+        if (h5handle->swmr < 2) {
+
+            cbf_h5failneg(H5Fstart_swmr_write(h5handle->hfile),CBF_H5ERROR);
+
+            h5handle->swmr = 2;
+
+        }
+
+        h5handle->swmr_flush_interval = flush_interval;
+
+        return CBF_SUCCESS;
+    }
+
+    /* Flush the file of an H5File handle */
+
+    int cbf_h5handle_flush(cbf_h5handle h5handle)
+    {
+        if (!h5handle || !cbf_H5Ivalid(h5handle->hfile)) return CBF_ARGUMENT;
+
+        cbf_h5failneg(H5Fflush(h5handle->hfile,H5F_SCOPE_LOCAL),CBF_H5ERROR);
+
+        return CBF_SUCCESS;
+    }
+
 
     /**
      This function expects the user to create or open a hdf5 file with the appropriate parameters for what they are
@@ -18333,6 +18961,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
             key->xdim = 0;
             key->ydim = 0;
             key->zdim = 0;
+            key->mapped = 0;
             key->axisData = NULL;
             for (ii=0; ii < CBF_NX2CBF_HASH_BINS; ii++) {
                 (key->axispathhash)[ii] = (key->axisnamehash)[ii] = (key->axisobjecthash)[ii] = NULL;
@@ -18496,6 +19125,303 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
         return error;
     }
 
+    /*
+     The offset of the current frame in a dataset of dim values, one per
+     frame, or 0 for a single value.  While the first frame is converted by
+     cbf_select_h5frame, a per-frame dataset is held until the value read
+     from it is stored, to note the cell it is stored in.
+     */
+    static hsize_t _cbf_nx2cbf_frame_offset
+    (const cbf_h5handle nx,
+     const hid_t dataset,
+     const hsize_t dim)
+    {
+        struct cbf_h5frame_cells * const cells = nx->nxframe_cells;
+        if (dim < 2) return 0;
+        if (cells && cells->recording) {
+            /* the value of the last one was never stored in a cell of its own */
+            if (cbf_H5Ivalid(cells->pending)) cells->full = 1;
+            cells->pending = dataset;
+        }
+        return nx->slice;
+    }
+
+    /*
+     Note the current cell of the CBF handle as holding a value of the
+     current frame read from the given dataset.
+     */
+    static int _cbf_nx2cbf_add_frame_cell
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const int kind,
+     const hid_t dataset,
+     cbf_h5frame_cell * * const note)
+    {
+        struct cbf_h5frame_cells * const cells = nx->nxframe_cells;
+        cbf_h5frame_cell * cell = NULL;
+        cbf_node * column = NULL;
+        *note = NULL;
+        if (!cells || !cells->recording) return CBF_SUCCESS;
+        cbf_failnez(cbf_find_parent(&column,cbf->node,CBF_COLUMN));
+        if (cells->cells == cells->size) {
+            const size_t size = cells->size ? 2*cells->size : 16;
+            if (!(cell = (cbf_h5frame_cell *)realloc(cells->cell,size*sizeof(cbf_h5frame_cell)))) return CBF_ALLOC;
+            cells->cell = cell;
+            cells->size = size;
+        }
+        if (cbf_H5Ivalid(dataset) && H5Iinc_ref(dataset) < 0) return CBF_H5ERROR;
+        cell = cells->cell+cells->cells++;
+        memset(cell,0,sizeof(cbf_h5frame_cell));
+        cell->column = column;
+        cell->row = cbf->row;
+        cell->kind = kind;
+        cell->dataset = dataset;
+        cell->factor = 1.;
+        cell->type = CBF_H5FAIL;
+        *note = cell;
+        return CBF_SUCCESS;
+    }
+
+    /*
+     Note the current cell of the CBF handle as holding the value just
+     read from the pending per-frame dataset, if any.
+     */
+    static int _cbf_nx2cbf_frame_cell
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const int kind,
+     cbf_h5frame_cell * * const note)
+    {
+        struct cbf_h5frame_cells * const cells = nx->nxframe_cells;
+        hid_t dataset = CBF_H5FAIL;
+        *note = NULL;
+        if (!cells || !cells->recording || !cbf_H5Ivalid(cells->pending)) return CBF_SUCCESS;
+        dataset = cells->pending;
+        cells->pending = CBF_H5FAIL;
+        return _cbf_nx2cbf_add_frame_cell(nx,cbf,kind,dataset,note);
+    }
+
+    /*
+     Store a real value, possibly one of the current frame, in the current cell.
+     */
+    static int _cbf_nx2cbf_set_frame_real
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const char * const format,
+     const double factor,
+     const double value)
+    {
+        int error = CBF_SUCCESS;
+        cbf_h5frame_cell * cell = NULL;
+        CBF_CALL(cbf_set_doublevalue(cbf,format,factor*value));
+        CBF_CALL(_cbf_nx2cbf_frame_cell(nx,cbf,CBF_H5FRAME_REAL,&cell));
+        if (cell) {
+            cell->format = format;
+            cell->factor = factor;
+        }
+        return error;
+    }
+
+    /*
+     Store an integer value, possibly one of the current frame, in the current cell.
+     */
+    static int _cbf_nx2cbf_set_frame_integer
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const long value)
+    {
+        int error = CBF_SUCCESS;
+        cbf_h5frame_cell * cell = NULL;
+        CBF_CALL(cbf_set_integervalue(cbf,value));
+        CBF_CALL(_cbf_nx2cbf_frame_cell(nx,cbf,CBF_H5FRAME_INTEGER,&cell));
+        return error;
+    }
+
+    /*
+     Store a string, possibly one of the current frame, in the current cell.
+     */
+    static int _cbf_nx2cbf_set_frame_text
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const char * const value)
+    {
+        int error = CBF_SUCCESS;
+        cbf_h5frame_cell * cell = NULL;
+        CBF_CALL(cbf_set_value(cbf,value));
+        CBF_CALL(_cbf_nx2cbf_frame_cell(nx,cbf,CBF_H5FRAME_TEXT,&cell));
+        return error;
+    }
+
+    /*
+     Store the number of the current frame, counted from 1, in the current cell.
+     */
+    static int _cbf_nx2cbf_set_frame_number
+    (const cbf_h5handle nx,
+     const cbf_handle cbf)
+    {
+        int error = CBF_SUCCESS;
+        cbf_h5frame_cell * cell = NULL;
+        CBF_CALL(cbf_set_integervalue(cbf,1+nx->slice));
+        CBF_CALL(_cbf_nx2cbf_add_frame_cell(nx,cbf,CBF_H5FRAME_NUMBER,CBF_H5FAIL,&cell));
+        return error;
+    }
+
+    /* The frame map of an image stack spread over several datasets */
+    static int cbf_h5handle_map_frames
+            (cbf_h5handle nx);
+    static int cbf_h5handle_read_frames
+            (cbf_h5handle nx,
+             const hsize_t frame,
+             const hsize_t n,
+             void * const array,
+             const hid_t memtype);
+
+    /*
+     Read a frame of an image stack and store it in the current cell,
+     compressed with byte offsets.  The count gives the size of the frame,
+     with 1 for the frame dimension.  An invalid data reads the frame
+     through the frame map of the h5handle.
+     */
+    static int _cbf_nx2cbf_frame_image
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const hid_t data,
+     const hid_t native_type,
+     const hsize_t * const count,
+     const size_t nelems,
+     const int rank,
+     const int binary_id,
+     const hsize_t frame)
+    {
+        int error = CBF_SUCCESS;
+        hsize_t offset[4];
+        const size_t elem_size = H5Tget_size(native_type);
+        const H5T_class_t classtype = H5Tget_class(native_type);
+        const H5T_order_t h5order = H5Tget_order(native_type);
+        const H5T_sign_t h5sign = H5Tget_sign(native_type);
+        const char * const byte_order = H5T_ORDER_LE==h5order ? "little_endian"
+                                      : H5T_ORDER_BE==h5order ? "big_endian" : NULL;
+        void * array = malloc(nelems*elem_size);
+        if (!array) return CBF_ALLOC;
+        if (cbf_H5Ivalid(data)) {
+            offset[0] = frame;
+            offset[1] = offset[2] = offset[3] = 0;
+            CBF_CALL(cbf_H5Dread2(data,offset,0,count,array,native_type));
+        } else {
+            CBF_CALL(cbf_h5handle_read_frames(nx,frame,1,array,native_type));
+        }
+        if (classtype == H5T_INTEGER) {
+            CBF_CALL(cbf_set_integerarray_wdims_fs(cbf,
+                                                   CBF_BYTE_OFFSET,
+                                                   binary_id,
+                                                   array,
+                                                   elem_size,
+                                                   H5T_SGN_2==h5sign ? 1 : 0,
+                                                   nelems,
+                                                   byte_order,
+                                                   rank > 1?count[rank-1]:0,
+                                                   rank > 2?count[rank-2]:0,
+                                                   rank > 3?count[rank-3]:0,
+                                                   0));
+        } else if (classtype == H5T_FLOAT) {
+            CBF_CALL(cbf_set_realarray_wdims_fs(cbf,
+                                                CBF_BYTE_OFFSET,
+                                                binary_id,
+                                                array,
+                                                elem_size,
+                                                nelems,
+                                                byte_order,
+                                                rank > 1?count[rank-1]:0,
+                                                rank > 2?count[rank-2]:0,
+                                                rank > 3?count[rank-3]:0,
+                                                0));
+        } else {
+            cbf_debug_print("Usupported array type");
+            error |= CBF_NOTIMPLEMENTED;
+        }
+        free((void*)array);
+        return error;
+    }
+
+    /*
+     Store a frame of an image stack in the current cell, noting the cell.
+     */
+    static int _cbf_nx2cbf_set_frame_image
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const hid_t data,
+     const hid_t native_type,
+     const hsize_t * const count,
+     const size_t nelems,
+     const int rank,
+     const int binary_id)
+    {
+        int error = CBF_SUCCESS;
+        cbf_h5frame_cell * cell = NULL;
+        CBF_CALL(_cbf_nx2cbf_frame_image(nx,cbf,data,native_type,count,nelems,rank,binary_id,nx->slice));
+        CBF_CALL(_cbf_nx2cbf_add_frame_cell(nx,cbf,CBF_H5FRAME_IMAGE,data,&cell));
+        if (cell) {
+            if (!cbf_H5Ivalid(cell->type = H5Tcopy(native_type))) error |= CBF_H5ERROR;
+            memcpy(cell->count,count,sizeof(cell->count));
+            cell->nelems = nelems;
+            cell->rank = rank;
+            cell->binary_id = binary_id;
+        }
+        return error;
+    }
+
+    /*
+     Refresh the cells of the CBF handle of cbf_select_h5frame that hold
+     values of the current frame, reading them for another frame.
+     */
+    static int _cbf_nx2cbf_refresh_frame
+    (const cbf_h5handle nx,
+     const cbf_handle cbf,
+     const unsigned int frame)
+    {
+        int error = CBF_SUCCESS;
+        struct cbf_h5frame_cells * const cells = nx->nxframe_cells;
+        cbf_node * const node = cbf->node;
+        const int row = cbf->row;
+        const hsize_t offset[] = {frame};
+        const hsize_t count[] = {1};
+        size_t i;
+        for (i = 0; CBF_SUCCESS==error && i < cells->cells; ++i) {
+            const cbf_h5frame_cell * const cell = cells->cell+i;
+            cbf->node = cell->column;
+            cbf->row = cell->row;
+            if (CBF_H5FRAME_REAL==cell->kind) {
+                double value = 0.;
+                CBF_CALL(cbf_H5Dread2(cell->dataset,offset,0,count,&value,H5T_NATIVE_DOUBLE));
+                CBF_CALL(cbf_set_doublevalue(cbf,cell->format,cell->factor*value));
+            } else if (CBF_H5FRAME_INTEGER==cell->kind) {
+                long value = 0;
+                CBF_CALL(cbf_H5Dread2(cell->dataset,offset,0,count,&value,H5T_NATIVE_LONG));
+                CBF_CALL(cbf_set_integervalue(cbf,value));
+            } else if (CBF_H5FRAME_TEXT==cell->kind) {
+                char * value = NULL;
+                hid_t vlstr = CBF_H5FAIL;
+                hid_t space = CBF_H5FAIL;
+                CBF_CALL(cbf_H5Tcreate_string(&vlstr,H5T_VARIABLE));
+                CBF_CALL(cbf_H5Dread2(cell->dataset,offset,0,count,&value,vlstr));
+                CBF_CALL(cbf_set_value(cbf,value));
+                if (value && cbf_H5Ivalid(space = H5Screate_simple(1,count,0))) {
+                    H5Dvlen_reclaim(vlstr,space,H5P_DEFAULT,&value);
+                }
+                cbf_H5Sfree(space);
+                cbf_H5Tfree(vlstr);
+            } else if (CBF_H5FRAME_NUMBER==cell->kind) {
+                CBF_CALL(cbf_set_integervalue(cbf,1+frame));
+            } else if (CBF_H5FRAME_IMAGE==cell->kind) {
+                CBF_CALL(_cbf_nx2cbf_frame_image(nx,cbf,cell->dataset,cell->type,cell->count,
+                                                 cell->nelems,cell->rank,cell->binary_id,frame));
+            }
+        }
+        cbf->node = node;
+        cbf->row = row;
+        return error;
+    }
+
     /*
      Declare a bunch of table manipulation functions, because they call each other to ensure everything is defined.
      TODO: Update these to return successfully if a row with the given keys already exists,
@@ -18974,7 +19900,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                 CBF_CALL(cbf_require_column(cbf,"scan_id"));
                 CBF_CALL(cbf_set_value(cbf,table->scan_id));
                 CBF_CALL(cbf_require_column(cbf,"frame_number"));
-                CBF_CALL(cbf_set_integervalue(cbf,1+nx->slice));
+                CBF_CALL(_cbf_nx2cbf_set_frame_number(nx,cbf));
 
                 /* ensure foreign keys are well-defined */
                 CBF_CALL(_cbf_nx2cbf_table__diffrn_scan(cbf,nx,table));
@@ -19187,7 +20113,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                 } else {
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
         }
@@ -19209,7 +20135,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                             CBF_CALL(_cbf_nx2cbf_table__diffrn_detector_element(cbf,nx,table));
                             CBF_CALL(cbf_require_column(cbf,"center[1]"));
                             /* write the data */
-                            CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",factor*value));
+                            CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",factor,value));
                         }
                         cbf_H5Sfree(data_space);
                         /*-----------------------------------------------------------------------------------------------*/
@@ -19237,7 +20163,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                 } else {
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                 }
@@ -19259,7 +20185,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                             CBF_CALL(_cbf_nx2cbf_table__diffrn_detector_element(cbf,nx,table));
                             CBF_CALL(cbf_require_column(cbf,"center[2]"));
                             /* write the data */
-                            CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",factor*value));
+                            CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",factor,value));
                         }
                         cbf_H5Sfree(data_space);
                         /*-----------------------------------------------------------------------------------------------*/
@@ -19290,7 +20216,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     const hid_t currType = H5Dget_type(object);
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     CBF_CALL(cbf_H5Tcreate_string(&vlstr,H5T_VARIABLE));
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&lvalue,vlstr));
                                     value = _cbf_strdup(lvalue);
@@ -19306,7 +20232,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                             CBF_CALL(_cbf_nx2cbf_table__diffrn_data_frame(cbf,nx,table));
                             CBF_CALL(cbf_require_column(cbf,"details"));
                             /* write the data */
-                            CBF_CALL(cbf_set_value(cbf,value));
+                            CBF_CALL(_cbf_nx2cbf_set_frame_text(nx,cbf,value));
                             
                             free((void*)value);
                         }
@@ -19332,7 +20258,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     double value = 0., factor = nan("");
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     if (CBF_SUCCESS==error) {
                                         /* convert the data to the correct units */
@@ -19348,7 +20274,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     CBF_CALL(_cbf_nx2cbf_table__diffrn_scan_frame(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"integration_time"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",factor*value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",factor,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -19527,7 +20453,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     double value = 0., factor = nan("");
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     if (CBF_SUCCESS==error) {
@@ -19544,7 +20470,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     CBF_CALL(_cbf_nx2cbf_table__diffrn_measurement(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"sample_detector_distance"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",factor*value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",factor,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -19575,7 +20501,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t count[] = {1};
                                     const hid_t currType = H5Dget_type(object);
                                     char * *  value = (char * *)malloc(dim[0]*sizeof(char *));
-                                    offset[0] = nx->slice;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     CBF_CALL(cbf_H5Tcreate_string(&vlstr,H5T_VARIABLE));
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,(void * const)value,vlstr));
                                     /* ensure I have suitable structure within the CBF file */
@@ -19583,7 +20509,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     CBF_CALL(cbf_require_column(cbf,"date"));
                                     /* write the data */
                                     if (value[0]) {
-                                       CBF_CALL(cbf_set_value(cbf,value[0]));
+                                       CBF_CALL(_cbf_nx2cbf_set_frame_text(nx,cbf,value[0]));
                                     }
                                     H5Dvlen_reclaim(currType, data_space, H5P_DEFAULT, value);
                                     if (value) free((void*)value);
@@ -19616,7 +20542,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     double value = 0., factor = nan("");
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     if (CBF_SUCCESS==error) {
                                         /* convert the data to the correct units */
@@ -19632,7 +20558,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     CBF_CALL(_cbf_nx2cbf_table__diffrn_scan_frame(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"time_period"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",factor*value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",factor,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -19685,14 +20611,14 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     double value = 0;
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     /* ensure I have suitable structure within the CBF file */
                                     CBF_CALL(_cbf_nx2cbf_table__array_intensities(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"offset"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",1.,value));
                                     if (CBF_SUCCESS==error) table->has_offset = 1;
                                 }
                             } else {
@@ -19722,14 +20648,14 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     long value = 0;
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_LONG));
                                     /* ensure I have suitable structure within the CBF file */
                                     CBF_CALL(_cbf_nx2cbf_table__array_intensities(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"overload"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_integervalue(cbf,value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_integer(nx,cbf,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -19758,14 +20684,14 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     double value = 0;
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     /* ensure I have suitable structure within the CBF file */
                                     CBF_CALL(_cbf_nx2cbf_table__array_intensities(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"scaling"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",1.,value));
                                     if (CBF_SUCCESS==error) table->has_scaling_factor = 1;
                                 }
                             } else {
@@ -19907,14 +20833,14 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     long value = 0;
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_LONG));
                                     /* ensure I have suitable structure within the CBF file */
                                     CBF_CALL(_cbf_nx2cbf_table__array_intensities(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"undefined_value"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_integervalue(cbf,value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_integer(nx,cbf,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -20970,7 +21896,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[2];
                                     hsize_t count[] = {1, 4};
                                     double value[4] = {0., 0., 0., 0.};
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     offset[1] = 0;
                                     /* read the value */
                                     if (CBF_SUCCESS!=(error|=cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE))) {
@@ -21034,7 +21960,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[2];
                                     hsize_t count[] = {1, 4};
                                     double value_esds[4] = {0., 0., 0., 0.};
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     offset[1] = 0;
                                     /* read the value */
                                     if (CBF_SUCCESS!=(error|=cbf_H5Dread2(object,offset,0,count,&value_esds,H5T_NATIVE_DOUBLE))) {
@@ -21090,7 +22016,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t count[] = {1};
                                     double value = 0;
                                     double factor;
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     if (CBF_SUCCESS==error) {
@@ -21107,7 +22033,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     CBF_CALL(_cbf_nx2cbf_table__diffrn_radiation_wavelength(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"wavelength"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",factor*value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",factor,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -21136,14 +22062,14 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t offset[1];
                                     hsize_t count[] = {1};
                                     double value = 0;
-                                    offset[0] = dim[0]>1 ? nx->slice : 0;
+                                    offset[0] = _cbf_nx2cbf_frame_offset(nx,object,dim[0]);
                                     /* read the value */
                                     CBF_CALL(cbf_H5Dread2(object,offset,0,count,&value,H5T_NATIVE_DOUBLE));
                                     /* ensure I have suitable structure within the CBF file */
                                     CBF_CALL(_cbf_nx2cbf_table__diffrn_radiation_wavelength(cbf,nx,table));
                                     CBF_CALL(cbf_require_column(cbf,"wt"));
                                     /* write the data */
-                                    CBF_CALL(cbf_set_doublevalue(cbf,"%-.15g",value));
+                                    CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%-.15g",1.,value));
                                 }
                             } else {
                                 cbf_debug_print("incorrect data rank");
@@ -22019,6 +22945,14 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                         if (table->rank > 1) table->xdim = dims[table->rank-1]; else table->xdim = 1;
                     }
                     cbf_H5Sfree(data_space);
+                    /* a stack spread over several data files is read through the frame map */
+                    if (CBF_SUCCESS==error && 3==table->rank
+                        && CBF_SUCCESS==cbf_h5handle_map_frames(nx)
+                        && nx->framedims[1]==table->ydim && nx->framedims[2]==table->xdim
+                        && (nx->num_framesrcs > 1 || nx->framesrcs[0].filename)) {
+                        table->frames = nx->framedims[0];
+                        table->mapped = 1;
+                    }
                 }
                 if (!error && nx->logfile) {
                     /* tell the user something about the data if they requested some information */
@@ -22353,7 +23287,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                 if (table->rank!=H5Sget_simple_extent_dims(data_space,dim,0)) {
                                     cbf_debug_print("Couldn't get dimensions of dataset");
                                     error |= CBF_H5ERROR;
-                                } else if (table->frames!=dim[0]
+                                } else if ((!table->mapped && table->frames!=dim[0])
                                            || (table->rank > 3 && table->zdim!=dim[table->rank-3])
                                            || (table->rank > 2 && table->ydim!=dim[table->rank-2])
                                            || (table->rank > 1 && table->xdim!=dim[table->rank-1])) {
@@ -22372,78 +23306,24 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     } else {
                                         /* extract the data from HDF5 and store in CBF */
                                         {
-                                            hsize_t offset[4];
                                             hsize_t count[4];
-                                            H5T_class_t classtype;
                                             unsigned int compression = CBF_BYTE_OFFSET;
-                                            H5T_sign_t h5sign;
-                                            size_t nelems;
+                                            const H5T_order_t h5order = H5Tget_order(native_type);
+                                            H5T_sign_t h5sign = H5Tget_sign(native_type);
                                             const size_t elem_size = H5Tget_size(native_type);
-                                            void * array;
-                                            H5T_order_t h5order;
-                                            h5order = H5Tget_order(native_type);
-                                            h5sign = H5Tget_sign(native_type);
-                                            classtype = H5Tget_class(native_type);
-                                            offset[0] = nx->slice;
-                                            offset[1] = offset[2] = offset[3] = 0;
                                             count[0] = 1;
                                             count[1] = dim[1];
                                             count[2] = dim[2];
                                             count[3] = dim[3];
-                                            nelems = count[0]*table->xdim*table->ydim*table->zdim;
-                                            array = malloc(nelems*elem_size);
                                             if (H5T_ORDER_LE==h5order) data_byte_order = little_endian;
                                             else if (H5T_ORDER_BE==h5order) data_byte_order = big_endian;
-                                            /* extract data from HDF5 and store in CBF: */
                                             if (h5sign<0) h5sign = H5T_SGN_NONE;
-
-
-                                            CBF_CALL(cbf_H5Dread2(data,offset,0,count,array,native_type));
-                                            if (classtype == H5T_INTEGER) {
-
-                                                CBF_CALL(
-                                                         cbf_set_integerarray_wdims_fs(
-                                                                                       cbf,
-                                                                                       compression,
-                                                                                       table->binary_id,
-                                                                                       array,
-                                                                                       elem_size,
-                                                                                       H5T_SGN_2==h5sign ? 1 : 0,
-                                                                                       nelems,
-                                                                                       data_byte_order,
-                                                                                       table->rank > 1?count[table->rank-1]:0,
-                                                                                       table->rank > 2?count[table->rank-2]:0,
-                                                                                       table->rank > 3?count[table->rank-3]:0,
-                                                                                       0
-                                                                                       )
-                                                         );
-                                            } else if (classtype == H5T_FLOAT) {
-
-                                                CBF_CALL(
-                                                         cbf_set_realarray_wdims_fs(
-                                                                                    cbf,
-                                                                                    compression,
-                                                                                    table->binary_id,
-                                                                                    array,
-                                                                                    elem_size,
-                                                                                    nelems,
-                                                                                    data_byte_order,
-                                                                                    table->rank > 1?count[table->rank-1]:0,
-                                                                                    table->rank > 2?count[table->rank-2]:0,
-                                                                                    table->rank > 3?count[table->rank-3]:0,
-                                                                                    0
-                                                                                    )
-                                                         );
-
-
-
-                                            } else {
-
-                                                cbf_debug_print("Usupported array type");
-
-                                                error |= CBF_NOTIMPLEMENTED;
-                                            }
-                                            free((void*)array);
+                                            /* extract data from HDF5 and store in CBF: */
+                                            CBF_CALL(_cbf_nx2cbf_set_frame_image(nx,cbf,
+                                                                                 table->mapped?CBF_H5FAIL:data,
+                                                                                 native_type,count,
+                                                                                 count[0]*table->xdim*table->ydim*table->zdim,
+                                                                                 table->rank,table->binary_id));
                                             /* map the compression to its string */
                                             switch (compression) {
                                                 case CBF_CANONICAL: {data_compression = canonical; break;}
@@ -22851,10 +23731,10 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                     hsize_t off[1];
                                     const hsize_t cnt[] = {1};
                                     double val;
-                                    off[0] = nx->slice;
                                     if (!error && nx->logfile) fprintf(nx->logfile,"Type: translation\n");
                                     CBF_CALL(cbf_set_value(cbf,"translation"));
                                     if (axisEquipment_image!=axisData->equipment) {
+                                        off[0] = _cbf_nx2cbf_frame_offset(nx,axisData->axis,table->frames);
                                         if (CBF_SUCCESS!=(error|=cbf_H5Dread2(axisData->axis,off,0,cnt,&val,H5T_NATIVE_DOUBLE))) {
                                             cbf_debug_print(cbf_strerror(error));
                                         } else {
@@ -22867,17 +23747,17 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                             CBF_CALL(cbf_require_column(cbf,"angle"));
                                             CBF_CALL(cbf_set_doublevalue(cbf,"%.15g",0.0));
                                             CBF_CALL(cbf_require_column(cbf,"displacement"));
-                                            CBF_CALL(cbf_set_doublevalue(cbf,"%.15g",val));
+                                            CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%.15g",1.,val));
                                         }
                                     }
                                 } else  if (!strcmp(type,"rotation")) {
                                     hsize_t off[1];
                                     const hsize_t cnt[] = {1};
                                     double val;
-                                    off[0] = nx->slice;
                                     if (!error && nx->logfile) fprintf(nx->logfile,"Type: rotation\n");
                                     CBF_CALL(cbf_set_value(cbf,"rotation"));
                                     if (axisEquipment_image!=axisData->equipment) {
+                                        off[0] = _cbf_nx2cbf_frame_offset(nx,axisData->axis,table->frames);
                                         if (CBF_SUCCESS!=(error|=cbf_H5Dread2(axisData->axis,off,0,cnt,&val,H5T_NATIVE_DOUBLE))) {
                                             cbf_debug_print(cbf_strerror(error));
                                         } else {
@@ -22888,7 +23768,7 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
                                             CBF_CALL(cbf_require_column(cbf,"frame_id"));
                                             CBF_CALL(cbf_set_value(cbf,table->frame_id));
                                             CBF_CALL(cbf_require_column(cbf,"angle"));
-                                            CBF_CALL(cbf_set_doublevalue(cbf,"%.15g",val));
+                                            CBF_CALL(_cbf_nx2cbf_set_frame_real(nx,cbf,"%.15g",1.,val));
                                             CBF_CALL(cbf_require_column(cbf,"displacement"));
                                             CBF_CALL(cbf_set_doublevalue(cbf,"%.15g",0.0));
                                         }
@@ -23077,6 +23957,518 @@ _cbf_pilatusAxis2nexusAxisAttrs(h4data,units,depends_on,exsisItem,cmp)
         return error;
     }
 
+    /*
+    Append a source of frames to the image stack, taking ownership of the
+    filename and path.  The frame counts are filled in later.
+    */
+    static int cbf_h5handle_add_framesrc
+            (cbf_h5handle nx,
+             char * const filename,
+             char * const path,
+             const hsize_t first,
+             const hsize_t srcfirst,
+             const hsize_t count)
+    {
+        cbf_h5framesrc * srcs = (cbf_h5framesrc *)realloc(nx->framesrcs,
+                                    (nx->num_framesrcs+1)*sizeof(cbf_h5framesrc));
+        if (!srcs || !path) {
+            free((void*)filename);
+            free((void*)path);
+            return CBF_ALLOC;
+        }
+        nx->framesrcs = srcs;
+        srcs += nx->num_framesrcs++;
+        srcs->filename = filename;
+        srcs->path = path;
+        srcs->first = first;
+        srcs->srcfirst = srcfirst;
+        srcs->count = count;
+        srcs->frames = 0;
+        srcs->file = CBF_H5FAIL;
+        srcs->dataset = CBF_H5FAIL;
+        srcs->lastuse = 0;
+        return CBF_SUCCESS;
+    }
+
+    /*
+    Get the dimensions of a dataset holding part of an image stack.
+    */
+    static int cbf_h5handle_framesrc_dims
+            (const hid_t dataset,
+             hsize_t * const dims)
+    {
+        int error = CBF_SUCCESS;
+        hid_t space = CBF_H5FAIL;
+        if (!cbf_H5Ivalid(space = H5Dget_space(dataset))) {
+            error |= CBF_H5ERROR;
+        } else if (3!=H5Sget_simple_extent_ndims(space)) {
+            cbf_debug_print("error: the image stack is not a 3D dataset\n");
+            error |= CBF_FORMAT;
+        } else if (3!=H5Sget_simple_extent_dims(space,dims,0)) {
+            error |= CBF_H5ERROR;
+        }
+        cbf_H5Sfree(space);
+        return error;
+    }
+
+    /*
+    Open the dataset holding a source of frames.  Data files are kept open
+    for later reads, closing the least recently used one first once
+    max_open_files are open, so that scans with many data files do not
+    exhaust file descriptors.  Relative file names are taken relative to
+    the directory of the master file, as HDF5 does for external links.
+    Once the frame size is known, each dataset opened is checked against
+    the frames the map expects of it.
+    */
+    static int cbf_h5handle_open_framesrc
+            (cbf_h5handle nx,
+             cbf_h5framesrc * const src)
+    {
+        int error = CBF_SUCCESS;
+        src->lastuse = ++nx->framesrc_clock;
+        if (cbf_H5Ivalid(src->dataset)) return CBF_SUCCESS;
+        if (!src->filename) {
+            if (!cbf_H5Ivalid(src->dataset = H5Dopen2(nx->nxdata,src->path,H5P_DEFAULT))) {
+                cbf_debug_print2("error: couldn't open '%s'\n",src->path);
+                error |= CBF_H5ERROR;
+            }
+        } else {
+            if (nx->max_open_files && nx->num_open_files >= nx->max_open_files) {
+                cbf_h5framesrc * lru = NULL;
+                size_t i;
+                for (i = 0; i < nx->num_framesrcs; ++i) {
+                    cbf_h5framesrc * const it = nx->framesrcs+i;
+                    if (cbf_H5Ivalid(it->file) && (!lru || it->lastuse < lru->lastuse)) lru = it;
+                }
+                if (lru) {
+                    if (cbf_H5Ivalid(lru->dataset)) CBF_H5CALL(H5Dclose(lru->dataset));
+                    CBF_H5CALL(H5Fclose(lru->file));
+                    lru->dataset = lru->file = CBF_H5FAIL;
+                    nx->num_open_files--;
+                }
+            }
+            if (src->filename[0] == '/') {
+                src->file = H5Fopen(src->filename,H5F_ACC_RDONLY,H5P_DEFAULT);
+            } else {
+                /* build the path relative to the master file */
+                char * master = NULL;
+                char * full = NULL;
+                const ssize_t len = H5Fget_name(nx->hfile,NULL,0);
+                if (len < 0 || !(master = (char *)malloc(len+1))) {
+                    error |= CBF_ALLOC;
+                } else if (H5Fget_name(nx->hfile,master,len+1) != len) {
+                    error |= CBF_H5ERROR;
+                } else {
+                    const char * const slash = strrchr(master,'/');
+                    const size_t dirlen = slash ? (size_t)(slash-master)+1 : 0;
+                    if (!(full = (char *)malloc(dirlen+strlen(src->filename)+1))) {
+                        error |= CBF_ALLOC;
+                    } else {
+                        memcpy(full,master,dirlen);
+                        strcpy(full+dirlen,src->filename);
+                        src->file = H5Fopen(full,H5F_ACC_RDONLY,H5P_DEFAULT);
+                    }
+                }
+                free((void*)full);
+                free((void*)master);
+            }
+            if (CBF_SUCCESS==error && !cbf_H5Ivalid(src->file)) {
+                cbf_debug_print2("error: couldn't open data file '%s'\n",src->filename);
+                error |= CBF_FILEOPEN;
+            }
+            if (CBF_SUCCESS==error) {
+                nx->num_open_files++;
+                if (!cbf_H5Ivalid(src->dataset = H5Dopen2(src->file,src->path,H5P_DEFAULT))) {
+                    cbf_debug_print3("error: couldn't open '%s' in '%s'\n",src->path,src->filename);
+                    error |= CBF_H5ERROR;
+                }
+            }
+        }
+        if (CBF_SUCCESS==error && nx->framedims[1]) {
+            hsize_t dims[3];
+            CBF_CALL(cbf_h5handle_framesrc_dims(src->dataset,dims));
+            if (CBF_SUCCESS==error
+                && (dims[1] != nx->framedims[1] || dims[2] != nx->framedims[2]
+                    || (src->frames ? dims[0] != src->frames : dims[0] < src->srcfirst+src->count))) {
+                cbf_debug_print3("error: '%s' in '%s' does not hold the frames mapped to it\n",
+                                 src->path,src->filename?src->filename:".");
+                error |= CBF_FORMAT;
+            }
+        }
+        if (CBF_SUCCESS!=error) {
+            if (cbf_H5Ivalid(src->dataset)) H5Dclose(src->dataset);
+            if (cbf_H5Ivalid(src->file)) {
+                H5Fclose(src->file);
+                nx->num_open_files--;
+            }
+            src->dataset = src->file = CBF_H5FAIL;
+        }
+        return error;
+    }
+
+    /*
+    Copy the target of an external link.
+    */
+    static int cbf_h5handle_get_elink
+            (const hid_t group,
+             const char * const name,
+             const size_t size,
+             char * * const filename,
+             char * * const path)
+    {
+        int error = CBF_SUCCESS;
+        char * buf = (char *)malloc(size);
+        const char * file = NULL, * obj = NULL;
+        if (!buf) return CBF_ALLOC;
+        if (H5Lget_val(group,name,buf,size,H5P_DEFAULT) < 0
+            || H5Lunpack_elink_val(buf,size,0,&file,&obj) < 0) {
+            error |= CBF_H5ERROR;
+        } else {
+            *filename = _cbf_strdup(file);
+            *path = _cbf_strdup(obj);
+        }
+        free((void*)buf);
+        return error;
+    }
+
+    /*
+    Collect the 'data_NNNNNN' links of an NXdata group, as written by Eiger
+    detectors, visited in name order.
+    */
+    static herr_t cbf_h5handle_framesrc_op
+            (hid_t group,
+             const char * name,
+             const H5L_info_t * info,
+             void * op_data)
+    {
+        cbf_h5handle nx = (cbf_h5handle)op_data;
+        char * filename = NULL;
+        char * path = NULL;
+        if (strncmp(name,"data_",5) || !isdigit((unsigned char)name[5])) return 0;
+        if (info->type == H5L_TYPE_EXTERNAL) {
+            if (cbf_h5handle_get_elink(group,name,info->u.val_size,&filename,&path)) return -1;
+        } else {
+            path = _cbf_strdup(name);
+        }
+        return cbf_h5handle_add_framesrc(nx,filename,path,0,0,0) ? -1 : 0;
+    }
+
+    /*
+    Resolve the mapping from frames of the image stack of the current
+    entry to the files holding them.  This is done once per handle, data
+    files then being opened only when their frames are read.
+
+    The image stack is the 'data' field of the NXdata group, usually a link
+    to the data in the NXdetector group.  If it is a virtual dataset whose
+    mappings each take whole frames from a single block of a source, the
+    source datasets are read directly rather than through the virtual
+    dataset; any other mapping, such as a frame tiled from the sources of
+    several modules, is rejected with CBF_FORMAT and the stack is read
+    through HDF5.  Failing a 'data' field, the 'data_NNNNNN' links of a
+    multi-file Eiger master are used.  All but the last of those hold as
+    many frames as the first, so only the first and the last data files
+    are opened here.
+    */
+    static int cbf_h5handle_map_frames
+            (cbf_h5handle nx)
+    {
+        int error = CBF_SUCCESS;
+        hid_t data = CBF_H5FAIL;
+        hsize_t dims[3];
+        size_t i;
+        if (!nx) return CBF_ARGUMENT;
+        if (nx->framesrcs) return CBF_SUCCESS;
+        CBF_CALL(cbf_h5handle_get_data(nx,&data,0));
+        if (CBF_SUCCESS==error) {
+            H5L_info_t info;
+            const htri_t exists = H5Lexists(data,"data",H5P_DEFAULT);
+            if (exists < 0) {
+                error |= CBF_H5ERROR;
+            } else if (!exists) {
+                if (H5Literate(data,H5_INDEX_NAME,H5_ITER_INC,NULL,
+                               cbf_h5handle_framesrc_op,(void *)nx) < 0) {
+                    error |= CBF_H5ERROR;
+                } else if (!nx->num_framesrcs) {
+                    cbf_debug_print("error: no 'data' field in the NXdata group\n");
+                    error |= CBF_NOTFOUND;
+                }
+            } else if (H5Lget_info(data,"data",&info,H5P_DEFAULT) < 0) {
+                error |= CBF_H5ERROR;
+            } else if (info.type == H5L_TYPE_EXTERNAL) {
+                char * filename = NULL;
+                char * path = NULL;
+                CBF_CALL(cbf_h5handle_get_elink(data,"data",info.u.val_size,&filename,&path));
+                CBF_CALL(cbf_h5handle_add_framesrc(nx,filename,path,0,0,0));
+            } else {
+                /* a dataset in this file, which may be virtual */
+                hid_t dataset = H5Dopen2(data,"data",H5P_DEFAULT);
+                hid_t dcpl = CBF_H5FAIL;
+                size_t count = 0;
+                if (!cbf_H5Ivalid(dataset) || !cbf_H5Ivalid(dcpl = H5Dget_create_plist(dataset))) {
+                    error |= CBF_H5ERROR;
+                } else if (H5D_VIRTUAL == H5Pget_layout(dcpl) && H5Pget_virtual_count(dcpl,&count) >= 0) {
+                    const hsize_t * const fd = nx->framedims;
+                    CBF_CALL(cbf_h5handle_framesrc_dims(dataset,nx->framedims));
+                    for (i = 0; CBF_SUCCESS==error && i < count; ++i) {
+                        hid_t vspace = H5Pget_virtual_vspace(dcpl,i);
+                        hid_t srcspace = H5Pget_virtual_srcspace(dcpl,i);
+                        const ssize_t flen = H5Pget_virtual_filename(dcpl,i,NULL,0);
+                        const ssize_t plen = H5Pget_virtual_dsetname(dcpl,i,NULL,0);
+                        hsize_t vstart[H5S_MAX_RANK], vend[H5S_MAX_RANK];
+                        hsize_t sstart[H5S_MAX_RANK], send[H5S_MAX_RANK];
+                        char * filename = NULL;
+                        char * path = NULL;
+                        int srcbounds = 0;
+                        /* the mapping must fill whole frames with a single block */
+                        if (3==H5Sget_simple_extent_ndims(vspace)
+                            && H5Sget_select_bounds(vspace,vstart,vend) >= 0
+                            && !vstart[1] && !vstart[2]
+                            && vend[1]+1 == fd[1] && vend[2]+1 == fd[2]
+                            && H5Sget_select_npoints(vspace) == (hssize_t)((vend[0]-vstart[0]+1)*fd[1]*fd[2])) {
+                            /* a source selecting all of its dataset may not have its extent yet */
+                            if (H5S_SEL_ALL == H5Sget_select_type(srcspace)
+                                || H5Sget_simple_extent_ndims(srcspace) < 1) {
+                                sstart[0] = 0;
+                                send[0] = vend[0]-vstart[0];
+                                srcbounds = 1;
+                            } else {
+                                /* and take them from whole frames of a single block */
+                                srcbounds = 3==H5Sget_simple_extent_ndims(srcspace)
+                                    && H5Sget_select_bounds(srcspace,sstart,send) >= 0
+                                    && !sstart[1] && !sstart[2]
+                                    && send[1]+1 == fd[1] && send[2]+1 == fd[2]
+                                    && H5Sget_select_npoints(srcspace) == (hssize_t)((send[0]-sstart[0]+1)*fd[1]*fd[2]);
+                            }
+                        }
+                        /* leave printf-style and partial mappings to HDF5 */
+                        if (flen < 0 || plen < 0 || !srcbounds
+                            || vend[0]-vstart[0] != send[0]-sstart[0]
+                            || !(filename = (char *)malloc(flen+1))
+                            || !(path = (char *)malloc(plen+1))
+                            || H5Pget_virtual_filename(dcpl,i,filename,flen+1) < 0
+                            || H5Pget_virtual_dsetname(dcpl,i,path,plen+1) < 0
+                            || strchr(filename,'%') || strchr(path,'%')) {
+                            error |= CBF_FORMAT;
+                            free((void*)filename);
+                            free((void*)path);
+                        } else {
+                            if (!strcmp(filename,".")) {
+                                free((void*)filename);
+                                filename = NULL;
+                            }
+                            error |= cbf_h5handle_add_framesrc(nx,filename,path,
+                                        vstart[0],sstart[0],vend[0]-vstart[0]+1);
+                        }
+                        cbf_H5Sfree(vspace);
+                        cbf_H5Sfree(srcspace);
+                    }
+                    if (CBF_SUCCESS==error && !count) error |= CBF_FORMAT;
+                    if (CBF_SUCCESS!=error) {
+                        cbf_debug_print("warning: reading the virtual dataset through HDF5\n");
+                        cbf_h5handle_free_framesrcs(nx);
+                        error = CBF_SUCCESS;
+                    }
+                }
+                if (cbf_H5Ivalid(dcpl)) H5Pclose(dcpl);
+                if (cbf_H5Ivalid(dataset)) H5Dclose(dataset);
+                if (CBF_SUCCESS==error && !nx->num_framesrcs) {
+                    CBF_CALL(cbf_h5handle_add_framesrc(nx,NULL,_cbf_strdup("data"),0,0,0));
+                }
+            }
+        }
+        if (CBF_SUCCESS==error && nx->framesrcs[0].count) {
+            /* a virtual dataset: the frame size comes from its extent */
+            return CBF_SUCCESS;
+        }
+        /* otherwise the first source gives the frame size and the frames of
+           every source but the last, the others being checked on first use */
+        if (CBF_SUCCESS==error) {
+            cbf_h5framesrc * const first = nx->framesrcs;
+            cbf_h5framesrc * const last = nx->framesrcs+nx->num_framesrcs-1;
+            CBF_CALL(cbf_h5handle_open_framesrc(nx,first));
+            CBF_CALL(cbf_h5handle_framesrc_dims(first->dataset,dims));
+            if (CBF_SUCCESS==error) {
+                for (i = 0; i < nx->num_framesrcs; ++i) {
+                    cbf_h5framesrc * const src = nx->framesrcs+i;
+                    src->first = i*dims[0];
+                    src->count = src->frames = dims[0];
+                }
+                nx->framedims[1] = dims[1];
+                nx->framedims[2] = dims[2];
+            }
+            if (CBF_SUCCESS==error && last != first) {
+                last->count = last->frames = 0;
+                CBF_CALL(cbf_h5handle_open_framesrc(nx,last));
+                CBF_CALL(cbf_h5handle_framesrc_dims(last->dataset,dims));
+                if (CBF_SUCCESS==error) last->count = last->frames = dims[0];
+            }
+            if (CBF_SUCCESS==error) nx->framedims[0] = last->first+last->count;
+        }
+        if (CBF_SUCCESS!=error) cbf_h5handle_free_framesrcs(nx);
+        return error;
+    }
+
+    /* Set the number of data files of an image stack held open at
+       once, the least recently used being closed first; 0 for no limit */
+
+    int cbf_h5handle_set_max_open_files(cbf_h5handle nx,
+                                        unsigned int max_open_files)
+    {
+        if (!nx) return CBF_ARGUMENT;
+        nx->max_open_files = max_open_files;
+        return CBF_SUCCESS;
+    }
+
+    /* Get the number of frames and the frame size of the image stack
+       in the NXdata group of the current entry */
+
+    int cbf_get_h5image_size(cbf_h5handle nx,
+                             unsigned int * frames,
+                             size_t * ndimslow,
+                             size_t * ndimfast)
+    {
+        cbf_failnez(cbf_h5handle_map_frames(nx));
+        if (frames) *frames = (unsigned int)nx->framedims[0];
+        if (ndimslow) *ndimslow = (size_t)nx->framedims[1];
+        if (ndimfast) *ndimfast = (size_t)nx->framedims[2];
+        return CBF_SUCCESS;
+    }
+
+    /*
+    Read n consecutive frames of the mapped image stack, starting at frame,
+    as values of memtype.  Only the requested hyperslab is read from each
+    data file holding the frames; frames not mapped to any data file are
+    left as zero.
+    */
+    static int cbf_h5handle_read_frames
+            (cbf_h5handle nx,
+             const hsize_t frame,
+             const hsize_t n,
+             void * const array,
+             const hid_t memtype)
+    {
+        int error = CBF_SUCCESS;
+        hsize_t offset[3];
+        hsize_t count[3];
+        const hsize_t end = frame+n;
+        const size_t framesize = H5Tget_size(memtype)*nx->framedims[1]*nx->framedims[2];
+        size_t i;
+        if (end > nx->framedims[0]) return CBF_ENDOFDATA;
+        memset(array,0,framesize*n);
+        for (i = 0; CBF_SUCCESS==error && i < nx->num_framesrcs; ++i) {
+            cbf_h5framesrc * const src = nx->framesrcs+i;
+            const hsize_t lo = frame > src->first ? frame : src->first;
+            const hsize_t hi = end < src->first+src->count ? end : src->first+src->count;
+            if (lo >= hi) continue;
+            CBF_CALL(cbf_h5handle_open_framesrc(nx,src));
+            offset[0] = src->srcfirst+(lo-src->first);
+            offset[1] = offset[2] = 0;
+            count[0] = hi-lo;
+            count[1] = nx->framedims[1];
+            count[2] = nx->framedims[2];
+            CBF_CALL(cbf_H5Dread2(src->dataset,offset,0,count,
+                                  (char *)array+(lo-frame)*framesize,memtype));
+        }
+        return error;
+    }
+
+    /* Read ndimslow consecutive frames of the image stack in the NXdata
+       group of the current entry, starting at frame.  Only the requested
+       hyperslab is read from each data file holding the frames, HDF5
+       converting the stored values to the requested integer type.
+       Frames not mapped to any data file are left as zero. */
+
+    int cbf_get_3d_h5image(cbf_h5handle nx,
+                           unsigned int frame,
+                           void * array,
+                           size_t elsize,
+                           int elsign,
+                           size_t ndimslow,
+                           size_t ndimmid,
+                           size_t ndimfast)
+    {
+        hid_t memtype = CBF_H5FAIL;
+        if (!array || !ndimslow) return CBF_ARGUMENT;
+        switch (elsize) {
+            case sizeof(char):  memtype = elsign?H5T_NATIVE_SCHAR:H5T_NATIVE_UCHAR; break;
+            case sizeof(short): memtype = elsign?H5T_NATIVE_SHORT:H5T_NATIVE_USHORT; break;
+            case sizeof(int):   memtype = elsign?H5T_NATIVE_INT:H5T_NATIVE_UINT; break;
+            case sizeof(CBF_sll_type): memtype = elsign?H5T_NATIVE_LLONG:H5T_NATIVE_ULLONG; break;
+            default: return CBF_ARGUMENT;
+        }
+        cbf_failnez(cbf_h5handle_map_frames(nx));
+        if ((hsize_t)frame+ndimslow > nx->framedims[0]) return CBF_ENDOFDATA;
+        if (ndimmid != nx->framedims[1] || ndimfast != nx->framedims[2]) return CBF_ARGUMENT;
+        return cbf_h5handle_read_frames(nx,frame,ndimslow,array,memtype);
+    }
+
+    /* Read a single frame of the image stack in the NXdata group of
+       the current entry.  ndimslow is the slow dimension, ndimfast is fast. */
+
+    int cbf_get_h5image(cbf_h5handle nx,
+                        unsigned int frame,
+                        void * array,
+                        size_t elsize,
+                        int elsign,
+                        size_t ndimslow,
+                        size_t ndimfast)
+    {
+        return cbf_get_3d_h5image(nx,frame,array,elsize,elsign,1,ndimslow,ndimfast);
+    }
+
+    /* Convert the metadata and image of a single frame of the current
+       entry into a CBF handle, replacing any previous contents.
+       cbf_write_nx2cbf reads only the slice of the image stack for the
+       frame, so the rest of the stack is never touched.  The metadata is
+       converted once: while the CBF handle is not freed or refilled, a
+       later frame only reads the image and the values that change from
+       frame to frame into the cells noted for them.  A file with a
+       per-frame value that has no cell of its own, such as a per-frame
+       polarization, is converted in full for each frame. */
+
+    int cbf_select_h5frame(cbf_h5handle nx,
+                           cbf_handle cbf,
+                           unsigned int frame)
+    {
+        cbf_node *node;
+        struct cbf_h5frame_cells * cells = NULL;
+        int error = CBF_SUCCESS;
+        if (!nx || !cbf) return CBF_ARGUMENT;
+        if (nx->nxframe_cbf == cbf && cbf->deferred == &nx->deferred) {
+            if (nx->nxframe == frame) return CBF_SUCCESS;
+            if (nx->nxframe_cells && !nx->nxframe_cells->full) {
+                nx->slice = frame;
+                error |= _cbf_nx2cbf_refresh_frame(nx, cbf, frame);
+                if (CBF_SUCCESS==error) nx->nxframe = frame;
+                else cbf_h5handle_detach(cbf);
+                return error;
+            }
+        }
+        /* the handle and this file forget any values held for each other */
+        cbf_h5handle_detach(cbf);
+        if (nx->nxframe_cbf) cbf_h5handle_detach(nx->nxframe_cbf);
+        cbf_failnez(cbf_build_datablocks(cbf));
+        cbf_failnez(cbf_find_parent(&node, cbf->node, CBF_ROOT));
+        cbf_failnez(cbf_set_children(node, 0));
+        cbf->node = node;
+        nx->slice = frame;
+        if (!(cells = (struct cbf_h5frame_cells *)calloc(1,sizeof(struct cbf_h5frame_cells)))) return CBF_ALLOC;
+        cells->pending = CBF_H5FAIL;
+        cells->recording = 1;
+        nx->nxframe_cells = cells;
+        error |= cbf_write_nx2cbf(nx, cbf);
+        cells->recording = 0;
+        if (cbf_H5Ivalid(cells->pending)) cells->full = 1;
+        if (CBF_SUCCESS==error) {
+            nx->nxframe_cbf = cbf;
+            nx->nxframe = frame;
+            cbf->deferred = &nx->deferred;
+        } else {
+            cbf_h5handle_free_frame_cells(nx);
+        }
+        return error;
+    }
+
     /*
     Find a suitable HDF5 datatype for the given parameters.
     */
@@ -27664,6 +29056,7 @@ static int process_DiffrnScanAxisCache(cbf_node * const category,
                         CBF_CALL(cbf_write_cbf2nx__array_structure_list_axis(handle, h5handle, key, list));
                         CBF_CALL(cbf_write_cbf2nx__link_h5data(handle, h5handle));
                     }
+                    CBF_CALL(cbf_h5handle_swmr_flush_frame(h5handle));
                     ++h5handle->slice;
                 }
             }
@@ -27694,6 +29087,357 @@ static int process_DiffrnScanAxisCache(cbf_node * const category,
         return error;
     }
 
+    /*
+    Append a string to a realloc'able buffer, without terminating it.
+    */
+    static void _cbf_minicbf_h5plan_append
+            (char * * const buf,
+             size_t * const n,
+             size_t * const k,
+             const char * str)
+    {
+        while (*str) cbf_push_buf(*str++, buf, n, k);
+    }
+
+    /*
+    Split a Pilatus 1.2 miniCBF header into its per-frame values and a
+    signature holding everything else.  The value following any of the
+    given keywords is a per-frame value, as is the frame time, which is
+    returned as a string.  All other tokens are kept in the signature.
+    */
+    static int _cbf_minicbf_h5plan_scan
+            (const char * header,
+             const char * const * const keywords,
+             const size_t num_keywords,
+             double * const values,
+             int * const seen,
+             char * * const signature,
+             char * * const time)
+    {
+        int error = CBF_SUCCESS;
+        char * token = NULL;
+        size_t n = 0, sign = 0, k = 0, i;
+        int newline = 1;
+        *signature = NULL;
+        *time = NULL;
+        for (i = 0; i < num_keywords; ++i) seen[i] = 0;
+        while (CBF_SUCCESS==error) {
+            CBF_CALL(_cbf_scan_pilatus_V1_2_miniheader(&token, &n, &newline, 0, &header));
+            if (!token) break;
+            if (!strcmp("\n",token)) {
+                _cbf_minicbf_h5plan_append(signature, &sign, &k, "\n");
+                continue;
+            }
+            /* the first token of a line: a time, or a keyword */
+            if (isDateTime(token)) {
+                free((void*)*time);
+                *time = _cbf_strdup(token);
+                _cbf_minicbf_h5plan_append(signature, &sign, &k, "#time");
+            } else {
+                size_t keyword = num_keywords;
+                _cbf_minicbf_h5plan_append(signature, &sign, &k, token);
+                for (i = 0; i < num_keywords && keyword == num_keywords; ++i) {
+                    if (!cbf_cistrcmp(keywords[i],token)) keyword = i;
+                }
+                if (keyword < num_keywords) {
+                    CBF_CALL(_cbf_scan_pilatus_V1_2_miniheader(&token, &n, &newline, 0, &header));
+                    if (!token) break;
+                    if (!strcmp("\n",token)) {
+                        _cbf_minicbf_h5plan_append(signature, &sign, &k, "\n");
+                        continue;
+                    }
+                    for (i = keyword; i < num_keywords; ++i) {
+                        if (!cbf_cistrcmp(keywords[i],keywords[keyword])) {
+                            values[i] = strtod(token,0);
+                            seen[i] = 1;
+                        }
+                    }
+                    _cbf_minicbf_h5plan_append(signature, &sign, &k, " #value");
+                }
+            }
+            /* the rest of the line */
+            do {
+                CBF_CALL(_cbf_scan_pilatus_V1_2_miniheader(&token, &n, &newline, 0, &header));
+                if (!token) break;
+                if (strcmp("\n",token)) _cbf_minicbf_h5plan_append(signature, &sign, &k, " ");
+                _cbf_minicbf_h5plan_append(signature, &sign, &k, token);
+            } while (CBF_SUCCESS==error && strcmp("\n",token));
+            if (!token) break;
+        }
+        free((void*)token);
+        cbf_push_buf('\0', signature, &sign, &k);
+        if (CBF_SUCCESS!=error || !*signature) {
+            free((void*)*signature);
+            free((void*)*time);
+            *signature = *time = NULL;
+            if (CBF_SUCCESS==error) error |= CBF_ALLOC;
+        }
+        return error;
+    }
+
+    /*
+    Get the Pilatus 1.2 header of the current datablock of a miniCBF file,
+    or return CBF_FORMAT if the header convention is anything else.
+    */
+    static int _cbf_minicbf_h5plan_header
+            (cbf_handle handle,
+             const char * * const header)
+    {
+        const char * value = NULL;
+        const char vendor_pilatus[] = "PILATUS";
+        const char version_1_2[] = "1.2";
+        cbf_failnez(cbf_find_category(handle,"array_data"));
+        cbf_failnez(cbf_find_column(handle,"header_convention"));
+        cbf_failnez(cbf_get_value(handle,&value));
+        if (!value || strncmp(value,vendor_pilatus,_cbf_strlen(vendor_pilatus))
+            || strncmp(value+_cbf_strlen(vendor_pilatus)+1,version_1_2,_cbf_strlen(version_1_2))) {
+            return CBF_FORMAT;
+        }
+        cbf_failnez(cbf_find_column(handle,"header_contents"));
+        return cbf_get_value(handle,header);
+    }
+
+    /*
+    Read a variable length string dataset holding a frame time.
+    */
+    static int _cbf_minicbf_h5plan_read_time
+            (const hid_t group,
+             const char * const name,
+             char * * const time)
+    {
+        int error = CBF_SUCCESS;
+        hid_t dataset = CBF_H5FAIL, type = CBF_H5FAIL, ftype = CBF_H5FAIL;
+        char * buf = NULL;
+        *time = NULL;
+        if (!cbf_H5Ivalid(dataset = H5Dopen2(group,name,H5P_DEFAULT))) return CBF_NOTFOUND;
+        if (!cbf_H5Ivalid(ftype = H5Dget_type(dataset)) || H5Tis_variable_str(ftype) <= 0) {
+            error |= CBF_FORMAT;
+        } else {
+            CBF_CALL(cbf_H5Tcreate_string(&type,H5T_VARIABLE));
+            CBF_CALL(cbf_H5Dread2(dataset,0,0,0,(void * const)&buf,type));
+            if (CBF_SUCCESS==error && buf) {
+                *time = _cbf_strdup(buf);
+                H5free_memory(buf);
+            }
+            cbf_H5Tfree(type);
+        }
+        if (cbf_H5Ivalid(ftype)) cbf_H5Tfree(ftype);
+        cbf_H5Dfree(dataset);
+        return error;
+    }
+
+    /*
+    Write a frame time if it is earlier than the start time or later than the
+    end time of the series so far, as the full conversion does.
+    */
+    static int _cbf_minicbf_h5plan_write_time
+            (const hid_t group,
+             const char * const name,
+             char * * const current,
+             const char * const time,
+             const int later)
+    {
+        int error = CBF_SUCCESS;
+        const int order = strcmp(time,*current);
+        if (later ? order > 0 : order < 0) {
+            hid_t dataset = CBF_H5FAIL, type = CBF_H5FAIL;
+            CBF_CALL(cbf_H5Tcreate_string(&type,H5T_VARIABLE));
+            if (CBF_SUCCESS==error && !cbf_H5Ivalid(dataset = H5Dopen2(group,name,H5P_DEFAULT))) {
+                error |= CBF_H5ERROR;
+            }
+            CBF_CALL(cbf_H5Dwrite2(dataset,0,0,0,&time,type));
+            if (CBF_SUCCESS==error) {
+                free((void*)*current);
+                *current = _cbf_strdup(time);
+            }
+            cbf_H5Dfree(dataset);
+            cbf_H5Tfree(type);
+        }
+        return error;
+    }
+
+    /*
+    Compile a conversion plan from the frame just converted by
+    cbf_write_minicbf_h5file.  A frame which can't be planned, for instance
+    because some of its per-frame values were not written, leaves no plan,
+    so that the following frames are converted in full.
+    */
+    static int _cbf_compile_minicbf_h5plan
+            (cbf_handle handle,
+             cbf_h5handle h5handle,
+             const cbf_config_t * const axisConfig,
+             const char * const saturation_value)
+    {
+        /* per-frame values in the detector (0) and sample (1) groups,
+           or ignored by the conversion (-1) */
+        static const struct {
+            const char * keyword;
+            int group;
+            const char * path;
+        } fixed[] = {
+            {"Image_path", -1, NULL},
+            {"Angle_increment", -1, NULL},
+            {"Detector_distance", 0, "distance"},
+            {"Detector_distance", 0, "transformations/translation"},
+            {"Exposure_time", 0, "count_time"},
+            {"Exposure_period", 0, "frame_time"},
+            {"Wavelength", 1, "beam/incident_wavelength"},
+            {"Polarization", 1, "beam/incident_polarisation_stokes"},
+        };
+        static const char * const axes[] = {
+            "Alpha", "Kappa", "Phi", "Chi", "Omega", "Start_angle", "Detector_2theta"
+        };
+        int error = CBF_SUCCESS;
+        struct cbf_minicbf_h5plan * plan = NULL;
+        const char * header = NULL;
+        const char * paths[CBF_MINICBF_H5PLAN_MAX];
+        char * axis_paths[CBF_MINICBF_H5PLAN_MAX];
+        int groups[CBF_MINICBF_H5PLAN_MAX];
+        double values[CBF_MINICBF_H5PLAN_MAX];
+        int seen[CBF_MINICBF_H5PLAN_MAX];
+        char * time = NULL;
+        hid_t detector = CBF_H5FAIL, sample = CBF_H5FAIL; /* do not free */
+        size_t i, j, candidates;
+
+        CBF_CALL(_cbf_free_minicbf_h5plan(h5handle->minicbf_plan));
+        h5handle->minicbf_plan = NULL;
+        if (CBF_SUCCESS!=error) return error;
+        if (CBF_SUCCESS!=_cbf_minicbf_h5plan_header(handle,&header)) return CBF_SUCCESS;
+        if (CBF_SUCCESS!=cbf_h5handle_get_detector(h5handle,&detector,0)
+            || CBF_SUCCESS!=cbf_h5handle_get_sample(h5handle,&sample,0)) return CBF_SUCCESS;
+        if (!(plan = (struct cbf_minicbf_h5plan *)calloc(1,sizeof(struct cbf_minicbf_h5plan)))) return CBF_ALLOC;
+        plan->config = axisConfig;
+        plan->rotation = CBF_H5FAIL;
+
+        /* the candidate per-frame values */
+        for (i = 0; i < sizeof(fixed)/sizeof(fixed[0]); ++i) {
+            plan->keywords[plan->num_items] = fixed[i].keyword;
+            plan->stokes[plan->num_items] = !strcmp(fixed[i].keyword,"Polarization");
+            groups[plan->num_items] = fixed[i].group;
+            paths[plan->num_items] = fixed[i].path;
+            axis_paths[plan->num_items++] = NULL;
+        }
+        for (i = 0; i < sizeof(axes)/sizeof(axes[0]); ++i) {
+            const cbf_configItem_t * const axisItem = cbf_config_findMinicbf(axisConfig, axes[i]);
+            if (cbf_config_end(axisConfig) != axisItem) {
+                const char * path_parts[3];
+                path_parts[0] = "transformations";
+                path_parts[1] = axisItem->nexus;
+                path_parts[2] = 0;
+                plan->keywords[plan->num_items] = axes[i];
+                plan->stokes[plan->num_items] = 0;
+                groups[plan->num_items] = axisItem->convert ? 1 : -1;
+                paths[plan->num_items] = axis_paths[plan->num_items]
+                    = axisItem->convert ? _cbf_str_join(path_parts,'/') : NULL;
+                plan->num_items++;
+            }
+        }
+        candidates = plan->num_items;
+        for (i = 0; i < candidates; ++i) plan->datasets[i] = CBF_H5FAIL;
+
+        CBF_CALL(_cbf_minicbf_h5plan_scan(header,plan->keywords,plan->num_items,
+                                          values,seen,&plan->signature,&time));
+
+        /* keep the values present in this frame, which must all have been written */
+        for (i = j = 0; CBF_SUCCESS==error && i < plan->num_items; ++i) {
+            if (!seen[i]) continue;
+            if (groups[i] >= 0
+                && !cbf_H5Ivalid(plan->datasets[j] = H5Dopen2(groups[i] ? sample : detector,
+                                                               paths[i],H5P_DEFAULT))) {
+                cbf_debug_print2("no plan: '%s' was not converted\n",plan->keywords[i]);
+                error |= CBF_NOTFOUND;
+            }
+            plan->keywords[j] = plan->keywords[i];
+            plan->stokes[j++] = plan->stokes[i];
+        }
+        plan->num_items = j;
+        for (i = 0; i < candidates; ++i) free((void*)axis_paths[i]);
+        if (CBF_SUCCESS==error
+            && !cbf_H5Ivalid(plan->rotation = H5Dopen2(detector,"transformations/rotation",H5P_DEFAULT))) {
+            error |= CBF_NOTFOUND;
+        }
+        if (CBF_SUCCESS==error && time) {
+            CBF_CALL(_cbf_minicbf_h5plan_read_time(h5handle->nxid,"start_time",&plan->start_time));
+            CBF_CALL(_cbf_minicbf_h5plan_read_time(h5handle->nxid,"end_time",&plan->end_time));
+        }
+        if (CBF_SUCCESS==error && saturation_value) {
+            plan->saturation_value = _cbf_strdup(saturation_value);
+        }
+        free((void*)time);
+
+        if (CBF_SUCCESS==error) {
+            h5handle->minicbf_plan = plan;
+        } else {
+            _cbf_free_minicbf_h5plan(plan);
+        }
+        return CBF_SUCCESS;
+    }
+
+    /*
+    Convert one frame using the compiled plan, writing only its per-frame
+    values and image.  CBF_H5DIFFERENT is returned, before anything is
+    written, if the frame does not match the plan.
+    */
+    static int _cbf_write_minicbf_h5plan_frame
+            (cbf_handle handle,
+             cbf_h5handle h5handle,
+             const cbf_config_t * const axisConfig)
+    {
+        int error = CBF_SUCCESS;
+        struct cbf_minicbf_h5plan * const plan = h5handle->minicbf_plan;
+        const char * header = NULL;
+        char * signature = NULL;
+        char * time = NULL;
+        double values[CBF_MINICBF_H5PLAN_MAX];
+        int seen[CBF_MINICBF_H5PLAN_MAX];
+        size_t i;
+
+        if (!plan || plan->config != axisConfig) return CBF_H5DIFFERENT;
+        if (CBF_SUCCESS!=_cbf_minicbf_h5plan_header(handle,&header)) return CBF_H5DIFFERENT;
+        cbf_failnez(_cbf_minicbf_h5plan_scan(header,plan->keywords,plan->num_items,
+                                             values,seen,&signature,&time));
+        if (strcmp(signature,plan->signature) || !time != !plan->start_time) {
+            error = CBF_H5DIFFERENT;
+        } else {
+            const hsize_t count[] = {1,4};
+            hsize_t offset[2];
+            hsize_t buf[] = {0,0};
+            const double rotation = 180.0;
+            offset[0] = h5handle->slice;
+            offset[1] = 0;
+            for (i = 0; i < plan->num_items; ++i) {
+                if (!cbf_H5Ivalid(plan->datasets[i])) {
+                    /* a value the conversion ignores */
+                } else if (plan->stokes[i]) {
+                    double polarisation[4];
+                    polarisation[0] = 1.0;
+                    polarisation[1] = values[i];
+                    polarisation[2] = 0.;
+                    polarisation[3] = 0.;
+                    CBF_CALL(cbf_H5Dinsert(plan->datasets[i],offset,0,count,buf,polarisation,H5T_NATIVE_DOUBLE));
+                } else {
+                    CBF_CALL(cbf_H5Dinsert(plan->datasets[i],offset,0,count,buf,values+i,H5T_NATIVE_DOUBLE));
+                }
+            }
+            CBF_CALL(cbf_H5Dinsert(plan->rotation,offset,0,count,buf,&rotation,H5T_NATIVE_DOUBLE));
+            if (time) {
+                CBF_CALL(_cbf_minicbf_h5plan_write_time(h5handle->nxid,"start_time",&plan->start_time,time,0));
+                CBF_CALL(_cbf_minicbf_h5plan_write_time(h5handle->nxid,"end_time",&plan->end_time,time,1));
+            }
+            /* the image itself */
+            CBF_CALL(cbf_find_column(handle,"data"));
+            CBF_CALL(cbf_select_row(handle,0));
+            if (CBF_SUCCESS==error) {
+                hsize_t h5dim[] = {0, 0, 0};
+                CBF_CALL(cbf_write_array_h5file(handle->node, handle->row, h5handle,
+                                                plan->saturation_value, 0, h5dim));
+            }
+        }
+        free((void*)signature);
+        free((void*)time);
+        return error;
+    }
+
     /**
      Extracts the miniCBF data directly - by parsing the header - and uses that plus the configuration options from
     <code>axisConfig</code> to generate a NeXus file in <code>h5handle</code>. This can extract metadata and image
@@ -27764,6 +29508,22 @@ static int process_DiffrnScanAxisCache(cbf_node * const category,
             cbf_onfailnez(cbf_find_category(handle,"array_data"),
                           cbf_debug_print("CBF error: cannot find category 'array_data'.\n"));
 
+            /* a frame matching the compiled plan only needs its per-frame values */
+            if (h5handle->minicbf_plan) {
+                const int planned = _cbf_write_minicbf_h5plan_frame(handle,h5handle,axisConfig);
+                if (CBF_SUCCESS==planned) {
+                    CBF_CALL(cbf_h5handle_swmr_flush_frame(h5handle));
+                    if (CBF_SUCCESS != error) break;
+                    ++h5handle->slice;
+                    if (CBF_SUCCESS != cbf_next_datablock(handle)) break;
+                    continue;
+                } else if (CBF_H5DIFFERENT!=planned) {
+                    error |= planned;
+                    break;
+                }
+                CBF_CALL(cbf_find_category(handle,"array_data"));
+            }
+
             /* First: extract the metadata from the CBF, put it in nexus */
             cbf_failnez(cbf_find_column(handle,"header_convention"));
             if (1) { /* get the header convention, check it is a value I understand */
@@ -28568,7 +30328,13 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
                 }
                 CBF_CALL(cbf_write_cbf2nx__link_h5data(handle, h5handle));
             }
+            /* compile a plan for the following frames of a fixed-geometry series */
+            if (CBF_SUCCESS==error && (h5handle->flags & CBF_H5_PLAN)) {
+                CBF_CALL(_cbf_compile_minicbf_h5plan(handle, h5handle, axisConfig, saturation_value));
+            }
             free((void*)saturation_value);
+            saturation_value = NULL;
+            CBF_CALL(cbf_h5handle_swmr_flush_frame(h5handle));
             ++h5handle->slice;
             if (CBF_SUCCESS != cbf_next_datablock(handle)) break;
         }
@@ -28625,6 +30391,51 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
 
     }
 
+    /* Open an HDF5 File handle as a SWMR reader
+
+       The file may still be being written by a process that has called
+       cbf_h5handle_start_swmr_write.  Datasets opened through the handle
+       show the data that had been flushed when they were opened; use
+       cbf_H5Drefresh to pick up slices flushed since then */
+
+    int cbf_open_h5handle_swmr(cbf_h5handle *h5handle,
+                               const char * h5filename) {
+
+        hid_t fcreate_prop_list;
+
+        if (!h5handle || !h5filename) return CBF_ARGUMENT;
+
+        /* ensure the HDF5 library is ready */
+
+        cbf_h5failneg(H5open(),CBF_H5ERROR);
+
+        cbf_failnez(cbf_make_h5handle(h5handle));
+
+        cbf_h5onfailneg(fcreate_prop_list = H5Pcreate(H5P_FILE_ACCESS),
+                        CBF_ALLOC,cbf_free((void**) h5handle, NULL));
+
+        (*h5handle)->rwmode = 0;
+
+        (*h5handle)->swmr = 1;
+
+        cbf_h5onfailneg(H5Pset_fclose_degree(fcreate_prop_list,H5F_CLOSE_STRONG),
+                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        cbf_h5onfailneg((*h5handle)->hfile = H5Fopen(h5filename,
+                                                     H5F_ACC_RDONLY|H5F_ACC_SWMR_READ,
+                                                     fcreate_prop_list),
+                        CBF_ARGUMENT,cbf_free((void**) h5handle, NULL));
+
+        cbf_onfailnez(cbf_require_h5handle_filename(*h5handle),
+            {cbf_free_h5handle(*h5handle); *h5handle = NULL;});
+
+        cbf_h5onfailneg(H5Pclose(fcreate_prop_list), CBF_ARGUMENT,
+            {cbf_free_h5handle(*h5handle); *h5handle = NULL;});
+
+        return CBF_SUCCESS;
+
+    }
+
     /* Convert an HDF5 typeclass to a string
      and flag for atomic or not
      copies up to n-1 characters of the
@@ -30489,6 +32300,98 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
         return CBF_SUCCESS;
     }
 
+    /* Record an HDF5 image stack in the CBF handle without reading it.
+       Only the type and dimensions are stored, the value is left null;
+       frames are read later with cbf_get_h5image or cbf_select_h5frame */
+
+    static int cbf_h5ds_store_deferred(cbf_handle handle, haddr_t parent,
+                                       const char * parent_name,
+                                       const int target_row,
+                                       const char * categoryname,
+                                       hid_t space, hid_t type,
+                                       const char * name) {
+
+        char buffer[25];
+
+        char h5t_type_class[14];
+
+        int errorcode = 0;
+
+        int atomic, ndims, ii;
+
+        unsigned int rows = 0;
+
+        hsize_t dims[H5S_MAX_RANK];
+
+        char dimstring[H5S_MAX_RANK*22+2];
+
+        size_t len;
+
+        cbf_reportnez(cbf_require_category(handle,categoryname),errorcode);
+
+        cbf_reportnez(cbf_require_column(handle,"id"),errorcode);
+
+        cbf_reportnez(cbf_count_rows(handle,&rows),errorcode);
+
+        for (ii=rows; ii <= target_row; ii++) {
+
+            cbf_reportnez(cbf_new_row(handle),errorcode);
+
+        }
+
+        cbf_reportnez(cbf_select_row(handle,target_row),errorcode);
+
+        cbf_reportnez(cbf_set_value(handle,name),errorcode);
+
+        cbf_reportnez(cbf_require_column(handle,"parent_name"),errorcode);
+
+        cbf_reportnez(cbf_set_value(handle,parent_name),errorcode);
+
+        cbf_reportnez(cbf_require_column(handle,"parent_id"),errorcode);
+
+        sprintf(buffer,"0x%lx",(unsigned long)parent);
+
+        cbf_reportnez(cbf_set_value(handle,buffer),errorcode);
+
+        cbf_reportnez(cbf_require_column(handle,"type"),errorcode);
+
+        if (!cbf_h5type_class_string(H5Tget_class(type),
+                                     h5t_type_class,&atomic,14)) {
+
+            cbf_reportnez(cbf_set_value(handle,h5t_type_class),errorcode);
+
+        }
+
+        ndims = H5Sget_simple_extent_ndims(space);
+
+        if (ndims > 0 && ndims <= H5S_MAX_RANK
+            && H5Sget_simple_extent_dims(space,dims,0) == ndims) {
+
+            cbf_reportnez(cbf_require_column(handle,"dimension"),errorcode);
+
+            dimstring[0] = '[';
+
+            for (ii=0, len=1; ii < ndims; ii++) {
+
+                len += sprintf(dimstring+len,"%lu%c",(unsigned long)dims[ii],(ii<ndims-1)?',':']');
+
+            }
+
+            cbf_reportnez(cbf_set_value(handle,dimstring),errorcode);
+
+            cbf_reportnez(cbf_set_typeofvalue(handle,"bkts"),errorcode);
+
+        }
+
+        cbf_reportnez(cbf_require_column(handle,"value"),errorcode);
+
+        cbf_reportnez(cbf_set_value(handle,"."),errorcode);
+
+        cbf_reportnez(cbf_set_typeofvalue(handle,"null"),errorcode);
+
+        return errorcode;
+    }
+
     /* Callback routine for objects in a group */
 
 
@@ -30570,8 +32473,6 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
 
         size_t padding;
 
-        CBF_UNUSED( info );
-
         CBF_UNUSED( checked_digest );
 
         CBF_UNUSED( type );
@@ -30588,6 +32489,54 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
 
         if (name[0]== '.') return 0;
 
+        /* when reading lazily, record external links without opening
+           their files, so that multi-file scans open quickly */
+
+        if ((((cbf_h5Ovisithandle)op_data)->h5handle->flags & CBF_H5_LAZY)
+            && info && info->type == H5L_TYPE_EXTERNAL) {
+
+            char * filename = NULL;
+
+            char * path = NULL;
+
+            cbf_reportnez(cbf_h5handle_get_elink(loc_id,name,info->u.val_size,
+                                                 &filename,&path),errorcode);
+
+            cbf_reportnez(cbf_rewind_datablock(handle),errorcode);
+
+            if (cbf_find_datablock(handle,"H5")) {
+
+                cbf_reportnez(cbf_new_datablock(handle,"H5"),errorcode);
+
+            }
+
+            cbf_reportnez(cbf_require_category(handle,"H5_External_links"),errorcode);
+
+            cbf_reportnez(cbf_new_row(handle),errorcode);
+
+            cbf_reportnez(cbf_require_column(handle,"name"),errorcode);
+
+            cbf_reportnez(cbf_set_value(handle,name),errorcode);
+
+            cbf_reportnez(cbf_require_column(handle,"parent_name"),errorcode);
+
+            cbf_reportnez(cbf_set_value(handle,((cbf_h5Ovisithandle)op_data)->parent_name),errorcode);
+
+            cbf_reportnez(cbf_require_column(handle,"file"),errorcode);
+
+            cbf_reportnez(cbf_set_value(handle,filename),errorcode);
+
+            cbf_reportnez(cbf_require_column(handle,"path"),errorcode);
+
+            cbf_reportnez(cbf_set_value(handle,path),errorcode);
+
+            free((void*)filename);
+
+            free((void*)path);
+
+            return 0;
+        }
+
         cbf_h5failneg(H5Oget_info_by_name(loc_id,
                                           name, &objinfo, H5P_DEFAULT),CBF_FORMAT);
 
@@ -31228,7 +33177,20 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
                 dataset_type_class = H5Tget_class(dataset_type);
 
                 cbf_debug_print("cbf_h5ds_store");
-                if (!innxpdb) cbf_h5ds_store(handle,objinfo.addr,
+                if (!innxpdb
+                    && (((cbf_h5Ovisithandle)op_data)->h5handle->flags & CBF_H5_LAZY)
+                    && H5Sget_simple_extent_ndims(dataset_ds) >= 3) {
+
+                    value = NULL;
+
+                    cbf_h5ds_store_deferred(handle,objinfo.addr,
+                                            parent_name,row,
+                                            "H5_Datasets",
+                                            dataset_ds,
+                                            dataset_type,
+                                            name);
+
+                } else if (!innxpdb) cbf_h5ds_store(handle,objinfo.addr,
                                parent_name,row,
                                "H5_Datasets",
                                dataset_id,
@@ -31630,6 +33592,12 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
 
         if( handle->commentfile) cbf_failnez (cbf_free_file (&(handle->commentfile)));
 
+        cbf_h5handle_detach(handle);
+
+        /* Data blocks of a lazy read are built before the tree is cleared */
+
+        cbf_failnez (cbf_build_datablocks (handle));
+
         cbf_failnez (cbf_find_parent (&node, handle->node, CBF_ROOT));
 
         cbf_failnez (cbf_set_children (node, 0))
@@ -31726,6 +33694,10 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
 
         cbf_failnez(cbf_new_datablock(handle,"H5"));
 
+        /* image stacks left null are read from this file when needed */
+
+        if (h5handle->flags & CBF_H5_LAZY) cbf_h5handle_attach_lazy(h5handle,handle);
+
         /* visit the groups in the file, starting with the root group */
 
         cbf_h5failneg(H5Literate(h5handle->hfile,
@@ -31789,6 +33761,10 @@ CBF_CALL(CBFM_pilatusAxis2nexusAxisAttrs(h5data,token,"",axisItem,cmp_double,cmp
         
         cbf_failnez(cbf_new_datablock(handle,"H5"));
 
+        /* image stacks left null are read from this file when needed */
+
+        if (h5handle->flags & CBF_H5_LAZY) cbf_h5handle_attach_lazy(h5handle,handle);
+
         /* visit the groups in the file, starting with the root group */
 
         cbf_h5failneg(H5Literate(group,
@@ -307,153 +307,110 @@ extern "C" {
     }
 
     
-    static size_t cbf_h5z_filter(unsigned int flags,
-                                 size_t cd_nelmts,
-                                 const unsigned int cd_values[],
-                                 size_t nbytes,
-                                 size_t *buf_size,
-                                 void **buf){
-        
+    /* Decode one CBF-compressed chunk held in the buffer cbfbuf of nbytes
+       bytes, checking the MIME header against the filter parameters.  If
+       *destination is NULL a buffer of the right size is allocated with
+       cbf_alloc, otherwise *destsize gives the space available there.  On
+       return *destsize is the number of bytes decoded.  The buffer cbfbuf
+       remains the property of the caller.  No HDF5 calls are made, so
+       separate chunks may be decoded concurrently. */
+
+    int cbf_h5z_decode_chunk(void *cbfbuf,
+                             size_t nbytes,
+                             size_t cd_nelmts,
+                             const unsigned int cd_values[],
+                             void **destination,
+                             size_t *destsize) {
+
         cbf_file *tempfile;
         int errorcode;
         size_t elsize;
-        int elsign;
         size_t nelem, nelem_read;
-        unsigned int compression;
-        size_t size;
-        int bits;
         char digest[25];
-        int realarray;
-        size_t ip;
-        size_t dimfast;
-        size_t dimmid;
-        size_t dimslow;
-        size_t padding;
-        char text[100];
-        size_t digest_pos;
-        size_t binary_size_pos;
-        long binid;
         void *vcharacters;
         size_t onbytes;
-        
-        if (flags & H5Z_FLAG_REVERSE) {
-            /* decompression */
-            
-            const char *line;
-            void *     cbfbuf;
-            int        textencoding;
-            size_t     textsize;
-            long       textid;
-            char       textdigest[25];
-            unsigned int        textcompression;
-            int        textbits;
-            int        textsign;
-            int        textreal;
-            const char *textbyteorder;
-            size_t     textdimover;
-            size_t     textdimfast;
-            size_t     textdimmid;
-            size_t     textdimslow;
-            size_t     textpadding;
-            void *     destination;
-            long int   start;
-            
-            int eltype_file, elsigned_file, elunsigned_file,
-            minelem_file, maxelem_file;
-            
-            size_t nelem_file;
-            
-            errorcode = 0;
-            tempfile = NULL;
-            cbf_reportnez(cbf_make_file(&tempfile,NULL),errorcode);
-            vcharacters = NULL;
-            onbytes = tempfile->characters_size;
-            if (tempfile->characters_base) vcharacters = (void *)(tempfile->characters_base);
-            cbf_memcpy_as_cbf(&cbfbuf,buf,nbytes);
-            H5free_memory(*buf);
-            *buf=NULL;
-            tempfile->characters_base = tempfile->characters = cbfbuf;
-            tempfile->characters_used = tempfile->characters_size = nbytes;
-#ifdef CBFDEBUG
-            {int ii;
-                for (ii=0; ii<500 && ii < (int)nbytes; ii++) {
-                    unsigned char c;
-                    c = (*((char**)buf))[ii];
-                    if (c < 32 || c > 126) {
-                        fprintf(stderr,"%d: %x ? ",ii,c);
-                    } else {
-                        fprintf(stderr,"%d: %x %c ",ii,c,c);
-            }
-                }
-            }
-#endif
-            
-            if (errorcode) {
-                /* *buf=NULL; */
-                *buf_size=0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
-            
-            if (cbf_read_line(tempfile,&line)||
-                !cbf_is_blank(line)) {
+        const char *line;
+        int        textencoding;
+        size_t     textsize;
+        long       textid;
+        char       textdigest[25];
+        unsigned int        textcompression;
+        int        textbits;
+        int        textsign;
+        int        textreal;
+        const char *textbyteorder;
+        size_t     textdimover;
+        size_t     textdimfast;
+        size_t     textdimmid;
+        size_t     textdimslow;
+        size_t     textpadding;
+        void *     allocated;
+        long int   start;
+
+        int eltype_file, elsigned_file, elunsigned_file,
+        minelem_file, maxelem_file;
+
+        size_t nelem_file;
+
+        if (!cbfbuf || !destination || !destsize) return CBF_ARGUMENT;
+
+        tempfile = NULL;
+        cbf_failnez(cbf_make_file(&tempfile,NULL));
+        vcharacters = NULL;
+        onbytes = tempfile->characters_size;
+        if (tempfile->characters_base) vcharacters = (void *)(tempfile->characters_base);
+        tempfile->characters_base = tempfile->characters = (char *)cbfbuf;
+        tempfile->characters_used = tempfile->characters_size = nbytes;
+
+        errorcode = 0;
+        allocated = NULL;
+
+        if (cbf_read_line(tempfile,&line)||
+            !cbf_is_blank(line)) {
 #ifdef CBFDEBUG
-                fprintf(stderr,"bad line %s \n",line);
+            fprintf(stderr,"bad line %s \n",line);
 #endif
-                errorcode |= CBF_FORMAT;
-                /* *buf=NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
-            if (cbf_read_line(tempfile,&line)||
-                cbf_cistrncmp(line,";",1)) {
+            errorcode |= CBF_FORMAT;
+        }
+        if (!errorcode && (cbf_read_line(tempfile,&line)||
+                           cbf_cistrncmp(line,";",1))) {
 #ifdef CBFDEBUG
-                fprintf(stderr,"bad line %s \n",line);
+            fprintf(stderr,"bad line %s \n",line);
 #endif
-                errorcode |= CBF_FORMAT;
-                /* *buf=NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
-            if (cbf_read_line(tempfile,&line)||
-                cbf_cistrncmp(line,"--CIF-BINARY-FORMAT-SECTION--",29)) {
+            errorcode |= CBF_FORMAT;
+        }
+        if (!errorcode && (cbf_read_line(tempfile,&line)||
+                           cbf_cistrncmp(line,"--CIF-BINARY-FORMAT-SECTION--",29))) {
 #ifdef CBFDEBUG
-                fprintf(stderr,"bad line %s \n",line);
+            fprintf(stderr,"bad line %s \n",line);
 #endif
-                errorcode |= CBF_FORMAT;
-                /* *buf=NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
-            cbf_reportnez(cbf_parse_mimeheader(tempfile,
-                                               &textencoding,
-                                               &textsize,
-                                               &textid,
-                                               textdigest,
-                                               &textcompression,
-                                               &textbits,
-                                               &textsign,
-                                               &textreal,
-                                               &textbyteorder,
-                                               &textdimover,
-                                               &textdimfast,
-                                               &textdimmid,
-                                               &textdimslow,
-                                               &textpadding),errorcode);
-            if (errorcode) {
-                /* *buf=NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
+            errorcode |= CBF_FORMAT;
+        }
+        if (!errorcode) {
+            errorcode |= cbf_parse_mimeheader(tempfile,
+                                              &textencoding,
+                                              &textsize,
+                                              &textid,
+                                              textdigest,
+                                              &textcompression,
+                                              &textbits,
+                                              &textsign,
+                                              &textreal,
+                                              &textbyteorder,
+                                              &textdimover,
+                                              &textdimfast,
+                                              &textdimmid,
+                                              &textdimslow,
+                                              &textpadding);
+        }
+        if (!errorcode) {
             if (textdimslow < 1) textdimslow = 1;
             if (textdimmid  < 1) textdimmid  = 1;
             if (textdimfast < 1) textdimfast = 1;
-            cbf_reportnez(cbf_parse_binaryheader(tempfile,NULL,NULL,NULL,1),errorcode);
-            if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_ELSIZE ||
+            errorcode |= cbf_parse_binaryheader(tempfile,NULL,NULL,NULL,1);
+        }
+        if (!errorcode
+            && (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_ELSIZE ||
                  (unsigned int)textbits !=  8*cd_values[CBF_H5Z_FILTER_CBF_ELSIZE])
                 || ((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_ELSIGN
                     ||(unsigned int)textsign != cd_values[CBF_H5Z_FILTER_CBF_ELSIGN])
@@ -471,157 +428,156 @@ extern "C" {
                     && (unsigned int)textpadding != cd_values[CBF_H5Z_FILTER_CBF_PADDING])
                 || ((int)cd_nelmts > CBF_H5Z_FILTER_CBF_BINARY_ID
                     && (unsigned int)textid != cd_values[CBF_H5Z_FILTER_CBF_BINARY_ID]
-                    && 0 != cd_values[CBF_H5Z_FILTER_CBF_BINARY_ID])
-                ) {
+                    && 0 != cd_values[CBF_H5Z_FILTER_CBF_BINARY_ID]))) {
 #ifdef CBFDEBUG
-                fprintf(stderr,"mismatch on cd_values versus mime\n");
-                
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_ELSIZE ||
-                     (unsigned int)textbits !=  8*cd_values[CBF_H5Z_FILTER_CBF_ELSIZE])){
-                    fprintf(stderr," bits: %d %d\n",(int)textbits, 8*cd_values[CBF_H5Z_FILTER_CBF_ELSIZE]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_ELSIGN
-                     ||(unsigned int)textsign != cd_values[CBF_H5Z_FILTER_CBF_ELSIGN])){
-                    fprintf(stderr," sign: %d %d\n",(int)textsign, 8*cd_values[CBF_H5Z_FILTER_CBF_ELSIGN]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_COMPRESSION
-                     ||(unsigned int)textcompression != cd_values[CBF_H5Z_FILTER_CBF_COMPRESSION])){
-                    fprintf(stderr," compression: %d %d\n",(int)textcompression, cd_values[CBF_H5Z_FILTER_CBF_COMPRESSION]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_REAL
-                     ||(unsigned int)textreal != cd_values[CBF_H5Z_FILTER_CBF_REAL])){
-                    fprintf(stderr," sign: %d %d\n",(int)textreal, cd_values[CBF_H5Z_FILTER_CBF_REAL]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_DIMFAST
-                     ||(unsigned int)textdimfast != cd_values[CBF_H5Z_FILTER_CBF_DIMFAST])){
-                    fprintf(stderr," dimfast: %d %d\n",(int)textdimfast, cd_values[CBF_H5Z_FILTER_CBF_DIMFAST]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_DIMMID
-                     ||(unsigned int)textdimmid != cd_values[CBF_H5Z_FILTER_CBF_DIMMID])){
-                    fprintf(stderr," dimmid: %d %d\n",(int)textdimmid, cd_values[CBF_H5Z_FILTER_CBF_DIMMID]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_DIMSLOW
-                     ||(unsigned int)textdimslow != cd_values[CBF_H5Z_FILTER_CBF_DIMSLOW])){
-                    fprintf(stderr," dimslow: %d %d\n",(int)textdimslow, cd_values[CBF_H5Z_FILTER_CBF_DIMSLOW]);
-                }
-                if (((int)cd_nelmts <= CBF_H5Z_FILTER_CBF_PADDING
-                     ||(unsigned int)textpadding != cd_values[CBF_H5Z_FILTER_CBF_PADDING])){
-                    fprintf(stderr," padding: %d %d\n",(int)textpadding, cd_values[CBF_H5Z_FILTER_CBF_PADDING]);
-                }
+            fprintf(stderr,"mismatch on cd_values versus mime\n");
+            fprintf(stderr," bits: %d, sign: %d, compression: %x, real: %d\n",
+                    (int)textbits,(int)textsign,textcompression,(int)textreal);
+            fprintf(stderr," dimfast: %d, dimmid: %d, dimslow: %d, padding: %d\n",
+                    (int)textdimfast,(int)textdimmid,(int)textdimslow,(int)textpadding);
 #endif
-                /* *buf = NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
-            
+            errorcode |= CBF_FORMAT;
+        }
+
+        if (!errorcode) {
             elsize = (textbits+7)/8;
             nelem = textdimover;
-            
-            
-            cbf_reportnez(cbf_decompress_parameters (&eltype_file, NULL,
-                                                     &elsigned_file, &elunsigned_file,
-                                                     &nelem_file,
-                                                     &minelem_file, &maxelem_file,
-                                                     textcompression,
-                                                     tempfile),errorcode);
-            if (errorcode) {
-                /* *buf = NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-            }
-            
-            cbf_reportnez(cbf_get_fileposition(tempfile,&start),errorcode);
-            
-            if (textcompression != CBF_NONE
+            errorcode |= cbf_decompress_parameters (&eltype_file, NULL,
+                                                    &elsigned_file, &elunsigned_file,
+                                                    &nelem_file,
+                                                    &minelem_file, &maxelem_file,
+                                                    textcompression,
+                                                    tempfile);
+        }
+
+        if (!errorcode) {
+            errorcode |= cbf_get_fileposition(tempfile,&start);
+            if (!errorcode && textcompression != CBF_NONE
                 && textcompression != CBF_BYTE_OFFSET
                 && textcompression != CBF_NIBBLE_OFFSET) {
-                cbf_reportnez(cbf_set_fileposition(tempfile,-24,SEEK_CUR),errorcode);}
-            
+                errorcode |= cbf_set_fileposition(tempfile,-24,SEEK_CUR);
+            }
             if (errorcode||(cbf_is_base64digest(textdigest) &&
                             !cbf_md5digest (tempfile, textsize, digest))) {
-                
                 if (errorcode || strcmp(textdigest,digest)) {
-                    
 #ifdef CBFDEBUG
                     fprintf(stderr," mismatched digests %s %s\n",textdigest,digest);
 #endif
-                    /* *buf = NULL; */
-                    *buf_size = 0;
-                    /* cbf_free_file(&tempfile) */;
-                    return 0;
-                    
+                    errorcode |= CBF_FORMAT;
                 }
-                
             }
-            
-            cbf_reportnez(cbf_set_fileposition(tempfile,start,SEEK_SET),errorcode);
-            
-            /* allocate a new buffer */
-            if (cbf_alloc((void **) &destination,NULL,
-                          nelem*elsize,1)) {
-                /* *buf = NULL; */
-                *buf_size = 0;
-                /* cbf_free_file(&tempfile); */
-                return 0;
-                
+        }
+
+        if (!errorcode) errorcode |= cbf_set_fileposition(tempfile,start,SEEK_SET);
+
+        if (!errorcode) {
+            if (!*destination) {
+                /* allocate a new buffer */
+                if (cbf_alloc((void **) &allocated,NULL,nelem*elsize,1)) {
+                    errorcode |= CBF_ALLOC;
+                } else {
+                    *destination = allocated;
+                }
+            } else if (nelem*elsize > *destsize) {
+                errorcode |= CBF_ARGUMENT;
             }
-            
+        }
+
+        if (!errorcode) {
 #ifdef CBFDEBUG
             fprintf(stderr,"compressed size estimates, textsize %ld, tempfile %ld\n",(unsigned long)textsize,
                     (unsigned long)( nbytes-(tempfile->characters-tempfile->characters_base)));
-            
-            fprintf(stderr,"Start of decompression %ld, compression %x\n",
-                    (long) (tempfile->characters-tempfile->characters_base),
-                    textcompression);
 #endif
             nelem_read = 0;
-            cbf_reportnez(cbf_decompress (destination,
-                                          elsize, textsign, nelem, &nelem_read,
-                                          textsize,
-                                          textcompression, textbits, textsign, tempfile,
-                                          textreal, textbyteorder, textdimover,
-                                          textdimfast,textdimmid,textdimslow,textpadding),
-                          errorcode);
+            errorcode |= cbf_decompress (*destination,
+                                         elsize, textsign, nelem, &nelem_read,
+                                         textsize,
+                                         textcompression, textbits, textsign, tempfile,
+                                         textreal, textbyteorder, textdimover,
+                                         textdimfast,textdimmid,textdimslow,textpadding);
 #ifdef CBFDEBUG
             fprintf(stderr," errorcode %d after decompress\n",errorcode);
-            
-            {int ii;
-                for (ii=0; ii<500 && ii < (int)(nelem_read*elsize); ii++) {
-                    unsigned char c;
-                    c = (((char*)destination))[ii];
-                    if (c < 32 || c > 126) {
-                        fprintf(stderr,"%d: %x ? ",ii,c);
-                    } else {
-                        fprintf(stderr,"%d: %x %c ",ii,c,c);
-            }
-                }
-            }
 #endif
-            
-            if (errorcode) {
+        }
 
-              cbf_free((void **) (&destination), NULL);
-              /* *buf = NULL; */
-              *buf_size = 0;
-              /* cbf_free_file(&tempfile); */
-              return 0;
+        if (errorcode) {
+            if (allocated) {
+                cbf_free((void **) &allocated, NULL);
+                *destination = NULL;
             }
-            
-            *buf_size = nelem_read*elsize;
+            *destsize = 0;
+        } else {
+            *destsize = nelem_read*elsize;
+        }
+
+        tempfile->characters_base = tempfile->characters = vcharacters;
+
+        tempfile->characters_size = onbytes;
+
+        tempfile->characters_used = 0;
+
+        cbf_free_file(&tempfile);
+
+        return errorcode;
 
-            cbf_memcpy_as_h5(buf,&destination,nelem_read*elsize);
+    }
+
+    static size_t cbf_h5z_filter(unsigned int flags,
+                                 size_t cd_nelmts,
+                                 const unsigned int cd_values[],
+                                 size_t nbytes,
+                                 size_t *buf_size,
+                                 void **buf){
+        
+        cbf_file *tempfile;
+        int errorcode;
+        size_t elsize;
+        int elsign;
+        size_t nelem;
+        unsigned int compression;
+        size_t size;
+        int bits;
+        char digest[25];
+        int realarray;
+        size_t ip;
+        size_t dimfast;
+        size_t dimmid;
+        size_t dimslow;
+        size_t padding;
+        char text[100];
+        size_t digest_pos;
+        size_t binary_size_pos;
+        long binid;
+        
+        if (flags & H5Z_FLAG_REVERSE) {
+            /* decompression */
             
-            cbf_free((void **) &destination,NULL);
+            void *     cbfbuf;
+            void *     destination;
             
-            tempfile->characters_base = tempfile->characters = vcharacters;
+            cbfbuf = NULL;
+            if (cbf_memcpy_as_cbf(&cbfbuf,buf,nbytes)) {
+                *buf_size = 0;
+                return 0;
+            }
+            H5free_memory(*buf);
+            *buf=NULL;
             
-            tempfile->characters_size = onbytes;
+            destination = NULL;
+            size = 0;
+            errorcode = cbf_h5z_decode_chunk(cbfbuf,nbytes,cd_nelmts,cd_values,
+                                             &destination,&size);
+            cbf_free((void **) &cbfbuf,NULL);
             
-            tempfile->characters_used = 0;
+            if (errorcode || cbf_memcpy_as_h5(buf,&destination,size)) {
+                if (destination) cbf_free((void **) &destination,NULL);
+                *buf_size = 0;
+                return 0;
+            }
             
-            cbf_free_file(&tempfile);
+            *buf_size = size;
+            
+            cbf_free((void **) &destination,NULL);
             
             return (*buf_size);
             
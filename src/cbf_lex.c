@@ -294,6 +294,191 @@ static int cbf_return_text (int code, YYSTYPE *val, const char *text, char type)
   return code;
 }
 
+
+  /* Return a data block name.  While one data block of a lazy read is
+     being built, the next data block name ends the input */
+
+static int cbf_return_datablock (cbf_handle handle, YYSTYPE *val, const char *name)
+{
+  if (handle->lazy_block > 1)
+
+    return 0;
+
+  if (handle->lazy_block)
+
+    handle->lazy_block = 2;
+
+  return cbf_return_text (DATA, val, name, 0);
+}
+
+  /* Character classes that can be taken in bulk by cbf_lex_span.  None of
+     them includes end-of-line, tab, null or non-ASCII characters, which
+     still go through cbf_read_character and its checks. */
+
+#define CBF_LEX_SPAN_WORD      0
+#define CBF_LEX_SPAN_WORD2     1
+#define CBF_LEX_SPAN_STRING    2
+#define CBF_LEX_SPAN_TEXT      3
+#define CBF_LEX_SPAN_BLANK     4
+
+static const char cbf_lex_plain [5][256] = {
+
+    /* rest of an unquoted word */
+
+  {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+  },
+
+    /* rest of an unquoted word with CIF2 delimiters */
+
+  {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,1,0,1,1,1,1,0,1,1,1,1,0,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,0,1,0,1,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+  },
+
+    /* inside a quoted string */
+
+  {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    1,1,0,1,1,1,1,0,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+  },
+
+    /* inside a text field, stopping at '-' to check for MIME boundaries */
+
+  {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+  },
+
+    /* blanks between tokens */
+
+  {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+  }
+};
+
+
+  /* Take a run of characters of the given class in one step, stopping
+     short of the column limit so the line size warning is still given,
+     and leave the queue of recent characters as reading them one at a
+     time would have.  Only the last five characters, and any run of
+     backslashes just before them, can affect the queue. */
+
+static int cbf_lex_span (cbf_file *file, int kind, int save, int cqueue[5])
+{
+  const char *span;
+
+  size_t length, limit, ii;
+
+  if (file->column <= file->columnlimit)
+
+    limit = file->columnlimit - file->column;
+
+  else
+
+    limit = file->characters_used;
+
+  cbf_failnez (cbf_read_span (file, cbf_lex_plain [kind], limit, save,
+                                                          &span, &length))
+
+  ii = length > 5 ? length - 5 : 0;
+
+  while (ii > 0 && span [ii - 1] == '\\') ii--;
+
+  if (ii > 0) ii--;
+
+  for (; ii < length; ii++) {
+
+    cqueue[4] = cqueue[3];
+
+    cqueue[3] = cqueue[2];
+
+    cqueue[2] = cqueue[1];
+
+    cqueue[1] = cqueue[0];
+
+    cqueue[0] = (unsigned char) span [ii];
+
+    if (cqueue[1] == '\\' && cqueue[2] == '\\') cqueue[1] += 0x100;
+
+  }
+
+  return 0;
+}
+
+
   /* Back up one character in the file */
   
 static int cbf_lex_unget (cbf_file *file, YYSTYPE *val, int c[5]) {
@@ -498,6 +683,10 @@ int cbf_lex (cbf_handle handle, YYSTYPE *val )
        
           cbf_errornez (cbf_save_character_trim (handle->commentfile, (cqueue[0]&0xFF)), val)
                  
+      } else if (cqueue[0] == ' ') {
+
+          cbf_errornez (cbf_lex_span (file, CBF_LEX_SPAN_BLANK, 0, cqueue), val)
+
       }
 
       continue;
@@ -535,12 +724,12 @@ int cbf_lex (cbf_handle handle, YYSTYPE *val )
             	  
             	}
             	
-            	return cbf_return_text (DATA, val, &line [5], 0);
+            	return cbf_return_datablock (handle, val, &line [5]);
             }
 
         if (isspace (cqueue[0]) || cqueue[0] == EOF)
 
-          return cbf_return_text (DATA, val, &line [5], 0);
+          return cbf_return_datablock (handle, val, &line [5]);
 
       }
 
@@ -1010,6 +1199,12 @@ int cbf_lex (cbf_handle handle, YYSTYPE *val )
           }
           
           cbf_errornez (cbf_save_character_trim (file, (cqueue[0]&0xFF)), val);
+
+            /* A closing quote can only follow an opening one or a blank */
+
+          if (cqueue[0] != file->buffer[0])
+
+            cbf_errornez (cbf_lex_span (file, CBF_LEX_SPAN_STRING, 1, cqueue), val)
                     
           continue;
 
@@ -1810,6 +2005,14 @@ int cbf_lex (cbf_handle handle, YYSTYPE *val )
           }
 
 
+            /* Take the rest of the line in bulk, unless the last character
+               read might begin the closing semicolon */
+
+          if (!mime && file->column >= 2)
+
+            cbf_errornez (cbf_lex_span (file, CBF_LEX_SPAN_TEXT, 1, cqueue), val)
+
+
             /* Read the next character */
             
           cqueue[4] = cqueue[3];
@@ -2049,6 +2252,13 @@ int cbf_lex (cbf_handle handle, YYSTYPE *val )
               cbf_errornez (cbf_get_fileposition (file, &position), val)
 
               code_size = size;
+
+                /* A header scan also skips the zero padding, rather
+                   than reading through it for the terminator */
+
+              if (file->read_headers & CBF_PARSE_SCAN)
+
+                code_size += padding;
             }
             else
 
@@ -2217,6 +2427,16 @@ int cbf_lex (cbf_handle handle, YYSTYPE *val )
     errorcode = cbf_save_character_trim (file, (cqueue[0]&0xFF));
 
     cbf_errornez (errorcode, val);
+
+
+      /* Take the rest of an unquoted word in bulk */
+
+    if (!data && !save && !loop && !item && !comment && !string && !column
+        && !(define && (file->read_headers & CBF_PARSE_DEFINES)))
+
+      cbf_errornez (cbf_lex_span (file,
+                      (file->read_headers & CBF_PARSE_CIF2_DELIMS)?
+                      CBF_LEX_SPAN_WORD2:CBF_LEX_SPAN_WORD, 1, cqueue), val)
   }
   while (cqueue[0] != EOF);
 
@@ -1444,31 +1444,37 @@ int cbf_compress_packed (void         *source,
     }
 
 
-  /* Decompress an array */
-
-int cbf_decompress_packed (void         *destination,
-                           size_t        elsize,
-                           int           elsign,
-                           size_t        nelem,
-                           size_t       *nelem_read,
-                           size_t        compressedsize,
-                           unsigned int  compression,
-                           int           data_bits,
-                           int           data_sign,
-                           cbf_file     *file,
-                           int           realarray,
-                           const char   *byteorder,
-                           size_t        dimover,
-                           size_t        dimfast,
-                           size_t        dimmid,
-                           size_t        dimslow,
-                           size_t        padding)
+  /* Decompress an array with ccp4 compression, either into a full
+     destination array or, if sink is set, through a destination window
+     of window elements of which the last history are kept for the
+     averaging each time it is passed on */
+
+static int cbf_decompress_packed_window (void         *destination,
+                                         size_t        window,
+                                         size_t        history,
+                                         cbf_tile_sink *sink,
+                                         size_t        elsize,
+                                         int           elsign,
+                                         size_t        nelem,
+                                         size_t       *nelem_read,
+                                         size_t        compressedsize,
+                                         unsigned int  compression,
+                                         int           data_bits,
+                                         int           data_sign,
+                                         cbf_file     *file,
+                                         int           realarray,
+                                         const char   *byteorder,
+                                         size_t        dimover,
+                                         size_t        dimfast,
+                                         size_t        dimmid,
+                                         size_t        dimslow,
+                                         size_t        padding)
     {
         unsigned int next, pixel=0, pixelcount;
         
         unsigned int bits, iint, element[4], sign, unsign, limit, count;
         
-        unsigned char *unsigned_char_data;
+        unsigned char *unsigned_char_data, *window_end, *delivered;
         
         unsigned char *trail_char_data[8];
         
@@ -1532,6 +1538,10 @@ int cbf_decompress_packed (void         *destination,
         
         unsigned_char_data = (unsigned char *) destination;
         
+        delivered = unsigned_char_data;
+        
+        window_end = unsigned_char_data + window * elsize;
+        
         
         for (i = 0; i < 8; i++) trail_char_data[i] = NULL;
         
@@ -1749,7 +1759,9 @@ int cbf_decompress_packed (void         *destination,
                     
                 } 
                 
-                if (avgflag) {
+                /* No average is needed after the last element */
+                
+                if (avgflag && count + pixel + 1 < nelem) {
                     
                     cbf_failnez(cbf_update_jpa_pointers(trail_char_data, 
                                                         &ndimfast,  &ndimmid, &ndimslow,
@@ -1768,6 +1780,12 @@ int cbf_decompress_packed (void         *destination,
                     
                 }
                 
+                if (sink && unsigned_char_data == window_end)
+                    
+                    cbf_failnez (cbf_flush_tile (sink, (unsigned char *) destination,
+                                                 &unsigned_char_data, &delivered,
+                                                 history, elsize))
+                
             }
             
             count += pixelcount;
@@ -1775,6 +1793,12 @@ int cbf_decompress_packed (void         *destination,
             
         }
         
+        if (sink)
+            
+            cbf_failnez (cbf_flush_tile (sink, (unsigned char *) destination,
+                                         &unsigned_char_data, &delivered,
+                                         0, elsize))
+        
         /* Number read */
         
         if (nelem_read)
@@ -1788,6 +1812,98 @@ int cbf_decompress_packed (void         *destination,
     }
 
 
+  /* Decompress an array with ccp4 compression */
+
+int cbf_decompress_packed (void         *destination,
+                           size_t        elsize,
+                           int           elsign,
+                           size_t        nelem,
+                           size_t       *nelem_read,
+                           size_t        compressedsize,
+                           unsigned int  compression,
+                           int           data_bits,
+                           int           data_sign,
+                           cbf_file     *file,
+                           int           realarray,
+                           const char   *byteorder,
+                           size_t        dimover,
+                           size_t        dimfast,
+                           size_t        dimmid,
+                           size_t        dimslow,
+                           size_t        padding)
+    {
+        return cbf_decompress_packed_window (destination, 0, 0, NULL,
+                                             elsize, elsign, nelem, nelem_read,
+                                             compressedsize, compression,
+                                             data_bits, data_sign, file,
+                                             realarray, byteorder, dimover,
+                                             dimfast, dimmid, dimslow, padding);
+    }
+
+
+  /* Decompress an array with ccp4 compression a tile at a time.
+     The averaging looks back at most a row, or a section and a row,
+     so only that much of the array is held */
+
+int cbf_decompress_packed_tiles (cbf_tile_sink *sink,
+                                 size_t        elsize,
+                                 int           elsign,
+                                 size_t        nelem,
+                                 size_t       *nelem_read,
+                                 size_t        compressedsize,
+                                 unsigned int  compression,
+                                 int           data_bits,
+                                 int           data_sign,
+                                 cbf_file     *file,
+                                 int           realarray,
+                                 const char   *byteorder,
+                                 size_t        dimover,
+                                 size_t        dimfast,
+                                 size_t        dimmid,
+                                 size_t        dimslow,
+                                 size_t        padding)
+    {
+        void *window;
+        
+        size_t history, fast, mid, slow;
+        
+        int errorcode;
+        
+        history = 1;
+        
+        if ((dimfast || dimmid || dimslow) && !(compression&CBF_FLAT_IMAGE)) {
+            
+            slow = dimslow ? dimslow : 1;
+            
+            mid = dimmid ? dimmid : 1;
+            
+            fast = dimfast ? dimfast : nelem/(mid*slow);
+            
+            if (slow > 1)
+                
+                history = fast*mid + fast + 1;
+            
+            else if (mid > 1)
+                
+                history = fast + 1;
+            
+        }
+        
+        cbf_failnez (cbf_alloc (&window, NULL, elsize, history + CBF_TILE_ELEMENTS))
+        
+        errorcode = cbf_decompress_packed_window (window,
+                                                  history + CBF_TILE_ELEMENTS,
+                                                  history, sink,
+                                                  elsize, elsign, nelem, nelem_read,
+                                                  compressedsize, compression,
+                                                  data_bits, data_sign, file,
+                                                  realarray, byteorder, dimover,
+                                                  dimfast, dimmid, dimslow, padding);
+        
+        return errorcode | cbf_free (&window, NULL);
+    }
+
+
 #ifdef __cplusplus
 
 }
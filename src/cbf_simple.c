@@ -4220,415 +4220,561 @@ extern "C" {
         return CBF_SUCCESS;
     }
 
-    /* Read a 3D array.
-     ndimslow is the slowest dimension,
-     ndimmid is the next faster dimension,
-     ndimfast is the fastest dimension */
-
-    int cbf_get_3d_array (cbf_handle    handle,
-                          unsigned int  reserved,
-                          const char   *array_id,
-                          int          *binary_id,
-                          void         *array,
-                          int           eltype,
-                          size_t        elsize,
-                          int           elsign,
-                          size_t        ndimslow,
-                          size_t        ndimmid,
-                          size_t        ndimfast)
+    /* Compile the layout of a list of array sections of one array into
+       a list of row copies between the full array and the sections,
+       packed one after another with the fast index varying fastest */
+
+    static int cbf_make_section_plan (cbf_handle        handle,
+                                      const char       *array_id,
+                                      const char      **section_id,
+                                      size_t            sections,
+                                      cbf_section_plan *plan)
     {
-        const char *direction_string;
-        
-        const char *xarray_id;
+        cbf_section_plan layout;
 
-        int code, done [4], precedence, direction [4], local_binary_id,
-        dir1=1, dir2=1, dir3=1,
-        index1, index2, index3,
-        start1, end1, inc1,
-        start2, end2, inc2,
-        start3, end3, inc3;
+        size_t section, index, rank, rows, row, j, k, dim [3],
+               start [3], end [3], *sectiondim;
 
-        size_t nelem_read, dimslow, dimmid, dimfast;
+        long stride [3], *sectionstride;
 
-        char tmp [32], *pixel, *pixel2;
+        int errorcode;
 
-        if (reserved != 0)
+        if (!handle || !array_id || !section_id || !sections || !plan)
 
             return CBF_ARGUMENT;
 
-        if ( eltype != CBF_FLOAT && eltype != CBF_INTEGER)
+        *plan = NULL;
 
-            return CBF_ARGUMENT;
+        cbf_failnez (cbf_alloc ((void **) &layout, NULL,
+                                sizeof (cbf_section_plan_struct), 1))
 
-        if ( eltype == CBF_FLOAT && elsize != 4 && elsize != 8 )
+        layout->array_id = (char *) cbf_copy_string (NULL, array_id, 0);
 
-            return CBF_ARGUMENT;
+        errorcode = layout->array_id ? 0 : CBF_ALLOC;
 
-        if ( eltype == CBF_FLOAT && !elsign)
+        if (!errorcode)
 
-            return CBF_ARGUMENT;
+            errorcode = cbf_get_3d_array_size (handle, 0, array_id,
+                                               &layout->dimslow,
+                                               &layout->dimmid,
+                                               &layout->dimfast);
 
+        if (!errorcode)
 
-        /* Get the index dimensions */
+            errorcode = cbf_alloc ((void **) &layout->section_id, NULL,
+                                   sizeof (char *), sections);
 
-        cbf_failnez (cbf_get_3d_array_size (handle, reserved, array_id,
-                                            &dimslow, &dimmid, &dimfast))
+        if (!errorcode)
+        {
+            memset (layout->section_id, 0, sections * sizeof (char *));
 
+            layout->sections = sections;
 
-        /* Check that the fast dimensions correspond */
+            errorcode = cbf_alloc ((void **) &layout->section_dim, NULL,
+                                   3 * sizeof (size_t), sections);
+        }
 
-        if (dimmid != ndimmid || dimfast != ndimfast)
+        if (!errorcode)
 
-            return CBF_ARGUMENT;
-        
-        /* See if the array_id is actually an array_section_id */
-        
-        cbf_failnez(cbf_get_array_section_array_id(handle,array_id,&xarray_id));
-        
-        if (cbf_cistrcmp(array_id,xarray_id)) {
-            
-            /* This is actually an array_section, to get the data we need
-             a scratch array the size of the entire array, and then
-             we need to extract the section from that */
-            
-            size_t xdimslow;
-            
-            size_t xdimmid;
-            
-            size_t xdimfast;
-            
-            size_t xtotalbytes;
-            
-            size_t array_offset, section_offset;
-            
-            void * temparray;
-            
-            size_t rank;
-            
-            int ii, iii, jj, jjj, kk, kkk;
-            
-            size_t start[3];
-            
-            size_t end[3];
-            
-            long stride[3];
-            
-            int dir[3];
-            
-            size_t arraydim[3];
-            
-            size_t sectiondim[3];
-            
-            int errorcode;
-            
-            cbf_failnez (cbf_get_array_section_rank(handle, array_id, &rank));
-            
-            if (rank > 3) return CBF_ARGUMENT;
-            
-            cbf_failnez (cbf_get_3d_array_size (handle, reserved, xarray_id,
-                                                &xdimslow, &xdimmid, &xdimfast));
-            
-            start[0] = start[1] = start[2] = 1L;
-            
-            end[0] = arraydim[0] = sectiondim[0] = xdimfast;
-            
-            end[1] = arraydim[1] = sectiondim[1] = xdimmid;
-            
-            end[2] = arraydim[2] = sectiondim[2] = xdimslow;
-            
-            stride[0] = stride[1] = stride[2] = dir[0] = dir[1] = dir[2] = 1;
-            
-            for (ii = 0; ii < (ssize_t)rank; ii++) {
-                
-                cbf_failnez(cbf_get_array_section_section(handle,array_id,ii+1,
-                                                          start+ii, end+ii, stride+ii));
-                
-                /* fprintf(stderr,"index %d start %ld end %ld stride% ld\n",ii, (long)start[ii], (long)end[ii], (long)stride[ii]); */
-                
-                if (stride[ii] < 0) dir[ii] = -1;
-                
-                sectiondim[ii] = ((end[ii]-start[ii]+stride[ii])*dir[ii])/stride[ii];
-                
-                /* fprintf(stderr,"index %d, dim %ld\n",ii,(long)sectiondim[ii]); */
-                
-            }
-            
-            
-            
-            xtotalbytes = xdimslow*xdimmid*xdimfast*elsize;
-            
-            cbf_failnez(cbf_alloc(&temparray,NULL,1,xtotalbytes));
-            
-            errorcode = cbf_get_3d_array(handle, reserved,
-                                         xarray_id,
-                                         binary_id,
-                                         temparray,
-                                         eltype,
-                                         elsize,
-                                         elsign,
-                                         xdimslow,
-                                         xdimmid,
-                                         xdimfast);
-            
-            /* we need to extract the data elsize bytes at a time
-               following the indexing of both the section and the
-               overall array */
-            
-            for (kk = start[2]; kk*dir[2] <  (int)(end[2]*dir[2]); kk += stride[2]) {
-                kkk = (kk-start[2])/stride[2];
-                for (jj = start[1]; jj*dir[1] <  (int)(end[1]*dir[1]); jj += stride[1]) {
-                    jjj = (jj-start[1])/stride[1];
-                    for (ii = start[0]; ii*dir[0] <  (int)(end[0]*dir[0]); ii += stride[0]) {
-                        iii = (ii-start[0])/stride[0];
-                        array_offset = elsize*cbf_offset_1_3(ii,jj,kk,xdimfast,xdimmid);
-                        section_offset = elsize*cbf_offset_0_3(iii,jjj,kkk,sectiondim[0],sectiondim[1]);
-                        /* fprintf(stderr,"ii,jj,kk: %d %d %d array_offset: %ld,iii,jjj,kkk: %d %d %d section_offset: %ld\n",
-                                ii,jj,kk,(unsigned long)array_offset,iii,jjj,kkk,(unsigned long)section_offset); */
-                        memcpy(((char *)array)+section_offset,((char *)temparray)+array_offset,elsize);
-                                                            
-                    }
-                }
-            }
-            
-            errorcode |= cbf_free(&temparray,NULL);
-            
-            return errorcode;
-            
-        }
-            
-            
-        /* Get the index directions from the array_structure_list category */
+            errorcode = cbf_alloc ((void **) &layout->section_offset, NULL,
+                                   sizeof (size_t), sections + 1);
 
-        done [1] = done [2] = done[3] = 0;
+        if (!errorcode)
 
-        direction [1] = direction [2] = direction [3] = 1;
+            errorcode = cbf_alloc ((void **) &layout->section_start, NULL,
+                                   3 * sizeof (size_t), sections);
 
-        /* If no array_id, use default directions */
+        if (!errorcode)
 
-        if (array_id) {
+            errorcode = cbf_alloc ((void **) &layout->section_stride, NULL,
+                                   3 * sizeof (long), sections);
 
-        cbf_failnez (cbf_find_category (handle, "array_structure_list"))
-        if (cbf_find_column   (handle, "array_id")) {
-            cbf_failnez(cbf_find_column (handle, "array_section"));
-        }
 
-        while (cbf_find_nextrow (handle, array_id) == 0)
+        /* Find the start, stride and size of each section along each
+           index.  Indices the section does not mention cover the array */
+
+        dim [0] = layout->dimfast;
+        dim [1] = layout->dimmid;
+        dim [2] = layout->dimslow;
+
+        rows = 0;
+
+        if (!errorcode)
+
+            layout->section_offset [0] = 0;
+
+        for (section = 0; section < sections && !errorcode; section++)
         {
-            cbf_failnez (cbf_find_column      (handle, "precedence"))
-            cbf_failnez (cbf_get_integervalue (handle, &precedence))
+            layout->section_id [section] =
+                (char *) cbf_copy_string (NULL, section_id [section], 0);
 
-            if (precedence < 1 || precedence > 3)
+            if (!layout->section_id [section])
 
-                return CBF_FORMAT;
+                errorcode = CBF_ALLOC;
 
-            code = cbf_find_column (handle, "direction");
+            if (!errorcode)
 
-            if (code == 0)
+                errorcode = cbf_get_array_section_rank (handle, section_id [section],
+                                                        &rank);
+
+            if (!errorcode && rank > 3)
+
+                errorcode = CBF_FORMAT;
+
+            for (index = 0; index < 3 && !errorcode; index++)
             {
-                cbf_failnez (cbf_get_value (handle, &direction_string))
+                start [index] = 1;
 
-                if (cbf_cistrcmp ("decreasing", direction_string) == 0)
+                end [index] = dim [index];
 
-                    direction [precedence] = -1;
+                stride [index] = 1;
+
+                if (index < rank)
+
+                    errorcode = cbf_get_array_section_section (handle,
+                                                               section_id [section],
+                                                               index + 1,
+                                                               start + index,
+                                                               end + index,
+                                                               stride + index);
+
+                if (!errorcode && stride [index] == 0)
+
+                    stride [index] = 1;
+
+                if (!errorcode &&
+                    (start [index] < 1 || start [index] > dim [index] ||
+                     end [index] < 1 || end [index] > dim [index] ||
+                     (stride [index] > 0 && end [index] < start [index]) ||
+                     (stride [index] < 0 && end [index] > start [index])))
+
+                    errorcode = CBF_FORMAT;
             }
-            else
 
-                if (code != CBF_NOTFOUND)
+            if (errorcode)
 
-                    return code;
+                break;
 
-            if (done [precedence])
+            sectiondim = layout->section_dim + 3 * section;
 
-                return CBF_FORMAT;
+            sectionstride = layout->section_stride + 3 * section;
 
-            done [precedence] = 1;
+            for (index = 0; index < 3; index++)
+            {
+                sectiondim [index] = (stride [index] > 0 ?
+                                      end [index] - start [index] :
+                                      start [index] - end [index]) /
+                                     labs (stride [index]) + 1;
 
-            if (cbf_find_column   (handle, "array_id")) {
-                cbf_failnez(cbf_find_column (handle, "array_section"));
+                layout->section_start [3 * section + index] = start [index];
+
+                sectionstride [index] = stride [index];
             }
+
+            layout->section_offset [section + 1] = layout->section_offset [section] +
+                sectiondim [0] * sectiondim [1] * sectiondim [2];
+
+            rows += sectiondim [1] * sectiondim [2];
         }
 
-        if (!done [1])
 
-            return CBF_NOTFOUND;
+        /* List the rows */
 
-        if (!done [2])
-        {
-            dir1 = direction [1];
+        if (!errorcode)
 
-            dir2 = 1;
-        }
-        else
+            errorcode = cbf_alloc ((void **) &layout->row, NULL,
+                                   sizeof (cbf_section_row), rows);
+
+        for (section = 0, row = 0; section < sections && !errorcode; section++)
         {
-            dir1 = direction [2];
+            size_t *first;
 
-            dir2 = direction [1];
-        }
+            first = layout->section_start + 3 * section;
 
-        if (!done [3])
-        {
-            dir3 = 1;
-        }
-        else
-        {
-            dir3 = dir2;
+            sectiondim = layout->section_dim + 3 * section;
 
-            dir2 = dir1;
+            sectionstride = layout->section_stride + 3 * section;
 
-            dir1 = direction [3];
-        }
+            for (k = 0; k < sectiondim [2]; k++)
+
+                for (j = 0; j < sectiondim [1]; j++, row++)
+                {
+                    layout->row [row].array_offset = cbf_offset_1_3 (first [0],
+                        first [1] + j * sectionstride [1],
+                        first [2] + k * sectionstride [2],
+                        layout->dimfast, layout->dimmid);
+
+                    layout->row [row].array_stride = sectionstride [0];
 
+                    layout->row [row].section_offset = layout->section_offset [section] +
+                        cbf_offset_0_3 (0, j, k, sectiondim [0], sectiondim [1]);
+
+                    layout->row [row].length = sectiondim [0];
+                }
         }
 
+        if (!errorcode)
 
-        /* Find the binary data */
+            layout->rows = rows;
 
-        cbf_failnez (cbf_find_category (handle, "array_data"))
+        if (errorcode)
 
-        if (array_id) {
-            cbf_failnez (cbf_find_column   (handle, "array_id"))
-            cbf_failnez (cbf_find_row      (handle, array_id))
-        } else {
-            cbf_failnez(cbf_rewind_row(handle));
-        }
+            return errorcode | cbf_free_section_plan (layout);
 
-        if ( binary_id && *binary_id != 0) {
+        *plan = layout;
 
-            if (cbf_find_column(handle, "binary_id")) {
+        return 0;
+    }
 
-                if ( *binary_id !=0 && *binary_id != 1 ) return CBF_NOTFOUND;
 
-            } else {
+    /* Construct a plan for moving all the sections of an array listed in
+       array_structure_list_section between the full array and a buffer
+       holding the sections one after another */
 
-                while (1)  {
-                    if (cbf_get_integervalue( handle, &local_binary_id) ||
-                        local_binary_id == 0) local_binary_id = 1;
-                    if (local_binary_id != *binary_id) {
-                        cbf_failnez (cbf_find_column   (handle, "array_id"))
-                        if (cbf_find_nextrow  (handle, array_id)) return CBF_NOTFOUND;
-                        cbf_failnez (cbf_find_column(handle, "binary_id"))
-                    } else break;
-                }
-            }
-        }
+    int cbf_construct_section_plan (cbf_handle        handle,
+                                    const char       *array_id,
+                                    cbf_section_plan *plan)
+    {
+        const char **section_id, *this_id, *this_array_id;
 
-        cbf_failnez (cbf_find_column   (handle, "data"))
+        unsigned int rows, row;
 
-        /* Read the binary data */
+        size_t sections, section, kept;
 
-        if ( ndimslow <= 0 || ndimmid  <= 0 ||  ndimfast <= 0)
+        int errorcode;
+
+        if (!handle || !plan)
 
             return CBF_ARGUMENT;
 
-        if (eltype == CBF_INTEGER) {
-            cbf_failnez (cbf_get_integerarray (handle, &local_binary_id,
-                                               array, elsize, elsign, ndimslow * ndimmid * ndimfast, &nelem_read))
-        } else {
-            cbf_failnez (cbf_get_realarray (handle, &local_binary_id,
-                                            array, elsize, ndimslow * ndimmid * ndimfast, &nelem_read))
-        }
+        if (!array_id)
 
-        if ( binary_id ) *binary_id = local_binary_id;
+            cbf_failnez (cbf_get_array_id (handle, 0, &array_id))
 
 
-        /* Reorder the data if necessary */
+        /* List the distinct section ids */
 
-#ifndef CBF_0721_READS
+        cbf_failnez (cbf_find_category (handle, "array_structure_list_section"))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_count_rows    (handle, &rows))
 
-        if (dir1 < 0 || dir2 < 0 || dir3 < 0 )
+        if (!rows)
+
+            return CBF_NOTFOUND;
+
+        cbf_failnez (cbf_alloc ((void **) &section_id, NULL,
+                                sizeof (const char *), rows))
+
+        sections = 0;
+
+        errorcode = 0;
+
+        for (row = 0; row < rows && !errorcode; row++)
         {
-            if (dir1 >= 0)
-            {
-                start1 = 0;
-                end1 = ndimslow;
-                inc1 = 1;
-            }
-            else
-            {
-                start1 = ndimslow - 1;
-                end1 = -1;
-                inc1 = -1;
-            }
+            errorcode = cbf_select_row (handle, row);
 
-            if (dir2 >= 0)
-            {
-                start2 = 0;
-                end2 = ndimmid;
-                inc2 = 1;
-            }
-            else
-            {
-                start2 = ndimmid - 1;
-                end2 = -1;
-                inc2 = -1;
-            }
+            if (!errorcode)
 
-            if (dir3 >= 0)
-            {
-                start3 = 0;
-                end3 = ndimfast;
-                inc3 = 1;
-            }
-            else
-            {
-                start3 = ndimfast - 1;
-                end3 = -1;
-                inc3 = -1;
-            }
+                errorcode = cbf_get_value (handle, &this_id);
 
+            if (errorcode || !this_id)
 
-            pixel = (char *) array;
+                continue;
 
-            for (index1 = start1; index1 != end1; index1 += inc1)
+            for (section = 0; section < sections; section++)
 
-                for (index2 = start2; index2 != end2; index2 += inc2)
+                if (cbf_cistrcmp (this_id, section_id [section]) == 0)
 
-                    for (index3 = start3; index3 != end3; index3 += inc3)
-                    {
-                        pixel2 = ((char *) array) + (index1*ndimmid*ndimfast + index2 * ndimfast + index3) * elsize;
+                    break;
 
-                        if (pixel < pixel2) {
+            if (section == sections)
 
-                            if (elsize == sizeof (int))
-                            {
-                                *((int *) tmp)    = *((int *) pixel);
-                                *((int *) pixel)  = *((int *) pixel2);
-                                *((int *) pixel2) = *((int *) tmp);
-                            }
-                            else
-                            {
-                                memcpy (tmp, pixel, elsize);
-                                memcpy (pixel, pixel2, elsize);
-                                memcpy (pixel2, tmp, elsize);
-                            }
+                section_id [sections++] = this_id;
+        }
 
-                        }
 
-                        pixel += elsize;
-                    }
+        /* Keep the sections of this array */
+
+        for (section = kept = 0; section < sections && !errorcode; section++)
+        {
+            errorcode = cbf_get_array_section_array_id (handle, section_id [section],
+                                                        &this_array_id);
+
+            if (!errorcode && this_array_id &&
+                cbf_cistrcmp (this_array_id, array_id) == 0)
+
+                section_id [kept++] = section_id [section];
+        }
+
+        if (!errorcode && !kept)
+
+            errorcode = CBF_NOTFOUND;
+
+        if (!errorcode)
+
+            errorcode = cbf_make_section_plan (handle, array_id, section_id, kept, plan);
+
+        return errorcode | cbf_free ((void **) &section_id, NULL);
+    }
+
+
+    /* Free a section plan */
+
+    int cbf_free_section_plan (cbf_section_plan plan)
+    {
+        int errorcode = 0;
+
+        size_t section;
+
+        void *memblock;
+
+        memblock = (void *) plan;
+
+        if (plan)
+        {
+            if (plan->section_id)
+
+                for (section = 0; section < plan->sections; section++)
+
+                    errorcode |= cbf_free ((void **) &plan->section_id [section], NULL);
+
+            errorcode |= cbf_free ((void **) &plan->section_id, NULL);
+
+            errorcode |= cbf_free ((void **) &plan->array_id, NULL);
+
+            errorcode |= cbf_free ((void **) &plan->section_dim, NULL);
+
+            errorcode |= cbf_free ((void **) &plan->section_offset, NULL);
+
+            errorcode |= cbf_free ((void **) &plan->section_start, NULL);
+
+            errorcode |= cbf_free ((void **) &plan->section_stride, NULL);
+
+            errorcode |= cbf_free ((void **) &plan->row, NULL);
+        }
+
+        return errorcode | cbf_free (&memblock, NULL);
+    }
+
+
+    /* Get the number of sections in a plan */
+
+    int cbf_get_section_plan_sections (cbf_section_plan plan, size_t *sections)
+    {
+        if (!plan || !sections)
+
+            return CBF_ARGUMENT;
+
+        *sections = plan->sections;
+
+        return 0;
+    }
+
+
+    /* Get the id, the offset in the section buffer and the dimensions of
+       one section of a plan */
+
+    int cbf_get_section_plan_section (cbf_section_plan plan, size_t section,
+                                      const char **section_id,
+                                      size_t      *offset,
+                                      size_t      *ndimslow,
+                                      size_t      *ndimmid,
+                                      size_t      *ndimfast)
+    {
+        if (!plan || section >= plan->sections)
+
+            return CBF_ARGUMENT;
+
+        if (section_id)
+
+            *section_id = plan->section_id [section];
+
+        if (offset)
+
+            *offset = plan->section_offset [section];
+
+        if (ndimslow)
+
+            *ndimslow = plan->section_dim [3 * section + 2];
+
+        if (ndimmid)
+
+            *ndimmid = plan->section_dim [3 * section + 1];
+
+        if (ndimfast)
+
+            *ndimfast = plan->section_dim [3 * section];
+
+        return 0;
+    }
+
+
+    /* Copy length elements from one strided row to another */
+
+#define cbf_copy_strided_row(type, to, tostride, from, fromstride, length) \
+    {                                                                       \
+        type *t = (type *) (to);                                            \
+                                                                            \
+        const type *f = (const type *) (from);                              \
+                                                                            \
+        long i;                                                             \
+                                                                            \
+        for (i = 0; i < (long) (length); i++)                               \
+                                                                            \
+            t [i * (tostride)] = f [i * (fromstride)];                      \
+    }
+
+    static void cbf_copy_section_row (char *to, long tostride,
+                                      const char *from, long fromstride,
+                                      size_t length, size_t elsize)
+    {
+        size_t i;
+
+        if (tostride == 1 && fromstride == 1)
+        {
+            memcpy (to, from, length * elsize);
+
+            return;
+        }
+
+        switch (elsize)
+        {
+            case 1:
+
+                cbf_copy_strided_row (unsigned char, to, tostride, from, fromstride, length)
+
+                break;
+
+            case 2:
+
+                cbf_copy_strided_row (unsigned short, to, tostride, from, fromstride, length)
+
+                break;
+
+            case 4:
+
+                cbf_copy_strided_row (unsigned int, to, tostride, from, fromstride, length)
+
+                break;
+
+            case 8:
+
+                cbf_copy_strided_row (CBF_ull_type, to, tostride, from, fromstride, length)
+
+                break;
+
+            default:
+
+                for (i = 0; i < length; i++)
+
+                    memcpy (to + (long) i * tostride * (long) elsize,
+                            from + (long) i * fromstride * (long) elsize, elsize);
         }
+    }
+
+
+    /* Copy the sections of a full array into a section buffer */
+
+    int cbf_extract_array_sections (cbf_section_plan plan,
+                                    const void      *array,
+                                    size_t           elsize,
+                                    void            *sections)
+    {
+        long row;
+
+        if (!plan || !array || !sections || !elsize)
 
+            return CBF_ARGUMENT;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(plan->section_offset [plan->sections] > 65536)
 #endif
+        for (row = 0; row < (long) plan->rows; row++)
+        {
+            const cbf_section_row *r = plan->row + row;
 
-        if (ndimslow * ndimmid * ndimfast != nelem_read)
+            cbf_copy_section_row ((char *) sections + r->section_offset * elsize, 1,
+                                  (const char *) array + r->array_offset * elsize,
+                                  r->array_stride, r->length, elsize);
+        }
 
-            return CBF_ENDOFDATA;
+        return 0;
+    }
+
+
+    /* Copy a section buffer into the full array.  Pixels outside every
+       section are left as they are */
+
+    int cbf_assemble_array_sections (cbf_section_plan plan,
+                                     const void      *sections,
+                                     size_t           elsize,
+                                     void            *array)
+    {
+        long row;
+
+        if (!plan || !array || !sections || !elsize)
+
+            return CBF_ARGUMENT;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(plan->section_offset [plan->sections] > 65536)
+#endif
+        for (row = 0; row < (long) plan->rows; row++)
+        {
+            const cbf_section_row *r = plan->row + row;
+
+            cbf_copy_section_row ((char *) array + r->array_offset * elsize,
+                                  r->array_stride,
+                                  (const char *) sections + r->section_offset * elsize, 1,
+                                  r->length, elsize);
+        }
 
         return 0;
     }
 
 
+    /* Read all the sections of a plan, decoding the full array once */
 
-    /* Save a 3D array.
+    int cbf_get_array_sections (cbf_handle       handle,
+                                cbf_section_plan plan,
+                                int             *binary_id,
+                                void            *sections,
+                                int              eltype,
+                                size_t           elsize,
+                                int              elsign)
+    {
+        void *array;
+
+        int errorcode;
+
+        if (!handle || !plan || !sections)
+
+            return CBF_ARGUMENT;
+
+        cbf_failnez (cbf_alloc (&array, NULL, elsize,
+                                plan->dimslow * plan->dimmid * plan->dimfast))
+
+        errorcode = cbf_get_3d_array (handle, 0, plan->array_id, binary_id, array,
+                                      eltype, elsize, elsign,
+                                      plan->dimslow, plan->dimmid, plan->dimfast);
+
+        if (!errorcode)
+
+            errorcode = cbf_extract_array_sections (plan, array, elsize, sections);
+
+        return errorcode | cbf_free (&array, NULL);
+    }
+
+
+    /* Read a 3D array.
      ndimslow is the slowest dimension,
      ndimmid is the next faster dimension,
      ndimfast is the fastest dimension */
 
-    int cbf_set_3d_array (cbf_handle    handle,
+    int cbf_get_3d_array (cbf_handle    handle,
                           unsigned int  reserved,
                           const char   *array_id,
                           int          *binary_id,
-                          unsigned int  compression,
                           void         *array,
                           int           eltype,
                           size_t        elsize,
@@ -4637,12 +4783,20 @@ extern "C" {
                           size_t        ndimmid,
                           size_t        ndimfast)
     {
-
-        char enctype[30];
+        const char *direction_string;
         
-        const char * xarray_id;
+        const char *xarray_id;
 
-        int local_binary_id, done [4], precedence, dimension [4];
+        int code, done [4], precedence, direction [4], local_binary_id,
+        dir1=1, dir2=1, dir3=1,
+        index1, index2, index3,
+        start1, end1, inc1,
+        start2, end2, inc2,
+        start3, end3, inc3;
+
+        size_t nelem_read, dimslow, dimmid, dimfast;
+
+        char tmp [32], *pixel, *pixel2;
 
         if (reserved != 0)
 
@@ -4660,36 +4814,18 @@ extern "C" {
 
             return CBF_ARGUMENT;
 
-        /* Update the array_structure_list category */
-
-        if (ndimslow == 0)
-
-            dimension [3] = 1;
-
-        else
-
-            dimension [3] = ndimslow;
-
-        if (ndimmid == 0)
-
-            dimension [2] = 1;
-
-        else
-
-            dimension [2] = ndimmid;
 
-        if (ndimfast == 0)
+        /* Get the index dimensions */
 
-            dimension [1] = 1;
+        cbf_failnez (cbf_get_3d_array_size (handle, reserved, array_id,
+                                            &dimslow, &dimmid, &dimfast))
 
-        else
 
-            dimension [1] = ndimfast;
+        /* Check that the fast dimensions correspond */
 
+        if (dimmid != ndimmid || dimfast != ndimfast)
 
-        done [1] = dimension [1] == 1;
-        done [2] = dimension [2] == 1;
-        done [3] = dimension [3] == 1;
+            return CBF_ARGUMENT;
         
         /* See if the array_id is actually an array_section_id */
         
@@ -4697,119 +4833,56 @@ extern "C" {
         
         if (cbf_cistrcmp(array_id,xarray_id)) {
             
-            /* This is actually an array section.  To write the section,
-             we need the full array.  If it does not exist, we have to
-             start it off as an array of zeros.  In either case we can then
-             insert the section into it and write it back.  */
+            /* This is actually an array_section, to get the data we need
+             a scratch array the size of the entire array, and then
+             we need to extract the section from that */
             
-            size_t xdimslow;
+            cbf_section_plan plan;
             
-            size_t xdimmid;
+            void * temparray;
             
-            size_t xdimfast;
+            int errorcode;
             
-            size_t xtotalbytes;
+            cbf_failnez (cbf_make_section_plan (handle, xarray_id, &array_id, 1, &plan));
             
-            size_t array_offset, section_offset;
+            errorcode = cbf_alloc(&temparray,NULL,elsize,
+                                  plan->dimslow*plan->dimmid*plan->dimfast);
             
-            void * temparray;
+            if (!errorcode)
             
-            size_t rank;
+                errorcode = cbf_get_3d_array(handle, reserved,
+                                             xarray_id,
+                                             binary_id,
+                                             temparray,
+                                             eltype,
+                                             elsize,
+                                             elsign,
+                                             plan->dimslow,
+                                             plan->dimmid,
+                                             plan->dimfast);
             
-            int ii, iii, jj, jjj, kk, kkk;
+            /* copy the section out a row at a time */
             
-            size_t start[3];
+            if (!errorcode)
             
-            size_t end[3];
+                errorcode = cbf_extract_array_sections(plan,temparray,elsize,array);
             
-            long stride[3];
+            errorcode |= cbf_free(&temparray,NULL);
             
-            int dir[3];
+            return errorcode | cbf_free_section_plan(plan);
             
-            size_t arraydim[3];
+        }
             
-            size_t sectiondim[3];
             
-            int errorcode;
-            
-            cbf_failnez (cbf_get_array_section_rank(handle, array_id, &rank));
-            
-            if (rank > 3) return CBF_ARGUMENT;
-            
-            cbf_failnez (cbf_get_3d_array_size (handle, reserved, xarray_id,
-                                                &xdimslow, &xdimmid, &xdimfast));
-            
-            start[0] = start[1] = start[2] = 1;
-            
-            end[0] = arraydim[0] = sectiondim[0] = xdimfast;
-            
-            end[1] = arraydim[1] = sectiondim[1] = xdimmid;
-            
-            end[2] = arraydim[2] = sectiondim[2] = xdimslow;
-            
-            stride[0] = stride[1] = stride[2] = dir[0] = dir[1] = dir[2] = 1;
-            
-            for (ii = 0; ii < (ssize_t)rank; ii++) {
-                
-                cbf_failnez(cbf_get_array_section_section(handle,array_id,ii+1,
-                                                          start+ii, end+ii, stride+ii));
-                
-                if (stride[ii] < 0) dir[ii] = -1;
-                
-                sectiondim[ii] = ((end[ii]-start[ii]+stride[ii])*dir[ii])/stride[ii];
-                
-            }
-            
-            
-            
-            xtotalbytes = xdimslow*xdimmid*xdimfast*elsize;
-            
-            cbf_failnez(cbf_alloc(&temparray,NULL,1,xtotalbytes));
-            
-            if (cbf_get_3d_array(handle, reserved,
-                                 xarray_id,
-                                 binary_id,
-                                 temparray,
-                                 eltype,
-                                 elsize,
-                                 elsign,
-                                 xdimslow,
-                                 xdimmid,
-                                 xdimfast)) {
-                
-                memset(temparray,0,xtotalbytes);
-                
-            }
-            
-            /* we need to store the data elsize bytes at a time
-             following the indexing of both the section and the
-             overall array */
-            
-            for (kk = start[2]; kk*dir[2] <  (int)(end[2]*dir[2]); kk += stride[2]) {
-                kkk = (kk-start[2])/stride[2];
-                for (jj = start[1]; jj*dir[1] <  (int)(end[1]*dir[1]); jj += stride[1]) {
-                    jjj = (jj-start[1])/stride[1];
-                    for (ii = start[0]; ii*dir[0] <  (int)(end[0]*dir[0]); ii += stride[0]) {
-                        iii = (ii-start[0])/stride[0];
-                        array_offset = elsize*cbf_offset_1_3(ii,jj,kk,xdimfast,xdimmid);
-                        section_offset = elsize*cbf_offset_0_3(iii,jjj,kkk,sectiondim[0],sectiondim[1]);
-                        memcpy(((char *)temparray)+array_offset,((char *)array)+section_offset,elsize);
-                        
-                    }
-                }
-            }
-            
-            /* Now write back the entire array */
-            
-            errorcode = cbf_set_3d_array ( handle, reserved, xarray_id,
-                                          binary_id, compression,temparray,
-                                          eltype,elsize,elsign,xdimslow,xdimmid,xdimfast);
-            
-            errorcode |= cbf_free(&temparray,NULL);
-            
-            return errorcode;
-            
-        }
+        /* Get the index directions from the array_structure_list category */
+
+        done [1] = done [2] = done[3] = 0;
+
+        direction [1] = direction [2] = direction [3] = 1;
+
+        /* If no array_id, use default directions */
+
+        if (array_id) {
 
         cbf_failnez (cbf_find_category (handle, "array_structure_list"))
         if (cbf_find_column   (handle, "array_id")) {
@@ -4825,2151 +4898,3612 @@ extern "C" {
 
                 return CBF_FORMAT;
 
-            cbf_failnez (cbf_find_column      (handle, "dimension"))
-            cbf_failnez (cbf_set_integervalue (handle, dimension [precedence]))
+            code = cbf_find_column (handle, "direction");
+
+            if (code == 0)
+            {
+                cbf_failnez (cbf_get_value (handle, &direction_string))
+
+                if (cbf_cistrcmp ("decreasing", direction_string) == 0)
+
+                    direction [precedence] = -1;
+            }
+            else
+
+                if (code != CBF_NOTFOUND)
+
+                    return code;
+
+            if (done [precedence])
+
+                return CBF_FORMAT;
 
             done [precedence] = 1;
 
-            cbf_failnez (cbf_find_column (handle, "array_id"))
+            if (cbf_find_column   (handle, "array_id")) {
+                cbf_failnez(cbf_find_column (handle, "array_section"));
+            }
         }
 
-        if (!done [1] || !done [2] || !done[3])
+        if (!done [1])
 
             return CBF_NOTFOUND;
 
+        if (!done [2])
+        {
+            dir1 = direction [1];
 
-        /* Get the binary_id */
+            dir2 = 1;
+        }
+        else
+        {
+            dir1 = direction [2];
 
-        cbf_failnez (cbf_require_category (handle, "array_data"))
-        cbf_failnez (cbf_require_column   (handle, "array_id"))
-        cbf_failnez (cbf_rewind_row       (handle))
-        if (cbf_find_row (handle, array_id)) {
-            cbf_failnez (cbf_new_row(handle))
-            cbf_failnez (cbf_set_value(handle,array_id))
+            dir2 = direction [1];
         }
-        cbf_failnez (cbf_require_column   (handle, "binary_id"))
-        if (binary_id)  {
-            if (*binary_id == 0) *binary_id = 1;
-            while (1) {
-                if ( cbf_get_integervalue(handle,&local_binary_id)
-                    || local_binary_id == 0) local_binary_id = 1;
-                if ( local_binary_id != *binary_id ) {
-                    cbf_failnez (cbf_find_column(handle, "array_id"))
-                    if (cbf_find_nextrow(handle, array_id)) {
-                        cbf_failnez (cbf_new_row( handle ))
-                        cbf_failnez (cbf_set_value(handle,array_id))
-                        cbf_failnez (cbf_find_column (handle, "binary_id"))
-                        cbf_failnez (cbf_set_integervalue (handle, *binary_id))
-                        break;
-                    }
-                    cbf_failnez (cbf_find_column(handle, "binary_id"))
-                } else {
-                    break;
-                }
-            }
+
+        if (!done [3])
+        {
+            dir3 = 1;
         }
         else
         {
-            if (cbf_get_integervalue (handle, &local_binary_id)) {
-                local_binary_id = 1;
-                cbf_failnez (cbf_set_integervalue (handle, local_binary_id))
-            }
-        }
-        cbf_failnez (cbf_find_column      (handle, "data"))
+            dir3 = dir2;
 
+            dir2 = dir1;
 
-        /* Save the array */
+            dir1 = direction [3];
+        }
 
-        if (eltype == CBF_INTEGER)   {
+        }
 
-            cbf_failnez (cbf_set_integerarray_wdims (handle, compression, *binary_id,
-                                                     array, elsize, elsign,
-                                                     dimension [1] * dimension [2] * dimension [3],
-                                                     "little_endian",
-                                                     dimension[1],
-                                                     (dimension[3]>1||dimension[2]>1)?dimension[2]:0,
-                                                     dimension[3]>1?dimension[3]:0,0 ))
-        } else {
 
-            cbf_failnez (cbf_set_realarray_wdims (handle, compression, *binary_id,
-                                                  array, elsize,
-                                                  dimension [1] * dimension [2] * dimension [3],
-                                                  "little_endian",
-                                                  dimension[1],
-                                                  (dimension[3]>1||dimension[2]>1)?dimension[2]:0,
-                                                  dimension[3]>1?dimension[3]:0,0 ))
-        }
+        /* Find the binary data */
 
-        /* Update the array_structure category */
+        cbf_failnez (cbf_find_category (handle, "array_data"))
 
-        cbf_failnez (cbf_require_category (handle, "array_structure"))
-        cbf_failnez (cbf_require_column   (handle, "id"))
-        cbf_failnez (cbf_rewind_row       (handle))
-        if (cbf_find_row (handle, array_id)) {
-            cbf_failnez (cbf_new_row(handle))
-            cbf_failnez (cbf_set_value(handle,array_id))
-            cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-        }
-        cbf_failnez (cbf_require_column   (handle, "encoding_type"))
-        if (eltype == CBF_INTEGER) {
-            if (elsign) {
-                sprintf(enctype,"signed %d-bit integer", ((int)elsize)*8);
-            } else {
-                sprintf(enctype,"unsigned %d-bit integer", ((int)elsize)*8);
-            }
+        if (array_id) {
+            cbf_failnez (cbf_find_column   (handle, "array_id"))
+            cbf_failnez (cbf_find_row      (handle, array_id))
         } else {
-            sprintf(enctype,"signed %d-bit real IEEE", ((int)elsize)*8);
-        }
-        cbf_failnez (cbf_set_value        (handle,enctype))
-        cbf_failnez (cbf_set_typeofvalue  (handle,"dblq"))
-        cbf_failnez (cbf_require_column   (handle, "compression_type"))
-        switch (compression&CBF_COMPRESSION_MASK) {
-            case (CBF_NONE):
-                cbf_failnez (cbf_set_value      (handle,"none"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            case (CBF_CANONICAL):
-                cbf_failnez (cbf_set_value      (handle,"canonical"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            case (CBF_PACKED):
-                cbf_failnez (cbf_set_value      (handle,"packed"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            case (CBF_PACKED_V2):
-                cbf_failnez (cbf_set_value      (handle,"packed_v2"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            case (CBF_BYTE_OFFSET):
-                cbf_failnez (cbf_set_value      (handle,"byte_offsets"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            case (CBF_NIBBLE_OFFSET):
-                cbf_failnez (cbf_set_value      (handle,"nibble_offset"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            case (CBF_PREDICTOR):
-                cbf_failnez (cbf_set_value      (handle,"predictor"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-                break;
-            default:
-                cbf_failnez (cbf_set_value      (handle,"."))
-                cbf_failnez (cbf_set_typeofvalue(handle,"null"))
-                break;
-        }
-        if (compression&CBF_FLAG_MASK) {
-            if (compression&CBF_UNCORRELATED_SECTIONS) {
-                cbf_failnez (cbf_require_column   (handle, "compression_type_flag"))
-                cbf_failnez (cbf_set_value        (handle, "uncorrelated_sections"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-            } else if (compression&CBF_FLAT_IMAGE)  {
-                cbf_failnez (cbf_require_column   (handle, "compression_type_flag"))
-                cbf_failnez (cbf_set_value        (handle, "flat"))
-                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
-            }
-            else return CBF_ARGUMENT;
+            cbf_failnez(cbf_rewind_row(handle));
         }
 
-        cbf_failnez (cbf_require_column     (handle, "byte_order"))
-        cbf_failnez (cbf_set_value          (handle, "little_endian"))
+        if ( binary_id && *binary_id != 0) {
 
+            if (cbf_find_column(handle, "binary_id")) {
 
-        return 0;
-    }
+                if ( *binary_id !=0 && *binary_id != 1 ) return CBF_NOTFOUND;
 
+            } else {
 
-    /* Count the ancestors of an axis */
+                while (1)  {
+                    if (cbf_get_integervalue( handle, &local_binary_id) ||
+                        local_binary_id == 0) local_binary_id = 1;
+                    if (local_binary_id != *binary_id) {
+                        cbf_failnez (cbf_find_column   (handle, "array_id"))
+                        if (cbf_find_nextrow  (handle, array_id)) return CBF_NOTFOUND;
+                        cbf_failnez (cbf_find_column(handle, "binary_id"))
+                    } else break;
+                }
+            }
+        }
 
-    int cbf_count_axis_ancestors (cbf_handle handle,
-                               const char *axis_id,
-                               unsigned int *ancestors) {
+        cbf_failnez (cbf_find_column   (handle, "data"))
 
-        const char * cur_axis;
-        const char * depends_on;
-        const char * deptype;
-        int curlevel;
-        unsigned int maxlevel;
+        /* Read the binary data */
 
-        /* Check for valid arguments */
+        if ( ndimslow <= 0 || ndimmid  <= 0 ||  ndimfast <= 0)
 
-        if (!handle || !axis_id || !ancestors ) return CBF_ARGUMENT;
+            return CBF_ARGUMENT;
 
-        /* Get the axis dependencies */
+        if (eltype == CBF_INTEGER) {
+            cbf_failnez (cbf_get_integerarray (handle, &local_binary_id,
+                                               array, elsize, elsign, ndimslow * ndimmid * ndimfast, &nelem_read))
+        } else {
+            cbf_failnez (cbf_get_realarray (handle, &local_binary_id,
+                                            array, elsize, ndimslow * ndimmid * ndimfast, &nelem_read))
+        }
 
-        cbf_failnez (cbf_find_category (handle, "axis"));
-        cbf_failnez (cbf_count_rows(handle,&maxlevel));
-        if (maxlevel < 1) return CBF_FORMAT;
-        maxlevel --;
-        curlevel = maxlevel;
-        cbf_failnez (cbf_find_column   (handle, "id"));
-        cbf_failnez (cbf_find_row      (handle, axis_id));
-        cbf_failnez (cbf_get_value     (handle, &cur_axis));
+        if ( binary_id ) *binary_id = local_binary_id;
 
-        *ancestors = 0;
 
-        while (curlevel >= 0) {
+        /* Reorder the data if necessary */
 
-            if (curlevel==0
-                || cbf_find_column   (handle, "depends_on")
-                || cbf_get_value     (handle, &depends_on)
-                || !(depends_on)
-                || cbf_get_typeofvalue(handle, &deptype)
-                || !cbf_cistrcmp(deptype,"null")) {
-                
-                return CBF_SUCCESS;
+#ifndef CBF_0721_READS
+
+        if (dir1 < 0 || dir2 < 0 || dir3 < 0 )
+        {
+            if (dir1 >= 0)
+            {
+                start1 = 0;
+                end1 = ndimslow;
+                inc1 = 1;
+            }
+            else
+            {
+                start1 = ndimslow - 1;
+                end1 = -1;
+                inc1 = -1;
             }
-            
-            if ( !cbf_cistrcmp(depends_on,".")
-                 || !cbf_cistrcmp(depends_on,"?") ){
-                
-                cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
-                                 depends_on,
-                                 axis_id);
-                
-                return CBF_SUCCESS;
 
+            if (dir2 >= 0)
+            {
+                start2 = 0;
+                end2 = ndimmid;
+                inc2 = 1;
+            }
+            else
+            {
+                start2 = ndimmid - 1;
+                end2 = -1;
+                inc2 = -1;
             }
 
-            cur_axis = depends_on;
-            curlevel--;
-            (*ancestors)++;
-            cbf_failnez (cbf_find_column(handle, "id"));
-            cbf_failnez (cbf_find_row   (handle, cur_axis));
+            if (dir3 >= 0)
+            {
+                start3 = 0;
+                end3 = ndimfast;
+                inc3 = 1;
+            }
+            else
+            {
+                start3 = ndimfast - 1;
+                end3 = -1;
+                inc3 = -1;
+            }
+
+
+            pixel = (char *) array;
+
+            for (index1 = start1; index1 != end1; index1 += inc1)
+
+                for (index2 = start2; index2 != end2; index2 += inc2)
+
+                    for (index3 = start3; index3 != end3; index3 += inc3)
+                    {
+                        pixel2 = ((char *) array) + (index1*ndimmid*ndimfast + index2 * ndimfast + index3) * elsize;
+
+                        if (pixel < pixel2) {
+
+                            if (elsize == sizeof (int))
+                            {
+                                *((int *) tmp)    = *((int *) pixel);
+                                *((int *) pixel)  = *((int *) pixel2);
+                                *((int *) pixel2) = *((int *) tmp);
+                            }
+                            else
+                            {
+                                memcpy (tmp, pixel, elsize);
+                                memcpy (pixel, pixel2, elsize);
+                                memcpy (pixel2, tmp, elsize);
+                            }
+
+                        }
 
+                        pixel += elsize;
+                    }
         }
-        return CBF_FORMAT;
 
+#endif
+
+        if (ndimslow * ndimmid * ndimfast != nelem_read)
+
+            return CBF_ENDOFDATA;
+
+        return 0;
     }
 
 
-    /* Get the specified ancestor of an axis */
 
-    int cbf_get_axis_ancestor (cbf_handle handle,
-                               const char *axis_id,
-                               const unsigned int ancestor_index,
-                               const char * *ancestor) {
+    /* Save a 3D array.
+     ndimslow is the slowest dimension,
+     ndimmid is the next faster dimension,
+     ndimfast is the fastest dimension */
 
-        const char * cur_axis;
-        const char * depends_on;
-        const char * deptype;
-        int curlevel;
+    int cbf_set_3d_array (cbf_handle    handle,
+                          unsigned int  reserved,
+                          const char   *array_id,
+                          int          *binary_id,
+                          unsigned int  compression,
+                          void         *array,
+                          int           eltype,
+                          size_t        elsize,
+                          int           elsign,
+                          size_t        ndimslow,
+                          size_t        ndimmid,
+                          size_t        ndimfast)
+    {
 
-        /* Check for valid arguments */
+        char enctype[30];
+        
+        const char * xarray_id;
 
-        if (!handle || !axis_id || !ancestor ) return CBF_ARGUMENT;
+        int local_binary_id, done [4], precedence, dimension [4];
 
-        *ancestor = NULL;
-        curlevel = ancestor_index;
+        if (reserved != 0)
 
-        /* Get the axis dependencies */
+            return CBF_ARGUMENT;
 
-        cbf_failnez (cbf_find_category (handle, "axis"));
-        cbf_failnez (cbf_find_column   (handle, "id"));
-        cbf_failnez (cbf_find_row      (handle, axis_id));
-        cbf_failnez (cbf_get_value     (handle, &cur_axis));
+        if ( eltype != CBF_FLOAT && eltype != CBF_INTEGER)
 
-        while (curlevel >= 0) {
+            return CBF_ARGUMENT;
+
+        if ( eltype == CBF_FLOAT && elsize != 4 && elsize != 8 )
+
+            return CBF_ARGUMENT;
+
+        if ( eltype == CBF_FLOAT && !elsign)
+
+            return CBF_ARGUMENT;
+
+        /* Update the array_structure_list category */
+
+        if (ndimslow == 0)
+
+            dimension [3] = 1;
+
+        else
+
+            dimension [3] = ndimslow;
+
+        if (ndimmid == 0)
+
+            dimension [2] = 1;
+
+        else
+
+            dimension [2] = ndimmid;
+
+        if (ndimfast == 0)
+
+            dimension [1] = 1;
+
+        else
+
+            dimension [1] = ndimfast;
+
+
+        done [1] = dimension [1] == 1;
+        done [2] = dimension [2] == 1;
+        done [3] = dimension [3] == 1;
+        
+        /* See if the array_id is actually an array_section_id */
+        
+        cbf_failnez(cbf_get_array_section_array_id(handle,array_id,&xarray_id));
+        
+        if (cbf_cistrcmp(array_id,xarray_id)) {
             
-            if (curlevel==0
-                || cbf_find_column   (handle, "depends_on")
-                || cbf_get_value     (handle, &depends_on)
-                || !((depends_on)[0])
-                || cbf_get_typeofvalue(handle, &deptype)
-                || !cbf_cistrcmp(deptype,"null")) {
-                
-                if (curlevel > 0) return CBF_NOTFOUND;
-                *ancestor = cur_axis;
-                return CBF_SUCCESS;
-                
-                
-            }
-            if (!cbf_cistrcmp(depends_on,".")
-                || !cbf_cistrcmp(depends_on,"?")){
-                
-                cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
-                                 depends_on,
-                                 axis_id);
-                
+            /* This is actually an array section.  To write the section,
+             we need the full array.  If it does not exist, we have to
+             start it off as an array of zeros.  In either case we can then
+             insert the section into it and write it back.  */
+            
+            cbf_section_plan plan;
+            
+            size_t xtotalbytes;
+            
+            void * temparray;
+            
+            int errorcode;
+            
+            cbf_failnez (cbf_make_section_plan (handle, xarray_id, &array_id, 1, &plan));
+            
+            xtotalbytes = plan->dimslow*plan->dimmid*plan->dimfast*elsize;
+            
+            errorcode = cbf_alloc(&temparray,NULL,1,xtotalbytes);
+            
+            if (errorcode)
+            
+                return errorcode | cbf_free_section_plan(plan);
+            
+            if (cbf_get_3d_array(handle, reserved,
+                                 xarray_id,
+                                 binary_id,
+                                 temparray,
+                                 eltype,
+                                 elsize,
+                                 elsign,
+                                 plan->dimslow,
+                                 plan->dimmid,
+                                 plan->dimfast)) {
                 
-                if (curlevel > 0) return CBF_NOTFOUND;
-                *ancestor = cur_axis;
-                return CBF_SUCCESS;
+                memset(temparray,0,xtotalbytes);
                 
             }
             
-            cur_axis = depends_on;
+            /* store the section a row at a time */
+            
+            errorcode = cbf_assemble_array_sections(plan,array,elsize,temparray);
+            
+            /* Now write back the entire array */
+            
+            if (!errorcode)
+            
+                errorcode = cbf_set_3d_array ( handle, reserved, xarray_id,
+                                              binary_id, compression,temparray,
+                                              eltype,elsize,elsign,
+                                              plan->dimslow,plan->dimmid,plan->dimfast);
+            
+            errorcode |= cbf_free(&temparray,NULL);
+            
+            return errorcode | cbf_free_section_plan(plan);
+            
+        }
+
+        cbf_failnez (cbf_find_category (handle, "array_structure_list"))
+        if (cbf_find_column   (handle, "array_id")) {
+            cbf_failnez(cbf_find_column (handle, "array_section"));
+        }
+
+        while (cbf_find_nextrow (handle, array_id) == 0)
+        {
+            cbf_failnez (cbf_find_column      (handle, "precedence"))
+            cbf_failnez (cbf_get_integervalue (handle, &precedence))
+
+            if (precedence < 1 || precedence > 3)
+
+                return CBF_FORMAT;
+
+            cbf_failnez (cbf_find_column      (handle, "dimension"))
+            cbf_failnez (cbf_set_integervalue (handle, dimension [precedence]))
+
+            done [precedence] = 1;
+
+            cbf_failnez (cbf_find_column (handle, "array_id"))
+        }
+
+        if (!done [1] || !done [2] || !done[3])
+
+            return CBF_NOTFOUND;
+
+
+        /* Get the binary_id */
+
+        cbf_failnez (cbf_require_category (handle, "array_data"))
+        cbf_failnez (cbf_require_column   (handle, "array_id"))
+        cbf_failnez (cbf_rewind_row       (handle))
+        if (cbf_find_row (handle, array_id)) {
+            cbf_failnez (cbf_new_row(handle))
+            cbf_failnez (cbf_set_value(handle,array_id))
+        }
+        cbf_failnez (cbf_require_column   (handle, "binary_id"))
+        if (binary_id)  {
+            if (*binary_id == 0) *binary_id = 1;
+            while (1) {
+                if ( cbf_get_integervalue(handle,&local_binary_id)
+                    || local_binary_id == 0) local_binary_id = 1;
+                if ( local_binary_id != *binary_id ) {
+                    cbf_failnez (cbf_find_column(handle, "array_id"))
+                    if (cbf_find_nextrow(handle, array_id)) {
+                        cbf_failnez (cbf_new_row( handle ))
+                        cbf_failnez (cbf_set_value(handle,array_id))
+                        cbf_failnez (cbf_find_column (handle, "binary_id"))
+                        cbf_failnez (cbf_set_integervalue (handle, *binary_id))
+                        break;
+                    }
+                    cbf_failnez (cbf_find_column(handle, "binary_id"))
+                } else {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            if (cbf_get_integervalue (handle, &local_binary_id)) {
+                local_binary_id = 1;
+                cbf_failnez (cbf_set_integervalue (handle, local_binary_id))
+            }
+        }
+        cbf_failnez (cbf_find_column      (handle, "data"))
+
+
+        /* Save the array */
+
+        if (eltype == CBF_INTEGER)   {
+
+            cbf_failnez (cbf_set_integerarray_wdims (handle, compression, *binary_id,
+                                                     array, elsize, elsign,
+                                                     dimension [1] * dimension [2] * dimension [3],
+                                                     "little_endian",
+                                                     dimension[1],
+                                                     (dimension[3]>1||dimension[2]>1)?dimension[2]:0,
+                                                     dimension[3]>1?dimension[3]:0,0 ))
+        } else {
+
+            cbf_failnez (cbf_set_realarray_wdims (handle, compression, *binary_id,
+                                                  array, elsize,
+                                                  dimension [1] * dimension [2] * dimension [3],
+                                                  "little_endian",
+                                                  dimension[1],
+                                                  (dimension[3]>1||dimension[2]>1)?dimension[2]:0,
+                                                  dimension[3]>1?dimension[3]:0,0 ))
+        }
+
+        /* Update the array_structure category */
+
+        cbf_failnez (cbf_require_category (handle, "array_structure"))
+        cbf_failnez (cbf_require_column   (handle, "id"))
+        cbf_failnez (cbf_rewind_row       (handle))
+        if (cbf_find_row (handle, array_id)) {
+            cbf_failnez (cbf_new_row(handle))
+            cbf_failnez (cbf_set_value(handle,array_id))
+            cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+        }
+        cbf_failnez (cbf_require_column   (handle, "encoding_type"))
+        if (eltype == CBF_INTEGER) {
+            if (elsign) {
+                sprintf(enctype,"signed %d-bit integer", ((int)elsize)*8);
+            } else {
+                sprintf(enctype,"unsigned %d-bit integer", ((int)elsize)*8);
+            }
+        } else {
+            sprintf(enctype,"signed %d-bit real IEEE", ((int)elsize)*8);
+        }
+        cbf_failnez (cbf_set_value        (handle,enctype))
+        cbf_failnez (cbf_set_typeofvalue  (handle,"dblq"))
+        cbf_failnez (cbf_require_column   (handle, "compression_type"))
+        switch (compression&CBF_COMPRESSION_MASK) {
+            case (CBF_NONE):
+                cbf_failnez (cbf_set_value      (handle,"none"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            case (CBF_CANONICAL):
+                cbf_failnez (cbf_set_value      (handle,"canonical"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            case (CBF_PACKED):
+                cbf_failnez (cbf_set_value      (handle,"packed"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            case (CBF_PACKED_V2):
+                cbf_failnez (cbf_set_value      (handle,"packed_v2"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            case (CBF_BYTE_OFFSET):
+                cbf_failnez (cbf_set_value      (handle,"byte_offsets"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            case (CBF_NIBBLE_OFFSET):
+                cbf_failnez (cbf_set_value      (handle,"nibble_offset"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            case (CBF_PREDICTOR):
+                cbf_failnez (cbf_set_value      (handle,"predictor"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+                break;
+            default:
+                cbf_failnez (cbf_set_value      (handle,"."))
+                cbf_failnez (cbf_set_typeofvalue(handle,"null"))
+                break;
+        }
+        if (compression&CBF_FLAG_MASK) {
+            if (compression&CBF_UNCORRELATED_SECTIONS) {
+                cbf_failnez (cbf_require_column   (handle, "compression_type_flag"))
+                cbf_failnez (cbf_set_value        (handle, "uncorrelated_sections"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+            } else if (compression&CBF_FLAT_IMAGE)  {
+                cbf_failnez (cbf_require_column   (handle, "compression_type_flag"))
+                cbf_failnez (cbf_set_value        (handle, "flat"))
+                cbf_failnez (cbf_set_typeofvalue(handle,"word"))
+            }
+            else return CBF_ARGUMENT;
+        }
+
+        cbf_failnez (cbf_require_column     (handle, "byte_order"))
+        cbf_failnez (cbf_set_value          (handle, "little_endian"))
+
+
+        return 0;
+    }
+
+
+    /* Count the ancestors of an axis */
+
+    int cbf_count_axis_ancestors (cbf_handle handle,
+                               const char *axis_id,
+                               unsigned int *ancestors) {
+
+        const char * cur_axis;
+        const char * depends_on;
+        const char * deptype;
+        int curlevel;
+        unsigned int maxlevel;
+
+        /* Check for valid arguments */
+
+        if (!handle || !axis_id || !ancestors ) return CBF_ARGUMENT;
+
+        /* Get the axis dependencies */
+
+        cbf_failnez (cbf_find_category (handle, "axis"));
+        cbf_failnez (cbf_count_rows(handle,&maxlevel));
+        if (maxlevel < 1) return CBF_FORMAT;
+        maxlevel --;
+        curlevel = maxlevel;
+        cbf_failnez (cbf_find_column   (handle, "id"));
+        cbf_failnez (cbf_find_row      (handle, axis_id));
+        cbf_failnez (cbf_get_value     (handle, &cur_axis));
+
+        *ancestors = 0;
+
+        while (curlevel >= 0) {
+
+            if (curlevel==0
+                || cbf_find_column   (handle, "depends_on")
+                || cbf_get_value     (handle, &depends_on)
+                || !(depends_on)
+                || cbf_get_typeofvalue(handle, &deptype)
+                || !cbf_cistrcmp(deptype,"null")) {
+                
+                return CBF_SUCCESS;
+            }
+            
+            if ( !cbf_cistrcmp(depends_on,".")
+                 || !cbf_cistrcmp(depends_on,"?") ){
+                
+                cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
+                                 depends_on,
+                                 axis_id);
+                
+                return CBF_SUCCESS;
+
+            }
+
+            cur_axis = depends_on;
             curlevel--;
+            (*ancestors)++;
             cbf_failnez (cbf_find_column(handle, "id"));
             cbf_failnez (cbf_find_row   (handle, cur_axis));
-            
+
         }
-        return CBF_NOTFOUND;
+        return CBF_FORMAT;
+
+    }
+
+
+    /* Get the specified ancestor of an axis */
+
+    int cbf_get_axis_ancestor (cbf_handle handle,
+                               const char *axis_id,
+                               const unsigned int ancestor_index,
+                               const char * *ancestor) {
+
+        const char * cur_axis;
+        const char * depends_on;
+        const char * deptype;
+        int curlevel;
+
+        /* Check for valid arguments */
+
+        if (!handle || !axis_id || !ancestor ) return CBF_ARGUMENT;
+
+        *ancestor = NULL;
+        curlevel = ancestor_index;
+
+        /* Get the axis dependencies */
+
+        cbf_failnez (cbf_find_category (handle, "axis"));
+        cbf_failnez (cbf_find_column   (handle, "id"));
+        cbf_failnez (cbf_find_row      (handle, axis_id));
+        cbf_failnez (cbf_get_value     (handle, &cur_axis));
+
+        while (curlevel >= 0) {
+            
+            if (curlevel==0
+                || cbf_find_column   (handle, "depends_on")
+                || cbf_get_value     (handle, &depends_on)
+                || !((depends_on)[0])
+                || cbf_get_typeofvalue(handle, &deptype)
+                || !cbf_cistrcmp(deptype,"null")) {
+                
+                if (curlevel > 0) return CBF_NOTFOUND;
+                *ancestor = cur_axis;
+                return CBF_SUCCESS;
+                
+                
+            }
+            if (!cbf_cistrcmp(depends_on,".")
+                || !cbf_cistrcmp(depends_on,"?")){
+                
+                cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
+                                 depends_on,
+                                 axis_id);
+                
+                
+                if (curlevel > 0) return CBF_NOTFOUND;
+                *ancestor = cur_axis;
+                return CBF_SUCCESS;
+                
+            }
+            
+            cur_axis = depends_on;
+            curlevel--;
+            cbf_failnez (cbf_find_column(handle, "id"));
+            cbf_failnez (cbf_find_row   (handle, cur_axis));
+            
+        }
+        return CBF_NOTFOUND;
+
+    }
+
+
+    /* Get the axis, if any, on which this axis depends
+     Will always return "." for the null case */
+
+    int cbf_get_axis_depends_on (cbf_handle handle, const char *axis_id,
+                                 const char * *depends_on)
+    {
+        
+        const char * deptype;
+        
+        /* Check for valid arguments */
+        
+        if (!handle || !depends_on) return CBF_ARGUMENT;
+        
+        
+        /* Get the axis dependency */
+        
+        cbf_failnez (cbf_find_category (handle, "axis"))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_find_row      (handle, axis_id))
+        
+        if (cbf_find_column   (handle, "depends_on")) {
+            
+            *depends_on = ".";  return CBF_SUCCESS;
+
+        }
+        
+        if (cbf_get_value     (handle, depends_on)
+            || !(*depends_on)) {
+            
+            *depends_on = ".";  return CBF_SUCCESS;
+            
+        }
+        
+        if (cbf_get_typeofvalue(handle,&deptype)
+            || !cbf_cistrcmp(deptype,"null")) {
+            
+            *depends_on = ".";  return CBF_SUCCESS;
+            
+        }
+        
+        
+        if (!cbf_cistrcmp(*depends_on,".")
+            || !cbf_cistrcmp(*depends_on,"?")) {
+            
+            cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
+                             *depends_on,
+                             axis_id);
+
+            
+            *depends_on = ".";  return CBF_SUCCESS;
+            
+        }
+        
+        return CBF_SUCCESS;
+        
+    }
+
+
+
+    /* Get the axis equipment */
+
+    int cbf_get_axis_equipment (cbf_handle handle, const char *axis_id,
+                           const char * *equipment)
+    {
+
+        /* Get the axis equipment */
+        
+        cbf_failnez (cbf_find_category (handle, "axis"))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_find_row      (handle, axis_id))
+        if (cbf_find_column   (handle, "equipment")) {
+            *equipment = ".";  return CBF_SUCCESS;
+        }
+        if (cbf_get_value     (handle, equipment)
+            || !(*equipment)
+            || !((*equipment)[0])) {
+            *equipment = ".";  return CBF_SUCCESS;
+        }
+        return CBF_SUCCESS;
+
+    }
+
+    /* Get the axis equipment_component */
+
+    int cbf_get_axis_equipment_component (cbf_handle handle,
+                                          const char *axis_id,
+                                const char * *equipment_component)
+    {
+
+        /* Get the axis equipment component */
+        
+        cbf_failnez (cbf_find_category (handle, "axis"))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_find_row      (handle, axis_id))
+        if (cbf_find_column   (handle, "equipment_component")) {
+            *equipment_component = ".";  return CBF_SUCCESS;
+        }
+        if (cbf_get_value     (handle, equipment_component)||
+            !((*equipment_component)[0])) {
+            *equipment_component = ".";  return CBF_SUCCESS;
+        }
+        return CBF_SUCCESS;
+
+    }
+
+    /* Get an axis rotation */
+
+    int cbf_get_axis_rotation (cbf_handle handle, const char *axis_id,
+                               double *rotation)
+    {
+        if (!handle || !axis_id || !rotation )
+            return CBF_ARGUMENT;
+
+        /* Read from the axis category */
+
+        cbf_failnez (cbf_find_category   (handle, "axis"))
+        cbf_failnez (cbf_find_column     (handle, "id"))
+        cbf_failnez (cbf_find_row        (handle, axis_id))
+        if (cbf_find_column( handle, "rotation")) {
+
+            *rotation = 0.0;
+            return CBF_SUCCESS;
+
+        }
+
+        if (cbf_get_doublevalue (handle, rotation)) *rotation = 0.;
+
+        return 0;
+
+    }
+
+
+    /* Get the axis rotation_axis */
+
+    int cbf_get_axis_rotation_axis (cbf_handle handle,
+                                          const char *axis_id,
+                                          const char * *rotation_axis)
+    {
+
+        /* Get the axis rotation_axis */
+
+        cbf_failnez (cbf_find_category (handle, "axis"))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_find_row      (handle, axis_id))
+        if (cbf_find_column   (handle, "rotation_axis")) {
+            *rotation_axis = ".";  return CBF_SUCCESS;
+        }
+        if (cbf_get_value     (handle, rotation_axis)||
+            !((*rotation_axis)[0])) {
+            *rotation_axis = ".";  return CBF_SUCCESS;
+        }
+        return CBF_SUCCESS;
+
+    }
+
+
+
+    /* Get an axis offset */
+
+    int cbf_get_axis_offset (cbf_handle handle, const char *axis_id,
+                             double *offset1,
+                             double *offset2,
+                             double *offset3)
+    {
+        if (!handle || !axis_id || !offset1 || !offset2 || !offset3)
+            return CBF_ARGUMENT;
+
+        /* Read from the axis category */
+
+        cbf_failnez (cbf_find_category   (handle, "axis"))
+        cbf_failnez (cbf_find_column     (handle, "id"))
+        cbf_failnez (cbf_find_row        (handle, axis_id))
+        cbf_failnez (cbf_find_column     (handle, "offset[1]"))
+        if (cbf_get_doublevalue (handle, offset1)) *offset1 = 0.;
+        cbf_failnez (cbf_find_column     (handle, "offset[2]"))
+        if (cbf_get_doublevalue (handle, offset2)) *offset2 = 0.;
+        cbf_failnez (cbf_find_column     (handle, "offset[3]"))
+        if (cbf_get_doublevalue (handle, offset3)) *offset3 = 0.;
+
+        return 0;
+    }
+
+
+
+
+
+    /* Get the type of an axis */
+
+    int cbf_get_axis_type (cbf_handle handle, const char *axis_id,
+                           cbf_axis_type *axis_type)
+    {
+        const char *type;
+
+
+        /* Get the axis type */
+
+        cbf_failnez (cbf_find_category (handle, "axis"))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_find_row      (handle, axis_id))
+        cbf_failnez (cbf_find_column   (handle, "type"))
+        cbf_failnez (cbf_get_value     (handle, &type))
+
+        if (!type)
+
+            return CBF_NOTFOUND;
+
+        if (toupper (*type) != 'T' &&
+            toupper (*type) != 'R' &&
+            toupper (*type) != 'G')
+
+            return CBF_FORMAT;
+
+        if (axis_type) {
+
+            if (toupper (*type) == 'T') {
+
+                *axis_type = CBF_TRANSLATION_AXIS;
+
+            } else {
+
+                if (toupper (*type) == 'R') {
+
+                    *axis_type = CBF_ROTATION_AXIS;
+
+                } else {
+
+                    *axis_type = CBF_GENERAL_AXIS;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    /* Get an axis vector */
+
+    int cbf_get_axis_vector (cbf_handle handle, const char *axis_id,
+                             double *vector1,
+                             double *vector2,
+                             double *vector3)
+    {
+        if (!handle || !axis_id || !vector1 || !vector2 || !vector3)
+            return CBF_ARGUMENT;
+
+        /* Read from the axis category */
+
+        cbf_failnez (cbf_find_category   (handle, "axis"))
+        cbf_failnez (cbf_find_column     (handle, "id"))
+        cbf_failnez (cbf_find_row        (handle, axis_id))
+        cbf_failnez (cbf_find_column     (handle, "vector[1]"))
+        if (cbf_get_doublevalue (handle, vector1)) *vector1 = 0.;
+        cbf_failnez (cbf_find_column     (handle, "vector[2]"))
+        if (cbf_get_doublevalue (handle, vector2)) *vector2 = 0.;
+        cbf_failnez (cbf_find_column     (handle, "vector[3]"))
+        if (cbf_get_doublevalue (handle, vector3)) *vector3 = 0.;
+
+        return 0;
+    }
+
+
+    /* Get the setting of an axis */
+
+    int cbf_get_axis_setting (cbf_handle handle, unsigned int  reserved,
+                              const char   *axis_id,
+                              double       *start,
+                              double       *increment)
+    {
+        cbf_axis_type type;
+
+        if (reserved != 0)
+
+            return CBF_ARGUMENT;
+
+
+        /* Get the axis type */
+
+        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+
+        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+
+            return CBF_FORMAT;
+
+
+        /* Read from the diffrn_scan_axis and
+         diffrn_scan_frame_axis categories */
+
+        if (type == CBF_TRANSLATION_AXIS)
+        {
+            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_find_row        (handle, axis_id))
+            cbf_failnez (cbf_find_column     (handle, "displacement"))
+            cbf_failnez (cbf_get_doublevalue (handle, start))
+
+            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_find_row        (handle, axis_id))
+            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_get_doublevalue (handle, increment))
+        }
+        else
+        {
+            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_find_row        (handle, axis_id))
+            cbf_failnez (cbf_find_column     (handle, "angle"))
+            cbf_failnez (cbf_get_doublevalue (handle, start))
+
+            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_find_row        (handle, axis_id))
+            cbf_failnez (cbf_find_column     (handle, "angle_increment"))
+            cbf_failnez (cbf_get_doublevalue (handle, increment))
+        }
+
+        return 0;
+    }
+
+
+
+
+    /* Get the reference setting of an axis */
+
+    int cbf_get_axis_reference_setting (cbf_handle handle, unsigned int  reserved,
+                                        const char   *axis_id,
+                                        double       *refsetting)
+    {
+        cbf_axis_type type;
+
+        if (reserved != 0 || !refsetting || !axis_id )
+
+            return CBF_ARGUMENT;
+
+        /* Get the axis type */
+
+        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+
+        if (type == CBF_GENERAL_AXIS || !cbf_cistrcmp(axis_id,".")) {
+
+            *refsetting = 0.;
+
+        }
+
+        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+
+            return CBF_FORMAT;
+
+
+        /* Read from the diffrn_scan_axis and
+         diffrn_scan_frame_axis categories */
+
+        if (type == CBF_TRANSLATION_AXIS)
+        {
+            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_find_row        (handle, axis_id))
+            *refsetting = 0.;
+            if (!cbf_find_column (handle, "reference_displacement")) {
+                if (cbf_get_doublevalue (handle, refsetting)) {
+                    if (!cbf_find_column (handle, "displacement")) {
+                        if (cbf_get_doublevalue (handle, refsetting)) {
+                            *refsetting = 0.;
+                        }
+                    }
+                }
+            } else {
+                if (!cbf_find_column (handle, "displacement")) {
+                    if (cbf_get_doublevalue (handle, refsetting)) {
+                        *refsetting = 0.;
+                    }
+                }
+                else  {
+                    cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
+                    cbf_failnez (cbf_find_column     (handle, "axis_id"))
+                    cbf_failnez (cbf_find_row        (handle, axis_id))
+                    if (!cbf_find_column (handle, "reference_displacement")) {
+                        if (cbf_get_doublevalue (handle, refsetting)) {
+                            if (!cbf_find_column (handle, "displacement")) {
+                                if (cbf_get_doublevalue (handle, refsetting)) {
+                                    *refsetting = 0.;
+                                }
+                            }
+                        }
+                    } else  {
+                        if (!cbf_find_column (handle, "displacement")) {
+                            if (cbf_get_doublevalue (handle, refsetting)) {
+                                *refsetting = 0.;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_find_row        (handle, axis_id))
+            *refsetting = 0.;
+            if (!cbf_find_column (handle, "reference_angle")) {
+                if (cbf_get_doublevalue (handle, refsetting)) {
+                    *refsetting = 0.;
+                }
+            } else {
+                cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
+                cbf_failnez (cbf_find_column     (handle, "axis_id"))
+                cbf_failnez (cbf_find_row        (handle, axis_id))
+                if (!cbf_find_column (handle, "reference_angle")) {
+                    if (cbf_get_doublevalue (handle, refsetting)) {
+                        *refsetting = 0.;
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+
+
+    /* Change the setting of an axis */
+
+    int cbf_set_axis_setting (cbf_handle handle, unsigned int  reserved,
+                              const char   *axis_id,
+                              double        start,
+                              double        increment)
+    {
+        cbf_axis_type type;
+
+        if (reserved != 0)
+
+            return CBF_ARGUMENT;
+
+
+        /* Get the axis type */
+
+        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+
+        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+
+            return CBF_FORMAT;
+
+
+        /* Update the diffrn_scan_axis and
+         diffrn_scan_frame_axis categories */
+
+        if (type == CBF_TRANSLATION_AXIS)
+        {
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "displacement"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
+            if (!cbf_find_column( handle, "displacement_increment")) {
+                cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
+            }
+
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "displacement_start"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
+            cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
+            cbf_failnez (cbf_require_column     (handle, "displacement_range"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
+        }
+        else
+        {
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "angle"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
+            if (!cbf_find_column     (handle, "angle_increment")) {
+                cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
+            }
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "angle_start"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
+            cbf_failnez (cbf_require_column     (handle, "angle_increment"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
+            cbf_failnez (cbf_require_column     (handle, "angle_range"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
+        }
+
+        return 0;
+    }
+
+
+    /* Change the reference setting of an axis */
+
+    int cbf_set_axis_reference_setting (cbf_handle handle, unsigned int  reserved,
+                                        const char   *axis_id,
+                                        double        refsetting)
+    {
+        cbf_axis_type type;
+
+        if (reserved != 0)
+
+            return CBF_ARGUMENT;
+
+
+        /* Get the axis type */
+
+        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+
+        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+
+            return CBF_FORMAT;
+
+
+        /* Update the diffrn_scan_axis and
+         diffrn_scan_frame_axis categories */
+
+        if (type == CBF_TRANSLATION_AXIS)
+        {
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "reference_displacement"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "reference_displacement"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+        }
+        else
+        {
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "reference_angle"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+
+            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_row        (handle, axis_id))
+            cbf_failnez (cbf_require_column     (handle, "reference_angle"))
+            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+        }
+
+        return 0;
+    }
+
+
+    /* Create a positioner */
+
+    static int cbf_make_positioner (cbf_positioner *positioner)
+    {
+        cbf_failnez (cbf_alloc ((void **) positioner, NULL,
+                                sizeof (cbf_positioner_struct), 1))
+
+        (*positioner)->matrix [0][0] = 1;
+        (*positioner)->matrix [0][1] = 0;
+        (*positioner)->matrix [0][2] = 0;
+        (*positioner)->matrix [0][3] = 0;
+        (*positioner)->matrix [1][0] = 0;
+        (*positioner)->matrix [1][1] = 1;
+        (*positioner)->matrix [1][2] = 0;
+        (*positioner)->matrix [1][3] = 0;
+        (*positioner)->matrix [2][0] = 0;
+        (*positioner)->matrix [2][1] = 0;
+        (*positioner)->matrix [2][2] = 1;
+        (*positioner)->matrix [2][3] = 0;
+
+        (*positioner)->axis = NULL;
+
+        (*positioner)->axes = 0;
+
+        (*positioner)->matrix_is_valid = 1;
+
+        (*positioner)->matrix_ratio_used = 0;
+
+        (*positioner)->axis_index_limit = 1000000;
+
+        return 0;
+    }
+
+
+    /* Free a positioner */
+
+    int cbf_free_positioner (cbf_positioner positioner)
+    {
+        int errorcode;
+
+        void *memblock;
+
+        void *vaxis;
+
+        void *vname;
+
+        void *adon, *arot;
+
+        size_t i;
+
+        memblock = (void *) positioner;
+
+        if (positioner)
+        {
+            errorcode = 0;
+
+            for (i = 0; i < positioner->axes; i++) {
+
+                vname = (void *)(positioner->axis [i].name);
+
+                errorcode |= cbf_free ((void **) &vname, NULL);
+
+                positioner->axis [i].name = NULL;
+
+                if (positioner->axis [i].depends_on) {
+
+                    adon = (void *)(positioner->axis [i].depends_on);
+
+                    errorcode |= cbf_free ((void **) &adon, NULL);
+
+                    positioner->axis [i].depends_on = NULL;
+
+                }
+
+                if (positioner->axis [i].rotation_axis) {
+
+                    arot = (void *)(positioner->axis [i].rotation_axis);
+
+                    errorcode |= cbf_free ((void **) &arot, NULL);
+
+                    positioner->axis [i].rotation_axis = NULL;
+
+            }
+
+            }
+
+            vaxis = (void *)positioner->axis;
+
+            errorcode |= cbf_free ((void **) &vaxis,
+                                   &positioner->axes);
+
+            positioner->axis = NULL;
+
+            return errorcode | cbf_free (&memblock, NULL);
+        }
+
+        return 0;
+    }
+
+
+     /* Add a positioner axis with rotation*/
+
+    static int cbf_add_positioner_axis_wrot (cbf_positioner positioner,
+                                 const char    *name,
+                                 const char    *depends_on,
+                                 const char    *rotation_axis,
+                                 cbf_axis_type  type,
+                                 double         vector1,
+                                 double         vector2,
+                                 double         vector3,
+                                 double         offset1,
+                                 double         offset2,
+                                 double         offset3,
+                                 double         start,
+                                 double         increment,
+                                 double         rotation)
+    {
+        int errorcode = 0;
+
+        cbf_axis_struct axis;
+
+        void  *vaxis;
+
+        void  *vname;
+
+        double length;
+
+        /* Check the arguments */
+
+        if (!name || !positioner || (type != CBF_TRANSLATION_AXIS &&
+                                     type != CBF_ROTATION_AXIS &&
+                                     type != CBF_GENERAL_AXIS ))
+
+            return CBF_ARGUMENT;
+
+        length = vector1 * vector1 + vector2 * vector2 + vector3 * vector3;
+
+        if (length <= 0.0)
+
+            return CBF_ARGUMENT;
+
+        /* Ensure we are not in a loop */
+
+        if (positioner->axes >= positioner->axis_index_limit) return CBF_ALLOC;
+
+
+        /* Allocate memory and copy the axis names */
+
+        axis.name = NULL;
+
+        axis.name = (char *)cbf_copy_string(NULL,name,0);
+
+        axis.depends_on = NULL;
+
+        axis.rotation_axis = NULL;
+
+        if (depends_on) {
+
+            axis.depends_on = (char *)cbf_copy_string(NULL,depends_on,0);
+
+        }
+
+        if (rotation_axis) {
+
+            axis.rotation_axis = (char *)cbf_copy_string(NULL,rotation_axis,0);
+
+        }
+
+        axis.depends_on_index = axis.rotation_axis_index = -1;
+
+        axis.depdepth = 0;
+
+        vaxis = (void *)(positioner->axis);
+
+        errorcode = cbf_realloc ((void **) &vaxis,
+                                 &(positioner->axes),
+                                 sizeof (cbf_axis_struct),
+                                 positioner->axes + 1);
+
+        positioner->axis = (cbf_axis_struct *)vaxis;
+
+        if (errorcode)
+        { int nerrorcode;
+
+            void * vdepends_on;
+
+            void * vrotation_axis;
+
+            vname = (void *)axis.name;
+
+            vdepends_on = (void *)axis.depends_on;
+
+            vrotation_axis = (void *)axis.rotation_axis;
+
+            nerrorcode = errorcode |
+              cbf_free (&vname, NULL) |
+              cbf_free (&vdepends_on, NULL) |
+              cbf_free (&vrotation_axis, NULL);
+
+            axis.name = NULL;
+
+            axis.depends_on = NULL;
+
+            axis.rotation_axis = NULL;
+
+            return nerrorcode;
+
+        }
+
+        length = sqrt (length);
+
+        axis.type = type;
+
+        axis.vector [0] = vector1 / length;
+        axis.vector [1] = vector2 / length;
+        axis.vector [2] = vector3 / length;
+
+        axis.offset [0] = offset1;
+        axis.offset [1] = offset2;
+        axis.offset [2] = offset3;
+
+        axis.start     = start;
+        axis.increment = increment;
+        axis.setting   = 0;
+        axis.rotation  = rotation;
+
+        positioner->axis [positioner->axes - 1] = axis;
+
+        positioner->matrix_is_valid = 0;
+
+        return 0;
+    }
+
+
+    /* Add a goniometer axis from a file */
+
+    static int cbf_read_positioner_axis (cbf_handle      handle,
+                                  unsigned int    reserved,
+                                  cbf_positioner  positioner,
+                                  const char     *axis_id,
+                                  int             read_setting)
+    {
+        const char *prev_id;
+
+        const char *rot_id;
+
+        cbf_axis_type axis_type;
+        
+        const char *deptype;
+
+        double vector1, vector2, vector3, offset1, offset2, offset3;
+
+        double start, increment, rot;
+
+        int errorcode;
+
+        cbf_failnez (cbf_find_category    (handle, "axis"));
+        cbf_failnez (cbf_find_column      (handle, "id"));
+        cbf_failnez (cbf_find_row         (handle, axis_id));
+        cbf_failnez (cbf_find_column      (handle, "depends_on"));
+        cbf_failnez (cbf_get_value        (handle, &prev_id));
+        cbf_failnez (cbf_get_typeofvalue  (handle, &deptype));
+        if (cbf_cistrcmp(deptype, "null") == 0) {
+            prev_id = NULL;
+        }
+
+        if (!cbf_find_column (handle, "rotation_axis")) {
+
+            cbf_failnez (cbf_get_value    (handle, &rot_id));
+
+        } else {
+
+            rot_id = NULL;
+
+        }
+
+        if (!cbf_find_column (handle, "rotation")) {
+
+            cbf_failnez (cbf_get_doublevalue (handle, &rot));
+
+        } else {
+
+            rot = 0.0;
+
+        }
+
+        cbf_failnez (cbf_get_axis_type    (handle, axis_id,
+                                           &axis_type))
+        cbf_failnez (cbf_get_axis_vector  (handle, axis_id,
+                                           &vector1,
+                                           &vector2,
+                                           &vector3))
+        cbf_failnez (cbf_get_axis_offset  (handle, axis_id,
+                                           &offset1,
+                                           &offset2,
+                                           &offset3))
+
+        start = increment = 0.;
+
+        errorcode = 0;
+
+        /* fprintf(stderr," cbf_read_positioner_axis , axis = %s, read_setting = %d\n",axis_id, read_setting);*/
+
+        if (read_setting && axis_type != CBF_GENERAL_AXIS)
+        {
+
+            errorcode = cbf_get_axis_setting (handle, reserved, axis_id,
+                                              &start,
+                                              &increment);
+
+            if (read_setting < 0) {
+                errorcode = cbf_get_axis_reference_setting (handle, reserved, axis_id,
+                                                            &start);
+            }
+
+            if ( (read_setting == -2 || read_setting == 2)
+                && (errorcode == CBF_NOTFOUND || errorcode == CBF_FORMAT) ) {
+
+                start = increment = 0;
+
+                errorcode = 0;
+
+            }
+
+            cbf_failnez(errorcode);
+
+        }
+
+        cbf_failnez (cbf_add_positioner_axis_wrot (positioner,
+                                              axis_id,
+                                              prev_id,
+                                              rot_id,
+                                              axis_type,
+                                              vector1, vector2, vector3,
+                                              offset1, offset2, offset3,
+                                              start, increment, rot))
+
+        return 0;
+    }
+
+
+
+    /* construct a positioner for a given final axis */
+
+    int cbf_construct_positioner (cbf_handle handle,
+                                  cbf_positioner *positioner, const char *axis_id)
+    {
+
+        int errorcode;
+
+        const char * target_axis;
+
+        const char * rotation_axis;
+
+        size_t axis_index;
+
+        unsigned int axis_index_limit;
+
+        if (!positioner || !axis_id)
+
+            return CBF_ARGUMENT;
+
+        /* fprintf(stderr," cbf_construct_positioner, axis %s\n",axis_id); */
+
+        errorcode = 0;
+
+
+        /* Construct the positioner */
+
+        cbf_failnez (cbf_make_positioner (positioner));
+
+        /* Set a limit on the number of axes in the positioner
+
+           As a crude limit to break dependency loops, N*(N-1)/2
+
+           will suffice.
+
+         */
+
+        cbf_failnez(cbf_find_category(handle,"axis"));
+
+        cbf_failnez(cbf_count_rows(handle,&axis_index_limit));
+
+        axis_index_limit *= (axis_index_limit-1);
+
+        axis_index_limit /= 2;
+
+        (*positioner)->axis_index_limit = axis_index_limit;
+
+        /* read the first axis */
+
+        errorcode = cbf_read_positioner_axis (handle,
+                                              0, /* reserved */
+                                              *positioner,
+                                              axis_id, 2);
+        axis_index = 0;
+
+        if (!errorcode) {
+
+            do{
+
+                target_axis = (*positioner)->axis[axis_index].depends_on;
+
+                rotation_axis = (*positioner)->axis[axis_index].rotation_axis;
+
+                if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *positioner,
+                                                          target_axis, 2);
+
+                    (*positioner)->axis[axis_index].depends_on_index
+                        = (*positioner)->axes-1;
+
+                    (*positioner)->axis[(*positioner)->axes-1].depdepth
+                        = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
+                           (*positioner)->axis[axis_index].depdepth+1);
+
+                    if (!errorcode) break;
+
+                }
+
+                if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+
+            errorcode = cbf_read_positioner_axis (handle,
+                                                  0, /* reserved */
+                                                  *positioner,
+                                                          rotation_axis, 2);
+
+                    (*positioner)->axis[axis_index].rotation_axis_index
+                        = (*positioner)->axes-1;
+
+                    (*positioner)->axis[(*positioner)->axes-1].depdepth
+                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
+                              (*positioner)->axis[axis_index].depdepth+1);
+
+
+                    if (!errorcode) break;
+
+            }
+
+                axis_index++;
+
+            } while (axis_index < (*positioner)->axes);
+
+        }
+
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (*positioner);
+
+            *positioner = NULL;
+        }
+
+        return errorcode;
+    }
+
+    /* construct a reference positioner for a given final axis */
+
+    int cbf_construct_reference_positioner (cbf_handle handle,
+                                            cbf_positioner *positioner, const char *axis_id)
+    {
+
+        int errorcode;
+
+        const char * target_axis;
+
+        const char * rotation_axis;
+
+        size_t axis_index;
+
+        unsigned int axis_index_limit;
+
+        if (!positioner || !axis_id)
+
+            return CBF_ARGUMENT;
+
+        /* fprintf(stderr," cbf_construct_positioner, axis %s\n",axis_id); */
+
+        errorcode = 0;
+
+
+        /* Construct the positioner */
+
+        cbf_failnez (cbf_make_positioner (positioner))
+
+        /* Set a limit on the number of axes in the positioner
+
+         As a crude limit to break dependency loops, N*(N-1)/2
+
+         will suffice.
+
+         */
+
+        cbf_failnez(cbf_find_category(handle,"axis"));
+
+        cbf_failnez(cbf_count_rows(handle,&axis_index_limit));
+
+        axis_index_limit *= (axis_index_limit-1);
+
+        axis_index_limit /= 2;
+
+        (*positioner)->axis_index_limit = axis_index_limit;
+
+        /* read the first axis */
+
+            errorcode = cbf_read_positioner_axis (handle,
+                                                  0, /* reserved */
+                                                  *positioner,
+                                              axis_id, -2);
+        axis_index = 0;
+
+            if (!errorcode) {
+
+            do{
+
+                target_axis = (*positioner)->axis[axis_index].depends_on;
+
+                rotation_axis = (*positioner)->axis[axis_index].rotation_axis;
+
+                if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *positioner,
+                                                          target_axis, -2);
+
+                    (*positioner)->axis[axis_index].depends_on_index
+                    = (*positioner)->axes-1;
+
+                    (*positioner)->axis[(*positioner)->axes-1].depdepth
+                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
+                              (*positioner)->axis[axis_index].depdepth+1);
+
+                    if (!errorcode) break;
+
+            }
+
+                if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *positioner,
+                                                          rotation_axis, -2);
+
+                    (*positioner)->axis[axis_index].depends_on_index
+                    = (*positioner)->axes-1;
+
+                    (*positioner)->axis[(*positioner)->axes-1].depdepth
+                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
+                              (*positioner)->axis[axis_index].depdepth+1);
+
+                    if (!errorcode) break;
+
+        }
+
+                axis_index++;
+
+            } while (axis_index < (*positioner)->axes);
+
+        }
+
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (*positioner);
+
+            *positioner = NULL;
+        }
+
+        return errorcode;
+
+    }
+
+
+    /* Calculate a position given initial coordinates */
+
+    static int cbf_calculate_position (cbf_positioner positioner,
+                                unsigned int   reserved,
+                                double         ratio,
+                                double         initial1,
+                                double         initial2,
+                                double         initial3,
+                                double        *final1,
+                                double        *final2,
+                                double        *final3)
+    {
+        size_t i, istart;
+
+        int idep;
+
+        int irot;
+
+        double setting;
+
+        double rangle;
+
+        if (!positioner)
+
+            return CBF_ARGUMENT;
+
+        if (reserved != 0)
+
+            return CBF_ARGUMENT;
+
+        istart = 0;
+
+        for (i = 0; i < positioner->axes; i++)
+        {
+            setting = positioner->axis [i].start + ratio *
+            positioner->axis [i].increment;
+
+            if (positioner->axis [i].setting != setting)
+            {
+                positioner->matrix_is_valid = 0;
+
+                positioner->axis [i].setting = setting;
+            }
+
+            if (positioner->axis [i].depdepth == 0) istart = i;
+        }
+
+
+        if (!positioner->matrix_is_valid || positioner->matrix_ratio_used != ratio )
+        {
+
+
+            positioner->matrix_ratio_used = ratio;
+
+            positioner->matrix [0][0] = 1;
+            positioner->matrix [0][1] = 0;
+            positioner->matrix [0][2] = 0;
+            positioner->matrix [0][3] = 0;
+            positioner->matrix [1][0] = 0;
+            positioner->matrix [1][1] = 1;
+            positioner->matrix [1][2] = 0;
+            positioner->matrix [1][3] = 0;
+            positioner->matrix [2][0] = 0;
+            positioner->matrix [2][1] = 0;
+            positioner->matrix [2][2] = 1;
+            positioner->matrix [2][3] = 0;
+
+            idep = 0;
+
+            irot = -1;
+
+            rangle = 0.;
+
+            i = istart;
+
+            while (1) {
+
+                setting = positioner->axis [i].setting;
+
+                if (positioner->axis [i].type == CBF_TRANSLATION_AXIS && irot == -1)
+                {
+                    positioner->matrix [0][3] += setting * positioner->axis [i].vector [0];
+                    positioner->matrix [1][3] += setting * positioner->axis [i].vector [1];
+                    positioner->matrix [2][3] += setting * positioner->axis [i].vector [2];
+                    /* fprintf(stderr," calculate position, axis %s, translate [%g, %g, %g]\n",
+                            positioner->axis [i].name,
+                            setting * positioner->axis [i].vector [0],
+                            setting * positioner->axis [i].vector [1],
+                            setting * positioner->axis [i].vector [2]); */
+
+
+                }
+                else
+                {
+                    double s, x, y, z, w,
+                    xx, yy, zz, xy, xz, xw, yz, yw, zw;
+
+                    double rotation [3][3], product [3][4];
+
+                    int r1, c1r2, c2;
+
+                    setting += rangle;
+
+                    s = sin (setting * 0.00872664625997164788461845384244);
+
+                    x = positioner->axis [i].vector [0] * s;
+                    y = positioner->axis [i].vector [1] * s;
+                    z = positioner->axis [i].vector [2] * s;
 
-    }
+                    w = cos (setting * 0.00872664625997164788461845384244);
 
+                    xx = x * x;
+                    yy = y * y;
+                    zz = z * z;
+                    xy = x * y;
+                    xz = x * z;
+                    xw = x * w;
+                    yz = y * z;
+                    yw = y * w;
+                    zw = z * w;
 
-    /* Get the axis, if any, on which this axis depends
-     Will always return "." for the null case */
+                    rotation [0][0] = 1 - 2 * (yy + zz);
+                    rotation [0][1] =     2 * (xy - zw);
+                    rotation [0][2] =     2 * (xz + yw);
+                    rotation [1][0] =     2 * (xy + zw);
+                    rotation [1][1] = 1 - 2 * (xx + zz);
+                    rotation [1][2] =     2 * (yz - xw);
+                    rotation [2][0] =     2 * (xz - yw);
+                    rotation [2][1] =     2 * (yz + xw);
+                    rotation [2][2] = 1 - 2 * (xx + yy);
 
-    int cbf_get_axis_depends_on (cbf_handle handle, const char *axis_id,
-                                 const char * *depends_on)
-    {
-        
-        const char * deptype;
-        
-        /* Check for valid arguments */
-        
-        if (!handle || !depends_on) return CBF_ARGUMENT;
-        
-        
-        /* Get the axis dependency */
-        
-        cbf_failnez (cbf_find_category (handle, "axis"))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_find_row      (handle, axis_id))
-        
-        if (cbf_find_column   (handle, "depends_on")) {
-            
-            *depends_on = ".";  return CBF_SUCCESS;
+                    /* fprintf(stderr," calculate position, axis %s, rotate [%g + i*%g + j*%g + k*%g]\n",
+                            positioner->axis [i].name, w, x, y, z); */
 
-        }
-        
-        if (cbf_get_value     (handle, depends_on)
-            || !(*depends_on)) {
-            
-            *depends_on = ".";  return CBF_SUCCESS;
-            
-        }
-        
-        if (cbf_get_typeofvalue(handle,&deptype)
-            || !cbf_cistrcmp(deptype,"null")) {
-            
-            *depends_on = ".";  return CBF_SUCCESS;
-            
-        }
-        
-        
-        if (!cbf_cistrcmp(*depends_on,".")
-            || !cbf_cistrcmp(*depends_on,"?")) {
-            
-            cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
-                             *depends_on,
-                             axis_id);
 
-            
-            *depends_on = ".";  return CBF_SUCCESS;
-            
-        }
-        
-        return CBF_SUCCESS;
-        
-    }
+                    for (r1 = 0; r1 < 3; r1++)
 
+                        for (c2 = 0; c2 < 4; c2++)
+                        {
+                            product [r1][c2] = 0;
 
+                            for (c1r2 = 0; c1r2 < 3; c1r2++)
 
-    /* Get the axis equipment */
+                                product [r1][c2] += rotation [r1][c1r2] *
+                                positioner->matrix [c1r2][c2];
+                        }
 
-    int cbf_get_axis_equipment (cbf_handle handle, const char *axis_id,
-                           const char * *equipment)
-    {
+                    for (r1 = 0; r1 < 3; r1++)
 
-        /* Get the axis equipment */
-        
-        cbf_failnez (cbf_find_category (handle, "axis"))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_find_row      (handle, axis_id))
-        if (cbf_find_column   (handle, "equipment")) {
-            *equipment = ".";  return CBF_SUCCESS;
-        }
-        if (cbf_get_value     (handle, equipment)
-            || !(*equipment)
-            || !((*equipment)[0])) {
-            *equipment = ".";  return CBF_SUCCESS;
-        }
-        return CBF_SUCCESS;
+                        for (c2 = 0; c2 < 4; c2++)
 
-    }
+                            positioner->matrix [r1][c2] = product [r1][c2];
+                }
 
-    /* Get the axis equipment_component */
+                positioner->matrix [0][3] += positioner->axis [i].offset [0];
+                positioner->matrix [1][3] += positioner->axis [i].offset [1];
+                positioner->matrix [2][3] += positioner->axis [i].offset [2];
 
-    int cbf_get_axis_equipment_component (cbf_handle handle,
-                                          const char *axis_id,
-                                const char * *equipment_component)
-    {
+                if (irot == -1) {
 
-        /* Get the axis equipment component */
-        
-        cbf_failnez (cbf_find_category (handle, "axis"))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_find_row      (handle, axis_id))
-        if (cbf_find_column   (handle, "equipment_component")) {
-            *equipment_component = ".";  return CBF_SUCCESS;
-        }
-        if (cbf_get_value     (handle, equipment_component)||
-            !((*equipment_component)[0])) {
-            *equipment_component = ".";  return CBF_SUCCESS;
-        }
-        return CBF_SUCCESS;
+                    irot = positioner->axis[i].rotation_axis_index;
 
-    }
+                    rangle = positioner->axis[i].rotation;
 
-    /* Get an axis rotation */
+                    if (irot >= 0 && fabs(rangle) >= 1.e-38) {
 
-    int cbf_get_axis_rotation (cbf_handle handle, const char *axis_id,
-                               double *rotation)
-    {
-        if (!handle || !axis_id || !rotation )
-            return CBF_ARGUMENT;
+                        if (cbf_cistrcmp(positioner->axis[i].depends_on,
+                                         positioner->axis[irot].depends_on)
+                            && cbf_cistrcmp(positioner->axis[i].depends_on,
+                                            positioner->axis[irot].name)) {
 
-        /* Read from the axis category */
+                            /* fprintf (stderr," CBFlib: cbf_calculate_position: "
+                                     "different rotation axis %s dependency for %s, %s vs. %s "
+                                     "not supported\n",
+                                     positioner->axis[irot].name,
+                                     positioner->axis[i].name,
+                                     positioner->axis[i].depends_on,
+                                     positioner->axis[irot].depends_on); */
 
-        cbf_failnez (cbf_find_category   (handle, "axis"))
-        cbf_failnez (cbf_find_column     (handle, "id"))
-        cbf_failnez (cbf_find_row        (handle, axis_id))
-        if (cbf_find_column( handle, "rotation")) {
+                            return CBF_FORMAT;
 
-            *rotation = 0.0;
-            return CBF_SUCCESS;
+                        }
 
-        }
+                        i = irot;
 
-        if (cbf_get_doublevalue (handle, rotation)) *rotation = 0.;
+                        continue;
+                    }
 
-        return 0;
+                    irot = -1;
 
-    }
+                }
 
+                idep = positioner->axis[i].depends_on_index;
 
-    /* Get the axis rotation_axis */
+                if (idep < 0) break;
 
-    int cbf_get_axis_rotation_axis (cbf_handle handle,
-                                          const char *axis_id,
-                                          const char * *rotation_axis)
-    {
+                i = idep;
 
-        /* Get the axis rotation_axis */
+                irot = -1;
 
-        cbf_failnez (cbf_find_category (handle, "axis"))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_find_row      (handle, axis_id))
-        if (cbf_find_column   (handle, "rotation_axis")) {
-            *rotation_axis = ".";  return CBF_SUCCESS;
-        }
-        if (cbf_get_value     (handle, rotation_axis)||
-            !((*rotation_axis)[0])) {
-            *rotation_axis = ".";  return CBF_SUCCESS;
-        }
-        return CBF_SUCCESS;
+                rangle = 0.0;
 
-    }
+            }
 
+            positioner->matrix_is_valid = 1;
+        }
 
+        /* fprintf(stderr," Overall matrix [[%g %g %g]] + %g\n"
+                "                [[%g %g %g]] + %g\n"
+                "                [[%g %g %g]] + %g\n",
+                positioner->matrix [0][0],
+                positioner->matrix [0][1],
+                positioner->matrix [0][2],
+                positioner->matrix [0][3],
+                positioner->matrix [1][0],
+                positioner->matrix [1][1],
+                positioner->matrix [1][2],
+                positioner->matrix [1][3],
+                positioner->matrix [2][0],
+                positioner->matrix [2][1],
+                positioner->matrix [2][2],
+                positioner->matrix [2][3]); */
 
-    /* Get an axis offset */
 
-    int cbf_get_axis_offset (cbf_handle handle, const char *axis_id,
-                             double *offset1,
-                             double *offset2,
-                             double *offset3)
-    {
-        if (!handle || !axis_id || !offset1 || !offset2 || !offset3)
-            return CBF_ARGUMENT;
+        if (final1)
 
-        /* Read from the axis category */
+            *final1 = positioner->matrix [0][0] * initial1 +
+            positioner->matrix [0][1] * initial2 +
+            positioner->matrix [0][2] * initial3 +
+            positioner->matrix [0][3];
 
-        cbf_failnez (cbf_find_category   (handle, "axis"))
-        cbf_failnez (cbf_find_column     (handle, "id"))
-        cbf_failnez (cbf_find_row        (handle, axis_id))
-        cbf_failnez (cbf_find_column     (handle, "offset[1]"))
-        if (cbf_get_doublevalue (handle, offset1)) *offset1 = 0.;
-        cbf_failnez (cbf_find_column     (handle, "offset[2]"))
-        if (cbf_get_doublevalue (handle, offset2)) *offset2 = 0.;
-        cbf_failnez (cbf_find_column     (handle, "offset[3]"))
-        if (cbf_get_doublevalue (handle, offset3)) *offset3 = 0.;
+        if (final2)
 
-        return 0;
-    }
+            *final2 = positioner->matrix [1][0] * initial1 +
+            positioner->matrix [1][1] * initial2 +
+            positioner->matrix [1][2] * initial3 +
+            positioner->matrix [1][3];
 
+        if (final3)
 
+            *final3 = positioner->matrix [2][0] * initial1 +
+            positioner->matrix [2][1] * initial2 +
+            positioner->matrix [2][2] * initial3 +
+            positioner->matrix [2][3];
 
+        return 0;
+    }
 
 
-    /* Get the type of an axis */
+    /* Calculate the initial position given final coordinates */
 
-    int cbf_get_axis_type (cbf_handle handle, const char *axis_id,
-                           cbf_axis_type *axis_type)
+    static int cbf_calculate_initial_position (cbf_positioner positioner,
+                                        unsigned int   reserved,
+                                        double         ratio,
+                                        double         final1,
+                                        double         final2,
+                                        double         final3,
+                                        double        *initial1,
+                                        double        *initial2,
+                                        double        *initial3)
     {
-        const char *type;
-
-
-        /* Get the axis type */
-
-        cbf_failnez (cbf_find_category (handle, "axis"))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_find_row      (handle, axis_id))
-        cbf_failnez (cbf_find_column   (handle, "type"))
-        cbf_failnez (cbf_get_value     (handle, &type))
+        double delta [3];
 
-        if (!type)
+        if (reserved != 0)
 
-            return CBF_NOTFOUND;
+            return CBF_ARGUMENT;
 
-        if (toupper (*type) != 'T' &&
-            toupper (*type) != 'R' &&
-            toupper (*type) != 'G')
 
-            return CBF_FORMAT;
+        /* Update the matrix */
 
-        if (axis_type) {
+        cbf_failnez (cbf_calculate_position (positioner, reserved, ratio, 0, 0, 0,
+                                             NULL, NULL, NULL))
 
-            if (toupper (*type) == 'T') {
+        delta [0] = final1 - positioner->matrix [0][3];
+        delta [1] = final2 - positioner->matrix [1][3];
+        delta [2] = final3 - positioner->matrix [2][3];
 
-                *axis_type = CBF_TRANSLATION_AXIS;
+        if (initial1)
 
-            } else {
+            *initial1 = positioner->matrix [0][0] * delta [0] +
+            positioner->matrix [1][0] * delta [1] +
+            positioner->matrix [2][0] * delta [2];
 
-                if (toupper (*type) == 'R') {
+        if (initial2)
 
-                    *axis_type = CBF_ROTATION_AXIS;
+            *initial2 = positioner->matrix [0][1] * delta [0] +
+            positioner->matrix [1][1] * delta [1] +
+            positioner->matrix [2][1] * delta [2];
 
-                } else {
+        if (initial3)
 
-                    *axis_type = CBF_GENERAL_AXIS;
-                }
-            }
-        }
+            *initial3 = positioner->matrix [0][2] * delta [0] +
+            positioner->matrix [1][2] * delta [1] +
+            positioner->matrix [2][2] * delta [2];
 
         return 0;
     }
 
-    /* Get an axis vector */
 
-    int cbf_get_axis_vector (cbf_handle handle, const char *axis_id,
-                             double *vector1,
-                             double *vector2,
-                             double *vector3)
+    /* Construct a goniometer */
+
+    int cbf_construct_goniometer (cbf_handle handle,
+                                  cbf_goniometer *goniometer)
     {
-        if (!handle || !axis_id || !vector1 || !vector2 || !vector3)
-            return CBF_ARGUMENT;
+        const char *diffrn_id, *id, *this_id, *axis_id;
 
-        /* Read from the axis category */
+        const char * target_axis;
 
-        cbf_failnez (cbf_find_category   (handle, "axis"))
-        cbf_failnez (cbf_find_column     (handle, "id"))
-        cbf_failnez (cbf_find_row        (handle, axis_id))
-        cbf_failnez (cbf_find_column     (handle, "vector[1]"))
-        if (cbf_get_doublevalue (handle, vector1)) *vector1 = 0.;
-        cbf_failnez (cbf_find_column     (handle, "vector[2]"))
-        if (cbf_get_doublevalue (handle, vector2)) *vector2 = 0.;
-        cbf_failnez (cbf_find_column     (handle, "vector[3]"))
-        if (cbf_get_doublevalue (handle, vector3)) *vector3 = 0.;
+        const char * rotation_axis;
 
-        return 0;
-    }
+        size_t axis_index;
 
+        unsigned int row;
 
-    /* Get the setting of an axis */
+        int errorcode;
 
-    int cbf_get_axis_setting (cbf_handle handle, unsigned int  reserved,
-                              const char   *axis_id,
-                              double       *start,
-                              double       *increment)
-    {
-        cbf_axis_type type;
 
-        if (reserved != 0)
+        if (!goniometer)
 
             return CBF_ARGUMENT;
 
 
-        /* Get the axis type */
+        /* Get the measurement id */
 
-        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
 
-        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+        cbf_failnez (cbf_find_category (handle, "diffrn_measurement"))
+        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
+        cbf_failnez (cbf_find_row      (handle, diffrn_id))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_get_value     (handle, &id))
 
-            return CBF_FORMAT;
 
+        /* Construct the goniometer */
 
-        /* Read from the diffrn_scan_axis and
-         diffrn_scan_frame_axis categories */
+        cbf_failnez (cbf_make_positioner (goniometer))
 
-        if (type == CBF_TRANSLATION_AXIS)
+        for (row = errorcode = 0; !errorcode; row++)
         {
-            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_find_row        (handle, axis_id))
-            cbf_failnez (cbf_find_column     (handle, "displacement"))
-            cbf_failnez (cbf_get_doublevalue (handle, start))
+            errorcode = cbf_find_category (handle, "diffrn_measurement_axis");
 
-            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_find_row        (handle, axis_id))
-            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_get_doublevalue (handle, increment))
-        }
-        else
-        {
-            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_find_row        (handle, axis_id))
-            cbf_failnez (cbf_find_column     (handle, "angle"))
-            cbf_failnez (cbf_get_doublevalue (handle, start))
+            if (!errorcode)
+            {
+                /* allow for aliases  _diffrn_measurement_axis.measurement_id
+                 _diffrn_measurement_axis.id  (deprecated) */
 
-            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_find_row        (handle, axis_id))
-            cbf_failnez (cbf_find_column     (handle, "angle_increment"))
-            cbf_failnez (cbf_get_doublevalue (handle, increment))
-        }
+                errorcode = cbf_find_column (handle, "measurement_id");
 
-        return 0;
-    }
+                if (errorcode)
 
+                    errorcode = cbf_find_column (handle, "id");
+            }
 
+            if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
 
+                if (errorcode == CBF_NOTFOUND)
+                {
+                    errorcode = 0;
 
-    /* Get the reference setting of an axis */
+                    break;
+                }
+            }
 
-    int cbf_get_axis_reference_setting (cbf_handle handle, unsigned int  reserved,
-                                        const char   *axis_id,
-                                        double       *refsetting)
-    {
-        cbf_axis_type type;
+            if (!errorcode)
 
-        if (reserved != 0 || !refsetting || !axis_id )
+                errorcode = cbf_get_value (handle, &this_id);
 
-            return CBF_ARGUMENT;
+            if (!errorcode)
 
-        /* Get the axis type */
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
 
-        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+                    if (!errorcode)
 
-        if (type == CBF_GENERAL_AXIS || !cbf_cistrcmp(axis_id,".")) {
+                        errorcode = cbf_get_value (handle, &axis_id);
 
-            *refsetting = 0.;
+                    if (!errorcode)
 
+                        errorcode = cbf_read_positioner_axis (handle,
+                                                              0, /* reserved */
+                                                              *goniometer,
+                                                              axis_id, 1);
+                }
         }
 
-        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+        /* Complete the connectivity of the positioner */
 
-            return CBF_FORMAT;
+        axis_index = 0;
 
+        do {
 
-        /* Read from the diffrn_scan_axis and
-         diffrn_scan_frame_axis categories */
+            size_t index;
 
-        if (type == CBF_TRANSLATION_AXIS)
-        {
-            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_find_row        (handle, axis_id))
-            *refsetting = 0.;
-            if (!cbf_find_column (handle, "reference_displacement")) {
-                if (cbf_get_doublevalue (handle, refsetting)) {
-                    if (!cbf_find_column (handle, "displacement")) {
-                        if (cbf_get_doublevalue (handle, refsetting)) {
-                            *refsetting = 0.;
-                        }
-                    }
-                }
-            } else {
-                if (!cbf_find_column (handle, "displacement")) {
-                    if (cbf_get_doublevalue (handle, refsetting)) {
-                        *refsetting = 0.;
-                    }
-                }
-                else  {
-                    cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
-                    cbf_failnez (cbf_find_column     (handle, "axis_id"))
-                    cbf_failnez (cbf_find_row        (handle, axis_id))
-                    if (!cbf_find_column (handle, "reference_displacement")) {
-                        if (cbf_get_doublevalue (handle, refsetting)) {
-                            if (!cbf_find_column (handle, "displacement")) {
-                                if (cbf_get_doublevalue (handle, refsetting)) {
-                                    *refsetting = 0.;
-                                }
-                            }
-                        }
-                    } else  {
-                        if (!cbf_find_column (handle, "displacement")) {
-                            if (cbf_get_doublevalue (handle, refsetting)) {
-                                *refsetting = 0.;
-                            }
-                        }
-                    }
+            int found;
+
+            target_axis = (*goniometer)->axis[axis_index].depends_on;
+
+            rotation_axis = (*goniometer)->axis[axis_index].rotation_axis;
+            
+            if (target_axis
+                && (!cbf_cistrcmp (target_axis,".")
+                    ||!cbf_cistrcmp (target_axis,"?"))) {
+                    
+                    cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
+                                     target_axis,
+                                     (*goniometer)->axis[axis_index].name);
+                    target_axis = NULL;
+                    
                 }
-            }
-        }
-        else
-        {
-            cbf_failnez (cbf_find_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_find_row        (handle, axis_id))
-            *refsetting = 0.;
-            if (!cbf_find_column (handle, "reference_angle")) {
-                if (cbf_get_doublevalue (handle, refsetting)) {
-                    *refsetting = 0.;
+
+            if (rotation_axis
+                && (!cbf_cistrcmp (rotation_axis,".")
+                    ||!cbf_cistrcmp (rotation_axis,"?"))) {
+                    
+                    cbf_debug_print3("non-null rotation_axis '%s' for axis '%s'\n",
+                                     rotation_axis,
+                                     (*goniometer)->axis[axis_index].name);
+                    rotation_axis = NULL;
+                    
                 }
-            } else {
-                cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
-                cbf_failnez (cbf_find_column     (handle, "axis_id"))
-                cbf_failnez (cbf_find_row        (handle, axis_id))
-                if (!cbf_find_column (handle, "reference_angle")) {
-                    if (cbf_get_doublevalue (handle, refsetting)) {
-                        *refsetting = 0.;
+
+            if ( target_axis ) {
+
+                found = 0;
+
+                for (index = 0; index < (*goniometer)->axes; index++) {
+
+                    if (index != axis_index &&
+                        cbf_cistrcmp (target_axis,(*goniometer)->axis[index].name)== 0)
+                    {
+
+                        (*goniometer)->axis[axis_index].depends_on_index = index;
+
+                        found = 1;
+
+                        (*goniometer)->axis[index].depdepth
+                        = cbf_max( (*goniometer)->axis[index].depdepth,
+                                  (*goniometer)->axis[axis_index].depdepth+1);
+
+
+                        break;
+
                     }
+
                 }
-            }
-        }
-        return 0;
-    }
 
+                if (!found) {
 
-    /* Change the setting of an axis */
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *goniometer,
+                                                          target_axis, 2);
 
-    int cbf_set_axis_setting (cbf_handle handle, unsigned int  reserved,
-                              const char   *axis_id,
-                              double        start,
-                              double        increment)
-    {
-        cbf_axis_type type;
+                    (*goniometer)->axis[axis_index].depends_on_index
+                    = (*goniometer)->axes-1;
 
-        if (reserved != 0)
+                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
+                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
+                              (*goniometer)->axis[axis_index].depdepth+1);
 
-            return CBF_ARGUMENT;
 
+                    if (!errorcode) break;
 
-        /* Get the axis type */
+                }
 
-        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+            }
 
-        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+            if ( rotation_axis ) {
 
-            return CBF_FORMAT;
+                found = 0;
 
+                for (index = 0; index < (*goniometer)->axes; index++) {
 
-        /* Update the diffrn_scan_axis and
-         diffrn_scan_frame_axis categories */
+                    if (index != axis_index &&
+                        cbf_cistrcmp (rotation_axis,(*goniometer)->axis[index].name)== 0)
+                    {
 
-        if (type == CBF_TRANSLATION_AXIS)
-        {
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "displacement"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
-            if (!cbf_find_column( handle, "displacement_increment")) {
-                cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
-            }
+                        (*goniometer)->axis[axis_index].rotation_axis_index = index;
 
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "displacement_start"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
-            cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
-            cbf_failnez (cbf_require_column     (handle, "displacement_range"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
-        }
-        else
-        {
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "angle"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
-            if (!cbf_find_column     (handle, "angle_increment")) {
-                cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
-            }
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "angle_start"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", start))
-            cbf_failnez (cbf_require_column     (handle, "angle_increment"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
-            cbf_failnez (cbf_require_column     (handle, "angle_range"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", increment))
-        }
+                        found = 1;
 
-        return 0;
-    }
+                        (*goniometer)->axis[index].depdepth
+                        = cbf_max( (*goniometer)->axis[index].depdepth,
+                                  (*goniometer)->axis[axis_index].depdepth+1);
 
 
-    /* Change the reference setting of an axis */
+                        break;
 
-    int cbf_set_axis_reference_setting (cbf_handle handle, unsigned int  reserved,
-                                        const char   *axis_id,
-                                        double        refsetting)
-    {
-        cbf_axis_type type;
+                    }
 
-        if (reserved != 0)
+                }
 
-            return CBF_ARGUMENT;
+                if (!found) {
 
 
-        /* Get the axis type */
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *goniometer,
+                                                          rotation_axis, 2);
 
-        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
+                    (*goniometer)->axis[axis_index].rotation_axis_index
+                    = (*goniometer)->axes-1;
 
-        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS)
+                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
+                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
+                              (*goniometer)->axis[axis_index].depdepth+1);
 
-            return CBF_FORMAT;
 
+                    if (!errorcode) break;
 
-        /* Update the diffrn_scan_axis and
-         diffrn_scan_frame_axis categories */
+                }
 
-        if (type == CBF_TRANSLATION_AXIS)
-        {
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "reference_displacement"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+            }
 
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "reference_displacement"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
-        }
-        else
+            axis_index++;
+
+        } while (axis_index < (*goniometer)->axes);
+
+        if (errorcode)
         {
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_frame_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "reference_angle"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+            errorcode |= cbf_free_positioner (*goniometer);
 
-            cbf_failnez (cbf_require_category   (handle, "diffrn_scan_axis"))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_row        (handle, axis_id))
-            cbf_failnez (cbf_require_column     (handle, "reference_angle"))
-            cbf_failnez (cbf_set_doublevalue    (handle, "%-.15g", refsetting))
+            *goniometer = NULL;
         }
 
-        return 0;
+        return errorcode;
     }
 
 
-    /* Create a positioner */
+    /* Free a goniometer */
 
-    static int cbf_make_positioner (cbf_positioner *positioner)
+    int cbf_free_goniometer (cbf_goniometer goniometer)
     {
-        cbf_failnez (cbf_alloc ((void **) positioner, NULL,
-                                sizeof (cbf_positioner_struct), 1))
+        return cbf_free_positioner (goniometer);
+    }
 
-        (*positioner)->matrix [0][0] = 1;
-        (*positioner)->matrix [0][1] = 0;
-        (*positioner)->matrix [0][2] = 0;
-        (*positioner)->matrix [0][3] = 0;
-        (*positioner)->matrix [1][0] = 0;
-        (*positioner)->matrix [1][1] = 1;
-        (*positioner)->matrix [1][2] = 0;
-        (*positioner)->matrix [1][3] = 0;
-        (*positioner)->matrix [2][0] = 0;
-        (*positioner)->matrix [2][1] = 0;
-        (*positioner)->matrix [2][2] = 1;
-        (*positioner)->matrix [2][3] = 0;
 
-        (*positioner)->axis = NULL;
+    /* Get the rotation axis */
 
-        (*positioner)->axes = 0;
+    int cbf_get_rotation_axis (cbf_goniometer goniometer, unsigned int  reserved,
+                               double       *vector1,
+                               double       *vector2,
+                               double       *vector3)
+    {
+        size_t axis;
 
-        (*positioner)->matrix_is_valid = 1;
+        if (!goniometer)
 
-        (*positioner)->matrix_ratio_used = 0;
+            return CBF_ARGUMENT;
 
-        (*positioner)->axis_index_limit = 1000000;
+        if (reserved != 0)
 
-        return 0;
+            return CBF_ARGUMENT;
+
+
+        /* Currently just return the first rotation axis */
+
+        for (axis = 0; axis < goniometer->axes; axis++)
+
+            if (goniometer->axis [axis].type == CBF_ROTATION_AXIS)
+
+                if (goniometer->axis [axis].increment)
+                {
+                    if (vector1)
+
+                        *vector1 = goniometer->axis [axis].vector [0];
+
+                    if (vector2)
+
+                        *vector2 = goniometer->axis [axis].vector [1];
+
+                    if (vector3)
+
+                        *vector3 = goniometer->axis [axis].vector [2];
+
+                    return 0;
+                }
+
+        return CBF_NOTFOUND;
     }
 
 
-    /* Free a positioner */
+    /* Get the rotation range */
 
-    int cbf_free_positioner (cbf_positioner positioner)
+    int cbf_get_rotation_range (cbf_goniometer goniometer, unsigned int  reserved,
+                                double       *start,
+                                double       *increment)
     {
-        int errorcode;
+        size_t axis;
 
-        void *memblock;
+        if (!goniometer)
 
-        void *vaxis;
+            return CBF_ARGUMENT;
 
-        void *vname;
+        if (reserved != 0)
 
-        void *adon, *arot;
+            return CBF_ARGUMENT;
 
-        size_t i;
 
-        memblock = (void *) positioner;
+        /* Currently just return the range of the first rotation axis with 
+	   non-zero increment */
 
-        if (positioner)
-        {
-            errorcode = 0;
+        for (axis = 0; axis < goniometer->axes; axis++)
 
-            for (i = 0; i < positioner->axes; i++) {
+            if (goniometer->axis [axis].type == CBF_ROTATION_AXIS)
 
-                vname = (void *)(positioner->axis [i].name);
+                if (goniometer->axis [axis].increment)
+                {
+                    if (start)
 
-                errorcode |= cbf_free ((void **) &vname, NULL);
+                        *start = goniometer->axis [axis].start;
 
-                positioner->axis [i].name = NULL;
+                    if (increment)
 
-                if (positioner->axis [i].depends_on) {
+                        *increment = goniometer->axis [axis].increment;
 
-                    adon = (void *)(positioner->axis [i].depends_on);
+                    return 0;
+                }
+	
+	/* Second pass just look for first rotation axis */ 
+	
+        for (axis = 0; axis < goniometer->axes; axis++) {
+	  if (goniometer->axis [axis].type == CBF_ROTATION_AXIS) {
+	    if (start) *start = goniometer->axis [axis].start;
+	    if (increment) *increment = goniometer->axis [axis].increment;
+	    return 0;
+	  }
+	}
+	
+        return CBF_NOTFOUND;
+    }
 
-                    errorcode |= cbf_free ((void **) &adon, NULL);
 
-                    positioner->axis [i].depends_on = NULL;
+    /* Reorient a vector */
 
-                }
+    int cbf_rotate_vector (cbf_goniometer goniometer, unsigned int reserved,
+                           double       ratio,
+                           double       initial1,
+                           double       initial2,
+                           double       initial3,
+                           double      *final1,
+                           double      *final2,
+                           double      *final3)
+    {
+        double transformed [3], origin [3];
 
-                if (positioner->axis [i].rotation_axis) {
+        if (reserved != 0)
 
-                    arot = (void *)(positioner->axis [i].rotation_axis);
+            return CBF_ARGUMENT;
 
-                    errorcode |= cbf_free ((void **) &arot, NULL);
+        cbf_failnez (cbf_calculate_position (goniometer, reserved, ratio, 0, 0, 0,
+                                             &origin [0],
+                                             &origin [1],
+                                             &origin [2]))
 
-                    positioner->axis [i].rotation_axis = NULL;
+        cbf_failnez (cbf_calculate_position (goniometer, reserved, ratio,
+                                             initial1,
+                                             initial2,
+                                             initial3,
+                                             &transformed [0],
+                                             &transformed [1],
+                                             &transformed [2]))
 
-            }
+        if (final1)
 
-            }
+            *final1 = transformed [0] - origin [0];
 
-            vaxis = (void *)positioner->axis;
+        if (final2)
 
-            errorcode |= cbf_free ((void **) &vaxis,
-                                   &positioner->axes);
+            *final2 = transformed [1] - origin [1];
 
-            positioner->axis = NULL;
+        if (final3)
 
-            return errorcode | cbf_free (&memblock, NULL);
-        }
+            *final3 = transformed [2] - origin [2];
 
         return 0;
     }
 
 
-     /* Add a positioner axis with rotation*/
+    /* Convert a vector to reciprocal space (assumes beam along -z) */
 
-    static int cbf_add_positioner_axis_wrot (cbf_positioner positioner,
-                                 const char    *name,
-                                 const char    *depends_on,
-                                 const char    *rotation_axis,
-                                 cbf_axis_type  type,
-                                 double         vector1,
-                                 double         vector2,
-                                 double         vector3,
-                                 double         offset1,
-                                 double         offset2,
-                                 double         offset3,
-                                 double         start,
-                                 double         increment,
-                                 double         rotation)
+    int cbf_get_reciprocal (cbf_goniometer goniometer, unsigned int reserved,
+                            double       ratio,
+                            double       wavelength,
+                            double       real1,
+                            double       real2,
+                            double       real3,
+                            double      *reciprocal1,
+                            double      *reciprocal2,
+                            double      *reciprocal3)
     {
-        int errorcode = 0;
-
-        cbf_axis_struct axis;
-
-        void  *vaxis;
-
-        void  *vname;
+        double length, ewald [3];
 
-        double length;
+        if (reserved != 0)
 
-        /* Check the arguments */
+            return CBF_ARGUMENT;
 
-        if (!name || !positioner || (type != CBF_TRANSLATION_AXIS &&
-                                     type != CBF_ROTATION_AXIS &&
-                                     type != CBF_GENERAL_AXIS ))
+        if (wavelength <= 0.0)
 
             return CBF_ARGUMENT;
 
-        length = vector1 * vector1 + vector2 * vector2 + vector3 * vector3;
+        length = real1 * real1 + real2 * real2 + real3 * real3;
 
         if (length <= 0.0)
 
             return CBF_ARGUMENT;
 
-        /* Ensure we are not in a loop */
-
-        if (positioner->axes >= positioner->axis_index_limit) return CBF_ALLOC;
 
+        /* Project the vector onto the sphere */
 
-        /* Allocate memory and copy the axis names */
+        length = sqrt (length) * wavelength;
 
-        axis.name = NULL;
+        ewald [0] = real1 / length;
+        ewald [1] = real2 / length;
+        ewald [2] = real3 / length + 1 / wavelength;
 
-        axis.name = (char *)cbf_copy_string(NULL,name,0);
 
-        axis.depends_on = NULL;
+        /* Rotate the vector back to the 0 position of the goniometer */
 
-        axis.rotation_axis = NULL;
+        cbf_failnez (cbf_calculate_initial_position (goniometer, reserved, ratio,
+                                                     ewald [0],
+                                                     ewald [1],
+                                                     ewald [2],
+                                                     reciprocal1,
+                                                     reciprocal2,
+                                                     reciprocal3))
 
-        if (depends_on) {
+        return 0;
+    }
 
-            axis.depends_on = (char *)cbf_copy_string(NULL,depends_on,0);
 
-        }
+    /* Rotate an array of reciprocal-space vectors back to the 0 position
+       of the goniometer, as cbf_get_reciprocal does for one */
 
-        if (rotation_axis) {
+    int cbf_get_reciprocal_array (cbf_goniometer goniometer, unsigned int reserved,
+                                  double        ratio,
+                                  size_t        nvectors,
+                                  const double *lab,
+                                  double       *reciprocal)
+    {
+        double matrix [3][4];
 
-            axis.rotation_axis = (char *)cbf_copy_string(NULL,rotation_axis,0);
+        long i;
 
-        }
+        if (reserved != 0 || !lab || !reciprocal)
 
-        axis.depends_on_index = axis.rotation_axis_index = -1;
+            return CBF_ARGUMENT;
 
-        axis.depdepth = 0;
 
-        vaxis = (void *)(positioner->axis);
+        /* Update the matrix once for the whole array */
 
-        errorcode = cbf_realloc ((void **) &vaxis,
-                                 &(positioner->axes),
-                                 sizeof (cbf_axis_struct),
-                                 positioner->axes + 1);
+        cbf_failnez (cbf_calculate_position (goniometer, reserved, ratio, 0, 0, 0,
+                                             NULL, NULL, NULL))
 
-        positioner->axis = (cbf_axis_struct *)vaxis;
+        memcpy (matrix, goniometer->matrix, sizeof (matrix));
 
-        if (errorcode)
-        { int nerrorcode;
+#ifdef _OPENMP
+#pragma omp parallel for if(nvectors > 65536)
+#endif
+        for (i = 0; i < (long) nvectors; i++)
+        {
+            double delta [3];
 
-            void * vdepends_on;
+            delta [0] = lab [3 * i]     - matrix [0][3];
+            delta [1] = lab [3 * i + 1] - matrix [1][3];
+            delta [2] = lab [3 * i + 2] - matrix [2][3];
 
-            void * vrotation_axis;
+            reciprocal [3 * i]     = matrix [0][0] * delta [0] +
+                                     matrix [1][0] * delta [1] +
+                                     matrix [2][0] * delta [2];
 
-            vname = (void *)axis.name;
+            reciprocal [3 * i + 1] = matrix [0][1] * delta [0] +
+                                     matrix [1][1] * delta [1] +
+                                     matrix [2][1] * delta [2];
 
-            vdepends_on = (void *)axis.depends_on;
+            reciprocal [3 * i + 2] = matrix [0][2] * delta [0] +
+                                     matrix [1][2] * delta [1] +
+                                     matrix [2][2] * delta [2];
+        }
 
-            vrotation_axis = (void *)axis.rotation_axis;
+        return 0;
+    }
 
-            nerrorcode = errorcode |
-              cbf_free (&vname, NULL) |
-              cbf_free (&vdepends_on, NULL) |
-              cbf_free (&vrotation_axis, NULL);
 
-            axis.name = NULL;
+    /* Construct a detector positioner */
 
-            axis.depends_on = NULL;
+    int cbf_construct_detector (cbf_handle    handle,
+                                cbf_detector *detector,
+                                unsigned int  element_number)
+    {
+        int errorcode, precedence;
 
-            axis.rotation_axis = NULL;
+        unsigned int row, axis;
 
-            return nerrorcode;
+        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
+        
+        const char *array_section_id;
 
-        }
+        const char * target_axis;
 
-        length = sqrt (length);
+        const char * rotation_axis;
 
-        axis.type = type;
+        size_t axis_index;
 
-        axis.vector [0] = vector1 / length;
-        axis.vector [1] = vector2 / length;
-        axis.vector [2] = vector3 / length;
+        const char *surface_axis [2];  /* fast, slow */
+        
+        const char *array_colname;
 
-        axis.offset [0] = offset1;
-        axis.offset [1] = offset2;
-        axis.offset [2] = offset3;
+        double displacement [2], increment [2];
 
-        axis.start     = start;
-        axis.increment = increment;
-        axis.setting   = 0;
-        axis.rotation  = rotation;
+        cbf_positioner positioner;
+        
+        /* fprintf(stderr,"cbf_construct_detector elno %d\n",element_number); */
 
-        positioner->axis [positioner->axes - 1] = axis;
+        if (!detector)
 
-        positioner->matrix_is_valid = 0;
+            return CBF_ARGUMENT;
 
-        return 0;
-    }
 
+        /* Get the detector id */
 
-    /* Add a goniometer axis from a file */
+        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
 
-    static int cbf_read_positioner_axis (cbf_handle      handle,
-                                  unsigned int    reserved,
-                                  cbf_positioner  positioner,
-                                  const char     *axis_id,
-                                  int             read_setting)
-    {
-        const char *prev_id;
+        cbf_failnez (cbf_find_category (handle, "diffrn_detector"))
+        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
+        cbf_failnez (cbf_find_row      (handle, diffrn_id))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_get_value     (handle, &id))
 
-        const char *rot_id;
 
-        cbf_axis_type axis_type;
-        
-        const char *deptype;
+        /* Construct the detector surface */
 
-        double vector1, vector2, vector3, offset1, offset2, offset3;
+        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id));
+        cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
+        cbf_failnez (cbf_find_category (handle, "array_structure_list"))
+        array_colname = "array_section_id";
+        if (cbf_find_column(handle,array_colname)) {
+            array_colname = "array_id";
+            cbf_failnez (cbf_find_category (handle, "array_structure_list"))
+            if (cbf_find_column   (handle, "array_id")) {
+                array_colname = "array_section";
+                cbf_failnez(cbf_find_column (handle, array_colname));
+            }
 
-        double start, increment, rot;
+            cbf_failnez (cbf_find_column   (handle, array_colname));
+        }
 
-        int errorcode;
+        surface_axis [0] = surface_axis [1] = NULL;
 
-        cbf_failnez (cbf_find_category    (handle, "axis"));
-        cbf_failnez (cbf_find_column      (handle, "id"));
-        cbf_failnez (cbf_find_row         (handle, axis_id));
-        cbf_failnez (cbf_find_column      (handle, "depends_on"));
-        cbf_failnez (cbf_get_value        (handle, &prev_id));
-        cbf_failnez (cbf_get_typeofvalue  (handle, &deptype));
-        if (cbf_cistrcmp(deptype, "null") == 0) {
-            prev_id = NULL;
-        }
+        while (cbf_find_nextrow (handle, array_section_id) == 0)
+        {
+            cbf_failnez (cbf_find_column      (handle, "precedence"))
+            cbf_failnez (cbf_get_integervalue (handle, &precedence))
 
-        if (!cbf_find_column (handle, "rotation_axis")) {
+            if (precedence < 1 || precedence > 2)
 
-            cbf_failnez (cbf_get_value    (handle, &rot_id));
+                return CBF_FORMAT;
 
-        } else {
+            if (surface_axis [precedence - 1])
 
-            rot_id = NULL;
+                return CBF_FORMAT;
 
+            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
+            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
+            cbf_failnez (cbf_find_column   (handle, array_colname));
         }
 
-        if (!cbf_find_column (handle, "rotation")) {
-
-            cbf_failnez (cbf_get_doublevalue (handle, &rot));
+        if (!surface_axis [0])
 
-        } else {
+            return CBF_FORMAT;
 
-            rot = 0.0;
+        cbf_failnez (cbf_find_category   (handle, "array_structure_list_axis"))
+        cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
+        cbf_failnez (cbf_find_row        (handle, surface_axis [0]))
+        cbf_failnez (cbf_find_column     (handle, "axis_id"))
+        cbf_failnez (cbf_get_value       (handle, &surface_axis [0]))
+        cbf_failnez (cbf_find_column     (handle, "displacement"))
+        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
+        cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+        cbf_failnez (cbf_get_doublevalue (handle, &increment [0]))
 
+        if (surface_axis [1])
+        {
+            cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
+            cbf_failnez (cbf_find_row        (handle, surface_axis [1]))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_get_value       (handle, &surface_axis [1]))
+            cbf_failnez (cbf_find_column     (handle, "displacement"))
+            cbf_failnez (cbf_get_doublevalue (handle, &displacement [1]))
+            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_get_doublevalue (handle, &increment [1]))
         }
 
-        cbf_failnez (cbf_get_axis_type    (handle, axis_id,
-                                           &axis_type))
-        cbf_failnez (cbf_get_axis_vector  (handle, axis_id,
-                                           &vector1,
-                                           &vector2,
-                                           &vector3))
-        cbf_failnez (cbf_get_axis_offset  (handle, axis_id,
-                                           &offset1,
-                                           &offset2,
-                                           &offset3))
 
-        start = increment = 0.;
+        /* Construct the positioner */
 
-        errorcode = 0;
+       /* fprintf(stderr," Construct the positioner\n"); */
 
-        /* fprintf(stderr," cbf_read_positioner_axis , axis = %s, read_setting = %d\n",axis_id, read_setting);*/
+       cbf_failnez (cbf_make_positioner (&positioner))
 
-        if (read_setting && axis_type != CBF_GENERAL_AXIS)
+        errorcode = cbf_alloc ((void **) detector, NULL,
+                               sizeof (cbf_detector_struct), 1);
+
+        for (row = errorcode = 0; !errorcode; row++)
         {
+            errorcode = cbf_find_category (handle, "diffrn_detector_axis");
 
-            errorcode = cbf_get_axis_setting (handle, reserved, axis_id,
-                                              &start,
-                                              &increment);
+            if (!errorcode)
+            {
+                /* allow for aliases  _diffrn_detector_axis.detector_id
+                 _diffrn_detector_axis.id  (deprecated) */
 
-            if (read_setting < 0) {
-                errorcode = cbf_get_axis_reference_setting (handle, reserved, axis_id,
-                                                            &start);
-            }
+                errorcode = cbf_find_column (handle, "detector_id");
 
-            if ( (read_setting == -2 || read_setting == 2)
-                && (errorcode == CBF_NOTFOUND || errorcode == CBF_FORMAT) ) {
+                if (errorcode)
 
-                start = increment = 0;
+                    errorcode = cbf_find_column (handle, "id");
+            }
 
-                errorcode = 0;
+            if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
+
+                if (errorcode == CBF_NOTFOUND)
+                {
+                    errorcode = 0;
 
+                    break;
+                }
             }
 
-            cbf_failnez(errorcode);
+            if (!errorcode)
 
-        }
+                errorcode = cbf_get_value (handle, &this_id);
 
-        cbf_failnez (cbf_add_positioner_axis_wrot (positioner,
-                                              axis_id,
-                                              prev_id,
-                                              rot_id,
-                                              axis_type,
-                                              vector1, vector2, vector3,
-                                              offset1, offset2, offset3,
-                                              start, increment, rot))
+            if (!errorcode)
 
-        return 0;
-    }
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
+
+                    if (!errorcode)
 
+                        errorcode = cbf_get_value (handle, &axis_id);
 
+                    if (!errorcode)
 
-    /* construct a positioner for a given final axis */
+                        errorcode = cbf_read_positioner_axis (handle, 0,
+                                                              positioner,
+                                                              axis_id, 1);
+                }
+        }
 
-    int cbf_construct_positioner (cbf_handle handle,
-                                  cbf_positioner *positioner, const char *axis_id)
-    {
 
-        int errorcode;
+        /* Add the surface axes */
 
-        const char * target_axis;
+        if (!errorcode)
 
-        const char * rotation_axis;
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [0], 0);
 
-        size_t axis_index;
+        if (!errorcode && surface_axis [1])
 
-        unsigned int axis_index_limit;
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [1], 0);
 
-        if (!positioner || !axis_id)
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (positioner);
 
-            return CBF_ARGUMENT;
+            return errorcode | cbf_free ((void **) detector, NULL);
+        }
 
-        /* fprintf(stderr," cbf_construct_positioner, axis %s\n",axis_id); */
+        /* Complete the connectivity of the positioner */
 
-        errorcode = 0;
+        /* fprintf(stderr," Complete the connectivity of the positioner\n"); */
 
+        axis_index = 0;
 
-        /* Construct the positioner */
+        do {
 
-        cbf_failnez (cbf_make_positioner (positioner));
+            size_t index;
 
-        /* Set a limit on the number of axes in the positioner
+            int found;
+            
+            /* fprintf(stderr,"connecting %s\n",positioner->axis[axis_index].name); */
 
-           As a crude limit to break dependency loops, N*(N-1)/2
+            target_axis = positioner->axis[axis_index].depends_on;
 
-           will suffice.
+            rotation_axis = positioner->axis[axis_index].rotation_axis;
 
-         */
+            /* fprintf(stderr," axis %s depends_on %s rotation_axis %s rotation %g\n",
+                    positioner->axis[axis_index].name,
+                    target_axis, rotation_axis,
+                    positioner->axis[axis_index].rotation); */
 
-        cbf_failnez(cbf_find_category(handle,"axis"));
+            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
 
-        cbf_failnez(cbf_count_rows(handle,&axis_index_limit));
+                found = 0;
 
-        axis_index_limit *= (axis_index_limit-1);
+                for (index = 0; index < positioner->axes; index++) {
 
-        axis_index_limit /= 2;
+                    if (index != axis_index &&
+                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
+                    {
 
-        (*positioner)->axis_index_limit = axis_index_limit;
+                        positioner->axis[axis_index].depends_on_index = index;
 
-        /* read the first axis */
+                        found = 1;
 
-        errorcode = cbf_read_positioner_axis (handle,
-                                              0, /* reserved */
-                                              *positioner,
-                                              axis_id, 2);
-        axis_index = 0;
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-        if (!errorcode) {
 
-            do{
+                        break;
 
-                target_axis = (*positioner)->axis[axis_index].depends_on;
+                    }
 
-                rotation_axis = (*positioner)->axis[axis_index].rotation_axis;
+                }
 
-                if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+                if (!found) {
 
                     errorcode = cbf_read_positioner_axis (handle,
                                                           0, /* reserved */
-                                                          *positioner,
+                                                          positioner,
                                                           target_axis, 2);
 
-                    (*positioner)->axis[axis_index].depends_on_index
-                        = (*positioner)->axes-1;
+                    positioner->axis[axis_index].depends_on_index
+                    = positioner->axes-1;
+
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-                    (*positioner)->axis[(*positioner)->axes-1].depdepth
-                        = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
-                           (*positioner)->axis[axis_index].depdepth+1);
 
                     if (!errorcode) break;
 
                 }
 
-                if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
-
-            errorcode = cbf_read_positioner_axis (handle,
-                                                  0, /* reserved */
-                                                  *positioner,
-                                                          rotation_axis, 2);
-
-                    (*positioner)->axis[axis_index].rotation_axis_index
-                        = (*positioner)->axes-1;
-
-                    (*positioner)->axis[(*positioner)->axes-1].depdepth
-                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
-                              (*positioner)->axis[axis_index].depdepth+1);
-
-
-                    if (!errorcode) break;
-
             }
 
-                axis_index++;
-
-            } while (axis_index < (*positioner)->axes);
-
-        }
+            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
 
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (*positioner);
+                found = 0;
 
-            *positioner = NULL;
-        }
+                for (index = 0; index < positioner->axes; index++) {
 
-        return errorcode;
-    }
+                    if (index != axis_index &&
+                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
+                    {
 
-    /* construct a reference positioner for a given final axis */
+                        positioner->axis[axis_index].rotation_axis_index = index;
 
-    int cbf_construct_reference_positioner (cbf_handle handle,
-                                            cbf_positioner *positioner, const char *axis_id)
-    {
+                        found = 1;
 
-        int errorcode;
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-        const char * target_axis;
 
-        const char * rotation_axis;
+                        break;
 
-        size_t axis_index;
+                    }
 
-        unsigned int axis_index_limit;
+                }
 
-        if (!positioner || !axis_id)
+                if (!found) {
 
-            return CBF_ARGUMENT;
 
-        /* fprintf(stderr," cbf_construct_positioner, axis %s\n",axis_id); */
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          rotation_axis, 2);
 
-        errorcode = 0;
+                    positioner->axis[axis_index].rotation_axis_index
+                    = positioner->axes-1;
 
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-        /* Construct the positioner */
 
-        cbf_failnez (cbf_make_positioner (positioner))
+                    if (!errorcode) break;
 
-        /* Set a limit on the number of axes in the positioner
+                }
 
-         As a crude limit to break dependency loops, N*(N-1)/2
+            }
 
-         will suffice.
+            axis_index++;
 
-         */
+        } while (axis_index < positioner->axes);
 
-        cbf_failnez(cbf_find_category(handle,"axis"));
+        /* Insert the cbf handle and element into the dectector */
 
-        cbf_failnez(cbf_count_rows(handle,&axis_index_limit));
+        (*detector)->handle = handle;
 
-        axis_index_limit *= (axis_index_limit-1);
+        (*detector)->element = element_number;
 
-        axis_index_limit /= 2;
 
-        (*positioner)->axis_index_limit = axis_index_limit;
+        /* Copy the start and increment values into the surface axes */
 
-        /* read the first axis */
+        (*detector)->displacement [0] = displacement [0];
+        (*detector)->displacement [1] = displacement [1];
 
-            errorcode = cbf_read_positioner_axis (handle,
-                                                  0, /* reserved */
-                                                  *positioner,
-                                              axis_id, -2);
-        axis_index = 0;
+        (*detector)->increment [0] = increment [0];
+        (*detector)->increment [1] = increment [1];
 
-            if (!errorcode) {
+        if (surface_axis [1])
 
-            do{
+            (*detector)->axes = 2;
 
-                target_axis = (*positioner)->axis[axis_index].depends_on;
+        else
 
-                rotation_axis = (*positioner)->axis[axis_index].rotation_axis;
+            (*detector)->axes = 1;
 
-                if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+        for (axis = 0; axis < (*detector)->axes; axis++)
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          *positioner,
-                                                          target_axis, -2);
+            for (row = 0; row < positioner->axes; row++)
 
-                    (*positioner)->axis[axis_index].depends_on_index
-                    = (*positioner)->axes-1;
+                if (cbf_cistrcmp (positioner->axis [row].name,
+                                  surface_axis [axis]) == 0)
+                {
+                    (*detector)->index [axis] = row;
 
-                    (*positioner)->axis[(*positioner)->axes-1].depdepth
-                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
-                              (*positioner)->axis[axis_index].depdepth+1);
+                    positioner->axis [row].increment = 0;
 
-                    if (!errorcode) break;
+                    break;
+                }
 
-            }
+        (*detector)->positioner = positioner;
 
-                if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+        return 0;
+    }
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          *positioner,
-                                                          rotation_axis, -2);
 
-                    (*positioner)->axis[axis_index].depends_on_index
-                    = (*positioner)->axes-1;
+    /* Construct a detector positioner, creating the necessary categories, and columns */
 
-                    (*positioner)->axis[(*positioner)->axes-1].depdepth
-                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
-                              (*positioner)->axis[axis_index].depdepth+1);
+    int cbf_require_detector (cbf_handle    handle, cbf_detector      *detector,
+                              unsigned int      element_number)
+    {
+        int errorcode, precedence;
 
-                    if (!errorcode) break;
+        unsigned int row, axis;
 
-        }
+        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
+        
+        const char *array_section_id;
 
-                axis_index++;
+        const char * target_axis;
 
-            } while (axis_index < (*positioner)->axes);
+        const char * rotation_axis;
 
-        }
+        size_t axis_index;
 
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (*positioner);
+        const char *surface_axis [2];
 
-            *positioner = NULL;
-        }
+        double displacement [2], increment [2];
 
-        return errorcode;
+        cbf_positioner positioner;
 
-    }
+        if (!detector)
 
+            return CBF_ARGUMENT;
 
-    /* Calculate a position given initial coordinates */
 
-    static int cbf_calculate_position (cbf_positioner positioner,
-                                unsigned int   reserved,
-                                double         ratio,
-                                double         initial1,
-                                double         initial2,
-                                double         initial3,
-                                double        *final1,
-                                double        *final2,
-                                double        *final3)
-    {
-        size_t i, istart;
+        /* Get the detector id */
 
-        int idep;
+        cbf_failnez (cbf_require_diffrn_id (handle, &diffrn_id, "DIFFRN_ID"))
 
-        int irot;
+        cbf_failnez (cbf_require_category (handle, "diffrn_detector"))
+        cbf_failnez (cbf_require_column   (handle, "diffrn_id"))
+        if (cbf_find_row (handle, diffrn_id))  {
+            cbf_failnez(cbf_new_row(handle))
+            cbf_failnez(cbf_set_value(handle,diffrn_id))
+        }
+        cbf_failnez (cbf_require_column   (handle, "id"))
+        cbf_failnez (cbf_require_value    (handle, &id, diffrn_id))
 
-        double setting;
 
-        double rangle;
+        /* Construct the detector surface */
 
-        if (!positioner)
+        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id))
+        cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
+        cbf_failnez (cbf_require_category (handle, "array_structure_list"))
+        if (cbf_find_column(handle,"array_section_id")) {
+            if (cbf_find_column(handle,"array_id")) {
+                cbf_failnez (cbf_find_column   (handle, "array_section"));
+            }
+        }
 
-            return CBF_ARGUMENT;
+        surface_axis [0] = surface_axis [1] = NULL;
 
-        if (reserved != 0)
+        while (cbf_find_nextrow (handle, array_id) == 0)
+        {
+            cbf_failnez (cbf_find_column      (handle, "precedence"))
+            cbf_failnez (cbf_get_integervalue (handle, &precedence))
 
-            return CBF_ARGUMENT;
+            if (precedence < 1 || precedence > 2)
 
-        istart = 0;
+                return CBF_FORMAT;
 
-        for (i = 0; i < positioner->axes; i++)
-        {
-            setting = positioner->axis [i].start + ratio *
-            positioner->axis [i].increment;
+            if (surface_axis [precedence - 1])
 
-            if (positioner->axis [i].setting != setting)
-            {
-                positioner->matrix_is_valid = 0;
+                return CBF_FORMAT;
 
-                positioner->axis [i].setting = setting;
+            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
+            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
+            if (cbf_find_column(handle,"array_section_id")) {
+                if (cbf_find_column(handle,"array_id")) {
+                    cbf_failnez (cbf_find_column   (handle, "array_section"));
+                }
             }
+        }
+
+        if (!surface_axis[0]) {
+            cbf_failnez (cbf_require_column  (handle, "array_id"))
+            cbf_failnez (cbf_new_row         (handle))
+            cbf_failnez (cbf_set_value       (handle, array_id))
+            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
+            cbf_failnez (cbf_set_value       (handle, array_section_id))
+            cbf_failnez (cbf_require_column  (handle, "precedence"))
+            cbf_failnez (cbf_set_integervalue(handle,1))
+            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
+            cbf_failnez (cbf_require_value   (handle, &surface_axis [0], "ELEMENT_X"))
 
-            if (positioner->axis [i].depdepth == 0) istart = i;
         }
 
+        if (!surface_axis[1]) {
+            cbf_failnez (cbf_require_column  (handle,"array_id"))
+            cbf_failnez (cbf_new_row         (handle))
+            cbf_failnez (cbf_set_value       (handle, array_id))
+            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
+            cbf_failnez (cbf_set_value       (handle, array_section_id))
+            cbf_failnez (cbf_require_column  (handle, "precedence"))
+            cbf_failnez (cbf_set_integervalue(handle,2))
+            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
+            cbf_failnez (cbf_require_value   (handle, &surface_axis [1], "ELEMENT_Y"))
 
-        if (!positioner->matrix_is_valid || positioner->matrix_ratio_used != ratio )
-        {
+        }
 
+        if (!surface_axis [0])
 
-            positioner->matrix_ratio_used = ratio;
+            return CBF_FORMAT;
 
-            positioner->matrix [0][0] = 1;
-            positioner->matrix [0][1] = 0;
-            positioner->matrix [0][2] = 0;
-            positioner->matrix [0][3] = 0;
-            positioner->matrix [1][0] = 0;
-            positioner->matrix [1][1] = 1;
-            positioner->matrix [1][2] = 0;
-            positioner->matrix [1][3] = 0;
-            positioner->matrix [2][0] = 0;
-            positioner->matrix [2][1] = 0;
-            positioner->matrix [2][2] = 1;
-            positioner->matrix [2][3] = 0;
+        cbf_failnez (cbf_require_category   (handle, "array_structure_list_axis"))
+        cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
+        cbf_failnez (cbf_require_row        (handle, surface_axis [0]))
+        cbf_failnez (cbf_require_column     (handle, "axis_id"))
+        cbf_failnez (cbf_require_value      (handle, &surface_axis [0], surface_axis[0]))
+        cbf_failnez (cbf_require_column     (handle, "displacement"))
+        cbf_failnez (cbf_require_doublevalue(handle, &displacement [0], 0.0))
+        cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
+        cbf_failnez (cbf_require_doublevalue(handle, &(increment [0]), 0.0))
 
-            idep = 0;
+        if (surface_axis [1])
+        {
+            cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
+            cbf_failnez (cbf_require_row        (handle, surface_axis [1]))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_value      (handle, &surface_axis [1], surface_axis[1]))
+            cbf_failnez (cbf_require_column     (handle, "displacement"))
+            cbf_failnez (cbf_require_doublevalue(handle, &displacement [1], 0.0))
+            cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_require_doublevalue(handle, &(increment [1]), 0.0))
+        }
 
-            irot = -1;
 
-            rangle = 0.;
+        /* Construct the positioner */
 
-            i = istart;
+        cbf_failnez (cbf_make_positioner (&positioner))
 
-            while (1) {
+        errorcode = cbf_alloc ((void **) detector, NULL,
+                               sizeof (cbf_detector_struct), 1);
 
-                setting = positioner->axis [i].setting;
+        for (row = errorcode = 0; !errorcode; row++)
+        {
+            errorcode = cbf_require_category (handle, "diffrn_detector_axis");
 
-                if (positioner->axis [i].type == CBF_TRANSLATION_AXIS && irot == -1)
-                {
-                    positioner->matrix [0][3] += setting * positioner->axis [i].vector [0];
-                    positioner->matrix [1][3] += setting * positioner->axis [i].vector [1];
-                    positioner->matrix [2][3] += setting * positioner->axis [i].vector [2];
-                    /* fprintf(stderr," calculate position, axis %s, translate [%g, %g, %g]\n",
-                            positioner->axis [i].name,
-                            setting * positioner->axis [i].vector [0],
-                            setting * positioner->axis [i].vector [1],
-                            setting * positioner->axis [i].vector [2]); */
+            if (!errorcode)
+            {
+                /* allow for aliases  _diffrn_detector_axis.detector_id
+                 _diffrn_detector_axis.id  (deprecated) */
 
+                errorcode = cbf_find_column (handle, "detector_id");
 
-                }
-                else
-                {
-                    double s, x, y, z, w,
-                    xx, yy, zz, xy, xz, xw, yz, yw, zw;
+                if (errorcode)
 
-                    double rotation [3][3], product [3][4];
+                    errorcode = cbf_find_column (handle, "id");
 
-                    int r1, c1r2, c2;
+                if (errorcode)
 
-                    setting += rangle;
+                    errorcode = cbf_require_column (handle, "detector_id");
 
-                    s = sin (setting * 0.00872664625997164788461845384244);
+            }
 
-                    x = positioner->axis [i].vector [0] * s;
-                    y = positioner->axis [i].vector [1] * s;
-                    z = positioner->axis [i].vector [2] * s;
+            if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
 
-                    w = cos (setting * 0.00872664625997164788461845384244);
+                if (errorcode == CBF_NOTFOUND)
+                {
+                    errorcode = 0;
 
-                    xx = x * x;
-                    yy = y * y;
-                    zz = z * z;
-                    xy = x * y;
-                    xz = x * z;
-                    xw = x * w;
-                    yz = y * z;
-                    yw = y * w;
-                    zw = z * w;
+                    break;
+                }
+            }
 
-                    rotation [0][0] = 1 - 2 * (yy + zz);
-                    rotation [0][1] =     2 * (xy - zw);
-                    rotation [0][2] =     2 * (xz + yw);
-                    rotation [1][0] =     2 * (xy + zw);
-                    rotation [1][1] = 1 - 2 * (xx + zz);
-                    rotation [1][2] =     2 * (yz - xw);
-                    rotation [2][0] =     2 * (xz - yw);
-                    rotation [2][1] =     2 * (yz + xw);
-                    rotation [2][2] = 1 - 2 * (xx + yy);
+            if (!errorcode)
 
-                    /* fprintf(stderr," calculate position, axis %s, rotate [%g + i*%g + j*%g + k*%g]\n",
-                            positioner->axis [i].name, w, x, y, z); */
+                errorcode = cbf_get_value (handle, &this_id);
 
+            if (!errorcode)
 
-                    for (r1 = 0; r1 < 3; r1++)
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
 
-                        for (c2 = 0; c2 < 4; c2++)
-                        {
-                            product [r1][c2] = 0;
+                    if (!errorcode)
 
-                            for (c1r2 = 0; c1r2 < 3; c1r2++)
+                        errorcode = cbf_get_value (handle, &axis_id);
 
-                                product [r1][c2] += rotation [r1][c1r2] *
-                                positioner->matrix [c1r2][c2];
-                        }
+                    if (!errorcode)
 
-                    for (r1 = 0; r1 < 3; r1++)
+                        errorcode = cbf_read_positioner_axis (handle, 0,
+                                                              positioner,
+                                                              axis_id, 1);
+                }
+        }
 
-                        for (c2 = 0; c2 < 4; c2++)
 
-                            positioner->matrix [r1][c2] = product [r1][c2];
-                }
+        /* Add the surface axes */
 
-                positioner->matrix [0][3] += positioner->axis [i].offset [0];
-                positioner->matrix [1][3] += positioner->axis [i].offset [1];
-                positioner->matrix [2][3] += positioner->axis [i].offset [2];
+        if (!errorcode)
 
-                if (irot == -1) {
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [0], 0);
 
-                    irot = positioner->axis[i].rotation_axis_index;
+        if (!errorcode && surface_axis [1])
 
-                    rangle = positioner->axis[i].rotation;
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [1], 0);
 
-                    if (irot >= 0 && fabs(rangle) >= 1.e-38) {
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (positioner);
 
-                        if (cbf_cistrcmp(positioner->axis[i].depends_on,
-                                         positioner->axis[irot].depends_on)
-                            && cbf_cistrcmp(positioner->axis[i].depends_on,
-                                            positioner->axis[irot].name)) {
+            return errorcode | cbf_free ((void **) detector, NULL);
+        }
 
-                            /* fprintf (stderr," CBFlib: cbf_calculate_position: "
-                                     "different rotation axis %s dependency for %s, %s vs. %s "
-                                     "not supported\n",
-                                     positioner->axis[irot].name,
-                                     positioner->axis[i].name,
-                                     positioner->axis[i].depends_on,
-                                     positioner->axis[irot].depends_on); */
+        /* Complete the connectivity of the positioner */
 
-                            return CBF_FORMAT;
+        axis_index = 0;
 
-                        }
+        do {
 
-                        i = irot;
+            size_t index;
 
-                        continue;
-                    }
+            int found;
 
-                    irot = -1;
+            target_axis = positioner->axis[axis_index].depends_on;
 
-                }
+            rotation_axis = positioner->axis[axis_index].rotation_axis;
 
-                idep = positioner->axis[i].depends_on_index;
+            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
 
-                if (idep < 0) break;
+                found = 0;
 
-                i = idep;
+                for (index = 0; index < positioner->axes; index++) {
 
-                irot = -1;
+                    if (index != axis_index &&
+                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
+        {
 
-                rangle = 0.0;
+                        positioner->axis[axis_index].depends_on_index = index;
 
-            }
+                        found = 1;
 
-            positioner->matrix_is_valid = 1;
-        }
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-        /* fprintf(stderr," Overall matrix [[%g %g %g]] + %g\n"
-                "                [[%g %g %g]] + %g\n"
-                "                [[%g %g %g]] + %g\n",
-                positioner->matrix [0][0],
-                positioner->matrix [0][1],
-                positioner->matrix [0][2],
-                positioner->matrix [0][3],
-                positioner->matrix [1][0],
-                positioner->matrix [1][1],
-                positioner->matrix [1][2],
-                positioner->matrix [1][3],
-                positioner->matrix [2][0],
-                positioner->matrix [2][1],
-                positioner->matrix [2][2],
-                positioner->matrix [2][3]); */
 
+                        break;
 
-        if (final1)
+        }
 
-            *final1 = positioner->matrix [0][0] * initial1 +
-            positioner->matrix [0][1] * initial2 +
-            positioner->matrix [0][2] * initial3 +
-            positioner->matrix [0][3];
+                }
 
-        if (final2)
+                if (!found) {
 
-            *final2 = positioner->matrix [1][0] * initial1 +
-            positioner->matrix [1][1] * initial2 +
-            positioner->matrix [1][2] * initial3 +
-            positioner->matrix [1][3];
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          target_axis, 2);
 
-        if (final3)
+                    positioner->axis[axis_index].depends_on_index
+                    = positioner->axes-1;
 
-            *final3 = positioner->matrix [2][0] * initial1 +
-            positioner->matrix [2][1] * initial2 +
-            positioner->matrix [2][2] * initial3 +
-            positioner->matrix [2][3];
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-        return 0;
-    }
 
+                    if (!errorcode) break;
 
-    /* Calculate the initial position given final coordinates */
+                }
 
-    static int cbf_calculate_initial_position (cbf_positioner positioner,
-                                        unsigned int   reserved,
-                                        double         ratio,
-                                        double         final1,
-                                        double         final2,
-                                        double         final3,
-                                        double        *initial1,
-                                        double        *initial2,
-                                        double        *initial3)
-    {
-        double delta [3];
+            }
 
-        if (reserved != 0)
+            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
 
-            return CBF_ARGUMENT;
+                found = 0;
 
+                for (index = 0; index < positioner->axes; index++) {
 
-        /* Update the matrix */
+                    if (index != axis_index &&
+                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
+                    {
 
-        cbf_failnez (cbf_calculate_position (positioner, reserved, ratio, 0, 0, 0,
-                                             NULL, NULL, NULL))
+                        positioner->axis[axis_index].rotation_axis_index = index;
 
-        delta [0] = final1 - positioner->matrix [0][3];
-        delta [1] = final2 - positioner->matrix [1][3];
-        delta [2] = final3 - positioner->matrix [2][3];
+                        found = 1;
 
-        if (initial1)
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-            *initial1 = positioner->matrix [0][0] * delta [0] +
-            positioner->matrix [1][0] * delta [1] +
-            positioner->matrix [2][0] * delta [2];
 
-        if (initial2)
+                        break;
 
-            *initial2 = positioner->matrix [0][1] * delta [0] +
-            positioner->matrix [1][1] * delta [1] +
-            positioner->matrix [2][1] * delta [2];
+                    }
 
-        if (initial3)
+                }
 
-            *initial3 = positioner->matrix [0][2] * delta [0] +
-            positioner->matrix [1][2] * delta [1] +
-            positioner->matrix [2][2] * delta [2];
+                if (!found) {
 
-        return 0;
-    }
 
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          rotation_axis, 2);
 
-    /* Construct a goniometer */
+                    positioner->axis[axis_index].rotation_axis_index
+                    = positioner->axes-1;
 
-    int cbf_construct_goniometer (cbf_handle handle,
-                                  cbf_goniometer *goniometer)
-    {
-        const char *diffrn_id, *id, *this_id, *axis_id;
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-        const char * target_axis;
 
-        const char * rotation_axis;
+                    if (!errorcode) break;
 
-        size_t axis_index;
+                }
 
-        unsigned int row;
+            }
 
-        int errorcode;
+            axis_index++;
 
+        } while (axis_index < positioner->axes);
 
-        if (!goniometer)
 
-            return CBF_ARGUMENT;
+        /* Insert the cbf handle and element into the dectector */
 
+        (*detector)->handle = handle;
 
-        /* Get the measurement id */
+        (*detector)->element = element_number;
 
-        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
 
-        cbf_failnez (cbf_find_category (handle, "diffrn_measurement"))
-        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
-        cbf_failnez (cbf_find_row      (handle, diffrn_id))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_get_value     (handle, &id))
 
+        /* Copy the start and increment values into the surface axes */
 
-        /* Construct the goniometer */
+        (*detector)->displacement [0] = displacement [0];
+        (*detector)->displacement [1] = displacement [1];
 
-        cbf_failnez (cbf_make_positioner (goniometer))
+        (*detector)->increment [0] = increment [0];
+        (*detector)->increment [1] = increment [1];
 
-        for (row = errorcode = 0; !errorcode; row++)
-        {
-            errorcode = cbf_find_category (handle, "diffrn_measurement_axis");
+        if (surface_axis [1])
 
-            if (!errorcode)
-            {
-                /* allow for aliases  _diffrn_measurement_axis.measurement_id
-                 _diffrn_measurement_axis.id  (deprecated) */
+            (*detector)->axes = 2;
 
-                errorcode = cbf_find_column (handle, "measurement_id");
+        else
 
-                if (errorcode)
+            (*detector)->axes = 1;
 
-                    errorcode = cbf_find_column (handle, "id");
-            }
+        for (axis = 0; axis < (*detector)->axes; axis++)
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
+            for (row = 0; row < positioner->axes; row++)
 
-                if (errorcode == CBF_NOTFOUND)
+                if (cbf_cistrcmp (positioner->axis [row].name,
+                                  surface_axis [axis]) == 0)
                 {
-                    errorcode = 0;
+                    (*detector)->index [axis] = row;
+
+                    positioner->axis [row].increment = 0;
 
                     break;
                 }
-            }
-
-            if (!errorcode)
-
-                errorcode = cbf_get_value (handle, &this_id);
 
-            if (!errorcode)
+        (*detector)->positioner = positioner;
 
-                if (cbf_cistrcmp (id, this_id) == 0)
-                {
-                    errorcode = cbf_find_column (handle, "axis_id");
+        return 0;
+    }
 
-                    if (!errorcode)
 
-                        errorcode = cbf_get_value (handle, &axis_id);
+    /* Construct a reference detector positioner */
 
-                    if (!errorcode)
+    int cbf_construct_reference_detector (cbf_handle    handle,
+                                          cbf_detector *detector,
+                                          unsigned int  element_number)
+    {
+        int errorcode, precedence;
 
-                        errorcode = cbf_read_positioner_axis (handle,
-                                                              0, /* reserved */
-                                                              *goniometer,
-                                                              axis_id, 1);
-                }
-        }
+        unsigned int row, axis;
 
-        /* Complete the connectivity of the positioner */
+        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
+        
+        const char * array_section_id;
 
-        axis_index = 0;
+        const char * target_axis;
 
-        do {
+        const char * rotation_axis;
 
-            size_t index;
+        size_t axis_index;
 
-            int found;
+        const char *surface_axis [2];
 
-            target_axis = (*goniometer)->axis[axis_index].depends_on;
+        double displacement [2], increment [2];
 
-            rotation_axis = (*goniometer)->axis[axis_index].rotation_axis;
-            
-            if (target_axis
-                && (!cbf_cistrcmp (target_axis,".")
-                    ||!cbf_cistrcmp (target_axis,"?"))) {
-                    
-                    cbf_debug_print3("non-null dependency '%s' for axis '%s'\n",
-                                     target_axis,
-                                     (*goniometer)->axis[axis_index].name);
-                    target_axis = NULL;
-                    
-                }
+        cbf_positioner positioner;
 
-            if (rotation_axis
-                && (!cbf_cistrcmp (rotation_axis,".")
-                    ||!cbf_cistrcmp (rotation_axis,"?"))) {
-                    
-                    cbf_debug_print3("non-null rotation_axis '%s' for axis '%s'\n",
-                                     rotation_axis,
-                                     (*goniometer)->axis[axis_index].name);
-                    rotation_axis = NULL;
-                    
-                }
+        if (!detector)
 
-            if ( target_axis ) {
+            return CBF_ARGUMENT;
 
-                found = 0;
 
-                for (index = 0; index < (*goniometer)->axes; index++) {
+        /* Get the detector id */
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (target_axis,(*goniometer)->axis[index].name)== 0)
-                    {
+        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id));
 
-                        (*goniometer)->axis[axis_index].depends_on_index = index;
+        cbf_failnez (cbf_find_category (handle, "diffrn_detector"));
+        cbf_failnez (cbf_find_column   (handle, "diffrn_id"));
+        cbf_failnez (cbf_find_row      (handle, diffrn_id));
+        cbf_failnez (cbf_find_column   (handle, "id"));
+        cbf_failnez (cbf_get_value     (handle, &id));
 
-                        found = 1;
 
-                        (*goniometer)->axis[index].depdepth
-                        = cbf_max( (*goniometer)->axis[index].depdepth,
-                                  (*goniometer)->axis[axis_index].depdepth+1);
+        /* Construct the detector surface */
 
+        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id));
+        cbf_failnez (cbf_get_array_section_id( handle,element_number,&array_section_id));
+        cbf_failnez (cbf_find_category (handle, "array_structure_list"));
+        if (cbf_find_column(handle,"array_section_id")) {
+            if (cbf_find_column(handle,"array_id")) {
+                cbf_failnez (cbf_find_column   (handle, "array_section"));
+            }
+        }
 
-                        break;
+        surface_axis [0] = surface_axis [1] = NULL;
 
-                    }
+        while (cbf_find_nextrow (handle, array_id) == 0)
+        {
+            cbf_failnez (cbf_find_column      (handle, "precedence"))
+            cbf_failnez (cbf_get_integervalue (handle, &precedence))
 
-                }
+            if (precedence < 1 || precedence > 2)
 
-                if (!found) {
+                return CBF_FORMAT;
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          *goniometer,
-                                                          target_axis, 2);
+            if (surface_axis [precedence - 1])
 
-                    (*goniometer)->axis[axis_index].depends_on_index
-                    = (*goniometer)->axes-1;
+                return CBF_FORMAT;
 
-                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
-                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
-                              (*goniometer)->axis[axis_index].depdepth+1);
+            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
+            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
+            if (cbf_find_column(handle,"array_section_id")) {
+                cbf_failnez (cbf_find_column   (handle, "array_id"));
+            }
+        }
 
+        if (!surface_axis [0])
 
-                    if (!errorcode) break;
+            return CBF_FORMAT;
 
-                }
+        cbf_failnez (cbf_find_category   (handle, "array_structure_list_axis"))
+        cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
+        cbf_failnez (cbf_find_row        (handle, surface_axis [0]))
+        cbf_failnez (cbf_find_column     (handle, "axis_id"))
+        cbf_failnez (cbf_get_value       (handle, &surface_axis [0]))
+        if (cbf_find_column(handle,"reference_displacement")) {
+            cbf_failnez(cbf_find_column(handle,"displacement"))
+        }
+        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
+        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
+        cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+        cbf_failnez (cbf_get_doublevalue (handle, &increment [0]))
 
+        if (surface_axis [1])
+        {
+            cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
+            cbf_failnez (cbf_find_row        (handle, surface_axis [1]))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_get_value       (handle, &surface_axis [1]))
+            if (cbf_find_column(handle,"reference_displacement")) {
+                cbf_failnez(cbf_find_column(handle,"displacement"))
             }
+            cbf_failnez (cbf_get_doublevalue (handle, &displacement [1]))
+            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_get_doublevalue (handle, &increment [1]))
+        }
 
-            if ( rotation_axis ) {
 
-                found = 0;
+        /* Construct the positioner */
 
-                for (index = 0; index < (*goniometer)->axes; index++) {
+        cbf_failnez (cbf_make_positioner (&positioner))
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (rotation_axis,(*goniometer)->axis[index].name)== 0)
-                    {
+        errorcode = cbf_alloc ((void **) detector, NULL,
+                               sizeof (cbf_detector_struct), 1);
 
-                        (*goniometer)->axis[axis_index].rotation_axis_index = index;
+        for (row = errorcode = 0; !errorcode; row++)
+        {
+            errorcode = cbf_find_category (handle, "diffrn_detector_axis");
 
-                        found = 1;
+            if (!errorcode)
+            {
+                /* allow for aliases  _diffrn_detector_axis.detector_id
+                 _diffrn_detector_axis.id  (deprecated) */
 
-                        (*goniometer)->axis[index].depdepth
-                        = cbf_max( (*goniometer)->axis[index].depdepth,
-                                  (*goniometer)->axis[axis_index].depdepth+1);
+                errorcode = cbf_find_column (handle, "detector_id");
+
+                if (errorcode)
 
+                    errorcode = cbf_find_column (handle, "id");
+            }
 
-                        break;
+            if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
 
-                    }
+                if (errorcode == CBF_NOTFOUND)
+                {
+                    errorcode = 0;
 
+                    break;
                 }
+            }
 
-                if (!found) {
+            if (!errorcode)
 
+                errorcode = cbf_get_value (handle, &this_id);
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          *goniometer,
-                                                          rotation_axis, 2);
+            if (!errorcode)
 
-                    (*goniometer)->axis[axis_index].rotation_axis_index
-                    = (*goniometer)->axes-1;
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
 
-                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
-                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
-                              (*goniometer)->axis[axis_index].depdepth+1);
+                    if (!errorcode)
 
+                        errorcode = cbf_get_value (handle, &axis_id);
 
-                    if (!errorcode) break;
+                    if (!errorcode)
 
+                        errorcode = cbf_read_positioner_axis (handle, 0,
+                                                              positioner,
+                                                              axis_id, -1);
                 }
+        }
 
-            }
 
-            axis_index++;
+        /* Add the surface axes */
 
-        } while (axis_index < (*goniometer)->axes);
+        if (!errorcode)
+
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [0], 0);
+
+        if (!errorcode && surface_axis [1])
 
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [1], 0);
         if (errorcode)
         {
-            errorcode |= cbf_free_positioner (*goniometer);
+            errorcode |= cbf_free_positioner (positioner);
 
-            *goniometer = NULL;
+            return errorcode | cbf_free ((void **) detector, NULL);
         }
 
-        return errorcode;
-    }
-
-
-    /* Free a goniometer */
-
-    int cbf_free_goniometer (cbf_goniometer goniometer)
-    {
-        return cbf_free_positioner (goniometer);
-    }
 
+        /* Complete the connectivity of the positioner */
 
-    /* Get the rotation axis */
+        axis_index = 0;
 
-    int cbf_get_rotation_axis (cbf_goniometer goniometer, unsigned int  reserved,
-                               double       *vector1,
-                               double       *vector2,
-                               double       *vector3)
-    {
-        size_t axis;
+        do {
 
-        if (!goniometer)
+            size_t index;
 
-            return CBF_ARGUMENT;
+            int found;
 
-        if (reserved != 0)
+            target_axis = positioner->axis[axis_index].depends_on;
 
-            return CBF_ARGUMENT;
+            rotation_axis = positioner->axis[axis_index].rotation_axis;
 
+            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
 
-        /* Currently just return the first rotation axis */
+                found = 0;
 
-        for (axis = 0; axis < goniometer->axes; axis++)
+                for (index = 0; index < positioner->axes; index++) {
 
-            if (goniometer->axis [axis].type == CBF_ROTATION_AXIS)
+                    if (index != axis_index &&
+                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
+        {
 
-                if (goniometer->axis [axis].increment)
-                {
-                    if (vector1)
+                        positioner->axis[axis_index].depends_on_index = index;
 
-                        *vector1 = goniometer->axis [axis].vector [0];
+                        found = 1;
 
-                    if (vector2)
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-                        *vector2 = goniometer->axis [axis].vector [1];
 
-                    if (vector3)
+                        break;
 
-                        *vector3 = goniometer->axis [axis].vector [2];
+        }
 
-                    return 0;
                 }
 
-        return CBF_NOTFOUND;
-    }
+                if (!found) {
 
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          target_axis, 2);
 
-    /* Get the rotation range */
+                    positioner->axis[axis_index].depends_on_index
+                    = positioner->axes-1;
 
-    int cbf_get_rotation_range (cbf_goniometer goniometer, unsigned int  reserved,
-                                double       *start,
-                                double       *increment)
-    {
-        size_t axis;
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-        if (!goniometer)
 
-            return CBF_ARGUMENT;
+                    if (!errorcode) break;
 
-        if (reserved != 0)
+                }
 
-            return CBF_ARGUMENT;
+            }
 
+            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
 
-        /* Currently just return the range of the first rotation axis with 
-	   non-zero increment */
+                found = 0;
 
-        for (axis = 0; axis < goniometer->axes; axis++)
+                for (index = 0; index < positioner->axes; index++) {
 
-            if (goniometer->axis [axis].type == CBF_ROTATION_AXIS)
+                    if (index != axis_index &&
+                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
+                    {
 
-                if (goniometer->axis [axis].increment)
-                {
-                    if (start)
+                        positioner->axis[axis_index].rotation_axis_index = index;
 
-                        *start = goniometer->axis [axis].start;
+                        found = 1;
 
-                    if (increment)
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-                        *increment = goniometer->axis [axis].increment;
 
-                    return 0;
-                }
-	
-	/* Second pass just look for first rotation axis */ 
-	
-        for (axis = 0; axis < goniometer->axes; axis++) {
-	  if (goniometer->axis [axis].type == CBF_ROTATION_AXIS) {
-	    if (start) *start = goniometer->axis [axis].start;
-	    if (increment) *increment = goniometer->axis [axis].increment;
-	    return 0;
-	  }
-	}
-	
-        return CBF_NOTFOUND;
-    }
+                        break;
 
+                    }
 
-    /* Reorient a vector */
+                }
 
-    int cbf_rotate_vector (cbf_goniometer goniometer, unsigned int reserved,
-                           double       ratio,
-                           double       initial1,
-                           double       initial2,
-                           double       initial3,
-                           double      *final1,
-                           double      *final2,
-                           double      *final3)
-    {
-        double transformed [3], origin [3];
+                if (!found) {
 
-        if (reserved != 0)
 
-            return CBF_ARGUMENT;
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          rotation_axis, 2);
 
-        cbf_failnez (cbf_calculate_position (goniometer, reserved, ratio, 0, 0, 0,
-                                             &origin [0],
-                                             &origin [1],
-                                             &origin [2]))
+                    positioner->axis[axis_index].rotation_axis_index
+                    = positioner->axes-1;
 
-        cbf_failnez (cbf_calculate_position (goniometer, reserved, ratio,
-                                             initial1,
-                                             initial2,
-                                             initial3,
-                                             &transformed [0],
-                                             &transformed [1],
-                                             &transformed [2]))
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-        if (final1)
 
-            *final1 = transformed [0] - origin [0];
+                    if (!errorcode) break;
 
-        if (final2)
+                }
 
-            *final2 = transformed [1] - origin [1];
+            }
 
-        if (final3)
+            axis_index++;
 
-            *final3 = transformed [2] - origin [2];
+        } while (axis_index < positioner->axes);
 
-        return 0;
-    }
 
+        /* Insert the cbf handle and element into the dectector */
 
-    /* Convert a vector to reciprocal space (assumes beam along -z) */
+        (*detector)->handle = handle;
 
-    int cbf_get_reciprocal (cbf_goniometer goniometer, unsigned int reserved,
-                            double       ratio,
-                            double       wavelength,
-                            double       real1,
-                            double       real2,
-                            double       real3,
-                            double      *reciprocal1,
-                            double      *reciprocal2,
-                            double      *reciprocal3)
-    {
-        double length, ewald [3];
+        (*detector)->element = element_number;
 
-        if (reserved != 0)
 
-            return CBF_ARGUMENT;
+        /* Copy the start and increment values into the surface axes */
 
-        if (wavelength <= 0.0)
+        (*detector)->displacement [0] = displacement [0];
+        (*detector)->displacement [1] = displacement [1];
 
-            return CBF_ARGUMENT;
+        (*detector)->increment [0] = increment [0];
+        (*detector)->increment [1] = increment [1];
 
-        length = real1 * real1 + real2 * real2 + real3 * real3;
+        if (surface_axis [1])
 
-        if (length <= 0.0)
+            (*detector)->axes = 2;
 
-            return CBF_ARGUMENT;
+        else
 
+            (*detector)->axes = 1;
 
-        /* Project the vector onto the sphere */
+        for (axis = 0; axis < (*detector)->axes; axis++)
 
-        length = sqrt (length) * wavelength;
+            for (row = 0; row < positioner->axes; row++)
 
-        ewald [0] = real1 / length;
-        ewald [1] = real2 / length;
-        ewald [2] = real3 / length + 1 / wavelength;
+                if (cbf_cistrcmp (positioner->axis [row].name,
+                                  surface_axis [axis]) == 0)
+                {
+                    (*detector)->index [axis] = row;
 
+                    positioner->axis [row].increment = 0;
 
-        /* Rotate the vector back to the 0 position of the goniometer */
+                    break;
+                }
 
-        cbf_failnez (cbf_calculate_initial_position (goniometer, reserved, ratio,
-                                                     ewald [0],
-                                                     ewald [1],
-                                                     ewald [2],
-                                                     reciprocal1,
-                                                     reciprocal2,
-                                                     reciprocal3))
+        (*detector)->positioner = positioner;
 
         return 0;
     }
 
 
-    /* Construct a detector positioner */
+    /* Construct a reference detector positioner,
+     creating the necessary categories, and columns */
 
-    int cbf_construct_detector (cbf_handle    handle,
-                                cbf_detector *detector,
-                                unsigned int  element_number)
+    int cbf_require_reference_detector (cbf_handle    handle, cbf_detector      *detector,
+                                        unsigned int      element_number)
     {
         int errorcode, precedence;
 
@@ -6979,21 +8513,11 @@ extern "C" {
         
         const char *array_section_id;
 
-        const char * target_axis;
-
-        const char * rotation_axis;
-
-        size_t axis_index;
-
-        const char *surface_axis [2];  /* fast, slow */
-        
-        const char *array_colname;
+        const char *surface_axis [2];
 
         double displacement [2], increment [2];
 
         cbf_positioner positioner;
-        
-        /* fprintf(stderr,"cbf_construct_detector elno %d\n",element_number); */
 
         if (!detector)
 
@@ -7002,34 +8526,32 @@ extern "C" {
 
         /* Get the detector id */
 
-        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
+        cbf_failnez (cbf_require_diffrn_id (handle, &diffrn_id, "DIFFRN_ID"))
 
-        cbf_failnez (cbf_find_category (handle, "diffrn_detector"))
-        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
-        cbf_failnez (cbf_find_row      (handle, diffrn_id))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_get_value     (handle, &id))
+        cbf_failnez (cbf_require_category (handle, "diffrn_detector"))
+        cbf_failnez (cbf_require_column   (handle, "diffrn_id"))
+        if (cbf_find_row (handle, diffrn_id))  {
+            cbf_failnez(cbf_new_row(handle))
+            cbf_failnez(cbf_set_value(handle,diffrn_id))
+        }
+        cbf_failnez (cbf_require_column   (handle, "id"))
+        cbf_failnez (cbf_require_value    (handle, &id, diffrn_id))
 
 
         /* Construct the detector surface */
 
-        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id));
+        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id))
         cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
-        cbf_failnez (cbf_find_category (handle, "array_structure_list"))
-        array_colname = "array_section_id";
-        if (cbf_find_column(handle,array_colname)) {
-            array_colname = "array_id";
-            cbf_failnez (cbf_find_category (handle, "array_structure_list"))
-            if (cbf_find_column   (handle, "array_id")) {
-                array_colname = "array_section";
-                cbf_failnez(cbf_find_column (handle, array_colname));
+        cbf_failnez (cbf_require_category (handle, "array_structure_list"))
+        if (cbf_find_column(handle,"array_section_id")) {
+            if (cbf_find_column(handle,"array_id")) {
+                cbf_failnez (cbf_find_column   (handle, "array_section"));
             }
-
-            cbf_failnez (cbf_find_column   (handle, array_colname));
         }
 
         surface_axis [0] = surface_axis [1] = NULL;
 
+
         while (cbf_find_nextrow (handle, array_section_id) == 0)
         {
             cbf_failnez (cbf_find_column      (handle, "precedence"))
@@ -7045,48 +8567,80 @@ extern "C" {
 
             cbf_failnez (cbf_find_column (handle, "axis_set_id"))
             cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
-            cbf_failnez (cbf_find_column   (handle, array_colname));
+            if (cbf_find_column(handle,"array_section_id")) {
+                if (cbf_find_column(handle,"array_id")) {
+                    cbf_failnez (cbf_find_column   (handle, "array_section"));
+                }
+            }
+        }
+
+        if (!surface_axis[0]) {
+            cbf_failnez (cbf_require_column  (handle, "array_id"))
+            cbf_failnez (cbf_new_row         (handle))
+            cbf_failnez (cbf_set_value       (handle, array_id))
+            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
+            cbf_failnez (cbf_set_value       (handle, array_section_id))
+            cbf_failnez (cbf_require_column  (handle, "precedence"))
+            cbf_failnez (cbf_set_integervalue(handle,1))
+            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
+            cbf_failnez (cbf_require_value   (handle, &surface_axis [0], "ELEMENT_X"))
+        }
+        if (!surface_axis[1]){
+            cbf_failnez (cbf_require_column  (handle,"array_id"))
+            cbf_failnez (cbf_new_row         (handle))
+            cbf_failnez (cbf_set_value       (handle, array_id))
+            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
+            cbf_failnez (cbf_set_value       (handle, array_section_id))
+            cbf_failnez (cbf_require_column  (handle, "precedence"))
+            cbf_failnez (cbf_set_integervalue(handle,2))
+            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
+            cbf_failnez (cbf_require_value   (handle, &surface_axis [1], "ELEMENT_Y"))
+
         }
 
         if (!surface_axis [0])
 
             return CBF_FORMAT;
 
-        cbf_failnez (cbf_find_category   (handle, "array_structure_list_axis"))
-        cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
-        cbf_failnez (cbf_find_row        (handle, surface_axis [0]))
-        cbf_failnez (cbf_find_column     (handle, "axis_id"))
-        cbf_failnez (cbf_get_value       (handle, &surface_axis [0]))
-        cbf_failnez (cbf_find_column     (handle, "displacement"))
-        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
-        cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-        cbf_failnez (cbf_get_doublevalue (handle, &increment [0]))
+        cbf_failnez (cbf_require_category   (handle, "array_structure_list_axis"))
+        cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
+        cbf_failnez (cbf_require_row        (handle, surface_axis [0]))
+        cbf_failnez (cbf_require_column     (handle, "axis_id"))
+        cbf_failnez (cbf_require_value      (handle, &surface_axis [0], surface_axis[0]))
+        if (!cbf_find_column(handle, "reference_displacement") ||
+            !cbf_require_column     (handle, "displacement")){
+            cbf_failnez (cbf_require_doublevalue(handle, &displacement [0], 0.0))
+        }
+        else return CBF_NOTFOUND;
+        cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
+        cbf_failnez (cbf_require_doublevalue(handle, &(increment [0]), 0.0))
 
         if (surface_axis [1])
         {
-            cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
-            cbf_failnez (cbf_find_row        (handle, surface_axis [1]))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_get_value       (handle, &surface_axis [1]))
-            cbf_failnez (cbf_find_column     (handle, "displacement"))
-            cbf_failnez (cbf_get_doublevalue (handle, &displacement [1]))
-            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_get_doublevalue (handle, &increment [1]))
+            cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
+            cbf_failnez (cbf_require_row        (handle, surface_axis [1]))
+            cbf_failnez (cbf_require_column     (handle, "axis_id"))
+            cbf_failnez (cbf_require_value      (handle, &surface_axis [1], surface_axis[1]))
+            if (!cbf_find_column(handle, "reference_displacement") ||
+                !cbf_require_column     (handle, "displacement")){
+                cbf_failnez (cbf_require_doublevalue(handle, &displacement [1], 0.0))
+            }
+            else return CBF_NOTFOUND;
+            cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_require_doublevalue(handle, &(increment [1]), 0.0))
         }
 
 
         /* Construct the positioner */
 
-       /* fprintf(stderr," Construct the positioner\n"); */
-
-       cbf_failnez (cbf_make_positioner (&positioner))
+        cbf_failnez (cbf_make_positioner (&positioner))
 
         errorcode = cbf_alloc ((void **) detector, NULL,
                                sizeof (cbf_detector_struct), 1);
 
         for (row = errorcode = 0; !errorcode; row++)
         {
-            errorcode = cbf_find_category (handle, "diffrn_detector_axis");
+            errorcode = cbf_require_category (handle, "diffrn_detector_axis");
 
             if (!errorcode)
             {
@@ -7098,181 +8652,66 @@ extern "C" {
                 if (errorcode)
 
                     errorcode = cbf_find_column (handle, "id");
-            }
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
+                if (errorcode)
 
-                if (errorcode == CBF_NOTFOUND)
-                {
-                    errorcode = 0;
+                    errorcode = cbf_require_column (handle, "detector_id");
 
-                    break;
-                }
             }
 
             if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
 
-                errorcode = cbf_get_value (handle, &this_id);
-
-            if (!errorcode)
-
-                if (cbf_cistrcmp (id, this_id) == 0)
+                if (errorcode == CBF_NOTFOUND)
                 {
-                    errorcode = cbf_find_column (handle, "axis_id");
-
-                    if (!errorcode)
-
-                        errorcode = cbf_get_value (handle, &axis_id);
-
-                    if (!errorcode)
-
-                        errorcode = cbf_read_positioner_axis (handle, 0,
-                                                              positioner,
-                                                              axis_id, 1);
-                }
-        }
-
-
-        /* Add the surface axes */
-
-        if (!errorcode)
-
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [0], 0);
-
-        if (!errorcode && surface_axis [1])
-
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [1], 0);
-
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (positioner);
-
-            return errorcode | cbf_free ((void **) detector, NULL);
-        }
-
-        /* Complete the connectivity of the positioner */
-
-        /* fprintf(stderr," Complete the connectivity of the positioner\n"); */
-
-        axis_index = 0;
-
-        do {
-
-            size_t index;
-
-            int found;
-            
-            /* fprintf(stderr,"connecting %s\n",positioner->axis[axis_index].name); */
-
-            target_axis = positioner->axis[axis_index].depends_on;
-
-            rotation_axis = positioner->axis[axis_index].rotation_axis;
-
-            /* fprintf(stderr," axis %s depends_on %s rotation_axis %s rotation %g\n",
-                    positioner->axis[axis_index].name,
-                    target_axis, rotation_axis,
-                    positioner->axis[axis_index].rotation); */
-
-            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
-
-                found = 0;
-
-                for (index = 0; index < positioner->axes; index++) {
-
-                    if (index != axis_index &&
-                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
-                    {
-
-                        positioner->axis[axis_index].depends_on_index = index;
-
-                        found = 1;
-
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
-
-
-                        break;
-
-                    }
-
-                }
-
-                if (!found) {
-
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          target_axis, 2);
-
-                    positioner->axis[axis_index].depends_on_index
-                    = positioner->axes-1;
-
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
-
-
-                    if (!errorcode) break;
+                    errorcode = 0;
 
+                    break;
                 }
-
             }
 
-            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
-
-                found = 0;
-
-                for (index = 0; index < positioner->axes; index++) {
-
-                    if (index != axis_index &&
-                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
-                    {
+            if (!errorcode)
 
-                        positioner->axis[axis_index].rotation_axis_index = index;
+                errorcode = cbf_get_value (handle, &this_id);
 
-                        found = 1;
+            if (!errorcode)
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
 
+                    if (!errorcode)
 
-                        break;
+                        errorcode = cbf_get_value (handle, &axis_id);
 
-                    }
+                    if (!errorcode)
 
+                        errorcode = cbf_read_positioner_axis (handle, 0,
+                                                              positioner,
+                                                              axis_id, -1);
                 }
+        }
 
-                if (!found) {
-
-
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          rotation_axis, 2);
-
-                    positioner->axis[axis_index].rotation_axis_index
-                    = positioner->axes-1;
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
+        /* Add the surface axes */
 
+        if (!errorcode)
 
-                    if (!errorcode) break;
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [0], 0);
 
-                }
+        if (!errorcode && surface_axis [1])
 
-            }
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [1], 0);
 
-            axis_index++;
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (positioner);
 
-        } while (axis_index < positioner->axes);
+            return errorcode | cbf_free ((void **) detector, NULL);
+        }
 
         /* Insert the cbf handle and element into the dectector */
 
@@ -7281,6 +8720,7 @@ extern "C" {
         (*detector)->element = element_number;
 
 
+
         /* Copy the start and increment values into the surface axes */
 
         (*detector)->displacement [0] = displacement [0];
@@ -7317,1933 +8757,2076 @@ extern "C" {
     }
 
 
-    /* Construct a detector positioner, creating the necessary categories, and columns */
+    /* Free a detector */
 
-    int cbf_require_detector (cbf_handle    handle, cbf_detector      *detector,
-                              unsigned int      element_number)
+    int cbf_free_detector (cbf_detector detector)
     {
-        int errorcode, precedence;
-
-        unsigned int row, axis;
+        int errorcode = 0;
 
-        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
-        
-        const char *array_section_id;
+        void * memblock;
 
-        const char * target_axis;
+        memblock = (void *)detector;
 
-        const char * rotation_axis;
+        if (detector)
+        {
+            errorcode = cbf_free_positioner (detector->positioner);
 
-        size_t axis_index;
+            errorcode |= cbf_free ((void **) &detector->frame_settings, NULL);
+        }
 
-        const char *surface_axis [2];
+        return errorcode | cbf_free (&memblock, NULL);
+    }
 
-        double displacement [2], increment [2];
 
-        cbf_positioner positioner;
+    /* Update the pixel settings */
 
+    static int cbf_update_pixel (cbf_detector detector, double index1,
+                          double index2)
+    {
         if (!detector)
 
             return CBF_ARGUMENT;
 
+        detector->positioner->axis [detector->index [0]].start =
+        index2 * detector->increment [0] + detector->displacement [0];
 
-        /* Get the detector id */
+        if (detector->axes == 2)
 
-        cbf_failnez (cbf_require_diffrn_id (handle, &diffrn_id, "DIFFRN_ID"))
+            detector->positioner->axis [detector->index [1]].start =
+            index1 * detector->increment [1] + detector->displacement [1];
 
-        cbf_failnez (cbf_require_category (handle, "diffrn_detector"))
-        cbf_failnez (cbf_require_column   (handle, "diffrn_id"))
-        if (cbf_find_row (handle, diffrn_id))  {
-            cbf_failnez(cbf_new_row(handle))
-            cbf_failnez(cbf_set_value(handle,diffrn_id))
-        }
-        cbf_failnez (cbf_require_column   (handle, "id"))
-        cbf_failnez (cbf_require_value    (handle, &id, diffrn_id))
+        return 0;
+    }
 
 
-        /* Construct the detector surface */
+    /* Get the beam center */
 
-        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id))
-        cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
-        cbf_failnez (cbf_require_category (handle, "array_structure_list"))
-        if (cbf_find_column(handle,"array_section_id")) {
-            if (cbf_find_column(handle,"array_id")) {
-                cbf_failnez (cbf_find_column   (handle, "array_section"));
-            }
-        }
+    int cbf_get_beam_center (cbf_detector detector, double *index1,
+                             double *index2,
+                             double *center1,
+                             double *center2)
+    {
+        double pixel00 [3], pixel01 [3], pixel10 [3], m [2][2], det, index [2];
 
-        surface_axis [0] = surface_axis [1] = NULL;
+        if (!detector)
 
-        while (cbf_find_nextrow (handle, array_id) == 0)
-        {
-            cbf_failnez (cbf_find_column      (handle, "precedence"))
-            cbf_failnez (cbf_get_integervalue (handle, &precedence))
+            return CBF_ARGUMENT;
 
-            if (precedence < 1 || precedence > 2)
+        if (detector->axes < 2)
 
-                return CBF_FORMAT;
+            return CBF_NOTIMPLEMENTED;
 
-            if (surface_axis [precedence - 1])
+        cbf_failnez (cbf_get_pixel_coordinates (detector, 0, 0,
+                                                &pixel00 [0],
+                                                &pixel00 [1],
+                                                &pixel00 [2]))
 
-                return CBF_FORMAT;
+        cbf_failnez (cbf_get_pixel_coordinates (detector, 0, 1,
+                                                &pixel01 [0],
+                                                &pixel01 [1],
+                                                &pixel01 [2]))
 
-            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
-            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
-            if (cbf_find_column(handle,"array_section_id")) {
-                if (cbf_find_column(handle,"array_id")) {
-                    cbf_failnez (cbf_find_column   (handle, "array_section"));
-                }
-            }
-        }
+        cbf_failnez (cbf_get_pixel_coordinates (detector, 1, 0,
+                                                &pixel10 [0],
+                                                &pixel10 [1],
+                                                &pixel10 [2]))
 
-        if (!surface_axis[0]) {
-            cbf_failnez (cbf_require_column  (handle, "array_id"))
-            cbf_failnez (cbf_new_row         (handle))
-            cbf_failnez (cbf_set_value       (handle, array_id))
-            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
-            cbf_failnez (cbf_set_value       (handle, array_section_id))
-            cbf_failnez (cbf_require_column  (handle, "precedence"))
-            cbf_failnez (cbf_set_integervalue(handle,1))
-            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
-            cbf_failnez (cbf_require_value   (handle, &surface_axis [0], "ELEMENT_X"))
+        m [0][0] = pixel10 [0] - pixel00 [0];
+        m [0][1] = pixel01 [0] - pixel00 [0];
+        m [1][0] = pixel10 [1] - pixel00 [1];
+        m [1][1] = pixel01 [1] - pixel00 [1];
 
-        }
+        det = m [0][0] * m [1][1] - m [1][0] * m [0][1];
 
-        if (!surface_axis[1]) {
-            cbf_failnez (cbf_require_column  (handle,"array_id"))
-            cbf_failnez (cbf_new_row         (handle))
-            cbf_failnez (cbf_set_value       (handle, array_id))
-            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
-            cbf_failnez (cbf_set_value       (handle, array_section_id))
-            cbf_failnez (cbf_require_column  (handle, "precedence"))
-            cbf_failnez (cbf_set_integervalue(handle,2))
-            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
-            cbf_failnez (cbf_require_value   (handle, &surface_axis [1], "ELEMENT_Y"))
+        if (det == 0.0)
 
-        }
+            return CBF_UNDEFINED;
 
-        if (!surface_axis [0])
+        index [0] = (-m [1][1] * pixel00 [0] + m [0][1] * pixel00 [1]) / det;
+        index [1] =  (m [1][0] * pixel00 [0] - m [0][0] * pixel00 [1]) / det;
 
-            return CBF_FORMAT;
+        if (index1)
 
-        cbf_failnez (cbf_require_category   (handle, "array_structure_list_axis"))
-        cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
-        cbf_failnez (cbf_require_row        (handle, surface_axis [0]))
-        cbf_failnez (cbf_require_column     (handle, "axis_id"))
-        cbf_failnez (cbf_require_value      (handle, &surface_axis [0], surface_axis[0]))
-        cbf_failnez (cbf_require_column     (handle, "displacement"))
-        cbf_failnez (cbf_require_doublevalue(handle, &displacement [0], 0.0))
-        cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
-        cbf_failnez (cbf_require_doublevalue(handle, &(increment [0]), 0.0))
+            *index1 = index [0];
 
-        if (surface_axis [1])
-        {
-            cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
-            cbf_failnez (cbf_require_row        (handle, surface_axis [1]))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_value      (handle, &surface_axis [1], surface_axis[1]))
-            cbf_failnez (cbf_require_column     (handle, "displacement"))
-            cbf_failnez (cbf_require_doublevalue(handle, &displacement [1], 0.0))
-            cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_require_doublevalue(handle, &(increment [1]), 0.0))
-        }
+        if (index2)
 
+            *index2 = index [1];
 
-        /* Construct the positioner */
+        if (center1)
 
-        cbf_failnez (cbf_make_positioner (&positioner))
+            *center1 = index [0] * detector->increment [0];
 
-        errorcode = cbf_alloc ((void **) detector, NULL,
-                               sizeof (cbf_detector_struct), 1);
+        if (center2)
 
-        for (row = errorcode = 0; !errorcode; row++)
-        {
-            errorcode = cbf_require_category (handle, "diffrn_detector_axis");
+            *center2 = index [1] * detector->increment [1];
 
-            if (!errorcode)
-            {
-                /* allow for aliases  _diffrn_detector_axis.detector_id
-                 _diffrn_detector_axis.id  (deprecated) */
+        return 0;
 
-                errorcode = cbf_find_column (handle, "detector_id");
+        /*  a * delta01 + b * delta10 + pixel00 = (0 0 ?)
+
+         a * delta01[0] + b * delta10[0] + pixel00[0] = 0
+         a * delta01[1] + b * delta10[1] + pixel00[1] = 0
+
+         (d01[0] d10[0]) (a) = -(p00[0])
+         (d01[1] d10[1]) (b)    (p00[1])
+
+         (a) = -(d01[0] d10[0])-1 (p00[0])
+         (b)    (d01[1] d10[1])   (p00[1]) */
+    }
+
+
+    /* Set the beam center */
+
+    int cbf_set_beam_center (cbf_detector detector, double *index1,
+                             double *index2,
+                             double *center1,
+                             double *center2)
+    {
+        double oindex1, oindex2, ocenter1, ocenter2;
+
+        double nindex1, nindex2, ncenter1, ncenter2;
 
-                if (errorcode)
+        double psize1, psize2;
 
-                    errorcode = cbf_find_column (handle, "id");
+        unsigned int naxis1, naxis2;
 
-                if (errorcode)
+        int sign1, sign2;
 
-                    errorcode = cbf_require_column (handle, "detector_id");
+        cbf_handle handle;
 
-            }
+        unsigned int element;
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
+        const char *element_id;
 
-                if (errorcode == CBF_NOTFOUND)
-                {
-                    errorcode = 0;
+        CBF_UNUSED( ncenter1 );
 
-                    break;
-                }
-            }
+        CBF_UNUSED( ncenter2 );
 
-            if (!errorcode)
+        if (!detector)
 
-                errorcode = cbf_get_value (handle, &this_id);
+            return CBF_ARGUMENT;
 
-            if (!errorcode)
+        if (detector->axes < 2)
 
-                if (cbf_cistrcmp (id, this_id) == 0)
-                {
-                    errorcode = cbf_find_column (handle, "axis_id");
+            return CBF_NOTIMPLEMENTED;
 
-                    if (!errorcode)
+        handle = detector->handle;
 
-                        errorcode = cbf_get_value (handle, &axis_id);
+        element = detector->element;
 
-                    if (!errorcode)
+        cbf_failnez(cbf_get_element_id(handle,element, &element_id))
 
-                        errorcode = cbf_read_positioner_axis (handle, 0,
-                                                              positioner,
-                                                              axis_id, 1);
-                }
-        }
+        naxis1 = detector->index[1];
 
+        naxis2 = detector->index[0];
 
-        /* Add the surface axes */
+        sign1 = detector->increment[1]>0.0?1.0:-1.0;
 
-        if (!errorcode)
+        sign2 = detector->increment[0]>0.0?1.0:-1.0;
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [0], 0);
+        psize1 = detector->increment[1];
 
-        if (!errorcode && surface_axis [1])
+        if (psize1 < 0.) psize1 = -psize1;
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [1], 0);
+        psize2 = detector->increment[0];
 
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (positioner);
+        if (psize1 < 0.) psize2 = -psize2;
 
-            return errorcode | cbf_free ((void **) detector, NULL);
-        }
+        if (index1) {
 
-        /* Complete the connectivity of the positioner */
+            nindex1 = *index1;
 
-        axis_index = 0;
+        } else {
 
-        do {
+            if (center1 && psize1 != 0.) nindex1 = sign1*(*center1)/psize1;
 
-            size_t index;
+            else return CBF_ARGUMENT;
 
-            int found;
+        }
 
-            target_axis = positioner->axis[axis_index].depends_on;
+        if (index2) {
 
-            rotation_axis = positioner->axis[axis_index].rotation_axis;
+            nindex2 = *index2;
 
-            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+        } else {
 
-                found = 0;
+            if (center2 && psize2 != 0.) nindex2 = sign2*(*center2)/psize2;
 
-                for (index = 0; index < positioner->axes; index++) {
+            else return CBF_ARGUMENT;
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
-        {
+        }
 
-                        positioner->axis[axis_index].depends_on_index = index;
+        if (center1) {
 
-                        found = 1;
+            ncenter1 = *center1;
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
+        } else {
 
+            if (index1 && psize1 != 0.) ncenter1 = sign1*(*index1)*psize1;
 
-                        break;
+            else return CBF_ARGUMENT;
 
         }
 
-                }
+        if (center2) {
 
-                if (!found) {
+            ncenter2 = *center2;
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          target_axis, 2);
+        } else {
 
-                    positioner->axis[axis_index].depends_on_index
-                    = positioner->axes-1;
+            if (index2 && psize2 != 0.) ncenter2 = sign2*(*index2)*psize2;
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
+            else return CBF_ARGUMENT;
 
+        }
 
-                    if (!errorcode) break;
 
-                }
+        cbf_failnez(cbf_get_beam_center(detector, &oindex1, &oindex2, &ocenter1, &ocenter2))
 
-            }
+        cbf_failnez(cbf_find_category(handle, "array_structure_list_axis"))
 
-            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+        cbf_failnez(cbf_find_column(handle, "axis_id"))
 
-                found = 0;
+        if ( nindex1 < oindex1-1.e-6 || nindex1 > oindex1+1.e-6 ) {
 
-                for (index = 0; index < positioner->axes; index++) {
+            double olddisp;
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
-                    {
+            cbf_failnez(cbf_rewind_row(handle))
 
-                        positioner->axis[axis_index].rotation_axis_index = index;
+            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis1].name))
 
-                        found = 1;
+            cbf_failnez(cbf_require_column(handle, "displacement"))
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
+            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
 
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
 
-                        break;
+                                            -(nindex1-oindex1)*detector->increment[1]  + detector->displacement[1]))
 
-                    }
+        }
 
-                }
+        cbf_failnez(cbf_find_column(handle, "axis_id"))
 
-                if (!found) {
+        if ( nindex2 < oindex2-1.e-6 || nindex2 > oindex2+1.e-6 ) {
 
+            double olddisp;
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          rotation_axis, 2);
+            cbf_failnez(cbf_rewind_row(handle))
 
-                    positioner->axis[axis_index].rotation_axis_index
-                    = positioner->axes-1;
+            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis2].name))
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
+            cbf_failnez(cbf_require_column(handle, "displacement"))
 
+            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
 
-                    if (!errorcode) break;
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
 
-                }
+                                            -(nindex2-oindex2)*detector->increment[0]  + detector->displacement[0]))
 
-            }
+        }
 
-            axis_index++;
+        if (!cbf_find_category(handle,"diffrn_data_frame")
 
-        } while (axis_index < positioner->axes);
+            && !cbf_find_column(handle,"detector_element_id")
 
+            && !cbf_find_row(handle,element_id)) {
 
-        /* Insert the cbf handle and element into the dectector */
+            cbf_failnez(cbf_require_column(handle,"center_slow"))
 
-        (*detector)->handle = handle;
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex1*detector->increment[1]))
 
-        (*detector)->element = element_number;
+            cbf_failnez(cbf_require_column(handle,"center_fast"))
 
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex2*detector->increment[0]))
 
+            cbf_failnez(cbf_require_column(handle,"center_units"))
 
-        /* Copy the start and increment values into the surface axes */
+            cbf_failnez(cbf_set_value(handle, "mm"))
 
-        (*detector)->displacement [0] = displacement [0];
-        (*detector)->displacement [1] = displacement [1];
+        }
 
-        (*detector)->increment [0] = increment [0];
-        (*detector)->increment [1] = increment [1];
 
-        if (surface_axis [1])
+        return 0;
 
-            (*detector)->axes = 2;
+    }
 
-        else
+    /* Set the reference beam center */
 
-            (*detector)->axes = 1;
+    int cbf_set_reference_beam_center (cbf_detector detector, double *index1,
+                                       double *index2,
+                                       double *center1,
+                                       double *center2)
+    {
+        double oindex1, oindex2, ocenter1, ocenter2;
 
-        for (axis = 0; axis < (*detector)->axes; axis++)
+        double nindex1, nindex2, ncenter1, ncenter2;
 
-            for (row = 0; row < positioner->axes; row++)
+        double psize1, psize2;
 
-                if (cbf_cistrcmp (positioner->axis [row].name,
-                                  surface_axis [axis]) == 0)
-                {
-                    (*detector)->index [axis] = row;
+        unsigned int naxis1, naxis2;
 
-                    positioner->axis [row].increment = 0;
+        int sign1, sign2;
 
-                    break;
-                }
+        cbf_handle handle;
 
-        (*detector)->positioner = positioner;
+        unsigned int element;
 
-        return 0;
-    }
+        const char *element_id;
 
+        CBF_UNUSED( ncenter1 );
 
-    /* Construct a reference detector positioner */
+        CBF_UNUSED( ncenter2 );
 
-    int cbf_construct_reference_detector (cbf_handle    handle,
-                                          cbf_detector *detector,
-                                          unsigned int  element_number)
-    {
-        int errorcode, precedence;
+        if (!detector)
 
-        unsigned int row, axis;
+            return CBF_ARGUMENT;
 
-        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
-        
-        const char * array_section_id;
+        if (detector->axes < 2)
 
-        const char * target_axis;
+            return CBF_NOTIMPLEMENTED;
 
-        const char * rotation_axis;
+        handle = detector->handle;
 
-        size_t axis_index;
+        element = detector->element;
 
-        const char *surface_axis [2];
+        cbf_failnez(cbf_get_element_id(handle,element, &element_id))
 
-        double displacement [2], increment [2];
+        naxis1 = detector->index[1];
 
-        cbf_positioner positioner;
+        naxis2 = detector->index[0];
 
-        if (!detector)
+        sign1 = detector->increment[1]>0.0?1.0:-1.0;
 
-            return CBF_ARGUMENT;
+        sign2 = detector->increment[0]>0.0?1.0:-1.0;
+
+        psize1 = detector->increment[1];
+
+        if (psize1 < 0.) psize1 = -psize1;
+
+        psize2 = detector->increment[0];
 
+        if (psize1 < 0.) psize2 = -psize2;
 
-        /* Get the detector id */
+        if (index1) {
 
-        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id));
+            nindex1 = *index1;
 
-        cbf_failnez (cbf_find_category (handle, "diffrn_detector"));
-        cbf_failnez (cbf_find_column   (handle, "diffrn_id"));
-        cbf_failnez (cbf_find_row      (handle, diffrn_id));
-        cbf_failnez (cbf_find_column   (handle, "id"));
-        cbf_failnez (cbf_get_value     (handle, &id));
+        } else {
 
+            if (center1 && psize1 != 0.) nindex1 = sign1*(*center1)/psize1;
 
-        /* Construct the detector surface */
+            else return CBF_ARGUMENT;
 
-        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id));
-        cbf_failnez (cbf_get_array_section_id( handle,element_number,&array_section_id));
-        cbf_failnez (cbf_find_category (handle, "array_structure_list"));
-        if (cbf_find_column(handle,"array_section_id")) {
-            if (cbf_find_column(handle,"array_id")) {
-                cbf_failnez (cbf_find_column   (handle, "array_section"));
-            }
         }
 
-        surface_axis [0] = surface_axis [1] = NULL;
-
-        while (cbf_find_nextrow (handle, array_id) == 0)
-        {
-            cbf_failnez (cbf_find_column      (handle, "precedence"))
-            cbf_failnez (cbf_get_integervalue (handle, &precedence))
+        if (index2) {
 
-            if (precedence < 1 || precedence > 2)
+            nindex2 = *index2;
 
-                return CBF_FORMAT;
+        } else {
 
-            if (surface_axis [precedence - 1])
+            if (center2 && psize2 != 0.) nindex2 = sign2*(*center2)/psize2;
 
-                return CBF_FORMAT;
+            else return CBF_ARGUMENT;
 
-            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
-            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
-            if (cbf_find_column(handle,"array_section_id")) {
-                cbf_failnez (cbf_find_column   (handle, "array_id"));
-            }
         }
 
-        if (!surface_axis [0])
+        if (center1) {
 
-            return CBF_FORMAT;
+            ncenter1 = *center1;
 
-        cbf_failnez (cbf_find_category   (handle, "array_structure_list_axis"))
-        cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
-        cbf_failnez (cbf_find_row        (handle, surface_axis [0]))
-        cbf_failnez (cbf_find_column     (handle, "axis_id"))
-        cbf_failnez (cbf_get_value       (handle, &surface_axis [0]))
-        if (cbf_find_column(handle,"reference_displacement")) {
-            cbf_failnez(cbf_find_column(handle,"displacement"))
-        }
-        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
-        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
-        cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-        cbf_failnez (cbf_get_doublevalue (handle, &increment [0]))
+        } else {
 
-        if (surface_axis [1])
-        {
-            cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
-            cbf_failnez (cbf_find_row        (handle, surface_axis [1]))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_get_value       (handle, &surface_axis [1]))
-            if (cbf_find_column(handle,"reference_displacement")) {
-                cbf_failnez(cbf_find_column(handle,"displacement"))
-            }
-            cbf_failnez (cbf_get_doublevalue (handle, &displacement [1]))
-            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_get_doublevalue (handle, &increment [1]))
-        }
+            if (index1 && psize1 != 0.) ncenter1 = sign1*(*index1)*psize1;
 
+            else return CBF_ARGUMENT;
 
-        /* Construct the positioner */
+        }
 
-        cbf_failnez (cbf_make_positioner (&positioner))
+        if (center2) {
 
-        errorcode = cbf_alloc ((void **) detector, NULL,
-                               sizeof (cbf_detector_struct), 1);
+            ncenter2 = *center2;
 
-        for (row = errorcode = 0; !errorcode; row++)
-        {
-            errorcode = cbf_find_category (handle, "diffrn_detector_axis");
+        } else {
 
-            if (!errorcode)
-            {
-                /* allow for aliases  _diffrn_detector_axis.detector_id
-                 _diffrn_detector_axis.id  (deprecated) */
+            if (index2 && psize2 != 0.) ncenter2 = sign2*(*index2)*psize2;
 
-                errorcode = cbf_find_column (handle, "detector_id");
+            else return CBF_ARGUMENT;
 
-                if (errorcode)
+        }
 
-                    errorcode = cbf_find_column (handle, "id");
-            }
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
+        cbf_failnez(cbf_get_beam_center(detector, &oindex1, &oindex2, &ocenter1, &ocenter2))
 
-                if (errorcode == CBF_NOTFOUND)
-                {
-                    errorcode = 0;
+        cbf_failnez(cbf_find_category(handle, "array_structure_list_axis"))
 
-                    break;
-                }
-            }
+        cbf_failnez(cbf_find_column(handle, "axis_id"))
 
-            if (!errorcode)
+        if ( nindex1 < oindex1-1.e-6 || nindex1 > oindex1+1.e-6 ) {
 
-                errorcode = cbf_get_value (handle, &this_id);
+            double olddisp;
 
-            if (!errorcode)
+            cbf_failnez(cbf_rewind_row(handle))
 
-                if (cbf_cistrcmp (id, this_id) == 0)
-                {
-                    errorcode = cbf_find_column (handle, "axis_id");
+            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis1].name))
 
-                    if (!errorcode)
+            cbf_failnez(cbf_require_column(handle, "reference_displacement"))
 
-                        errorcode = cbf_get_value (handle, &axis_id);
+            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
 
-                    if (!errorcode)
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
+
+                                            -(nindex1-oindex1)*detector->increment[1]  + detector->displacement[1]))
 
-                        errorcode = cbf_read_positioner_axis (handle, 0,
-                                                              positioner,
-                                                              axis_id, -1);
-                }
         }
 
+        cbf_failnez(cbf_find_column(handle, "axis_id"))
 
-        /* Add the surface axes */
+        if ( nindex2 < oindex2-1.e-6 || nindex2 > oindex2+1.e-6 ) {
 
-        if (!errorcode)
+            double olddisp;
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [0], 0);
+            cbf_failnez(cbf_rewind_row(handle))
 
-        if (!errorcode && surface_axis [1])
+            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis2].name))
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [1], 0);
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (positioner);
+            cbf_failnez(cbf_require_column(handle, "reference_displacement"))
+
+            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
+
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
+
+                                            -(nindex2-oindex2)*detector->increment[0]  + detector->displacement[0]))
 
-            return errorcode | cbf_free ((void **) detector, NULL);
         }
 
+        if (!cbf_find_category(handle,"diffrn_detector_element")
 
-        /* Complete the connectivity of the positioner */
+            && !cbf_find_column(handle,"id")
 
-        axis_index = 0;
+            && !cbf_find_row(handle,element_id)) {
 
-        do {
+            cbf_failnez(cbf_require_column(handle,"reference_center_slow"))
 
-            size_t index;
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex1*detector->increment[1]))
 
-            int found;
+            cbf_failnez(cbf_require_column(handle,"reference_center_fast"))
 
-            target_axis = positioner->axis[axis_index].depends_on;
+            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex2*detector->increment[0]))
 
-            rotation_axis = positioner->axis[axis_index].rotation_axis;
+            cbf_failnez(cbf_require_column(handle,"reference_center_units"))
 
-            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+            cbf_failnez(cbf_set_value(handle, "mm"))
 
-                found = 0;
+        }
 
-                for (index = 0; index < positioner->axes; index++) {
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
-        {
+        return 0;
 
-                        positioner->axis[axis_index].depends_on_index = index;
+    }
 
-                        found = 1;
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
 
+    /* Get the detector distance: shortest distance to the plane */
 
-                        break;
+    int cbf_get_detector_distance (cbf_detector detector, double *distance)
+    {
+        double normal [3], pixel00 [3];
 
-        }
+        cbf_failnez (cbf_get_detector_normal (detector, &normal [0],
+                                              &normal [1],
+                                              &normal [2]))
 
-                }
+        cbf_failnez (cbf_get_pixel_coordinates (detector, 0, 0,
+                                                &pixel00 [0],
+                                                &pixel00 [1],
+                                                &pixel00 [2]))
 
-                if (!found) {
+        if (distance)
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          target_axis, 2);
+            *distance = fabs (normal [0] * pixel00 [0] +
+                              normal [1] * pixel00 [1] +
+                              normal [2] * pixel00 [2]);
 
-                    positioner->axis[axis_index].depends_on_index
-                    = positioner->axes-1;
+        return 0;
+    }
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
 
+    /* Get the detector normal */
 
-                    if (!errorcode) break;
+    int cbf_get_detector_normal (cbf_detector detector, double *normal1,
+                                 double *normal2,
+                                 double *normal3)
+    {
+        cbf_failnez (cbf_get_pixel_normal (detector, 0, 0, normal1,
+                                           normal2,
+                                           normal3))
 
-                }
+        return 0;
+    }
 
-            }
 
-            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+    /* Calculate the coordinates of a pixel */
 
-                found = 0;
+    int cbf_get_pixel_coordinates (cbf_detector detector, double index1,
+                                   double index2,
+                                   double *coordinate1,
+                                   double *coordinate2,
+                                   double *coordinate3)
+    {
+        cbf_failnez (cbf_update_pixel (detector, index1, index2))
 
-                for (index = 0; index < positioner->axes; index++) {
+        cbf_failnez (cbf_calculate_position (detector->positioner,
+                                             0, 0, 0, 0, 0,
+                                             coordinate1,
+                                             coordinate2,
+                                             coordinate3))
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
-                    {
+        return 0;
+    }
 
-                        positioner->axis[axis_index].rotation_axis_index = index;
+    /* Get the names of the detector surface axes */
 
-                        found = 1;
+    int cbf_get_detector_surface_axes(cbf_detector detector,
+                                 const char * * axis_id1,
+                                 const char * * axis_id2)
+    {
+        unsigned int row;
+
+        if ( !detector || !(detector->positioner)) return CBF_ARGUMENT;
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
+        if (axis_id1) {
 
+            row = detector->index[0];
 
-                        break;
+            if (row < detector->positioner->axes) {
 
-                    }
+                *axis_id1 = (detector->positioner->axis[row]).name;
 
-                }
+            } else {
 
-                if (!found) {
+                *axis_id1 = ".";
+            }
 
+        }
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          rotation_axis, 2);
 
-                    positioner->axis[axis_index].rotation_axis_index
-                    = positioner->axes-1;
+        if (axis_id2) {
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
+            row = detector->index[1];
 
+            if (row < detector->positioner->axes) {
 
-                    if (!errorcode) break;
+                *axis_id2 = (detector->positioner->axis[row]).name;
 
-                }
+            } else {
 
+                *axis_id2 = ".";
             }
 
-            axis_index++;
+        }
 
-        } while (axis_index < positioner->axes);
+        return CBF_SUCCESS;
 
+    }
 
-        /* Insert the cbf handle and element into the dectector */
 
-        (*detector)->handle = handle;
+    /* Calcluate the slow axis of a detector */
 
-        (*detector)->element = element_number;
+    int cbf_get_detector_axis_slow (cbf_detector detector,
+                                    double *slowaxis1,
+                                    double *slowaxis2,
+                                    double *slowaxis3)
+    {
+        double pixel00[3], pixel10[3], length;
 
+        cbf_failnez (cbf_get_pixel_coordinates (detector, - 0.5,
+                                                - 0.5,
+                                                &pixel00 [0],
+                                                &pixel00 [1],
+                                                &pixel00 [2]))
 
-        /* Copy the start and increment values into the surface axes */
+        cbf_failnez (cbf_get_pixel_coordinates (detector, 0.5,
+                                                - 0.5,
+                                                &pixel10 [0],
+                                                &pixel10 [1],
+                                                &pixel10 [2]))
 
-        (*detector)->displacement [0] = displacement [0];
-        (*detector)->displacement [1] = displacement [1];
+        pixel10 [0] -= pixel00 [0];
+        pixel10 [1] -= pixel00 [1];
+        pixel10 [2] -= pixel00 [2];
 
-        (*detector)->increment [0] = increment [0];
-        (*detector)->increment [1] = increment [1];
+        length =  pixel10 [0]* pixel10 [0] +
+        pixel10 [1]* pixel10 [1] +
+        pixel10 [2]* pixel10 [2];
 
-        if (surface_axis [1])
+        if (length <= 0.0)
 
-            (*detector)->axes = 2;
+            return CBF_UNDEFINED;
 
-        else
+        length = sqrt (length);
 
-            (*detector)->axes = 1;
+        if (slowaxis1)
 
-        for (axis = 0; axis < (*detector)->axes; axis++)
+            *slowaxis1 = pixel10 [0] / length;
 
-            for (row = 0; row < positioner->axes; row++)
+        if (slowaxis2)
 
-                if (cbf_cistrcmp (positioner->axis [row].name,
-                                  surface_axis [axis]) == 0)
-                {
-                    (*detector)->index [axis] = row;
+            *slowaxis2 = pixel10 [1] / length;
 
-                    positioner->axis [row].increment = 0;
+        if (slowaxis3)
 
-                    break;
-                }
+            *slowaxis3 = pixel10 [2] / length;
 
-        (*detector)->positioner = positioner;
 
         return 0;
     }
 
+    /* Calcluate the fast axis of a detector */
 
-    /* Construct a reference detector positioner,
-     creating the necessary categories, and columns */
-
-    int cbf_require_reference_detector (cbf_handle    handle, cbf_detector      *detector,
-                                        unsigned int      element_number)
+    int cbf_get_detector_axis_fast (cbf_detector detector,
+                                    double *fastaxis1,
+                                    double *fastaxis2,
+                                    double *fastaxis3)
     {
-        int errorcode, precedence;
+        double pixel00[3], pixel01[3], length;
 
-        unsigned int row, axis;
+        cbf_failnez (cbf_get_pixel_coordinates (detector, -0.5,
+                                                -0.5,
+                                                &pixel00 [0],
+                                                &pixel00 [1],
+                                                &pixel00 [2]))
 
-        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
-        
-        const char *array_section_id;
+        cbf_failnez (cbf_get_pixel_coordinates (detector, -0.5,
+                                                0.5,
+                                                &pixel01 [0],
+                                                &pixel01 [1],
+                                                &pixel01 [2]))
 
-        const char *surface_axis [2];
+        pixel01 [0] -= pixel00 [0];
+        pixel01 [1] -= pixel00 [1];
+        pixel01 [2] -= pixel00 [2];
 
-        double displacement [2], increment [2];
+        length =  pixel01 [0]* pixel01 [0] +
+        pixel01 [1]* pixel01 [1] +
+        pixel01 [2]* pixel01 [2];
 
-        cbf_positioner positioner;
+        if (length <= 0.0)
 
-        if (!detector)
+            return CBF_UNDEFINED;
 
-            return CBF_ARGUMENT;
+        length = sqrt (length);
 
+        if (fastaxis1)
 
-        /* Get the detector id */
+            *fastaxis1 = pixel01 [0] / length;
 
-        cbf_failnez (cbf_require_diffrn_id (handle, &diffrn_id, "DIFFRN_ID"))
+        if (fastaxis2)
 
-        cbf_failnez (cbf_require_category (handle, "diffrn_detector"))
-        cbf_failnez (cbf_require_column   (handle, "diffrn_id"))
-        if (cbf_find_row (handle, diffrn_id))  {
-            cbf_failnez(cbf_new_row(handle))
-            cbf_failnez(cbf_set_value(handle,diffrn_id))
-        }
-        cbf_failnez (cbf_require_column   (handle, "id"))
-        cbf_failnez (cbf_require_value    (handle, &id, diffrn_id))
+            *fastaxis2 = pixel01 [1] / length;
 
+        if (fastaxis3)
 
-        /* Construct the detector surface */
+            *fastaxis3 = pixel01 [2] / length;
 
-        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id))
-        cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
-        cbf_failnez (cbf_require_category (handle, "array_structure_list"))
-        if (cbf_find_column(handle,"array_section_id")) {
-            if (cbf_find_column(handle,"array_id")) {
-                cbf_failnez (cbf_find_column   (handle, "array_section"));
-            }
-        }
 
-        surface_axis [0] = surface_axis [1] = NULL;
+        return 0;
+    }
 
+    /* Calcluate the axes of a detector */
 
-        while (cbf_find_nextrow (handle, array_section_id) == 0)
-        {
-            cbf_failnez (cbf_find_column      (handle, "precedence"))
-            cbf_failnez (cbf_get_integervalue (handle, &precedence))
+    int cbf_get_detector_axes (cbf_detector detector,
+                               double *slowaxis1,
+                               double *slowaxis2,
+                               double *slowaxis3,
+                               double *fastaxis1,
+                               double *fastaxis2,
+                               double *fastaxis3)
+    {
 
-            if (precedence < 1 || precedence > 2)
+        cbf_failnez (cbf_get_detector_axis_slow (detector, slowaxis1, slowaxis2, slowaxis3) )
 
-                return CBF_FORMAT;
+        cbf_failnez (cbf_get_detector_axis_fast (detector, fastaxis1, fastaxis2, fastaxis3) )
 
-            if (surface_axis [precedence - 1])
+        return 0;
+    }
 
-                return CBF_FORMAT;
 
-            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
-            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
-            if (cbf_find_column(handle,"array_section_id")) {
-                if (cbf_find_column(handle,"array_id")) {
-                    cbf_failnez (cbf_find_column   (handle, "array_section"));
-                }
-            }
-        }
+    /* Get the pixel normal */
 
-        if (!surface_axis[0]) {
-            cbf_failnez (cbf_require_column  (handle, "array_id"))
-            cbf_failnez (cbf_new_row         (handle))
-            cbf_failnez (cbf_set_value       (handle, array_id))
-            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
-            cbf_failnez (cbf_set_value       (handle, array_section_id))
-            cbf_failnez (cbf_require_column  (handle, "precedence"))
-            cbf_failnez (cbf_set_integervalue(handle,1))
-            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
-            cbf_failnez (cbf_require_value   (handle, &surface_axis [0], "ELEMENT_X"))
-        }
-        if (!surface_axis[1]){
-            cbf_failnez (cbf_require_column  (handle,"array_id"))
-            cbf_failnez (cbf_new_row         (handle))
-            cbf_failnez (cbf_set_value       (handle, array_id))
-            cbf_failnez (cbf_require_column  (handle, "array_section_id"))
-            cbf_failnez (cbf_set_value       (handle, array_section_id))
-            cbf_failnez (cbf_require_column  (handle, "precedence"))
-            cbf_failnez (cbf_set_integervalue(handle,2))
-            cbf_failnez (cbf_require_column  (handle, "axis_set_id"))
-            cbf_failnez (cbf_require_value   (handle, &surface_axis [1], "ELEMENT_Y"))
+    int cbf_get_pixel_normal (cbf_detector detector, double  index1,
+                              double  index2,
+                              double *normal1,
+                              double *normal2,
+                              double *normal3)
+    {
+        double pixel00 [3], pixel01 [3], pixel10 [3], normal [3], length;
 
-        }
+        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
+                                                index2 - 0.5,
+                                                &pixel00 [0],
+                                                &pixel00 [1],
+                                                &pixel00 [2]))
 
-        if (!surface_axis [0])
+        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
+                                                index2 + 0.5,
+                                                &pixel01 [0],
+                                                &pixel01 [1],
+                                                &pixel01 [2]))
 
-            return CBF_FORMAT;
+        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 + 0.5,
+                                                index2 - 0.5,
+                                                &pixel10 [0],
+                                                &pixel10 [1],
+                                                &pixel10 [2]))
 
-        cbf_failnez (cbf_require_category   (handle, "array_structure_list_axis"))
-        cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
-        cbf_failnez (cbf_require_row        (handle, surface_axis [0]))
-        cbf_failnez (cbf_require_column     (handle, "axis_id"))
-        cbf_failnez (cbf_require_value      (handle, &surface_axis [0], surface_axis[0]))
-        if (!cbf_find_column(handle, "reference_displacement") ||
-            !cbf_require_column     (handle, "displacement")){
-            cbf_failnez (cbf_require_doublevalue(handle, &displacement [0], 0.0))
-        }
-        else return CBF_NOTFOUND;
-        cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
-        cbf_failnez (cbf_require_doublevalue(handle, &(increment [0]), 0.0))
+        pixel01 [0] -= pixel00 [0];
+        pixel01 [1] -= pixel00 [1];
+        pixel01 [2] -= pixel00 [2];
+
+        pixel10 [0] -= pixel00 [0];
+        pixel10 [1] -= pixel00 [1];
+        pixel10 [2] -= pixel00 [2];
+
+        normal [0] = pixel01 [1] * pixel10 [2] - pixel10 [1] * pixel01 [2];
+        normal [1] = pixel01 [2] * pixel10 [0] - pixel10 [2] * pixel01 [0];
+        normal [2] = pixel01 [0] * pixel10 [1] - pixel10 [0] * pixel01 [1];
 
-        if (surface_axis [1])
-        {
-            cbf_failnez (cbf_require_column     (handle, "axis_set_id"))
-            cbf_failnez (cbf_require_row        (handle, surface_axis [1]))
-            cbf_failnez (cbf_require_column     (handle, "axis_id"))
-            cbf_failnez (cbf_require_value      (handle, &surface_axis [1], surface_axis[1]))
-            if (!cbf_find_column(handle, "reference_displacement") ||
-                !cbf_require_column     (handle, "displacement")){
-                cbf_failnez (cbf_require_doublevalue(handle, &displacement [1], 0.0))
-            }
-            else return CBF_NOTFOUND;
-            cbf_failnez (cbf_require_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_require_doublevalue(handle, &(increment [1]), 0.0))
-        }
+        length = normal [0] * normal [0] +
+        normal [1] * normal [1] +
+        normal [2] * normal [2];
 
+        if (length <= 0.0)
 
-        /* Construct the positioner */
+            return CBF_UNDEFINED;
 
-        cbf_failnez (cbf_make_positioner (&positioner))
+        length = sqrt (length);
 
-        errorcode = cbf_alloc ((void **) detector, NULL,
-                               sizeof (cbf_detector_struct), 1);
+        if (normal1)
 
-        for (row = errorcode = 0; !errorcode; row++)
-        {
-            errorcode = cbf_require_category (handle, "diffrn_detector_axis");
+            *normal1 = normal [0] / length;
 
-            if (!errorcode)
-            {
-                /* allow for aliases  _diffrn_detector_axis.detector_id
-                 _diffrn_detector_axis.id  (deprecated) */
+        if (normal2)
 
-                errorcode = cbf_find_column (handle, "detector_id");
+            *normal2 = normal [1] / length;
 
-                if (errorcode)
+        if (normal3)
 
-                    errorcode = cbf_find_column (handle, "id");
+            *normal3 = normal [2] / length;
 
-                if (errorcode)
+        return 0;
+    }
 
-                    errorcode = cbf_require_column (handle, "detector_id");
 
-            }
+    /* Calcluate the area of a pixel */
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
+    int cbf_get_pixel_area (cbf_detector detector, double index1,
+                            double index2,
+                            double *area,
+                            double *projected_area)
+    {
+        double pixel00 [3], pixel01 [3], pixel10 [3], normal [3];
 
-                if (errorcode == CBF_NOTFOUND)
-                {
-                    errorcode = 0;
+        double length, length00;
 
-                    break;
-                }
-            }
+        if (!detector)
 
-            if (!errorcode)
+            return CBF_ARGUMENT;
 
-                errorcode = cbf_get_value (handle, &this_id);
+        if (detector->axes < 2)
 
-            if (!errorcode)
+            return CBF_NOTIMPLEMENTED;
 
-                if (cbf_cistrcmp (id, this_id) == 0)
-                {
-                    errorcode = cbf_find_column (handle, "axis_id");
+        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
+                                                index2 - 0.5,
+                                                &pixel00 [0],
+                                                &pixel00 [1],
+                                                &pixel00 [2]))
 
-                    if (!errorcode)
+        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
+                                                index2 + 0.5,
+                                                &pixel01 [0],
+                                                &pixel01 [1],
+                                                &pixel01 [2]))
 
-                        errorcode = cbf_get_value (handle, &axis_id);
+        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 + 0.5,
+                                                index2 - 0.5,
+                                                &pixel10 [0],
+                                                &pixel10 [1],
+                                                &pixel10 [2]))
 
-                    if (!errorcode)
+        pixel01 [0] -= pixel00 [0];
+        pixel01 [1] -= pixel00 [1];
+        pixel01 [2] -= pixel00 [2];
 
-                        errorcode = cbf_read_positioner_axis (handle, 0,
-                                                              positioner,
-                                                              axis_id, -1);
-                }
-        }
+        pixel10 [0] -= pixel00 [0];
+        pixel10 [1] -= pixel00 [1];
+        pixel10 [2] -= pixel00 [2];
 
+        normal [0] = pixel01 [1] * pixel10 [2] - pixel10 [1] * pixel01 [2];
+        normal [1] = pixel01 [2] * pixel10 [0] - pixel10 [2] * pixel01 [0];
+        normal [2] = pixel01 [0] * pixel10 [1] - pixel10 [0] * pixel01 [1];
 
-        /* Add the surface axes */
+        length = normal [0] * normal [0] +
+        normal [1] * normal [1] +
+        normal [2] * normal [2];
 
-        if (!errorcode)
+        if (length <= 0.0)
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [0], 0);
+            return CBF_UNDEFINED;
 
-        if (!errorcode && surface_axis [1])
+        length = sqrt (length);
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [1], 0);
+        if (area)
 
-        if (errorcode)
+            *area = length;
+
+        if (projected_area)
         {
-            errorcode |= cbf_free_positioner (positioner);
+            length00 = pixel00 [0] * pixel00 [0] +
+            pixel00 [1] * pixel00 [1] +
+            pixel00 [2] * pixel00 [2];
 
-            return errorcode | cbf_free ((void **) detector, NULL);
+            if (length00 <= 0.0)
+
+                return CBF_UNDEFINED;
+
+            length00 = sqrt (length00);
+
+            *projected_area = fabs (pixel00 [0] * normal [0] +
+                                    pixel00 [1] * normal [1] +
+                                    pixel00 [2] * normal [2]) / length00;
         }
 
-        /* Insert the cbf handle and element into the dectector */
+        return 0;
+    }
 
-        (*detector)->handle = handle;
+    /* Take a copy of the settings the pixel frame of a detector depends
+       on.  The starts of the surface axes are left out, since every
+       pixel lookup moves them. */
 
-        (*detector)->element = element_number;
+    static int cbf_get_frame_settings (cbf_detector detector, double **settings,
+                                       size_t *nsettings)
+    {
+        cbf_positioner positioner;
 
+        size_t i, k;
 
+        double *setting;
 
-        /* Copy the start and increment values into the surface axes */
+        positioner = detector->positioner;
 
-        (*detector)->displacement [0] = displacement [0];
-        (*detector)->displacement [1] = displacement [1];
+        *nsettings = 9 * positioner->axes + 4;
 
-        (*detector)->increment [0] = increment [0];
-        (*detector)->increment [1] = increment [1];
+        cbf_failnez (cbf_alloc ((void **) settings, NULL,
+                                sizeof (double), *nsettings))
 
-        if (surface_axis [1])
+        setting = *settings;
 
-            (*detector)->axes = 2;
+        for (i = 0; i < positioner->axes; i++)
+        {
+            cbf_axis_struct *axis = positioner->axis + i;
 
-        else
+            if (i == detector->index [0] ||
+                (detector->axes == 2 && i == detector->index [1]))
 
-            (*detector)->axes = 1;
+                *setting++ = 0.;
 
-        for (axis = 0; axis < (*detector)->axes; axis++)
+            else
 
-            for (row = 0; row < positioner->axes; row++)
+                *setting++ = axis->start;
 
-                if (cbf_cistrcmp (positioner->axis [row].name,
-                                  surface_axis [axis]) == 0)
-                {
-                    (*detector)->index [axis] = row;
+            *setting++ = axis->increment;
 
-                    positioner->axis [row].increment = 0;
+            for (k = 0; k < 3; k++)
 
-                    break;
-                }
+                *setting++ = axis->vector [k];
 
-        (*detector)->positioner = positioner;
+            for (k = 0; k < 3; k++)
+
+                *setting++ = axis->offset [k];
+
+            *setting++ = axis->rotation;
+        }
+
+        *setting++ = detector->displacement [0];
+        *setting++ = detector->displacement [1];
+        *setting++ = detector->increment [0];
+        *setting   = detector->increment [1];
 
         return 0;
     }
 
 
-    /* Free a detector */
+    /* Find the lab coordinates of pixel (0, 0) and the steps to the next
+       pixel along the slow and fast axes, unless no axis setting has
+       changed since they were last found */
 
-    int cbf_free_detector (cbf_detector detector)
+    static int cbf_get_pixel_frame (cbf_detector detector)
     {
-        int errorcode = 0;
-
-        void * memblock;
-
-        memblock = (void *)detector;
+        double *settings, frame [3][3];
 
-        if (detector)
+        size_t nsettings;
 
-            errorcode = cbf_free_positioner (detector->positioner);
+        int errorcode, i;
 
-        return errorcode | cbf_free (&memblock, NULL);
-    }
+        if (!detector || !detector->positioner)
 
+            return CBF_ARGUMENT;
 
-    /* Update the pixel settings */
+        settings = NULL;
 
-    static int cbf_update_pixel (cbf_detector detector, double index1,
-                          double index2)
-    {
-        if (!detector)
+        cbf_failnez (cbf_get_frame_settings (detector, &settings, &nsettings))
 
-            return CBF_ARGUMENT;
+        if (detector->pixel_frame_is_valid &&
+            nsettings == detector->frame_nsettings &&
+            !memcmp (settings, detector->frame_settings, nsettings * sizeof (double)))
 
-        detector->positioner->axis [detector->index [0]].start =
-        index2 * detector->increment [0] + detector->displacement [0];
+            return cbf_free ((void **) &settings, NULL);
 
-        if (detector->axes == 2)
+        errorcode = cbf_get_pixel_coordinates (detector, 0, 0, &frame [0][0],
+                                               &frame [0][1],
+                                               &frame [0][2]);
 
-            detector->positioner->axis [detector->index [1]].start =
-            index1 * detector->increment [1] + detector->displacement [1];
+        if (!errorcode)
 
-        return 0;
-    }
+            errorcode = cbf_get_pixel_coordinates (detector, 1, 0, &frame [1][0],
+                                                   &frame [1][1],
+                                                   &frame [1][2]);
 
+        if (!errorcode)
 
-    /* Get the beam center */
+            errorcode = cbf_get_pixel_coordinates (detector, 0, 1, &frame [2][0],
+                                                   &frame [2][1],
+                                                   &frame [2][2]);
 
-    int cbf_get_beam_center (cbf_detector detector, double *index1,
-                             double *index2,
-                             double *center1,
-                             double *center2)
-    {
-        double pixel00 [3], pixel01 [3], pixel10 [3], m [2][2], det, index [2];
+        if (errorcode)
+        {
+            cbf_free ((void **) &settings, NULL);
 
-        if (!detector)
+            return errorcode;
+        }
 
-            return CBF_ARGUMENT;
+        for (i = 0; i < 3; i++)
+        {
+            frame [1][i] -= frame [0][i];
 
-        if (detector->axes < 2)
+            frame [2][i] -= frame [0][i];
+        }
 
-            return CBF_NOTIMPLEMENTED;
+        memcpy (detector->pixel_frame, frame, sizeof (frame));
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, 0, 0,
-                                                &pixel00 [0],
-                                                &pixel00 [1],
-                                                &pixel00 [2]))
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, 0, 1,
-                                                &pixel01 [0],
-                                                &pixel01 [1],
-                                                &pixel01 [2]))
+            /* Translations along the surface axes move a pixel linearly
+               with its indices; anything else has to be taken pixel by
+               pixel */
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, 1, 0,
-                                                &pixel10 [0],
-                                                &pixel10 [1],
-                                                &pixel10 [2]))
+        detector->pixel_frame_is_affine =
+            detector->positioner->axis [detector->index [0]].type == CBF_TRANSLATION_AXIS &&
+            (detector->axes < 2 ||
+             detector->positioner->axis [detector->index [1]].type == CBF_TRANSLATION_AXIS);
 
-        m [0][0] = pixel10 [0] - pixel00 [0];
-        m [0][1] = pixel01 [0] - pixel00 [0];
-        m [1][0] = pixel10 [1] - pixel00 [1];
-        m [1][1] = pixel01 [1] - pixel00 [1];
+        cbf_free ((void **) &detector->frame_settings, NULL);
 
-        det = m [0][0] * m [1][1] - m [1][0] * m [0][1];
+        detector->frame_settings = settings;
 
-        if (det == 0.0)
+        detector->frame_nsettings = nsettings;
 
-            return CBF_UNDEFINED;
+        detector->pixel_frame_is_valid = 1;
 
-        index [0] = (-m [1][1] * pixel00 [0] + m [0][1] * pixel00 [1]) / det;
-        index [1] =  (m [1][0] * pixel00 [0] - m [0][0] * pixel00 [1]) / det;
+        return 0;
+    }
 
-        if (index1)
 
-            *index1 = index [0];
+    /* Store the geometry of the pixel at lab coordinates x, y, z */
 
-        if (index2)
+    static void cbf_set_pixel_geometry (size_t index, double x, double y, double z,
+                                        const double normal [3], double area,
+                                        double *coordinates,
+                                        double *normals,
+                                        double *solid_angles,
+                                        double *two_theta,
+                                        double *azimuth)
+    {
+        const double degrees = 45. / atan2 (1., 1.);
 
-            *index2 = index [1];
+        double r2, r;
 
-        if (center1)
+        r2 = x * x + y * y + z * z;
 
-            *center1 = index [0] * detector->increment [0];
+        r = sqrt (r2);
 
-        if (center2)
+        if (coordinates)
+        {
+            coordinates [3 * index]     = x;
+            coordinates [3 * index + 1] = y;
+            coordinates [3 * index + 2] = z;
+        }
 
-            *center2 = index [1] * detector->increment [1];
+        if (normals)
+        {
+            normals [3 * index]     = normal [0];
+            normals [3 * index + 1] = normal [1];
+            normals [3 * index + 2] = normal [2];
+        }
 
-        return 0;
+        if (solid_angles)
 
-        /*  a * delta01 + b * delta10 + pixel00 = (0 0 ?)
+            solid_angles [index] = r2 > 0.0 ?
+                area * fabs (x * normal [0] + y * normal [1] + z * normal [2]) / (r2 * r) : 0.0;
 
-         a * delta01[0] + b * delta10[0] + pixel00[0] = 0
-         a * delta01[1] + b * delta10[1] + pixel00[1] = 0
+        if (two_theta)
 
-         (d01[0] d10[0]) (a) = -(p00[0])
-         (d01[1] d10[1]) (b)    (p00[1])
+            two_theta [index] = atan2 (sqrt (x * x + y * y), -z) * degrees;
 
-         (a) = -(d01[0] d10[0])-1 (p00[0])
-         (b)    (d01[1] d10[1])   (p00[1]) */
+        if (azimuth)
+
+            azimuth [index] = atan2 (y, x) * degrees;
     }
 
 
-    /* Set the beam center */
+    /* Calculate the geometry of every pixel of a detector element */
 
-    int cbf_set_beam_center (cbf_detector detector, double *index1,
-                             double *index2,
-                             double *center1,
-                             double *center2)
+    int cbf_get_pixel_geometry (cbf_detector detector, size_t dimfast,
+                                size_t dimslow,
+                                double *coordinates,
+                                double *normals,
+                                double *solid_angles,
+                                double *two_theta,
+                                double *azimuth)
     {
-        double oindex1, oindex2, ocenter1, ocenter2;
+        double normal [3], area, (*frame) [3];
 
-        double nindex1, nindex2, ncenter1, ncenter2;
+        size_t fast;
 
-        double psize1, psize2;
+        long slow;
 
-        unsigned int naxis1, naxis2;
+        cbf_failnez (cbf_get_pixel_frame (detector))
 
-        int sign1, sign2;
+        if ((normals || solid_angles) && detector->axes < 2)
 
-        cbf_handle handle;
+            return CBF_NOTIMPLEMENTED;
 
-        unsigned int element;
+        normal [0] = normal [1] = normal [2] = area = 0.0;
 
-        const char *element_id;
+        if (!detector->pixel_frame_is_affine)
+        {
+            for (slow = 0; slow < (long) dimslow; slow++)
 
-        CBF_UNUSED( ncenter1 );
+                for (fast = 0; fast < dimfast; fast++)
+                {
+                    double pixel [3];
 
-        CBF_UNUSED( ncenter2 );
+                    cbf_failnez (cbf_get_pixel_coordinates (detector, slow, fast,
+                                                            &pixel [0],
+                                                            &pixel [1],
+                                                            &pixel [2]))
 
-        if (!detector)
+                    if (normals || solid_angles)
+                    {
+                        cbf_failnez (cbf_get_pixel_normal (detector, slow, fast,
+                                                           &normal [0],
+                                                           &normal [1],
+                                                           &normal [2]))
 
-            return CBF_ARGUMENT;
+                        cbf_failnez (cbf_get_pixel_area (detector, slow, fast,
+                                                         &area, NULL))
+                    }
 
-        if (detector->axes < 2)
+                    cbf_set_pixel_geometry (slow * dimfast + fast,
+                                            pixel [0], pixel [1], pixel [2],
+                                            normal, area, coordinates, normals,
+                                            solid_angles, two_theta, azimuth);
+                }
 
-            return CBF_NOTIMPLEMENTED;
+            return 0;
+        }
 
-        handle = detector->handle;
 
-        element = detector->element;
+            /* A flat element has the same normal and area everywhere */
 
-        cbf_failnez(cbf_get_element_id(handle,element, &element_id))
+        frame = detector->pixel_frame;
 
-        naxis1 = detector->index[1];
+        if (normals || solid_angles)
+        {
+            normal [0] = frame [2][1] * frame [1][2] - frame [1][1] * frame [2][2];
+            normal [1] = frame [2][2] * frame [1][0] - frame [1][2] * frame [2][0];
+            normal [2] = frame [2][0] * frame [1][1] - frame [1][0] * frame [2][1];
 
-        naxis2 = detector->index[0];
+            area = sqrt (normal [0] * normal [0] +
+                         normal [1] * normal [1] +
+                         normal [2] * normal [2]);
 
-        sign1 = detector->increment[1]>0.0?1.0:-1.0;
+            if (area <= 0.0)
 
-        sign2 = detector->increment[0]>0.0?1.0:-1.0;
+                return CBF_UNDEFINED;
 
-        psize1 = detector->increment[1];
+            normal [0] /= area;
+            normal [1] /= area;
+            normal [2] /= area;
+        }
 
-        if (psize1 < 0.) psize1 = -psize1;
+#ifdef _OPENMP
+#pragma omp parallel for private(fast) if(dimslow > 1)
+#endif
+        for (slow = 0; slow < (long) dimslow; slow++)
+        {
+            double x, y, z;
 
-        psize2 = detector->increment[0];
+            x = frame [0][0] + slow * frame [1][0];
+            y = frame [0][1] + slow * frame [1][1];
+            z = frame [0][2] + slow * frame [1][2];
 
-        if (psize1 < 0.) psize2 = -psize2;
+            for (fast = 0; fast < dimfast; fast++)
 
-        if (index1) {
+                cbf_set_pixel_geometry (slow * dimfast + fast,
+                                        x + fast * frame [2][0],
+                                        y + fast * frame [2][1],
+                                        z + fast * frame [2][2],
+                                        normal, area, coordinates, normals,
+                                        solid_angles, two_theta, azimuth);
+        }
 
-            nindex1 = *index1;
+        return 0;
+    }
 
-        } else {
 
-            if (center1 && psize1 != 0.) nindex1 = sign1*(*center1)/psize1;
+    /* The polarization factor of the pixel at lab coordinates x, y, z, for
+       fractions inplane and normal of the beam polarized along e1 and e2 */
 
-            else return CBF_ARGUMENT;
+    static double cbf_pixel_polarization (double x, double y, double z,
+                                          const double e1 [2], const double e2 [2],
+                                          double inplane, double normal)
+    {
+        double r2, d1, d2;
 
-        }
+        r2 = x * x + y * y + z * z;
 
-        if (index2) {
+        if (r2 <= 0.0)
 
-            nindex2 = *index2;
+            return 1.0;
 
-        } else {
+        d1 = x * e1 [0] + y * e1 [1];
 
-            if (center2 && psize2 != 0.) nindex2 = sign2*(*center2)/psize2;
+        d2 = x * e2 [0] + y * e2 [1];
 
-            else return CBF_ARGUMENT;
+        return inplane * (1.0 - d1 * d1 / r2) + normal * (1.0 - d2 * d2 / r2);
+    }
 
-        }
 
-        if (center1) {
+    /* Calculate the polarization factor of every pixel of a detector
+       element: the fraction of the scattered intensity left, for a beam
+       along -Z whose polarizn_source_norm is measured from the Y axis */
 
-            ncenter1 = *center1;
+    int cbf_get_pixel_polarization (cbf_detector detector, size_t dimfast,
+                                    size_t dimslow,
+                                    double polarizn_source_ratio,
+                                    double polarizn_source_norm,
+                                    double *factors)
+    {
+        double e1 [2], e2 [2], norm, inplane, normal, (*frame) [3];
 
-        } else {
+        size_t fast;
 
-            if (index1 && psize1 != 0.) ncenter1 = sign1*(*index1)*psize1;
+        long slow;
 
-            else return CBF_ARGUMENT;
+        if (!factors)
 
-        }
+            return CBF_ARGUMENT;
 
-        if (center2) {
+        cbf_failnez (cbf_get_pixel_frame (detector))
 
-            ncenter2 = *center2;
+        norm = polarizn_source_norm * atan2 (1., 1.) / 45.;
 
-        } else {
+        e1 [0] = cos (norm);
+        e1 [1] = sin (norm);
+        e2 [0] = -e1 [1];
+        e2 [1] = e1 [0];
 
-            if (index2 && psize2 != 0.) ncenter2 = sign2*(*index2)*psize2;
+        inplane = 0.5 * (1.0 + polarizn_source_ratio);
 
-            else return CBF_ARGUMENT;
+        normal = 0.5 * (1.0 - polarizn_source_ratio);
 
-        }
+        if (!detector->pixel_frame_is_affine)
+        {
+            for (slow = 0; slow < (long) dimslow; slow++)
 
+                for (fast = 0; fast < dimfast; fast++)
+                {
+                    double pixel [3];
 
-        cbf_failnez(cbf_get_beam_center(detector, &oindex1, &oindex2, &ocenter1, &ocenter2))
+                    cbf_failnez (cbf_get_pixel_coordinates (detector, slow, fast,
+                                                            &pixel [0],
+                                                            &pixel [1],
+                                                            &pixel [2]))
 
-        cbf_failnez(cbf_find_category(handle, "array_structure_list_axis"))
+                    factors [slow * dimfast + fast] =
+                        cbf_pixel_polarization (pixel [0], pixel [1], pixel [2],
+                                                e1, e2, inplane, normal);
+                }
 
-        cbf_failnez(cbf_find_column(handle, "axis_id"))
+            return 0;
+        }
 
-        if ( nindex1 < oindex1-1.e-6 || nindex1 > oindex1+1.e-6 ) {
+        frame = detector->pixel_frame;
 
-            double olddisp;
+#ifdef _OPENMP
+#pragma omp parallel for private(fast) if(dimslow > 1)
+#endif
+        for (slow = 0; slow < (long) dimslow; slow++)
+        {
+            double x, y, z;
 
-            cbf_failnez(cbf_rewind_row(handle))
+            x = frame [0][0] + slow * frame [1][0];
+            y = frame [0][1] + slow * frame [1][1];
+            z = frame [0][2] + slow * frame [1][2];
 
-            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis1].name))
+            for (fast = 0; fast < dimfast; fast++)
 
-            cbf_failnez(cbf_require_column(handle, "displacement"))
+                factors [slow * dimfast + fast] =
+                    cbf_pixel_polarization (x + fast * frame [2][0],
+                                            y + fast * frame [2][1],
+                                            z + fast * frame [2][2],
+                                            e1, e2, inplane, normal);
+        }
 
-            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
+        return 0;
+    }
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
 
-                                            -(nindex1-oindex1)*detector->increment[1]  + detector->displacement[1]))
+    /* Project the pixel at lab coordinates x, y, z onto the Ewald sphere */
 
-        }
+    static int cbf_pixel_reciprocal (double x, double y, double z, double wavelength,
+                                     double *reciprocal)
+    {
+        double length;
 
-        cbf_failnez(cbf_find_column(handle, "axis_id"))
+        length = x * x + y * y + z * z;
 
-        if ( nindex2 < oindex2-1.e-6 || nindex2 > oindex2+1.e-6 ) {
+        if (length <= 0.0)
 
-            double olddisp;
+            return CBF_ARGUMENT;
 
-            cbf_failnez(cbf_rewind_row(handle))
+        length = sqrt (length) * wavelength;
 
-            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis2].name))
+        reciprocal [0] = x / length;
+        reciprocal [1] = y / length;
+        reciprocal [2] = z / length + 1 / wavelength;
 
-            cbf_failnez(cbf_require_column(handle, "displacement"))
+        return 0;
+    }
 
-            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
+    /* Calculate the lab-frame reciprocal-space vector of every pixel of a
+       detector element */
 
-                                            -(nindex2-oindex2)*detector->increment[0]  + detector->displacement[0]))
+    int cbf_get_pixel_reciprocal (cbf_detector detector, double wavelength,
+                                  size_t dimfast,
+                                  size_t dimslow,
+                                  double *reciprocal)
+    {
+        double (*frame) [3];
 
-        }
+        size_t fast;
 
-        if (!cbf_find_category(handle,"diffrn_data_frame")
+        long slow;
 
-            && !cbf_find_column(handle,"detector_element_id")
+        int errorcode;
 
-            && !cbf_find_row(handle,element_id)) {
+        if (wavelength <= 0.0 || !reciprocal)
 
-            cbf_failnez(cbf_require_column(handle,"center_slow"))
+            return CBF_ARGUMENT;
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex1*detector->increment[1]))
+        cbf_failnez (cbf_get_pixel_frame (detector))
 
-            cbf_failnez(cbf_require_column(handle,"center_fast"))
+        if (!detector->pixel_frame_is_affine)
+        {
+            for (slow = 0; slow < (long) dimslow; slow++)
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex2*detector->increment[0]))
+                for (fast = 0; fast < dimfast; fast++)
+                {
+                    double pixel [3];
 
-            cbf_failnez(cbf_require_column(handle,"center_units"))
+                    cbf_failnez (cbf_get_pixel_coordinates (detector, slow, fast,
+                                                            &pixel [0],
+                                                            &pixel [1],
+                                                            &pixel [2]))
 
-            cbf_failnez(cbf_set_value(handle, "mm"))
+                    cbf_failnez (cbf_pixel_reciprocal (pixel [0], pixel [1], pixel [2],
+                                                       wavelength,
+                                                       reciprocal + 3 * (slow * dimfast + fast)))
+                }
 
+            return 0;
         }
 
+        frame = detector->pixel_frame;
 
-        return 0;
+        errorcode = 0;
 
-    }
+#ifdef _OPENMP
+#pragma omp parallel for private(fast) reduction(|:errorcode) if(dimslow > 1)
+#endif
+        for (slow = 0; slow < (long) dimslow; slow++)
+        {
+            double x, y, z;
 
-    /* Set the reference beam center */
+            x = frame [0][0] + slow * frame [1][0];
+            y = frame [0][1] + slow * frame [1][1];
+            z = frame [0][2] + slow * frame [1][2];
 
-    int cbf_set_reference_beam_center (cbf_detector detector, double *index1,
-                                       double *index2,
-                                       double *center1,
-                                       double *center2)
-    {
-        double oindex1, oindex2, ocenter1, ocenter2;
+            for (fast = 0; fast < dimfast; fast++)
 
-        double nindex1, nindex2, ncenter1, ncenter2;
+                errorcode |= cbf_pixel_reciprocal (x + fast * frame [2][0],
+                                                   y + fast * frame [2][1],
+                                                   z + fast * frame [2][2],
+                                                   wavelength,
+                                                   reciprocal + 3 * (slow * dimfast + fast));
+        }
 
-        double psize1, psize2;
+        return errorcode;
+    }
 
-        unsigned int naxis1, naxis2;
 
-        int sign1, sign2;
+    /* Calculate the reciprocal-space coordinates of every pixel of a frame */
 
-        cbf_handle handle;
+    int cbf_get_frame_reciprocal (cbf_goniometer goniometer,
+                                  cbf_detector   detector,
+                                  double         ratio,
+                                  double         wavelength,
+                                  size_t         dimfast,
+                                  size_t         dimslow,
+                                  double        *reciprocal)
+    {
+        cbf_failnez (cbf_get_pixel_reciprocal (detector, wavelength,
+                                               dimfast, dimslow, reciprocal))
 
-        unsigned int element;
+        return cbf_get_reciprocal_array (goniometer, 0, ratio, dimfast * dimslow,
+                                         reciprocal, reciprocal);
+    }
 
-        const char *element_id;
 
-        CBF_UNUSED( ncenter1 );
+    /* Calcluate the size of a pixel from the detector element axis displacements */
 
-        CBF_UNUSED( ncenter2 );
+    int cbf_get_inferred_pixel_size (cbf_detector detector,
+                                     int axis_number,
+                                     double *psize)
+    {
 
-        if (!detector)
+        if (axis_number < 0) axis_number = detector->axes+1+axis_number;
+
+        if (!detector || axis_number < 1 || (ssize_t)(detector-> axes) < axis_number )
 
             return CBF_ARGUMENT;
 
-        if (detector->axes < 2)
 
-            return CBF_NOTIMPLEMENTED;
+        *psize = fabs( (detector-> increment)[axis_number-1] );
 
-        handle = detector->handle;
+        return 0;
 
-        element = detector->element;
+    }
 
-        cbf_failnez(cbf_get_element_id(handle,element, &element_id))
+    /* Get the unit cell parameters */
 
-        naxis1 = detector->index[1];
+    int cbf_get_unit_cell (cbf_handle handle, double cell[6], double cell_esd[6])
+    {
+        cbf_failnez(cbf_find_category    (handle, "cell"))
+        cbf_failnez(cbf_rewind_row       (handle))
 
-        naxis2 = detector->index[0];
+        if (cell) {
 
-        sign1 = detector->increment[1]>0.0?1.0:-1.0;
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "length_a",    &(cell[0]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "length_b",    &(cell[1]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "length_c",    &(cell[2]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "angle_alpha", &(cell[3]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "angle_beta",  &(cell[4]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "angle_gamma", &(cell[5]),0.))
 
-        sign2 = detector->increment[0]>0.0?1.0:-1.0;
+        }
 
-        psize1 = detector->increment[1];
+        if (cell_esd) {
 
-        if (psize1 < 0.) psize1 = -psize1;
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "length_a_esd",    &(cell_esd[0]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "length_b_esd",    &(cell_esd[1]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "length_c_esd",    &(cell_esd[2]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "angle_alpha_esd", &(cell_esd[3]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "angle_beta_esd",  &(cell_esd[4]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "angle_gamma_esd", &(cell_esd[5]),0.))
 
-        psize2 = detector->increment[0];
+        }
 
-        if (psize1 < 0.) psize2 = -psize2;
 
-        if (index1) {
+        return 0;
 
-            nindex1 = *index1;
+    }
 
-        } else {
+    /* Set the unit cell parameters */
 
-            if (center1 && psize1 != 0.) nindex1 = sign1*(*center1)/psize1;
+    int cbf_set_unit_cell (cbf_handle handle, double cell[6], double cell_esd[6])
+    {
+        const char * diffrn_id;
+        const char * entry_id;
 
-            else return CBF_ARGUMENT;
 
-        }
+        if (!(cbf_get_diffrn_id    (handle, &diffrn_id))) diffrn_id = NULL;
 
-        if (index2) {
+        cbf_failnez(cbf_require_category (handle, "cell"))
+        cbf_failnez(cbf_rewind_row       (handle))
 
-            nindex2 = *index2;
+        cbf_failnez(cbf_require_column   (handle, "entry_id"))
 
-        } else {
+        entry_id = NULL;
+        if (diffrn_id && (cbf_get_value(handle, &entry_id) ||
+                          !entry_id || *entry_id == '\0')) {
+            cbf_failnez(cbf_set_value      (handle, diffrn_id))
+        }
 
-            if (center2 && psize2 != 0.) nindex2 = sign2*(*center2)/psize2;
+        if (cell) {
 
-            else return CBF_ARGUMENT;
+            cbf_failnez (cbf_require_column  (handle, "length_a"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[0]))
+            cbf_failnez (cbf_require_column  (handle, "length_b"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[1]))
+            cbf_failnez (cbf_require_column  (handle, "length_c"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[2]))
+            cbf_failnez (cbf_require_column  (handle, "angle_alpha"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[3]))
+            cbf_failnez (cbf_require_column  (handle, "angle_beta"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[4]))
+            cbf_failnez (cbf_require_column  (handle, "angle_gamma"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[5]))
 
         }
 
-        if (center1) {
-
-            ncenter1 = *center1;
-
-        } else {
-
-            if (index1 && psize1 != 0.) ncenter1 = sign1*(*index1)*psize1;
+        if (cell_esd) {
 
-            else return CBF_ARGUMENT;
+            cbf_failnez (cbf_require_column  (handle, "length_a_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[0]))
+            cbf_failnez (cbf_require_column  (handle, "length_b_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[1]))
+            cbf_failnez (cbf_require_column  (handle, "length_c_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[2]))
+            cbf_failnez (cbf_require_column  (handle, "angle_alpha_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[3]))
+            cbf_failnez (cbf_require_column  (handle, "angle_beta_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[4]))
+            cbf_failnez (cbf_require_column  (handle, "angle_gamma_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[5]))
 
         }
 
-        if (center2) {
+        return 0;
 
-            ncenter2 = *center2;
+    }
 
-        } else {
+    /* Get the reciprocal cell parameters */
 
-            if (index2 && psize2 != 0.) ncenter2 = sign2*(*index2)*psize2;
+    int cbf_get_reciprocal_cell (cbf_handle handle, double cell[6], double cell_esd[6])
+    {
 
-            else return CBF_ARGUMENT;
+        cbf_failnez(cbf_find_category     (handle, "cell"))
+        cbf_failnez(cbf_rewind_row        (handle))
 
-        }
+        if (cell) {
 
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_length_a",    &(cell[0]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_length_b",    &(cell[1]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_length_c",    &(cell[2]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_angle_alpha", &(cell[3]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_angle_beta",  &(cell[4]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_angle_gamma", &(cell[5]),0.))
 
-        cbf_failnez(cbf_get_beam_center(detector, &oindex1, &oindex2, &ocenter1, &ocenter2))
+        }
 
-        cbf_failnez(cbf_find_category(handle, "array_structure_list_axis"))
+        if (cell_esd) {
 
-        cbf_failnez(cbf_find_column(handle, "axis_id"))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_length_a_esd",    &(cell_esd[0]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_length_b_esd",    &(cell_esd[1]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_length_c_esd",    &(cell_esd[2]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_angle_alpha_esd", &(cell_esd[3]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_angle_beta_esd",  &(cell_esd[4]),0.))
+            cbf_failnez (cbf_require_column_doublevalue (handle,
+                                                         "reciprocal_angle_gamma_esd", &(cell_esd[5]),0.))
+        }
 
-        if ( nindex1 < oindex1-1.e-6 || nindex1 > oindex1+1.e-6 ) {
 
-            double olddisp;
+        return 0;
 
-            cbf_failnez(cbf_rewind_row(handle))
+    }
 
-            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis1].name))
+    /* Set the reciprocal cell parameters */
 
-            cbf_failnez(cbf_require_column(handle, "reference_displacement"))
+    int cbf_set_reciprocal_cell (cbf_handle handle, double cell[6], double cell_esd[6])
+    {
+        const char * diffrn_id;
+        const char * entry_id;
 
-            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
+        if (!(cbf_get_diffrn_id    (handle, &diffrn_id))) diffrn_id = NULL;
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
+        cbf_failnez(cbf_require_category (handle, "cell"))
+        cbf_failnez(cbf_rewind_row       (handle))
 
-                                            -(nindex1-oindex1)*detector->increment[1]  + detector->displacement[1]))
+        cbf_failnez(cbf_require_column   (handle, "entry_id"))
 
+        entry_id = NULL;
+        if (diffrn_id && (cbf_get_value(handle, &entry_id) ||
+                          !entry_id || *entry_id == '\0')) {
+            cbf_failnez(cbf_set_value      (handle, diffrn_id))
         }
 
-        cbf_failnez(cbf_find_column(handle, "axis_id"))
-
-        if ( nindex2 < oindex2-1.e-6 || nindex2 > oindex2+1.e-6 ) {
-
-            double olddisp;
-
-            cbf_failnez(cbf_rewind_row(handle))
-
-            cbf_failnez(cbf_find_row(handle,detector->positioner->axis[naxis2].name))
+        if (cell) {
 
-            cbf_failnez(cbf_require_column(handle, "reference_displacement"))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_a"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[0]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_b"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[1]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_c"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[2]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_alpha"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[3]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_beta"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[4]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_gamma"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[5]))
 
-            cbf_failnez(cbf_require_doublevalue(handle,&olddisp,0.0))
+        }
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",
+        if (cell_esd) {
 
-                                            -(nindex2-oindex2)*detector->increment[0]  + detector->displacement[0]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_a_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[0]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_b_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[1]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_c_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[2]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_alpha_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[3]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_beta_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[4]))
+            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_gamma_esd"))
+            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[5]))
 
         }
 
-        if (!cbf_find_category(handle,"diffrn_detector_element")
-
-            && !cbf_find_column(handle,"id")
+        return 0;
 
-            && !cbf_find_row(handle,element_id)) {
+    }
 
-            cbf_failnez(cbf_require_column(handle,"reference_center_slow"))
+    /* Compute a cell volume */
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex1*detector->increment[1]))
+    int cbf_compute_cell_volume (double cell[6], double *volume) {
 
-            cbf_failnez(cbf_require_column(handle,"reference_center_fast"))
+        double degtorad;
 
-            cbf_failnez(cbf_set_doublevalue(handle, "%-f",  nindex2*detector->increment[0]))
+        degtorad = atan2(1.,1.)/45.;
 
-            cbf_failnez(cbf_require_column(handle,"reference_center_units"))
+        *volume =  cell[0]*cell[1]*cell[2]*
+        sqrt(1.
+             - cos(cell[3]*degtorad)*cos(cell[3]*degtorad)
+             - cos(cell[4]*degtorad)*cos(cell[4]*degtorad)
+             - cos(cell[5]*degtorad)*cos(cell[5]*degtorad)
+             + 2.*cos(cell[3]*degtorad)*cos(cell[4]*degtorad)*cos(cell[5]*degtorad));
+        return 0;
 
-            cbf_failnez(cbf_set_value(handle, "mm"))
+    }
 
-        }
+    /* Compute a reciprocal cell */
 
+    int cbf_compute_reciprocal_cell (double cell[6], double rcell[6]){
 
-        return 0;
+        double volume, degtorad, radtodeg;
+#define acos_deg(x) (atan2(sqrt(1.-(x)*(x)),(x))*radtodeg)
 
-    }
+        cbf_compute_cell_volume (cell, &volume);
 
+        degtorad = atan2(1.,1.)/45.;
+        radtodeg = 1./degtorad;
 
+        if (volume <= 0. ) return CBF_ARGUMENT;
 
-    /* Get the detector distance: shortest distance to the plane */
+        rcell[0] = cell[1]*cell[2]*sin(cell[3]*degtorad)/volume;
 
-    int cbf_get_detector_distance (cbf_detector detector, double *distance)
-    {
-        double normal [3], pixel00 [3];
+        rcell[1] = cell[2]*cell[0]*sin(cell[4]*degtorad)/volume;
 
-        cbf_failnez (cbf_get_detector_normal (detector, &normal [0],
-                                              &normal [1],
-                                              &normal [2]))
+        rcell[2] = cell[0]*cell[1]*sin(cell[5]*degtorad)/volume;
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, 0, 0,
-                                                &pixel00 [0],
-                                                &pixel00 [1],
-                                                &pixel00 [2]))
+        rcell[3] = acos_deg((cos(cell[4]*degtorad)*cos(cell[5]*degtorad) - cos(cell[3]*degtorad))/(sin(cell[4]*degtorad)*sin(cell[5]*degtorad)));
 
-        if (distance)
+        rcell[4] = acos_deg((cos(cell[5]*degtorad)*cos(cell[3]*degtorad) - cos(cell[4]*degtorad))/(sin(cell[5]*degtorad)*sin(cell[3]*degtorad)));
 
-            *distance = fabs (normal [0] * pixel00 [0] +
-                              normal [1] * pixel00 [1] +
-                              normal [2] * pixel00 [2]);
+        rcell[5] = acos_deg((cos(cell[3]*degtorad)*cos(cell[4]*degtorad) - cos(cell[5]*degtorad))/(sin(cell[3]*degtorad)*sin(cell[4]*degtorad)));
 
         return 0;
-    }
 
+    }
 
-    /* Get the detector normal */
+    /* Get the orientation matrix entry */
 
-    int cbf_get_detector_normal (cbf_detector detector, double *normal1,
-                                 double *normal2,
-                                 double *normal3)
+    int cbf_get_orientation_matrix (cbf_handle handle, double ub_matrix[9])
     {
-        cbf_failnez (cbf_get_pixel_normal (detector, 0, 0, normal1,
-                                           normal2,
-                                           normal3))
-
-        return 0;
-    }
 
+        cbf_failnez(cbf_find_category    (handle, "diffrn_orient_matrix"));
+        cbf_failnez(cbf_rewind_row       (handle));
 
-    /* Calculate the coordinates of a pixel */
+        if (ub_matrix) {
 
-    int cbf_get_pixel_coordinates (cbf_detector detector, double index1,
-                                   double index2,
-                                   double *coordinate1,
-                                   double *coordinate2,
-                                   double *coordinate3)
-    {
-        cbf_failnez (cbf_update_pixel (detector, index1, index2))
+            cbf_failnez (cbf_find_column   (handle, "UB[1][1]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[0])));
+            cbf_failnez (cbf_find_column   (handle, "UB[1][2]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[1])));
+            cbf_failnez (cbf_find_column   (handle, "UB[1][3]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[2])));
+            cbf_failnez (cbf_find_column   (handle, "UB[2][1]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[3])));
+            cbf_failnez (cbf_find_column   (handle, "UB[2][2]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[4])));
+            cbf_failnez (cbf_find_column   (handle, "UB[2][3]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[5])));
+            cbf_failnez (cbf_find_column   (handle, "UB[3][1]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[6])));
+            cbf_failnez (cbf_find_column   (handle, "UB[3][2]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[7])));
+            cbf_failnez (cbf_find_column   (handle, "UB[3][3]"));
+            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[8])));
 
-        cbf_failnez (cbf_calculate_position (detector->positioner,
-                                             0, 0, 0, 0, 0,
-                                             coordinate1,
-                                             coordinate2,
-                                             coordinate3))
+        }
 
         return 0;
+
     }
 
-    /* Get the names of the detector surface axes */
+    /* Set the orientation matrix entry */
 
-    int cbf_get_detector_surface_axes(cbf_detector detector,
-                                 const char * * axis_id1,
-                                 const char * * axis_id2)
+    int cbf_set_orientation_matrix (cbf_handle handle, double ub_matrix[9])
     {
-        unsigned int row;
+        const char * diffrn_id;
+        const char * UBdiffrn_id;
 
-        if ( !detector || !(detector->positioner)) return CBF_ARGUMENT;
+        cbf_failnez(cbf_get_diffrn_id    (handle, &diffrn_id))
 
-        if (axis_id1) {
+        cbf_failnez(cbf_require_category (handle, "diffrn_orient_matrix"))
+        cbf_failnez(cbf_rewind_row       (handle))
 
-            row = detector->index[0];
+        cbf_failnez(cbf_require_column   (handle, "diffrn_id"))
 
-            if (row < detector->positioner->axes) {
+        UBdiffrn_id = 0;
+        if (cbf_get_value(handle, &UBdiffrn_id) ||
+            !UBdiffrn_id || *UBdiffrn_id == '\0') {
+            cbf_failnez(cbf_set_value      (handle, diffrn_id))
+        }
 
-                *axis_id1 = (detector->positioner->axis[row]).name;
 
-            } else {
+        if (ub_matrix) {
 
-                *axis_id1 = ".";
-            }
+            cbf_failnez (cbf_require_column   (handle, "UB[1][1]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[0]));
+            cbf_failnez (cbf_require_column   (handle, "UB[1][2]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[1]));
+            cbf_failnez (cbf_require_column   (handle, "UB[1][3]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[2]));
+            cbf_failnez (cbf_require_column   (handle, "UB[2][1]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[3]));
+            cbf_failnez (cbf_require_column   (handle, "UB[2][2]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[4]));
+            cbf_failnez (cbf_require_column   (handle, "UB[2][3]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[5]));
+            cbf_failnez (cbf_require_column   (handle, "UB[3][1]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[6]));
+            cbf_failnez (cbf_require_column   (handle, "UB[3][2]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[7]));
+            cbf_failnez (cbf_require_column   (handle, "UB[3][3]"));
+            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[8]));
 
         }
 
+        return 0;
 
-        if (axis_id2) {
-
-            row = detector->index[1];
-
-            if (row < detector->positioner->axes) {
+    }
 
-                *axis_id2 = (detector->positioner->axis[row]).name;
 
-            } else {
+    /* get the axis upon which an axis depends */
 
-                *axis_id2 = ".";
-            }
+    int cbf_get_parent_axis(cbf_handle handle,
+                            const char * *parent_axis,
+                            const char *axis_id) {
 
-        }
+        cbf_failnez (cbf_find_category    (handle, "axis"))
+        cbf_failnez (cbf_find_column      (handle, "id"))
+        cbf_failnez (cbf_find_row         (handle, axis_id))
+        cbf_failnez (cbf_find_column      (handle, "depends_on"))
+        cbf_failnez (cbf_get_value        (handle, parent_axis))
 
-        return CBF_SUCCESS;
+        return 0;
 
     }
 
 
-    /* Calcluate the slow axis of a detector */
+    /* get the reference axis vector and offset of a given axis */
 
-    int cbf_get_detector_axis_slow (cbf_detector detector,
-                                    double *slowaxis1,
-                                    double *slowaxis2,
-                                    double *slowaxis3)
+    int cbf_get_axis_reference_poise(cbf_handle handle,
+                                     double *vector1, double *vector2, double *vector3,
+                                     double *offset1, double *offset2, double *offset3,
+                                     const char *axis_id)
     {
-        double pixel00[3], pixel10[3], length;
-
-        cbf_failnez (cbf_get_pixel_coordinates (detector, - 0.5,
-                                                - 0.5,
-                                                &pixel00 [0],
-                                                &pixel00 [1],
-                                                &pixel00 [2]))
-
-        cbf_failnez (cbf_get_pixel_coordinates (detector, 0.5,
-                                                - 0.5,
-                                                &pixel10 [0],
-                                                &pixel10 [1],
-                                                &pixel10 [2]))
-
-        pixel10 [0] -= pixel00 [0];
-        pixel10 [1] -= pixel00 [1];
-        pixel10 [2] -= pixel00 [2];
+        cbf_failnez (cbf_get_axis_vector  (handle, axis_id,
+                                           vector1,
+                                           vector2,
+                                           vector3))
+        cbf_failnez (cbf_get_axis_offset  (handle, axis_id,
+                                           offset1,
+                                           offset2,
+                                           offset3))
 
-        length =  pixel10 [0]* pixel10 [0] +
-        pixel10 [1]* pixel10 [1] +
-        pixel10 [2]* pixel10 [2];
+        return 0;
+    }
 
-        if (length <= 0.0)
+    /* get the absolute axis vector and offset of a given axis
+     ratio is how far into a frame we are, 0. at the start
+     of the frame, 1. at the end
 
-            return CBF_UNDEFINED;
+     The three offset values are the absolute position to which
+     the origin has been moved */
 
-        length = sqrt (length);
+    int cbf_get_axis_poise(cbf_handle handle, double ratio,
+                           double *vector1, double *vector2, double *vector3,
+                           double *offset1, double *offset2, double *offset3,
+                           double *angle,
+                           const char *axis_id,
+                           const char *frame_id)
+    {
+        cbf_positioner positioner;
 
-        if (slowaxis1)
+        const char *parent_axis;
 
-            *slowaxis1 = pixel10 [0] / length;
+        double refvector1, refvector2, refvector3;
 
-        if (slowaxis2)
+        double refoffset1, refoffset2, refoffset3;
 
-            *slowaxis2 = pixel10 [1] / length;
+        double start, increment;
 
-        if (slowaxis3)
+        cbf_get_axis_reference_poise(handle,
+                                     &refvector1, &refvector2, &refvector3,
+                                     &refoffset1, &refoffset2, &refoffset3,
+                                     axis_id);
 
-            *slowaxis3 = pixel10 [2] / length;
+        if (angle) {
 
+            cbf_failnez(cbf_get_frame_axis_setting(handle,0,
+                                    axis_id, frame_id, &start, &increment));
 
-        return 0;
-    }
+            *angle = ratio*increment;
 
-    /* Calcluate the fast axis of a detector */
+        }
 
-    int cbf_get_detector_axis_fast (cbf_detector detector,
-                                    double *fastaxis1,
-                                    double *fastaxis2,
-                                    double *fastaxis3)
-    {
-        double pixel00[3], pixel01[3], length;
+        cbf_failnez(cbf_get_parent_axis(handle,&parent_axis,axis_id));
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, -0.5,
-                                                -0.5,
-                                                &pixel00 [0],
-                                                &pixel00 [1],
-                                                &pixel00 [2]))
+        /* fprintf(stderr," axis_id %s parent %s\n",axis_id,parent_axis); */
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, -0.5,
-                                                0.5,
-                                                &pixel01 [0],
-                                                &pixel01 [1],
-                                                &pixel01 [2]))
+        /* If this axis is not dependent, just return the reference poise */
 
-        pixel01 [0] -= pixel00 [0];
-        pixel01 [1] -= pixel00 [1];
-        pixel01 [2] -= pixel00 [2];
+        if (!parent_axis || cbf_cistrcmp(".",parent_axis) == 0) {
 
-        length =  pixel01 [0]* pixel01 [0] +
-        pixel01 [1]* pixel01 [1] +
-        pixel01 [2]* pixel01 [2];
 
-        if (length <= 0.0)
+            if (vector1) *vector1 = refvector1;
+            if (vector2) *vector2 = refvector2;
+            if (vector3) *vector3 = refvector3;
 
-            return CBF_UNDEFINED;
+            if (offset1) *offset1 = refoffset1;
+            if (offset2) *offset2 = refoffset2;
+            if (offset3) *offset3 = refoffset3;
 
-        length = sqrt (length);
+            return 0;
 
-        if (fastaxis1)
+        }
 
-            *fastaxis1 = pixel01 [0] / length;
+        cbf_failnez(cbf_construct_frame_positioner(handle, &positioner, parent_axis, frame_id))
 
-        if (fastaxis2)
 
-            *fastaxis2 = pixel01 [1] / length;
+        cbf_failnez(cbf_calculate_position(positioner,0,ratio,
+                                      refoffset1, refoffset2, refoffset3,
+                                      offset1,offset2,offset3))
 
-        if (fastaxis3)
+        cbf_failnez(cbf_rotate_vector(positioner,0,ratio,
+                                      refvector1, refvector2, refvector3,
+                                      vector1,vector2,vector3))
 
-            *fastaxis3 = pixel01 [2] / length;
+                return cbf_free_positioner(positioner);
 
 
-        return 0;
     }
 
-    /* Calcluate the axes of a detector */
+    /* Get the positioner matrix
 
-    int cbf_get_detector_axes (cbf_detector detector,
-                               double *slowaxis1,
-                               double *slowaxis2,
-                               double *slowaxis3,
-                               double *fastaxis1,
-                               double *fastaxis2,
-                               double *fastaxis3)
-    {
+     The position matrix return is a 3x4 matrix of doubles.  The upper left 3x3
+     is the rotation, the upper right 3x1 is the (post-) translation*/
 
-        cbf_failnez (cbf_get_detector_axis_slow (detector, slowaxis1, slowaxis2, slowaxis3) )
 
-        cbf_failnez (cbf_get_detector_axis_fast (detector, fastaxis1, fastaxis2, fastaxis3) )
+    int cbf_get_positioner_matrix (cbf_positioner positioner, double ratio, double matrix[3][4]) {
 
-        return 0;
-    }
+        size_t i, j;
 
+        double setting;
 
-    /* Get the pixel normal */
+        if (!positioner)
 
-    int cbf_get_pixel_normal (cbf_detector detector, double  index1,
-                              double  index2,
-                              double *normal1,
-                              double *normal2,
-                              double *normal3)
-    {
-        double pixel00 [3], pixel01 [3], pixel10 [3], normal [3], length;
+            return CBF_ARGUMENT;
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
-                                                index2 - 0.5,
-                                                &pixel00 [0],
-                                                &pixel00 [1],
-                                                &pixel00 [2]))
+        for (i = 0; i < positioner->axes; i++)
+        {
+            setting = positioner->axis [i].start + ratio *
+            positioner->axis [i].increment;
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
-                                                index2 + 0.5,
-                                                &pixel01 [0],
-                                                &pixel01 [1],
-                                                &pixel01 [2]))
+            if (positioner->axis [i].setting != setting)
+            {
+                positioner->matrix_is_valid = 0;
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 + 0.5,
-                                                index2 - 0.5,
-                                                &pixel10 [0],
-                                                &pixel10 [1],
-                                                &pixel10 [2]))
+                positioner->axis [i].setting = setting;
+            }
+        }
 
-        pixel01 [0] -= pixel00 [0];
-        pixel01 [1] -= pixel00 [1];
-        pixel01 [2] -= pixel00 [2];
+        if (!positioner->matrix_is_valid || positioner->matrix_ratio_used != ratio )
+        {
 
-        pixel10 [0] -= pixel00 [0];
-        pixel10 [1] -= pixel00 [1];
-        pixel10 [2] -= pixel00 [2];
 
-        normal [0] = pixel01 [1] * pixel10 [2] - pixel10 [1] * pixel01 [2];
-        normal [1] = pixel01 [2] * pixel10 [0] - pixel10 [2] * pixel01 [0];
-        normal [2] = pixel01 [0] * pixel10 [1] - pixel10 [0] * pixel01 [1];
+            positioner->matrix_ratio_used = ratio;
+
+            positioner->matrix [0][0] = 1;
+            positioner->matrix [0][1] = 0;
+            positioner->matrix [0][2] = 0;
+            positioner->matrix [0][3] = 0;
+            positioner->matrix [1][0] = 0;
+            positioner->matrix [1][1] = 1;
+            positioner->matrix [1][2] = 0;
+            positioner->matrix [1][3] = 0;
+            positioner->matrix [2][0] = 0;
+            positioner->matrix [2][1] = 0;
+            positioner->matrix [2][2] = 1;
+            positioner->matrix [2][3] = 0;
 
-        length = normal [0] * normal [0] +
-        normal [1] * normal [1] +
-        normal [2] * normal [2];
 
-        if (length <= 0.0)
+            for (i = 0; i < positioner->axes; i++)
+            {
+                setting = positioner->axis [i].setting;
 
-            return CBF_UNDEFINED;
+                if (positioner->axis [i].type == CBF_TRANSLATION_AXIS)
+                {
+                    positioner->matrix [0][3] += setting * positioner->axis [i].vector [0];
+                    positioner->matrix [1][3] += setting * positioner->axis [i].vector [1];
+                    positioner->matrix [2][3] += setting * positioner->axis [i].vector [2];
+                    /* fprintf(stderr," calculate position, axis %d, translate [%g, %g, %g]\n",
+                     i,
+                     setting * positioner->axis [i].vector [0],
+                     setting * positioner->axis [i].vector [1],
+                     setting * positioner->axis [i].vector [2]);
+                     */
 
-        length = sqrt (length);
+                }
+                else
+                {
+                    double s, x, y, z, w,
+                    xx, yy, zz, xy, xz, xw, yz, yw, zw;
 
-        if (normal1)
+                    double rotation [3][3], product [3][4];
 
-            *normal1 = normal [0] / length;
+                    int r1, c1r2, c2;
 
-        if (normal2)
+                    s = sin (setting * 0.00872664625997164788461845384244);
 
-            *normal2 = normal [1] / length;
+                    x = positioner->axis [i].vector [0] * s;
+                    y = positioner->axis [i].vector [1] * s;
+                    z = positioner->axis [i].vector [2] * s;
 
-        if (normal3)
+                    w = cos (setting * 0.00872664625997164788461845384244);
 
-            *normal3 = normal [2] / length;
+                    xx = x * x;
+                    yy = y * y;
+                    zz = z * z;
+                    xy = x * y;
+                    xz = x * z;
+                    xw = x * w;
+                    yz = y * z;
+                    yw = y * w;
+                    zw = z * w;
 
-        return 0;
-    }
+                    rotation [0][0] = 1 - 2 * (yy + zz);
+                    rotation [0][1] =     2 * (xy - zw);
+                    rotation [0][2] =     2 * (xz + yw);
+                    rotation [1][0] =     2 * (xy + zw);
+                    rotation [1][1] = 1 - 2 * (xx + zz);
+                    rotation [1][2] =     2 * (yz - xw);
+                    rotation [2][0] =     2 * (xz - yw);
+                    rotation [2][1] =     2 * (yz + xw);
+                    rotation [2][2] = 1 - 2 * (xx + yy);
 
+                    /* fprintf(stderr," calculate position, axis %d, rotate [%g + i*%g + j*%g + k*%g]\n",
+                     i, w, x, y, z);
+                     */
 
-    /* Calcluate the area of a pixel */
+                    for (r1 = 0; r1 < 3; r1++)
 
-    int cbf_get_pixel_area (cbf_detector detector, double index1,
-                            double index2,
-                            double *area,
-                            double *projected_area)
-    {
-        double pixel00 [3], pixel01 [3], pixel10 [3], normal [3];
+                        for (c2 = 0; c2 < 4; c2++)
+                        {
+                            product [r1][c2] = 0;
 
-        double length, length00;
+                            for (c1r2 = 0; c1r2 < 3; c1r2++)
 
-        if (!detector)
+                                product [r1][c2] += rotation [r1][c1r2] *
+                                positioner->matrix [c1r2][c2];
+                        }
 
-            return CBF_ARGUMENT;
+                    for (r1 = 0; r1 < 3; r1++)
 
-        if (detector->axes < 2)
+                        for (c2 = 0; c2 < 4; c2++)
 
-            return CBF_NOTIMPLEMENTED;
+                            positioner->matrix [r1][c2] = product [r1][c2];
+                }
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
-                                                index2 - 0.5,
-                                                &pixel00 [0],
-                                                &pixel00 [1],
-                                                &pixel00 [2]))
+                positioner->matrix [0][3] += positioner->axis [i].offset [0];
+                positioner->matrix [1][3] += positioner->axis [i].offset [1];
+                positioner->matrix [2][3] += positioner->axis [i].offset [2];
+            }
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 - 0.5,
-                                                index2 + 0.5,
-                                                &pixel01 [0],
-                                                &pixel01 [1],
-                                                &pixel01 [2]))
+            positioner->matrix_is_valid = 1;
+        }
 
-        cbf_failnez (cbf_get_pixel_coordinates (detector, index1 + 0.5,
-                                                index2 - 0.5,
-                                                &pixel10 [0],
-                                                &pixel10 [1],
-                                                &pixel10 [2]))
+        if (matrix) {
 
-        pixel01 [0] -= pixel00 [0];
-        pixel01 [1] -= pixel00 [1];
-        pixel01 [2] -= pixel00 [2];
+            for (i=0;i<3;i++) {
+                for (j=0;j<4;j++) {
+                    matrix[i][j]=positioner->matrix[i][j];
+                }
+            }
 
-        pixel10 [0] -= pixel00 [0];
-        pixel10 [1] -= pixel00 [1];
-        pixel10 [2] -= pixel00 [2];
+        }
 
-        normal [0] = pixel01 [1] * pixel10 [2] - pixel10 [1] * pixel01 [2];
-        normal [1] = pixel01 [2] * pixel10 [0] - pixel10 [2] * pixel01 [0];
-        normal [2] = pixel01 [0] * pixel10 [1] - pixel10 [0] * pixel01 [1];
+        return 0;
 
-        length = normal [0] * normal [0] +
-        normal [1] * normal [1] +
-        normal [2] * normal [2];
+    }
 
-        if (length <= 0.0)
+    /* Get goniometer poise -- returns the pre-offset, post-translation and angle */
 
-            return CBF_UNDEFINED;
+    int cbf_get_goniometer_poise(cbf_goniometer goniometer, double ratio,
+                                 double *vector1, double *vector2, double* vector3,
+                                 double *offset1, double *offset2, double* offset3,
+                                 double *angle) {
+        double matrix0[3][4];
 
-        length = sqrt (length);
+        double matrix1[3][4];
 
-        if (area)
+        double matrix[3][4];
 
-            *area = length;
+        double axis[3], alength;
 
-        if (projected_area)
-        {
-            length00 = pixel00 [0] * pixel00 [0] +
-            pixel00 [1] * pixel00 [1] +
-            pixel00 [2] * pixel00 [2];
+        double theta, costheta, sintheta;
 
-            if (length00 <= 0.0)
+        int i,j;
 
-                return CBF_UNDEFINED;
+        cbf_failnez(cbf_get_positioner_matrix(goniometer, 0., matrix0))
 
-            length00 = sqrt (length00);
+        cbf_failnez(cbf_get_positioner_matrix(goniometer, 1., matrix1))
 
-            *projected_area = fabs (pixel00 [0] * normal [0] +
-                                    pixel00 [1] * normal [1] +
-                                    pixel00 [2] * normal [2]) / length00;
-        }
+        /* compute matrix1*inverse(matrix2) forcing the offset to the
+           ratio weighted average of the two offsets */
 
-        return 0;
-    }
+        for (i=0; i < 3; i++) {
 
-    /* Calcluate the size of a pixel from the detector element axis displacements */
+            for (j=0; j < 3; j++) {
 
-    int cbf_get_inferred_pixel_size (cbf_detector detector,
-                                     int axis_number,
-                                     double *psize)
-    {
+                matrix[i][j] = matrix0[i][0]*matrix1[j][0]
+                + matrix0[i][1]*matrix1[j][1]
+                + matrix0[i][2]*matrix1[j][2];
 
-        if (axis_number < 0) axis_number = detector->axes+1+axis_number;
+            }
 
-        if (!detector || axis_number < 1 || (ssize_t)(detector-> axes) < axis_number )
+            matrix[i][3] = matrix0[i][3]*(1.-ratio)+matrix1[i][3]*ratio;
+        }
 
-            return CBF_ARGUMENT;
+        costheta = .5*(matrix[0][0]+matrix[1][1]+matrix[2][2]-1.);
 
+        if (costheta < -1.0000000000001 || costheta > 1.0000000000001) return CBF_ARGUMENT;
 
-        *psize = fabs( (detector-> increment)[axis_number-1] );
+        sintheta = sqrt(fabs(1.-costheta*costheta));
 
-        return 0;
+        theta = atan2(sintheta,costheta);
 
-    }
+        axis[0] = -(matrix[2][1]-matrix[1][2]);
 
-    /* Get the unit cell parameters */
+        axis[1] = -(matrix[0][2]-matrix[2][0]);
 
-    int cbf_get_unit_cell (cbf_handle handle, double cell[6], double cell_esd[6])
-    {
-        cbf_failnez(cbf_find_category    (handle, "cell"))
-        cbf_failnez(cbf_rewind_row       (handle))
+        axis[2] = -(matrix[1][0]-matrix[0][1]);
 
-        if (cell) {
+        alength = sqrt(axis[0]*axis[0]+axis[1]*axis[1]+axis[2]*axis[2]);
 
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "length_a",    &(cell[0]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "length_b",    &(cell[1]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "length_c",    &(cell[2]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "angle_alpha", &(cell[3]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "angle_beta",  &(cell[4]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "angle_gamma", &(cell[5]),0.))
+        if (alength > 1.e-10) {
 
-        }
+            axis[0] = axis[0]/alength;
 
-        if (cell_esd) {
+            axis[1] = axis[1]/alength;
 
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "length_a_esd",    &(cell_esd[0]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "length_b_esd",    &(cell_esd[1]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "length_c_esd",    &(cell_esd[2]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "angle_alpha_esd", &(cell_esd[3]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "angle_beta_esd",  &(cell_esd[4]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "angle_gamma_esd", &(cell_esd[5]),0.))
+            axis[2] = axis[2]/alength;
 
-        }
+        } else {
 
+            axis[0] = 1.;
 
-        return 0;
+            axis[1] = 0.;
 
-    }
+            axis[2] = 0.;
+        }
 
-    /* Set the unit cell parameters */
+        if (angle) *angle = ratio*theta*45./atan2(1.,1.);
 
-    int cbf_set_unit_cell (cbf_handle handle, double cell[6], double cell_esd[6])
-    {
-        const char * diffrn_id;
-        const char * entry_id;
+        if (vector1) *vector1 = axis[0];
 
+        if (vector2) *vector2 = axis[1];
 
-        if (!(cbf_get_diffrn_id    (handle, &diffrn_id))) diffrn_id = NULL;
+        if (vector3) *vector3 = axis[2];
 
-        cbf_failnez(cbf_require_category (handle, "cell"))
-        cbf_failnez(cbf_rewind_row       (handle))
+        if (offset1) {
 
-        cbf_failnez(cbf_require_column   (handle, "entry_id"))
+            *offset1 = matrix[0][0]*matrix[0][3]
+            + matrix[1][0]*matrix[1][3]
+            + matrix[2][0]*matrix[2][3];
 
-        entry_id = NULL;
-        if (diffrn_id && (cbf_get_value(handle, &entry_id) ||
-                          !entry_id || *entry_id == '\0')) {
-            cbf_failnez(cbf_set_value      (handle, diffrn_id))
         }
 
-        if (cell) {
+        if (offset2) {
 
-            cbf_failnez (cbf_require_column  (handle, "length_a"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[0]))
-            cbf_failnez (cbf_require_column  (handle, "length_b"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[1]))
-            cbf_failnez (cbf_require_column  (handle, "length_c"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[2]))
-            cbf_failnez (cbf_require_column  (handle, "angle_alpha"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[3]))
-            cbf_failnez (cbf_require_column  (handle, "angle_beta"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[4]))
-            cbf_failnez (cbf_require_column  (handle, "angle_gamma"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[5]))
+            *offset2 = matrix[0][1]*matrix[0][3]
+            + matrix[1][1]*matrix[1][3]
+            + matrix[2][1]*matrix[2][3];
 
         }
 
-        if (cell_esd) {
+        if (offset3) {
 
-            cbf_failnez (cbf_require_column  (handle, "length_a_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[0]))
-            cbf_failnez (cbf_require_column  (handle, "length_b_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[1]))
-            cbf_failnez (cbf_require_column  (handle, "length_c_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[2]))
-            cbf_failnez (cbf_require_column  (handle, "angle_alpha_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[3]))
-            cbf_failnez (cbf_require_column  (handle, "angle_beta_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[4]))
-            cbf_failnez (cbf_require_column  (handle, "angle_gamma_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[5]))
+            *offset3 = matrix[0][2]*matrix[0][3]
+            + matrix[1][2]*matrix[1][3]
+            + matrix[2][2]*matrix[2][3];
 
         }
 
@@ -9251,880 +10834,831 @@ extern "C" {
 
     }
 
-    /* Get the reciprocal cell parameters */
+    /* Get the setting of an axis specific to a given frame */
 
-    int cbf_get_reciprocal_cell (cbf_handle handle, double cell[6], double cell_esd[6])
+    int cbf_get_frame_axis_setting (cbf_handle handle, unsigned int  reserved,
+                                    const char   *axis_id,
+                                    const char   *frame_id,
+                                    double       *start,
+                                    double       *increment)
     {
+        cbf_axis_type type;
 
-        cbf_failnez(cbf_find_category     (handle, "cell"))
-        cbf_failnez(cbf_rewind_row        (handle))
+        if (reserved != 0 || !start || !increment )
 
-        if (cell) {
+            return CBF_ARGUMENT;
 
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_length_a",    &(cell[0]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_length_b",    &(cell[1]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_length_c",    &(cell[2]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_angle_alpha", &(cell[3]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_angle_beta",  &(cell[4]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_angle_gamma", &(cell[5]),0.))
 
-        }
+        /* Get the axis type */
 
-        if (cell_esd) {
+        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
 
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_length_a_esd",    &(cell_esd[0]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_length_b_esd",    &(cell_esd[1]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_length_c_esd",    &(cell_esd[2]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_angle_alpha_esd", &(cell_esd[3]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_angle_beta_esd",  &(cell_esd[4]),0.))
-            cbf_failnez (cbf_require_column_doublevalue (handle,
-                                                         "reciprocal_angle_gamma_esd", &(cell_esd[5]),0.))
-        }
+        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS && type != CBF_GENERAL_AXIS )
 
+            return CBF_FORMAT;
 
-        return 0;
+        /* For a general axis, the settings are always 0 */
 
-    }
+        if (type == CBF_GENERAL_AXIS ) {
 
-    /* Set the reciprocal cell parameters */
+            *start = 0.;
 
-    int cbf_set_reciprocal_cell (cbf_handle handle, double cell[6], double cell_esd[6])
-    {
-        const char * diffrn_id;
-        const char * entry_id;
+            *increment = 0.;
 
-        if (!(cbf_get_diffrn_id    (handle, &diffrn_id))) diffrn_id = NULL;
+        }
 
-        cbf_failnez(cbf_require_category (handle, "cell"))
-        cbf_failnez(cbf_rewind_row       (handle))
 
-        cbf_failnez(cbf_require_column   (handle, "entry_id"))
+        /* Read from the diffrn_scan_axis and
+         diffrn_scan_frame_axis categories */
 
-        entry_id = NULL;
-        if (diffrn_id && (cbf_get_value(handle, &entry_id) ||
-                          !entry_id || *entry_id == '\0')) {
-            cbf_failnez(cbf_set_value      (handle, diffrn_id))
-        }
+        else if (type == CBF_TRANSLATION_AXIS)
+        {
+            const char *test_axis_id;
 
-        if (cell) {
+            int foundincr, founddisp;
+            foundincr = 0;
+            founddisp = 0;
 
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_a"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[0]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_b"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[1]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_c"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[2]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_alpha"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[3]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_beta"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[4]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_gamma"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell[5]))
+            if (frame_id && cbf_cistrcmp(frame_id,".")!=0 ) {
+                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
+                    !cbf_find_column     (handle, "frame_id")){
+                    cbf_failnez (cbf_rewind_row      (handle))
+                    while (!cbf_find_nextrow(handle,frame_id)) {
+                        if(!cbf_find_column(handle,"axis_id") &&
+                           !cbf_get_value(handle,&test_axis_id) &&
+                           test_axis_id && *test_axis_id &&
+                           !cbf_cistrcmp(test_axis_id,axis_id)) {
+                            if (!cbf_find_column     (handle, "displacement") &&
+                                !cbf_get_doublevalue (handle, start)) founddisp = 1;
+                            if (!cbf_find_column     (handle, "displacement_increment") &&
+                                !cbf_get_doublevalue (handle, increment)) foundincr = 1;
+                            break;
+                        }
+                        cbf_failnez (cbf_find_column     (handle, "frame_id"))
+                    }
+                }
+            }
+            if ((!foundincr||!founddisp)&&frame_id && cbf_cistrcmp(frame_id,".")==0 ) {
+                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
+                    !cbf_find_column     (handle, "axis_id")){
+                    cbf_failnez (cbf_rewind_row      (handle))
+                    if (!cbf_find_nextrow(handle,axis_id)) {
+                        if (!founddisp&&!cbf_find_column(handle, "displacement") &&
+                            !cbf_get_doublevalue (handle, start)) founddisp = 1;
+                        if (!foundincr&&!cbf_find_column(handle, "displacement_increment") &&
+                            !cbf_get_doublevalue (handle, increment)) foundincr = 1;
+                    }
+                }
+            }
+            if (!foundincr || !founddisp) {
+                cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
+                cbf_failnez (cbf_find_column     (handle, "axis_id"))
+                cbf_failnez (cbf_find_row        (handle, axis_id))
+                if (!founddisp) {
+                    cbf_failnez (cbf_find_column     (handle, "displacement"))
+                    cbf_failnez (cbf_get_doublevalue (handle, start))
+                    founddisp=1;
+                }
+                if (!foundincr) {
+                    cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+                    cbf_failnez (cbf_get_doublevalue (handle, increment))
+                    foundincr=1;
+                }
+            }
+            if (!foundincr) return CBF_NOTFOUND;
+            if (!founddisp) return CBF_NOTFOUND;
+        }
+        else
+        {
+            const char *test_axis_id;
+
+            int foundincr, foundangle;
+            foundincr = 0;
+            foundangle = 0;
 
+            if (frame_id && cbf_cistrcmp(frame_id,".")!=0 ) {
+                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
+                    !cbf_find_column     (handle, "frame_id")){
+                    cbf_failnez (cbf_rewind_row      (handle))
+                    while (!cbf_find_nextrow(handle,frame_id)) {
+                        if(!cbf_find_column(handle,"axis_id") &&
+                           !cbf_get_value(handle,&test_axis_id) &&
+                           test_axis_id && *test_axis_id &&
+                           !cbf_cistrcmp(test_axis_id,axis_id)) {
+                            if (!cbf_find_column     (handle, "angle") &&
+                                !cbf_get_doublevalue (handle, start)) foundangle = 1;
+                            if (!cbf_find_column     (handle, "angle_increment") &&
+                                !cbf_get_doublevalue (handle, increment)) foundincr = 1;
+                            break;
+                        }
+                        cbf_failnez (cbf_find_column     (handle, "frame_id"))
+                    }
+                }
+            }
+            if ((!foundincr||!foundangle)&&frame_id && cbf_cistrcmp(frame_id,".")==0 ) {
+                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
+                    !cbf_find_column     (handle, "axis_id")){
+                    cbf_failnez (cbf_rewind_row      (handle))
+                    if (!cbf_find_nextrow(handle,axis_id)) {
+                        if (!foundangle&&!cbf_find_column(handle, "angle") &&
+                            !cbf_get_doublevalue (handle, start)) foundangle = 1;
+                        if (!foundincr&&!cbf_find_column(handle, "angle_increment") &&
+                            !cbf_get_doublevalue (handle, increment)) foundincr = 1;
+                    }
+                }
+            }
+            if (!foundincr || !foundangle) {
+                cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
+                cbf_failnez (cbf_find_column     (handle, "axis_id"))
+                cbf_failnez (cbf_find_row        (handle, axis_id))
+                if (!foundangle) {
+                    cbf_failnez (cbf_find_column     (handle, "angle"))
+                    cbf_failnez (cbf_get_doublevalue (handle, start))
+                    foundangle=1;
+                }
+                if (!foundincr) {
+                    cbf_failnez (cbf_find_column     (handle, "angle_increment"))
+                    cbf_failnez (cbf_get_doublevalue (handle, increment))
+                    foundincr=1;
+                }
+            }
+            if (!foundincr) return CBF_NOTFOUND;
+            if (!foundangle) return CBF_NOTFOUND;
         }
 
-        if (cell_esd) {
 
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_a_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[0]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_b_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[1]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_length_c_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[2]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_alpha_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[3]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_beta_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[4]))
-            cbf_failnez (cbf_require_column  (handle, "reciprocal_angle_gamma_esd"))
-            cbf_failnez (cbf_set_doublevalue (handle, "%-.15g", cell_esd[5]))
+        return 0;
+    }
 
-        }
+    /* Add frame-specific data for an axis to a positioner */
+
+    int cbf_read_positioner_frame_axis (cbf_handle      handle,
+                                        unsigned int    reserved,
+                                        cbf_positioner  positioner,
+                                        const char     *axis_id,
+                                        const char     *frame_id,
+                                        int             read_setting)
+    {
+        const char *next_id;
+
+        const char *rot_id;
+
+        cbf_axis_type axis_type;
+        
+        const char *deptype;
+
+        double vector1, vector2, vector3, offset1, offset2, offset3;
 
-        return 0;
+        double start, increment, rot;
 
-    }
+        int errorcode;
 
-    /* Compute a cell volume */
+        cbf_failnez (cbf_find_category    (handle, "axis"));
+        cbf_failnez (cbf_find_column      (handle, "id"));
+        cbf_failnez (cbf_find_row         (handle, axis_id));
+        cbf_failnez (cbf_find_column      (handle, "depends_on"));
+        cbf_failnez (cbf_get_value        (handle, &next_id));
+        cbf_failnez (cbf_get_typeofvalue  (handle, &deptype));
+        if (cbf_cistrcmp(deptype, "null") == 0) {
+            next_id = NULL;
+        }
 
-    int cbf_compute_cell_volume (double cell[6], double *volume) {
+        if (!cbf_find_column (handle, "rotation_axis")) {
 
-        double degtorad;
+            cbf_failnez (cbf_get_value    (handle, &rot_id));
 
-        degtorad = atan2(1.,1.)/45.;
+        } else {
 
-        *volume =  cell[0]*cell[1]*cell[2]*
-        sqrt(1.
-             - cos(cell[3]*degtorad)*cos(cell[3]*degtorad)
-             - cos(cell[4]*degtorad)*cos(cell[4]*degtorad)
-             - cos(cell[5]*degtorad)*cos(cell[5]*degtorad)
-             + 2.*cos(cell[3]*degtorad)*cos(cell[4]*degtorad)*cos(cell[5]*degtorad));
-        return 0;
+            rot_id = NULL;
 
-    }
+        }
 
-    /* Compute a reciprocal cell */
+        if (!cbf_find_column (handle, "rotation")) {
 
-    int cbf_compute_reciprocal_cell (double cell[6], double rcell[6]){
+            cbf_failnez (cbf_get_doublevalue (handle, &rot));
 
-        double volume, degtorad, radtodeg;
-#define acos_deg(x) (atan2(sqrt(1.-(x)*(x)),(x))*radtodeg)
+        } else {
 
-        cbf_compute_cell_volume (cell, &volume);
+            rot = 0.0;
 
-        degtorad = atan2(1.,1.)/45.;
-        radtodeg = 1./degtorad;
+        }
 
-        if (volume <= 0. ) return CBF_ARGUMENT;
+        cbf_failnez (cbf_get_axis_type    (handle, axis_id,
+                                           &axis_type))
+        cbf_failnez (cbf_get_axis_vector  (handle, axis_id,
+                                           &vector1,
+                                           &vector2,
+                                           &vector3))
+        cbf_failnez (cbf_get_axis_offset  (handle, axis_id,
+                                           &offset1,
+                                           &offset2,
+                                           &offset3))
 
-        rcell[0] = cell[1]*cell[2]*sin(cell[3]*degtorad)/volume;
+        start = increment = 0.;
 
-        rcell[1] = cell[2]*cell[0]*sin(cell[4]*degtorad)/volume;
+        errorcode = 0;
 
-        rcell[2] = cell[0]*cell[1]*sin(cell[5]*degtorad)/volume;
+        /* fprintf(stderr," cbf_read_positioner_axis , axis = %s, read_setting = %d\n",axis_id, read_setting);*/
 
-        rcell[3] = acos_deg((cos(cell[4]*degtorad)*cos(cell[5]*degtorad) - cos(cell[3]*degtorad))/(sin(cell[4]*degtorad)*sin(cell[5]*degtorad)));
+        if (read_setting && axis_type != CBF_GENERAL_AXIS)
+        {
 
-        rcell[4] = acos_deg((cos(cell[5]*degtorad)*cos(cell[3]*degtorad) - cos(cell[4]*degtorad))/(sin(cell[5]*degtorad)*sin(cell[3]*degtorad)));
+            errorcode = cbf_get_frame_axis_setting (handle, reserved, axis_id,
+                                                    frame_id,
+                                                    &start,
+                                                    &increment);
 
-        rcell[5] = acos_deg((cos(cell[3]*degtorad)*cos(cell[4]*degtorad) - cos(cell[5]*degtorad))/(sin(cell[3]*degtorad)*sin(cell[4]*degtorad)));
+            if (read_setting < 0) {
 
-        return 0;
+                increment = 0.;
 
-    }
+                errorcode = cbf_get_axis_reference_setting (handle, reserved, axis_id,
+                                                            &start);
+            }
 
-    /* Get the orientation matrix entry */
+            if ( (read_setting == -2 || read_setting == 2)
+                && (errorcode == CBF_NOTFOUND || errorcode == CBF_FORMAT) ) {
 
-    int cbf_get_orientation_matrix (cbf_handle handle, double ub_matrix[9])
-    {
+                start = increment = 0;
 
-        cbf_failnez(cbf_find_category    (handle, "diffrn_orient_matrix"));
-        cbf_failnez(cbf_rewind_row       (handle));
+                errorcode = 0;
 
-        if (ub_matrix) {
+            }
 
-            cbf_failnez (cbf_find_column   (handle, "UB[1][1]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[0])));
-            cbf_failnez (cbf_find_column   (handle, "UB[1][2]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[1])));
-            cbf_failnez (cbf_find_column   (handle, "UB[1][3]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[2])));
-            cbf_failnez (cbf_find_column   (handle, "UB[2][1]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[3])));
-            cbf_failnez (cbf_find_column   (handle, "UB[2][2]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[4])));
-            cbf_failnez (cbf_find_column   (handle, "UB[2][3]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[5])));
-            cbf_failnez (cbf_find_column   (handle, "UB[3][1]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[6])));
-            cbf_failnez (cbf_find_column   (handle, "UB[3][2]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[7])));
-            cbf_failnez (cbf_find_column   (handle, "UB[3][3]"));
-            cbf_failnez (cbf_get_doublevalue     (handle, &(ub_matrix[8])));
+            cbf_failnez(errorcode);
 
         }
 
-        return 0;
+        cbf_failnez (cbf_add_positioner_axis_wrot (positioner,
+                                              axis_id,
+                                              next_id,
+                                              rot_id,
+                                              axis_type,
+                                              vector1, vector2, vector3,
+                                              offset1, offset2, offset3,
+                                              start, increment, rot))
 
+        return 0;
     }
 
-    /* Set the orientation matrix entry */
+    /* Construct a frame goniometer positioner*/
 
-    int cbf_set_orientation_matrix (cbf_handle handle, double ub_matrix[9])
+    int cbf_construct_frame_goniometer (cbf_handle handle,
+                                        cbf_goniometer *goniometer,
+                                        const char *frame_id)
     {
-        const char * diffrn_id;
-        const char * UBdiffrn_id;
-
-        cbf_failnez(cbf_get_diffrn_id    (handle, &diffrn_id))
-
-        cbf_failnez(cbf_require_category (handle, "diffrn_orient_matrix"))
-        cbf_failnez(cbf_rewind_row       (handle))
-
-        cbf_failnez(cbf_require_column   (handle, "diffrn_id"))
-
-        UBdiffrn_id = 0;
-        if (cbf_get_value(handle, &UBdiffrn_id) ||
-            !UBdiffrn_id || *UBdiffrn_id == '\0') {
-            cbf_failnez(cbf_set_value      (handle, diffrn_id))
-        }
-
-
-        if (ub_matrix) {
+        const char *diffrn_id, *id, *this_id, *axis_id;
 
-            cbf_failnez (cbf_require_column   (handle, "UB[1][1]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[0]));
-            cbf_failnez (cbf_require_column   (handle, "UB[1][2]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[1]));
-            cbf_failnez (cbf_require_column   (handle, "UB[1][3]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[2]));
-            cbf_failnez (cbf_require_column   (handle, "UB[2][1]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[3]));
-            cbf_failnez (cbf_require_column   (handle, "UB[2][2]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[4]));
-            cbf_failnez (cbf_require_column   (handle, "UB[2][3]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[5]));
-            cbf_failnez (cbf_require_column   (handle, "UB[3][1]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[6]));
-            cbf_failnez (cbf_require_column   (handle, "UB[3][2]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[7]));
-            cbf_failnez (cbf_require_column   (handle, "UB[3][3]"));
-            cbf_failnez (cbf_set_doublevalue     (handle, "%-.15g", ub_matrix[8]));
+        const char * target_axis;
 
-        }
+        const char * rotation_axis;
 
-        return 0;
+        size_t axis_index;
 
-    }
+        unsigned int row;
 
+        int errorcode;
 
-    /* get the axis upon which an axis depends */
 
-    int cbf_get_parent_axis(cbf_handle handle,
-                            const char * *parent_axis,
-                            const char *axis_id) {
+        if (!goniometer)
 
-        cbf_failnez (cbf_find_category    (handle, "axis"))
-        cbf_failnez (cbf_find_column      (handle, "id"))
-        cbf_failnez (cbf_find_row         (handle, axis_id))
-        cbf_failnez (cbf_find_column      (handle, "depends_on"))
-        cbf_failnez (cbf_get_value        (handle, parent_axis))
+            return CBF_ARGUMENT;
 
-        return 0;
 
-    }
+        /* Get the measurement id */
 
+        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
 
-    /* get the reference axis vector and offset of a given axis */
+        cbf_failnez (cbf_find_category (handle, "diffrn_measurement"))
+        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
+        cbf_failnez (cbf_find_row      (handle, diffrn_id))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_get_value     (handle, &id))
 
-    int cbf_get_axis_reference_poise(cbf_handle handle,
-                                     double *vector1, double *vector2, double *vector3,
-                                     double *offset1, double *offset2, double *offset3,
-                                     const char *axis_id)
-    {
-        cbf_failnez (cbf_get_axis_vector  (handle, axis_id,
-                                           vector1,
-                                           vector2,
-                                           vector3))
-        cbf_failnez (cbf_get_axis_offset  (handle, axis_id,
-                                           offset1,
-                                           offset2,
-                                           offset3))
 
-        return 0;
-    }
+        /* Construct the goniometer */
 
-    /* get the absolute axis vector and offset of a given axis
-     ratio is how far into a frame we are, 0. at the start
-     of the frame, 1. at the end
+        cbf_failnez (cbf_make_positioner (goniometer))
 
-     The three offset values are the absolute position to which
-     the origin has been moved */
+        for (row = errorcode = 0; !errorcode; row++)
+        {
+            errorcode = cbf_find_category (handle, "diffrn_measurement_axis");
 
-    int cbf_get_axis_poise(cbf_handle handle, double ratio,
-                           double *vector1, double *vector2, double *vector3,
-                           double *offset1, double *offset2, double *offset3,
-                           double *angle,
-                           const char *axis_id,
-                           const char *frame_id)
-    {
-        cbf_positioner positioner;
+            if (!errorcode)
+            {
+                /* allow for aliases  _diffrn_measurement_axis.measurement_id
+                 _diffrn_measurement_axis.id  (deprecated) */
 
-        const char *parent_axis;
+                errorcode = cbf_find_column (handle, "measurement_id");
 
-        double refvector1, refvector2, refvector3;
+                if (errorcode)
 
-        double refoffset1, refoffset2, refoffset3;
+                    errorcode = cbf_find_column (handle, "id");
+            }
 
-        double start, increment;
+            if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
 
-        cbf_get_axis_reference_poise(handle,
-                                     &refvector1, &refvector2, &refvector3,
-                                     &refoffset1, &refoffset2, &refoffset3,
-                                     axis_id);
+                if (errorcode == CBF_NOTFOUND)
+                {
+                    errorcode = 0;
 
-        if (angle) {
+                    break;
+                }
+            }
 
-            cbf_failnez(cbf_get_frame_axis_setting(handle,0,
-                                    axis_id, frame_id, &start, &increment));
+            if (!errorcode)
 
-            *angle = ratio*increment;
+                errorcode = cbf_get_value (handle, &this_id);
 
-        }
+            if (!errorcode)
 
-        cbf_failnez(cbf_get_parent_axis(handle,&parent_axis,axis_id));
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
 
-        /* fprintf(stderr," axis_id %s parent %s\n",axis_id,parent_axis); */
+                    if (!errorcode)
 
-        /* If this axis is not dependent, just return the reference poise */
+                        errorcode = cbf_get_value (handle, &axis_id);
 
-        if (!parent_axis || cbf_cistrcmp(".",parent_axis) == 0) {
+                    if (!errorcode)
 
+                        errorcode = cbf_read_positioner_frame_axis (handle,
+                                                                    0, /* reserved */
+                                                                    *goniometer,
+                                                                    axis_id,
+                                                                    frame_id, 1);
+                }
+        }
 
-            if (vector1) *vector1 = refvector1;
-            if (vector2) *vector2 = refvector2;
-            if (vector3) *vector3 = refvector3;
+        /* Complete the connectivity of the positioner */
 
-            if (offset1) *offset1 = refoffset1;
-            if (offset2) *offset2 = refoffset2;
-            if (offset3) *offset3 = refoffset3;
+        axis_index = 0;
 
-            return 0;
+        do {
 
-        }
+            size_t index;
 
-        cbf_failnez(cbf_construct_frame_positioner(handle, &positioner, parent_axis, frame_id))
+            int found;
 
+            target_axis = (*goniometer)->axis[axis_index].depends_on;
 
-        cbf_failnez(cbf_calculate_position(positioner,0,ratio,
-                                      refoffset1, refoffset2, refoffset3,
-                                      offset1,offset2,offset3))
+            rotation_axis = (*goniometer)->axis[axis_index].rotation_axis;
 
-        cbf_failnez(cbf_rotate_vector(positioner,0,ratio,
-                                      refvector1, refvector2, refvector3,
-                                      vector1,vector2,vector3))
+            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
 
-                return cbf_free_positioner(positioner);
+                found = 0;
 
+                for (index = 0; index < (*goniometer)->axes; index++) {
 
-    }
+                    if (index != axis_index &&
+                        cbf_cistrcmp (target_axis,(*goniometer)->axis[index].name)== 0)
+                    {
 
-    /* Get the positioner matrix
+                        (*goniometer)->axis[axis_index].depends_on_index = index;
 
-     The position matrix return is a 3x4 matrix of doubles.  The upper left 3x3
-     is the rotation, the upper right 3x1 is the (post-) translation*/
+                        found = 1;
 
+                        (*goniometer)->axis[index].depdepth
+                        = cbf_max( (*goniometer)->axis[index].depdepth,
+                                  (*goniometer)->axis[axis_index].depdepth+1);
 
-    int cbf_get_positioner_matrix (cbf_positioner positioner, double ratio, double matrix[3][4]) {
 
-        size_t i, j;
+                        break;
 
-        double setting;
+                    }
 
-        if (!positioner)
+                }
 
-            return CBF_ARGUMENT;
+                if (!found) {
 
-        for (i = 0; i < positioner->axes; i++)
-        {
-            setting = positioner->axis [i].start + ratio *
-            positioner->axis [i].increment;
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *goniometer,
+                                                          target_axis, 2);
 
-            if (positioner->axis [i].setting != setting)
-            {
-                positioner->matrix_is_valid = 0;
+                    (*goniometer)->axis[axis_index].depends_on_index
+                    = (*goniometer)->axes-1;
 
-                positioner->axis [i].setting = setting;
-            }
-        }
+                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
+                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
+                              (*goniometer)->axis[axis_index].depdepth+1);
 
-        if (!positioner->matrix_is_valid || positioner->matrix_ratio_used != ratio )
-        {
 
+                    if (!errorcode) break;
 
-            positioner->matrix_ratio_used = ratio;
+                }
 
-            positioner->matrix [0][0] = 1;
-            positioner->matrix [0][1] = 0;
-            positioner->matrix [0][2] = 0;
-            positioner->matrix [0][3] = 0;
-            positioner->matrix [1][0] = 0;
-            positioner->matrix [1][1] = 1;
-            positioner->matrix [1][2] = 0;
-            positioner->matrix [1][3] = 0;
-            positioner->matrix [2][0] = 0;
-            positioner->matrix [2][1] = 0;
-            positioner->matrix [2][2] = 1;
-            positioner->matrix [2][3] = 0;
+            }
 
+            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
 
-            for (i = 0; i < positioner->axes; i++)
-            {
-                setting = positioner->axis [i].setting;
+                found = 0;
 
-                if (positioner->axis [i].type == CBF_TRANSLATION_AXIS)
-                {
-                    positioner->matrix [0][3] += setting * positioner->axis [i].vector [0];
-                    positioner->matrix [1][3] += setting * positioner->axis [i].vector [1];
-                    positioner->matrix [2][3] += setting * positioner->axis [i].vector [2];
-                    /* fprintf(stderr," calculate position, axis %d, translate [%g, %g, %g]\n",
-                     i,
-                     setting * positioner->axis [i].vector [0],
-                     setting * positioner->axis [i].vector [1],
-                     setting * positioner->axis [i].vector [2]);
-                     */
+                for (index = 0; index < (*goniometer)->axes; index++) {
 
-                }
-                else
-                {
-                    double s, x, y, z, w,
-                    xx, yy, zz, xy, xz, xw, yz, yw, zw;
+                    if (index != axis_index &&
+                        cbf_cistrcmp (rotation_axis,(*goniometer)->axis[index].name)== 0)
+                    {
 
-                    double rotation [3][3], product [3][4];
+                        (*goniometer)->axis[axis_index].rotation_axis_index = index;
 
-                    int r1, c1r2, c2;
+                        found = 1;
 
-                    s = sin (setting * 0.00872664625997164788461845384244);
+                        (*goniometer)->axis[index].depdepth
+                        = cbf_max( (*goniometer)->axis[index].depdepth,
+                                  (*goniometer)->axis[axis_index].depdepth+1);
 
-                    x = positioner->axis [i].vector [0] * s;
-                    y = positioner->axis [i].vector [1] * s;
-                    z = positioner->axis [i].vector [2] * s;
 
-                    w = cos (setting * 0.00872664625997164788461845384244);
+                        break;
 
-                    xx = x * x;
-                    yy = y * y;
-                    zz = z * z;
-                    xy = x * y;
-                    xz = x * z;
-                    xw = x * w;
-                    yz = y * z;
-                    yw = y * w;
-                    zw = z * w;
+                    }
 
-                    rotation [0][0] = 1 - 2 * (yy + zz);
-                    rotation [0][1] =     2 * (xy - zw);
-                    rotation [0][2] =     2 * (xz + yw);
-                    rotation [1][0] =     2 * (xy + zw);
-                    rotation [1][1] = 1 - 2 * (xx + zz);
-                    rotation [1][2] =     2 * (yz - xw);
-                    rotation [2][0] =     2 * (xz - yw);
-                    rotation [2][1] =     2 * (yz + xw);
-                    rotation [2][2] = 1 - 2 * (xx + yy);
+                }
 
-                    /* fprintf(stderr," calculate position, axis %d, rotate [%g + i*%g + j*%g + k*%g]\n",
-                     i, w, x, y, z);
-                     */
+                if (!found) {
 
-                    for (r1 = 0; r1 < 3; r1++)
 
-                        for (c2 = 0; c2 < 4; c2++)
-                        {
-                            product [r1][c2] = 0;
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          *goniometer,
+                                                          rotation_axis, 2);
 
-                            for (c1r2 = 0; c1r2 < 3; c1r2++)
+                    (*goniometer)->axis[axis_index].rotation_axis_index
+                    = (*goniometer)->axes-1;
 
-                                product [r1][c2] += rotation [r1][c1r2] *
-                                positioner->matrix [c1r2][c2];
-                        }
+                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
+                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
+                              (*goniometer)->axis[axis_index].depdepth+1);
 
-                    for (r1 = 0; r1 < 3; r1++)
 
-                        for (c2 = 0; c2 < 4; c2++)
+                    if (!errorcode) break;
 
-                            positioner->matrix [r1][c2] = product [r1][c2];
                 }
 
-                positioner->matrix [0][3] += positioner->axis [i].offset [0];
-                positioner->matrix [1][3] += positioner->axis [i].offset [1];
-                positioner->matrix [2][3] += positioner->axis [i].offset [2];
             }
 
-            positioner->matrix_is_valid = 1;
-        }
+            axis_index++;
 
-        if (matrix) {
+        } while (axis_index < (*goniometer)->axes);
 
-            for (i=0;i<3;i++) {
-                for (j=0;j<4;j++) {
-                    matrix[i][j]=positioner->matrix[i][j];
-                }
-            }
 
-        }
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (*goniometer);
 
-        return 0;
+            *goniometer = NULL;
+        }
 
+        return errorcode;
     }
 
-    /* Get goniometer poise -- returns the pre-offset, post-translation and angle */
 
-    int cbf_get_goniometer_poise(cbf_goniometer goniometer, double ratio,
-                                 double *vector1, double *vector2, double* vector3,
-                                 double *offset1, double *offset2, double* offset3,
-                                 double *angle) {
-        double matrix0[3][4];
+    /* Construct a frame detector positioner */
 
-        double matrix1[3][4];
+    int cbf_construct_frame_detector (cbf_handle    handle,
+                                      cbf_detector *detector,
+                                      unsigned int  element_number,
+                                      const char *frame_id)
+    {
+        int errorcode, precedence;
 
-        double matrix[3][4];
+        unsigned int row, axis;
 
-        double axis[3], alength;
+        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
+        
+        const char *array_section_id;
 
-        double theta, costheta, sintheta;
+        const char * target_axis;
 
-        int i,j;
+        const char * rotation_axis;
 
-        cbf_failnez(cbf_get_positioner_matrix(goniometer, 0., matrix0))
+        size_t axis_index;
 
-        cbf_failnez(cbf_get_positioner_matrix(goniometer, 1., matrix1))
+        const char *surface_axis [2];  /* fast, slow */
 
-        /* compute matrix1*inverse(matrix2) forcing the offset to the
-           ratio weighted average of the two offsets */
+        double displacement [2], increment [2];
 
-        for (i=0; i < 3; i++) {
+        cbf_positioner positioner;
 
-            for (j=0; j < 3; j++) {
+        if (!detector)
 
-                matrix[i][j] = matrix0[i][0]*matrix1[j][0]
-                + matrix0[i][1]*matrix1[j][1]
-                + matrix0[i][2]*matrix1[j][2];
+            return CBF_ARGUMENT;
 
-            }
 
-            matrix[i][3] = matrix0[i][3]*(1.-ratio)+matrix1[i][3]*ratio;
-        }
+        /* Get the detector id */
 
-        costheta = .5*(matrix[0][0]+matrix[1][1]+matrix[2][2]-1.);
+        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
 
-        if (costheta < -1.0000000000001 || costheta > 1.0000000000001) return CBF_ARGUMENT;
+        cbf_failnez (cbf_find_category (handle, "diffrn_detector"))
+        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
+        cbf_failnez (cbf_find_row      (handle, diffrn_id))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_get_value     (handle, &id))
 
-        sintheta = sqrt(fabs(1.-costheta*costheta));
 
-        theta = atan2(sintheta,costheta);
+        /* Construct the detector surface */
 
-        axis[0] = -(matrix[2][1]-matrix[1][2]);
+        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id))
+        cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
+        cbf_failnez (cbf_find_category (handle, "array_structure_list"))
+        if (cbf_find_column(handle,"array_section_id")) {
+            if (cbf_find_column(handle,"array_id")) {
+                cbf_failnez (cbf_find_column   (handle, "array_section"));
+            }
+        }
 
-        axis[1] = -(matrix[0][2]-matrix[2][0]);
+        surface_axis [0] = surface_axis [1] = NULL;
 
-        axis[2] = -(matrix[1][0]-matrix[0][1]);
+        while (cbf_find_nextrow (handle, array_id) == 0)
+        {
+            cbf_failnez (cbf_find_column      (handle, "precedence"))
+            cbf_failnez (cbf_get_integervalue (handle, &precedence))
 
-        alength = sqrt(axis[0]*axis[0]+axis[1]*axis[1]+axis[2]*axis[2]);
+            if (precedence < 1 || precedence > 2)
 
-        if (alength > 1.e-10) {
+                return CBF_FORMAT;
 
-            axis[0] = axis[0]/alength;
+            if (surface_axis [precedence - 1])
 
-            axis[1] = axis[1]/alength;
+                return CBF_FORMAT;
 
-            axis[2] = axis[2]/alength;
+            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
+            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
+            if (cbf_find_column(handle,"array_section_id")) {
+                cbf_failnez (cbf_find_column   (handle, "array_id"));
+            }
+        }
 
-        } else {
+        if (!surface_axis [0])
 
-            axis[0] = 1.;
+            return CBF_FORMAT;
 
-            axis[1] = 0.;
+        cbf_failnez (cbf_find_category   (handle, "array_structure_list_axis"))
+        cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
+        cbf_failnez (cbf_find_row        (handle, surface_axis [0]))
+        cbf_failnez (cbf_find_column     (handle, "axis_id"))
+        cbf_failnez (cbf_get_value       (handle, &surface_axis [0]))
+        cbf_failnez (cbf_find_column     (handle, "displacement"))
+        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
+        cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+        cbf_failnez (cbf_get_doublevalue (handle, &increment [0]))
 
-            axis[2] = 0.;
+        if (surface_axis [1])
+        {
+            cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
+            cbf_failnez (cbf_find_row        (handle, surface_axis [1]))
+            cbf_failnez (cbf_find_column     (handle, "axis_id"))
+            cbf_failnez (cbf_get_value       (handle, &surface_axis [1]))
+            cbf_failnez (cbf_find_column     (handle, "displacement"))
+            cbf_failnez (cbf_get_doublevalue (handle, &displacement [1]))
+            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
+            cbf_failnez (cbf_get_doublevalue (handle, &increment [1]))
         }
 
-        if (angle) *angle = ratio*theta*45./atan2(1.,1.);
-
-        if (vector1) *vector1 = axis[0];
 
-        if (vector2) *vector2 = axis[1];
+        /* Construct the positioner */
 
-        if (vector3) *vector3 = axis[2];
+        cbf_failnez (cbf_make_positioner (&positioner))
 
-        if (offset1) {
+        errorcode = cbf_alloc ((void **) detector, NULL,
+                               sizeof (cbf_detector_struct), 1);
 
-            *offset1 = matrix[0][0]*matrix[0][3]
-            + matrix[1][0]*matrix[1][3]
-            + matrix[2][0]*matrix[2][3];
+        for (row = errorcode = 0; !errorcode; row++)
+        {
+            errorcode = cbf_find_category (handle, "diffrn_detector_axis");
 
-        }
+            if (!errorcode)
+            {
+                /* allow for aliases  _diffrn_detector_axis.detector_id
+                 _diffrn_detector_axis.id  (deprecated) */
 
-        if (offset2) {
+                errorcode = cbf_find_column (handle, "detector_id");
 
-            *offset2 = matrix[0][1]*matrix[0][3]
-            + matrix[1][1]*matrix[1][3]
-            + matrix[2][1]*matrix[2][3];
+                if (errorcode)
 
-        }
+                    errorcode = cbf_find_column (handle, "id");
+            }
 
-        if (offset3) {
+            if (!errorcode)
+            {
+                errorcode = cbf_select_row (handle, row);
 
-            *offset3 = matrix[0][2]*matrix[0][3]
-            + matrix[1][2]*matrix[1][3]
-            + matrix[2][2]*matrix[2][3];
+                if (errorcode == CBF_NOTFOUND)
+                {
+                    errorcode = 0;
 
-        }
+                    break;
+                }
+            }
 
-        return 0;
+            if (!errorcode)
 
-    }
+                errorcode = cbf_get_value (handle, &this_id);
 
-    /* Get the setting of an axis specific to a given frame */
+            if (!errorcode)
 
-    int cbf_get_frame_axis_setting (cbf_handle handle, unsigned int  reserved,
-                                    const char   *axis_id,
-                                    const char   *frame_id,
-                                    double       *start,
-                                    double       *increment)
-    {
-        cbf_axis_type type;
+                if (cbf_cistrcmp (id, this_id) == 0)
+                {
+                    errorcode = cbf_find_column (handle, "axis_id");
 
-        if (reserved != 0 || !start || !increment )
+                    if (!errorcode)
 
-            return CBF_ARGUMENT;
+                        errorcode = cbf_get_value (handle, &axis_id);
 
+                    if (!errorcode)
 
-        /* Get the axis type */
+                        errorcode = cbf_read_positioner_frame_axis (handle, 0,
+                                                                    positioner,
+                                                                    axis_id,
+                                                                    frame_id,
+                                                                    1);
+                }
+        }
 
-        cbf_failnez (cbf_get_axis_type (handle, axis_id, &type))
 
-        if (type != CBF_TRANSLATION_AXIS && type != CBF_ROTATION_AXIS && type != CBF_GENERAL_AXIS )
+        /* Add the surface axes */
 
-            return CBF_FORMAT;
+        if (!errorcode)
 
-        /* For a general axis, the settings are always 0 */
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [0], 0);
 
-        if (type == CBF_GENERAL_AXIS ) {
+        if (!errorcode && surface_axis [1])
 
-            *start = 0.;
+            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
+                                                  surface_axis [1], 0);
 
-            *increment = 0.;
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (positioner);
 
+            return errorcode | cbf_free ((void **) detector, NULL);
         }
 
+        /* Complete the connectivity of the positioner */
 
-        /* Read from the diffrn_scan_axis and
-         diffrn_scan_frame_axis categories */
+        axis_index = 0;
 
-        else if (type == CBF_TRANSLATION_AXIS)
-        {
-            const char *test_axis_id;
+        do {
 
-            int foundincr, founddisp;
-            foundincr = 0;
-            founddisp = 0;
+            size_t index;
 
-            if (frame_id && cbf_cistrcmp(frame_id,".")!=0 ) {
-                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
-                    !cbf_find_column     (handle, "frame_id")){
-                    cbf_failnez (cbf_rewind_row      (handle))
-                    while (!cbf_find_nextrow(handle,frame_id)) {
-                        if(!cbf_find_column(handle,"axis_id") &&
-                           !cbf_get_value(handle,&test_axis_id) &&
-                           test_axis_id && *test_axis_id &&
-                           !cbf_cistrcmp(test_axis_id,axis_id)) {
-                            if (!cbf_find_column     (handle, "displacement") &&
-                                !cbf_get_doublevalue (handle, start)) founddisp = 1;
-                            if (!cbf_find_column     (handle, "displacement_increment") &&
-                                !cbf_get_doublevalue (handle, increment)) foundincr = 1;
-                            break;
-                        }
-                        cbf_failnez (cbf_find_column     (handle, "frame_id"))
-                    }
-                }
-            }
-            if ((!foundincr||!founddisp)&&frame_id && cbf_cistrcmp(frame_id,".")==0 ) {
-                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
-                    !cbf_find_column     (handle, "axis_id")){
-                    cbf_failnez (cbf_rewind_row      (handle))
-                    if (!cbf_find_nextrow(handle,axis_id)) {
-                        if (!founddisp&&!cbf_find_column(handle, "displacement") &&
-                            !cbf_get_doublevalue (handle, start)) founddisp = 1;
-                        if (!foundincr&&!cbf_find_column(handle, "displacement_increment") &&
-                            !cbf_get_doublevalue (handle, increment)) foundincr = 1;
-                    }
-                }
-            }
-            if (!foundincr || !founddisp) {
-                cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
-                cbf_failnez (cbf_find_column     (handle, "axis_id"))
-                cbf_failnez (cbf_find_row        (handle, axis_id))
-                if (!founddisp) {
-                    cbf_failnez (cbf_find_column     (handle, "displacement"))
-                    cbf_failnez (cbf_get_doublevalue (handle, start))
-                }
-                if (!foundincr) {
-                    cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-                    cbf_failnez (cbf_get_doublevalue (handle, increment))
-                }
-            }
-            if (!foundincr) return CBF_NOTFOUND;
-            if (!founddisp) return CBF_NOTFOUND;
-        }
-        else
-        {
-            const char *test_axis_id;
+            int found;
 
-            int foundincr, foundangle;
-            foundincr = 0;
-            foundangle = 0;
+            target_axis = positioner->axis[axis_index].depends_on;
+
+            rotation_axis = positioner->axis[axis_index].rotation_axis;
+
+            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+
+                found = 0;
+
+                for (index = 0; index < positioner->axes; index++) {
+
+                    if (index != axis_index &&
+                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
+        {
+
+                        positioner->axis[axis_index].depends_on_index = index;
+
+                        found = 1;
+
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
+
+
+                        break;
+
+        }
 
-            if (frame_id && cbf_cistrcmp(frame_id,".")!=0 ) {
-                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
-                    !cbf_find_column     (handle, "frame_id")){
-                    cbf_failnez (cbf_rewind_row      (handle))
-                    while (!cbf_find_nextrow(handle,frame_id)) {
-                        if(!cbf_find_column(handle,"axis_id") &&
-                           !cbf_get_value(handle,&test_axis_id) &&
-                           test_axis_id && *test_axis_id &&
-                           !cbf_cistrcmp(test_axis_id,axis_id)) {
-                            if (!cbf_find_column     (handle, "angle") &&
-                                !cbf_get_doublevalue (handle, start)) foundangle = 1;
-                            if (!cbf_find_column     (handle, "angle_increment") &&
-                                !cbf_get_doublevalue (handle, increment)) foundincr = 1;
-                            break;
-                        }
-                        cbf_failnez (cbf_find_column     (handle, "frame_id"))
-                    }
-                }
-            }
-            if ((!foundincr||!foundangle)&&frame_id && cbf_cistrcmp(frame_id,".")==0 ) {
-                if (!cbf_find_category   (handle, "diffrn_scan_frame_axis") &&
-                    !cbf_find_column     (handle, "axis_id")){
-                    cbf_failnez (cbf_rewind_row      (handle))
-                    if (!cbf_find_nextrow(handle,axis_id)) {
-                        if (!foundangle&&!cbf_find_column(handle, "angle") &&
-                            !cbf_get_doublevalue (handle, start)) foundangle = 1;
-                        if (!foundincr&&!cbf_find_column(handle, "angle_increment") &&
-                            !cbf_get_doublevalue (handle, increment)) foundincr = 1;
-                    }
-                }
-            }
-            if (!foundincr || !foundangle) {
-                cbf_failnez (cbf_find_category   (handle, "diffrn_scan_axis"))
-                cbf_failnez (cbf_find_column     (handle, "axis_id"))
-                cbf_failnez (cbf_find_row        (handle, axis_id))
-                if (!foundangle) {
-                    cbf_failnez (cbf_find_column     (handle, "angle"))
-                    cbf_failnez (cbf_get_doublevalue (handle, start))
-                    foundangle=1;
                 }
-                if (!foundincr) {
-                    cbf_failnez (cbf_find_column     (handle, "angle_increment"))
-                    cbf_failnez (cbf_get_doublevalue (handle, increment))
-                    foundincr=1;
+
+                if (!found) {
+
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          target_axis, 2);
+
+                    positioner->axis[axis_index].depends_on_index
+                    = positioner->axes-1;
+
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
+
+
+                    if (!errorcode) break;
+
                 }
+
             }
-            if (!foundincr) return CBF_NOTFOUND;
-            if (!foundangle) return CBF_NOTFOUND;
-        }
 
+            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
 
-        return 0;
-    }
+                found = 0;
 
-    /* Add frame-specific data for an axis to a positioner */
+                for (index = 0; index < positioner->axes; index++) {
 
-    int cbf_read_positioner_frame_axis (cbf_handle      handle,
-                                        unsigned int    reserved,
-                                        cbf_positioner  positioner,
-                                        const char     *axis_id,
-                                        const char     *frame_id,
-                                        int             read_setting)
-    {
-        const char *next_id;
+                    if (index != axis_index &&
+                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
+                    {
 
-        const char *rot_id;
+                        positioner->axis[axis_index].rotation_axis_index = index;
 
-        cbf_axis_type axis_type;
-        
-        const char *deptype;
+                        found = 1;
 
-        double vector1, vector2, vector3, offset1, offset2, offset3;
+                        positioner->axis[index].depdepth
+                        = cbf_max( positioner->axis[index].depdepth,
+                                  positioner->axis[axis_index].depdepth+1);
 
-        double start, increment, rot;
 
-        int errorcode;
+                        break;
 
-        cbf_failnez (cbf_find_category    (handle, "axis"));
-        cbf_failnez (cbf_find_column      (handle, "id"));
-        cbf_failnez (cbf_find_row         (handle, axis_id));
-        cbf_failnez (cbf_find_column      (handle, "depends_on"));
-        cbf_failnez (cbf_get_value        (handle, &next_id));
-        cbf_failnez (cbf_get_typeofvalue  (handle, &deptype));
-        if (cbf_cistrcmp(deptype, "null") == 0) {
-            next_id = NULL;
-        }
+                    }
 
-        if (!cbf_find_column (handle, "rotation_axis")) {
+                }
 
-            cbf_failnez (cbf_get_value    (handle, &rot_id));
+                if (!found) {
 
-        } else {
 
-            rot_id = NULL;
+                    errorcode = cbf_read_positioner_axis (handle,
+                                                          0, /* reserved */
+                                                          positioner,
+                                                          rotation_axis, 2);
 
-        }
+                    positioner->axis[axis_index].rotation_axis_index
+                    = positioner->axes-1;
 
-        if (!cbf_find_column (handle, "rotation")) {
+                    positioner->axis[positioner->axes-1].depdepth
+                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
+                              positioner->axis[axis_index].depdepth+1);
 
-            cbf_failnez (cbf_get_doublevalue (handle, &rot));
 
-        } else {
+                    if (!errorcode) break;
 
-            rot = 0.0;
+                }
 
-        }
+            }
 
-        cbf_failnez (cbf_get_axis_type    (handle, axis_id,
-                                           &axis_type))
-        cbf_failnez (cbf_get_axis_vector  (handle, axis_id,
-                                           &vector1,
-                                           &vector2,
-                                           &vector3))
-        cbf_failnez (cbf_get_axis_offset  (handle, axis_id,
-                                           &offset1,
-                                           &offset2,
-                                           &offset3))
+            axis_index++;
 
-        start = increment = 0.;
+        } while (axis_index < positioner->axes);
 
-        errorcode = 0;
+        /* Insert the cbf handle and element into the dectector */
 
-        /* fprintf(stderr," cbf_read_positioner_axis , axis = %s, read_setting = %d\n",axis_id, read_setting);*/
+        (*detector)->handle = handle;
 
-        if (read_setting && axis_type != CBF_GENERAL_AXIS)
-        {
+        (*detector)->element = element_number;
 
-            errorcode = cbf_get_frame_axis_setting (handle, reserved, axis_id,
-                                                    frame_id,
-                                                    &start,
-                                                    &increment);
 
-            if (read_setting < 0) {
+        /* Copy the start and increment values into the surface axes */
 
-                increment = 0.;
+        (*detector)->displacement [0] = displacement [0];
+        (*detector)->displacement [1] = displacement [1];
 
-                errorcode = cbf_get_axis_reference_setting (handle, reserved, axis_id,
-                                                            &start);
-            }
+        (*detector)->increment [0] = increment [0];
+        (*detector)->increment [1] = increment [1];
 
-            if ( (read_setting == -2 || read_setting == 2)
-                && (errorcode == CBF_NOTFOUND || errorcode == CBF_FORMAT) ) {
+        if (surface_axis [1])
 
-                start = increment = 0;
+            (*detector)->axes = 2;
 
-                errorcode = 0;
+        else
 
-            }
+            (*detector)->axes = 1;
 
-            cbf_failnez(errorcode);
+        for (axis = 0; axis < (*detector)->axes; axis++)
 
-        }
+            for (row = 0; row < positioner->axes; row++)
 
-        cbf_failnez (cbf_add_positioner_axis_wrot (positioner,
-                                              axis_id,
-                                              next_id,
-                                              rot_id,
-                                              axis_type,
-                                              vector1, vector2, vector3,
-                                              offset1, offset2, offset3,
-                                              start, increment, rot))
+                if (cbf_cistrcmp (positioner->axis [row].name,
+                                  surface_axis [axis]) == 0)
+                {
+                    (*detector)->index [axis] = row;
+
+                    positioner->axis [row].increment = 0;
+
+                    break;
+                }
+
+        (*detector)->positioner = positioner;
 
         return 0;
     }
 
-    /* Construct a frame goniometer positioner*/
+    /* construct a positioner for a given final axis */
 
-    int cbf_construct_frame_goniometer (cbf_handle handle,
-                                        cbf_goniometer *goniometer,
+    int cbf_construct_frame_positioner (cbf_handle handle,
+                                        cbf_positioner *positioner,
+                                        const char *axis_id,
                                         const char *frame_id)
     {
-        const char *diffrn_id, *id, *this_id, *axis_id;
+
+        int errorcode;
 
         const char * target_axis;
 
@@ -10132,661 +11666,713 @@ extern "C" {
 
         size_t axis_index;
 
-        unsigned int row;
+        unsigned int axis_index_limit;
 
-        int errorcode;
+        if (!positioner || !axis_id)
 
+            return CBF_ARGUMENT;
 
-        if (!goniometer)
+        /* fprintf(stderr," cbf_construct_positioner, axis %s\n",axis_id);*/
 
-            return CBF_ARGUMENT;
+        errorcode = 0;
 
 
-        /* Get the measurement id */
+        /* Construct the positioner */
 
-        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
+        cbf_failnez (cbf_make_positioner (positioner));
 
-        cbf_failnez (cbf_find_category (handle, "diffrn_measurement"))
-        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
-        cbf_failnez (cbf_find_row      (handle, diffrn_id))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_get_value     (handle, &id))
+        /* Set a limit on the number of axes in the positioner
+
+         As a crude limit to break dependency loops, N*(N-1)/2
 
+         will suffice.
 
-        /* Construct the goniometer */
+         */
 
-        cbf_failnez (cbf_make_positioner (goniometer))
+        cbf_failnez(cbf_find_category(handle,"axis"));
 
-        for (row = errorcode = 0; !errorcode; row++)
-        {
-            errorcode = cbf_find_category (handle, "diffrn_measurement_axis");
+        cbf_failnez(cbf_count_rows(handle,&axis_index_limit));
 
-            if (!errorcode)
-            {
-                /* allow for aliases  _diffrn_measurement_axis.measurement_id
-                 _diffrn_measurement_axis.id  (deprecated) */
+        axis_index_limit *= (axis_index_limit-1);
+
+        axis_index_limit /= 2;
+
+        (*positioner)->axis_index_limit = axis_index_limit;
+
+        /* read the first axis */
+
+            errorcode = cbf_read_positioner_frame_axis (handle,
+                                                        0, /* reserved */
+                                                        *positioner,
+                                                    axis_id,
+                                                        frame_id, 2);
+
+        axis_index = 0;
+
+            if (!errorcode) {
+
+            do{
+
+                target_axis = (*positioner)->axis[axis_index].depends_on;
+
+                rotation_axis = (*positioner)->axis[axis_index].rotation_axis;
+
+                if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+
+                    errorcode = cbf_read_positioner_frame_axis (handle,
+                                                          0, /* reserved */
+                                                          *positioner,
+                                                          target_axis,
+                                                          frame_id, 2);
+
+                    (*positioner)->axis[axis_index].depends_on_index
+                    = (*positioner)->axes-1;
 
-                errorcode = cbf_find_column (handle, "measurement_id");
+                    (*positioner)->axis[(*positioner)->axes-1].depdepth
+                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
+                              (*positioner)->axis[axis_index].depdepth+1);
 
-                if (errorcode)
+                    if (!errorcode) break;
 
-                    errorcode = cbf_find_column (handle, "id");
             }
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
-
-                if (errorcode == CBF_NOTFOUND)
-                {
-                    errorcode = 0;
+                if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
 
-                    break;
-                }
-            }
+                    errorcode = cbf_read_positioner_frame_axis (handle,
+                                                          0, /* reserved */
+                                                          *positioner,
+                                                          rotation_axis,
+                                                          frame_id, 2);
 
-            if (!errorcode)
+                    (*positioner)->axis[axis_index].rotation_axis_index
+                    = (*positioner)->axes-1;
 
-                errorcode = cbf_get_value (handle, &this_id);
+                    (*positioner)->axis[(*positioner)->axes-1].depdepth
+                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
+                              (*positioner)->axis[axis_index].depdepth+1);
 
-            if (!errorcode)
 
-                if (cbf_cistrcmp (id, this_id) == 0)
-                {
-                    errorcode = cbf_find_column (handle, "axis_id");
+                    if (!errorcode) break;
 
-                    if (!errorcode)
+        }
 
-                        errorcode = cbf_get_value (handle, &axis_id);
+                axis_index++;
 
-                    if (!errorcode)
+            } while (axis_index < (*positioner)->axes);
 
-                        errorcode = cbf_read_positioner_frame_axis (handle,
-                                                                    0, /* reserved */
-                                                                    *goniometer,
-                                                                    axis_id,
-                                                                    frame_id, 1);
-                }
         }
 
-        /* Complete the connectivity of the positioner */
+        if (errorcode)
+        {
+            errorcode |= cbf_free_positioner (*positioner);
 
-        axis_index = 0;
+            *positioner = NULL;
+        }
 
-        do {
+        return errorcode;
+    }
 
-            size_t index;
 
-            int found;
+    /* Count the axes of the goniometer or detector that take their
+       settings from the frame.  cbf_construct_frame_goniometer and
+       cbf_construct_frame_detector add these before any other axes */
 
-            target_axis = (*goniometer)->axis[axis_index].depends_on;
+    static int cbf_count_frame_axes (cbf_handle  handle,
+                                     const char *equipment,
+                                     const char *category,
+                                     const char *column,
+                                     size_t     *count)
+    {
+        const char *diffrn_id, *id, *this_id;
 
-            rotation_axis = (*goniometer)->axis[axis_index].rotation_axis;
+        unsigned int row;
 
-            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+        *count = 0;
 
-                found = 0;
+        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
 
-                for (index = 0; index < (*goniometer)->axes; index++) {
+        cbf_failnez (cbf_find_category (handle, equipment))
+        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
+        cbf_failnez (cbf_find_row      (handle, diffrn_id))
+        cbf_failnez (cbf_find_column   (handle, "id"))
+        cbf_failnez (cbf_get_value     (handle, &id))
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (target_axis,(*goniometer)->axis[index].name)== 0)
-                    {
+        cbf_failnez (cbf_find_category (handle, category))
 
-                        (*goniometer)->axis[axis_index].depends_on_index = index;
+        if (cbf_find_column (handle, column))
 
-                        found = 1;
+            cbf_failnez (cbf_find_column (handle, "id"))
 
-                        (*goniometer)->axis[index].depdepth
-                        = cbf_max( (*goniometer)->axis[index].depdepth,
-                                  (*goniometer)->axis[axis_index].depdepth+1);
+        for (row = 0; !cbf_select_row (handle, row); row++)
+        {
+            cbf_failnez (cbf_get_value (handle, &this_id))
 
+            if (this_id && cbf_cistrcmp (id, this_id) == 0)
 
-                        break;
+                (*count)++;
+        }
 
-                    }
+        return 0;
+    }
 
-                }
 
-                if (!found) {
+    /* Read the start and increment of the first axes of a positioner for
+       every frame of a scan in one pass through diffrn_scan_frame_axis,
+       falling back to diffrn_scan_axis as cbf_get_frame_axis_setting does */
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          *goniometer,
-                                                          target_axis, 2);
+    static int cbf_read_scan_settings (cbf_handle      handle,
+                                       cbf_positioner  positioner,
+                                       size_t          axes,
+                                       char          **frame_id,
+                                       size_t          frames,
+                                       double         *settings)
+    {
+        unsigned char *found;
 
-                    (*goniometer)->axis[axis_index].depends_on_index
-                    = (*goniometer)->axes-1;
+        const char *this_frame, *this_axis, *column [2];
 
-                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
-                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
-                              (*goniometer)->axis[axis_index].depdepth+1);
+        unsigned int row;
 
+        size_t frame, axis, hint, k;
 
-                    if (!errorcode) break;
+        int errorcode;
 
-                }
+        if (!axes || !frames)
 
-            }
+            return 0;
 
-            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+        cbf_failnez (cbf_alloc ((void **) &found, NULL, 1, frames * axes))
 
-                found = 0;
+        memset (found, 0, frames * axes);
 
-                for (index = 0; index < (*goniometer)->axes; index++) {
+        memset (settings, 0, 2 * frames * axes * sizeof (double));
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (rotation_axis,(*goniometer)->axis[index].name)== 0)
-                    {
+        errorcode = 0;
 
-                        (*goniometer)->axis[axis_index].rotation_axis_index = index;
 
-                        found = 1;
+        /* Take the first row for each frame and axis */
 
-                        (*goniometer)->axis[index].depdepth
-                        = cbf_max( (*goniometer)->axis[index].depdepth,
-                                  (*goniometer)->axis[axis_index].depdepth+1);
+        if (!cbf_find_category (handle, "diffrn_scan_frame_axis") &&
+            !cbf_find_column   (handle, "frame_id") &&
+            !cbf_find_column   (handle, "axis_id"))
+        {
+            hint = 0;
 
+            for (row = 0; !cbf_select_row (handle, row); row++)
+            {
+                if (cbf_find_column (handle, "frame_id") ||
+                    cbf_get_value (handle, &this_frame) || !this_frame ||
+                    cbf_find_column (handle, "axis_id") ||
+                    cbf_get_value (handle, &this_axis) || !this_axis)
 
-                        break;
+                    continue;
 
-                    }
+                for (axis = 0; axis < axes; axis++)
 
-                }
+                    if (positioner->axis [axis].type != CBF_GENERAL_AXIS &&
+                        cbf_cistrcmp (this_axis, positioner->axis [axis].name) == 0)
 
-                if (!found) {
+                        break;
 
+                if (axis == axes)
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          *goniometer,
-                                                          rotation_axis, 2);
+                    continue;
 
-                    (*goniometer)->axis[axis_index].rotation_axis_index
-                    = (*goniometer)->axes-1;
 
-                    (*goniometer)->axis[(*goniometer)->axes-1].depdepth
-                    = cbf_max( (*goniometer)->axis[(*goniometer)->axes-1].depdepth,
-                              (*goniometer)->axis[axis_index].depdepth+1);
+                    /* The rows are normally grouped by frame */
 
+                for (k = 0; k < frames; k++)
+                {
+                    frame = (hint + k) % frames;
 
-                    if (!errorcode) break;
+                    if (cbf_cistrcmp (this_frame, frame_id [frame]) == 0)
 
+                        break;
                 }
 
-            }
+                if (k == frames)
 
-            axis_index++;
+                    continue;
 
-        } while (axis_index < (*goniometer)->axes);
+                hint = frame;
 
+                if (found [frame * axes + axis])
 
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (*goniometer);
+                    continue;
 
-            *goniometer = NULL;
-        }
+                found [frame * axes + axis] = 4;
 
-        return errorcode;
-    }
+                if (positioner->axis [axis].type == CBF_ROTATION_AXIS)
+                {
+                    column [0] = "angle";
 
+                    column [1] = "angle_increment";
+                }
+                else
+                {
+                    column [0] = "displacement";
 
-    /* Construct a frame detector positioner */
+                    column [1] = "displacement_increment";
+                }
 
-    int cbf_construct_frame_detector (cbf_handle    handle,
-                                      cbf_detector *detector,
-                                      unsigned int  element_number,
-                                      const char *frame_id)
-    {
-        int errorcode, precedence;
+                for (k = 0; k < 2; k++)
 
-        unsigned int row, axis;
+                    if (!cbf_find_column (handle, column [k]) &&
+                        !cbf_get_doublevalue (handle, settings + 2 * (frame * axes + axis) + k))
 
-        const char *diffrn_id, *id, *this_id, *axis_id, *array_id;
-        
-        const char *array_section_id;
+                        found [frame * axes + axis] |= 1 << k;
+            }
+        }
 
-        const char * target_axis;
 
-        const char * rotation_axis;
+        /* Fill in anything missing from diffrn_scan_axis */
 
-        size_t axis_index;
+        for (axis = 0; axis < axes && !errorcode; axis++)
+        {
+            double value [2] = { 0., 0. };
 
-        const char *surface_axis [2];  /* fast, slow */
+            int missing;
 
-        double displacement [2], increment [2];
+            if (positioner->axis [axis].type == CBF_GENERAL_AXIS)
 
-        cbf_positioner positioner;
+                continue;
 
-        if (!detector)
+            for (missing = 0, frame = 0; frame < frames; frame++)
 
-            return CBF_ARGUMENT;
+                missing |= ~found [frame * axes + axis] & 3;
 
+            if (!missing)
 
-        /* Get the detector id */
+                continue;
 
-        cbf_failnez (cbf_get_diffrn_id (handle, &diffrn_id))
+            if (positioner->axis [axis].type == CBF_ROTATION_AXIS)
+            {
+                column [0] = "angle";
 
-        cbf_failnez (cbf_find_category (handle, "diffrn_detector"))
-        cbf_failnez (cbf_find_column   (handle, "diffrn_id"))
-        cbf_failnez (cbf_find_row      (handle, diffrn_id))
-        cbf_failnez (cbf_find_column   (handle, "id"))
-        cbf_failnez (cbf_get_value     (handle, &id))
+                column [1] = "angle_increment";
+            }
+            else
+            {
+                column [0] = "displacement";
 
+                column [1] = "displacement_increment";
+            }
 
-        /* Construct the detector surface */
+            errorcode = cbf_find_category (handle, "diffrn_scan_axis");
 
-        cbf_failnez (cbf_get_array_id  (handle, element_number, &array_id))
-        cbf_failnez (cbf_get_array_section_id  (handle, element_number, &array_section_id))
-        cbf_failnez (cbf_find_category (handle, "array_structure_list"))
-        if (cbf_find_column(handle,"array_section_id")) {
-            if (cbf_find_column(handle,"array_id")) {
-                cbf_failnez (cbf_find_column   (handle, "array_section"));
-            }
-        }
+            if (!errorcode)
 
-        surface_axis [0] = surface_axis [1] = NULL;
+                errorcode = cbf_find_column (handle, "axis_id");
 
-        while (cbf_find_nextrow (handle, array_id) == 0)
-        {
-            cbf_failnez (cbf_find_column      (handle, "precedence"))
-            cbf_failnez (cbf_get_integervalue (handle, &precedence))
+            if (!errorcode)
 
-            if (precedence < 1 || precedence > 2)
+                errorcode = cbf_find_row (handle, positioner->axis [axis].name);
 
-                return CBF_FORMAT;
+            for (k = 0; k < 2 && !errorcode; k++)
 
-            if (surface_axis [precedence - 1])
+                if (missing & (1 << k))
+                {
+                    errorcode = cbf_find_column (handle, column [k]);
 
-                return CBF_FORMAT;
+                    if (!errorcode)
 
-            cbf_failnez (cbf_find_column (handle, "axis_set_id"))
-            cbf_failnez (cbf_get_value   (handle, &surface_axis [precedence - 1]))
-            if (cbf_find_column(handle,"array_section_id")) {
-                cbf_failnez (cbf_find_column   (handle, "array_id"));
-            }
-        }
+                        errorcode = cbf_get_doublevalue (handle, &value [k]);
+                }
 
-        if (!surface_axis [0])
+            for (frame = 0; frame < frames && !errorcode; frame++)
 
-            return CBF_FORMAT;
+                for (k = 0; k < 2; k++)
 
-        cbf_failnez (cbf_find_category   (handle, "array_structure_list_axis"))
-        cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
-        cbf_failnez (cbf_find_row        (handle, surface_axis [0]))
-        cbf_failnez (cbf_find_column     (handle, "axis_id"))
-        cbf_failnez (cbf_get_value       (handle, &surface_axis [0]))
-        cbf_failnez (cbf_find_column     (handle, "displacement"))
-        cbf_failnez (cbf_get_doublevalue (handle, &displacement [0]))
-        cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-        cbf_failnez (cbf_get_doublevalue (handle, &increment [0]))
+                    if (!(found [frame * axes + axis] & (1 << k)))
 
-        if (surface_axis [1])
-        {
-            cbf_failnez (cbf_find_column     (handle, "axis_set_id"))
-            cbf_failnez (cbf_find_row        (handle, surface_axis [1]))
-            cbf_failnez (cbf_find_column     (handle, "axis_id"))
-            cbf_failnez (cbf_get_value       (handle, &surface_axis [1]))
-            cbf_failnez (cbf_find_column     (handle, "displacement"))
-            cbf_failnez (cbf_get_doublevalue (handle, &displacement [1]))
-            cbf_failnez (cbf_find_column     (handle, "displacement_increment"))
-            cbf_failnez (cbf_get_doublevalue (handle, &increment [1]))
+                        settings [2 * (frame * axes + axis) + k] = value [k];
         }
 
+        return errorcode | cbf_free ((void **) &found, NULL);
+    }
 
-        /* Construct the positioner */
 
-        cbf_failnez (cbf_make_positioner (&positioner))
+    /* Set the frame-dependent axes of the scan positioners to a frame */
 
-        errorcode = cbf_alloc ((void **) detector, NULL,
-                               sizeof (cbf_detector_struct), 1);
+    static int cbf_load_scan_frame (cbf_scan_geometry scan, size_t frame)
+    {
+        const double *settings;
 
-        for (row = errorcode = 0; !errorcode; row++)
-        {
-            errorcode = cbf_find_category (handle, "diffrn_detector_axis");
+        size_t axis;
 
-            if (!errorcode)
-            {
-                /* allow for aliases  _diffrn_detector_axis.detector_id
-                 _diffrn_detector_axis.id  (deprecated) */
+        settings = scan->goniometer_settings + 2 * frame * scan->goniometer_axes;
 
-                errorcode = cbf_find_column (handle, "detector_id");
+        for (axis = 0; axis < scan->goniometer_axes; axis++)
+        {
+            scan->goniometer->axis [axis].start = settings [2 * axis];
 
-                if (errorcode)
+            scan->goniometer->axis [axis].increment = settings [2 * axis + 1];
+        }
 
-                    errorcode = cbf_find_column (handle, "id");
-            }
+        settings = scan->detector_settings + 2 * frame * scan->detector_axes;
 
-            if (!errorcode)
-            {
-                errorcode = cbf_select_row (handle, row);
+        for (axis = 0; axis < scan->detector_axes; axis++)
+        {
+            scan->detector->positioner->axis [axis].start = settings [2 * axis];
 
-                if (errorcode == CBF_NOTFOUND)
-                {
-                    errorcode = 0;
+            scan->detector->positioner->axis [axis].increment = settings [2 * axis + 1];
+        }
 
-                    break;
-                }
-            }
+        return cbf_update_pixel (scan->detector, 0, 0);
+    }
 
-            if (!errorcode)
 
-                errorcode = cbf_get_value (handle, &this_id);
+    /* Construct the geometry of every frame of a scan.  The goniometer and
+       detector positioner matrices are calculated once for each frame at
+       the given ratio, so that later per-frame lookups need not read the
+       diffrn_scan_frame_axis rows again */
 
-            if (!errorcode)
+    int cbf_construct_scan_geometry (cbf_handle         handle,
+                                     cbf_scan_geometry *scan,
+                                     unsigned int       element_number,
+                                     double             ratio)
+    {
+        cbf_scan_geometry geometry;
 
-                if (cbf_cistrcmp (id, this_id) == 0)
-                {
-                    errorcode = cbf_find_column (handle, "axis_id");
+        const char *frame_id;
 
-                    if (!errorcode)
+        unsigned int rows, row;
 
-                        errorcode = cbf_get_value (handle, &axis_id);
+        size_t frames, frame;
 
-                    if (!errorcode)
+        int errorcode;
 
-                        errorcode = cbf_read_positioner_frame_axis (handle, 0,
-                                                                    positioner,
-                                                                    axis_id,
-                                                                    frame_id,
-                                                                    1);
-                }
-        }
+        if (!handle || !scan)
 
+            return CBF_ARGUMENT;
 
-        /* Add the surface axes */
+        *scan = NULL;
 
-        if (!errorcode)
+        cbf_failnez (cbf_alloc ((void **) &geometry, NULL,
+                                sizeof (cbf_scan_geometry_struct), 1))
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [0], 0);
+        geometry->ratio = ratio;
 
-        if (!errorcode && surface_axis [1])
 
-            errorcode = cbf_read_positioner_axis (handle, 0, positioner,
-                                                  surface_axis [1], 0);
+        /* List the frames in the order of diffrn_scan_frame */
 
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (positioner);
+        rows = 0;
 
-            return errorcode | cbf_free ((void **) detector, NULL);
-        }
+        errorcode = cbf_find_category (handle, "diffrn_scan_frame");
 
-        /* Complete the connectivity of the positioner */
+        if (!errorcode)
 
-        axis_index = 0;
+            errorcode = cbf_find_column (handle, "frame_id");
 
-        do {
+        if (!errorcode)
 
-            size_t index;
+            errorcode = cbf_count_rows (handle, &rows);
 
-            int found;
+        if (!errorcode && !rows)
 
-            target_axis = positioner->axis[axis_index].depends_on;
+            errorcode = CBF_NOTFOUND;
 
-            rotation_axis = positioner->axis[axis_index].rotation_axis;
+        frames = rows;
 
-            if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+        if (!errorcode)
 
-                found = 0;
+            errorcode = cbf_alloc ((void **) &geometry->frame_id, NULL,
+                                   sizeof (char *), frames);
 
-                for (index = 0; index < positioner->axes; index++) {
+        if (!errorcode)
+        {
+            memset (geometry->frame_id, 0, frames * sizeof (char *));
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (target_axis,positioner->axis[index].name)== 0)
+            geometry->frames = frames;
+        }
+
+        for (row = 0; row < rows && !errorcode; row++)
         {
+            errorcode = cbf_select_row (handle, row);
 
-                        positioner->axis[axis_index].depends_on_index = index;
+            if (!errorcode)
 
-                        found = 1;
+                errorcode = cbf_get_value (handle, &frame_id);
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
+            if (!errorcode && !frame_id)
 
+                errorcode = CBF_FORMAT;
 
-                        break;
+            if (!errorcode)
+            {
+                geometry->frame_id [row] = (char *) cbf_copy_string (NULL, frame_id, 0);
 
+                if (!geometry->frame_id [row])
+
+                    errorcode = CBF_ALLOC;
+            }
         }
 
-                }
+        /* Construct the positioners for the first frame and find which
+           of their axes move from frame to frame */
 
-                if (!found) {
+        if (!errorcode)
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          target_axis, 2);
+            errorcode = cbf_construct_frame_goniometer (handle, &geometry->goniometer,
+                                                        geometry->frame_id [0]);
 
-                    positioner->axis[axis_index].depends_on_index
-                    = positioner->axes-1;
+        if (!errorcode)
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
+            errorcode = cbf_construct_frame_detector (handle, &geometry->detector,
+                                                      element_number,
+                                                      geometry->frame_id [0]);
 
+        if (!errorcode)
 
-                    if (!errorcode) break;
+            errorcode = cbf_count_frame_axes (handle, "diffrn_measurement",
+                                              "diffrn_measurement_axis",
+                                              "measurement_id",
+                                              &geometry->goniometer_axes);
 
-                }
+        if (!errorcode)
 
-            }
+            errorcode = cbf_count_frame_axes (handle, "diffrn_detector",
+                                              "diffrn_detector_axis",
+                                              "detector_id",
+                                              &geometry->detector_axes);
 
-            if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+        if (!errorcode &&
+            (geometry->goniometer_axes > geometry->goniometer->axes ||
+             geometry->detector_axes > geometry->detector->positioner->axes))
 
-                found = 0;
+            errorcode = CBF_FORMAT;
 
-                for (index = 0; index < positioner->axes; index++) {
 
-                    if (index != axis_index &&
-                        cbf_cistrcmp (rotation_axis,positioner->axis[index].name)== 0)
-                    {
+        /* Read the settings of every frame */
 
-                        positioner->axis[axis_index].rotation_axis_index = index;
+        if (!errorcode)
 
-                        found = 1;
+            errorcode = cbf_alloc ((void **) &geometry->goniometer_settings, NULL,
+                                   2 * sizeof (double),
+                                   frames * geometry->goniometer_axes);
 
-                        positioner->axis[index].depdepth
-                        = cbf_max( positioner->axis[index].depdepth,
-                                  positioner->axis[axis_index].depdepth+1);
+        if (!errorcode)
 
+            errorcode = cbf_alloc ((void **) &geometry->detector_settings, NULL,
+                                   2 * sizeof (double),
+                                   frames * geometry->detector_axes);
 
-                        break;
+        if (!errorcode)
 
-                    }
+            errorcode = cbf_read_scan_settings (handle, geometry->goniometer,
+                                                geometry->goniometer_axes,
+                                                geometry->frame_id, frames,
+                                                geometry->goniometer_settings);
 
-                }
+        if (!errorcode)
 
-                if (!found) {
+            errorcode = cbf_read_scan_settings (handle, geometry->detector->positioner,
+                                                geometry->detector_axes,
+                                                geometry->frame_id, frames,
+                                                geometry->detector_settings);
 
 
-                    errorcode = cbf_read_positioner_axis (handle,
-                                                          0, /* reserved */
-                                                          positioner,
-                                                          rotation_axis, 2);
+        /* Calculate the matrices */
 
-                    positioner->axis[axis_index].rotation_axis_index
-                    = positioner->axes-1;
+        if (!errorcode)
 
-                    positioner->axis[positioner->axes-1].depdepth
-                    = cbf_max( positioner->axis[positioner->axes-1].depdepth,
-                              positioner->axis[axis_index].depdepth+1);
+            errorcode = cbf_alloc ((void **) &geometry->goniometer_matrix, NULL,
+                                   sizeof (double [3][4]), frames);
 
+        if (!errorcode)
 
-                    if (!errorcode) break;
+            errorcode = cbf_alloc ((void **) &geometry->detector_matrix, NULL,
+                                   sizeof (double [3][4]), frames);
 
-                }
+        for (frame = 0; frame < frames && !errorcode; frame++)
+        {
+            errorcode = cbf_load_scan_frame (geometry, frame);
 
-            }
+            if (!errorcode)
 
-            axis_index++;
+                errorcode = cbf_calculate_position (geometry->goniometer, 0, ratio,
+                                                    0, 0, 0, NULL, NULL, NULL);
 
-        } while (axis_index < positioner->axes);
+            if (!errorcode)
 
-        /* Insert the cbf handle and element into the dectector */
+                errorcode = cbf_calculate_position (geometry->detector->positioner, 0, ratio,
+                                                    0, 0, 0, NULL, NULL, NULL);
 
-        (*detector)->handle = handle;
+            if (!errorcode)
+            {
+                memcpy (geometry->goniometer_matrix [frame], geometry->goniometer->matrix,
+                        sizeof (double [3][4]));
 
-        (*detector)->element = element_number;
+                memcpy (geometry->detector_matrix [frame], geometry->detector->positioner->matrix,
+                        sizeof (double [3][4]));
+            }
+        }
 
+        if (errorcode)
 
-        /* Copy the start and increment values into the surface axes */
+            return errorcode | cbf_free_scan_geometry (geometry);
 
-        (*detector)->displacement [0] = displacement [0];
-        (*detector)->displacement [1] = displacement [1];
+        *scan = geometry;
 
-        (*detector)->increment [0] = increment [0];
-        (*detector)->increment [1] = increment [1];
+        return 0;
+    }
 
-        if (surface_axis [1])
 
-            (*detector)->axes = 2;
+    /* Free a scan geometry */
 
-        else
+    int cbf_free_scan_geometry (cbf_scan_geometry scan)
+    {
+        int errorcode = 0;
 
-            (*detector)->axes = 1;
+        size_t frame;
 
-        for (axis = 0; axis < (*detector)->axes; axis++)
+        void *memblock;
 
-            for (row = 0; row < positioner->axes; row++)
+        memblock = (void *) scan;
 
-                if (cbf_cistrcmp (positioner->axis [row].name,
-                                  surface_axis [axis]) == 0)
-                {
-                    (*detector)->index [axis] = row;
+        if (scan)
+        {
+            if (scan->frame_id)
 
-                    positioner->axis [row].increment = 0;
+                for (frame = 0; frame < scan->frames; frame++)
 
-                    break;
-                }
+                    errorcode |= cbf_free ((void **) &scan->frame_id [frame], NULL);
 
-        (*detector)->positioner = positioner;
+            errorcode |= cbf_free ((void **) &scan->frame_id, NULL);
 
-        return 0;
-    }
+            errorcode |= cbf_free_goniometer (scan->goniometer);
 
-    /* construct a positioner for a given final axis */
+            errorcode |= cbf_free_detector (scan->detector);
 
-    int cbf_construct_frame_positioner (cbf_handle handle,
-                                        cbf_positioner *positioner,
-                                        const char *axis_id,
-                                        const char *frame_id)
-    {
+            errorcode |= cbf_free ((void **) &scan->goniometer_settings, NULL);
 
-        int errorcode;
+            errorcode |= cbf_free ((void **) &scan->detector_settings, NULL);
 
-        const char * target_axis;
+            errorcode |= cbf_free ((void **) &scan->goniometer_matrix, NULL);
 
-        const char * rotation_axis;
+            errorcode |= cbf_free ((void **) &scan->detector_matrix, NULL);
+        }
 
-        size_t axis_index;
+        return errorcode | cbf_free (&memblock, NULL);
+    }
 
-        unsigned int axis_index_limit;
 
-        if (!positioner || !axis_id)
+    /* Get the number of frames in a scan */
+
+    int cbf_get_scan_frames (cbf_scan_geometry scan, size_t *frames)
+    {
+        if (!scan || !frames)
 
             return CBF_ARGUMENT;
 
-        /* fprintf(stderr," cbf_construct_positioner, axis %s\n",axis_id);*/
+        *frames = scan->frames;
 
-        errorcode = 0;
+        return 0;
+    }
 
 
-        /* Construct the positioner */
+    /* Find the number of a frame in a scan from its frame_id */
 
-        cbf_failnez (cbf_make_positioner (positioner));
+    int cbf_find_scan_frame (cbf_scan_geometry scan, const char *frame_id,
+                             size_t *frame)
+    {
+        size_t i;
 
-        /* Set a limit on the number of axes in the positioner
+        if (!scan || !frame_id || !frame)
 
-         As a crude limit to break dependency loops, N*(N-1)/2
+            return CBF_ARGUMENT;
 
-         will suffice.
+        for (i = 0; i < scan->frames; i++)
 
-         */
+            if (scan->frame_id [i] && cbf_cistrcmp (frame_id, scan->frame_id [i]) == 0)
+            {
+                *frame = i;
 
-        cbf_failnez(cbf_find_category(handle,"axis"));
+                return 0;
+            }
 
-        cbf_failnez(cbf_count_rows(handle,&axis_index_limit));
+        return CBF_NOTFOUND;
+    }
 
-        axis_index_limit *= (axis_index_limit-1);
 
-        axis_index_limit /= 2;
+    /* Get the goniometer and detector positioner matrices of a frame.
+       The detector matrix places pixel (0, 0) */
 
-        (*positioner)->axis_index_limit = axis_index_limit;
+    int cbf_get_scan_frame_matrices (cbf_scan_geometry scan, size_t frame,
+                                     double goniometer_matrix [3][4],
+                                     double detector_matrix [3][4])
+    {
+        if (!scan || frame >= scan->frames)
 
-        /* read the first axis */
+            return CBF_ARGUMENT;
 
-            errorcode = cbf_read_positioner_frame_axis (handle,
-                                                        0, /* reserved */
-                                                        *positioner,
-                                                    axis_id,
-                                                        frame_id, 2);
+        if (goniometer_matrix)
 
-        axis_index = 0;
+            memcpy (goniometer_matrix, scan->goniometer_matrix [frame],
+                    sizeof (double [3][4]));
 
-            if (!errorcode) {
+        if (detector_matrix)
 
-            do{
+            memcpy (detector_matrix, scan->detector_matrix [frame],
+                    sizeof (double [3][4]));
 
-                target_axis = (*positioner)->axis[axis_index].depends_on;
+        return 0;
+    }
 
-                rotation_axis = (*positioner)->axis[axis_index].rotation_axis;
 
-                if (target_axis && cbf_cistrcmp (target_axis,".") !=0 ) {
+    /* Set the goniometer and detector of a scan to a frame.  The
+       positioners belong to the scan and must not be freed; their
+       matrices are taken from the table, so the functions that use them
+       at the ratio of the scan do not recalculate them */
 
-                    errorcode = cbf_read_positioner_frame_axis (handle,
-                                                          0, /* reserved */
-                                                          *positioner,
-                                                          target_axis,
-                                                          frame_id, 2);
+    int cbf_set_scan_frame (cbf_scan_geometry scan, size_t frame,
+                            cbf_goniometer *goniometer,
+                            cbf_detector *detector)
+    {
+        cbf_positioner positioner [2];
 
-                    (*positioner)->axis[axis_index].depends_on_index
-                    = (*positioner)->axes-1;
+        double (*matrix [2]) [4];
 
-                    (*positioner)->axis[(*positioner)->axes-1].depdepth
-                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
-                              (*positioner)->axis[axis_index].depdepth+1);
+        size_t i, axis;
 
-                    if (!errorcode) break;
+        if (!scan || frame >= scan->frames)
 
-            }
+            return CBF_ARGUMENT;
 
-                if (rotation_axis && cbf_cistrcmp (rotation_axis,".") !=0 ) {
+        cbf_failnez (cbf_load_scan_frame (scan, frame))
 
-                    errorcode = cbf_read_positioner_frame_axis (handle,
-                                                          0, /* reserved */
-                                                          *positioner,
-                                                          rotation_axis,
-                                                          frame_id, 2);
+        positioner [0] = scan->goniometer;
 
-                    (*positioner)->axis[axis_index].rotation_axis_index
-                    = (*positioner)->axes-1;
+        positioner [1] = scan->detector->positioner;
 
-                    (*positioner)->axis[(*positioner)->axes-1].depdepth
-                    = cbf_max( (*positioner)->axis[(*positioner)->axes-1].depdepth,
-                              (*positioner)->axis[axis_index].depdepth+1);
+        matrix [0] = scan->goniometer_matrix [frame];
 
+        matrix [1] = scan->detector_matrix [frame];
 
-                    if (!errorcode) break;
+        for (i = 0; i < 2; i++)
+        {
+            for (axis = 0; axis < positioner [i]->axes; axis++)
 
-        }
+                positioner [i]->axis [axis].setting =
+                    positioner [i]->axis [axis].start + scan->ratio *
+                    positioner [i]->axis [axis].increment;
 
-                axis_index++;
+            memcpy (positioner [i]->matrix, matrix [i], sizeof (double [3][4]));
 
-            } while (axis_index < (*positioner)->axes);
+            positioner [i]->matrix_ratio_used = scan->ratio;
 
+            positioner [i]->matrix_is_valid = 1;
         }
 
-        if (errorcode)
-        {
-            errorcode |= cbf_free_positioner (*positioner);
+        if (goniometer)
 
-            *positioner = NULL;
-        }
+            *goniometer = scan->goniometer;
 
-        return errorcode;
+        if (detector)
+
+            *detector = scan->detector;
+
+        return 0;
     }
     
     /*  For a given axis, return the first element_id
@@ -0,0 +1,1410 @@
+/**********************************************************************
+ * cbf_spots.c -- search decoded frames for diffraction spots         *
+ *                                                                    *
+ *                      Part of the CBFlib API                        *
+ *                              by                                    *
+ *                          Paul Ellis and                            *
+ *         Herbert J. Bernstein (yaya@bernstein-plus-sons.com)        *
+ *                                                                    *
+ **********************************************************************/
+
+
+/**********************************************************************
+ *                                                                    *
+ * YOU MAY REDISTRIBUTE THE CBFLIB PACKAGE UNDER THE TERMS OF THE GPL *
+ *                                                                    *
+ * ALTERNATIVELY YOU MAY REDISTRIBUTE THE CBFLIB API UNDER THE TERMS  *
+ * OF THE LGPL                                                        *
+ *                                                                    *
+ **********************************************************************/
+
+/*************************** GPL NOTICES ******************************
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * (the License, or (at your option) any later version.               *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, write to the Free Software        *
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA           *
+ * 02111-1307  USA                                                    *
+ *                                                                    *
+ **********************************************************************/
+
+/************************* LGPL NOTICES *******************************
+ *                                                                    *
+ * This library is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU Lesser General Public         *
+ * License as published by the Free Software Foundation; either       *
+ * version 2.1 of the License, or (at your option) any later version. *
+ *                                                                    *
+ * This library is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ * Lesser General Public License for more details.                    *
+ *                                                                    *
+ * You should have received a copy of the GNU Lesser General Public   *
+ * License along with this library; if not, write to the Free         *
+ * Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,    *
+ * MA  02110-1301  USA                                                *
+ *                                                                    *
+ **********************************************************************/
+
+/**********************************************************************
+ *                                                                    *
+ *                    Stanford University Notices                     *
+ *  for the CBFlib software package that incorporates SLAC software   *
+ *                 on which copyright is disclaimed                   *
+ *                                                                    *
+ * This software                                                      *
+ * -------------                                                      *
+ * The term ‘this software’, as used in these Notices, refers to      *
+ * those portions of the software package CBFlib that were created by *
+ * employees of the Stanford Linear Accelerator Center, Stanford      *
+ * University.                                                        *
+ *                                                                    *
+ * Stanford disclaimer of copyright                                   *
+ * --------------------------------                                   *
+ * Stanford University, owner of the copyright, hereby disclaims its  *
+ * copyright and all other rights in this software.  Hence, anyone    *
+ * may freely use it for any purpose without restriction.             *
+ *                                                                    *
+ * Acknowledgement of sponsorship                                     *
+ * ------------------------------                                     *
+ * This software was produced by the Stanford Linear Accelerator      *
+ * Center, Stanford University, under Contract DE-AC03-76SFO0515 with *
+ * the Department of Energy.                                          *
+ *                                                                    *
+ * Government disclaimer of liability                                 *
+ * ----------------------------------                                 *
+ * Neither the United States nor the United States Department of      *
+ * Energy, nor any of their employees, makes any warranty, express or *
+ * implied, or assumes any legal liability or responsibility for the  *
+ * accuracy, completeness, or usefulness of any data, apparatus,      *
+ * product, or process disclosed, or represents that its use would    *
+ * not infringe privately owned rights.                               *
+ *                                                                    *
+ * Stanford disclaimer of liability                                   *
+ * --------------------------------                                   *
+ * Stanford University makes no representations or warranties,        *
+ * express or implied, nor assumes any liability for the use of this  *
+ * software.                                                          *
+ *                                                                    *
+ * Maintenance of notices                                             *
+ * ----------------------                                             *
+ * In the interest of clarity regarding the origin and status of this *
+ * software, this and all the preceding Stanford University notices   *
+ * are to remain affixed to any copy or derivative of this software   *
+ * made or distributed by the recipient and are to be affixed to any  *
+ * copy of software made or distributed by the recipient that         *
+ * contains a copy or derivative of this software.                    *
+ *                                                                    *
+ * Based on SLAC Software Notices, Set 4                              *
+ * OTT.002a, 2004 FEB 03                                              *
+ **********************************************************************/
+
+
+
+/**********************************************************************
+ *                               NOTICE                               *
+ * Creative endeavors depend on the lively exchange of ideas. There   *
+ * are laws and customs which establish rights and responsibilities   *
+ * for authors and the users of what authors create.  This notice     *
+ * is not intended to prevent you from using the software and         *
+ * documents in this package, but to ensure that there are no         *
+ * misunderstandings about terms and conditions of such use.          *
+ *                                                                    *
+ * Please read the following notice carefully.  If you do not         *
+ * understand any portion of this notice, please seek appropriate     *
+ * professional legal advice before making use of the software and    *
+ * documents included in this software package.  In addition to       *
+ * whatever other steps you may be obliged to take to respect the     *
+ * intellectual property rights of the various parties involved, if   *
+ * you do make use of the software and documents in this package,     *
+ * please give credit where credit is due by citing this package,     *
+ * its authors and the URL or other source from which you obtained    *
+ * it, or equivalent primary references in the literature with the    *
+ * same authors.                                                      *
+ *                                                                    *
+ * Some of the software and documents included within this software   *
+ * package are the intellectual property of various parties, and      *
+ * placement in this package does not in any way imply that any       *
+ * such rights have in any way been waived or diminished.             *
+ *                                                                    *
+ * With respect to any software or documents for which a copyright    *
+ * exists, ALL RIGHTS ARE RESERVED TO THE OWNERS OF SUCH COPYRIGHT.   *
+ *                                                                    *
+ * Even though the authors of the various documents and software      *
+ * found here have made a good faith effort to ensure that the        *
+ * documents are correct and that the software performs according     *
+ * to its documentation, and we would greatly appreciate hearing of   *
+ * any problems you may encounter, the programs and documents any     *
+ * files created by the programs are provided **AS IS** without any   *
+ * warranty as to correctness, merchantability or fitness for any     *
+ * particular or general use.                                         *
+ *                                                                    *
+ * THE RESPONSIBILITY FOR ANY ADVERSE CONSEQUENCES FROM THE USE OF    *
+ * PROGRAMS OR DOCUMENTS OR ANY FILE OR FILES CREATED BY USE OF THE   *
+ * PROGRAMS OR DOCUMENTS LIES SOLELY WITH THE USERS OF THE PROGRAMS   *
+ * OR DOCUMENTS OR FILE OR FILES AND NOT WITH AUTHORS OF THE          *
+ * PROGRAMS OR DOCUMENTS.                                             *
+ **********************************************************************/
+
+/**********************************************************************
+ *                                                                    *
+ *                           The IUCr Policy                          *
+ *      for the Protection and the Promotion of the STAR File and     *
+ *     CIF Standards for Exchanging and Archiving Electronic Data     *
+ *                                                                    *
+ * Overview                                                           *
+ *                                                                    *
+ * The Crystallographic Information File (CIF)[1] is a standard for   *
+ * information interchange promulgated by the International Union of  *
+ * Crystallography (IUCr). CIF (Hall, Allen & Brown, 1991) is the     *
+ * recommended method for submitting publications to Acta             *
+ * Crystallographica Section C and reports of crystal structure       *
+ * determinations to other sections of Acta Crystallographica         *
+ * and many other journals. The syntax of a CIF is a subset of the    *
+ * more general STAR File[2] format. The CIF and STAR File approaches *
+ * are used increasingly in the structural sciences for data exchange *
+ * and archiving, and are having a significant influence on these     *
+ * activities in other fields.                                        *
+ *                                                                    *
+ * Statement of intent                                                *
+ *                                                                    *
+ * The IUCr's interest in the STAR File is as a general data          *
+ * interchange standard for science, and its interest in the CIF,     *
+ * a conformant derivative of the STAR File, is as a concise data     *
+ * exchange and archival standard for crystallography and structural  *
+ * science.                                                           *
+ *                                                                    *
+ * Protection of the standards                                        *
+ *                                                                    *
+ * To protect the STAR File and the CIF as standards for              *
+ * interchanging and archiving electronic data, the IUCr, on behalf   *
+ * of the scientific community,                                       *
+ *                                                                    *
+ * * holds the copyrights on the standards themselves,                *
+ *                                                                    *
+ * * owns the associated trademarks and service marks, and            *
+ *                                                                    *
+ * * holds a patent on the STAR File.                                 *
+ *                                                                    *
+ * These intellectual property rights relate solely to the            *
+ * interchange formats, not to the data contained therein, nor to     *
+ * the software used in the generation, access or manipulation of     *
+ * the data.                                                          *
+ *                                                                    *
+ * Promotion of the standards                                         *
+ *                                                                    *
+ * The sole requirement that the IUCr, in its protective role,        *
+ * imposes on software purporting to process STAR File or CIF data    *
+ * is that the following conditions be met prior to sale or           *
+ * distribution.                                                      *
+ *                                                                    *
+ * * Software claiming to read files written to either the STAR       *
+ * File or the CIF standard must be able to extract the pertinent     *
+ * data from a file conformant to the STAR File syntax, or the CIF    *
+ * syntax, respectively.                                              *
+ *                                                                    *
+ * * Software claiming to write files in either the STAR File, or     *
+ * the CIF, standard must produce files that are conformant to the    *
+ * STAR File syntax, or the CIF syntax, respectively.                 *
+ *                                                                    *
+ * * Software claiming to read definitions from a specific data       *
+ * dictionary approved by the IUCr must be able to extract any        *
+ * pertinent definition which is conformant to the dictionary         *
+ * definition language (DDL)[3] associated with that dictionary.      *
+ *                                                                    *
+ * The IUCr, through its Committee on CIF Standards, will assist      *
+ * any developer to verify that software meets these conformance      *
+ * conditions.                                                        *
+ *                                                                    *
+ * Glossary of terms                                                  *
+ *                                                                    *
+ * [1] CIF:  is a data file conformant to the file syntax defined     *
+ * at http://www.iucr.org/iucr-top/cif/spec/index.html                *
+ *                                                                    *
+ * [2] STAR File:  is a data file conformant to the file syntax       *
+ * defined at http://www.iucr.org/iucr-top/cif/spec/star/index.html   *
+ *                                                                    *
+ * [3] DDL:  is a language used in a data dictionary to define data   *
+ * items in terms of "attributes". Dictionaries currently approved    *
+ * by the IUCr, and the DDL versions used to construct these          *
+ * dictionaries, are listed at                                        *
+ * http://www.iucr.org/iucr-top/cif/spec/ddl/index.html               *
+ *                                                                    *
+ * Last modified: 30 September 2000                                   *
+ *                                                                    *
+ * IUCr Policy Copyright (C) 2000 International Union of              *
+ * Crystallography                                                    *
+ **********************************************************************/
+
+/*=======================================================================
+ * All files in the distribution of the DPS system are Copyright
+ * 1996 by the Computational Biology group in the Department of Biological
+ * Sciences at Purdue University.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms are permitted
+ * provided that this entire copyright notice is duplicated in all such
+ * copies, and that any documentation, announcements, and other materials
+ * related to such distribution and use acknowledge that the software was
+ * developed by the Computational Biology group in the Department of
+ * Biological Sciences at Purdue University, W. Lafayette, IN by Ingo
+ * Steller and Michael G. Rossmann. No charge may be made for copies,
+ * derivations, or distributions of this material without the express
+ * written consent of the copyright holder.  Neither the name of the
+ * University nor the names of the authors may be used to endorse or
+ * promote products derived from this material without specific prior
+ * written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND WITHOUT ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, WITHOUT LIMITATION, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR ANY PARTICULAR PURPOSE.
+ *======================================================================*/
+
+/* The search below is the DPS peak search of examples/dps_peaksearch.c,
+ * reworked to take any integer frame with an optional mask and to run
+ * over bands of rows in parallel.
+ */
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+#include "cbf.h"
+#include "cbf_alloc.h"
+#include "cbf_spots.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+    /* Value given to masked pixels; it is below any min_value, so
+       boxes that hold a masked pixel are never accepted */
+
+#define CBF_SPOT_MASKED INT_MIN
+
+    /* Scan rows in each band searched by one thread */
+
+#define CBF_SPOT_BAND 64
+
+
+    /* A spot with the scan row it was found from */
+
+    typedef struct
+    {
+        cbf_spot spot;
+
+        int row;
+    }
+    cbf_spot_found;
+
+
+    /* The spots found in one band */
+
+    typedef struct
+    {
+        cbf_spot_found * found;
+
+        size_t count, size;
+    }
+    cbf_spot_list;
+
+
+    /* The rows row0 to row0+nrows-1 of a frame nx x ny, as ints */
+
+    typedef struct
+    {
+        const int * data;
+
+        int nx, ny, row0, nrows;
+    }
+    cbf_spot_band;
+
+
+    /* Search parameters */
+
+    typedef struct
+    {
+        int step, small_step, min_value, overload;
+
+        double noise_thresh;
+    }
+    cbf_spot_params;
+
+
+#define cbf_spot_pixel(band,x,y) \
+    ((band)->data[(size_t)((y)-(band)->row0)*(band)->nx+(x)])
+
+
+    /* Round to the nearest integer, halves away from zero */
+
+    static int cbf_spot_rint(double x)
+    {
+        if (x == (int)x)
+
+            return (int)x;
+
+        if (x > 0.0)
+
+            return (int)(x+0.5);
+
+        return (int)(x-0.5);
+    }
+
+
+    /* Convert rows row0 to row1-1 of an image to ints, marking masked
+       pixels and the 0xFFFC-0xFFFE flags of unsigned 16-bit frames */
+
+    static void cbf_spot_convert(const void * image, size_t elsize, int elsign,
+                                 const unsigned char * mask,
+                                 int nx, int row0, int row1, int * data)
+    {
+        size_t index, first, last;
+
+        first = (size_t)row0*nx;
+
+        last = (size_t)row1*nx;
+
+        for (index = first; index < last; index++)
+        {
+            int value;
+
+            if (elsize == 1)
+
+                value = elsign? ((const signed char *)image)[index]:
+                                ((const unsigned char *)image)[index];
+
+            else if (elsize == 2)
+            {
+                if (elsign)
+
+                    value = ((const short *)image)[index];
+
+                else
+                {
+                    value = ((const unsigned short *)image)[index];
+
+                    if (value != 0xFFFF && (value & 0xFFFC) == 0xFFFC)
+
+                        value = CBF_SPOT_MASKED;
+                }
+            }
+            else
+            {
+                if (elsign)
+
+                    value = ((const int *)image)[index];
+
+                else if (((const unsigned int *)image)[index] > INT_MAX)
+
+                    value = INT_MAX;
+
+                else
+
+                    value = (int)((const unsigned int *)image)[index];
+            }
+
+            if (mask && mask[index])
+
+                value = CBF_SPOT_MASKED;
+
+            data[index-first] = value;
+        }
+    }
+
+
+    /* One pass of the centre of mass of a box n x n centred on x, y;
+       masked and negative pixels carry no weight, which keeps the centre
+       inside the box */
+
+    static void cbf_spot_cmass_pass(const cbf_spot_band * band, int x, int y, int n,
+                                    double * cm_x, double * cm_y)
+    {
+        int i, j, lowy, highy;
+
+        double sum_x = 0.0, sum_y = 0.0, sum_z = 0.0;
+
+        lowy = band->row0;
+
+        highy = band->row0+band->nrows;
+
+        if (highy > band->ny)
+
+            highy = band->ny;
+
+        for (j = -n/2; j <= n/2; j++)
+        {
+            if (j+y < lowy || j+y >= highy)
+
+                continue;
+
+            for (i = -n/2; i <= n/2; i++)
+            {
+                int value;
+
+                if (i+x < 0 || i+x >= band->nx)
+
+                    continue;
+
+                value = cbf_spot_pixel(band,i+x,j+y);
+
+                if (value <= 0)
+
+                    continue;
+
+                sum_x += ((double)i+x)*value;
+
+                sum_y += ((double)j+y)*value;
+
+                sum_z += value;
+            }
+        }
+
+        if (sum_z == 0.0)
+        {
+            *cm_x = x;
+
+            *cm_y = y;
+        }
+        else
+        {
+            *cm_x = sum_x/sum_z;
+
+            *cm_y = sum_y/sum_z;
+        }
+    }
+
+
+    /* Find the centre of mass of a spot near x, y, recentring once */
+
+    static void cbf_spot_cmass(const cbf_spot_band * band, int x, int y, int n,
+                               double * cm_x, double * cm_y)
+    {
+        int cx, cy;
+
+        cbf_spot_cmass_pass(band,x,y,n,cm_x,cm_y);
+
+        cx = cbf_spot_rint(*cm_x);
+
+        cy = cbf_spot_rint(*cm_y);
+
+        if (cx != x || cy != y)
+
+            cbf_spot_cmass_pass(band,cx,cy,n,cm_x,cm_y);
+    }
+
+
+    /* Is the spot at x, y too close to the edge, or spread over too much
+       of its box?  If not, set the spot width and height */
+
+    static int cbf_spot_near_edge(const cbf_spot_band * band, int x, int y,
+                                  double back, int peak, int bmax, int bmin,
+                                  int step, int min_value,
+                                  int * width, int * height)
+    {
+        int is, it, k, n, value, smin, smax, ring [4];
+
+        double bavg;
+
+        if (x < step || x >= band->nx-step || y < step || y >= band->ny-step)
+
+            return 1;
+
+        if (bmax >= peak)
+
+            return 1;
+
+
+            /* Walk out through rings of 8*is pixels around the peak */
+
+        for (is = 1; is <= step; is++)
+        {
+            smax = INT_MIN;
+
+            smin = INT_MAX;
+
+            bavg = 0.0;
+
+            for (it = -is; it <= is; it++)
+            {
+                ring [0] = cbf_spot_pixel(band,x+it,y-is);
+
+                ring [1] = cbf_spot_pixel(band,x+it,y+is);
+
+                n = 2;
+
+                if (it > -is && it < is)
+                {
+                    ring [2] = cbf_spot_pixel(band,x-is,y+it);
+
+                    ring [3] = cbf_spot_pixel(band,x+is,y+it);
+
+                    n = 4;
+                }
+
+                for (k = 0; k < n; k++)
+                {
+                    value = ring [k];
+
+                    if (value < min_value)
+
+                        return 1;
+
+                    if (value > smax)
+
+                        smax = value;
+
+                    if (value < smin)
+
+                        smin = value;
+
+                    bavg += (double)value;
+                }
+            }
+
+            bavg /= (double)(8*is);
+
+            if ((double)smin < back/2. && smin < bmin)
+
+                return 1;
+
+            if (bavg >= back*1.1)
+
+                continue;
+
+            if (smax <= bmax)
+            {
+                *width = *height = 2*is-1;
+
+                return 0;
+            }
+        }
+
+        *width = *height = 2*step+1;
+
+        return 0;
+    }
+
+
+    /* Add a spot to a list */
+
+    static int cbf_spot_add(cbf_spot_list * list, double cm_x, double cm_y,
+                            double isigma, int width, int height, int row)
+    {
+        cbf_spot_found * found;
+
+        if (list->count == list->size)
+        {
+            size_t size = list->size? 2*list->size: 256;
+
+            found = (cbf_spot_found *)realloc(list->found, size*sizeof(cbf_spot_found));
+
+            if (!found)
+
+                return CBF_ALLOC;
+
+            list->found = found;
+
+            list->size = size;
+        }
+
+        found = list->found+list->count++;
+
+        found->spot.fast = cm_x;
+
+        found->spot.slow = cm_y;
+
+        found->spot.isigma = isigma;
+
+        found->spot.width = width;
+
+        found->spot.height = height;
+
+        found->row = row;
+
+        return 0;
+    }
+
+
+    /* Scan rows kfirst to kend-1 of a band, keeping the spots found from
+       rows kown onwards; the rows before kown only set up next_good_y */
+
+    static int cbf_spot_scan(const cbf_spot_band * band,
+                             const cbf_spot_params * params,
+                             int kfirst, int kown, int kend,
+                             int * next_good_y, cbf_spot_list * list)
+    {
+        const int step = params->step, small_step = params->small_step;
+
+        const double back_count = 8*step, spot_count = (2*step-1)*(2*step-1);
+
+        const int nx = band->nx, ny = band->ny;
+
+        int i, j, k, l, m;
+
+        for (k = kfirst; k < kend; k++)
+        {
+            j = 2*step+k*small_step;
+
+            for (i = 2*step; i < nx-2*step; i += small_step)
+            {
+                const int * p;
+
+                int value, maxval, x_max, y_max, bmi_x, bma_x, bmi_y, bma_y;
+
+                int bmax, bmin, nover, nunder, width, height, collide;
+
+                double back, spot, A, B, I, sigmaI;
+
+                const ptrdiff_t dy = (ptrdiff_t)step*nx;
+
+
+                    /* Skip this pixel if too close to prior spots */
+
+                collide = 0;
+
+                for (l = i-step; l <= i+step; l++)
+
+                    if (next_good_y[l] > j-step-1)
+                    {
+                        collide = 1;
+
+                        break;
+                    }
+
+                if (collide)
+
+                    continue;
+
+
+                    /* Is there a maximum at i, j on the coarse grid? */
+
+                p = &cbf_spot_pixel(band,i,j);
+
+                value = *p;
+
+                if (!(value > p[step]      && value > p[-step]      &&
+                      value > p[dy]        && value > p[-dy]        &&
+                      value > p[dy+step]   && value > p[dy-step]    &&
+                      value > p[step-dy]   && value > p[-step-dy]))
+
+                    continue;
+
+
+                    /* Find the maximum on the fine grid in the box around it */
+
+                maxval = value;
+
+                x_max = i;
+
+                y_max = j;
+
+                for (m = j-step; m <= j+step; m++)
+
+                    for (l = i-step; l <= i+step; l++)
+                    {
+                        p = &cbf_spot_pixel(band,l,m);
+
+                        value = *p;
+
+                        if (value >= p[1]  && value >= p[-1] &&
+                            value >= p[nx] && value >= p[-nx] &&
+                            value >= maxval)
+                        {
+                            maxval = value;
+
+                            x_max = l;
+
+                            y_max = m;
+                        }
+                    }
+
+                cbf_spot_cmass(band,x_max,y_max,2*step+1,&A,&B);
+
+                x_max = (int)(A+0.5);
+
+                y_max = (int)(B+0.5);
+
+
+                    /* Sum the background over the border of the box and
+                       the spot over the inside */
+
+                bma_y = y_max+step;
+
+                bmi_y = y_max-step;
+
+                bma_x = x_max+step;
+
+                bmi_x = x_max-step;
+
+                if (bma_y >= ny) bma_y = ny-1;
+
+                if (bma_x >= nx) bma_x = nx-1;
+
+                if (bmi_y < 0) bmi_y = 0;
+
+                if (bmi_x < 0) bmi_x = 0;
+
+                back = spot = 0.0;
+
+                bmax = INT_MIN;
+
+                bmin = INT_MAX;
+
+                nover = nunder = 0;
+
+                for (m = bmi_y; m <= bma_y; m++)
+
+                    for (l = bmi_x; l <= bma_x; l++)
+                    {
+                        value = cbf_spot_pixel(band,l,m);
+
+                        if (params->overload > 0 && value >= params->overload)
+
+                            nover++;
+
+                        if (value < params->min_value)
+
+                            nunder++;
+
+                        if (m == bma_y || m == bmi_y || l == bma_x || l == bmi_x)
+                        {
+                            back += value;
+
+                            if (value > bmax) bmax = value;
+
+                            if (value < bmin) bmin = value;
+                        }
+                        else
+
+                            spot += value;
+                    }
+
+                I = spot-back*spot_count/back_count;
+
+                sigmaI = sqrt(spot+back*spot_count/back_count);
+
+                if (!(sigmaI > 0.0) || I/sigmaI <= params->noise_thresh ||
+                    nover > 4 || nunder > 0 ||
+                    cbf_spot_near_edge(band,x_max,y_max,back/back_count,
+                                       maxval,bmax,bmin,step,params->min_value,
+                                       &width,&height))
+
+                    continue;
+
+                if (k >= kown)
+
+                    cbf_failnez(cbf_spot_add(list,A,B,I/sigmaI,width,height,j))
+
+
+                    /* Keep later scans clear of this spot */
+
+                for (l = x_max-width/2; l <= x_max+width/2; l++)
+
+                    if (next_good_y[l] < y_max+step+1)
+
+                        next_good_y[l] = y_max+step+1;
+
+                if (x_max+width/2-small_step > i)
+
+                    i = x_max+width/2-small_step;
+            }
+        }
+
+        return 0;
+    }
+
+
+    /* Search one band of scan rows */
+
+    static int cbf_spot_search_band(const void * image, size_t elsize, int elsign,
+                                    const unsigned char * mask, int nx, int ny,
+                                    const cbf_spot_params * params,
+                                    int kfirst, int kown, int kend,
+                                    cbf_spot_list * list)
+    {
+        cbf_spot_band band;
+
+        int * data, * next_good_y, halo, row1, errorcode;
+
+        halo = 4*params->step+2;
+
+        band.row0 = 2*params->step+kfirst*params->small_step-halo;
+
+        row1 = 2*params->step+(kend-1)*params->small_step+halo+1;
+
+        if (band.row0 < 0)
+
+            band.row0 = 0;
+
+        if (row1 > ny)
+
+            row1 = ny;
+
+        band.nx = nx;
+
+        band.ny = ny;
+
+        band.nrows = row1-band.row0;
+
+        data = (int *)malloc((size_t)band.nrows*nx*sizeof(int));
+
+        next_good_y = (int *)calloc(nx,sizeof(int));
+
+        if (!data || !next_good_y)
+
+            errorcode = CBF_ALLOC;
+
+        else
+        {
+            cbf_spot_convert(image,elsize,elsign,mask,nx,band.row0,row1,data);
+
+            band.data = data;
+
+            errorcode = cbf_spot_scan(&band,params,kfirst,kown,kend,next_good_y,list);
+        }
+
+        free(next_good_y);
+
+        free(data);
+
+        return errorcode;
+    }
+
+
+    /* Sort spots by decreasing I/sigma(I), then by position */
+
+    static int cbf_spot_compare(const void * lhs, const void * rhs)
+    {
+        const cbf_spot * a = (const cbf_spot *)lhs, * b = (const cbf_spot *)rhs;
+
+        if (a->isigma != b->isigma)
+
+            return a->isigma < b->isigma? 1: -1;
+
+        if (a->slow != b->slow)
+
+            return a->slow > b->slow? 1: -1;
+
+        if (a->fast != b->fast)
+
+            return a->fast > b->fast? 1: -1;
+
+        return 0;
+    }
+
+
+    /* Of each pair of overlapping spots keep the stronger, taking the
+       pairs in the order of the scan.  Spots are listed in scan order and
+       lie within reach rows of the row they were found from, so the
+       search for partners stops once the rows are too far apart */
+
+    static void cbf_spot_merge(cbf_spot_found * found, size_t count, int reach,
+                               char * dropped)
+    {
+        size_t i, j;
+
+        int maxheight = 0;
+
+        for (i = 0; i < count; i++)
+
+            if (found[i].spot.height > maxheight)
+
+                maxheight = found[i].spot.height;
+
+        for (i = 0; i < count; i++)
+        {
+            const cbf_spot * a = &found[i].spot;
+
+            for (j = i+1; !dropped[i] && j < count; j++)
+            {
+                const cbf_spot * b = &found[j].spot;
+
+                if ((double)(found[j].row-reach)-a->slow >= maxheight)
+
+                    break;
+
+                if (dropped[j])
+
+                    continue;
+
+                if (fabs(a->fast-b->fast) < (a->width+b->width)/2 &&
+                    fabs(a->slow-b->slow) < (a->height+b->height)/2)
+                {
+                    if (a->isigma > b->isigma)
+
+                        dropped[j] = 1;
+
+                    else
+
+                        dropped[i] = 1;
+                }
+            }
+        }
+    }
+
+
+    /* Search an image for spots */
+
+    int cbf_find_spots(const void          * image,
+                       size_t                elsize,
+                       int                   elsign,
+                       const unsigned char * mask,
+                       size_t                dimfast,
+                       size_t                dimslow,
+                       double                min_isigma,
+                       int                   min_spacing,
+                       int                   min_value,
+                       int                   overload,
+                       int                   threads,
+                       size_t                maxspots,
+                       cbf_spot           ** spots,
+                       size_t              * nspots)
+    {
+        cbf_spot_params params;
+
+        cbf_spot_list * lists;
+
+        cbf_spot_found * found;
+
+        char * dropped;
+
+        int * errors;
+
+        int nx, ny, nscan, nband, warm;
+
+        long band;
+
+        size_t count, kept, i;
+
+        int errorcode;
+
+        if (!image || !spots || !nspots || dimfast > INT_MAX || dimslow > INT_MAX ||
+            (elsize != 1 && elsize != 2 && elsize != 4) || threads < 0)
+
+            return CBF_ARGUMENT;
+
+        *spots = NULL;
+
+        *nspots = 0;
+
+        nx = (int)dimfast;
+
+        ny = (int)dimslow;
+
+        params.step = (min_spacing+1)/2;
+
+        if (params.step < 1)
+
+            params.step = 1;
+
+        params.small_step = params.step > 3? 3: params.step;
+
+        params.noise_thresh = min_isigma > 0? min_isigma: 1.0;
+
+        params.min_value = min_value > INT_MIN? min_value: INT_MIN+1;
+
+        params.overload = overload;
+
+        if (nx <= 4*params.step || ny <= 4*params.step)
+
+            return 0;
+
+
+            /* Split the scan rows into bands; each band first replays
+               enough of the rows before it to see the spots that reach in */
+
+        nscan = (ny-4*params.step+params.small_step-1)/params.small_step;
+
+        nband = (nscan+CBF_SPOT_BAND-1)/CBF_SPOT_BAND;
+
+        warm = (2*(5*params.step+3)+params.small_step-1)/params.small_step;
+
+        lists = (cbf_spot_list *)calloc(nband,sizeof(cbf_spot_list));
+
+        errors = (int *)calloc(nband,sizeof(int));
+
+        if (!lists || !errors)
+        {
+            free(lists);
+
+            free(errors);
+
+            return CBF_ALLOC;
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads > 0? threads: omp_get_max_threads()) if(nband > 1)
+#endif
+        for (band = 0; band < nband; band++)
+        {
+            int kown = (int)band*CBF_SPOT_BAND, kend = kown+CBF_SPOT_BAND;
+
+            if (kend > nscan)
+
+                kend = nscan;
+
+            errors[band] = cbf_spot_search_band(image,elsize,elsign,mask,nx,ny,&params,
+                                                kown > warm? kown-warm: 0,kown,kend,
+                                                lists+band);
+        }
+
+        errorcode = 0;
+
+        count = 0;
+
+        for (band = 0; band < nband; band++)
+        {
+            errorcode |= errors[band];
+
+            count += lists[band].count;
+        }
+
+
+            /* Gather the bands in scan order */
+
+        found = NULL;
+
+        dropped = NULL;
+
+        if (!errorcode && count)
+        {
+            found = (cbf_spot_found *)malloc(count*sizeof(cbf_spot_found));
+
+            dropped = (char *)calloc(count,1);
+
+            if (!found || !dropped)
+
+                errorcode = CBF_ALLOC;
+        }
+
+        if (!errorcode && count)
+        {
+            for (count = 0, band = 0; band < nband; band++)
+            {
+                if (lists[band].count)
+
+                    memcpy(found+count,lists[band].found,
+                           lists[band].count*sizeof(cbf_spot_found));
+
+                count += lists[band].count;
+            }
+
+            if (min_spacing > 0)
+
+                cbf_spot_merge(found,count,4*params.step+2,dropped);
+
+            for (kept = 0, i = 0; i < count; i++)
+
+                if (!dropped[i])
+
+                    kept++;
+
+            if (maxspots == 0 || maxspots > kept)
+
+                maxspots = kept;
+
+            errorcode = cbf_alloc((void **)spots,NULL,sizeof(cbf_spot),kept);
+
+            if (!errorcode)
+            {
+                for (kept = 0, i = 0; i < count; i++)
+
+                    if (!dropped[i])
+
+                        (*spots)[kept++] = found[i].spot;
+
+                qsort(*spots,kept,sizeof(cbf_spot),cbf_spot_compare);
+
+                *nspots = maxspots;
+            }
+        }
+
+        for (band = 0; band < nband; band++)
+
+            free(lists[band].found);
+
+        free(dropped);
+
+        free(found);
+
+        free(errors);
+
+        free(lists);
+
+        return errorcode;
+    }
+
+
+    /* Free a spot list */
+
+    int cbf_free_spots(cbf_spot ** spots)
+    {
+        return cbf_free((void **)spots,NULL);
+    }
+
+
+    /* Write a spot list to a category */
+
+    int cbf_set_spots(cbf_handle       handle,
+                      const char     * category,
+                      const cbf_spot * spots,
+                      size_t           nspots)
+    {
+        static const char * columns [] =
+            { "id", "fast", "slow", "i_over_sigma", "width", "height" };
+
+        unsigned int column;
+
+        size_t i;
+
+        if (!handle || !category || (nspots && !spots))
+
+            return CBF_ARGUMENT;
+
+        cbf_failnez(cbf_require_category(handle,category))
+
+        cbf_failnez(cbf_reset_category(handle))
+
+        for (column = 0; column < 6; column++)
+
+            cbf_failnez(cbf_new_column(handle,columns[column]))
+
+        for (i = 0; i < nspots; i++)
+        {
+            cbf_failnez(cbf_new_row(handle))
+
+            cbf_failnez(cbf_select_column(handle,0))
+
+            cbf_failnez(cbf_set_integervalue(handle,(int)(i+1)))
+
+            cbf_failnez(cbf_select_column(handle,1))
+
+            cbf_failnez(cbf_set_doublevalue(handle,"%.3f",spots[i].fast))
+
+            cbf_failnez(cbf_select_column(handle,2))
+
+            cbf_failnez(cbf_set_doublevalue(handle,"%.3f",spots[i].slow))
+
+            cbf_failnez(cbf_select_column(handle,3))
+
+            cbf_failnez(cbf_set_doublevalue(handle,"%.2f",spots[i].isigma))
+
+            cbf_failnez(cbf_select_column(handle,4))
+
+            cbf_failnez(cbf_set_integervalue(handle,spots[i].width))
+
+            cbf_failnez(cbf_select_column(handle,5))
+
+            cbf_failnez(cbf_set_integervalue(handle,spots[i].height))
+        }
+
+        return 0;
+    }
+
+
+    /* Read and decode the image of one file */
+
+    static int cbf_spot_read_frame(const char * filename, void ** image,
+                                   size_t * elsize, int * elsign,
+                                   size_t * dimfast, size_t * dimslow)
+    {
+        cbf_handle handle;
+
+        FILE * file;
+
+        unsigned int compression;
+
+        int id, elunsigned, minelement, maxelement, errorcode;
+
+        size_t elements, elements_read, dimmid, padding;
+
+        const char * byteorder;
+
+        *image = NULL;
+
+        if (!(file = fopen(filename,"rb")))
+
+            return CBF_FILEOPEN;
+
+        if ((errorcode = cbf_make_handle(&handle)))
+        {
+            fclose(file);
+
+            return errorcode;
+        }
+
+        errorcode = cbf_read_widefile(handle,file,MSG_DIGEST);
+
+        if (!errorcode)
+
+            errorcode = cbf_find_tag(handle,"_array_data.data");
+
+        if (!errorcode)
+
+            errorcode = cbf_get_integerarrayparameters_wdims_fs(handle,&compression,&id,
+                                                                elsize,elsign,&elunsigned,
+                                                                &elements,&minelement,&maxelement,
+                                                                &byteorder,dimfast,&dimmid,dimslow,
+                                                                &padding);
+
+        if (!errorcode)
+        {
+            if (*dimfast == 0) *dimfast = elements;
+
+            if (dimmid == 0) dimmid = 1;
+
+            if (*dimslow == 0) *dimslow = 1;
+
+            *dimslow *= dimmid;
+
+            if (*dimfast * *dimslow != elements)
+
+                errorcode = CBF_FORMAT;
+        }
+
+        if (!errorcode)
+        {
+            if (*elsize != 1 && *elsize != 2 && *elsize != 4)
+            {
+                *elsize = 4;
+
+                *elsign = 1;
+            }
+
+            errorcode = cbf_alloc(image,NULL,*elsize,elements);
+        }
+
+        if (!errorcode)
+
+            errorcode = cbf_get_integerarray(handle,&id,*image,*elsize,*elsign,
+                                             elements,&elements_read);
+
+        if (!errorcode && elements_read != elements)
+
+            errorcode = CBF_ENDOFDATA;
+
+        if (errorcode)
+
+            cbf_free(image,NULL);
+
+        errorcode |= cbf_free_handle(handle);
+
+        return errorcode;
+    }
+
+
+    /* Search the images of a series of files for spots */
+
+    int cbf_find_series_spots(const char * const  * filenames,
+                              size_t                nframes,
+                              const unsigned char * mask,
+                              size_t                maskfast,
+                              size_t                maskslow,
+                              double                min_isigma,
+                              int                   min_spacing,
+                              int                   min_value,
+                              int                   overload,
+                              size_t                maxspots,
+                              int                   inflight,
+                              cbf_spot_sink         sink,
+                              void                * context)
+    {
+        long frame;
+
+        int errorcode;
+
+        if (!filenames || !sink || inflight < 0)
+
+            return CBF_ARGUMENT;
+
+        errorcode = 0;
+
+
+            /* Each frame is read, decoded and searched by one thread, and
+               handed on in order; a thread that finishes early waits for
+               the frames before its own, which bounds the frames in flight */
+
+#ifdef _OPENMP
+#pragma omp parallel for ordered schedule(dynamic,1) num_threads(inflight > 0? inflight: omp_get_max_threads()) if(nframes > 1)
+#endif
+        for (frame = 0; frame < (long)nframes; frame++)
+        {
+            void * image = NULL;
+
+            cbf_spot * spots = NULL;
+
+            size_t elsize, dimfast, dimslow, nspots = 0;
+
+            int elsign, stop, error;
+
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+            stop = errorcode;
+
+            error = 0;
+
+            if (!stop)
+            {
+                error = cbf_spot_read_frame(filenames[frame],&image,&elsize,&elsign,
+                                            &dimfast,&dimslow);
+
+                if (!error && mask && (dimfast != maskfast || dimslow != maskslow))
+
+                    error = CBF_FORMAT;
+
+                if (!error)
+
+                    error = cbf_find_spots(image,elsize,elsign,mask,dimfast,dimslow,
+                                           min_isigma,min_spacing,min_value,overload,1,
+                                           maxspots,&spots,&nspots);
+
+                cbf_free(&image,NULL);
+            }
+
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+            {
+                if (!stop && !errorcode)
+                {
+                    if (!error)
+
+                        error = sink(context,(size_t)frame,filenames[frame],spots,nspots);
+
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+                    errorcode = error;
+                }
+            }
+
+            cbf_free_spots(&spots);
+        }
+
+        return errorcode;
+    }
+
+
+#ifdef __cplusplus
+
+}
+
+#endif
@@ -265,6 +265,9 @@ extern "C" {
 #include "cbf_binary.h"
 
 
+static int cbf_free_store (cbf_node *node);
+
+
   /* Make a new node */
 
 int cbf_make_node (cbf_node **node, CBF_NODETYPE type,
@@ -298,6 +301,8 @@ int cbf_make_node (cbf_node **node, CBF_NODETYPE type,
 
   (*node)->child = NULL;
 
+  (*node)->store = NULL;
+
 
     /* Add the context? */
 
@@ -376,6 +381,8 @@ int cbf_make_new_node (cbf_node **node, CBF_NODETYPE type,
 
   (*node)->child = NULL;
 
+  (*node)->store = NULL;
+
 
     /* Add the context? */
 
@@ -564,10 +571,12 @@ int cbf_free_node (cbf_node *node)
   }
 
 
-    /* Free the name */
+    /* Free the name and any columnar storage */
 
   cbf_free_string (NULL, node->name);
 
+  cbf_failnez (cbf_free_store (node))
+
 
     /* Free the context connection */
 
@@ -622,6 +631,14 @@ int cbf_set_children (cbf_node *node, const unsigned int children)
 
   if (new_size < children) new_size = children;
 
+    /* Grow large nodes geometrically, so that adding rows one at a
+       time to a long loop costs amortized constant time */
+
+  if (children > node->child_size && node->child_size > 512*2
+                                  && new_size < node->child_size + node->child_size/2)
+
+    new_size = node->child_size + node->child_size/2;
+
     /* Decrease the number of children? */
 
   if (children < node->children)
@@ -656,11 +673,21 @@ int cbf_set_children (cbf_node *node, const unsigned int children)
       errorcode = cbf_free ((void **) &vchild, &node->child_size);
       
       node->child = NULL;
+
+      errorcode |= cbf_free_store (node);
     }
+    else
+
+      if (node->store && node->store->size > children)
+
+        memset (node->store->state + children, 0,
+                (node->store->size < node->children ?
+                 node->store->size : node->children) - children);
 
     node->children = children;
 
-    if (new_size < node->child_size ) 
+    if (new_size < node->child_size
+     && (node->child_size <= 512*2 || new_size <= node->child_size/2))
     {
       vchild = (void *)node->child;
   
@@ -1376,6 +1403,61 @@ int cbf_add_new_child (cbf_node *node, cbf_node *child)
 }
 
 
+  /* Move all the children of one node to the end of another */
+
+int cbf_move_children (cbf_node *node, cbf_node *source)
+{
+  unsigned int first, count;
+
+  void *vchild;
+
+
+    /* Follow any links */
+
+  node = cbf_get_link (node);
+
+  source = cbf_get_link (source);
+
+
+    /* Check the arguments */
+
+  if (!node || !source || node == source || node->type == CBF_COLUMN
+                                          || source->type == CBF_COLUMN)
+
+    return CBF_ARGUMENT;
+
+
+    /* Add the children */
+
+  first = node->children;
+
+  cbf_failnez (cbf_set_children (node, first + source->children))
+
+  for (count = 0; count < source->children; count++)
+  {
+    node->child [first + count] = source->child [count];
+
+    node->child [first + count]->parent = node;
+  }
+
+
+    /* Leave the source empty */
+
+  source->children = 0;
+
+  vchild = (void *) source->child;
+
+  cbf_failnez (cbf_free ((void **) &vchild, &source->child_size))
+
+  source->child = NULL;
+
+
+    /* Success */
+
+  return 0;
+}
+
+
   /* Make a new child node */
 
 int cbf_make_child (cbf_node **child, cbf_node *node,
@@ -1591,6 +1673,97 @@ int cbf_shift_link (cbf_node *link)
 }
 
 
+  /* Free the columnar storage of a node */
+
+static int cbf_free_store (cbf_node *node)
+{
+  cbf_column_store *store;
+
+  void *memblock;
+
+  int errorcode;
+
+  store = node->store;
+
+  if (!store)
+
+    return 0;
+
+  node->store = NULL;
+
+  errorcode = 0;
+
+  while (store->arena)
+  {
+    cbf_arena *next = store->arena->next;
+
+    errorcode |= cbf_free ((void **) &store->arena, NULL);
+
+    store->arena = next;
+  }
+
+  errorcode |= cbf_free ((void **) &store->state, NULL);
+
+  errorcode |= cbf_free ((void **) &store->number, NULL);
+
+  errorcode |= cbf_free ((void **) &store->integer, NULL);
+
+  memblock = (void *) store;
+
+  return errorcode | cbf_free (&memblock, NULL);
+}
+
+
+  /* Make room in the numeric caches of a column for all its rows */
+
+static int cbf_size_store (cbf_node *column)
+{
+  cbf_column_store *store;
+
+  size_t size;
+
+  int errorcode;
+
+  if (!column->store)
+
+    cbf_failnez (cbf_alloc ((void **) &column->store, NULL,
+                            sizeof (cbf_column_store), 1))
+
+  store = column->store;
+
+  if (store->size >= column->children)
+
+    return 0;
+
+  size = store->size;
+
+  errorcode = cbf_realloc ((void **) &store->state, &size,
+                           sizeof (unsigned char), column->child_size);
+
+  size = store->size;
+
+  if (!errorcode)
+
+    errorcode = cbf_realloc ((void **) &store->number, &size,
+                             sizeof (double), column->child_size);
+
+  size = store->size;
+
+  if (!errorcode)
+
+    errorcode = cbf_realloc ((void **) &store->integer, &size,
+                             sizeof (long), column->child_size);
+
+  if (errorcode)
+
+    return errorcode;
+
+  store->size = column->child_size;
+
+  return 0;
+}
+
+
   /* Set the value of a row */
 
 int cbf_set_columnrow (cbf_node *column, unsigned int row,
@@ -1629,10 +1802,14 @@ int cbf_set_columnrow (cbf_node *column, unsigned int row,
     cbf_failnez (cbf_free_value (column->context, column, row))
 
 
-    /* Set the new value */
+    /* Set the new value and forget any number parsed from the old one */
 
   column->child [row] = (cbf_node *) value;
 
+  if (column->store && row < column->store->size)
+
+    column->store->state [row] = 0;
+
 
     /* Success */
 
@@ -1714,6 +1891,20 @@ int cbf_insert_columnrow (cbf_node *column, unsigned int row,
     memmove (column->child + row + 1, column->child + row,
                sizeof (cbf_node *) * (column->children - row - 1));
 
+  if (column->store && row < column->store->size)
+  {
+    cbf_column_store *store = column->store;
+
+    size_t count = (store->size < column->children ?
+                    store->size : column->children) - row - 1;
+
+    memmove (store->state   + row + 1, store->state   + row, count);
+    memmove (store->number  + row + 1, store->number  + row, count * sizeof (double));
+    memmove (store->integer + row + 1, store->integer + row, count * sizeof (long));
+
+    store->state [row] = 0;
+  }
+
 
     /* Set the value */
 
@@ -1760,6 +1951,20 @@ int cbf_delete_columnrow (cbf_node *column, unsigned int row)
 
   column->child [column->children - 1] = NULL;
 
+  if (column->store && row < column->store->size)
+  {
+    cbf_column_store *store = column->store;
+
+    size_t count = (store->size < column->children ?
+                    store->size : column->children) - row - 1;
+
+    memmove (store->state   + row, store->state   + row + 1, count);
+    memmove (store->number  + row, store->number  + row + 1, count * sizeof (double));
+    memmove (store->integer + row, store->integer + row + 1, count * sizeof (long));
+
+    store->state [row + count] = 0;
+  }
+
 
     /* Decrease the column size */
 
@@ -1788,6 +1993,365 @@ int cbf_add_columnrow (cbf_node *column, const char *value)
   return cbf_set_columnrow (column, column->children, value, 1);
 }
 
+
+  /* Get the cached double value of a row */
+
+int cbf_get_columnrow_double (double *number, const cbf_node *column,
+                              unsigned int row)
+{
+  column = cbf_get_link (column);
+
+  if (!column || column->type != CBF_COLUMN)
+
+    return CBF_ARGUMENT;
+
+  if (!column->store || row >= column->store->size ||
+      row >= column->children ||
+      !(column->store->state [row] & CBF_STORE_DOUBLE))
+
+    return CBF_NOTFOUND;
+
+  if (number)
+
+    *number = column->store->number [row];
+
+  return 0;
+}
+
+
+  /* Get the cached long value of a row */
+
+int cbf_get_columnrow_long (long *number, const cbf_node *column,
+                            unsigned int row)
+{
+  column = cbf_get_link (column);
+
+  if (!column || column->type != CBF_COLUMN)
+
+    return CBF_ARGUMENT;
+
+  if (!column->store || row >= column->store->size ||
+      row >= column->children ||
+      !(column->store->state [row] & CBF_STORE_LONG))
+
+    return CBF_NOTFOUND;
+
+  if (number)
+
+    *number = column->store->integer [row];
+
+  return 0;
+}
+
+
+  /* Cache the double value of a row */
+
+int cbf_set_columnrow_double (cbf_node *column, unsigned int row,
+                              double number)
+{
+  column = cbf_get_link (column);
+
+  if (!column || column->type != CBF_COLUMN)
+
+    return CBF_ARGUMENT;
+
+  if (row >= column->children)
+
+    return CBF_NOTFOUND;
+
+  cbf_failnez (cbf_size_store (column))
+
+  column->store->number [row] = number;
+
+  column->store->state [row] |= CBF_STORE_DOUBLE;
+
+  return 0;
+}
+
+
+  /* Cache the long value of a row */
+
+int cbf_set_columnrow_long (cbf_node *column, unsigned int row,
+                            long number)
+{
+  column = cbf_get_link (column);
+
+  if (!column || column->type != CBF_COLUMN)
+
+    return CBF_ARGUMENT;
+
+  if (row >= column->children)
+
+    return CBF_NOTFOUND;
+
+  cbf_failnez (cbf_size_store (column))
+
+  column->store->integer [row] = number;
+
+  column->store->state [row] |= CBF_STORE_LONG;
+
+  return 0;
+}
+
+
+  /* Is the text of a value held in the packed storage of its column? */
+
+int cbf_is_packed_value (const cbf_node *column, const char *value)
+{
+  const cbf_arena *block;
+
+  column = cbf_get_link (column);
+
+  if (!column || !column->store || !value)
+
+    return 0;
+
+  if (column->store->image &&
+      value >= column->store->image &&
+      value <  column->store->image + column->store->image_size)
+
+    return 1;
+
+  for (block = column->store->arena; block; block = block->next)
+
+    if (value >= (const char *) (block + 1) &&
+        value <  (const char *) (block + 1) + block->used)
+
+      return 1;
+
+  return 0;
+}
+
+
+  /* Record that values of a column may point into a block of text,
+     such as a mapped dictionary image, that the column does not own */
+
+int cbf_set_column_image (cbf_node *column, const char *image, size_t size)
+{
+    /* Follow any links */
+
+  column = cbf_get_link (column);
+
+  if (!column || column->type != CBF_COLUMN || !image)
+
+    return CBF_ARGUMENT;
+
+  if (!column->store)
+
+    cbf_failnez (cbf_alloc ((void **) &column->store, NULL,
+                            sizeof (cbf_column_store), 1))
+
+  column->store->image = image;
+
+  column->store->image_size = size;
+
+  return 0;
+}
+
+
+  /* Copy text into the packed storage of a column, starting a new
+     block, at least twice the size of the last, when it is full */
+
+static int cbf_arena_copy (cbf_column_store *store, const char *text,
+                                                    const char **copy)
+{
+  cbf_arena *block;
+
+  size_t length, size;
+
+  length = strlen (text) + 1;
+
+  block = store->arena;
+
+  if (!block || block->size - block->used < length)
+  {
+    size = block ? block->size * 2 : CBF_ARENA_BLOCK;
+
+    if (size > CBF_ARENA_BLOCK * 256)
+
+      size = CBF_ARENA_BLOCK * 256;
+
+    if (size < length)
+
+      size = length;
+
+    block = NULL;
+
+    cbf_failnez (cbf_alloc ((void **) &block, NULL, 1, sizeof (cbf_arena) + size))
+
+    block->next = store->arena;
+
+    block->size = size;
+
+    block->used = 0;
+
+    store->arena = block;
+  }
+
+  *copy = (const char *) (block + 1) + block->used;
+
+  memcpy ((char *) *copy, text, length);
+
+  block->used += length;
+
+  return 0;
+}
+
+
+  /* Copy the text values of a column into one contiguous block, so
+     that a long loop holds one allocation per column rather than one
+     per value.  Binary values are left where they are. */
+
+int cbf_pack_column (cbf_node *column)
+{
+  cbf_column_store packed;
+
+  cbf_arena *block, *old_arena;
+
+  const char *text, *copy;
+
+  size_t size;
+
+  unsigned int row;
+
+
+    /* Follow any links */
+
+  column = cbf_get_link (column);
+
+  if (!column || column->type != CBF_COLUMN)
+
+    return CBF_ARGUMENT;
+
+
+    /* Measure the text values */
+
+  size = 0;
+
+  for (row = 0; row < column->children; row++)
+  {
+    text = (const char *) column->child [row];
+
+    if (text && !cbf_is_binary (column, row))
+
+      size += strlen (text) + 1;
+  }
+
+  if (!size)
+
+    return 0;
+
+
+    /* Copy them into a single new block */
+
+  if (!column->store)
+
+    cbf_failnez (cbf_alloc ((void **) &column->store, NULL,
+                            sizeof (cbf_column_store), 1))
+
+  block = NULL;
+
+  cbf_failnez (cbf_alloc ((void **) &block, NULL, 1, sizeof (cbf_arena) + size))
+
+  block->next = NULL;
+
+  block->size = size;
+
+  block->used = 0;
+
+  packed.arena = block;
+
+  for (row = 0; row < column->children; row++)
+  {
+    text = (const char *) column->child [row];
+
+    if (text && !cbf_is_binary (column, row))
+    {
+      cbf_failnez (cbf_arena_copy (&packed, text, &copy))
+
+      if (!cbf_is_packed_value (column, text))
+
+        cbf_free_string (NULL, text);
+
+      column->child [row] = (cbf_node *) copy;
+    }
+  }
+
+
+    /* Replace the earlier blocks */
+
+  old_arena = column->store->arena;
+
+  column->store->arena = block;
+
+  while (old_arena)
+  {
+    block = old_arena->next;
+
+    cbf_failnez (cbf_free ((void **) &old_arena, NULL))
+
+    old_arena = block;
+  }
+
+  return 0;
+}
+
+
+  /* Add a value read from a file to a column.  Once the column is
+     long, the text is moved into the packed storage of the column
+     and *value updated to point at the copy. */
+
+int cbf_append_columnrow (cbf_node *column, const char **value)
+{
+  const char *copy;
+
+
+    /* Follow any links */
+
+  column = cbf_get_link (column);
+
+
+    /* Check the arguments */
+
+  if (!column || !value)
+
+    return CBF_ARGUMENT;
+
+
+    /* Short columns and binary values are stored as they are */
+
+  if (column->children < CBF_PACK_ROWS || !*value ||
+       **value == CBF_TOKEN_BIN     ||
+       **value == CBF_TOKEN_TMP_BIN ||
+       **value == CBF_TOKEN_MIME_BIN)
+
+    return cbf_add_columnrow (column, *value);
+
+
+    /* Pack the values already read on reaching the threshold */
+
+  if (!column->store || !column->store->arena)
+
+    cbf_failnez (cbf_pack_column (column))
+
+  if (!column->store)
+
+    return cbf_add_columnrow (column, *value);
+
+
+    /* Add the copy */
+
+  cbf_failnez (cbf_arena_copy (column->store, *value, &copy))
+
+  cbf_failnez (cbf_add_columnrow (column, copy))
+
+  cbf_free_string (NULL, *value);
+
+  *value = copy;
+
+  return 0;
+}
+
   /* compute a hash code for a string */
 
 int cbf_compute_hashcode(const char *string, unsigned int *hashcode)
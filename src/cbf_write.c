@@ -653,6 +653,10 @@ extern "C" {
         
         test [0] |= strcmp (&value [1], "?") == 0;
         test [0] |= strcmp (&value [1], ".") == 0;
+
+        /* An empty value is only written as a quoted string */
+
+        test [0] |= !value [1];
         
         
         /* Simple word? */